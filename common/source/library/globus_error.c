@@ -16,7 +16,6 @@
 
 #include "globus_common_include.h"
 #include "globus_common.h"
-#include "globus_object_cache.h"
 #include "globus_error.h"
 #include "globus_error_generic.h"
 #include "globus_error_hierarchy.h"
@@ -292,9 +291,67 @@ globus_error_construct_base (globus_module_descriptor_t * source_module,
  * Error Management API
  **********************************************************************/
 
-static globus_object_cache_t s_result_to_object_mapper;
-static globus_uint_t         s_next_available_result_count;
-static local_mutex_t         s_result_to_object_mutex;
+/*
+ * results map to error objects through a table split into shards, each
+ * with its own lock.  a thread puts its errors in the shard it was given on
+ * first use and a result names the shard, slot and a generation count of
+ * that slot, so put, get and peek are all constant time and a stale result
+ * doesn't find a later error.  when all slots of a shard are in use the
+ * error in the slot after the last one taken that way is dropped, as the
+ * single cache used to drop its oldest entry.
+ */
+#define GLOBUS_L_ERROR_SHARD_BITS 6
+#define GLOBUS_L_ERROR_SLOT_BITS 9
+#define GLOBUS_L_ERROR_SHARDS (1 << GLOBUS_L_ERROR_SHARD_BITS)
+#define GLOBUS_L_ERROR_SLOTS (1 << GLOBUS_L_ERROR_SLOT_BITS)
+#define GLOBUS_L_ERROR_GEN_SHIFT \
+    (GLOBUS_L_ERROR_SHARD_BITS + GLOBUS_L_ERROR_SLOT_BITS)
+/* never 0, and below the value that would make a result GLOBUS_FAILURE */
+#define GLOBUS_L_ERROR_GEN_MAX \
+    ((((globus_result_t) ~0) >> GLOBUS_L_ERROR_GEN_SHIFT) - 1)
+
+typedef struct
+{
+    globus_object_t *                   error;
+    globus_result_t                     generation;
+    int                                 next_free;
+} globus_l_error_slot_t;
+
+typedef struct
+{
+    local_mutex_t                       lock;
+    /* allocated on first use */
+    globus_l_error_slot_t *             slots;
+    int                                 free_head;
+    int                                 spill;
+} globus_l_error_shard_t;
+
+/*
+ * results whose generation bits are 0 are never made by the shards and are
+ * left to long lived errors registered with globus_error_put_static().
+ * such a result holds the index of the static error and a count of how
+ * often that index was taken, and get and peek find the error without a
+ * lock.
+ */
+#define GLOBUS_L_ERROR_STATIC_BITS 6
+#define GLOBUS_L_ERROR_STATICS (1 << GLOBUS_L_ERROR_STATIC_BITS)
+#define GLOBUS_L_ERROR_STATIC_GEN_MAX \
+    ((1 << (GLOBUS_L_ERROR_GEN_SHIFT - GLOBUS_L_ERROR_STATIC_BITS)) - 1)
+#define s_error_result_is_static(result) \
+    (((result) >> GLOBUS_L_ERROR_GEN_SHIFT) == 0)
+
+typedef struct
+{
+    globus_object_t *                   error;
+    globus_result_t                     generation;
+} globus_l_error_static_t;
+
+static globus_l_error_shard_t s_result_to_object_shards[GLOBUS_L_ERROR_SHARDS];
+static globus_l_error_static_t s_static_errors[GLOBUS_L_ERROR_STATICS];
+static local_mutex_t         s_static_errors_mutex;
+static globus_uint_t         s_next_shard;
+static local_mutex_t         s_next_shard_mutex;
+static globus_thread_key_t   s_shard_key;
 static globus_thread_key_t   s_peek_key;
 
 static int  s_error_cache_initialized = 0;
@@ -313,16 +370,28 @@ s_key_destructor_func(
 static int s_error_cache_init (void)
 {
     char *                              tmp_string;
+    int                                 i;
   
   if(globus_module_activate(GLOBUS_OBJECT_MODULE) != GLOBUS_SUCCESS)
   {
     return GLOBUS_FAILURE;
   }
   globus_thread_key_create(&s_peek_key, s_key_destructor_func);
-				   
-  globus_object_cache_init (&s_result_to_object_mapper);
-  local_mutex_init (&s_result_to_object_mutex, NULL);
-  s_next_available_result_count = 1;
+  globus_thread_key_create(&s_shard_key, GLOBUS_NULL);
+
+  for (i = 0; i < GLOBUS_L_ERROR_SHARDS; i++)
+  {
+    local_mutex_init (&s_result_to_object_shards[i].lock, NULL);
+    s_result_to_object_shards[i].slots = GLOBUS_NULL;
+  }
+  for (i = 0; i < GLOBUS_L_ERROR_STATICS; i++)
+  {
+    s_static_errors[i].error = GLOBUS_NULL;
+    s_static_errors[i].generation = 0;
+  }
+  local_mutex_init (&s_static_errors_mutex, NULL);
+  local_mutex_init (&s_next_shard_mutex, NULL);
+  s_next_shard = 0;
   s_error_cache_initialized = 1;
   
     tmp_string = globus_module_getenv("GLOBUS_ERROR_OUTPUT");
@@ -345,6 +414,9 @@ static int s_error_cache_init (void)
 static int s_error_cache_destroy (void)
 {
   globus_object_t *                   cached;
+  globus_l_error_shard_t *            shard;
+  int                                 i;
+  int                                 j;
     
   cached = (globus_object_t *) globus_thread_getspecific(s_peek_key);
   if(cached)
@@ -353,10 +425,36 @@ static int s_error_cache_destroy (void)
   }
     
   globus_thread_key_delete(s_peek_key);
+  globus_thread_key_delete(s_shard_key);
   globus_thread_key_delete(globus_i_error_verbose_key);
   
-  globus_object_cache_destroy (&s_result_to_object_mapper);
-  local_mutex_destroy (&s_result_to_object_mutex);
+  for (i = 0; i < GLOBUS_L_ERROR_SHARDS; i++)
+  {
+    shard = &s_result_to_object_shards[i];
+    if (shard->slots != GLOBUS_NULL)
+    {
+      for (j = 0; j < GLOBUS_L_ERROR_SLOTS; j++)
+      {
+        if (shard->slots[j].error != GLOBUS_NULL)
+        {
+          globus_object_free(shard->slots[j].error);
+        }
+      }
+      globus_free(shard->slots);
+      shard->slots = GLOBUS_NULL;
+    }
+    local_mutex_destroy (&shard->lock);
+  }
+  for (i = 0; i < GLOBUS_L_ERROR_STATICS; i++)
+  {
+    if (s_static_errors[i].error != GLOBUS_NULL)
+    {
+      globus_object_free(s_static_errors[i].error);
+      s_static_errors[i].error = GLOBUS_NULL;
+    }
+  }
+  local_mutex_destroy (&s_static_errors_mutex);
+  local_mutex_destroy (&s_next_shard_mutex);
   s_error_cache_initialized = 0;
   
   globus_module_deactivate(GLOBUS_OBJECT_MODULE);
@@ -364,24 +462,112 @@ static int s_error_cache_destroy (void)
   return GLOBUS_SUCCESS;
 }
 
+/* the shard this thread puts its errors in, handed out round robin */
+static int
+s_error_shard_index (void)
+{
+  intptr_t index;
+
+  index = (intptr_t) globus_thread_getspecific(s_shard_key);
+  if (index == 0)
+  {
+    local_mutex_lock (&s_next_shard_mutex);
+    index = (s_next_shard++ % GLOBUS_L_ERROR_SHARDS) + 1;
+    local_mutex_unlock (&s_next_shard_mutex);
+    globus_thread_setspecific(s_shard_key, (void *) index);
+  }
+
+  return (int) index - 1;
+}
+
+/* called locked.  the slot a result names if it still holds that error */
+static globus_l_error_slot_t *
+s_error_slot_lookup (globus_l_error_shard_t * shard,
+                     globus_result_t          result)
+{
+  globus_l_error_slot_t * slot;
+
+  if (shard->slots == GLOBUS_NULL) return GLOBUS_NULL;
+
+  slot = &shard->slots[result & (GLOBUS_L_ERROR_SLOTS - 1)];
+  if (slot->error == GLOBUS_NULL ||
+      slot->generation != result >> GLOBUS_L_ERROR_GEN_SHIFT)
+  {
+    return GLOBUS_NULL;
+  }
+
+  return slot;
+}
+
+/* called locked.  empty a slot, leaving stale results for it unmatched */
+static void
+s_error_slot_release (globus_l_error_shard_t * shard,
+                      globus_l_error_slot_t *  slot)
+{
+  slot->error = GLOBUS_NULL;
+  if (++slot->generation > GLOBUS_L_ERROR_GEN_MAX)
+  {
+    slot->generation = 1;
+  }
+  slot->next_free = shard->free_head;
+  shard->free_head = slot - shard->slots;
+}
+
+/* the static error a result names, if it is still registered */
+static globus_object_t *
+s_error_static_lookup (globus_result_t result)
+{
+  globus_l_error_static_t * entry;
+
+  entry = &s_static_errors[result & (GLOBUS_L_ERROR_STATICS - 1)];
+  if (entry->generation != result >> GLOBUS_L_ERROR_STATIC_BITS)
+  {
+    return GLOBUS_NULL;
+  }
+
+  return entry->error;
+}
+
+#define s_error_shard(result) \
+  (&s_result_to_object_shards[((result) >> GLOBUS_L_ERROR_SLOT_BITS) & \
+                              (GLOBUS_L_ERROR_SHARDS - 1)])
 
 globus_object_t *
 globus_error_get (globus_result_t result)
 {
-  globus_object_t * error;
+  globus_object_t * error = NULL;
+  globus_l_error_shard_t * shard;
+  globus_l_error_slot_t * slot;
   int err;
 
   if (! s_error_cache_initialized ) return NULL;
 
   if ( result == GLOBUS_SUCCESS ) return NULL;
 
-  err = local_mutex_lock (&s_result_to_object_mutex);
+  if (s_error_result_is_static(result))
+  {
+    /* the caller frees what it gets, the registered reference stays */
+    error = s_error_static_lookup (result);
+    if (error != NULL)
+    {
+      globus_object_reference(error);
+      return error;
+    }
+    return GLOBUS_ERROR_NO_INFO;
+  }
+
+  shard = s_error_shard(result);
+  err = local_mutex_lock (&shard->lock);
   if (err) return NULL;
 
-  error = globus_object_cache_remove (&s_result_to_object_mapper,
-				      (void *) (intptr_t) result);
+  slot = s_error_slot_lookup (shard, result);
+  if (slot != NULL)
+  {
+    error = slot->error;
+    s_error_slot_release (shard, slot);
+  }
 
-  local_mutex_unlock (&s_result_to_object_mutex);
+  local_mutex_unlock (&shard->lock);
 
   if (error!=NULL) 
     return error;
@@ -393,24 +579,39 @@ globus_object_t *
 globus_error_peek(
     globus_result_t                     result)
 {
-  globus_object_t * error;
+  globus_object_t * error = NULL;
+  globus_l_error_shard_t * shard;
+  globus_l_error_slot_t * slot;
   int err;
 
   if (! s_error_cache_initialized ) return NULL;
 
   if ( result == GLOBUS_SUCCESS ) return NULL;
 
-  err = local_mutex_lock (&s_result_to_object_mutex);
+  if (s_error_result_is_static(result))
+  {
+    /* lives until released, no reference needs caching */
+    error = s_error_static_lookup (result);
+    return error != NULL ? error : GLOBUS_ERROR_NO_INFO;
+  }
+
+  shard = s_error_shard(result);
+  err = local_mutex_lock (&shard->lock);
   if (err) return NULL;
 
-  error = globus_object_cache_lookup (&s_result_to_object_mapper,
-				      (void *) (intptr_t) result);
+  slot = s_error_slot_lookup (shard, result);
+  if (slot != NULL)
+  {
+    error = slot->error;
+    globus_object_reference(error);
+  }
+  
+  local_mutex_unlock (&shard->lock);
   
   if (error!=NULL) 
   {
     globus_object_t *                   cached;
     
-    globus_object_reference(error);
     cached = (globus_object_t *) globus_thread_getspecific(s_peek_key);
     if(cached)
     {
@@ -418,12 +619,8 @@ globus_error_peek(
     }
     
     globus_thread_setspecific(s_peek_key, error);
-  }
-  
-  local_mutex_unlock (&s_result_to_object_mutex);
-  
-  if (error!=NULL) 
     return error;
+  }
   else
     return GLOBUS_ERROR_NO_INFO;
 }
@@ -432,12 +629,15 @@ globus_result_t
 globus_error_put (globus_object_t * error)
 {
   globus_result_t new_result;
+  globus_l_error_shard_t * shard;
+  globus_l_error_slot_t * slot;
+  globus_object_t * spilled = NULL;
+  int index;
+  int i;
   int err;
 
   if (! s_error_cache_initialized || !error) return GLOBUS_FAILURE;
   
-  err = local_mutex_lock (&s_result_to_object_mutex);
-  if (err) return GLOBUS_FAILURE;
   globus_i_error_output_error(error);
 
   if ( globus_object_type_match (globus_object_get_type(error),
@@ -446,20 +646,120 @@ globus_error_put (globus_object_t * error)
     error = GLOBUS_ERROR_NO_INFO;
   }
   
-  do
+  index = s_error_shard_index();
+  shard = &s_result_to_object_shards[index];
+  err = local_mutex_lock (&shard->lock);
+  if (err) return GLOBUS_FAILURE;
+
+  if (shard->slots == GLOBUS_NULL)
   {
-     new_result = s_next_available_result_count++;
-  } while(globus_object_cache_lookup(
-      &s_result_to_object_mapper, (void *) (intptr_t) new_result) != NULL);
+    shard->slots = (globus_l_error_slot_t *)
+      globus_malloc(sizeof(globus_l_error_slot_t) * GLOBUS_L_ERROR_SLOTS);
+    if (shard->slots == GLOBUS_NULL)
+    {
+      local_mutex_unlock (&shard->lock);
+      return GLOBUS_FAILURE;
+    }
+    for (i = 0; i < GLOBUS_L_ERROR_SLOTS; i++)
+    {
+      shard->slots[i].error = GLOBUS_NULL;
+      shard->slots[i].generation = 1;
+      shard->slots[i].next_free = i + 1;
+    }
+    shard->slots[GLOBUS_L_ERROR_SLOTS - 1].next_free = -1;
+    shard->free_head = 0;
+    shard->spill = 0;
+  }
+
+  if (shard->free_head < 0)
+  {
+    /* full, drop an old error to make room */
+    slot = &shard->slots[shard->spill];
+    shard->spill = (shard->spill + 1) % GLOBUS_L_ERROR_SLOTS;
+    spilled = slot->error;
+    s_error_slot_release (shard, slot);
+  }
 
-  globus_object_cache_insert (&s_result_to_object_mapper,
-			      (void *) (intptr_t) new_result, error);
+  slot = &shard->slots[shard->free_head];
+  shard->free_head = slot->next_free;
+  slot->error = error;
+  new_result = (slot->generation << GLOBUS_L_ERROR_GEN_SHIFT) |
+    ((globus_result_t) index << GLOBUS_L_ERROR_SLOT_BITS) |
+    (globus_result_t) (slot - shard->slots);
 
-  local_mutex_unlock (&s_result_to_object_mutex);
+  local_mutex_unlock (&shard->lock);
+
+  if (spilled != NULL)
+  {
+    globus_object_free (spilled);
+  }
 
   return new_result;
 }
 
+globus_result_t
+globus_error_put_static (globus_object_t * error)
+{
+  globus_result_t new_result = GLOBUS_FAILURE;
+  globus_l_error_static_t * entry;
+  int i;
+
+  if (! s_error_cache_initialized || !error) return GLOBUS_FAILURE;
+
+  if ( globus_object_type_match (globus_object_get_type(error),
+				 GLOBUS_ERROR_TYPE_BASE)
+       != GLOBUS_TRUE ) {
+    return GLOBUS_FAILURE;
+  }
+
+  local_mutex_lock (&s_static_errors_mutex);
+  for (i = 0; i < GLOBUS_L_ERROR_STATICS; i++)
+  {
+    entry = &s_static_errors[i];
+    if (entry->error == GLOBUS_NULL)
+    {
+      if (++entry->generation > GLOBUS_L_ERROR_STATIC_GEN_MAX)
+      {
+        entry->generation = 1;
+      }
+      entry->error = error;
+      new_result = (entry->generation << GLOBUS_L_ERROR_STATIC_BITS) |
+        (globus_result_t) i;
+      break;
+    }
+  }
+  local_mutex_unlock (&s_static_errors_mutex);
+
+  return new_result;
+}
+
+void
+globus_error_release_static (globus_result_t result)
+{
+  globus_l_error_static_t * entry;
+  globus_object_t * error = NULL;
+
+  if (! s_error_cache_initialized || result == GLOBUS_SUCCESS ||
+      ! s_error_result_is_static(result))
+  {
+    return;
+  }
+
+  local_mutex_lock (&s_static_errors_mutex);
+  error = s_error_static_lookup (result);
+  if (error != NULL)
+  {
+    entry = &s_static_errors[result & (GLOBUS_L_ERROR_STATICS - 1)];
+    entry->error = GLOBUS_NULL;
+  }
+  local_mutex_unlock (&s_static_errors_mutex);
+
+  if (error != NULL)
+  {
+    globus_object_free (error);
+  }
+}
+
 globus_module_descriptor_t globus_i_error_module =
 {
   "globus_error",
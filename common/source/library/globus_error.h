@@ -106,6 +106,22 @@ globus_error_put(
     globus_object_t *                   error);
 /* does nothing if error is NULL */
 
+extern globus_result_t
+globus_error_put_static(
+    globus_object_t *                   error);
+/* takes error for good and returns a result for it that may be gotten or
+ * peeked any number of times and from any thread without using up a slot.
+ * get returns a new reference the caller frees.  the error must not be
+ * changed once put.  returns GLOBUS_FAILURE if no more can be registered
+ */
+
+extern void
+globus_error_release_static(
+    globus_result_t                     result);
+/* drops an error registered with globus_error_put_static.  the result must
+ * no longer be in use
+ */
+
 /**********************************************************************
  * Error Manipulation API
  **********************************************************************/
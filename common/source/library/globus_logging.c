@@ -56,6 +56,38 @@ static int                              globus_l_logging_pid;
             __LINE__,                                                       \
             "Out of memory"))
 
+/*
+ *  with GLOBUS_LOGGING_WRITER_THREAD each thread formats its messages into a
+ *  buffer of its own, locked only against the writer.  the writer swaps the
+ *  full and spare halves of every thread's buffer, merges the messages by
+ *  the time they were made and hands them to the module in large writes.
+ */
+typedef struct globus_l_logging_record_s
+{
+    long                                tv_sec;
+    long                                tv_usec;
+    globus_size_t                       length;
+} globus_l_logging_record_t;
+
+#define GlobusLoggingRecordSize(_len)                                       \
+    ((sizeof(globus_l_logging_record_t) + (_len) + sizeof(long) - 1) &      \
+        ~(sizeof(long) - 1))
+
+typedef struct globus_l_logging_thread_buffer_s
+{
+    globus_mutex_t                      mutex;
+    globus_byte_t *                     buffer;
+    globus_size_t                       used_length;
+    /* the other half, only touched by the writer */
+    globus_byte_t *                     spare;
+    globus_size_t                       spare_length;
+    globus_size_t                       spare_offset;
+    int                                 dropped;
+    globus_bool_t                       wake_sent;
+    globus_bool_t                       thread_exited;
+    struct globus_l_logging_thread_buffer_s * next;
+} globus_l_logging_thread_buffer_t;
+
 typedef struct globus_l_logging_handle_s
 {
     globus_mutex_t                      mutex;
@@ -66,6 +98,16 @@ typedef struct globus_l_logging_handle_s
     globus_callback_handle_t            callback_handle;
     globus_logging_module_t             module;
     globus_bool_t                       periodic_running;
+
+    /* GLOBUS_LOGGING_WRITER_THREAD */
+    globus_bool_t                       writer_running;
+    globus_bool_t                       writer_shutdown;
+    globus_cond_t                       writer_cond;
+    globus_reltime_t                    writer_period;
+    globus_size_t                       thread_buffer_length;
+    globus_thread_key_t                 thread_buffer_key;
+    globus_l_logging_thread_buffer_t *  thread_buffers;
+
     globus_byte_t                       buffer[1];
 } globus_l_logging_handle_t;
 
@@ -126,6 +168,340 @@ globus_l_logging_periodic(
     globus_mutex_unlock(&handle->mutex);
 }
 
+/*
+ *  format the module header and the message into buf, marking it if it had
+ *  to be cut short.  returns the length written.
+ */
+static globus_size_t
+globus_l_logging_format(
+    globus_l_logging_handle_t *         handle,
+    char *                              buf,
+    globus_size_t                       remain,
+    const char *                        fmt,
+    va_list                             ap)
+{
+    globus_size_t                       used = 0;
+    globus_size_t                       nbytes;
+    int                                 rc;
+
+    if(handle->module.header_func != NULL)
+    {
+        nbytes = remain;
+        handle->module.header_func(buf, &nbytes);
+        used += nbytes;
+    }
+    rc = vsnprintf(&buf[used], remain - used, fmt, ap);
+    if (rc < 0)
+    {
+        nbytes = 0;
+    }
+    else
+    {
+        nbytes = rc;
+    }
+    if(nbytes > remain - used)
+    {
+        char                            suffix[64];
+
+        globus_libc_snprintf(
+            suffix, 
+            sizeof(suffix), 
+            " *** TRUNCATED %lu bytes\n", 
+            (unsigned long) (nbytes - (remain - used) + sizeof(suffix)));
+
+        memcpy(&buf[remain - sizeof(suffix)], suffix, sizeof(suffix));
+
+        nbytes = remain - used - sizeof(suffix) + strlen(suffix);
+    }
+
+    return used + nbytes;
+}
+
+/*
+ *  called locked.  take what every thread has written so far and write it
+ *  out oldest first.
+ */
+static void
+globus_l_logging_drain(
+    globus_l_logging_handle_t *         handle)
+{
+    globus_l_logging_thread_buffer_t *  tb;
+    globus_l_logging_thread_buffer_t *  oldest;
+    globus_l_logging_thread_buffer_t ** prev;
+    globus_l_logging_record_t *         record;
+    globus_l_logging_record_t *         oldest_record;
+    globus_byte_t *                     tmp;
+    int                                 dropped = 0;
+
+    for(tb = handle->thread_buffers; tb != NULL; tb = tb->next)
+    {
+        globus_mutex_lock(&tb->mutex);
+        {
+            tmp = tb->spare;
+            tb->spare = tb->buffer;
+            tb->spare_length = tb->used_length;
+            tb->spare_offset = 0;
+            tb->buffer = tmp;
+            tb->used_length = 0;
+            dropped += tb->dropped;
+            tb->dropped = 0;
+            tb->wake_sent = GLOBUS_FALSE;
+        }
+        globus_mutex_unlock(&tb->mutex);
+    }
+
+    /* each thread's messages are in order, so take the oldest head */
+    for(;;)
+    {
+        oldest = NULL;
+        oldest_record = NULL;
+        for(tb = handle->thread_buffers; tb != NULL; tb = tb->next)
+        {
+            if(tb->spare_offset >= tb->spare_length)
+            {
+                continue;
+            }
+            record = (globus_l_logging_record_t *)
+                &tb->spare[tb->spare_offset];
+            if(oldest_record == NULL ||
+                record->tv_sec < oldest_record->tv_sec ||
+                (record->tv_sec == oldest_record->tv_sec &&
+                    record->tv_usec < oldest_record->tv_usec))
+            {
+                oldest = tb;
+                oldest_record = record;
+            }
+        }
+        if(oldest == NULL)
+        {
+            break;
+        }
+
+        if(handle->buffer_length - handle->used_length <
+            oldest_record->length)
+        {
+            globus_l_logging_flush(handle);
+        }
+        memcpy(&handle->buffer[handle->used_length],
+            oldest_record + 1, oldest_record->length);
+        handle->used_length += oldest_record->length;
+        oldest->spare_offset += GlobusLoggingRecordSize(oldest_record->length);
+    }
+
+    if(dropped > 0)
+    {
+        if(handle->buffer_length - handle->used_length <
+            GLOBUS_L_LOGGING_MAX_MESSAGE)
+        {
+            globus_l_logging_flush(handle);
+        }
+        handle->used_length += globus_libc_snprintf(
+            (char *) &handle->buffer[handle->used_length],
+            GLOBUS_L_LOGGING_MAX_MESSAGE,
+            "*** %d log messages dropped\n", dropped);
+    }
+    globus_l_logging_flush(handle);
+
+    /* buffers of threads that have gone are freed once empty */
+    prev = &handle->thread_buffers;
+    while((tb = *prev) != NULL)
+    {
+        globus_bool_t                   remove;
+
+        globus_mutex_lock(&tb->mutex);
+        remove = tb->thread_exited && tb->used_length == 0;
+        globus_mutex_unlock(&tb->mutex);
+
+        if(remove)
+        {
+            *prev = tb->next;
+            globus_mutex_destroy(&tb->mutex);
+            globus_free(tb->buffer);
+            globus_free(tb->spare);
+            globus_free(tb);
+        }
+        else
+        {
+            prev = &tb->next;
+        }
+    }
+}
+
+static void *
+globus_l_logging_writer(
+    void *                              user_arg)
+{
+    globus_l_logging_handle_t *         handle;
+    globus_abstime_t                    timeout;
+
+    handle = (globus_l_logging_handle_t *) user_arg;
+
+    globus_mutex_lock(&handle->mutex);
+    {
+        while(!handle->writer_shutdown)
+        {
+            GlobusTimeAbstimeGetCurrent(timeout);
+            GlobusTimeAbstimeInc(timeout, handle->writer_period);
+            globus_cond_timedwait(
+                &handle->writer_cond, &handle->mutex, &timeout);
+
+            globus_l_logging_drain(handle);
+        }
+        handle->writer_running = GLOBUS_FALSE;
+        globus_cond_broadcast(&handle->writer_cond);
+    }
+    globus_mutex_unlock(&handle->mutex);
+
+    return NULL;
+}
+
+/*
+ *  thread exit, let the writer free the buffer once it is written.  the
+ *  handle mutex is not taken here, a thread may exit while logging is
+ *  being flushed.
+ */
+static void
+globus_l_logging_thread_buffer_exit(
+    void *                              value)
+{
+    globus_l_logging_thread_buffer_t *  tb;
+
+    tb = (globus_l_logging_thread_buffer_t *) value;
+
+    globus_mutex_lock(&tb->mutex);
+    {
+        tb->thread_exited = GLOBUS_TRUE;
+    }
+    globus_mutex_unlock(&tb->mutex);
+}
+
+static globus_l_logging_thread_buffer_t *
+globus_l_logging_thread_buffer(
+    globus_l_logging_handle_t *         handle)
+{
+    globus_l_logging_thread_buffer_t *  tb;
+
+    tb = (globus_l_logging_thread_buffer_t *)
+        globus_thread_getspecific(handle->thread_buffer_key);
+    if(tb != NULL)
+    {
+        return tb;
+    }
+
+    tb = (globus_l_logging_thread_buffer_t *)
+        globus_calloc(1, sizeof(globus_l_logging_thread_buffer_t));
+    if(tb == NULL)
+    {
+        goto error_alloc;
+    }
+    tb->buffer = globus_malloc(handle->thread_buffer_length);
+    tb->spare = globus_malloc(handle->thread_buffer_length);
+    if(tb->buffer == NULL || tb->spare == NULL)
+    {
+        goto error_buffer;
+    }
+    globus_mutex_init(&tb->mutex, NULL);
+
+    globus_mutex_lock(&handle->mutex);
+    {
+        tb->next = handle->thread_buffers;
+        handle->thread_buffers = tb;
+    }
+    globus_mutex_unlock(&handle->mutex);
+
+    globus_thread_setspecific(handle->thread_buffer_key, tb);
+
+    return tb;
+
+error_buffer:
+    if(tb->buffer)
+    {
+        globus_free(tb->buffer);
+    }
+    if(tb->spare)
+    {
+        globus_free(tb->spare);
+    }
+    globus_free(tb);
+error_alloc:
+    return NULL;
+}
+
+/*
+ *  add a message to this thread's buffer.  returns GLOBUS_FALSE if there is
+ *  no buffer for this thread and the message must be written inline.
+ */
+static globus_bool_t
+globus_l_logging_thread_write(
+    globus_l_logging_handle_t *         handle,
+    int                                 type,
+    const char *                        fmt,
+    va_list                             ap)
+{
+    globus_l_logging_thread_buffer_t *  tb;
+    globus_l_logging_record_t *         record;
+    struct timeval                      tv;
+    globus_bool_t                       wake = GLOBUS_FALSE;
+
+    tb = globus_l_logging_thread_buffer(handle);
+    if(tb == NULL)
+    {
+        return GLOBUS_FALSE;
+    }
+
+    gettimeofday(&tv, NULL);
+
+    /* only the writer competes for this lock, so format under it */
+    globus_mutex_lock(&tb->mutex);
+    if(handle->thread_buffer_length - tb->used_length <
+        GlobusLoggingRecordSize(GLOBUS_L_LOGGING_MAX_MESSAGE))
+    {
+        if(handle->type_mask & GLOBUS_LOGGING_DROP &&
+            !(type & GLOBUS_LOGGING_INLINE))
+        {
+            tb->dropped++;
+            globus_mutex_unlock(&tb->mutex);
+            return GLOBUS_TRUE;
+        }
+
+        /* full, write everything out here rather than lose it */
+        globus_mutex_unlock(&tb->mutex);
+        globus_mutex_lock(&handle->mutex);
+        {
+            globus_l_logging_drain(handle);
+        }
+        globus_mutex_unlock(&handle->mutex);
+        globus_mutex_lock(&tb->mutex);
+    }
+    record = (globus_l_logging_record_t *) &tb->buffer[tb->used_length];
+    record->tv_sec = tv.tv_sec;
+    record->tv_usec = tv.tv_usec;
+    record->length = globus_l_logging_format(
+        handle, (char *) (record + 1), GLOBUS_L_LOGGING_MAX_MESSAGE, fmt, ap);
+    tb->used_length += GlobusLoggingRecordSize(record->length);
+    if(!tb->wake_sent && tb->used_length > handle->thread_buffer_length / 2)
+    {
+        tb->wake_sent = GLOBUS_TRUE;
+        wake = GLOBUS_TRUE;
+    }
+    globus_mutex_unlock(&tb->mutex);
+
+    if(type & GLOBUS_LOGGING_INLINE)
+    {
+        globus_mutex_lock(&handle->mutex);
+        {
+            globus_l_logging_drain(handle);
+        }
+        globus_mutex_unlock(&handle->mutex);
+    }
+    else if(wake)
+    {
+        globus_cond_signal(&handle->writer_cond);
+    }
+
+    return GLOBUS_TRUE;
+}
+
 /**
  * Reset the cached version of the pid used for logging. Call this after
  * fork() to keep logging working in a child process
@@ -204,8 +580,46 @@ globus_logging_init(
         handle->module.open_func(handle->user_arg);
     }
     
+    handle->writer_running = GLOBUS_FALSE;
+    handle->writer_shutdown = GLOBUS_FALSE;
+    handle->thread_buffers = NULL;
+
     GlobusTimeReltimeSet(zero, 0, 0);
-    if(flush_period != NULL && globus_reltime_cmp(flush_period, &zero) != 0)
+    if(flush_period != NULL && globus_reltime_cmp(flush_period, &zero) != 0 &&
+        handle->type_mask & GLOBUS_LOGGING_WRITER_THREAD &&
+        !(handle->type_mask & GLOBUS_LOGGING_INLINE) &&
+        !globus_i_am_only_thread())
+    {
+        globus_thread_t                 thread;
+        int                             rc;
+
+        /* room for at least one message of the longest length */
+        handle->thread_buffer_length = buffer_length;
+        if(handle->thread_buffer_length <
+            GlobusLoggingRecordSize(GLOBUS_L_LOGGING_MAX_MESSAGE))
+        {
+            handle->thread_buffer_length =
+                GlobusLoggingRecordSize(GLOBUS_L_LOGGING_MAX_MESSAGE);
+        }
+        GlobusTimeReltimeCopy(handle->writer_period, *flush_period);
+        globus_cond_init(&handle->writer_cond, NULL);
+        globus_thread_key_create(
+            &handle->thread_buffer_key, globus_l_logging_thread_buffer_exit);
+        handle->writer_running = GLOBUS_TRUE;
+        handle->periodic_running = GLOBUS_FALSE;
+
+        rc = globus_thread_create(
+            &thread, NULL, globus_l_logging_writer, handle);
+        if(rc != 0)
+        {
+            res = GlobusLoggingErrorParameter("log_type");
+            globus_thread_key_delete(handle->thread_buffer_key);
+            globus_cond_destroy(&handle->writer_cond);
+            goto err;
+        }
+    }
+    else if(flush_period != NULL &&
+        globus_reltime_cmp(flush_period, &zero) != 0)
     {
         res = globus_callback_register_periodic(
             &handle->callback_handle,
@@ -218,11 +632,13 @@ globus_logging_init(
             goto err;
         }
         handle->periodic_running = GLOBUS_TRUE;
+        handle->type_mask &= ~GLOBUS_LOGGING_WRITER_THREAD;
     }
     else
     {
         /* insist that all are inline */
         handle->type_mask |= GLOBUS_LOGGING_INLINE;
+        handle->type_mask &= ~GLOBUS_LOGGING_WRITER_THREAD;
         handle->periodic_running = GLOBUS_FALSE;
     }
     *out_handle = handle;
@@ -243,7 +659,6 @@ globus_logging_vwrite(
     globus_result_t                     res;
     globus_size_t                       remain;
     globus_size_t                       nbytes;
-    int                                 rc;
     GlobusLoggingName(globus_logging_write);
 
     if(handle == NULL)
@@ -257,61 +672,39 @@ globus_logging_vwrite(
         goto err;
     }
 
+    if(!(type & handle->type_mask))
+    {
+        return GLOBUS_SUCCESS;
+    }
+
+    if(handle->type_mask & GLOBUS_LOGGING_WRITER_THREAD &&
+        globus_l_logging_thread_write(handle, type, fmt, ap))
+    {
+        return GLOBUS_SUCCESS;
+    }
+
     globus_mutex_lock(&handle->mutex);
     {
-        if(type & handle->type_mask)
+        remain = handle->buffer_length - handle->used_length;
+        if(remain < GLOBUS_L_LOGGING_MAX_MESSAGE)
         {
-            remain = handle->buffer_length - handle->used_length;
-            if(remain < GLOBUS_L_LOGGING_MAX_MESSAGE)
-            {
-                globus_l_logging_flush(handle);
-                remain = handle->buffer_length;
-            }
-            if(handle->module.header_func != NULL)
-            {
-                nbytes = remain;
-                handle->module.header_func(
-                    (char *) &handle->buffer[handle->used_length],
-                    &nbytes);
-                handle->used_length += nbytes;
-                remain -= nbytes;
-            }
-            rc = vsnprintf((char *) &handle->buffer[handle->used_length], 
-                remain, fmt, ap);
-            if (rc < 0)
-            {
-                nbytes = 0;
-            }
-            else
-            {
-                nbytes = rc;
-            }
-            if(nbytes > remain)
-            {
-                char                    suffix[64];
-                
-                globus_libc_snprintf(
-                    suffix, 
-                    sizeof(suffix), 
-                    " *** TRUNCATED %lu bytes\n", 
-                    (unsigned long) (nbytes - remain + sizeof(suffix)));
-                
-                memcpy(
-                    &handle->buffer[handle->buffer_length - sizeof(suffix)], 
-                    suffix,
-                    sizeof(suffix));
-                    
-                nbytes = remain - sizeof(suffix) + strlen(suffix);
-            }
-            handle->used_length += nbytes;
-            remain -= nbytes;
-
-            if(type & GLOBUS_LOGGING_INLINE || 
-                handle->type_mask & GLOBUS_LOGGING_INLINE ||
-                remain < GLOBUS_L_LOGGING_MAX_MESSAGE)
-            {
-                globus_l_logging_flush(handle);
-            }
+            globus_l_logging_flush(handle);
+            remain = handle->buffer_length;
+        }
+        nbytes = globus_l_logging_format(
+            handle,
+            (char *) &handle->buffer[handle->used_length],
+            remain,
+            fmt,
+            ap);
+        handle->used_length += nbytes;
+        remain -= nbytes;
+
+        if(type & GLOBUS_LOGGING_INLINE || 
+            handle->type_mask & GLOBUS_LOGGING_INLINE ||
+            remain < GLOBUS_L_LOGGING_MAX_MESSAGE)
+        {
+            globus_l_logging_flush(handle);
         }
     }
     globus_mutex_unlock(&handle->mutex);
@@ -346,6 +739,10 @@ globus_logging_flush(
 
     globus_mutex_lock(&handle->mutex);
     {
+        if(handle->type_mask & GLOBUS_LOGGING_WRITER_THREAD)
+        {
+            globus_l_logging_drain(handle);
+        }
         globus_l_logging_flush(handle);
     }
     globus_mutex_unlock(&handle->mutex);
@@ -366,6 +763,37 @@ globus_logging_destroy(
         goto err;
     }
 
+    if(handle->type_mask & GLOBUS_LOGGING_WRITER_THREAD)
+    {
+        globus_l_logging_thread_buffer_t *  tb;
+
+        globus_mutex_lock(&handle->mutex);
+        {
+            handle->writer_shutdown = GLOBUS_TRUE;
+            globus_cond_broadcast(&handle->writer_cond);
+            while(handle->writer_running)
+            {
+                globus_cond_wait(&handle->writer_cond, &handle->mutex);
+            }
+            globus_l_logging_drain(handle);
+        }
+        globus_mutex_unlock(&handle->mutex);
+
+        globus_thread_key_delete(handle->thread_buffer_key);
+        while((tb = handle->thread_buffers) != NULL)
+        {
+            handle->thread_buffers = tb->next;
+            globus_mutex_destroy(&tb->mutex);
+            globus_free(tb->buffer);
+            globus_free(tb->spare);
+            globus_free(tb);
+        }
+        globus_cond_destroy(&handle->writer_cond);
+        globus_l_logging_unregister(handle);
+
+        return GLOBUS_SUCCESS;
+    }
+
     globus_mutex_lock(&handle->mutex);
     {
         globus_l_logging_flush(handle);
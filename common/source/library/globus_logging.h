@@ -30,6 +30,13 @@ extern "C" {
 #endif
 
 #define GLOBUS_LOGGING_INLINE           0x08000000
+/* log_type flags: format into per-thread buffers written out by a thread of
+ * the handle's own, buffer_length bytes for each thread.  needs threads and
+ * a flush_period, without them messages are written as before */
+#define GLOBUS_LOGGING_WRITER_THREAD    0x04000000
+/* with GLOBUS_LOGGING_WRITER_THREAD drop and count messages that don't fit
+ * in a full buffer instead of writing them out in the logging thread */
+#define GLOBUS_LOGGING_DROP             0x02000000
 
 typedef struct globus_l_logging_handle_s * globus_logging_handle_t;
 
@@ -0,0 +1,280 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file error_thread_test.c
+ * @brief Error Result Table Tests
+ *
+ * Checks that results map back to their own error objects, that stale
+ * results find nothing, that static errors survive being gotten, and
+ * measures put/peek/get from many threads at once.
+ */
+
+#include "globus_common.h"
+#include "globus_error_string.h"
+#include "globus_test_tap.h"
+#include "globus_preload.h"
+
+#define ITERATIONS 100000
+
+typedef struct
+{
+    globus_mutex_t                      lock;
+    globus_cond_t                       cond;
+    int                                 running;
+    int                                 errors;
+} error_test_monitor_t;
+
+static error_test_monitor_t             monitor;
+
+static
+globus_object_t *
+new_error(
+    int                                 n)
+{
+    return globus_error_construct_string(GLOBUS_NULL, GLOBUS_NULL, "%d", n);
+}
+
+static
+int
+round_trip_test(void)
+{
+    globus_object_t *                   error;
+    globus_result_t                     result;
+    globus_result_t                     stale;
+
+    error = new_error(0);
+    result = globus_error_put(error);
+    if(result == GLOBUS_SUCCESS || result == GLOBUS_FAILURE)
+    {
+        return 1;
+    }
+    if(globus_error_peek(result) != error || globus_error_get(result) != error)
+    {
+        return 1;
+    }
+    stale = result;
+
+    /* the slot is reused with a new generation */
+    result = globus_error_put(error);
+    if(result == stale ||
+        globus_error_get(stale) != GLOBUS_ERROR_NO_INFO ||
+        globus_error_get(result) != error)
+    {
+        return 1;
+    }
+    globus_object_free(error);
+
+    return 0;
+}
+
+static
+int
+spill_test(void)
+{
+    globus_result_t                     results[2000];
+    globus_object_t *                   error;
+    int                                 i;
+    int                                 found = 0;
+    int                                 rc = 0;
+
+    /* far more outstanding than a thread keeps, the newest must survive */
+    for(i = 0; i < 2000; i++)
+    {
+        results[i] = globus_error_put(new_error(i));
+    }
+    for(i = 0; i < 2000; i++)
+    {
+        error = globus_error_get(results[i]);
+        if(error == GLOBUS_ERROR_NO_INFO)
+        {
+            if(i >= 1900)
+            {
+                rc = 1;
+            }
+            continue;
+        }
+        globus_object_free(error);
+        found++;
+    }
+
+    return rc || found == 0;
+}
+
+static
+int
+static_test(void)
+{
+    globus_object_t *                   error;
+    globus_result_t                     result;
+    int                                 i;
+
+    error = new_error(0);
+    result = globus_error_put_static(error);
+    if(result == GLOBUS_SUCCESS || result == GLOBUS_FAILURE)
+    {
+        return 1;
+    }
+    /* gotten as often as wanted, each get its own reference */
+    for(i = 0; i < 3; i++)
+    {
+        if(globus_error_peek(result) != error ||
+            globus_error_get(result) != error)
+        {
+            return 1;
+        }
+        globus_object_free(error);
+    }
+    globus_error_release_static(result);
+
+    return globus_error_get(result) != GLOBUS_ERROR_NO_INFO;
+}
+
+static
+void *
+put_get_thread(
+    void *                              arg)
+{
+    globus_object_t *                   error;
+    globus_object_t *                   held[8];
+    globus_result_t                     results[8];
+    int                                 i;
+    int                                 j;
+    int                                 errors = 0;
+
+    for(j = 0; j < 8; j++)
+    {
+        held[j] = new_error(j);
+    }
+
+    for(i = 0; i < ITERATIONS; i++)
+    {
+        /* a few outstanding results per thread, as with parked eofs */
+        for(j = 0; j < 8; j++)
+        {
+            results[j] = globus_error_put(held[j]);
+        }
+        for(j = 0; j < 8; j++)
+        {
+            if(globus_error_peek(results[j]) != held[j])
+            {
+                errors++;
+            }
+            error = globus_error_get(results[j]);
+            if(error != held[j])
+            {
+                errors++;
+            }
+        }
+        if(globus_error_get(results[0]) != GLOBUS_ERROR_NO_INFO)
+        {
+            errors++;
+        }
+    }
+
+    for(j = 0; j < 8; j++)
+    {
+        globus_object_free(held[j]);
+    }
+
+    globus_mutex_lock(&monitor.lock);
+    monitor.errors += errors;
+    if(--monitor.running == 0)
+    {
+        globus_cond_signal(&monitor.cond);
+    }
+    globus_mutex_unlock(&monitor.lock);
+
+    return NULL;
+}
+
+static
+int
+contention_test(
+    int                                 thread_count)
+{
+    globus_thread_t                     thread;
+    globus_abstime_t                    start;
+    globus_abstime_t                    end;
+    globus_reltime_t                    elapsed;
+    long                                usec;
+    int                                 i;
+
+    monitor.running = thread_count;
+    monitor.errors = 0;
+
+    GlobusTimeAbstimeGetCurrent(start);
+    for(i = 0; i < thread_count; i++)
+    {
+        if(globus_thread_create(&thread, NULL, put_get_thread, NULL) != 0)
+        {
+            return 1;
+        }
+    }
+
+    globus_mutex_lock(&monitor.lock);
+    while(monitor.running > 0)
+    {
+        globus_cond_wait(&monitor.cond, &monitor.lock);
+    }
+    globus_mutex_unlock(&monitor.lock);
+    GlobusTimeAbstimeGetCurrent(end);
+
+    GlobusTimeAbstimeDiff(elapsed, end, start);
+    GlobusTimeReltimeToUSec(usec, elapsed);
+    /* each iteration is 8 puts, 8 peeks and 9 gets */
+    printf("# %d threads: %.0f put/peek/get per second\n",
+        thread_count,
+        (double) thread_count * ITERATIONS * 25 * 1000000.0 /
+            (usec > 0 ? usec : 1));
+
+    return monitor.errors != 0;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    const char * thread_model = THREAD_MODEL;
+    globus_bool_t no_threads = GLOBUS_FALSE;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    globus_thread_set_model(thread_model);
+    globus_module_activate(GLOBUS_COMMON_MODULE);
+
+    globus_mutex_init(&monitor.lock, NULL);
+    globus_cond_init(&monitor.cond, NULL);
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    printf("1..6\n");
+
+    no_threads = (thread_model == NULL || strcmp(thread_model, "none") == 0);
+
+    ok(round_trip_test() == 0, "round_trip");
+    ok(spill_test() == 0, "spill");
+    ok(static_test() == 0, "static");
+    skip(no_threads, ok(contention_test(1) == 0, "1_thread"));
+    skip(no_threads, ok(contention_test(8) == 0, "8_threads"));
+    skip(no_threads, ok(contention_test(64) == 0, "64_threads"));
+
+    globus_cond_destroy(&monitor.cond);
+    globus_mutex_destroy(&monitor.lock);
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return TEST_EXIT_CODE;
+}
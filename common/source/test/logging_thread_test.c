@@ -0,0 +1,342 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file logging_thread_test.c
+ * @brief Logging Writer Thread Tests
+ *
+ * Checks that messages logged from many threads through per-thread buffers
+ * are all written once and in order, that a full buffer drops and counts
+ * messages when asked to, and compares the rate of logging from many
+ * threads with and without the writer thread.
+ */
+
+#include "globus_common.h"
+#include "globus_test_tap.h"
+#include "globus_preload.h"
+
+#define MESSAGES 20000
+#define THREADS 8
+
+typedef struct
+{
+    globus_mutex_t                      lock;
+    globus_cond_t                       cond;
+    int                                 running;
+    globus_logging_handle_t             handle;
+    /* what the module was given */
+    char *                              output;
+    globus_size_t                       output_length;
+    globus_size_t                       output_size;
+    globus_bool_t                       keep_output;
+    int                                 writes;
+} logging_test_monitor_t;
+
+static logging_test_monitor_t           monitor;
+
+static
+void
+test_write_func(
+    globus_byte_t *                     buf,
+    globus_size_t                       length,
+    void *                              user_arg)
+{
+    globus_mutex_lock(&monitor.lock);
+    monitor.writes++;
+    if(monitor.keep_output)
+    {
+        if(monitor.output_length + length + 1 > monitor.output_size)
+        {
+            monitor.output_size = (monitor.output_length + length + 1) * 2;
+            monitor.output = realloc(monitor.output, monitor.output_size);
+        }
+        memcpy(&monitor.output[monitor.output_length], buf, length);
+        monitor.output_length += length;
+        monitor.output[monitor.output_length] = '\0';
+    }
+    globus_mutex_unlock(&monitor.lock);
+}
+
+static globus_logging_module_t          test_module =
+{
+    NULL,
+    test_write_func,
+    NULL,
+    NULL
+};
+
+static
+void
+reset_output(
+    globus_bool_t                       keep_output)
+{
+    monitor.output_length = 0;
+    if(monitor.output)
+    {
+        monitor.output[0] = '\0';
+    }
+    monitor.keep_output = keep_output;
+    monitor.writes = 0;
+}
+
+static
+void *
+log_thread(
+    void *                              arg)
+{
+    int                                 id = (int) (intptr_t) arg;
+    int                                 i;
+
+    for(i = 0; i < MESSAGES; i++)
+    {
+        globus_logging_write(monitor.handle, 1, "t%d m%d\n", id, i);
+    }
+
+    globus_mutex_lock(&monitor.lock);
+    if(--monitor.running == 0)
+    {
+        globus_cond_signal(&monitor.cond);
+    }
+    globus_mutex_unlock(&monitor.lock);
+
+    return NULL;
+}
+
+static
+int
+run_threads(
+    int                                 log_type,
+    globus_size_t                       buffer_length,
+    double *                            rate)
+{
+    globus_thread_t                     thread;
+    globus_reltime_t                    period;
+    globus_abstime_t                    start;
+    globus_abstime_t                    end;
+    globus_reltime_t                    elapsed;
+    long                                usec;
+    int                                 i;
+
+    GlobusTimeReltimeSet(period, 1, 0);
+    if(globus_logging_init(
+        &monitor.handle, &period, buffer_length,
+        log_type, &test_module, NULL) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+
+    monitor.running = THREADS;
+    GlobusTimeAbstimeGetCurrent(start);
+    for(i = 0; i < THREADS; i++)
+    {
+        if(globus_thread_create(
+            &thread, NULL, log_thread, (void *) (intptr_t) i) != 0)
+        {
+            return 1;
+        }
+    }
+
+    globus_mutex_lock(&monitor.lock);
+    while(monitor.running > 0)
+    {
+        globus_cond_wait(&monitor.cond, &monitor.lock);
+    }
+    globus_mutex_unlock(&monitor.lock);
+    GlobusTimeAbstimeGetCurrent(end);
+
+    globus_logging_destroy(monitor.handle);
+
+    GlobusTimeAbstimeDiff(elapsed, end, start);
+    GlobusTimeReltimeToUSec(usec, elapsed);
+    if(rate)
+    {
+        *rate = (double) THREADS * MESSAGES * 1000000.0 /
+            (usec > 0 ? usec : 1);
+    }
+
+    return 0;
+}
+
+static
+int
+all_written_test(void)
+{
+    int                                 next[THREADS];
+    char *                              line;
+    int                                 id;
+    int                                 n;
+    int                                 i;
+
+    reset_output(GLOBUS_TRUE);
+    if(run_threads(0xff | GLOBUS_LOGGING_WRITER_THREAD, 4096, NULL) != 0)
+    {
+        return 1;
+    }
+
+    /* every message once, each thread's in the order it logged them */
+    memset(next, 0, sizeof(next));
+    for(line = monitor.output; line && *line; line = strchr(line, '\n') + 1)
+    {
+        if(sscanf(line, "t%d m%d", &id, &n) != 2 ||
+            id < 0 || id >= THREADS || n != next[id])
+        {
+            return 1;
+        }
+        next[id]++;
+    }
+    for(i = 0; i < THREADS; i++)
+    {
+        if(next[i] != MESSAGES)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static
+int
+drop_test(void)
+{
+    globus_reltime_t                    period;
+    char *                              line;
+    int                                 written = 0;
+    int                                 dropped = 0;
+    int                                 n;
+    int                                 i;
+
+    reset_output(GLOBUS_TRUE);
+
+    /* the writer won't wake for a while, so most of these can't fit */
+    GlobusTimeReltimeSet(period, 60, 0);
+    if(globus_logging_init(
+        &monitor.handle, &period, 4096,
+        0xff | GLOBUS_LOGGING_WRITER_THREAD | GLOBUS_LOGGING_DROP,
+        &test_module, NULL) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+    for(i = 0; i < 1000; i++)
+    {
+        globus_logging_write(monitor.handle, 1, "message %d\n", i);
+    }
+    globus_logging_destroy(monitor.handle);
+
+    for(line = monitor.output; line && *line; line = strchr(line, '\n') + 1)
+    {
+        if(sscanf(line, "*** %d log messages dropped", &n) == 1)
+        {
+            dropped += n;
+        }
+        else
+        {
+            written++;
+        }
+    }
+
+    return dropped == 0 || written + dropped != 1000;
+}
+
+static
+int
+inline_test(void)
+{
+    globus_reltime_t                    period;
+    int                                 rc;
+
+    reset_output(GLOBUS_TRUE);
+
+    GlobusTimeReltimeSet(period, 60, 0);
+    if(globus_logging_init(
+        &monitor.handle, &period, 65536,
+        0xff | GLOBUS_LOGGING_WRITER_THREAD,
+        &test_module, NULL) != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+    globus_logging_write(monitor.handle, 1, "first\n");
+    globus_logging_write(monitor.handle, 1 | GLOBUS_LOGGING_INLINE, "now\n");
+
+    /* written with everything before it, without waiting for the writer */
+    globus_mutex_lock(&monitor.lock);
+    rc = monitor.output == NULL ||
+        strcmp(monitor.output, "first\nnow\n") != 0;
+    globus_mutex_unlock(&monitor.lock);
+
+    globus_logging_destroy(monitor.handle);
+
+    return rc;
+}
+
+static
+int
+rate_test(void)
+{
+    double                              locked_rate;
+    double                              writer_rate;
+
+    reset_output(GLOBUS_FALSE);
+    if(run_threads(0xff, 65536, &locked_rate) != 0)
+    {
+        return 1;
+    }
+    reset_output(GLOBUS_FALSE);
+    if(run_threads(
+        0xff | GLOBUS_LOGGING_WRITER_THREAD, 65536, &writer_rate) != 0)
+    {
+        return 1;
+    }
+
+    printf("# %d threads: %.0f messages per second locked, "
+        "%.0f with writer thread\n", THREADS, locked_rate, writer_rate);
+
+    return 0;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    const char * thread_model = THREAD_MODEL;
+    globus_bool_t no_threads = GLOBUS_FALSE;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    globus_thread_set_model(thread_model);
+    globus_module_activate(GLOBUS_COMMON_MODULE);
+
+    globus_mutex_init(&monitor.lock, NULL);
+    globus_cond_init(&monitor.cond, NULL);
+
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    printf("1..4\n");
+
+    no_threads = (thread_model == NULL || strcmp(thread_model, "none") == 0);
+
+    skip(no_threads, ok(all_written_test() == 0, "all_written"));
+    skip(no_threads, ok(drop_test() == 0, "drop"));
+    skip(no_threads, ok(inline_test() == 0, "inline"));
+    skip(no_threads, ok(rate_test() == 0, "rate"));
+
+    free(monitor.output);
+    globus_cond_destroy(&monitor.cond);
+    globus_mutex_destroy(&monitor.lock);
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return TEST_EXIT_CODE;
+}
@@ -701,7 +701,65 @@ globus_gass_copy_glob_expand_url(
      globus_gass_copy_attr_t *          attr,
      globus_gass_copy_glob_entry_cb_t   entry_cb,
      void *                             user_arg);
-     
+
+/**
+ * @brief Expand globbed url and everything below it
+ * @ingroup globus_gass_copy
+ * @details
+ * This function expands wildcards in a globbed url like
+ * globus_gass_copy_glob_expand_url(), then lists every directory it
+ * matched, and every directory below those, calling entry_cb() on each
+ * entry found.  Directories are listed concurrently, up to max_listings
+ * at a time.  For ftp and gsiftp urls each listing uses its own connection,
+ * which is kept open for the next listing.  For file urls the directories
+ * are read by max_listings threads when the thread model allows it.
+ *
+ * Entries are passed to entry_cb() as soon as the directory containing
+ * them has been read, so the caller can act on them before the rest of the
+ * tree is listed.  The entries of one directory are passed one after
+ * another, and calls to entry_cb() never overlap, but they may come from
+ * different threads.  A directory whose unique_id has been seen already is
+ * passed to entry_cb() but not listed again.  Servers that do not support
+ * MLSD don't report entry types, so only the top url is expanded for them.
+ *
+ * @param handle
+ *        A gass copy handle to use for the operation.
+ *
+ * @param url
+ *	  The URL to expand. The URL may be an ftp, gsiftp or file URL.
+ *        Wildcard characters supported are '?' '*' '[ ]' in the filename
+ *        portion of the url.  A URL without wildcards must end in '/'.
+ *
+ * @param attr
+ *	  Gass copy attributes for this operation.
+ *
+ * @param max_listings
+ *        The most directories to list at once.  If this is less than 1,
+ *        4 is used.
+ *
+ * @param entry_cb
+ *        Function to call with information about each entry
+ *
+ * @param user_arg
+ *        An argument to pass to entry_cb()
+ *
+ * @return
+ *        This function returns an error when any of these conditions are
+ *        true:
+ *        - url cannot be parsed
+ *        - url is not a ftp, gsiftp or file url
+ *        - url has no wildcards and doesn't end in '/'
+ *        - any directory in the tree could not be listed
+ */
+globus_result_t
+globus_gass_copy_glob_expand_tree(
+     globus_gass_copy_handle_t *        handle,
+     const char *                       url,
+     globus_gass_copy_attr_t *          attr,
+     int                                max_listings,
+     globus_gass_copy_glob_entry_cb_t   entry_cb,
+     void *                             user_arg);
+
 /**
  * @brief Make directory
  * @ingroup globus_gass_copy
@@ -18,6 +18,7 @@
 
 #ifndef TARGET_ARCH_WIN32
 #include <fnmatch.h>
+#include <fcntl.h>
 #else
 #define fnmatch(p,f,l) globus_l_win_fnmatch(p,f)
 static
@@ -83,6 +84,11 @@ static
 globus_result_t
 globus_l_gass_copy_glob_parse_ftp_list(
     globus_l_gass_copy_glob_info_t *   info);
+
+static
+globus_result_t
+globus_l_gass_copy_glob_ftp_feat(
+    globus_l_gass_copy_glob_info_t *   info);
     
 static
 globus_result_t
@@ -127,6 +133,61 @@ globus_l_gass_copy_urlencode(
 
 
 #define GLOBUS_GASS_COPY_FTP_LIST_BUFFER_SIZE 256*1024
+#define GLOBUS_L_GASS_COPY_GLOB_TREE_LISTINGS 4
+
+/* a directory waiting to be listed by globus_gass_copy_glob_expand_tree() */
+typedef struct
+{
+    /* ends in '/' */
+    char *                              url;
+    /* local path, file urls only */
+    char *                              path;
+    /* NULL below the top directory */
+    char *                              glob_pattern;
+} globus_l_gass_copy_glob_dir_t;
+
+typedef struct
+{
+    globus_mutex_t                      mutex;
+    globus_cond_t                       cond;
+    globus_object_t *                   err;
+    globus_fifo_t                       dir_queue;
+    /* unique ids of directories already queued */
+    globus_hashtable_t                  seen_dirs;
+    /* directories being listed */
+    int                                 busy;
+    /* threads reading local directories */
+    int                                 workers;
+    globus_l_gass_copy_ftp_op_t         list_op;
+    globus_ftp_client_handle_t *        ftp_handles;
+    int                                 ftp_handle_count;
+    globus_fifo_t                       idle_handles;
+    globus_gass_copy_attr_t *           attr;
+    globus_gass_copy_glob_entry_cb_t    entry_cb;
+    void *                              entry_user_arg;
+} globus_l_gass_copy_glob_tree_t;
+
+/* one outstanding ftp listing, info holds its buffer and parse state */
+typedef struct
+{
+    globus_l_gass_copy_glob_info_t      info;
+    globus_l_gass_copy_glob_tree_t *    tree;
+    globus_ftp_client_handle_t *        ftp_handle;
+    globus_byte_t *                     read_buffer;
+} globus_l_gass_copy_glob_listing_t;
+
+/* an entry of a local directory, held until the directory has been read */
+typedef struct
+{
+    char *                              url;
+    char *                              path;
+    globus_gass_copy_glob_stat_t        stat_info;
+} globus_l_gass_copy_glob_file_entry_t;
+
+static
+void
+globus_l_gass_copy_glob_tree_ftp_start(
+    globus_l_gass_copy_glob_tree_t *    tree);
 
 
 globus_result_t 
@@ -513,43 +574,12 @@ error_url:
 
 static
 globus_result_t
-globus_l_gass_copy_glob_expand_ftp_url(
+globus_l_gass_copy_glob_ftp_feat(
     globus_l_gass_copy_glob_info_t *    info)
 {
-    static char *   myname = "globus_l_gass_copy_glob_expand_ftp_url";    
     globus_result_t                    result;    
     globus_ftp_client_tristate_t       feature_response;
     globus_ftp_client_features_t       features;
-    char *                             tmp;
-    
-
-
-    info->base_url = globus_libc_strdup(info->url);
-    tmp = strrchr(info->base_url, '/');
-    if(tmp == GLOBUS_NULL || tmp == '\0')
-    {
-        result = globus_error_put(
-            globus_error_construct_string(
-                GLOBUS_GASS_COPY_MODULE,
-                GLOBUS_NULL,
-                "[%s]: Bad URL",
-                myname));
-        goto error_url;
-    }
-
-    tmp++;
-    info->glob_pattern = globus_libc_strdup(tmp);
-    *tmp = '\0';
-
-    globus_url_string_hex_decode(info->glob_pattern);
-   
-    info->base_url_len = strlen(info->base_url);
-    info->list_buffer = GLOBUS_NULL;
-    info->buffer_length = 0;
-    info->err = GLOBUS_NULL;
-            
-    globus_mutex_init(&info->mutex, GLOBUS_NULL);
-    globus_cond_init(&info->cond, GLOBUS_NULL);
 
     result = globus_ftp_client_features_init(&features);
 
@@ -608,6 +638,62 @@ globus_l_gass_copy_glob_expand_ftp_url(
         info->list_op = GLOBUS_GASS_COPY_FTP_OP_NLST;
     }
 
+    globus_ftp_client_features_destroy(&features);
+
+    return GLOBUS_SUCCESS;
+
+error_feat:
+    globus_ftp_client_features_destroy(&features);
+
+error_feat_init:
+    return result;
+}
+
+static
+globus_result_t
+globus_l_gass_copy_glob_expand_ftp_url(
+    globus_l_gass_copy_glob_info_t *    info)
+{
+    static char *   myname = "globus_l_gass_copy_glob_expand_ftp_url";    
+    globus_result_t                    result;    
+    char *                             tmp;
+    
+
+
+    info->base_url = globus_libc_strdup(info->url);
+    tmp = strrchr(info->base_url, '/');
+    if(tmp == GLOBUS_NULL || tmp == '\0')
+    {
+        result = globus_error_put(
+            globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: Bad URL",
+                myname));
+        goto error_url;
+    }
+
+    tmp++;
+    info->glob_pattern = globus_libc_strdup(tmp);
+    *tmp = '\0';
+
+    globus_url_string_hex_decode(info->glob_pattern);
+   
+    info->base_url_len = strlen(info->base_url);
+    info->list_buffer = GLOBUS_NULL;
+    info->buffer_length = 0;
+    info->err = GLOBUS_NULL;
+            
+    globus_mutex_init(&info->mutex, GLOBUS_NULL);
+    globus_cond_init(&info->cond, GLOBUS_NULL);
+
+    result = globus_l_gass_copy_glob_ftp_feat(info);
+
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_feat;
+    }
+
     result = globus_l_gass_copy_glob_ftp_list(info);    
          
     if(result != GLOBUS_SUCCESS)
@@ -627,8 +713,6 @@ globus_l_gass_copy_glob_expand_ftp_url(
         globus_free(info->list_buffer);
     }
    
-    globus_ftp_client_features_destroy(&features);
-
     globus_cond_destroy(&info->cond);
     globus_mutex_destroy(&info->mutex);
         
@@ -640,9 +724,6 @@ globus_l_gass_copy_glob_expand_ftp_url(
 
 error_list:
 error_feat:
-    globus_ftp_client_features_destroy(&features);
-
-error_feat_init:    
     globus_cond_destroy(&info->cond);
     globus_mutex_destroy(&info->mutex);
     globus_free(info->glob_pattern);
@@ -1466,6 +1547,947 @@ error_before_callback:
 }
 
 
+/************************************************************
+ * tree expansion
+ ***********************************************************/
+
+static
+void
+globus_l_gass_copy_glob_dir_free(
+    globus_l_gass_copy_glob_dir_t *     dir)
+{
+    globus_free(dir->url);
+    if(dir->path)
+    {
+        globus_free(dir->path);
+    }
+    if(dir->glob_pattern)
+    {
+        globus_free(dir->glob_pattern);
+    }
+    globus_free(dir);
+}
+
+static
+void
+globus_l_gass_copy_glob_tree_set_error(
+    globus_l_gass_copy_glob_tree_t *    tree,
+    globus_object_t *                   err)
+{
+    if(tree->err == GLOBUS_NULL)
+    {
+        tree->err = err;
+    }
+    else
+    {
+        globus_object_free(err);
+    }
+}
+
+/* called locked.  passes the entry on and queues new directories */
+static
+void
+globus_l_gass_copy_glob_tree_entry(
+    globus_l_gass_copy_glob_tree_t *    tree,
+    const char *                        url,
+    const char *                        path,
+    const globus_gass_copy_glob_stat_t * stat_info)
+{
+    globus_l_gass_copy_glob_dir_t *     dir;
+    char *                              unique_id;
+
+    tree->entry_cb(url, stat_info, tree->entry_user_arg);
+
+    if(stat_info->type != GLOBUS_GASS_COPY_GLOB_ENTRY_DIR)
+    {
+        return;
+    }
+
+    /* a link back up the tree would otherwise be listed forever */
+    if(stat_info->unique_id && *stat_info->unique_id)
+    {
+        unique_id = globus_libc_strdup(stat_info->unique_id);
+        if(globus_hashtable_insert(
+            &tree->seen_dirs, unique_id, unique_id) != 0)
+        {
+            globus_free(unique_id);
+            return;
+        }
+    }
+
+    dir = (globus_l_gass_copy_glob_dir_t *)
+        globus_calloc(1, sizeof(globus_l_gass_copy_glob_dir_t));
+    if(dir == GLOBUS_NULL)
+    {
+        globus_l_gass_copy_glob_tree_set_error(
+            tree,
+            globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: Memory allocation error",
+                "globus_l_gass_copy_glob_tree_entry"));
+        return;
+    }
+    dir->url = globus_libc_strdup(url);
+    dir->path = path ? globus_libc_strdup(path) : GLOBUS_NULL;
+
+    globus_fifo_enqueue(&tree->dir_queue, dir);
+    globus_cond_signal(&tree->cond);
+}
+
+static
+void
+globus_l_gass_copy_glob_tree_ftp_entry_cb(
+    const char *                         url,
+    const globus_gass_copy_glob_stat_t * info_stat,
+    void *                               user_arg)
+{
+    globus_l_gass_copy_glob_listing_t * listing;
+
+    listing = (globus_l_gass_copy_glob_listing_t *) user_arg;
+
+    globus_l_gass_copy_glob_tree_entry(listing->tree, url, NULL, info_stat);
+}
+
+static
+void
+globus_l_gass_copy_glob_tree_ftp_finished(
+    globus_l_gass_copy_glob_listing_t * listing,
+    globus_object_t *                   err)
+{
+    globus_l_gass_copy_glob_tree_t *    tree;
+    globus_result_t                     result;
+
+    tree = listing->tree;
+
+    globus_mutex_lock(&tree->mutex);
+    if(err && !listing->info.err)
+    {
+        listing->info.err = globus_object_copy(err);
+    }
+    listing->info.callbacks_left--;
+    if(listing->info.callbacks_left > 0)
+    {
+        globus_mutex_unlock(&tree->mutex);
+        return;
+    }
+
+    if(listing->info.err == GLOBUS_NULL &&
+        listing->info.list_buffer != GLOBUS_NULL &&
+        tree->err == GLOBUS_NULL)
+    {
+        result = globus_l_gass_copy_glob_parse_ftp_list(&listing->info);
+        if(result != GLOBUS_SUCCESS)
+        {
+            listing->info.err = globus_error_get(result);
+        }
+    }
+    if(listing->info.err)
+    {
+        globus_l_gass_copy_glob_tree_set_error(tree, listing->info.err);
+    }
+
+    globus_fifo_enqueue(&tree->idle_handles, listing->ftp_handle);
+    tree->busy--;
+
+    if(listing->info.list_buffer)
+    {
+        globus_free(listing->info.list_buffer);
+    }
+    globus_free(listing->info.base_url);
+    globus_free(listing->info.glob_pattern);
+    globus_free(listing->read_buffer);
+    globus_free(listing);
+
+    globus_l_gass_copy_glob_tree_ftp_start(tree);
+    if(tree->busy == 0)
+    {
+        globus_cond_signal(&tree->cond);
+    }
+    globus_mutex_unlock(&tree->mutex);
+}
+
+static
+void
+globus_l_gass_copy_glob_tree_ftp_done_callback(
+    void *                             user_arg,
+    globus_ftp_client_handle_t *       handle,
+    globus_object_t *                  err)
+{
+    globus_l_gass_copy_glob_tree_ftp_finished(
+        (globus_l_gass_copy_glob_listing_t *) user_arg, err);
+}
+
+static
+void
+globus_l_gass_copy_glob_tree_ftp_read_callback(
+    void *                             user_arg,
+    globus_ftp_client_handle_t *       handle,
+    globus_object_t *                  err,
+    globus_byte_t *                    buffer,
+    globus_size_t                      length,
+    globus_off_t                       offset,
+    globus_bool_t                      eof)
+{
+    static char *   myname = "globus_l_gass_copy_glob_tree_ftp_read_callback";
+    globus_l_gass_copy_glob_listing_t * listing;
+    globus_l_gass_copy_glob_info_t *    info;
+    globus_object_t *                   read_err = GLOBUS_NULL;
+    globus_result_t                     result;
+    char *                              temp_p;
+
+    listing = (globus_l_gass_copy_glob_listing_t *) user_arg;
+    info = &listing->info;
+
+    if(err)
+    {
+        goto error;
+    }
+
+    if((length + offset) > info->buffer_length)
+    {
+        /* one spare byte, the nlst parser terminates the last line */
+        temp_p = (char *)
+            globus_realloc(info->list_buffer, length + offset + 1);
+        if(temp_p == GLOBUS_NULL)
+        {
+            read_err = globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: Memory allocation error",
+                myname);
+            goto error;
+        }
+
+        info->list_buffer = temp_p;
+        info->buffer_length = length + offset;
+    }
+    memcpy(info->list_buffer + offset, buffer, length);
+
+    if(!eof)
+    {
+        result = globus_ftp_client_register_read(
+            handle,
+            buffer,
+            GLOBUS_GASS_COPY_FTP_LIST_BUFFER_SIZE,
+            globus_l_gass_copy_glob_tree_ftp_read_callback,
+            listing);
+        if(result == GLOBUS_SUCCESS)
+        {
+            return;
+        }
+        read_err = globus_error_get(result);
+    }
+
+error:
+    globus_l_gass_copy_glob_tree_ftp_finished(
+        listing, read_err ? read_err : err);
+    if(read_err)
+    {
+        globus_object_free(read_err);
+    }
+}
+
+/* called locked.  starts a listing of dir on ftp_handle */
+static
+globus_result_t
+globus_l_gass_copy_glob_tree_ftp_list(
+    globus_l_gass_copy_glob_tree_t *    tree,
+    globus_l_gass_copy_glob_dir_t *     dir,
+    globus_ftp_client_handle_t *        ftp_handle)
+{
+    static char *   myname = "globus_l_gass_copy_glob_tree_ftp_list";
+    globus_l_gass_copy_glob_listing_t * listing;
+    globus_result_t                     result;
+
+    listing = (globus_l_gass_copy_glob_listing_t *)
+        globus_calloc(1, sizeof(globus_l_gass_copy_glob_listing_t));
+    if(listing == GLOBUS_NULL)
+    {
+        goto error_malloc;
+    }
+    listing->read_buffer = (globus_byte_t *)
+        globus_malloc(GLOBUS_GASS_COPY_FTP_LIST_BUFFER_SIZE);
+    if(listing->read_buffer == GLOBUS_NULL)
+    {
+        globus_free(listing);
+        goto error_malloc;
+    }
+    listing->tree = tree;
+    listing->ftp_handle = ftp_handle;
+    listing->info.base_url = globus_libc_strdup(dir->url);
+    listing->info.base_url_len = strlen(dir->url);
+    listing->info.glob_pattern = globus_libc_strdup(
+        dir->glob_pattern ? dir->glob_pattern : "*");
+    listing->info.list_op = tree->list_op;
+    listing->info.entry_cb = globus_l_gass_copy_glob_tree_ftp_entry_cb;
+    listing->info.entry_user_arg = listing;
+    listing->info.callbacks_left = 2;
+
+    if(tree->list_op == GLOBUS_GASS_COPY_FTP_OP_MLSD)
+    {
+        result = globus_ftp_client_machine_list(
+            ftp_handle,
+            listing->info.base_url,
+            tree->attr->ftp_attr,
+            globus_l_gass_copy_glob_tree_ftp_done_callback,
+            listing);
+    }
+    else
+    {
+        result = globus_ftp_client_list(
+            ftp_handle,
+            listing->info.base_url,
+            tree->attr->ftp_attr,
+            globus_l_gass_copy_glob_tree_ftp_done_callback,
+            listing);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_list;
+    }
+    tree->busy++;
+
+    result = globus_ftp_client_register_read(
+        ftp_handle,
+        listing->read_buffer,
+        GLOBUS_GASS_COPY_FTP_LIST_BUFFER_SIZE,
+        globus_l_gass_copy_glob_tree_ftp_read_callback,
+        listing);
+    if(result != GLOBUS_SUCCESS)
+    {
+        /* the done callback finishes the listing */
+        listing->info.err = globus_error_get(result);
+        listing->info.callbacks_left--;
+        globus_ftp_client_abort(ftp_handle);
+    }
+
+    return GLOBUS_SUCCESS;
+
+error_list:
+    globus_free(listing->info.base_url);
+    globus_free(listing->info.glob_pattern);
+    globus_free(listing->read_buffer);
+    globus_free(listing);
+    return result;
+
+error_malloc:
+    return globus_error_put(
+        globus_error_construct_string(
+            GLOBUS_GASS_COPY_MODULE,
+            GLOBUS_NULL,
+            "[%s]: Memory allocation error",
+            myname));
+}
+
+/* called locked.  lists queued directories on the idle handles */
+static
+void
+globus_l_gass_copy_glob_tree_ftp_start(
+    globus_l_gass_copy_glob_tree_t *    tree)
+{
+    globus_l_gass_copy_glob_dir_t *     dir;
+    globus_ftp_client_handle_t *        ftp_handle;
+    globus_result_t                     result;
+
+    while(tree->err == GLOBUS_NULL &&
+        !globus_fifo_empty(&tree->dir_queue) &&
+        !globus_fifo_empty(&tree->idle_handles))
+    {
+        dir = (globus_l_gass_copy_glob_dir_t *)
+            globus_fifo_dequeue(&tree->dir_queue);
+        ftp_handle = (globus_ftp_client_handle_t *)
+            globus_fifo_dequeue(&tree->idle_handles);
+
+        result = globus_l_gass_copy_glob_tree_ftp_list(
+            tree, dir, ftp_handle);
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_fifo_enqueue(&tree->idle_handles, ftp_handle);
+            globus_l_gass_copy_glob_tree_set_error(
+                tree, globus_error_get(result));
+        }
+        globus_l_gass_copy_glob_dir_free(dir);
+    }
+}
+
+static
+globus_result_t
+globus_l_gass_copy_glob_expand_tree_ftp(
+    globus_l_gass_copy_glob_tree_t *    tree,
+    globus_gass_copy_handle_t *         handle,
+    const char *                        url,
+    int                                 max_listings)
+{
+    globus_l_gass_copy_glob_info_t      info;
+    globus_ftp_client_handleattr_t      handleattr;
+    globus_gass_copy_glob_stat_t        stat_info;
+    globus_result_t                     result;
+    int                                 i;
+
+    memset(&info, 0, sizeof(globus_l_gass_copy_glob_info_t));
+    info.handle = handle;
+    info.attr = tree->attr;
+    info.base_url = (char *) url;
+    globus_mutex_init(&info.mutex, GLOBUS_NULL);
+    globus_cond_init(&info.cond, GLOBUS_NULL);
+
+    result = globus_l_gass_copy_glob_ftp_feat(&info);
+
+    globus_cond_destroy(&info.cond);
+    globus_mutex_destroy(&info.mutex);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_feat;
+    }
+    tree->list_op = info.list_op;
+
+    /* the top directory isn't listed again through a link below it */
+    if(tree->list_op == GLOBUS_GASS_COPY_FTP_OP_MLSD)
+    {
+        memset(&stat_info, 0, sizeof(globus_gass_copy_glob_stat_t));
+        result = globus_gass_copy_stat(
+            handle, (char *) url, tree->attr, &stat_info);
+        if(result != GLOBUS_SUCCESS)
+        {
+            /* only loop detection is lost */
+            globus_object_free(globus_error_get(result));
+        }
+        else if(stat_info.unique_id != GLOBUS_NULL &&
+            (*stat_info.unique_id == '\0' ||
+            globus_hashtable_insert(
+                &tree->seen_dirs,
+                stat_info.unique_id,
+                stat_info.unique_id) != 0))
+        {
+            globus_free(stat_info.unique_id);
+        }
+        if(stat_info.symlink_target)
+        {
+            globus_free(stat_info.symlink_target);
+        }
+    }
+
+    result = globus_ftp_client_handleattr_init(&handleattr);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_feat;
+    }
+    /* each handle keeps its connection for its next listing */
+    globus_ftp_client_handleattr_set_cache_all(&handleattr, GLOBUS_TRUE);
+
+    tree->ftp_handles = (globus_ftp_client_handle_t *)
+        globus_calloc(max_listings, sizeof(globus_ftp_client_handle_t));
+    for(i = 0; tree->ftp_handles && i < max_listings; i++)
+    {
+        result = globus_ftp_client_handle_init(
+            &tree->ftp_handles[i], &handleattr);
+        if(result != GLOBUS_SUCCESS)
+        {
+            break;
+        }
+        globus_fifo_enqueue(&tree->idle_handles, &tree->ftp_handles[i]);
+    }
+    tree->ftp_handle_count = i;
+    globus_ftp_client_handleattr_destroy(&handleattr);
+
+    if(tree->ftp_handle_count == 0)
+    {
+        goto error_handles;
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        /* carry on with fewer listings */
+        globus_object_free(globus_error_get(result));
+        result = GLOBUS_SUCCESS;
+    }
+
+    globus_mutex_lock(&tree->mutex);
+    globus_l_gass_copy_glob_tree_ftp_start(tree);
+    while(tree->busy > 0)
+    {
+        globus_cond_wait(&tree->cond, &tree->mutex);
+    }
+    globus_mutex_unlock(&tree->mutex);
+
+    for(i = 0; i < tree->ftp_handle_count; i++)
+    {
+        globus_ftp_client_handle_destroy(&tree->ftp_handles[i]);
+    }
+
+error_handles:
+    if(tree->ftp_handles)
+    {
+        globus_free(tree->ftp_handles);
+    }
+    else
+    {
+        result = globus_error_put(
+            globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: Memory allocation error",
+                "globus_l_gass_copy_glob_expand_tree_ftp"));
+    }
+
+error_feat:
+    return result;
+}
+
+/* reads one local directory, then passes its entries on together */
+static
+globus_result_t
+globus_l_gass_copy_glob_tree_list_file(
+    globus_l_gass_copy_glob_tree_t *    tree,
+    globus_l_gass_copy_glob_dir_t *     dir)
+{
+    static char *   myname = "globus_l_gass_copy_glob_tree_list_file";
+    globus_l_gass_copy_glob_file_entry_t * entry;
+    globus_gass_copy_glob_entry_t       type;
+    globus_fifo_t                       entries;
+    struct dirent *                     dir_entry;
+    struct stat                         stat_buf;
+    DIR *                               dir_h;
+    char                                path[MAXPATHLEN];
+    char                                symlink_target[MAXPATHLEN*2];
+    char                                unique_id[256];
+    char *                              encoded_path;
+    int                                 rc;
+#if defined(HAVE_FDOPENDIR) && defined(HAVE_FSTATAT)
+    int                                 fd;
+
+    /* names are stat'ed relative to the open directory, so the kernel
+     * doesn't walk the whole path again for every entry */
+    dir_h = GLOBUS_NULL;
+    fd = open(dir->path, O_RDONLY);
+    if(fd >= 0)
+    {
+        dir_h = fdopendir(fd);
+        if(dir_h == GLOBUS_NULL)
+        {
+            close(fd);
+        }
+    }
+#else
+    dir_h = globus_libc_opendir(dir->path);
+#endif
+    if(dir_h == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: unable to open url path, %s",
+                myname,
+                dir->path));
+    }
+
+    globus_fifo_init(&entries);
+    while((dir_entry = readdir(dir_h)) != GLOBUS_NULL)
+    {
+        if(dir_entry->d_name[0] == '.' && (dir_entry->d_name[1] == '\0' ||
+            (dir_entry->d_name[1] == '.' && dir_entry->d_name[2] == '\0')))
+        {
+            continue;
+        }
+        if(dir->glob_pattern &&
+            fnmatch(dir->glob_pattern, dir_entry->d_name, 0) != 0)
+        {
+            continue;
+        }
+
+        snprintf(path, sizeof(path),
+            "%s/%s", dir->path, dir_entry->d_name);
+        path[MAXPATHLEN - 1] = '\0';
+#if defined(HAVE_FDOPENDIR) && defined(HAVE_FSTATAT)
+        rc = fstatat(fd, dir_entry->d_name, &stat_buf, AT_SYMLINK_NOFOLLOW);
+#elif !defined(TARGET_ARCH_WIN32)
+        rc = lstat(path, &stat_buf);
+#else
+        rc = stat(path, &stat_buf);
+#endif
+        if(rc != 0)
+        {
+            /* removed since it was read, skip it */
+            continue;
+        }
+
+        *symlink_target = '\0';
+#ifdef S_ISLNK
+        if(S_ISLNK(stat_buf.st_mode))
+        {
+#if defined(HAVE_FDOPENDIR) && defined(HAVE_FSTATAT)
+            rc = fstatat(fd, dir_entry->d_name, &stat_buf, 0);
+#else
+            rc = stat(path, &stat_buf);
+#endif
+            if(rc != 0 || realpath(path, symlink_target) == NULL)
+            {
+                continue;
+            }
+        }
+#endif
+
+        if(S_ISDIR(stat_buf.st_mode))
+        {
+            type = GLOBUS_GASS_COPY_GLOB_ENTRY_DIR;
+        }
+        else
+        {
+            type = GLOBUS_GASS_COPY_GLOB_ENTRY_FILE;
+        }
+
+        sprintf(
+            unique_id,
+            "%lx-%lx;",
+            (unsigned long) stat_buf.st_dev,
+            (unsigned long) stat_buf.st_ino);
+
+        entry = (globus_l_gass_copy_glob_file_entry_t *)
+            globus_calloc(1, sizeof(globus_l_gass_copy_glob_file_entry_t));
+        if(entry == GLOBUS_NULL)
+        {
+            break;
+        }
+
+        globus_l_gass_copy_urlencode(dir_entry->d_name, &encoded_path);
+        entry->url = globus_common_create_string(
+            "%s%s%s",
+            dir->url,
+            encoded_path,
+            type == GLOBUS_GASS_COPY_GLOB_ENTRY_DIR ? "/" : "");
+        globus_free(encoded_path);
+
+        if(type == GLOBUS_GASS_COPY_GLOB_ENTRY_DIR)
+        {
+            entry->path = globus_libc_strdup(path);
+        }
+        entry->stat_info.type = type;
+        entry->stat_info.unique_id = globus_libc_strdup(unique_id);
+        entry->stat_info.symlink_target =
+            *symlink_target ? globus_libc_strdup(symlink_target) : NULL;
+        entry->stat_info.mode = stat_buf.st_mode & 07777;
+        entry->stat_info.mdtm = (int) stat_buf.st_mtime;
+        entry->stat_info.size = stat_buf.st_size;
+
+        globus_fifo_enqueue(&entries, entry);
+    }
+    closedir(dir_h);
+
+    globus_mutex_lock(&tree->mutex);
+    while(!globus_fifo_empty(&entries))
+    {
+        entry = (globus_l_gass_copy_glob_file_entry_t *)
+            globus_fifo_dequeue(&entries);
+
+        if(tree->err == GLOBUS_NULL)
+        {
+            globus_l_gass_copy_glob_tree_entry(
+                tree, entry->url, entry->path, &entry->stat_info);
+        }
+
+        globus_free(entry->url);
+        if(entry->path)
+        {
+            globus_free(entry->path);
+        }
+        globus_free(entry->stat_info.unique_id);
+        if(entry->stat_info.symlink_target)
+        {
+            globus_free(entry->stat_info.symlink_target);
+        }
+        globus_free(entry);
+    }
+    globus_mutex_unlock(&tree->mutex);
+    globus_fifo_destroy(&entries);
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+void *
+globus_l_gass_copy_glob_tree_file_worker(
+    void *                              user_arg)
+{
+    globus_l_gass_copy_glob_tree_t *    tree;
+    globus_l_gass_copy_glob_dir_t *     dir;
+    globus_result_t                     result;
+
+    tree = (globus_l_gass_copy_glob_tree_t *) user_arg;
+
+    globus_mutex_lock(&tree->mutex);
+    for(;;)
+    {
+        /* a busy worker may still queue more directories */
+        while(globus_fifo_empty(&tree->dir_queue) &&
+            tree->busy > 0 &&
+            tree->err == GLOBUS_NULL)
+        {
+            globus_cond_wait(&tree->cond, &tree->mutex);
+        }
+        if(tree->err != GLOBUS_NULL || globus_fifo_empty(&tree->dir_queue))
+        {
+            break;
+        }
+
+        dir = (globus_l_gass_copy_glob_dir_t *)
+            globus_fifo_dequeue(&tree->dir_queue);
+        tree->busy++;
+        globus_mutex_unlock(&tree->mutex);
+
+        result = globus_l_gass_copy_glob_tree_list_file(tree, dir);
+        globus_l_gass_copy_glob_dir_free(dir);
+
+        globus_mutex_lock(&tree->mutex);
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_l_gass_copy_glob_tree_set_error(
+                tree, globus_error_get(result));
+        }
+        tree->busy--;
+        globus_cond_broadcast(&tree->cond);
+    }
+    tree->workers--;
+    globus_cond_broadcast(&tree->cond);
+    globus_mutex_unlock(&tree->mutex);
+
+    return NULL;
+}
+
+static
+globus_result_t
+globus_l_gass_copy_glob_expand_tree_file(
+    globus_l_gass_copy_glob_tree_t *    tree,
+    int                                 max_listings)
+{
+    globus_thread_t                     thread;
+    int                                 i;
+
+    globus_mutex_lock(&tree->mutex);
+    tree->workers = 1;
+    for(i = 1; i < max_listings && globus_thread_preemptive_threads(); i++)
+    {
+        if(globus_thread_create(
+            &thread,
+            GLOBUS_NULL,
+            globus_l_gass_copy_glob_tree_file_worker,
+            tree) != 0)
+        {
+            break;
+        }
+        tree->workers++;
+    }
+    globus_mutex_unlock(&tree->mutex);
+
+    /* this thread reads directories too */
+    globus_l_gass_copy_glob_tree_file_worker(tree);
+
+    globus_mutex_lock(&tree->mutex);
+    while(tree->workers > 0)
+    {
+        globus_cond_wait(&tree->cond, &tree->mutex);
+    }
+    globus_mutex_unlock(&tree->mutex);
+
+    return GLOBUS_SUCCESS;
+}
+
+globus_result_t
+globus_gass_copy_glob_expand_tree(
+     globus_gass_copy_handle_t *        handle,
+     const char *                       url,
+     globus_gass_copy_attr_t *          attr,
+     int                                max_listings,
+     globus_gass_copy_glob_entry_cb_t   entry_cb,
+     void *                             user_arg)
+{
+    static char *   myname = "globus_gass_copy_glob_expand_tree";
+    globus_l_gass_copy_glob_tree_t      tree;
+    globus_l_gass_copy_glob_dir_t *     dir;
+    globus_url_scheme_t                 scheme_type;
+    globus_url_t                        parsed_url;
+    globus_result_t                     result;
+    struct stat                         stat_buf;
+    char                                unique_id[256] = "";
+    char *                              pattern;
+    int                                 len;
+
+    if(handle == GLOBUS_NULL || url == GLOBUS_NULL || entry_cb == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: BAD_PARAMETER",
+                myname));
+    }
+    if(max_listings < 1)
+    {
+        max_listings = GLOBUS_L_GASS_COPY_GLOB_TREE_LISTINGS;
+    }
+
+    if(globus_url_get_scheme(url, &scheme_type) != 0)
+    {
+        return globus_error_put(
+            globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: error parsing url scheme.",
+                myname));
+    }
+
+    dir = (globus_l_gass_copy_glob_dir_t *)
+        globus_calloc(1, sizeof(globus_l_gass_copy_glob_dir_t));
+    dir->url = globus_libc_strdup(url);
+
+    pattern = strrchr(dir->url, '/');
+    if(pattern == GLOBUS_NULL)
+    {
+        result = globus_error_put(
+            globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: Bad URL",
+                myname));
+        goto error_url;
+    }
+    pattern++;
+    if(*pattern != '\0')
+    {
+        if(strcspn(pattern, "[]*?") == strlen(pattern))
+        {
+            result = globus_error_put(
+                globus_error_construct_string(
+                    GLOBUS_GASS_COPY_MODULE,
+                    GLOBUS_NULL,
+                    "[%s]: url must end in '/' or contain wildcards: %s",
+                    myname,
+                    url));
+            goto error_url;
+        }
+        dir->glob_pattern = globus_libc_strdup(pattern);
+        globus_url_string_hex_decode(dir->glob_pattern);
+        *pattern = '\0';
+    }
+
+    if(scheme_type == GLOBUS_URL_SCHEME_FILE)
+    {
+        if(globus_url_parse_loose(dir->url, &parsed_url) != 0 ||
+            parsed_url.url_path == GLOBUS_NULL)
+        {
+            result = globus_error_put(
+                globus_error_construct_string(
+                    GLOBUS_GASS_COPY_MODULE,
+                    GLOBUS_NULL,
+                    "[%s]: error parsing url path: %s",
+                    myname,
+                    dir->url));
+            goto error_url;
+        }
+        dir->path = globus_libc_strdup(parsed_url.url_path);
+        globus_url_destroy(&parsed_url);
+
+        len = strlen(dir->path);
+        if(len > 1 && dir->path[len - 1] == '/')
+        {
+            dir->path[len - 1] = '\0';
+        }
+
+        if(stat(dir->path, &stat_buf) != 0)
+        {
+            result = globus_error_put(
+                globus_error_construct_string(
+                    GLOBUS_GASS_COPY_MODULE,
+                    GLOBUS_NULL,
+                    "[%s]: unable to access url path: %s",
+                    myname,
+                    dir->path));
+            goto error_url;
+        }
+        sprintf(
+            unique_id,
+            "%lx-%lx;",
+            (unsigned long) stat_buf.st_dev,
+            (unsigned long) stat_buf.st_ino);
+    }
+
+    memset(&tree, 0, sizeof(globus_l_gass_copy_glob_tree_t));
+    globus_mutex_init(&tree.mutex, GLOBUS_NULL);
+    globus_cond_init(&tree.cond, GLOBUS_NULL);
+    globus_fifo_init(&tree.dir_queue);
+    globus_fifo_init(&tree.idle_handles);
+    globus_hashtable_init(
+        &tree.seen_dirs,
+        256,
+        globus_hashtable_string_hash,
+        globus_hashtable_string_keyeq);
+    tree.attr = attr;
+    tree.entry_cb = entry_cb;
+    tree.entry_user_arg = user_arg;
+
+    if(*unique_id)
+    {
+        /* the top directory isn't listed again through a link below it */
+        pattern = globus_libc_strdup(unique_id);
+        globus_hashtable_insert(&tree.seen_dirs, pattern, pattern);
+    }
+    globus_fifo_enqueue(&tree.dir_queue, dir);
+
+    switch (scheme_type)
+    {
+      case GLOBUS_URL_SCHEME_FTP:
+      case GLOBUS_URL_SCHEME_GSIFTP:
+      case GLOBUS_URL_SCHEME_SSHFTP:
+        result = globus_l_gass_copy_glob_expand_tree_ftp(
+            &tree, handle, dir->url, max_listings);
+        break;
+
+      case GLOBUS_URL_SCHEME_FILE:
+        result = globus_l_gass_copy_glob_expand_tree_file(
+            &tree, max_listings);
+        break;
+
+      default:
+        result = globus_error_put(
+            globus_error_construct_string(
+                GLOBUS_GASS_COPY_MODULE,
+                GLOBUS_NULL,
+                "[%s]: Globbing not supported with URL scheme.",
+                myname));
+        break;
+    }
+
+    if(result == GLOBUS_SUCCESS && tree.err != GLOBUS_NULL)
+    {
+        result = globus_error_put(tree.err);
+        tree.err = GLOBUS_NULL;
+    }
+
+    /* left over after an error */
+    while(!globus_fifo_empty(&tree.dir_queue))
+    {
+        globus_l_gass_copy_glob_dir_free(
+            (globus_l_gass_copy_glob_dir_t *)
+                globus_fifo_dequeue(&tree.dir_queue));
+    }
+    if(tree.err)
+    {
+        globus_object_free(tree.err);
+    }
+    globus_hashtable_destroy_all(&tree.seen_dirs, globus_libc_free);
+    globus_fifo_destroy(&tree.idle_handles);
+    globus_fifo_destroy(&tree.dir_queue);
+    globus_cond_destroy(&tree.cond);
+    globus_mutex_destroy(&tree.mutex);
+
+    return result;
+
+error_url:
+    globus_l_gass_copy_glob_dir_free(dir);
+    return result;
+}
+
+
 static const char *hex_chars = "0123456789ABCDEF";
 #define ALLOWED_CHARS "$-_.+!'\"(),/:@=&"
 
@@ -1111,6 +1111,48 @@ globus_l_guc_glob_list_cb(
     globus_url_destroy(&url_info);
 }
     
+/* entries of one directory arrive together, print a heading before each */
+static
+void
+globus_l_guc_glob_tree_list_cb(
+    const char *                         url,
+    const globus_gass_copy_glob_stat_t * info_stat,
+    void *                               user_arg)
+{
+    char **                             current_dir;
+    const char *                        name;
+    char *                              tmp_str;
+    int                                 dir_len;
+    int                                 name_len;
+
+    current_dir = (char **) user_arg;
+
+    name_len = strlen(url);
+    if(name_len > 0 && url[name_len - 1] == '/')
+    {
+        name_len--;
+    }
+    for(dir_len = name_len; dir_len > 0 && url[dir_len - 1] != '/'; dir_len--)
+    {
+    }
+    name = url + dir_len;
+    name_len -= dir_len;
+
+    if(strlen(*current_dir) != dir_len ||
+        strncmp(*current_dir, url, dir_len) != 0)
+    {
+        free(*current_dir);
+        *current_dir = globus_common_create_string("%.*s", dir_len, url);
+        printf("\n%s\n", *current_dir);
+    }
+
+    tmp_str = globus_common_create_string("%.*s", name_len, name);
+    globus_url_string_hex_decode(tmp_str);
+    printf("    %s%c\n", tmp_str,
+        info_stat->type == GLOBUS_GASS_COPY_GLOB_ENTRY_DIR ? '/' : ' ');
+    free(tmp_str);
+}
+
 static
 void
 globus_l_guc_ext_interrupt_handler(
@@ -1950,7 +1992,34 @@ main(int argc, char **argv)
     globus_cond_init(&g_monitor.cond, NULL);
     g_monitor.was_error = 0;
     
-    if(guc_info.list_url != NULL)
+    if(guc_info.list_url != NULL && guc_info.recurse &&
+        guc_info.list_url[strlen(guc_info.list_url) - 1] == '/')
+    {
+        char *                          current_dir;
+
+        /* list the whole tree at once, several directories at a time */
+        current_dir = globus_libc_strdup(guc_info.list_url);
+        fprintf(stdout, "%s\n", current_dir);
+        globus_l_guc_gass_attr_init(
+            &guc_info.handles[0]->source_gass_copy_attr,
+            &guc_info.handles[0]->source_gass_attr,
+            &guc_info.handles[0]->source_ftp_attr,
+            &guc_info,
+            guc_info.list_url,
+            GLOBUS_TRUE,
+            GLOBUS_TRUE);
+
+        result = globus_gass_copy_glob_expand_tree(
+                &guc_info.handles[0]->gass_copy_handle,
+                guc_info.list_url,
+                &guc_info.handles[0]->source_gass_copy_attr,
+                guc_info.conc > 1 ? guc_info.conc : 0,
+                globus_l_guc_glob_tree_list_cb,
+                &current_dir);
+        free(current_dir);
+        fprintf(stdout, "\n");
+    }
+    else if(guc_info.list_url != NULL)
     {
         globus_fifo_enqueue(&guc_info.expanded_url_list,
             strdup(guc_info.list_url));
@@ -6089,13 +6158,16 @@ globus_l_guc_gass_attr_init(
             tmp_net_str = guc_info->dst_net_stack_str;
             tmp_disk_str = guc_info->dst_disk_stack_str;
         }
-        if(tmp_net_str != NULL && gsi_driver_str != NULL)
+        if(tmp_net_str != NULL)
         {
             char *  tmp_stack;
             char *  second_driver;
             char * gsi_ptr;
 
-            if ((strstr(tmp_net_str, "gsi,") != tmp_net_str) &&
+            /* gsi is only added to gsiftp stacks, ftp stacks are used as
+             * given */
+            if (gsi_driver_str != NULL &&
+                (strstr(tmp_net_str, "gsi,") != tmp_net_str) &&
                 (strstr(tmp_net_str, ",gsi,") == NULL) &&
                 (((gsi_ptr = strstr(tmp_net_str, ",gsi")) == NULL) ||
                     (strlen(gsi_ptr) != 4)))
@@ -0,0 +1,165 @@
+#! /usr/bin/perl
+
+#
+# Copyright 1999-2006 University of Chicago
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# These tests list a directory tree with globus-url-copy -r -list, which
+# uses globus_gass_copy_glob_expand_tree(), locally and through the server,
+# and compare each directory's entries with what is on disk.
+require 5.8.0;
+
+use strict;
+use warnings;
+use Test::More;
+use IPC::Open3;
+use Symbol qw/gensym/;
+use File::Temp qw/ tempdir /;
+use File::Path qw/ mkpath /;
+
+my $subject = $ENV{FTP_TEST_SUBJECT};
+my $server_cs = $ENV{FTP_TEST_CONTACT};
+
+my @cc_opts = (
+    ['-cc', '1'],
+    ['-cc', '4']);
+
+my $work_dir = tempdir( CLEANUP => 1);
+my $tree = "$work_dir/tree";
+my %expected;
+
+# 3 levels of 3 directories, a few files in each, a name with a space
+# and a link back to the top that must not be listed again
+sub make_tree
+{
+    my ($dir, $depth) = @_;
+    my $fd;
+
+    mkpath($dir);
+    for my $i (0..2)
+    {
+        open($fd, ">$dir/f$i");
+        print $fd "$i\n";
+        close($fd);
+    }
+    return if $depth == 0;
+    for my $i (0..2)
+    {
+        make_tree("$dir/d$i", $depth - 1);
+    }
+}
+make_tree($tree, 3);
+mkpath("$tree/sp ace");
+open(my $fd, ">$tree/sp ace/f0");
+close($fd);
+symlink($tree, "$tree/d1/loop");
+
+sub read_tree
+{
+    my ($dir, $rel) = @_;
+    my ($dh, @entries);
+
+    opendir($dh, $dir);
+    for my $name (grep { $_ ne '.' && $_ ne '..' } readdir($dh))
+    {
+        if (-d "$dir/$name")
+        {
+            push(@entries, "$name/");
+            if (! -l "$dir/$name")
+            {
+                read_tree("$dir/$name", "$rel$name/");
+            }
+        }
+        else
+        {
+            push(@entries, "$name ");
+        }
+    }
+    closedir($dh);
+    (my $key = $rel) =~ s/ /%20/g;
+    $expected{$key} = join("\n", sort @entries);
+}
+read_tree($tree, "");
+
+# directory headings are urls, entry names are decoded
+sub parse_listing
+{
+    my ($base, $out) = @_;
+    my (%got, $dir);
+
+    for my $line (split(/\n/, $out))
+    {
+        if ($line eq '')
+        {
+            $dir = undef;
+        }
+        elsif ($line =~ /^    (.*)$/)
+        {
+            push(@{$got{$dir}}, $1) if defined($dir);
+        }
+        elsif (!defined($dir))
+        {
+            $dir = $line;
+            $dir =~ s/^\Q$base\E// or return undef;
+            $got{$dir} ||= [];
+        }
+    }
+    return { map { $_ => join("\n", sort @{$got{$_}}) } keys %got };
+}
+
+sub list_test
+{
+    my ($base, $cc_opt) = @_;
+    my ($infd, $outfd, $errfd);
+    my ($out, $err);
+    my ($pid, $rc);
+    $errfd = gensym;
+
+    $pid = open3($infd, $outfd, $errfd, "globus-url-copy-noinst",
+        @{$cc_opt}, '-r', '-list', $base);
+    close($infd);
+    {
+        local($/);
+        $out = <$outfd> if $outfd;
+        $err = <$errfd> if $errfd;
+    }
+    waitpid($pid, 0);
+    $rc = $?;
+
+    print STDERR map { "# $_\n" } split(/\n/, $err) if $err;
+
+    ok($rc == 0, join(" ", "guc -r -list", @{$cc_opt}, $base,
+        "exits with 0"));
+    is_deeply(parse_listing($base, $out), \%expected,
+        join(" ", "guc -r -list", @{$cc_opt}, "lists each directory once"));
+}
+
+my $test_count = 4 * scalar(@cc_opts);
+plan tests => $test_count;
+
+foreach my $cc_opt (@cc_opts)
+{
+    list_test("file://$tree/", $cc_opt);
+}
+
+SKIP: {
+    skip "Missing URL or subject", 2 * scalar(@cc_opts)
+        unless($server_cs && $subject);
+
+    foreach my $cc_opt (@cc_opts)
+    {
+        list_test("${server_cs}$tree/", [@{$cc_opt}, '-subject', $subject]);
+    }
+}
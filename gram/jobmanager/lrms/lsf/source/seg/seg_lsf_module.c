@@ -190,6 +190,8 @@ static globus_mutex_t                   globus_l_lsf_mutex;
 static globus_cond_t                    globus_l_lsf_cond;
 static globus_bool_t                    shutdown_called;
 static int                              callback_count;
+static globus_scheduler_event_generator_tail_t
+                                        globus_l_lsf_tail;
 
 
 GlobusDebugDefine(SEG_LSF);
@@ -362,10 +364,22 @@ globus_l_lsf_module_activate(void)
     {
         goto free_logfile_state_path_error;
     }
+
+    result = globus_scheduler_event_generator_tail_init(
+            &globus_l_lsf_tail,
+            logfile_state->log_dir,
+            "lsb.events");
+    if (result != GLOBUS_SUCCESS)
+    {
+        SEGLsfDebug(SEG_LSF_DEBUG_ERROR,
+                ("Error watching log directory: %s\n",
+                globus_error_print_friendly(globus_error_peek(result))));
+        goto close_logfile_error;
+    }
     GlobusTimeReltimeSet(delay, 0, 0);
 
-    result = globus_callback_register_oneshot(
-            NULL,
+    result = globus_scheduler_event_generator_tail_register(
+            globus_l_lsf_tail,
             &delay,
             globus_l_lsf_read_callback,
             logfile_state);
@@ -375,12 +389,17 @@ globus_l_lsf_module_activate(void)
         SEGLsfDebug(SEG_LSF_DEBUG_ERROR,
                 ("Error registering oneshot: %s\n",
                 globus_error_print_friendly(globus_error_peek(result))));
-        goto free_logfile_state_path_error;
+        goto destroy_tail_error;
     }
     callback_count++;
 
     return 0;
 
+destroy_tail_error:
+    globus_scheduler_event_generator_tail_destroy(globus_l_lsf_tail);
+    globus_l_lsf_tail = NULL;
+close_logfile_error:
+    fclose(logfile_state->fp);
 free_logfile_state_path_error:
     if (logfile_state->path)
     {
@@ -420,6 +439,7 @@ globus_l_lsf_module_deactivate(void)
 
     globus_mutex_lock(&globus_l_lsf_mutex);
     shutdown_called = GLOBUS_TRUE;
+    globus_scheduler_event_generator_tail_wakeup(globus_l_lsf_tail);
 
     while (callback_count > 0)
     {
@@ -427,6 +447,9 @@ globus_l_lsf_module_deactivate(void)
     }
     globus_mutex_unlock(&globus_l_lsf_mutex);
 
+    globus_scheduler_event_generator_tail_destroy(globus_l_lsf_tail);
+    globus_l_lsf_tail = NULL;
+
     SEGLsfExit();
     GlobusDebugDestroy(SEG_LSF);
 
@@ -498,8 +521,8 @@ globus_l_lsf_read_callback(
 
             GlobusTimeReltimeSet(delay, 0, 0);
 
-            result = globus_callback_register_oneshot(
-                    NULL,
+            result = globus_scheduler_event_generator_tail_register(
+                    globus_l_lsf_tail,
                     &delay,
                     globus_l_lsf_read_callback,
                     state);
@@ -574,8 +597,8 @@ globus_l_lsf_read_callback(
         GlobusTimeReltimeSet(delay, 2, 0);
     }
 
-    result = globus_callback_register_oneshot(
-            NULL,
+    result = globus_scheduler_event_generator_tail_register(
+            globus_l_lsf_tail,
             &delay,
             globus_l_lsf_read_callback,
             state);
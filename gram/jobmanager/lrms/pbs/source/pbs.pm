@@ -794,6 +794,52 @@ sub poll
     return {JOB_STATE => $state};
 }
 
+sub poll_all
+{
+    my $self = shift;
+    my $description = $self->{JobDescription};
+    my %poll_job_ids = map { $_ => 1 } $description->polljobids();
+    my $job_id;
+    my $state;
+
+    $self->log("polling " . scalar(keys %poll_job_ids) . " jobs");
+
+    # One full qstat listing answers every job which is still known to PBS.
+    # Completed and unknown jobs are left to poll(), which syncs their
+    # output files.
+    foreach ($self->pipe_out_cmd($qstat, '-f'))
+    {
+        if (/^Job Id:\s*(\S+)/)
+        {
+            $job_id = $1;
+            next;
+        }
+        next unless defined($job_id) && exists($poll_job_ids{$job_id});
+        next unless /^\s*job_state\s*=\s*(\S+)/;
+
+        $_ = $1;
+        if(/Q|W|T/)
+        {
+            $state = Globus::GRAM::JobState::PENDING;
+        }
+        elsif(/S|H/)
+        {
+            $state = Globus::GRAM::JobState::SUSPENDED;
+        }
+        elsif(/R|E/)
+        {
+            $state = Globus::GRAM::JobState::ACTIVE;
+        }
+        else
+        {
+            next;
+        }
+        $self->respond({POLL_JOB_STATE => "$job_id:$state"});
+    }
+
+    return {};
+}
+
 sub cancel
 {
     my $self = shift;
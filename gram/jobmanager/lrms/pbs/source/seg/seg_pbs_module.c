@@ -127,6 +127,8 @@ typedef struct
     time_t                              start_timestamp;
     /** Offset of the next event to read from the log file */
     off_t                               log_offset;
+    /** Stdio file handle of the log file, kept open between reads */
+    FILE *                              fp;
     /** Buffer of log file data */
     char *                              buffer;
     /** Length of the buffer */
@@ -142,6 +144,8 @@ static globus_mutex_t                   globus_l_pbs_mutex;
 static globus_cond_t                    globus_l_pbs_cond;
 static globus_bool_t                    shutdown_called;
 static int                              callback_count;
+static globus_scheduler_event_generator_tail_t
+                                        globus_l_pbs_tail;
 
 GlobusDebugDefine(SEG_PBS);
 
@@ -287,6 +291,18 @@ globus_l_pbs_module_activate(void)
 
         goto stat_log_dir_failed;
     }
+    result = globus_scheduler_event_generator_tail_init(
+            &globus_l_pbs_tail,
+            logfile_state->log_dir,
+            NULL);
+    if (result != GLOBUS_SUCCESS)
+    {
+        SEGPbsDebug(SEG_PBS_DEBUG_ERROR,
+                ("Fatal error watching log directory: %s\n",
+                globus_error_print_friendly(globus_error_peek(result))));
+
+        goto tail_init_failed;
+    }
     if (localtime_r(&logfile_state->start_timestamp, &logfile_state->path_time)
             == NULL)
     {
@@ -324,8 +340,8 @@ globus_l_pbs_module_activate(void)
         GlobusTimeReltimeSet(delay, 1, 0);
     }
 
-    result = globus_callback_register_oneshot(
-            NULL,
+    result = globus_scheduler_event_generator_tail_register(
+            globus_l_pbs_tail,
             &delay,
             globus_l_pbs_read_callback,
             logfile_state);
@@ -348,6 +364,9 @@ oneshot_failed:
         free(logfile_state->path);
     }
 alloc_path_failed:
+    globus_scheduler_event_generator_tail_destroy(globus_l_pbs_tail);
+    globus_l_pbs_tail = NULL;
+tail_init_failed:
 stat_log_dir_failed:
     if (logfile_state->log_dir)
     {
@@ -382,6 +401,7 @@ globus_l_pbs_module_deactivate(void)
 
     globus_mutex_lock(&globus_l_pbs_mutex);
     shutdown_called = GLOBUS_TRUE;
+    globus_scheduler_event_generator_tail_wakeup(globus_l_pbs_tail);
 
     while (callback_count > 0)
     {
@@ -389,6 +409,9 @@ globus_l_pbs_module_deactivate(void)
     }
     globus_mutex_unlock(&globus_l_pbs_mutex);
 
+    globus_scheduler_event_generator_tail_destroy(globus_l_pbs_tail);
+    globus_l_pbs_tail = NULL;
+
     SEGPbsExit();
     GlobusDebugDestroy(SEG_PBS);
 
@@ -401,7 +424,8 @@ globus_l_pbs_module_deactivate(void)
  * read callback
  *
  * Try to open a log file (either the last one we parsed or a newer one if
- * it doesn't exist or is done).
+ * it doesn't exist or is done). The file stays open until we move on to
+ * the next one.
  *
  * Seek to the file's current parse location
  *
@@ -418,7 +442,7 @@ globus_l_pbs_read_callback(
     globus_l_pbs_logfile_state_t *      state = user_arg;
     globus_reltime_t                    delay;
     globus_result_t                     result;
-    FILE *                              fp;
+    FILE *                              fp = state->fp;
     time_t                              today;
 
     GlobusFuncName(globus_l_pbs_read_callback);
@@ -441,7 +465,7 @@ globus_l_pbs_read_callback(
      * valid file, so we'll defer the parsing until another callback.
      *
      */
-    do
+    while (fp == NULL)
     {
         fp = fopen(state->path, "r");
 
@@ -529,7 +553,7 @@ globus_l_pbs_read_callback(
             }
         }
     }
-    while (fp == NULL);
+    state->fp = fp;
 
     if (fp != NULL)
     {
@@ -563,6 +587,8 @@ globus_l_pbs_read_callback(
                                  (float) state->log_offset,
                                  strerror(errno)));
 
+                        fclose(fp);
+                        state->fp = NULL;
                         GlobusTimeReltimeSet(delay, 10, 0);
                         goto reregister;
 
@@ -616,6 +642,8 @@ globus_l_pbs_read_callback(
                     {
                         if (state->log_offset == st.st_size)
                         {
+                            fclose(state->fp);
+                            state->fp = NULL;
                             free(state->path);
                             state->path = next_file;
 
@@ -645,11 +673,9 @@ globus_l_pbs_read_callback(
         }
     }
 
-    fclose(fp);
-
 reregister:
-    result = globus_callback_register_oneshot(
-            NULL,
+    result = globus_scheduler_event_generator_tail_register(
+            globus_l_pbs_tail,
             &delay,
             globus_l_pbs_read_callback,
             state);
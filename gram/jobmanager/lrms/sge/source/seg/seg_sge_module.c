@@ -114,6 +114,8 @@ static globus_mutex_t                   globus_l_sge_mutex;
 static globus_cond_t                    globus_l_sge_cond;
 static globus_bool_t                    shutdown_called;
 static int                              callback_count;
+static globus_scheduler_event_generator_tail_t
+                                        globus_l_sge_tail;
 
 
 /* Function signature declarations. */
@@ -206,6 +208,8 @@ globus_l_sge_module_activate(void)
     char                               *globus_sge_conf= NULL;
     char                               *sge_config = NULL;
     char                               *sge_root = NULL, *sge_cell = NULL;
+    char                               *log_dir = NULL;
+    const char                         *log_base;
     globus_result_t                     result;
 
     rc = globus_module_activate(GLOBUS_COMMON_MODULE);
@@ -462,22 +466,64 @@ globus_l_sge_module_activate(void)
 	goto free_logfile_state_path_error;
     }
 
+    /* Watch the directory containing the reporting file and its rotated
+     * copies so that new events are read as soon as they are written.
+     */
+    log_base = strrchr(logfile_state->log_file, '/');
+    if (log_base == NULL)
+    {
+	log_dir = strdup(".");
+	log_base = logfile_state->log_file;
+    }
+    else
+    {
+	log_dir = globus_common_create_string(
+		"%.*s",
+		(log_base == logfile_state->log_file)
+		    ? 1 : (int) (log_base - logfile_state->log_file),
+		logfile_state->log_file);
+	log_base++;
+    }
+    if (log_dir == NULL)
+    {
+	goto close_logfile_error;
+    }
+    result = globus_scheduler_event_generator_tail_init(
+	    &globus_l_sge_tail,
+	    log_dir,
+	    log_base);
+    free(log_dir);
+    log_dir = NULL;
+    if (result != GLOBUS_SUCCESS)
+    {
+	goto close_logfile_error;
+    }
+
     /* Setup a callback so that our main read function will be
      * invoked at a later time.
      */
-    result = globus_callback_register_oneshot(
-	    NULL,
+    result = globus_scheduler_event_generator_tail_register(
+	    globus_l_sge_tail,
 	    &delay,
 	    globus_l_sge_read_callback,
 	    logfile_state);
     if (result != GLOBUS_SUCCESS)
     {
-	goto free_logfile_state_path_error;
+	goto destroy_tail_error;
     }
     callback_count++;
 
     return 0;
 
+destroy_tail_error:
+    globus_scheduler_event_generator_tail_destroy(globus_l_sge_tail);
+    globus_l_sge_tail = NULL;
+close_logfile_error:
+    if (logfile_state->fp != NULL)
+    {
+	fclose(logfile_state->fp);
+    }
+
 free_sge_cell:
     if (sge_cell != NULL)
     {
@@ -524,6 +570,7 @@ globus_l_sge_module_deactivate(void)
 {
     globus_mutex_lock(&globus_l_sge_mutex);
     shutdown_called = GLOBUS_TRUE;
+    globus_scheduler_event_generator_tail_wakeup(globus_l_sge_tail);
 
     while (callback_count > 0)
     {
@@ -531,6 +578,9 @@ globus_l_sge_module_deactivate(void)
     }
     globus_mutex_unlock(&globus_l_sge_mutex);
 
+    globus_scheduler_event_generator_tail_destroy(globus_l_sge_tail);
+    globus_l_sge_tail = NULL;
+
     GlobusDebugDestroy(SEG_SGE);
 
     globus_module_deactivate(GLOBUS_COMMON_MODULE);
@@ -540,7 +590,8 @@ globus_l_sge_module_deactivate(void)
 
 /*
  * This is our master read function.  It will be called periodically
- * as a result of a previous globus_callback_register_oneshot() invocation.
+ * as a result of a previous globus_scheduler_event_generator_tail_register()
+ * invocation.
  */
 static
 void
@@ -710,8 +761,8 @@ globus_l_sge_read_callback(
     /* Make the call to get ourselves invoked again. */
     /* rjp --> this used to include a pointer to the callback in the logfile_state struct.
      * as &state->callback, But this causes a memory leak. Removed and put to NULL */
-    result = globus_callback_register_oneshot(
-    	    NULL,
+    result = globus_scheduler_event_generator_tail_register(
+	    globus_l_sge_tail,
 	    &delay,
 	    globus_l_sge_read_callback,
 	    state);
@@ -17,8 +17,42 @@
 #include "globus_common.h"
 #include "globus_scheduler_event_generator.h"
 #include "globus_scheduler_event_generator_app.h"
+#include "globus_xio.h"
+#include "globus_xio_file_driver.h"
 #include "version.h"
 
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+/**
+ * Default maximum wait between log checks when change notification is
+ * available
+ */
+#define GLOBUS_L_SEG_TAIL_INTERVAL 30
+
+struct globus_scheduler_event_generator_tail_s
+{
+    globus_mutex_t                      mutex;
+    globus_cond_t                       cond;
+    /** Only changes to files whose names begin with this wake the tail */
+    char *                              prefix;
+    /** inotify descriptor, or -1 if changes are only found by polling */
+    int                                 notify_fd;
+    /** XIO handle wrapping notify_fd, used to wait for it to be readable */
+    globus_xio_handle_t                 notify_handle;
+    /** Directory watch is active, so timeouts can be extended */
+    globus_bool_t                       watching;
+    /** A change was seen while no callback was registered */
+    globus_bool_t                       changed;
+    globus_callback_handle_t            callback_handle;
+    globus_callback_func_t              callback;
+    void *                              callback_arg;
+    globus_bool_t                       callback_running;
+    globus_bool_t                       unregister_pending;
+    globus_bool_t                       destroy_called;
+};
+
 static
 int
 globus_l_seg_activate(void);
@@ -47,11 +81,17 @@ static void *                           globus_l_seg_fault_arg;
 static globus_scheduler_event_generator_event_handler_t
                                         globus_l_seg_event_handler;
 static void *                           globus_l_seg_event_arg;
+static globus_xio_driver_t              globus_l_seg_file_driver;
+static globus_xio_stack_t               globus_l_seg_file_stack;
+static globus_reltime_t                 globus_l_seg_tail_interval;
+
 static
 int
 globus_l_seg_activate(void)
 {
     int                                 rc;
+    char *                              interval;
+    int                                 interval_secs = 0;
 
     rc = globus_module_activate(GLOBUS_COMMON_MODULE);
 
@@ -59,6 +99,12 @@ globus_l_seg_activate(void)
     {
         goto error;
     }
+    rc = globus_module_activate(GLOBUS_XIO_MODULE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        globus_module_deactivate(GLOBUS_COMMON_MODULE);
+        goto error;
+    }
 
     globus_l_seg_extension = NULL;
     globus_l_seg_timestamp = 0;
@@ -66,6 +112,19 @@ globus_l_seg_activate(void)
     globus_l_seg_fault_arg = NULL;
     globus_l_seg_event_handler = NULL;
     globus_l_seg_event_arg = NULL;
+    globus_l_seg_file_driver = NULL;
+    globus_l_seg_file_stack = NULL;
+
+    interval = globus_module_getenv("GLOBUS_SEG_TAIL_INTERVAL");
+    if (interval != NULL)
+    {
+        interval_secs = atoi(interval);
+    }
+    if (interval_secs <= 0)
+    {
+        interval_secs = GLOBUS_L_SEG_TAIL_INTERVAL;
+    }
+    GlobusTimeReltimeSet(globus_l_seg_tail_interval, interval_secs, 0);
 
     globus_mutex_init(&globus_l_seg_mutex, NULL);
 error:
@@ -82,8 +141,19 @@ globus_l_seg_deactivate(void)
         globus_extension_deactivate(globus_l_seg_extension);
         globus_l_seg_extension = NULL;
     }
+    if (globus_l_seg_file_stack != NULL)
+    {
+        globus_xio_stack_destroy(globus_l_seg_file_stack);
+        globus_l_seg_file_stack = NULL;
+    }
+    if (globus_l_seg_file_driver != NULL)
+    {
+        globus_xio_driver_unload(globus_l_seg_file_driver);
+        globus_l_seg_file_driver = NULL;
+    }
 
     globus_mutex_destroy(&globus_l_seg_mutex);
+    globus_module_deactivate(GLOBUS_XIO_MODULE);
     globus_module_deactivate(GLOBUS_COMMON_MODULE);
 
     return 0;
@@ -600,3 +670,552 @@ globus_scheduler_event_destroy(
 }
 /* globus_scheduler_event_copy() */
 
+
+static
+void
+globus_l_seg_tail_callback(
+    void *                              user_arg)
+{
+    globus_scheduler_event_generator_tail_t
+                                        tail = user_arg;
+    globus_callback_func_t              callback;
+    void *                              callback_arg;
+
+    globus_mutex_lock(&tail->mutex);
+    tail->callback_handle = GLOBUS_NULL_HANDLE;
+    callback = tail->callback;
+    callback_arg = tail->callback_arg;
+    tail->callback = NULL;
+    tail->callback_arg = NULL;
+
+    if (tail->destroy_called || callback == NULL)
+    {
+        globus_mutex_unlock(&tail->mutex);
+        return;
+    }
+    tail->callback_running = GLOBUS_TRUE;
+    globus_mutex_unlock(&tail->mutex);
+
+    callback(callback_arg);
+
+    globus_mutex_lock(&tail->mutex);
+    tail->callback_running = GLOBUS_FALSE;
+    if (tail->destroy_called)
+    {
+        globus_cond_signal(&tail->cond);
+    }
+    globus_mutex_unlock(&tail->mutex);
+}
+/* globus_l_seg_tail_callback() */
+
+static
+void
+globus_l_seg_tail_unregister_callback(
+    void *                              user_arg)
+{
+    globus_scheduler_event_generator_tail_t
+                                        tail = user_arg;
+
+    globus_mutex_lock(&tail->mutex);
+    tail->unregister_pending = GLOBUS_FALSE;
+    globus_cond_signal(&tail->cond);
+    globus_mutex_unlock(&tail->mutex);
+}
+/* globus_l_seg_tail_unregister_callback() */
+
+/*
+ * Wake the registered callback now, or remember that a change happened so
+ * that the next registration runs immediately. Called with the tail mutex
+ * held.
+ */
+static
+void
+globus_l_seg_tail_changed(
+    globus_scheduler_event_generator_tail_t
+                                        tail)
+{
+    if (tail->callback_handle != GLOBUS_NULL_HANDLE)
+    {
+        globus_callback_adjust_oneshot(tail->callback_handle, NULL);
+    }
+    else
+    {
+        tail->changed = GLOBUS_TRUE;
+    }
+}
+/* globus_l_seg_tail_changed() */
+
+#ifdef HAVE_SYS_INOTIFY_H
+/*
+ * Consume all queued inotify events, returning GLOBUS_TRUE if any of them
+ * refer to a file the tail is interested in. Called with the tail mutex held.
+ */
+static
+globus_bool_t
+globus_l_seg_tail_drain(
+    globus_scheduler_event_generator_tail_t
+                                        tail)
+{
+    union
+    {
+        struct inotify_event            event;
+        char                            data[4096];
+    }                                   buffer;
+    struct inotify_event *              event;
+    ssize_t                             len;
+    size_t                              prefix_len;
+    char *                              p;
+    globus_bool_t                       changed = GLOBUS_FALSE;
+
+    prefix_len = tail->prefix ? strlen(tail->prefix) : 0;
+
+    while ((len = read(tail->notify_fd, buffer.data, sizeof(buffer))) > 0)
+    {
+        for (p = buffer.data;
+             p < buffer.data + len;
+             p += sizeof(struct inotify_event) + event->len)
+        {
+            event = (struct inotify_event *) p;
+
+            if (event->mask & IN_IGNORED)
+            {
+                /* Directory was removed or unmounted */
+                tail->watching = GLOBUS_FALSE;
+                changed = GLOBUS_TRUE;
+            }
+            else if (event->mask & IN_Q_OVERFLOW)
+            {
+                changed = GLOBUS_TRUE;
+            }
+            else if (prefix_len == 0 ||
+                     (event->len > 0 &&
+                      strncmp(event->name, tail->prefix, prefix_len) == 0))
+            {
+                changed = GLOBUS_TRUE;
+            }
+        }
+    }
+    return changed;
+}
+/* globus_l_seg_tail_drain() */
+
+static
+void
+globus_l_seg_tail_notify_callback(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    globus_scheduler_event_generator_tail_t
+                                        tail = user_arg;
+
+    if (result != GLOBUS_SUCCESS)
+    {
+        /* Handle closed by globus_scheduler_event_generator_tail_destroy() */
+        return;
+    }
+
+    globus_mutex_lock(&tail->mutex);
+    if (globus_l_seg_tail_drain(tail))
+    {
+        globus_l_seg_tail_changed(tail);
+    }
+    if (tail->notify_handle != NULL && tail->watching)
+    {
+        result = globus_xio_register_read(
+                tail->notify_handle,
+                buffer,
+                0,
+                0,
+                NULL,
+                globus_l_seg_tail_notify_callback,
+                tail);
+        if (result != GLOBUS_SUCCESS)
+        {
+            tail->watching = GLOBUS_FALSE;
+        }
+    }
+    globus_mutex_unlock(&tail->mutex);
+}
+/* globus_l_seg_tail_notify_callback() */
+
+/*
+ * Watch log_dir with inotify and wait for events in the XIO select loop.
+ * On failure, the tail is left in polling mode.
+ */
+static
+void
+globus_l_seg_tail_notify_init(
+    globus_scheduler_event_generator_tail_t
+                                        tail,
+    const char *                        log_dir)
+{
+    globus_result_t                     result;
+    globus_xio_attr_t                   attr;
+    static globus_byte_t                buffer[1];
+
+    globus_mutex_lock(&globus_l_seg_mutex);
+    if (globus_l_seg_file_stack == NULL)
+    {
+        result = globus_xio_driver_load("file", &globus_l_seg_file_driver);
+        if (result != GLOBUS_SUCCESS)
+        {
+            globus_l_seg_file_driver = NULL;
+            globus_mutex_unlock(&globus_l_seg_mutex);
+            goto driver_load_failed;
+        }
+        result = globus_xio_stack_init(&globus_l_seg_file_stack, NULL);
+        if (result != GLOBUS_SUCCESS)
+        {
+            globus_l_seg_file_stack = NULL;
+            globus_mutex_unlock(&globus_l_seg_mutex);
+            goto driver_load_failed;
+        }
+        result = globus_xio_stack_push_driver(
+                globus_l_seg_file_stack,
+                globus_l_seg_file_driver);
+        if (result != GLOBUS_SUCCESS)
+        {
+            globus_xio_stack_destroy(globus_l_seg_file_stack);
+            globus_l_seg_file_stack = NULL;
+            globus_mutex_unlock(&globus_l_seg_mutex);
+            goto driver_load_failed;
+        }
+    }
+    globus_mutex_unlock(&globus_l_seg_mutex);
+
+    tail->notify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (tail->notify_fd < 0)
+    {
+        goto inotify_init_failed;
+    }
+    if (inotify_add_watch(
+                tail->notify_fd,
+                log_dir,
+                IN_MODIFY | IN_CREATE | IN_MOVED_TO) < 0)
+    {
+        goto add_watch_failed;
+    }
+
+    result = globus_xio_attr_init(&attr);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto add_watch_failed;
+    }
+    result = globus_xio_attr_cntl(
+            attr,
+            globus_l_seg_file_driver,
+            GLOBUS_XIO_FILE_SET_HANDLE,
+            tail->notify_fd);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto attr_cntl_failed;
+    }
+    result = globus_xio_handle_create(
+            &tail->notify_handle,
+            globus_l_seg_file_stack);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto handle_create_failed;
+    }
+    result = globus_xio_open(tail->notify_handle, NULL, attr);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto open_failed;
+    }
+    tail->watching = GLOBUS_TRUE;
+
+    result = globus_xio_register_read(
+            tail->notify_handle,
+            buffer,
+            0,
+            0,
+            NULL,
+            globus_l_seg_tail_notify_callback,
+            tail);
+    if (result != GLOBUS_SUCCESS)
+    {
+        tail->watching = GLOBUS_FALSE;
+        goto register_read_failed;
+    }
+    globus_xio_attr_destroy(attr);
+
+    return;
+
+register_read_failed:
+open_failed:
+    globus_xio_close(tail->notify_handle, NULL);
+handle_create_failed:
+    tail->notify_handle = NULL;
+attr_cntl_failed:
+    globus_xio_attr_destroy(attr);
+add_watch_failed:
+    close(tail->notify_fd);
+    tail->notify_fd = -1;
+inotify_init_failed:
+driver_load_failed:
+    return;
+}
+/* globus_l_seg_tail_notify_init() */
+#endif /* HAVE_SYS_INOTIFY_H */
+
+/**
+ * @brief Create a log file change notifier
+ * @ingroup globus_scheduler_event_generator_api
+ *
+ * @details
+ * Create a handle which SEG modules use to wait for changes to the
+ * scheduler log files in @a log_dir. If the directory can not be watched,
+ * the handle falls back to waiting for the full delay passed to
+ * globus_scheduler_event_generator_tail_register().
+ *
+ * @param tail
+ *     Pointer to the new tail handle.
+ * @param log_dir
+ *     Directory containing the log files to watch.
+ * @param prefix
+ *     If non-NULL, only changes to files whose names begin with this
+ *     string cause the callback to run early.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_SEG_ERROR_NULL
+ *     Null parameter.
+ * @retval GLOBUS_SEG_ERROR_OUT_OF_MEMORY
+ *     Out of memory.
+ */
+globus_result_t
+globus_scheduler_event_generator_tail_init(
+    globus_scheduler_event_generator_tail_t *
+                                        tail,
+    const char *                        log_dir,
+    const char *                        prefix)
+{
+    globus_scheduler_event_generator_tail_t
+                                        new_tail;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+
+    if (tail == NULL || log_dir == NULL)
+    {
+        result = GLOBUS_SEG_ERROR_NULL;
+        goto null_param;
+    }
+    new_tail = calloc(1, sizeof(struct globus_scheduler_event_generator_tail_s));
+    if (new_tail == NULL)
+    {
+        result = GLOBUS_SEG_ERROR_OUT_OF_MEMORY;
+        goto calloc_failed;
+    }
+    if (prefix != NULL)
+    {
+        new_tail->prefix = strdup(prefix);
+        if (new_tail->prefix == NULL)
+        {
+            result = GLOBUS_SEG_ERROR_OUT_OF_MEMORY;
+            goto prefix_strdup_failed;
+        }
+    }
+    globus_mutex_init(&new_tail->mutex, NULL);
+    globus_cond_init(&new_tail->cond, NULL);
+    new_tail->notify_fd = -1;
+    new_tail->callback_handle = GLOBUS_NULL_HANDLE;
+
+#ifdef HAVE_SYS_INOTIFY_H
+    globus_l_seg_tail_notify_init(new_tail, log_dir);
+#endif
+
+    *tail = new_tail;
+
+    return result;
+
+prefix_strdup_failed:
+    free(new_tail);
+calloc_failed:
+    *tail = NULL;
+null_param:
+    return result;
+}
+/* globus_scheduler_event_generator_tail_init() */
+
+/**
+ * @brief Wait for a log file change
+ * @ingroup globus_scheduler_event_generator_api
+ *
+ * @details
+ * Register @a callback to be called once, when a watched log file changes
+ * or @a delay expires. If a change was noticed since the previous callback
+ * started, the callback runs immediately. Only one callback may be
+ * registered with a tail at a time.
+ *
+ * @param tail
+ *     Tail handle created by globus_scheduler_event_generator_tail_init().
+ * @param delay
+ *     Longest time to wait for a change. A zero delay runs the callback
+ *     immediately.
+ * @param callback
+ *     Function to call.
+ * @param callback_arg
+ *     Parameter to @a callback.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_SEG_ERROR_NULL
+ *     Null parameter.
+ * @retval GLOBUS_SEG_ERROR_ALREADY_SET
+ *     A callback is already registered or the tail is being destroyed.
+ */
+globus_result_t
+globus_scheduler_event_generator_tail_register(
+    globus_scheduler_event_generator_tail_t
+                                        tail,
+    const globus_reltime_t *            delay,
+    globus_callback_func_t              callback,
+    void *                              callback_arg)
+{
+    globus_reltime_t                    wait;
+    globus_result_t                     result;
+
+    if (tail == NULL || delay == NULL || callback == NULL)
+    {
+        return GLOBUS_SEG_ERROR_NULL;
+    }
+
+    globus_mutex_lock(&tail->mutex);
+    if (tail->destroy_called || tail->callback != NULL)
+    {
+        result = GLOBUS_SEG_ERROR_ALREADY_SET;
+        goto unlock_error;
+    }
+
+    if (tail->changed)
+    {
+        GlobusTimeReltimeSet(wait, 0, 0);
+        tail->changed = GLOBUS_FALSE;
+    }
+    else if (tail->watching &&
+             globus_reltime_cmp(delay, &globus_i_reltime_zero) > 0 &&
+             globus_reltime_cmp(delay, &globus_l_seg_tail_interval) < 0)
+    {
+        GlobusTimeReltimeCopy(wait, globus_l_seg_tail_interval);
+    }
+    else
+    {
+        GlobusTimeReltimeCopy(wait, *delay);
+    }
+
+    tail->callback = callback;
+    tail->callback_arg = callback_arg;
+
+    result = globus_callback_register_oneshot(
+            &tail->callback_handle,
+            &wait,
+            globus_l_seg_tail_callback,
+            tail);
+    if (result != GLOBUS_SUCCESS)
+    {
+        tail->callback_handle = GLOBUS_NULL_HANDLE;
+        tail->callback = NULL;
+        tail->callback_arg = NULL;
+    }
+
+unlock_error:
+    globus_mutex_unlock(&tail->mutex);
+
+    return result;
+}
+/* globus_scheduler_event_generator_tail_register() */
+
+/**
+ * @brief Run a registered tail callback now
+ * @ingroup globus_scheduler_event_generator_api
+ *
+ * @details
+ * Cause the callback registered with @a tail to run without waiting for
+ * a change. SEG modules call this from their deactivation function so
+ * that they do not wait for the full delay before shutting down.
+ *
+ * @param tail
+ *     Tail handle created by globus_scheduler_event_generator_tail_init().
+ */
+void
+globus_scheduler_event_generator_tail_wakeup(
+    globus_scheduler_event_generator_tail_t
+                                        tail)
+{
+    if (tail == NULL)
+    {
+        return;
+    }
+    globus_mutex_lock(&tail->mutex);
+    globus_l_seg_tail_changed(tail);
+    globus_mutex_unlock(&tail->mutex);
+}
+/* globus_scheduler_event_generator_tail_wakeup() */
+
+/**
+ * @brief Destroy a log file change notifier
+ * @ingroup globus_scheduler_event_generator_api
+ *
+ * @details
+ * Cancel any registered callback without running it, wait for a running
+ * callback to return, and free the tail. This must not be called from
+ * within the tail's callback.
+ *
+ * @param tail
+ *     Tail handle created by globus_scheduler_event_generator_tail_init().
+ */
+void
+globus_scheduler_event_generator_tail_destroy(
+    globus_scheduler_event_generator_tail_t
+                                        tail)
+{
+    globus_xio_handle_t                 handle;
+
+    if (tail == NULL)
+    {
+        return;
+    }
+
+    globus_mutex_lock(&tail->mutex);
+    tail->destroy_called = GLOBUS_TRUE;
+    if (tail->callback_handle != GLOBUS_NULL_HANDLE)
+    {
+        tail->unregister_pending = GLOBUS_TRUE;
+        globus_callback_unregister(
+                tail->callback_handle,
+                globus_l_seg_tail_unregister_callback,
+                tail,
+                NULL);
+        tail->callback_handle = GLOBUS_NULL_HANDLE;
+        tail->callback = NULL;
+        tail->callback_arg = NULL;
+    }
+    while (tail->callback_running || tail->unregister_pending)
+    {
+        globus_cond_wait(&tail->cond, &tail->mutex);
+    }
+    handle = tail->notify_handle;
+    tail->notify_handle = NULL;
+    globus_mutex_unlock(&tail->mutex);
+
+    if (handle != NULL)
+    {
+        globus_xio_close(handle, NULL);
+    }
+    if (tail->notify_fd != -1)
+    {
+        close(tail->notify_fd);
+    }
+    globus_cond_destroy(&tail->cond);
+    globus_mutex_destroy(&tail->mutex);
+    if (tail->prefix != NULL)
+    {
+        free(tail->prefix);
+    }
+    free(tail);
+}
+/* globus_scheduler_event_generator_tail_destroy() */
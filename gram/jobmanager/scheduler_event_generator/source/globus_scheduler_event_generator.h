@@ -206,6 +206,52 @@ globus_result_t
 globus_scheduler_event_generator_get_timestamp(
     time_t *                            timestamp);
 
+/**
+ * @brief Log file change notifier
+ * @ingroup globus_scheduler_event_generator_api
+ *
+ * @details
+ * A SEG module which follows a scheduler log file can use a tail handle in
+ * place of a timed oneshot to wait for more log data. The callback
+ * registered with globus_scheduler_event_generator_tail_register() is
+ * invoked as soon as a file in the watched directory is written, created, or
+ * renamed (on systems with inotify), or when the delay passed to it expires.
+ * The module reads and parses the new data from its own open stream as it
+ * does after a timed wakeup.
+ *
+ * When change notification is available, nonzero delays are extended to
+ * the number of seconds in the GLOBUS_SEG_TAIL_INTERVAL environment
+ * variable (default 30), which bounds the latency for changes made on
+ * filesystems which do not generate local notifications, such as NFS.
+ */
+typedef struct globus_scheduler_event_generator_tail_s *
+        globus_scheduler_event_generator_tail_t;
+
+globus_result_t
+globus_scheduler_event_generator_tail_init(
+    globus_scheduler_event_generator_tail_t *
+                                        tail,
+    const char *                        log_dir,
+    const char *                        prefix);
+
+globus_result_t
+globus_scheduler_event_generator_tail_register(
+    globus_scheduler_event_generator_tail_t
+                                        tail,
+    const globus_reltime_t *            delay,
+    globus_callback_func_t              callback,
+    void *                              callback_arg);
+
+void
+globus_scheduler_event_generator_tail_wakeup(
+    globus_scheduler_event_generator_tail_t
+                                        tail);
+
+void
+globus_scheduler_event_generator_tail_destroy(
+    globus_scheduler_event_generator_tail_t
+                                        tail);
+
 #ifdef __cplusplus
 }
 #endif
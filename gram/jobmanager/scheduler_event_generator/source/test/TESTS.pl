@@ -55,6 +55,6 @@ my $test_result = 1;
 $|=1;
 
 @tests = qw(
-   seg-api-test.pl seg-module-load-test  seg-timestamp-test
+   seg-api-test.pl seg-module-load-test  seg-timestamp-test seg-tail-test
 );
 $harness->runtests(@tests)
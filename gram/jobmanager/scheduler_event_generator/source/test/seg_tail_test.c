@@ -0,0 +1,302 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @page seg_tail_test SEG Tail Test
+ *
+ * Test that a SEG module using globus_scheduler_event_generator_tail_init()
+ * is woken up when its log file is appended to and when it is rotated, and
+ * that each event written to the log is delivered exactly once.
+ */
+
+#include "globus_common.h"
+#include "globus_scheduler_event_generator.h"
+#include "globus_scheduler_event_generator_app.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define JOBS 8
+
+/*
+ * The module's own delay is stretched to 30 seconds while the log
+ * directory is watched, so waiting less than that checks that the change
+ * woke it up
+ */
+#define WAIT_SECONDS 10
+
+static int                              event_counts[JOBS];
+static int                              bad_events;
+static char                             log_dir[] = "/tmp/seg-tail-testXXXXXX";
+
+static
+globus_result_t
+event_handler(
+    void *                              user_arg,
+    const globus_scheduler_event_t *    event)
+{
+    int                                 job;
+
+    if (event->event_type == GLOBUS_SCHEDULER_EVENT_DONE &&
+        sscanf(event->job_id, "job.%d", &job) == 1 &&
+        job >= 0 && job < JOBS)
+    {
+        event_counts[job]++;
+    }
+    else
+    {
+        printf("# unexpected event for %s\n", event->job_id);
+        bad_events++;
+    }
+    return GLOBUS_SUCCESS;
+}
+/* event_handler() */
+
+static
+int
+log_append(
+    const char *                        name,
+    const char *                        data)
+{
+    char *                              path;
+    FILE *                              fp;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    path = globus_common_create_string("%s/%s", log_dir, name);
+    fp = fopen(path, "a");
+    if (fp == NULL || fputs(data, fp) < 0 || fclose(fp) != 0)
+    {
+        rc = GLOBUS_FAILURE;
+    }
+    free(path);
+
+    return rc;
+}
+/* log_append() */
+
+/* Run callbacks until jobs first..last have events or the time is up */
+static
+int
+events_wait(
+    int                                 first,
+    int                                 last)
+{
+    globus_abstime_t                    timeout;
+    time_t                              deadline;
+    int                                 i;
+
+    deadline = time(NULL) + WAIT_SECONDS;
+    for (i = first; i <= last && time(NULL) < deadline; )
+    {
+        GlobusTimeAbstimeSet(timeout, 0, 100000);
+        globus_callback_poll(&timeout);
+
+        while (i <= last && event_counts[i] > 0)
+        {
+            i++;
+        }
+    }
+    if (i <= last)
+    {
+        printf("# no event for job.%d after %d seconds\n", i, WAIT_SECONDS);
+        return GLOBUS_FAILURE;
+    }
+    return GLOBUS_SUCCESS;
+}
+/* events_wait() */
+
+static
+int
+append_test(void)
+{
+    int                                 rc;
+
+    rc = log_append("log", "job.1\njob.2\n");
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = log_append("log", "job.3\n");
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = events_wait(0, 3);
+    }
+    return rc;
+}
+/* append_test() */
+
+/* A line is only an event once its newline has been written */
+static
+int
+partial_line_test(void)
+{
+    globus_abstime_t                    timeout;
+    int                                 rc;
+    int                                 i;
+
+    rc = log_append("log", "job.4\njob.");
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = events_wait(4, 4);
+    }
+    for (i = 0; rc == GLOBUS_SUCCESS && i < 10; i++)
+    {
+        GlobusTimeAbstimeSet(timeout, 0, 100000);
+        globus_callback_poll(&timeout);
+    }
+    if (rc == GLOBUS_SUCCESS && bad_events != 0)
+    {
+        rc = GLOBUS_FAILURE;
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = log_append("log", "5\n");
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = events_wait(5, 5);
+    }
+    return rc;
+}
+/* partial_line_test() */
+
+/*
+ * The last line of the old log is written just before the rotation, so
+ * the module must finish the old file before moving to the new one
+ */
+static
+int
+rotate_test(void)
+{
+    char *                              old_path;
+    char *                              new_path;
+    int                                 rc;
+
+    old_path = globus_common_create_string("%s/log", log_dir);
+    new_path = globus_common_create_string("%s/log.1", log_dir);
+
+    rc = log_append("log", "job.6\n");
+    if (rc == GLOBUS_SUCCESS && rename(old_path, new_path) != 0)
+    {
+        rc = GLOBUS_FAILURE;
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = log_append("log", "job.7\n");
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = events_wait(6, 7);
+    }
+    free(new_path);
+    free(old_path);
+
+    return rc;
+}
+/* rotate_test() */
+
+static
+int
+exactly_once_test(void)
+{
+    globus_abstime_t                    timeout;
+    time_t                              deadline;
+    int                                 rc = GLOBUS_SUCCESS;
+    int                                 i;
+
+    /* give duplicates time to show up */
+    deadline = time(NULL) + 3;
+    while (time(NULL) < deadline)
+    {
+        GlobusTimeAbstimeSet(timeout, 0, 100000);
+        globus_callback_poll(&timeout);
+    }
+
+    for (i = 1; i < JOBS; i++)
+    {
+        if (event_counts[i] != 1)
+        {
+            printf("# job.%d had %d events\n", i, event_counts[i]);
+            rc = GLOBUS_FAILURE;
+        }
+    }
+    if (bad_events != 0)
+    {
+        rc = GLOBUS_FAILURE;
+    }
+    return rc;
+}
+/* exactly_once_test() */
+
+int main(int argc, char *argv[])
+{
+    int                                 rc;
+    int                                 fail_count = 0;
+    globus_result_t                     result;
+    char *                              command;
+
+    printf("1..4\n");
+
+    if (mkdtemp(log_dir) == NULL)
+    {
+        printf("Bail out! mkdtemp failed\n");
+        return 1;
+    }
+    globus_libc_setenv("TEST_MODULE_LOG_DIR", log_dir, GLOBUS_TRUE);
+
+    /* job.0 is a placeholder so the waits can start from 0 */
+    event_counts[0] = 1;
+
+    rc = globus_module_activate(GLOBUS_SCHEDULER_EVENT_GENERATOR_MODULE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! activate failed\n");
+        return 1;
+    }
+    globus_scheduler_event_generator_set_event_handler(event_handler, NULL);
+
+    result = globus_scheduler_event_generator_load_module("tail_test_module");
+    if (result != GLOBUS_SUCCESS)
+    {
+        printf("Bail out! load_module failed: %s\n",
+                globus_object_printable_to_string(globus_error_peek(result)));
+        return 1;
+    }
+
+    rc = append_test();
+    printf("%s - append_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+    rc = partial_line_test();
+    printf("%s - partial_line_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+    rc = rotate_test();
+    printf("%s - rotate_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+    rc = exactly_once_test();
+    printf("%s - exactly_once_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+    globus_module_deactivate_all();
+
+    command = globus_common_create_string("rm -rf %s", log_dir);
+    system(command);
+    free(command);
+
+    return fail_count;
+}
+/* main() */
@@ -0,0 +1,258 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * SEG module for the tail test. Follows the file "log" in the directory
+ * named by TEST_MODULE_LOG_DIR like tail -F, and generates a done event
+ * for each complete line, using the line as the job id. When the log is
+ * renamed and a new one created, the rest of the old file is read before
+ * switching to the new one.
+ */
+#include "globus_common.h"
+#include "globus_scheduler_event_generator.h"
+
+#include <sys/stat.h>
+
+typedef struct
+{
+    char *                              path;
+    FILE *                              fp;
+    ino_t                               ino;
+}
+globus_l_test_module_state_t;
+
+static
+int
+globus_l_test_module_activate(void);
+
+static
+int
+globus_l_test_module_deactivate(void);
+
+static
+void
+globus_l_test_module_callback(
+    void *                              user_arg);
+
+static globus_mutex_t                   globus_l_test_module_mutex;
+static globus_cond_t                    globus_l_test_module_cond;
+static globus_bool_t                    shutdown_called;
+static int                              callback_count;
+static globus_scheduler_event_generator_tail_t
+                                        globus_l_test_module_tail;
+static globus_l_test_module_state_t     globus_l_test_module_state;
+
+GlobusExtensionDefineModule(globus_seg_tail_test_module) =
+{
+    "globus_seg_tail_test_module",
+    globus_l_test_module_activate,
+    globus_l_test_module_deactivate,
+    NULL,
+    NULL,
+    NULL,
+    NULL
+};
+
+/* Generate events for the complete lines after the current position */
+static
+void
+globus_l_test_module_read(
+    FILE *                              fp)
+{
+    char                                line[256];
+    size_t                              len;
+    long                                pos;
+
+    for (pos = ftell(fp); fgets(line, sizeof(line), fp) != NULL; pos = ftell(fp))
+    {
+        len = strlen(line);
+        if (line[len-1] != '\n')
+        {
+            /* partial line, read it again once it is complete */
+            fseek(fp, pos, SEEK_SET);
+            break;
+        }
+        line[len-1] = '\0';
+        globus_scheduler_event_done(time(NULL), line, 0);
+    }
+    clearerr(fp);
+}
+/* globus_l_test_module_read() */
+
+static
+void
+globus_l_test_module_open(
+    globus_l_test_module_state_t *      state)
+{
+    struct stat                         st;
+
+    state->fp = fopen(state->path, "r");
+    if (state->fp != NULL && fstat(fileno(state->fp), &st) == 0)
+    {
+        state->ino = st.st_ino;
+    }
+}
+/* globus_l_test_module_open() */
+
+int
+globus_l_test_module_activate(void)
+{
+    globus_reltime_t                    delay;
+    globus_result_t                     result;
+    char *                              log_dir;
+
+    log_dir = getenv("TEST_MODULE_LOG_DIR");
+    if (log_dir == NULL)
+    {
+        printf("not ok - no TEST_MODULE_LOG_DIR environment\n");
+        return 1;
+    }
+
+    globus_module_activate(GLOBUS_COMMON_MODULE);
+    globus_mutex_init(&globus_l_test_module_mutex, NULL);
+    globus_cond_init(&globus_l_test_module_cond, NULL);
+    shutdown_called = GLOBUS_FALSE;
+    callback_count = 0;
+
+    globus_l_test_module_state.path = globus_common_create_string(
+            "%s/log", log_dir);
+    globus_l_test_module_state.fp = NULL;
+
+    result = globus_scheduler_event_generator_tail_init(
+            &globus_l_test_module_tail,
+            log_dir,
+            "log");
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto tail_init_failed;
+    }
+
+    GlobusTimeReltimeSet(delay, 0, 0);
+    result = globus_scheduler_event_generator_tail_register(
+            globus_l_test_module_tail,
+            &delay,
+            globus_l_test_module_callback,
+            &globus_l_test_module_state);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto register_failed;
+    }
+    callback_count++;
+
+    return 0;
+
+register_failed:
+    globus_scheduler_event_generator_tail_destroy(globus_l_test_module_tail);
+    globus_l_test_module_tail = NULL;
+tail_init_failed:
+    free(globus_l_test_module_state.path);
+    globus_cond_destroy(&globus_l_test_module_cond);
+    globus_mutex_destroy(&globus_l_test_module_mutex);
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+    return 1;
+}
+/* globus_l_test_module_activate() */
+
+int
+globus_l_test_module_deactivate(void)
+{
+    globus_mutex_lock(&globus_l_test_module_mutex);
+    shutdown_called = GLOBUS_TRUE;
+    globus_scheduler_event_generator_tail_wakeup(globus_l_test_module_tail);
+
+    while (callback_count > 0)
+    {
+        globus_cond_wait(
+                &globus_l_test_module_cond,
+                &globus_l_test_module_mutex);
+    }
+    globus_mutex_unlock(&globus_l_test_module_mutex);
+
+    globus_scheduler_event_generator_tail_destroy(globus_l_test_module_tail);
+    globus_l_test_module_tail = NULL;
+
+    if (globus_l_test_module_state.fp != NULL)
+    {
+        fclose(globus_l_test_module_state.fp);
+    }
+    free(globus_l_test_module_state.path);
+    globus_cond_destroy(&globus_l_test_module_cond);
+    globus_mutex_destroy(&globus_l_test_module_mutex);
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return 0;
+}
+/* globus_l_test_module_deactivate() */
+
+/*
+ * Called when the log directory changes, or after the delay. The delay
+ * passed in is short, but the tail stretches it while it can watch the
+ * directory, so the test only sees events in time if changes wake it up.
+ */
+static
+void
+globus_l_test_module_callback(
+    void *                              user_arg)
+{
+    globus_l_test_module_state_t *      state = user_arg;
+    globus_reltime_t                    delay;
+    globus_result_t                     result;
+    struct stat                         st;
+
+    globus_mutex_lock(&globus_l_test_module_mutex);
+    if (shutdown_called)
+    {
+        goto done;
+    }
+    globus_mutex_unlock(&globus_l_test_module_mutex);
+
+    if (state->fp == NULL)
+    {
+        globus_l_test_module_open(state);
+    }
+    if (state->fp != NULL)
+    {
+        globus_l_test_module_read(state->fp);
+
+        if (stat(state->path, &st) == 0 && st.st_ino != state->ino)
+        {
+            /* rotated: the old file was read to its end above */
+            fclose(state->fp);
+            globus_l_test_module_open(state);
+            if (state->fp != NULL)
+            {
+                globus_l_test_module_read(state->fp);
+            }
+        }
+    }
+
+    GlobusTimeReltimeSet(delay, 1, 0);
+    result = globus_scheduler_event_generator_tail_register(
+            globus_l_test_module_tail,
+            &delay,
+            globus_l_test_module_callback,
+            state);
+    if (result == GLOBUS_SUCCESS)
+    {
+        return;
+    }
+    globus_mutex_lock(&globus_l_test_module_mutex);
+done:
+    callback_count--;
+    globus_cond_signal(&globus_l_test_module_cond);
+    globus_mutex_unlock(&globus_l_test_module_mutex);
+}
+/* globus_l_test_module_callback() */
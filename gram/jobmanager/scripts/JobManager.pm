@@ -40,6 +40,7 @@ Globus::GRAM::JobManager - Base class for all Job Manager scripts
  $manager->respond($hashref);
  $hashref = $manager->submit();
  $hashref = $manager->poll();
+ $hashref = $manager->poll_all();
  $hashref = $manager->cancel();
  $hashref = $manager->signal();
  $hashref = $manager->make_scratchdir();
@@ -277,6 +278,32 @@ sub poll
     return Globus::GRAM::Error::UNIMPLEMENTED;
 }
 
+=item $manager->poll_all()
+
+Poll the status of several jobs at once. The default implementation returns
+with the Globus::GRAM::Error::UNIMPLEMENTED error, and the job manager then
+polls each job with the I<poll> method. Scheduler specific subclasses may
+reimplement this method to query the scheduler once for all of the jobs.
+
+The job IDs to poll can be accessed by calling the
+$self->{JobDescription}->polljobids() method in list context. For each job
+whose state is known, a scheduler which implements this method should send
+an intermediate response containing the POLL_JOB_STATE value by calling
+the I<respond>() method, and then return an empty hash reference. Jobs
+without a POLL_JOB_STATE response are polled individually with the
+I<poll> method, so an implementation may leave out jobs which need the full
+I<poll> processing, such as completed jobs.
+
+=cut
+
+sub poll_all
+{
+    my $self = shift;
+
+    $self->log("Job Manager module Script does not implement 'poll_all'\n");
+    return Globus::GRAM::Error::UNIMPLEMENTED;
+}
+
 =item $manager->cancel()
 
 Cancel a job. The default implementation returns
@@ -1326,6 +1353,11 @@ response via the I<response>() method, the following hash keys are valid:
 An integer job state value. These are enumerated in the Globus::GRAM::JobState
 module.
 
+=item * POLL_JOB_STATE
+
+A string containing a job identifier and an integer job state value separated
+by a colon. This response should only be returned by the I<poll_all> method.
+
 =item * ERROR
 
 An integer error code. These are enumerated in the Globus::GRAM::Error module.
@@ -106,6 +106,22 @@ globus_l_gram_job_manager_request_load_all_from_dir(
     globus_gram_job_manager_t *         manager,
     const char *                        state_file_dir,
     const char *                        state_file_pattern);
+
+static
+int
+globus_l_gram_job_manager_request_load_all_from_journal(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file_dir,
+    const char *                        state_file_pattern);
+
+static
+int
+globus_l_gram_job_manager_request_reload(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file_dir,
+    uint64_t                            uniq1,
+    uint64_t                            uniq2,
+    char *                              key);
 #endif /* GLOBUS_DONT_DOCUMENT_INTERNAL */
 
 /**
@@ -152,6 +168,10 @@ globus_gram_job_manager_init(
     manager->expiration_handle = GLOBUS_NULL_HANDLE;
     manager->lockcheck_handle = GLOBUS_NULL_HANDLE;
     manager->idle_script_handle = GLOBUS_NULL_HANDLE;
+    manager->poll_all_waiters = NULL;
+    manager->poll_all_timer = GLOBUS_NULL_HANDLE;
+    manager->poll_all_running = GLOBUS_FALSE;
+    manager->poll_all_unsupported = GLOBUS_FALSE;
 
     rc = globus_mutex_init(&manager->mutex, NULL);
     if (rc != GLOBUS_SUCCESS)
@@ -281,7 +301,12 @@ globus_gram_job_manager_init(
     }
 
     manager->active_job_manager_handle = NULL;
+    manager->fork_callback_handle = GLOBUS_NULL_HANDLE;
+    manager->fork_event_fd = -1;
+    manager->fork_event_handle = NULL;
+    manager->condor_tail = NULL;
     manager->lock_fd = -1;
+    manager->state_journal = NULL;
     manager->lock_path = globus_common_create_string(
             "%s/%s.%s.lock",
             dir_prefix,
@@ -440,6 +465,7 @@ globus_gram_job_manager_destroy(
         return;
     }
     globus_gram_job_manager_shutdown_seg(manager);
+    globus_gram_job_manager_state_journal_close(manager);
 
     globus_gram_protocol_callback_disallow(manager->url_base);
     free(manager->url_base);
@@ -1463,6 +1489,7 @@ globus_gram_job_manager_register_job_id(
 
             goto hash_insert_failed;
         }
+        (void) globus_gram_job_manager_seg_fork_watch(manager, ref->job_id);
     }
 
     globus_gram_job_manager_log(
@@ -1534,6 +1561,7 @@ globus_gram_job_manager_unregister_job_id(
         rc = GLOBUS_GRAM_PROTOCOL_ERROR_JOB_CONTACT_NOT_FOUND;
         goto no_such_job;
     }
+    globus_gram_job_manager_seg_fork_unwatch(manager, job_id);
     free(ref->job_contact_path);
     free(ref->job_id);
     free(ref);
@@ -2281,10 +2309,26 @@ globus_gram_job_manager_request_load_all(
             goto hashed_job_dir_alloc_failed;
         }
 
+        /* Jobs in the per-user directory may have their state in the
+         * state journal instead of their own state files. Opening the
+         * journal removes state files it has replaced, so each job is only
+         * found in one of them.
+         */
+        if (manager->state_journal == NULL)
+        {
+            globus_gram_job_manager_state_journal_open(
+                    manager,
+                    hashed_job_dir);
+        }
+
         globus_l_gram_job_manager_request_load_all_from_dir(
                 manager,
                 hashed_job_dir,
                 state_file_pattern);
+        globus_l_gram_job_manager_request_load_all_from_journal(
+                manager,
+                hashed_job_dir,
+                state_file_pattern);
         free(hashed_job_dir);
     }
 
@@ -2324,8 +2368,6 @@ globus_l_gram_job_manager_request_load_all_from_dir(
     int                                 lock;
     struct dirent *                     entry;
     uint64_t                            uniq1, uniq2;
-    globus_gram_jobmanager_request_t *  request;
-    globus_gram_job_manager_ref_t *     ref;
     struct stat                         st;
     char *                              full_path;
     uid_t                               uid = getuid();
@@ -2486,188 +2528,320 @@ globus_l_gram_job_manager_request_load_all_from_dir(
                 entry = NULL;
                 continue;
             }
-            rc = globus_l_gram_restart_job(
+            free(entry);
+            entry = NULL;
+
+            globus_l_gram_job_manager_request_reload(
                     manager,
-                    &request,
-                    key+1);
+                    state_file_dir,
+                    uniq1,
+                    uniq2,
+                    key);
+        }
+        else
+        {
             free(entry);
+        }
+    }
+    rc = 0;
+    globus_libc_closedir(dir);
 
-            if (rc != GLOBUS_SUCCESS)
-            {
-                if (rc != GLOBUS_GRAM_PROTOCOL_ERROR_OLD_JM_ALIVE)
-                {
-                    globus_gram_job_manager_log(
-                            manager,
-                            GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
-                            "event=gram.reload_requests.info "
-                            "level=WARN "
-                            "statedir=\"%s\" "
-                            "msg=\"%s\" "
-                            "gramid=/%"PRIu64"/%"PRIu64"/ "
-                            "status=%d "
-                            "reason=\"%s\"\n",
-                            state_file_dir,
-                            "Error restarting job",
-                            uniq1,
-                            uniq2,
-                            -rc,
-                            globus_gram_protocol_error_string(rc));
-                }
+opendir_failed:
+    return rc;
+}
+/* globus_l_gram_job_manager_request_load_all_from_dir() */
 
-                free(key);
-                continue;
-            }
+static
+int
+globus_l_gram_job_manager_request_load_all_from_journal(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file_dir,
+    const char *                        state_file_pattern)
+{
+    int                                 rc;
+    globus_list_t *                     state_files;
+    char *                              state_file;
+    char *                              key;
+    uint64_t                            uniq1, uniq2;
+    int                                 end;
 
-            /* Set the SEG timestamp to be the earliest value in any of the
-             * jobs we will manage.
-             */
-            if (manager->seg_last_timestamp == 0 ||
-                manager->seg_last_timestamp > request->seg_last_timestamp)
-            {
-                manager->seg_last_timestamp = request->seg_last_timestamp;
-            }
+    rc = globus_gram_job_manager_state_journal_list(manager, &state_files);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.reload_requests.info "
+                "level=ERROR "
+                "statedir=\"%s\" "
+                "msg=\"%s\" "
+                "status=%d "
+                "reason=\"%s\"\n",
+                state_file_dir,
+                "Error listing state journal",
+                -rc,
+                globus_gram_protocol_error_string(rc));
+        return rc;
+    }
 
-            /* Optimize the (hopefully) common case. The job is pending
-             * or active in the queue and we will want to wait for
-             * job state changes. In this case, we add the reference to
-             * the job's LRM job id 
-             */
-            if ((request->config->seg_module != NULL ||
-                 strcmp(request->config->jobmanager_type, "fork") == 0 ||
-                 strcmp(request->config->jobmanager_type, "condor") == 0) &&
-                (request->restart_state ==
-                        GLOBUS_GRAM_JOB_MANAGER_STATE_POLL1 ||
-                 request->restart_state ==
-                        GLOBUS_GRAM_JOB_MANAGER_STATE_POLL2 ||
-                 request->restart_state ==
-                        GLOBUS_GRAM_JOB_MANAGER_STATE_POLL_QUERY1 ||
-                 request->restart_state ==
-                        GLOBUS_GRAM_JOB_MANAGER_STATE_POLL_QUERY2))
-            {
-                rc = globus_gram_job_manager_register_job_id(
-                        request->manager,
-                        request->job_id_string,
-                        request,
-                        GLOBUS_TRUE);
-                if (rc != GLOBUS_SUCCESS)
-                {
-                    globus_gram_job_manager_request_log(
-                            request,
-                            GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
-                            "event=gram.reload_requests.info "
-                            "level=WARN "
-                            "statedir=\"%s\" "
-                            "msg=\"%s\" "
-                            "gramid=/%"PRIu64"/%"PRIu64"/ "
-                            "status=%d "
-                            "reason=\"%s\" "
-                            "\n",
-                            state_file_dir,
-                            "Error registering job id",
-                            uniq1,
-                            uniq2,
-                            -rc,
-                            globus_gram_protocol_error_string(rc));
-                }
-                request->jobmanager_state = GLOBUS_GRAM_JOB_MANAGER_STATE_POLL2;
-            }
-            /* Add a stub in the job manager's request_hash for this job. The
-             * Reference count will be left at 0, and we will null out the
-             * ref->request pointer below. This allows queries, SEG events, and 
-             * the restart code to look up the job ID without the entire
-             * request remaining in memory.
-             */
-            rc = globus_l_gram_job_manager_add_ref_stub(
-                    request->manager,
-                    request->job_contact_path,
-                    request,
-                    &ref);
-            if (rc != GLOBUS_SUCCESS)
-            {
-                globus_gram_job_manager_request_log(
-                        request,
-                        GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
-                        "event=gram.reload_requests.info "
-                        "level=WARN "
-                        "statedir=\"%s\" "
-                        "msg=\"%s\" "
-                        "gramid=%"PRIu64"/%"PRIu64" "
-                        "status=%d "
-                        "reason=\"%s\" "
-                        "\n",
-                        state_file_dir,
-                        "Error registering job id",
-                        uniq1,
-                        uniq2,
-                        -rc,
-                        globus_gram_protocol_error_string(rc));
-            }
-            if (ref != NULL)
-            {
-                /* We don't want to keep this reference active. We want it
-                 * to look like the job was swapped out
-                 */
-                ref->request = NULL;
-            }
-            if (request &&
-                request->jobmanager_state !=
-                        GLOBUS_GRAM_JOB_MANAGER_STATE_POLL2)
-            {
-                rc = globus_list_insert(
-                        &manager->pending_restarts,
-                        key);
-                key = NULL;
-            }
-            /* Indicate that it will need some special handling when its
-             * first reference is added
-             */
-            ref->loaded_only = GLOBUS_TRUE;
+    while (!globus_list_empty(state_files))
+    {
+        state_file = globus_list_remove(&state_files, state_files);
 
-            if (request)
-            {
-                globus_gram_job_manager_request_free(request);
-                free(request);
-                request = NULL;
-            }
-            if (rc != GLOBUS_SUCCESS)
+        if ((sscanf(state_file,
+                    state_file_pattern,
+                    &uniq1,
+                    &uniq2,
+                    &end) == 2)
+            && (strlen(state_file + end) == 0))
+        {
+            key = globus_common_create_string(
+                    "/%"PRIu64"/%"PRIu64"/",
+                    uniq1,
+                    uniq2);
+            if (key == NULL)
             {
-                rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
-
                 globus_gram_job_manager_log(
                         manager,
                         GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
                         "event=gram.reload_requests.info "
                         "level=WARN "
                         "statedir=\"%s\" "
+                        "file=\"%s\" "
                         "msg=\"%s\" "
-                        "gramid=%"PRIu64"/%"PRIu64" "
+                        "gramid=/%"PRIu64"/%"PRIu64"/ "
                         "errno=%d "
                         "reason=\"%s\"\n",
                         state_file_dir,
-                        "Error inserting job into request list",
+                        state_file,
+                        "Error constructing key, ignoring journaled job",
                         uniq1,
                         uniq2,
-                        globus_gram_protocol_error_string(rc));
-
+                        errno,
+                        strerror(errno));
             }
-            if (key)
+            else if (globus_hashtable_lookup(&manager->request_hash, key)
+                        != NULL)
             {
+                /* Already loaded from a state file */
                 free(key);
-                key = NULL;
+            }
+            else
+            {
+                globus_l_gram_job_manager_request_reload(
+                        manager,
+                        state_file_dir,
+                        uniq1,
+                        uniq2,
+                        key);
             }
         }
-        else
+        free(state_file);
+    }
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_l_gram_job_manager_request_load_all_from_journal() */
+
+/**
+ * Reload a job found in the job state directory or state journal
+ *
+ * @param manager
+ *     Job Manager
+ * @param state_file_dir
+ *     Directory containing the job's state, used for logging.
+ * @param uniq1
+ *     First part of the job's unique id.
+ * @param uniq2
+ *     Second part of the job's unique id.
+ * @param key
+ *     Job contact path of the job. This function takes ownership of it.
+ */
+static
+int
+globus_l_gram_job_manager_request_reload(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file_dir,
+    uint64_t                            uniq1,
+    uint64_t                            uniq2,
+    char *                              key)
+{
+    int                                 rc;
+    globus_gram_jobmanager_request_t *  request;
+    globus_gram_job_manager_ref_t *     ref;
+
+    rc = globus_l_gram_restart_job(
+            manager,
+            &request,
+            key+1);
+
+    if (rc != GLOBUS_SUCCESS)
+    {
+        if (rc != GLOBUS_GRAM_PROTOCOL_ERROR_OLD_JM_ALIVE)
         {
-            free(entry);
+            globus_gram_job_manager_log(
+                    manager,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+                    "event=gram.reload_requests.info "
+                    "level=WARN "
+                    "statedir=\"%s\" "
+                    "msg=\"%s\" "
+                    "gramid=/%"PRIu64"/%"PRIu64"/ "
+                    "status=%d "
+                    "reason=\"%s\"\n",
+                    state_file_dir,
+                    "Error restarting job",
+                    uniq1,
+                    uniq2,
+                    -rc,
+                    globus_gram_protocol_error_string(rc));
         }
+
+        free(key);
+        return rc;
+    }
+
+    /* Set the SEG timestamp to be the earliest value in any of the
+     * jobs we will manage.
+     */
+    if (manager->seg_last_timestamp == 0 ||
+        manager->seg_last_timestamp > request->seg_last_timestamp)
+    {
+        manager->seg_last_timestamp = request->seg_last_timestamp;
+    }
+
+    /* Optimize the (hopefully) common case. The job is pending
+     * or active in the queue and we will want to wait for
+     * job state changes. In this case, we add the reference to
+     * the job's LRM job id 
+     */
+    if ((request->config->seg_module != NULL ||
+         strcmp(request->config->jobmanager_type, "fork") == 0 ||
+         strcmp(request->config->jobmanager_type, "condor") == 0) &&
+        (request->restart_state ==
+                GLOBUS_GRAM_JOB_MANAGER_STATE_POLL1 ||
+         request->restart_state ==
+                GLOBUS_GRAM_JOB_MANAGER_STATE_POLL2 ||
+         request->restart_state ==
+                GLOBUS_GRAM_JOB_MANAGER_STATE_POLL_QUERY1 ||
+         request->restart_state ==
+                GLOBUS_GRAM_JOB_MANAGER_STATE_POLL_QUERY2))
+    {
+        rc = globus_gram_job_manager_register_job_id(
+                request->manager,
+                request->job_id_string,
+                request,
+                GLOBUS_TRUE);
+        if (rc != GLOBUS_SUCCESS)
+        {
+            globus_gram_job_manager_request_log(
+                    request,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+                    "event=gram.reload_requests.info "
+                    "level=WARN "
+                    "statedir=\"%s\" "
+                    "msg=\"%s\" "
+                    "gramid=/%"PRIu64"/%"PRIu64"/ "
+                    "status=%d "
+                    "reason=\"%s\" "
+                    "\n",
+                    state_file_dir,
+                    "Error registering job id",
+                    uniq1,
+                    uniq2,
+                    -rc,
+                    globus_gram_protocol_error_string(rc));
+        }
+        request->jobmanager_state = GLOBUS_GRAM_JOB_MANAGER_STATE_POLL2;
+    }
+    /* Add a stub in the job manager's request_hash for this job. The
+     * Reference count will be left at 0, and we will null out the
+     * ref->request pointer below. This allows queries, SEG events, and 
+     * the restart code to look up the job ID without the entire
+     * request remaining in memory.
+     */
+    rc = globus_l_gram_job_manager_add_ref_stub(
+            request->manager,
+            request->job_contact_path,
+            request,
+            &ref);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        globus_gram_job_manager_request_log(
+                request,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+                "event=gram.reload_requests.info "
+                "level=WARN "
+                "statedir=\"%s\" "
+                "msg=\"%s\" "
+                "gramid=%"PRIu64"/%"PRIu64" "
+                "status=%d "
+                "reason=\"%s\" "
+                "\n",
+                state_file_dir,
+                "Error registering job id",
+                uniq1,
+                uniq2,
+                -rc,
+                globus_gram_protocol_error_string(rc));
+    }
+    if (ref != NULL)
+    {
+        /* We don't want to keep this reference active. We want it
+         * to look like the job was swapped out
+         */
+        ref->request = NULL;
+    }
+    if (request &&
+        request->jobmanager_state !=
+                GLOBUS_GRAM_JOB_MANAGER_STATE_POLL2)
+    {
+        rc = globus_list_insert(
+                &manager->pending_restarts,
+                key);
+        key = NULL;
+    }
+    /* Indicate that it will need some special handling when its
+     * first reference is added
+     */
+    ref->loaded_only = GLOBUS_TRUE;
+
+    if (request)
+    {
+        globus_gram_job_manager_request_free(request);
+        free(request);
+        request = NULL;
+    }
+    if (rc != GLOBUS_SUCCESS)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+                "event=gram.reload_requests.info "
+                "level=WARN "
+                "statedir=\"%s\" "
+                "msg=\"%s\" "
+                "gramid=%"PRIu64"/%"PRIu64" "
+                "errno=%d "
+                "reason=\"%s\"\n",
+                state_file_dir,
+                "Error inserting job into request list",
+                uniq1,
+                uniq2,
+                globus_gram_protocol_error_string(rc));
+
+    }
+    if (key)
+    {
+        free(key);
+        key = NULL;
     }
-    rc = 0;
-    globus_libc_closedir(dir);
 
-opendir_failed:
     return rc;
 }
-/* globus_l_gram_job_manager_request_load_all_from_dir() */
+/* globus_l_gram_job_manager_request_reload() */
 
 int
 globus_i_gram_mkdir(
@@ -25,6 +25,7 @@
 #include "globus_rsl.h"
 #include "globus_gass_cache.h"
 #include "globus_gsi_credential.h"
+#include "globus_scheduler_event_generator.h"
 
 /* Defines */
 
@@ -355,6 +356,11 @@ typedef struct
      * on GRAM operations or not. Default to no.
      */
     globus_bool_t                       enable_callout;
+    /**
+     * Boolean flag indicating whether to rewrite per-job state files
+     * instead of appending to the state journal. Default to no.
+     */
+    globus_bool_t                       state_journal_disabled;
 }
 globus_gram_job_manager_config_t;
 
@@ -424,6 +430,14 @@ globus_gram_job_manager_scripts_t;
  * computed from the configuration state above and may change during the
  * lifetime of the job manager.
  */
+/**
+ * Append-only log of the job state file contents for the jobs in a job
+ * manager's per-user state directory. Its contents are private to
+ * globus_gram_job_manager_state_file.c
+ */
+typedef struct globus_gram_job_manager_state_journal_s
+    globus_gram_job_manager_state_journal_t;
+
 typedef struct globus_gram_job_manager_s
 {
     /** Link to the static job manager configuration */
@@ -442,6 +456,23 @@ typedef struct globus_gram_job_manager_s
      * Callback handle for fork SEG-like polling
      */
     globus_callback_handle_t            fork_callback_handle;
+    /**
+     * epoll descriptor watching the pidfds of fork jobs, or -1 if fork jobs
+     * are polled with fork_callback_handle instead
+     */
+    int                                 fork_event_fd;
+    /** XIO Handle for fork_event_fd so we can use XIO's select loop */
+    globus_xio_handle_t                 fork_event_handle;
+    /** Hashtable mapping fork job id -> process watch state */
+    globus_hashtable_t                  fork_watch_hash;
+    /** Done events for fork jobs which exited before they could be watched */
+    globus_fifo_t                       fork_done_events;
+    /**
+     * Change notifier for the condor log files in job_state_file_dir, or
+     * NULL if condor logs are polled with fork_callback_handle instead
+     */
+    globus_scheduler_event_generator_tail_t
+                                        condor_tail;
     /** LRM-specific set of validation records */
     globus_list_t *                     validation_records;
     /** Newest validation file timestamp */
@@ -471,6 +502,12 @@ typedef struct globus_gram_job_manager_s
     globus_xio_handle_t                 active_job_manager_handle;
     /** Lock file related to the socket_fd */
     int                                 lock_fd;
+    /**
+     * State journal for jobs in the per-user state directory, or NULL if
+     * state files are rewritten in place
+     */
+    globus_gram_job_manager_state_journal_t *
+                                        state_journal;
     /** Socket file path */
     char *                              socket_path;
     /** Lock file path */
@@ -525,6 +562,22 @@ typedef struct globus_gram_job_manager_s
      * Periodic callback handle to clse idle perl script xio handles
      */
     globus_callback_handle_t            idle_script_handle;
+
+    /**
+     * Jobs waiting to be polled by the next poll_all script command
+     */
+    globus_list_t *                     poll_all_waiters;
+    /**
+     * Oneshot callback handle to run the next poll_all script command
+     */
+    globus_callback_handle_t            poll_all_timer;
+    /** Set to GLOBUS_TRUE while a poll_all script command is running */
+    globus_bool_t                       poll_all_running;
+    /**
+     * Set to GLOBUS_TRUE when the LRM module doesn't implement poll_all, so
+     * that jobs are polled individually
+     */
+    globus_bool_t                       poll_all_unsupported;
 }
 globus_gram_job_manager_t;
 
@@ -1334,10 +1387,28 @@ int
 globus_gram_job_manager_state_file_write(
     globus_gram_jobmanager_request_t *  request);
 
+int
+globus_gram_job_manager_state_file_remove(
+    globus_gram_jobmanager_request_t *  request);
+
 int
 globus_gram_job_manager_state_file_register_update(
     globus_gram_jobmanager_request_t *  request);
 
+int
+globus_gram_job_manager_state_journal_open(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file_dir);
+
+void
+globus_gram_job_manager_state_journal_close(
+    globus_gram_job_manager_t *         manager);
+
+int
+globus_gram_job_manager_state_journal_list(
+    globus_gram_job_manager_t *         manager,
+    globus_list_t **                    state_files);
+
 /* globus_gram_job_manager_script.c */
 int 
 globus_gram_job_manager_script_stage_in(
@@ -1402,6 +1473,16 @@ globus_gram_job_manager_seg_parse_condor_id(
     globus_gram_jobmanager_request_t *  request,
     char **                             condor_id);
 
+int
+globus_gram_job_manager_seg_fork_watch(
+    globus_gram_job_manager_t *         manager,
+    const char *                        job_id);
+
+void
+globus_gram_job_manager_seg_fork_unwatch(
+    globus_gram_job_manager_t *         manager,
+    const char *                        job_id);
+
 /* globus_gram_job_manager_auditing.c */
 int
 globus_gram_job_manager_auditing_file_write(
@@ -381,6 +381,10 @@ globus_gram_job_manager_config_init(
             }
             config->usage_targets = strdup(argv[++i]);
         }
+        else if (strcmp(argv[i], "-disable-state-journal") == 0)
+        {
+            config->state_journal_disabled = GLOBUS_TRUE;
+        }
         else if (strcmp(argv[i], "-enable-callout") == 0)
         {
             config->enable_callout = GLOBUS_TRUE;
@@ -412,6 +416,7 @@ globus_gram_job_manager_config_init(
                     "\t-stdio-log DIRECTORY\n"
                     "\t-log-levels TRACE|INFO|DEBUG|WARN|ERROR|FATAL\n"
                     "\t-state-file-dir state-directory\n"
+                    "\t-disable-state-journal\n"
                     "\t-globus-tcp-port-range <min port #>,<max port #>\n"
                     "\t-globus-tcp-source-range <min port #>,<max port #>\n"
                     "\t-x509-cert-dir DIRECTORY\n"
@@ -91,6 +91,31 @@ typedef struct
 }
 globus_gram_job_manager_script_context_t;
 
+/**
+ * Seconds to gather job polls into a single poll_all script command. After
+ * the first bulk poll, the jobs it answered are reregistered together, so
+ * their later polls fall into the same window.
+ */
+#define GLOBUS_L_GRAM_POLL_ALL_DELAY 1
+
+/** Job waiting for its status from the next poll_all script command */
+typedef struct
+{
+    globus_gram_jobmanager_request_t *  request;
+    int                                 starting_jobmanager_state;
+    globus_bool_t                       polled;
+}
+globus_l_gram_poll_all_waiter_t;
+
+/** State of one poll_all script command */
+typedef struct
+{
+    globus_gram_job_manager_t *         manager;
+    /** Hashtable mapping job_contact_path -> globus_l_gram_poll_all_waiter_t */
+    globus_hashtable_t                  waiters;
+}
+globus_l_gram_poll_all_context_t;
+
 /* Module Specific Prototypes */
 static
 void
@@ -123,6 +148,36 @@ globus_l_gram_job_manager_query_done(
     const char *                        variable,
     const char *                        value);
 
+static
+void
+globus_l_gram_job_manager_poll_all_done(
+    void *                              arg,
+    globus_gram_jobmanager_request_t *  request,
+    int                                 failure_code,
+    int                                 starting_jobmanager_state,
+    const char *                        variable,
+    const char *                        value);
+
+static
+globus_bool_t
+globus_l_gram_poll_all_enqueue(
+    globus_gram_jobmanager_request_t *  request);
+
+static
+int
+globus_l_gram_poll_all_schedule_locked(
+    globus_gram_job_manager_t *         manager);
+
+static
+void
+globus_l_gram_poll_all_callback(
+    void *                              user_arg);
+
+static
+void
+globus_l_gram_poll_all_finish(
+    globus_l_gram_poll_all_context_t *  context);
+
 static
 int
 globus_l_gram_request_validate(
@@ -281,7 +336,8 @@ globus_l_gram_job_manager_script_run(
     script_context->request = request;
     script_context->starting_jobmanager_state = request->jobmanager_state;
 
-    if (strcmp(script_cmd, "poll") == 0)
+    if (strcmp(script_cmd, "poll") == 0 ||
+        strcmp(script_cmd, "poll_all") == 0)
     {
         script_context->priority.priority_level =
             GLOBUS_GRAM_SCRIPT_PRIORITY_LEVEL_POLL;
@@ -1041,7 +1097,9 @@ FAST_POLL_EXIT:
  *
  * This function invokes a scheduler-specific program to determine
  * the current status of the job request. The job status field of
- * the requst structure will be updated with the new status.
+ * the requst structure will be updated with the new status. Jobs with an
+ * LRM job id are polled together with the other jobs due to be polled by
+ * the poll_all script command, unless the LRM module doesn't implement it.
  *
  * @param request
  *        The request containing the job description.
@@ -1078,6 +1136,14 @@ globus_gram_job_manager_script_poll(
         return(GLOBUS_SUCCESS);
     }
 
+    /* Let a single poll_all answer this job along with any others which are
+     * due to be polled
+     */
+    if (globus_l_gram_poll_all_enqueue(request))
+    {
+        return GLOBUS_SUCCESS;
+    }
+
     rc = globus_l_gram_job_manager_script_run(
                 request,
                 script_cmd,
@@ -1483,6 +1549,460 @@ globus_l_gram_job_manager_default_done(
 }
 /* globus_l_gram_job_manager_default_done() */
 
+/**
+ * Add a job to the next poll_all script command
+ *
+ * Jobs which are due to be polled are collected for
+ * GLOBUS_L_GRAM_POLL_ALL_DELAY seconds and then polled by a single
+ * poll_all command so that the LRM is queried once per poll cycle instead of
+ * once per job.
+ *
+ * @param request
+ *     Job to poll. Its state machine is reregistered when the poll_all
+ *     command completes.
+ *
+ * @retval GLOBUS_TRUE
+ *     The job will be polled by poll_all.
+ * @retval GLOBUS_FALSE
+ *     The job must be polled with the poll script command.
+ */
+static
+globus_bool_t
+globus_l_gram_poll_all_enqueue(
+    globus_gram_jobmanager_request_t *  request)
+{
+    globus_gram_job_manager_t *         manager = request->manager;
+    globus_l_gram_poll_all_waiter_t *   waiter;
+    globus_bool_t                       unsupported;
+    int                                 rc;
+
+    /* job_id_hash only contains the individual ids of multi-id jobs */
+    if (request->job_id_string == NULL ||
+        strchr(request->job_id_string, ',') != NULL)
+    {
+        return GLOBUS_FALSE;
+    }
+
+    GlobusGramJobManagerLock(manager);
+    unsupported = manager->poll_all_unsupported;
+    GlobusGramJobManagerUnlock(manager);
+
+    if (unsupported)
+    {
+        return GLOBUS_FALSE;
+    }
+
+    waiter = malloc(sizeof(globus_l_gram_poll_all_waiter_t));
+    if (waiter == NULL)
+    {
+        goto waiter_malloc_failed;
+    }
+    waiter->request = request;
+    waiter->starting_jobmanager_state = request->jobmanager_state;
+    waiter->polled = GLOBUS_FALSE;
+
+    rc = globus_gram_job_manager_add_reference(
+            manager,
+            request->job_contact_path,
+            "poll_all",
+            NULL);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto add_reference_failed;
+    }
+
+    GlobusGramJobManagerLock(manager);
+    rc = globus_list_insert(&manager->poll_all_waiters, waiter);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto insert_failed;
+    }
+    rc = globus_l_gram_poll_all_schedule_locked(manager);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        globus_list_remove(
+                &manager->poll_all_waiters,
+                globus_list_search(manager->poll_all_waiters, waiter));
+insert_failed:
+        GlobusGramJobManagerUnlock(manager);
+        globus_gram_job_manager_remove_reference(
+                manager,
+                request->job_contact_path,
+                "poll_all");
+add_reference_failed:
+        free(waiter);
+waiter_malloc_failed:
+        return GLOBUS_FALSE;
+    }
+    GlobusGramJobManagerUnlock(manager);
+
+    return GLOBUS_TRUE;
+}
+/* globus_l_gram_poll_all_enqueue() */
+
+/**
+ * Register the poll_all oneshot if jobs are waiting and none is pending
+ *
+ * Called with the manager lock held.
+ */
+static
+int
+globus_l_gram_poll_all_schedule_locked(
+    globus_gram_job_manager_t *         manager)
+{
+    globus_reltime_t                    delay;
+    globus_result_t                     result;
+
+    if (manager->poll_all_waiters == NULL ||
+        manager->poll_all_timer != GLOBUS_NULL_HANDLE ||
+        manager->poll_all_running)
+    {
+        return GLOBUS_SUCCESS;
+    }
+
+    GlobusTimeReltimeSet(delay, GLOBUS_L_GRAM_POLL_ALL_DELAY, 0);
+    result = globus_callback_register_oneshot(
+            &manager->poll_all_timer,
+            &delay,
+            globus_l_gram_poll_all_callback,
+            manager);
+    if (result != GLOBUS_SUCCESS)
+    {
+        manager->poll_all_timer = GLOBUS_NULL_HANDLE;
+
+        return GLOBUS_GRAM_PROTOCOL_ERROR_NO_RESOURCES;
+    }
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_l_gram_poll_all_schedule_locked() */
+
+/**
+ * Run the poll_all script command for all waiting jobs
+ *
+ * The command is run with the description of one of the waiting jobs, with
+ * the LRM job ids of all of them in the polljobids attribute.
+ */
+static
+void
+globus_l_gram_poll_all_callback(
+    void *                              user_arg)
+{
+    globus_gram_job_manager_t *         manager = user_arg;
+    globus_l_gram_poll_all_context_t *  context;
+    globus_l_gram_poll_all_waiter_t *   waiter;
+    globus_gram_jobmanager_request_t *  request = NULL;
+    globus_list_t *                     waiters;
+    globus_list_t *                     job_ids = NULL;
+    int                                 count = 0;
+    int                                 rc;
+
+    GlobusGramJobManagerLock(manager);
+    waiters = manager->poll_all_waiters;
+    manager->poll_all_waiters = NULL;
+    manager->poll_all_timer = GLOBUS_NULL_HANDLE;
+    manager->poll_all_running = GLOBUS_TRUE;
+    GlobusGramJobManagerUnlock(manager);
+
+    context = malloc(sizeof(globus_l_gram_poll_all_context_t));
+    if (context == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto context_malloc_failed;
+    }
+    context->manager = manager;
+    rc = globus_hashtable_init(
+            &context->waiters,
+            89,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+
+        goto hashtable_init_failed;
+    }
+
+    while (!globus_list_empty(waiters))
+    {
+        waiter = globus_list_remove(&waiters, waiters);
+        request = waiter->request;
+
+        globus_hashtable_insert(
+                &context->waiters,
+                request->job_contact_path,
+                waiter);
+        globus_list_insert(&job_ids, request->job_id_string);
+        count++;
+    }
+
+    globus_gram_job_manager_log(
+            manager,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_DEBUG,
+            "event=gram.poll_all.start "
+            "level=DEBUG "
+            "jobs=%d "
+            "\n",
+            count);
+
+    GlobusGramJobManagerRequestLock(request);
+    rc = globus_l_gram_job_manager_script_run(
+            request,
+            "poll_all",
+            globus_l_gram_job_manager_poll_all_done,
+            context,
+            "polljobids",
+            'l',
+            job_ids,
+            NULL);
+    GlobusGramJobManagerRequestUnlock(request);
+    globus_list_free(job_ids);
+
+    if (rc != GLOBUS_SUCCESS)
+    {
+        /* Fall back to polling each job */
+        globus_l_gram_poll_all_finish(context);
+    }
+    return;
+
+hashtable_init_failed:
+    free(context);
+context_malloc_failed:
+    globus_gram_job_manager_log(
+            manager,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+            "event=gram.poll_all.end "
+            "level=ERROR "
+            "status=%d "
+            "reason=\"%s\" "
+            "\n",
+            -rc,
+            globus_gram_protocol_error_string(rc));
+
+    /* Skip this poll cycle */
+    while (!globus_list_empty(waiters))
+    {
+        waiter = globus_list_remove(&waiters, waiters);
+        request = waiter->request;
+
+        globus_l_gram_job_manager_default_done(
+                NULL,
+                request,
+                GLOBUS_SUCCESS,
+                waiter->starting_jobmanager_state,
+                NULL,
+                NULL);
+        globus_gram_job_manager_remove_reference(
+                manager,
+                request->job_contact_path,
+                "poll_all");
+        free(waiter);
+    }
+
+    GlobusGramJobManagerLock(manager);
+    manager->poll_all_running = GLOBUS_FALSE;
+    (void) globus_l_gram_poll_all_schedule_locked(manager);
+    GlobusGramJobManagerUnlock(manager);
+}
+/* globus_l_gram_poll_all_callback() */
+
+/**
+ * Handle a poll_all script response
+ *
+ * Each GRAM_SCRIPT_POLL_JOB_STATE response names an LRM job id and its
+ * state, separated by the last ':' in the value. The job id is resolved to
+ * its request through the manager's job_id_hash and the state is handled as
+ * a GRAM_SCRIPT_JOB_STATE response to a poll of that job.
+ */
+static
+void
+globus_l_gram_job_manager_poll_all_done(
+    void *                              arg,
+    globus_gram_jobmanager_request_t *  request,
+    int                                 failure_code,
+    int                                 starting_jobmanager_state,
+    const char *                        variable,
+    const char *                        value)
+{
+    globus_l_gram_poll_all_context_t *  context = arg;
+    globus_l_gram_poll_all_waiter_t *   waiter;
+    globus_gram_jobmanager_request_t *  job_request;
+    const char *                        state;
+    char *                              job_id;
+    int                                 rc;
+
+    if (!variable)
+    {
+        globus_l_gram_poll_all_finish(context);
+    }
+    else if (strcmp(variable, "GRAM_SCRIPT_POLL_JOB_STATE") == 0)
+    {
+        state = strrchr(value, ':');
+        if (state == NULL)
+        {
+            globus_gram_job_manager_log(
+                    context->manager,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                    "event=gram.poll_all.info "
+                    "level=ERROR "
+                    "msg=\"%s\" "
+                    "value=\"%s\" "
+                    "\n",
+                    "Invalid GRAM_SCRIPT_POLL_JOB_STATE",
+                    value);
+            return;
+        }
+        job_id = globus_common_create_string(
+                "%.*s", (int) (state - value), value);
+        if (job_id == NULL)
+        {
+            return;
+        }
+        rc = globus_gram_job_manager_add_reference_by_jobid(
+                context->manager,
+                job_id,
+                "poll_all",
+                &job_request);
+        free(job_id);
+        if (rc != GLOBUS_SUCCESS)
+        {
+            return;
+        }
+
+        waiter = globus_hashtable_lookup(
+                &context->waiters,
+                job_request->job_contact_path);
+        if (waiter != NULL && !waiter->polled)
+        {
+            waiter->polled = GLOBUS_TRUE;
+
+            globus_l_gram_job_manager_default_done(
+                    NULL,
+                    waiter->request,
+                    GLOBUS_SUCCESS,
+                    waiter->starting_jobmanager_state,
+                    "GRAM_SCRIPT_JOB_STATE",
+                    state + 1);
+        }
+        globus_gram_job_manager_remove_reference(
+                context->manager,
+                job_request->job_contact_path,
+                "poll_all");
+    }
+    else if (strcmp(variable, "GRAM_SCRIPT_ERROR") == 0)
+    {
+        if (atoi(value) == GLOBUS_GRAM_PROTOCOL_ERROR_UNIMPLEMENTED)
+        {
+            GlobusGramJobManagerLock(context->manager);
+            context->manager->poll_all_unsupported = GLOBUS_TRUE;
+            GlobusGramJobManagerUnlock(context->manager);
+        }
+        globus_gram_job_manager_log(
+                context->manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_DEBUG,
+                "event=gram.poll_all.info "
+                "level=DEBUG "
+                "msg=\"%s\" "
+                "status=%d "
+                "\n",
+                "poll_all failed, polling jobs individually",
+                -atoi(value));
+    }
+    else if (strcmp(variable, "GRAM_SCRIPT_LOG") == 0)
+    {
+        globus_l_gram_job_manager_default_done(
+                NULL,
+                request,
+                GLOBUS_SUCCESS,
+                starting_jobmanager_state,
+                variable,
+                value);
+    }
+}
+/* globus_l_gram_job_manager_poll_all_done() */
+
+/**
+ * Complete a poll_all script command
+ *
+ * Reregisters the state machine of each job which poll_all answered and
+ * runs the poll script command for the rest.
+ */
+static
+void
+globus_l_gram_poll_all_finish(
+    globus_l_gram_poll_all_context_t *  context)
+{
+    globus_gram_job_manager_t *         manager = context->manager;
+    globus_l_gram_poll_all_waiter_t *   waiter;
+    globus_gram_jobmanager_request_t *  request;
+    globus_list_t *                     waiters = NULL;
+    int                                 polled = 0;
+    int                                 rc;
+
+    globus_hashtable_to_list(&context->waiters, &waiters);
+    globus_hashtable_destroy(&context->waiters);
+
+    while (!globus_list_empty(waiters))
+    {
+        waiter = globus_list_remove(&waiters, waiters);
+        request = waiter->request;
+
+        if (waiter->polled)
+        {
+            polled++;
+            rc = GLOBUS_FAILURE;
+        }
+        else
+        {
+            GlobusGramJobManagerRequestLock(request);
+            rc = globus_l_gram_job_manager_script_run(
+                    request,
+                    "poll",
+                    globus_l_gram_job_manager_default_done,
+                    NULL,
+                    NULL);
+            GlobusGramJobManagerRequestUnlock(request);
+        }
+        if (rc != GLOBUS_SUCCESS)
+        {
+            globus_l_gram_job_manager_default_done(
+                    NULL,
+                    request,
+                    GLOBUS_SUCCESS,
+                    waiter->starting_jobmanager_state,
+                    NULL,
+                    NULL);
+        }
+        globus_gram_job_manager_remove_reference(
+                manager,
+                request->job_contact_path,
+                "poll_all");
+        free(waiter);
+    }
+    free(context);
+
+    globus_gram_job_manager_log(
+            manager,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_DEBUG,
+            "event=gram.poll_all.end "
+            "level=DEBUG "
+            "polled=%d "
+            "\n",
+            polled);
+
+    GlobusGramJobManagerLock(manager);
+    manager->poll_all_running = GLOBUS_FALSE;
+    rc = globus_l_gram_poll_all_schedule_locked(manager);
+    GlobusGramJobManagerUnlock(manager);
+
+    if (rc != GLOBUS_SUCCESS)
+    {
+        globus_l_gram_poll_all_callback(manager);
+    }
+}
+/* globus_l_gram_poll_all_finish() */
+
 /**
  * Completion callback for query-initiated scripts
  */
@@ -1755,6 +2275,7 @@ globus_l_gram_enqueue_description(
     char                                format;
     char *                              string_value;
     int                                 int_value;
+    globus_list_t *                     list_value;
     char *                              prepared;
     int                                 rc;
 
@@ -1796,6 +2317,27 @@ globus_l_gram_enqueue_description(
             }
             break;
 
+          case 'l':
+            list_value = va_arg(ap, globus_list_t *);
+            rc = globus_l_gram_enqueue_string(
+                    fifo,
+                    ",\n    '%s' => [",
+                    attribute);
+            for (; list_value != NULL; list_value = globus_list_rest(list_value))
+            {
+                prepared = globus_l_gram_job_manager_script_prepare_param(
+                        globus_list_first(list_value));
+
+                rc = globus_l_gram_enqueue_string(
+                        fifo,
+                        " '%s'%s",
+                        prepared,
+                        globus_list_rest(list_value) ? "," : "");
+                free(prepared);
+            }
+            rc = globus_l_gram_enqueue_string(fifo, " ]");
+            break;
+
           case 'i':
           case 'd':
             int_value = va_arg(ap, int);
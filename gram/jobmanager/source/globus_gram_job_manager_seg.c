@@ -23,6 +23,12 @@
 #include <utime.h>
 #include <regex.h>
 
+#if defined(HAVE_SYS_EPOLL_H) && HAVE_DECL_SYS_PIDFD_OPEN
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#define GLOBUS_L_GRAM_FORK_PIDFD 1
+#endif
+
 typedef struct globus_gram_seg_resume_s
 {
     globus_gram_job_manager_t *         manager;
@@ -30,6 +36,25 @@ typedef struct globus_gram_seg_resume_s
 }
 globus_gram_seg_resume_t;
 
+typedef struct globus_l_gram_fork_watch_s globus_l_gram_fork_watch_t;
+
+/* One process of a fork job, with the pidfd registered with the epoll fd */
+typedef struct
+{
+    globus_l_gram_fork_watch_t *        watch;
+    int                                 pidfd;
+}
+globus_l_gram_fork_pid_t;
+
+/* All processes of a fork job. The job is done when all pidfds are done */
+struct globus_l_gram_fork_watch_s
+{
+    char *                              job_id;
+    int                                 pid_count;
+    int                                 done_count;
+    globus_l_gram_fork_pid_t *          pids;
+};
+
 static globus_bool_t globus_l_condor_regexes_compiled = GLOBUS_FALSE;
 static regex_t globus_l_condor_outer_re;
 static regex_t globus_l_condor_inner_re;
@@ -44,6 +69,24 @@ void
 globus_l_gram_fork_poll_callback(
     void *                              user_arg);
 
+static
+void
+globus_l_gram_fork_deliver_events(
+    globus_gram_job_manager_t *         manager,
+    globus_list_t *                     events);
+
+#ifdef GLOBUS_L_GRAM_FORK_PIDFD
+static
+int
+globus_l_gram_fork_event_init(
+    globus_gram_job_manager_t *         manager);
+
+static
+void
+globus_l_gram_fork_event_destroy(
+    globus_gram_job_manager_t *         manager);
+#endif
+
 static
 int
 globus_l_gram_deliver_event(
@@ -95,6 +138,39 @@ globus_gram_job_manager_init_seg(
     {
         globus_reltime_t                delay;
 
+#ifdef GLOBUS_L_GRAM_FORK_PIDFD
+        /* Track process exits with pidfds if the kernel supports them,
+         * otherwise fall back to polling all job processes
+         */
+        if (globus_l_gram_fork_event_init(manager) == GLOBUS_SUCCESS)
+        {
+            globus_list_t *             job_id_list = NULL;
+            globus_list_t *             tmp;
+
+            manager->seg_started = GLOBUS_TRUE;
+            GlobusGramJobManagerUnlock(manager);
+
+            /* Jobs reloaded from state files were registered before the
+             * events were set up
+             */
+            (void) globus_gram_job_manager_get_job_id_list(
+                    manager,
+                    &job_id_list);
+
+            GlobusGramJobManagerLock(manager);
+            for (tmp = job_id_list; tmp != NULL; tmp = globus_list_rest(tmp))
+            {
+                (void) globus_gram_job_manager_seg_fork_watch(
+                        manager,
+                        globus_list_first(tmp));
+            }
+            GlobusGramJobManagerUnlock(manager);
+            globus_list_destroy_all(job_id_list, free);
+
+            return GLOBUS_SUCCESS;
+        }
+#endif
+
         GlobusTimeReltimeSet(delay, 1, 0);
 
         result = globus_callback_register_periodic(
@@ -137,12 +213,47 @@ globus_gram_job_manager_init_seg(
 
         GlobusTimeReltimeSet(delay, 5, 0);
 
-        result = globus_callback_register_periodic(
-                &manager->fork_callback_handle,
-                &delay,
-                &delay,
-                globus_l_gram_condor_poll_callback,
-                manager);
+        /* Read the condor logs as soon as condor writes to them if the
+         * state file directory can be watched for changes, otherwise poll
+         * them periodically
+         */
+        rc = globus_module_activate(GLOBUS_SCHEDULER_EVENT_GENERATOR_MODULE);
+        if (rc == GLOBUS_SUCCESS)
+        {
+            result = globus_scheduler_event_generator_tail_init(
+                    &manager->condor_tail,
+                    manager->config->job_state_file_dir,
+                    "condor.");
+            if (result == GLOBUS_SUCCESS)
+            {
+                result = globus_scheduler_event_generator_tail_register(
+                        manager->condor_tail,
+                        &delay,
+                        globus_l_gram_condor_poll_callback,
+                        manager);
+                if (result != GLOBUS_SUCCESS)
+                {
+                    globus_scheduler_event_generator_tail_destroy(
+                            manager->condor_tail);
+                    manager->condor_tail = NULL;
+                }
+            }
+            if (manager->condor_tail == NULL)
+            {
+                globus_module_deactivate(
+                        GLOBUS_SCHEDULER_EVENT_GENERATOR_MODULE);
+            }
+        }
+
+        if (manager->condor_tail == NULL)
+        {
+            result = globus_callback_register_periodic(
+                    &manager->fork_callback_handle,
+                    &delay,
+                    &delay,
+                    globus_l_gram_condor_poll_callback,
+                    manager);
+        }
         if (result != GLOBUS_SUCCESS)
         {
             char *                      errstr;
@@ -230,12 +341,28 @@ globus_result_t
 globus_gram_job_manager_shutdown_seg(
     globus_gram_job_manager_t *         manager)
 {
+    globus_bool_t                       fork_events = GLOBUS_FALSE;
+
     if (! manager->seg_started)
     {
         return GLOBUS_SUCCESS;
     }
 
-    if (manager->fork_callback_handle != GLOBUS_NULL_HANDLE)
+#ifdef GLOBUS_L_GRAM_FORK_PIDFD
+    if (manager->fork_event_fd != -1)
+    {
+        globus_l_gram_fork_event_destroy(manager);
+        fork_events = GLOBUS_TRUE;
+    }
+#endif
+
+    if (manager->condor_tail != NULL)
+    {
+        globus_scheduler_event_generator_tail_destroy(manager->condor_tail);
+        manager->condor_tail = NULL;
+        globus_module_deactivate(GLOBUS_SCHEDULER_EVENT_GENERATOR_MODULE);
+    }
+    else if (manager->fork_callback_handle != GLOBUS_NULL_HANDLE)
     {
         globus_callback_unregister(
                 manager->fork_callback_handle,
@@ -244,7 +371,7 @@ globus_gram_job_manager_shutdown_seg(
                 NULL);
         manager->fork_callback_handle = GLOBUS_NULL_HANDLE;
     }
-    else
+    else if (!fork_events)
     {
         globus_module_deactivate(GLOBUS_SCHEDULER_EVENT_GENERATOR_MODULE);
     }
@@ -845,10 +972,8 @@ globus_l_gram_fork_poll_callback(
 {
     int                                 rc;
     globus_gram_job_manager_t *         manager = user_arg;
-    globus_list_t *                     l;
     globus_scheduler_event_t *          event;
     globus_list_t *                     events = NULL;
-    globus_gram_jobmanager_request_t *  request;
     int                                 pid_count = 0;
     int                                 done_count = 0;
     globus_list_t *                     job_id_list;
@@ -919,6 +1044,30 @@ globus_l_gram_fork_poll_callback(
     }
     globus_list_free(job_id_list);
 
+    globus_l_gram_fork_deliver_events(manager, events);
+}
+/* globus_l_gram_fork_poll_callback() */
+
+/**
+ * @brief
+ * Deliver synthesized fork job events
+ *
+ * @details
+ * Queue each event in the list in the SEG event queue of the request it
+ * belongs to and free the list. Events for jobs which are no longer known
+ * are destroyed. Called without the manager lock held.
+ */
+static
+void
+globus_l_gram_fork_deliver_events(
+    globus_gram_job_manager_t *         manager,
+    globus_list_t *                     events)
+{
+    int                                 rc;
+    globus_list_t *                     l;
+    globus_scheduler_event_t *          event;
+    globus_gram_jobmanager_request_t *  request;
+
     /* Queue events in the request-specific SEG event queue */
     for (l = events; l != NULL; l = globus_list_rest(l))
     {
@@ -953,15 +1102,598 @@ destroy_event:
     }
     globus_list_free(events);
 }
-/* globus_l_gram_fork_poll_callback() */
+/* globus_l_gram_fork_deliver_events() */
+
+#ifdef GLOBUS_L_GRAM_FORK_PIDFD
+static
+globus_scheduler_event_t *
+globus_l_gram_fork_done_event(
+    const char *                        job_id)
+{
+    globus_scheduler_event_t *          event;
+
+    event = malloc(sizeof(globus_scheduler_event_t));
+    if (event == NULL)
+    {
+        return NULL;
+    }
+    event->event_type = GLOBUS_SCHEDULER_EVENT_DONE;
+    event->job_id = strdup(job_id);
+    event->timestamp = time(NULL);
+    event->exit_code = 0;
+    event->failure_code = 0;
+    event->raw_event = NULL;
+
+    if (event->job_id == NULL)
+    {
+        free(event);
+        event = NULL;
+    }
+    return event;
+}
+/* globus_l_gram_fork_done_event() */
+
+/* Called with the manager lock held */
+static
+void
+globus_l_gram_fork_watch_free(
+    globus_gram_job_manager_t *         manager,
+    globus_l_gram_fork_watch_t *        watch)
+{
+    int                                 i;
+
+    for (i = 0; i < watch->pid_count; i++)
+    {
+        if (watch->pids[i].pidfd != -1)
+        {
+            epoll_ctl(
+                    manager->fork_event_fd,
+                    EPOLL_CTL_DEL,
+                    watch->pids[i].pidfd,
+                    NULL);
+            close(watch->pids[i].pidfd);
+        }
+    }
+    free(watch->pids);
+    free(watch->job_id);
+    free(watch);
+}
+/* globus_l_gram_fork_watch_free() */
+
+/**
+ * @brief
+ * Collect done events for fork jobs whose processes have exited
+ *
+ * @details
+ * Drains the ready pidfds from the manager's epoll descriptor, and delivers
+ * a done event for each job whose last process has exited, along with any
+ * events for jobs which had already exited when they were registered.
+ */
+static
+void
+globus_l_gram_fork_event_process(
+    globus_gram_job_manager_t *         manager)
+{
+    struct epoll_event                  ready[64];
+    int                                 nready;
+    int                                 i;
+    globus_l_gram_fork_pid_t *          pid;
+    globus_l_gram_fork_watch_t *        watch;
+    globus_scheduler_event_t *          event;
+    globus_list_t *                     events = NULL;
+
+    GlobusGramJobManagerLock(manager);
+    if (manager->fork_event_fd == -1)
+    {
+        GlobusGramJobManagerUnlock(manager);
+        return;
+    }
+    do
+    {
+        nready = epoll_wait(
+                manager->fork_event_fd,
+                ready,
+                sizeof(ready)/sizeof(ready[0]),
+                0);
+
+        for (i = 0; i < nready; i++)
+        {
+            pid = ready[i].data.ptr;
+            watch = pid->watch;
+
+            epoll_ctl(manager->fork_event_fd, EPOLL_CTL_DEL, pid->pidfd, NULL);
+            close(pid->pidfd);
+            pid->pidfd = -1;
+
+            if (++watch->done_count < watch->pid_count)
+            {
+                continue;
+            }
+            globus_hashtable_remove(&manager->fork_watch_hash, watch->job_id);
+
+            event = globus_l_gram_fork_done_event(watch->job_id);
+            if (event != NULL)
+            {
+                globus_list_insert(&events, event);
+            }
+            globus_l_gram_fork_watch_free(manager, watch);
+        }
+    }
+    while (nready == sizeof(ready)/sizeof(ready[0]));
+
+    while (!globus_fifo_empty(&manager->fork_done_events))
+    {
+        globus_list_insert(
+                &events,
+                globus_fifo_dequeue(&manager->fork_done_events));
+    }
+    GlobusGramJobManagerUnlock(manager);
+
+    globus_l_gram_fork_deliver_events(manager, events);
+}
+/* globus_l_gram_fork_event_process() */
+
+static
+void
+globus_l_gram_fork_done_callback(
+    void *                              user_arg)
+{
+    globus_l_gram_fork_event_process(user_arg);
+}
+/* globus_l_gram_fork_done_callback() */
+
+static
+void
+globus_l_gram_fork_event_callback(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    globus_gram_job_manager_t *         manager = user_arg;
+
+    if (result != GLOBUS_SUCCESS)
+    {
+        /* Handle closed by globus_l_gram_fork_event_destroy() */
+        return;
+    }
+
+    globus_l_gram_fork_event_process(manager);
+
+    GlobusGramJobManagerLock(manager);
+    if (manager->fork_event_handle != NULL)
+    {
+        result = globus_xio_register_read(
+                manager->fork_event_handle,
+                buffer,
+                0,
+                0,
+                NULL,
+                globus_l_gram_fork_event_callback,
+                manager);
+        if (result != GLOBUS_SUCCESS)
+        {
+            globus_gram_job_manager_log(
+                    manager,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                    "event=gram.fork_events.end "
+                    "level=ERROR "
+                    "msg=\"%s\" "
+                    "\n",
+                    "Error registering for process exit events");
+        }
+    }
+    GlobusGramJobManagerUnlock(manager);
+}
+/* globus_l_gram_fork_event_callback() */
+
+/**
+ * @brief
+ * Start event-driven tracking of fork job processes
+ *
+ * @details
+ * Creates an epoll descriptor to hold a pidfd for each job process and
+ * registers it with XIO's select loop. Called with the manager lock held.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_FAILURE
+ *     pidfds are not supported by the kernel, or setup failed. The caller
+ *     should fall back to polling.
+ */
+static
+int
+globus_l_gram_fork_event_init(
+    globus_gram_job_manager_t *         manager)
+{
+    int                                 rc;
+    int                                 fd;
+    globus_result_t                     result;
+    globus_xio_attr_t                   attr;
+    static globus_byte_t                buffer[1];
+
+    fd = syscall(SYS_pidfd_open, getpid(), 0);
+    if (fd < 0)
+    {
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_DEBUG,
+                "event=gram.fork_events.init.end "
+                "level=DEBUG "
+                "status=%d "
+                "errno=%d "
+                "msg=\"%s\" "
+                "\n",
+                -1,
+                errno,
+                "pidfd_open not available, polling instead");
+        return GLOBUS_FAILURE;
+    }
+    close(fd);
+
+    manager->fork_event_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (manager->fork_event_fd < 0)
+    {
+        goto epoll_create_failed;
+    }
+    rc = globus_hashtable_init(
+            &manager->fork_watch_hash,
+            89,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto hashtable_init_failed;
+    }
+    rc = globus_fifo_init(&manager->fork_done_events);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto fifo_init_failed;
+    }
+
+    result = globus_xio_attr_init(&attr);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto attr_init_failed;
+    }
+    result = globus_xio_attr_cntl(
+            attr,
+            globus_i_gram_job_manager_file_driver,
+            GLOBUS_XIO_FILE_SET_HANDLE,
+            manager->fork_event_fd);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto attr_cntl_failed;
+    }
+    result = globus_xio_handle_create(
+            &manager->fork_event_handle,
+            globus_i_gram_job_manager_file_stack);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto handle_create_failed;
+    }
+    result = globus_xio_open(manager->fork_event_handle, NULL, attr);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto open_failed;
+    }
+    result = globus_xio_register_read(
+            manager->fork_event_handle,
+            buffer,
+            0,
+            0,
+            NULL,
+            globus_l_gram_fork_event_callback,
+            manager);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto register_read_failed;
+    }
+    globus_xio_attr_destroy(attr);
+
+    globus_gram_job_manager_log(
+            manager,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_TRACE,
+            "event=gram.fork_events.init.end "
+            "level=TRACE "
+            "status=%d "
+            "\n",
+            0);
+
+    return GLOBUS_SUCCESS;
+
+register_read_failed:
+open_failed:
+    globus_xio_close(manager->fork_event_handle, NULL);
+handle_create_failed:
+    manager->fork_event_handle = NULL;
+attr_cntl_failed:
+    globus_xio_attr_destroy(attr);
+attr_init_failed:
+    globus_fifo_destroy(&manager->fork_done_events);
+fifo_init_failed:
+    globus_hashtable_destroy(&manager->fork_watch_hash);
+hashtable_init_failed:
+    close(manager->fork_event_fd);
+    manager->fork_event_fd = -1;
+epoll_create_failed:
+    globus_gram_job_manager_log(
+            manager,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+            "event=gram.fork_events.init.end "
+            "level=WARN "
+            "status=%d "
+            "msg=\"%s\" "
+            "\n",
+            -1,
+            "Unable to set up process exit events, polling instead");
+    return GLOBUS_FAILURE;
+}
+/* globus_l_gram_fork_event_init() */
+
+static
+void
+globus_l_gram_fork_event_destroy(
+    globus_gram_job_manager_t *         manager)
+{
+    globus_xio_handle_t                 handle;
+    globus_l_gram_fork_watch_t *        watch;
+
+    GlobusGramJobManagerLock(manager);
+    handle = manager->fork_event_handle;
+    manager->fork_event_handle = NULL;
+    GlobusGramJobManagerUnlock(manager);
+
+    if (handle != NULL)
+    {
+        globus_xio_close(handle, NULL);
+    }
+
+    GlobusGramJobManagerLock(manager);
+    while ((watch = globus_hashtable_first(&manager->fork_watch_hash)) != NULL)
+    {
+        globus_hashtable_remove(&manager->fork_watch_hash, watch->job_id);
+        globus_l_gram_fork_watch_free(manager, watch);
+    }
+    globus_hashtable_destroy(&manager->fork_watch_hash);
+    while (!globus_fifo_empty(&manager->fork_done_events))
+    {
+        globus_scheduler_event_destroy(
+                globus_fifo_dequeue(&manager->fork_done_events));
+    }
+    globus_fifo_destroy(&manager->fork_done_events);
+    close(manager->fork_event_fd);
+    manager->fork_event_fd = -1;
+    GlobusGramJobManagerUnlock(manager);
+}
+/* globus_l_gram_fork_event_destroy() */
+#endif /* GLOBUS_L_GRAM_FORK_PIDFD */
+
+/**
+ * @brief
+ * Start watching the processes of a fork job
+ *
+ * @details
+ * Opens a pidfd for each process id in the comma-separated job_id and adds it
+ * to the manager's epoll descriptor, so that a done event is delivered as
+ * soon as the last of them exits. This does nothing unless event-driven fork
+ * job tracking is active. Called with the manager lock held.
+ *
+ * @param manager
+ *     Job manager state
+ * @param job_id
+ *     Fork job id (list of process ids)
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED
+ *     Malloc failed.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_NO_RESOURCES
+ *     A process could not be watched; the job manager falls back to polling.
+ */
+int
+globus_gram_job_manager_seg_fork_watch(
+    globus_gram_job_manager_t *         manager,
+    const char *                        job_id)
+{
+    int                                 rc = GLOBUS_SUCCESS;
+#ifdef GLOBUS_L_GRAM_FORK_PIDFD
+    globus_l_gram_fork_watch_t *        watch;
+    globus_scheduler_event_t *          event;
+    struct epoll_event                  ev;
+    char *                              job_id_copy;
+    char *                              pid_string;
+    char *                              tok_end = NULL;
+    char *                              end;
+    const char *                        p;
+    unsigned long                       pid;
+    globus_reltime_t                    delay;
+    int                                 i;
+
+    if (manager->fork_event_fd == -1 ||
+        globus_hashtable_lookup(&manager->fork_watch_hash, (void *) job_id))
+    {
+        return GLOBUS_SUCCESS;
+    }
+
+    watch = calloc(1, sizeof(globus_l_gram_fork_watch_t));
+    if (watch == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto watch_malloc_failed;
+    }
+    watch->job_id = strdup(job_id);
+    job_id_copy = strdup(job_id);
+    for (i = 1, p = job_id; *p; p++)
+    {
+        if (*p == ',')
+        {
+            i++;
+        }
+    }
+    watch->pids = calloc(i, sizeof(globus_l_gram_fork_pid_t));
+    if (watch->job_id == NULL || job_id_copy == NULL || watch->pids == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto copy_failed;
+    }
+
+    for (pid_string = strtok_r(job_id_copy, ",", &tok_end);
+         pid_string != NULL;
+         pid_string = strtok_r(NULL, ",", &tok_end))
+    {
+        globus_l_gram_fork_pid_t *      watch_pid;
+
+        watch_pid = &watch->pids[watch->pid_count++];
+        watch_pid->watch = watch;
+        watch_pid->pidfd = -1;
+
+        errno = 0;
+        pid = strtoul(pid_string, &end, 10);
+        if ((pid == ULONG_MAX && errno != 0) || strlen(end) != 0)
+        {
+            /* Not a process we can watch; the poller ignores these too */
+            continue;
+        }
+
+        watch_pid->pidfd = syscall(SYS_pidfd_open, (pid_t) pid, 0);
+        if (watch_pid->pidfd < 0)
+        {
+            watch_pid->pidfd = -1;
+            if (errno == ESRCH)
+            {
+                watch->done_count++;
+                continue;
+            }
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_RESOURCES;
+            goto pidfd_open_failed;
+        }
+
+        ev.events = EPOLLIN;
+        ev.data.ptr = watch_pid;
+        if (epoll_ctl(
+                manager->fork_event_fd,
+                EPOLL_CTL_ADD,
+                watch_pid->pidfd,
+                &ev) != 0)
+        {
+            close(watch_pid->pidfd);
+            watch_pid->pidfd = -1;
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_RESOURCES;
+            goto pidfd_open_failed;
+        }
+    }
+    free(job_id_copy);
+
+    if (watch->pid_count > 0 && watch->done_count == watch->pid_count)
+    {
+        /* Already exited, nothing will ever wake us up for this one */
+        event = globus_l_gram_fork_done_event(job_id);
+        if (event != NULL)
+        {
+            globus_fifo_enqueue(&manager->fork_done_events, event);
+
+            GlobusTimeReltimeSet(delay, 0, 0);
+            globus_callback_register_oneshot(
+                    NULL,
+                    &delay,
+                    globus_l_gram_fork_done_callback,
+                    manager);
+        }
+        globus_l_gram_fork_watch_free(manager, watch);
+        return GLOBUS_SUCCESS;
+    }
+
+    rc = globus_hashtable_insert(
+            &manager->fork_watch_hash,
+            watch->job_id,
+            watch);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto hash_insert_failed;
+    }
+
+    return GLOBUS_SUCCESS;
+
+pidfd_open_failed:
+copy_failed:
+    free(job_id_copy);
+hash_insert_failed:
+    globus_l_gram_fork_watch_free(manager, watch);
+watch_malloc_failed:
+    globus_gram_job_manager_log(
+            manager,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+            "event=gram.fork_watch.end "
+            "level=WARN "
+            "jobid=\"%s\" "
+            "status=%d "
+            "errno=%d "
+            "reason=\"%s\" "
+            "\n",
+            job_id,
+            -rc,
+            errno,
+            globus_gram_protocol_error_string(rc));
+
+    /* Make sure this job is still noticed when it finishes */
+    if (manager->fork_callback_handle == GLOBUS_NULL_HANDLE)
+    {
+        GlobusTimeReltimeSet(delay, 1, 0);
+
+        globus_callback_register_periodic(
+                &manager->fork_callback_handle,
+                &delay,
+                &delay,
+                globus_l_gram_fork_poll_callback,
+                manager);
+    }
+#endif /* GLOBUS_L_GRAM_FORK_PIDFD */
+
+    return rc;
+}
+/* globus_gram_job_manager_seg_fork_watch() */
+
+/**
+ * @brief
+ * Stop watching the processes of a fork job
+ *
+ * @details
+ * Called with the manager lock held when a job id is unregistered.
+ */
+void
+globus_gram_job_manager_seg_fork_unwatch(
+    globus_gram_job_manager_t *         manager,
+    const char *                        job_id)
+{
+#ifdef GLOBUS_L_GRAM_FORK_PIDFD
+    globus_l_gram_fork_watch_t *        watch;
+
+    if (manager->fork_event_fd == -1)
+    {
+        return;
+    }
+    watch = globus_hashtable_remove(&manager->fork_watch_hash, (void *) job_id);
+    if (watch != NULL)
+    {
+        globus_l_gram_fork_watch_free(manager, watch);
+    }
+#endif
+}
+/* globus_gram_job_manager_seg_fork_unwatch() */
 
 /**
  * @brief
  * Condor SEG-like periodic callback
  *
  * @details
- * This function is called periodically to check for condor state changes by
- * polling the condor log files for the jobs. This code assumes that
+ * This function is called periodically, or when a condor log file in the
+ * job state directory changes, to check for condor state changes in the
+ * condor log files for the jobs. This code assumes that
  * - The condor log files can be located in $job_state_file_dir/condor.$uniq_id
  * - The condor log files are in (pseudo) XML format
  * - The condor log files are owned by the user whose job is being logged
@@ -1091,7 +1823,21 @@ read_failed:
     {
         GlobusTimeReltimeSet(delay, (time_t) 5, 0);
     }
-    globus_callback_adjust_period(manager->fork_callback_handle, &delay);
+    if (manager->condor_tail != NULL)
+    {
+        /* Fails only if the tail is being destroyed by
+         * globus_gram_job_manager_shutdown_seg()
+         */
+        (void) globus_scheduler_event_generator_tail_register(
+                manager->condor_tail,
+                &delay,
+                globus_l_gram_condor_poll_callback,
+                manager);
+    }
+    else
+    {
+        globus_callback_adjust_period(manager->fork_callback_handle, &delay);
+    }
     GlobusGramJobManagerUnlock(manager);
 
     while (!globus_fifo_empty(&events))
@@ -845,7 +845,7 @@ globus_l_gram_job_manager_state_machine(
         
         if(request->job_state_file)
         {
-            remove(request->job_state_file);
+            globus_gram_job_manager_state_file_remove(request);
         }
         globus_l_gram_job_manager_cancel_queries(request);
 
@@ -867,7 +867,7 @@ globus_l_gram_job_manager_state_machine(
       case GLOBUS_GRAM_JOB_MANAGER_STATE_FAILED_DONE:
         if(request->job_state_file)
         {
-            remove(request->job_state_file);
+            globus_gram_job_manager_state_file_remove(request);
         }
         globus_l_gram_job_manager_cancel_queries(request);
         /* Write auditing file if job is DONE or FAILED */
@@ -17,6 +17,183 @@
 #include "globus_gram_job_manager.h"
 
 #include <string.h>
+#include <sys/uio.h>
+
+#define GLOBUS_L_GRAM_JOURNAL_NAME "journal"
+#define GLOBUS_L_GRAM_JOURNAL_MAGIC "GJ1"
+/* Longest allowed record header line, including the state file name */
+#define GLOBUS_L_GRAM_JOURNAL_HEADER_MAX 256
+/*
+ * Rewrite the journal with only the newest record for each job once it is
+ * at least this large and this many times larger than those records
+ */
+#define GLOBUS_L_GRAM_JOURNAL_COMPACT_SIZE (1024 * 1024)
+#define GLOBUS_L_GRAM_JOURNAL_COMPACT_RATIO 4
+
+/*
+ * The state journal replaces the temp file, fsync, and rename done for each
+ * update of a job's state file with an append to one file shared by all of
+ * the jobs in the job manager's per-user state directory. Each record is a
+ * header line
+ *
+ *     GJ1 <W|D> <crc32> <length> <state file name>
+ *
+ * followed by <length> bytes of state file contents. A W record replaces
+ * the job's state and a D record removes it. Records appended while another
+ * thread is in fsync() are made durable by the next single fsync(), and a
+ * torn record at the end of the file is discarded when the journal is
+ * opened.
+ */
+struct globus_gram_job_manager_state_journal_s
+{
+    globus_mutex_t                      mutex;
+    globus_cond_t                       cond;
+    /* Directory containing the journal and the state files it replaces */
+    char *                              dir;
+    char *                              path;
+    int                                 fd;
+    /* Offset of the end of the last complete record */
+    off_t                               size;
+    /* Total length of the newest record of each job */
+    off_t                               live_size;
+    /* State file name -> globus_l_gram_journal_record_t */
+    globus_hashtable_t                  records;
+    /* Count of records appended, and how many of those are on disk */
+    uint64_t                            written;
+    uint64_t                            synced;
+    /*
+     * Records up to this count were appended before an fsync() failed. A
+     * later fsync() can succeed without them reaching the disk.
+     */
+    uint64_t                            failed;
+    /* GLOBUS_TRUE while a thread is in fsync() without the mutex */
+    globus_bool_t                       syncing;
+};
+
+typedef struct
+{
+    char *                              name;
+    /* Location of the job's state file contents in the journal */
+    off_t                               offset;
+    size_t                              length;
+    /* Length of the record including its header */
+    size_t                              record_length;
+    /* Location of the contents in a journal being compacted */
+    off_t                               compact_offset;
+}
+globus_l_gram_journal_record_t;
+
+static
+const char *
+globus_l_gram_state_journal_name(
+    globus_gram_jobmanager_request_t *  request);
+
+static
+int
+globus_l_gram_state_journal_write(
+    globus_gram_jobmanager_request_t *  request);
+
+static
+int
+globus_l_gram_state_journal_read(
+    globus_gram_jobmanager_request_t *  request,
+    char **                             data,
+    size_t *                            length);
+
+static
+int
+globus_l_gram_journal_append(
+    globus_gram_jobmanager_request_t *  request,
+    char                                type,
+    const char *                        name,
+    const char *                        data,
+    size_t                              length,
+    globus_bool_t *                     first);
+
+static
+int
+globus_l_gram_journal_index(
+    globus_gram_job_manager_state_journal_t *
+                                        journal,
+    char                                type,
+    const char *                        name,
+    off_t                               offset,
+    size_t                              length,
+    size_t                              record_length,
+    globus_bool_t *                     first);
+
+static
+int
+globus_l_gram_journal_compact(
+    globus_gram_job_manager_state_journal_t *
+                                        journal);
+
+static
+int
+globus_l_gram_journal_export(
+    globus_gram_job_manager_state_journal_t *
+                                        journal);
+
+static
+void
+globus_l_gram_journal_destroy(
+    globus_gram_job_manager_state_journal_t *
+                                        journal);
+
+static
+void
+globus_l_gram_journal_record_free(
+    void *                              datum);
+
+static
+int
+globus_l_gram_journal_header(
+    char *                              header,
+    char                                type,
+    const char *                        name,
+    const char *                        data,
+    size_t                              length);
+
+static
+int
+globus_l_gram_journal_parse(
+    const char *                        data,
+    size_t                              data_length,
+    size_t *                            pos,
+    char *                              type,
+    char *                              name,
+    size_t *                            offset,
+    size_t *                            length);
+
+static
+int
+globus_l_gram_journal_load(
+    int                                 fd,
+    char **                             data,
+    size_t *                            length);
+
+static
+int
+globus_l_gram_journal_pread(
+    int                                 fd,
+    off_t                               offset,
+    size_t                              length,
+    char **                             data);
+
+static
+int
+globus_l_gram_journal_writev(
+    int                                 fd,
+    struct iovec *                      iov,
+    int                                 iovcnt);
+
+static
+uint32_t
+globus_l_gram_journal_crc(
+    uint32_t                            crc,
+    const char *                        data,
+    size_t                              length);
+
 
 
 /**
@@ -90,64 +267,30 @@ create_state_file_failed:
 }
 /* globus_gram_job_manager_state_file_set() */
 
+/**
+ * Write the contents of a job state file
+ *
+ * @param request
+ *     The request to write the state of.
+ * @param fp
+ *     Stream to write the state to.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE
+ *     Error writing state.
+ */
+static
 int
-globus_gram_job_manager_state_file_write(
-    globus_gram_jobmanager_request_t *  request)
+globus_l_gram_state_file_print(
+    globus_gram_jobmanager_request_t *  request,
+    FILE *                              fp)
 {
-    int                                 rc = GLOBUS_SUCCESS;
-    FILE *                              fp = NULL;
-    char                                tmp_file[1024] = { 0 };
-
-    globus_gram_job_manager_request_log(
-            request,
-            GLOBUS_GRAM_JOB_MANAGER_LOG_TRACE,
-            "event=gram.write_state_file.start "
-            "level=TRACE "
-            "gramid=%s "
-            "path=\"%s\" "
-            "\n",
-            request->job_contact_path,
-            request->job_state_file);
-
-    /*
-     * We want the file update to be atomic, so create a new temp file,
-     * write the new information, close the new file, then rename the new
-     * file on top of the old one. The rename is the atomic update action.
-     */
-    strcpy( tmp_file, request->job_state_file );
-    strcat( tmp_file, ".tmp" );
-
-    fp = fopen( tmp_file, "w" );
-    if ( fp == NULL )
-    {
-        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
-
-        globus_gram_job_manager_request_log(
-                request,
-                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
-                "event=gram.write_state_file.end "
-                "level=ERROR "
-                "gramid=%s "
-                "path=\"%s\" "
-                "status=%d "
-                "msg=\"%s\" "
-                "errno=%d "
-                "reason=\"%s\"\n",
-                request->job_contact_path,
-                tmp_file,
-                -rc,
-                "Error opening state file",
-                errno,
-                strerror(errno));
-
-        return rc;
-    }
+    int                                 rc;
 
     rc = fprintf(fp, "%s\n", request->job_contact ? request->job_contact : " ");
     if (rc < 0)
     {
-        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
-
         goto error_exit;
     }
     rc = fprintf(fp, "%4d\n",
@@ -316,7 +459,76 @@ globus_gram_job_manager_state_file_write(
         goto error_exit;
     }
 
+    return GLOBUS_SUCCESS;
+
+error_exit:
+    return GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+}
+/* globus_l_gram_state_file_print() */
+
+int
+globus_gram_job_manager_state_file_write(
+    globus_gram_jobmanager_request_t *  request)
+{
+    int                                 rc = GLOBUS_SUCCESS;
+    FILE *                              fp = NULL;
+    char                                tmp_file[1024] = { 0 };
+
+    globus_gram_job_manager_request_log(
+            request,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_TRACE,
+            "event=gram.write_state_file.start "
+            "level=TRACE "
+            "gramid=%s "
+            "path=\"%s\" "
+            "\n",
+            request->job_contact_path,
+            request->job_state_file);
+
+    if (globus_l_gram_state_journal_name(request) != NULL)
+    {
+        return globus_l_gram_state_journal_write(request);
+    }
+
+    /*
+     * We want the file update to be atomic, so create a new temp file,
+     * write the new information, close the new file, then rename the new
+     * file on top of the old one. The rename is the atomic update action.
+     */
+    strcpy( tmp_file, request->job_state_file );
+    strcat( tmp_file, ".tmp" );
+
+    fp = fopen( tmp_file, "w" );
+    if ( fp == NULL )
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        globus_gram_job_manager_request_log(
+                request,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.write_state_file.end "
+                "level=ERROR "
+                "gramid=%s "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "errno=%d "
+                "reason=\"%s\"\n",
+                request->job_contact_path,
+                tmp_file,
+                -rc,
+                "Error opening state file",
+                errno,
+                strerror(errno));
+
+        return rc;
+    }
 
+    rc = globus_l_gram_state_file_print(request, fp);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto error_exit;
+    }
 
     /*
      * On some filsystems, write + rename is *not* atomic, so we explicitly
@@ -402,6 +614,7 @@ globus_gram_job_manager_state_file_read(
 {
     FILE *                              fp;
     char *                              buffer = NULL;
+    char *                              journal_data = NULL;
     size_t                              file_len;
     struct stat                         statbuf;
     int                                 rc = GLOBUS_SUCCESS;
@@ -421,57 +634,68 @@ globus_gram_job_manager_state_file_read(
             request->job_contact_path,
             request->job_state_file);
 
-    if (stat(request->job_state_file, &statbuf) != 0)
+    rc = globus_l_gram_state_journal_read(request, &journal_data, &file_len);
+    if (rc == GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE)
     {
-        rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
-
-        globus_gram_job_manager_request_log(
-                request,
-                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
-                "event=gram.state_file_read.end "
-                "level=ERROR "
-                "gramid=%s "
-                "path=%s "
-                "msg=\"%s\" "
-                "status=%d "
-                "errno=%d "
-                "reason=\"%s\" "
-                "\n",
-                request->job_contact_path,
-                request->job_state_file,
-                "Error checking file status",
-                -rc,
-                errno,
-                strerror(errno));
+        /* Not journaled, look for a state file of its own */
+        rc = GLOBUS_SUCCESS;
 
-        return rc;
+        if (stat(request->job_state_file, &statbuf) != 0)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
+
+            globus_gram_job_manager_request_log(
+                    request,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                    "event=gram.state_file_read.end "
+                    "level=ERROR "
+                    "gramid=%s "
+                    "path=%s "
+                    "msg=\"%s\" "
+                    "status=%d "
+                    "errno=%d "
+                    "reason=\"%s\" "
+                    "\n",
+                    request->job_contact_path,
+                    request->job_state_file,
+                    "Error checking file status",
+                    -rc,
+                    errno,
+                    strerror(errno));
+
+            return rc;
+        }
+        if (statbuf.st_uid != getuid())
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
+
+            globus_gram_job_manager_request_log(
+                    request,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                    "event=gram.state_file_read.end "
+                    "level=ERROR "
+                    "gramid=%s "
+                    "path=%s "
+                    "msg=\"%s\" "
+                    "status=%d "
+                    "errno=%d "
+                    "reason=\"%s\" "
+                    "\n",
+                    request->job_contact_path,
+                    request->job_state_file,
+                    "State file not owned by me",
+                    -rc,
+                    errno,
+                    strerror(errno));
+
+            return rc;
+        }
+        file_len = (size_t) statbuf.st_size;
     }
-    if (statbuf.st_uid != getuid())
+    else if (rc != GLOBUS_SUCCESS)
     {
-        rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
-
-        globus_gram_job_manager_request_log(
-                request,
-                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
-                "event=gram.state_file_read.end "
-                "level=ERROR "
-                "gramid=%s "
-                "path=%s "
-                "msg=\"%s\" "
-                "status=%d "
-                "errno=%d "
-                "reason=\"%s\" "
-                "\n",
-                request->job_contact_path,
-                request->job_state_file,
-                "State file not owned by me",
-                -rc,
-                errno,
-                strerror(errno));
-
         return rc;
     }
-    file_len = (size_t) statbuf.st_size;
     buffer = malloc(file_len+1);
     if (buffer == NULL)
     {
@@ -498,7 +722,14 @@ globus_gram_job_manager_state_file_read(
         goto exit;
     }
 
-    fp = fopen( request->job_state_file, "r" );
+    if (journal_data != NULL)
+    {
+        fp = fmemopen(journal_data, file_len, "r");
+    }
+    else
+    {
+        fp = fopen( request->job_state_file, "r" );
+    }
     if(!fp)
     {
         rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
@@ -779,6 +1010,10 @@ globus_gram_job_manager_state_file_read(
     fclose(fp);
 
     free(buffer);
+    if (journal_data != NULL)
+    {
+        free(journal_data);
+    }
 
     globus_gram_job_manager_request_log(
             request,
@@ -876,6 +1111,10 @@ fopen_state_file_failed:
         free(buffer);
     }
 exit:
+    if (journal_data != NULL)
+    {
+        free(journal_data);
+    }
     return rc;
 }
 /* globus_gram_job_manager_state_file_read() */
@@ -921,3 +1160,1364 @@ globus_gram_job_manager_file_lock(
     return rc;
 }
 /* globus_gram_job_manager_file_lock() */
+
+/**
+ * Remove a job's state
+ *
+ * Writes a removal record to the state journal if the job's state is
+ * journaled, and removes the job's state file if it has one.
+ *
+ * @param request
+ *     The request whose state is no longer needed.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE
+ *     Error writing to the state journal.
+ */
+int
+globus_gram_job_manager_state_file_remove(
+    globus_gram_jobmanager_request_t *  request)
+{
+    int                                 rc = GLOBUS_SUCCESS;
+    const char *                        name;
+
+    name = globus_l_gram_state_journal_name(request);
+    if (name != NULL)
+    {
+        rc = globus_l_gram_journal_append(request, 'D', name, "", 0, NULL);
+        if (rc != GLOBUS_SUCCESS)
+        {
+            globus_gram_job_manager_request_log(
+                    request,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                    "event=gram.remove_state_file.end "
+                    "level=ERROR "
+                    "gramid=%s "
+                    "path=\"%s\" "
+                    "status=%d "
+                    "msg=\"%s\" "
+                    "\n",
+                    request->job_contact_path,
+                    request->manager->state_journal->path,
+                    -rc,
+                    "Error writing to state journal");
+        }
+    }
+    remove(request->job_state_file);
+
+    return rc;
+}
+/* globus_gram_job_manager_state_file_remove() */
+
+/**
+ * Open the state journal for a state file directory
+ *
+ * Reads the state journal in @a state_file_dir, creating it if it does not
+ * exist, discards any incomplete record at its end, and removes state files
+ * which have been replaced by journal records. If the journal is disabled in
+ * the job manager configuration, the journaled jobs' states are written back
+ * to their own state files and the journal is removed instead.
+ *
+ * @param manager
+ *     Job manager to set the state_journal of.
+ * @param state_file_dir
+ *     Directory containing the jobs' state files.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED
+ *     Malloc failed.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_READING_STATE_FILE
+ *     Error reading the journal.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE
+ *     Error writing the journal.
+ */
+int
+globus_gram_job_manager_state_journal_open(
+    globus_gram_job_manager_t *         manager,
+    const char *                        state_file_dir)
+{
+    int                                 rc = GLOBUS_SUCCESS;
+    globus_gram_job_manager_state_journal_t *
+                                        journal;
+    globus_l_gram_journal_record_t *    record;
+    char *                              data = NULL;
+    size_t                              length = 0;
+    size_t                              pos = 0;
+    size_t                              start;
+    size_t                              offset;
+    size_t                              record_length;
+    char                                type;
+    char                                name[GLOBUS_L_GRAM_JOURNAL_HEADER_MAX];
+    char *                              state_file;
+
+    journal = calloc(1, sizeof(globus_gram_job_manager_state_journal_t));
+    if (journal == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto journal_malloc_failed;
+    }
+    rc = globus_hashtable_init(
+            &journal->records,
+            64,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto hashtable_init_failed;
+    }
+    globus_mutex_init(&journal->mutex, NULL);
+    globus_cond_init(&journal->cond, NULL);
+    journal->fd = -1;
+
+    journal->dir = strdup(state_file_dir);
+    if (journal->dir == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto open_failed;
+    }
+    journal->path = globus_common_create_string(
+            "%s/%s",
+            journal->dir,
+            GLOBUS_L_GRAM_JOURNAL_NAME);
+    if (journal->path == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto open_failed;
+    }
+    globus_i_gram_mkdir(journal->dir);
+
+    journal->fd = open(
+            journal->path,
+            O_RDWR|O_CREAT|O_APPEND,
+            S_IRUSR|S_IWUSR);
+    if (journal->fd < 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.open.end "
+                "level=ERROR "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "errno=%d "
+                "reason=\"%s\" "
+                "\n",
+                journal->path,
+                -rc,
+                "Error opening state journal",
+                errno,
+                strerror(errno));
+        goto open_failed;
+    }
+    fcntl(journal->fd, F_SETFD, FD_CLOEXEC);
+
+    rc = globus_l_gram_journal_load(journal->fd, &data, &length);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.open.end "
+                "level=ERROR "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "reason=\"%s\" "
+                "\n",
+                journal->path,
+                -rc,
+                "Error reading state journal",
+                globus_gram_protocol_error_string(rc));
+        goto open_failed;
+    }
+
+    while (pos < length)
+    {
+        start = pos;
+        if (globus_l_gram_journal_parse(
+                data,
+                length,
+                &pos,
+                &type,
+                name,
+                &offset,
+                &record_length) != GLOBUS_SUCCESS)
+        {
+            break;
+        }
+        rc = globus_l_gram_journal_index(
+                journal,
+                type,
+                name,
+                (off_t) offset,
+                record_length,
+                pos - start,
+                NULL);
+        if (rc != GLOBUS_SUCCESS)
+        {
+            goto index_failed;
+        }
+    }
+    free(data);
+    data = NULL;
+
+    if (pos < length)
+    {
+        /* The job manager stopped while appending this record */
+        globus_gram_job_manager_log(
+                manager,
+                GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+                "event=gram.state_journal.open.info "
+                "level=WARN "
+                "path=\"%s\" "
+                "offset=%lu "
+                "msg=\"%s\" "
+                "\n",
+                journal->path,
+                (unsigned long) pos,
+                "Discarding incomplete journal record");
+
+        if (ftruncate(journal->fd, (off_t) pos) != 0)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+            goto index_failed;
+        }
+    }
+    journal->size = (off_t) pos;
+
+    if (manager->config->state_journal_disabled)
+    {
+        rc = globus_l_gram_journal_export(journal);
+        if (rc == GLOBUS_SUCCESS)
+        {
+            unlink(journal->path);
+        }
+        globus_gram_job_manager_log(
+                manager,
+                rc == GLOBUS_SUCCESS
+                    ? GLOBUS_GRAM_JOB_MANAGER_LOG_DEBUG
+                    : GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+                "event=gram.state_journal.open.end "
+                "level=%s "
+                "path=\"%s\" "
+                "status=%d "
+                "msg=\"%s\" "
+                "\n",
+                rc == GLOBUS_SUCCESS ? "DEBUG" : "ERROR",
+                journal->path,
+                -rc,
+                "Moved journaled job state to state files");
+        globus_l_gram_journal_destroy(journal);
+
+        return rc;
+    }
+
+    /*
+     * Journal records are only written once there is no job manager using
+     * state files in this directory, so any state file left for a journaled
+     * job is older than its journal record.
+     */
+    for (record = globus_hashtable_first(&journal->records);
+         record != NULL;
+         record = globus_hashtable_next(&journal->records))
+    {
+        state_file = globus_common_create_string(
+                "%s/%s",
+                journal->dir,
+                record->name);
+        if (state_file != NULL)
+        {
+            remove(state_file);
+            free(state_file);
+        }
+    }
+
+    if (journal->size > journal->live_size)
+    {
+        if (globus_l_gram_journal_compact(journal) != GLOBUS_SUCCESS)
+        {
+            globus_gram_job_manager_log(
+                    manager,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+                    "event=gram.state_journal.open.info "
+                    "level=WARN "
+                    "path=\"%s\" "
+                    "msg=\"%s\" "
+                    "\n",
+                    journal->path,
+                    "Error compacting state journal");
+        }
+    }
+    manager->state_journal = journal;
+
+    globus_gram_job_manager_log(
+            manager,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_DEBUG,
+            "event=gram.state_journal.open.end "
+            "level=DEBUG "
+            "path=\"%s\" "
+            "jobs=%d "
+            "size=%lu "
+            "status=%d "
+            "\n",
+            journal->path,
+            globus_hashtable_size(&journal->records),
+            (unsigned long) journal->size,
+            0);
+
+    return GLOBUS_SUCCESS;
+
+index_failed:
+    if (data != NULL)
+    {
+        free(data);
+    }
+open_failed:
+    globus_l_gram_journal_destroy(journal);
+    return rc;
+
+hashtable_init_failed:
+    free(journal);
+journal_malloc_failed:
+    return rc;
+}
+/* globus_gram_job_manager_state_journal_open() */
+
+/**
+ * Close the job manager's state journal
+ *
+ * @param manager
+ *     Job manager to close the state_journal of.
+ */
+void
+globus_gram_job_manager_state_journal_close(
+    globus_gram_job_manager_t *         manager)
+{
+    if (manager->state_journal != NULL)
+    {
+        globus_l_gram_journal_destroy(manager->state_journal);
+        manager->state_journal = NULL;
+    }
+}
+/* globus_gram_job_manager_state_journal_close() */
+
+/**
+ * List the jobs with state in the state journal
+ *
+ * @param manager
+ *     Job manager whose state_journal to list.
+ * @param state_files
+ *     Pointer to be set to a list of the state file names of the
+ *     journaled jobs. The caller must free the list and its contents.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED
+ *     Malloc failed.
+ */
+int
+globus_gram_job_manager_state_journal_list(
+    globus_gram_job_manager_t *         manager,
+    globus_list_t **                    state_files)
+{
+    globus_gram_job_manager_state_journal_t *
+                                        journal = manager->state_journal;
+    globus_l_gram_journal_record_t *    record;
+    char *                              name;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    *state_files = NULL;
+    if (journal == NULL)
+    {
+        return GLOBUS_SUCCESS;
+    }
+
+    globus_mutex_lock(&journal->mutex);
+    for (record = globus_hashtable_first(&journal->records);
+         record != NULL;
+         record = globus_hashtable_next(&journal->records))
+    {
+        name = strdup(record->name);
+        if (name == NULL || globus_list_insert(state_files, name) != 0)
+        {
+            if (name != NULL)
+            {
+                free(name);
+            }
+            globus_list_destroy_all(*state_files, free);
+            *state_files = NULL;
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+            break;
+        }
+    }
+    globus_mutex_unlock(&journal->mutex);
+
+    return rc;
+}
+/* globus_gram_job_manager_state_journal_list() */
+
+/**
+ * Return the name of a request's state file in the job manager's state
+ * journal, or NULL if its state is not journaled
+ */
+static
+const char *
+globus_l_gram_state_journal_name(
+    globus_gram_jobmanager_request_t *  request)
+{
+    globus_gram_job_manager_state_journal_t *
+                                        journal;
+    size_t                              dir_length;
+    const char *                        name;
+
+    if (request->manager == NULL ||
+        request->manager->state_journal == NULL ||
+        request->job_state_file == NULL)
+    {
+        return NULL;
+    }
+    journal = request->manager->state_journal;
+    dir_length = strlen(journal->dir);
+
+    if (strncmp(request->job_state_file, journal->dir, dir_length) != 0 ||
+        request->job_state_file[dir_length] != '/')
+    {
+        return NULL;
+    }
+    name = request->job_state_file + dir_length + 1;
+    if (*name == '\0' || strchr(name, '/') != NULL)
+    {
+        return NULL;
+    }
+
+    return name;
+}
+/* globus_l_gram_state_journal_name() */
+
+static
+int
+globus_l_gram_state_journal_write(
+    globus_gram_jobmanager_request_t *  request)
+{
+    int                                 rc;
+    FILE *                              fp;
+    char *                              data = NULL;
+    size_t                              length = 0;
+    globus_bool_t                       first = GLOBUS_FALSE;
+
+    fp = open_memstream(&data, &length);
+    if (fp == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto error_exit;
+    }
+    rc = globus_l_gram_state_file_print(request, fp);
+    if (fclose(fp) != 0 && rc == GLOBUS_SUCCESS)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+    }
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto error_exit;
+    }
+
+    rc = globus_l_gram_journal_append(
+            request,
+            'W',
+            globus_l_gram_state_journal_name(request),
+            data,
+            length,
+            &first);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto error_exit;
+    }
+    free(data);
+
+    if (first)
+    {
+        /* Replaced by the journal record */
+        remove(request->job_state_file);
+    }
+
+    globus_gram_job_manager_request_log(
+            request,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_TRACE,
+            "event=gram.write_state_file.end "
+            "level=TRACE "
+            "gramid=%s "
+            "path=%s "
+            "status=0 "
+            "\n",
+            request->job_contact_path,
+            request->manager->state_journal->path);
+
+    return GLOBUS_SUCCESS;
+
+error_exit:
+    globus_gram_job_manager_request_log(
+            request,
+            GLOBUS_GRAM_JOB_MANAGER_LOG_ERROR,
+            "event=gram.write_state_file.end "
+            "level=ERROR "
+            "gramid=%s "
+            "path=\"%s\" "
+            "status=%d "
+            "msg=\"%s\"\n",
+            request->job_contact_path,
+            request->manager->state_journal->path,
+            -rc,
+            "Error writing to state journal");
+    if (data != NULL)
+    {
+        free(data);
+    }
+
+    return rc;
+}
+/* globus_l_gram_state_journal_write() */
+
+/**
+ * Read a request's state from a state journal
+ *
+ * Uses the job manager's state journal if the request's state is journaled
+ * there. Otherwise, as in the streamer, scans the journal in the directory
+ * containing the request's state file, if there is one.
+ *
+ * @retval GLOBUS_SUCCESS
+ *     Success. The caller must free @a data.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE
+ *     No journal has state for this request.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED
+ *     Malloc failed.
+ * @retval GLOBUS_GRAM_PROTOCOL_ERROR_READING_STATE_FILE
+ *     Error reading the journal.
+ */
+static
+int
+globus_l_gram_state_journal_read(
+    globus_gram_jobmanager_request_t *  request,
+    char **                             data,
+    size_t *                            length)
+{
+    globus_gram_job_manager_state_journal_t *
+                                        journal;
+    globus_l_gram_journal_record_t *    record;
+    const char *                        name;
+    char *                              path;
+    char *                              journal_data;
+    char *                              journal_record;
+    size_t                              journal_length;
+    size_t                              pos = 0;
+    size_t                              offset;
+    size_t                              record_length;
+    char                                type;
+    char                                record_name[GLOBUS_L_GRAM_JOURNAL_HEADER_MAX];
+    globus_bool_t                       found = GLOBUS_FALSE;
+    int                                 fd;
+    int                                 rc;
+
+    *data = NULL;
+    *length = 0;
+
+    name = globus_l_gram_state_journal_name(request);
+    if (name != NULL)
+    {
+        journal = request->manager->state_journal;
+
+        globus_mutex_lock(&journal->mutex);
+        record = globus_hashtable_lookup(&journal->records, (void *) name);
+        if (record == NULL)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
+        }
+        else
+        {
+            rc = globus_l_gram_journal_pread(
+                    journal->fd,
+                    record->offset,
+                    record->length,
+                    data);
+            *length = record->length;
+        }
+        globus_mutex_unlock(&journal->mutex);
+
+        return rc;
+    }
+
+    if (request->job_state_file == NULL ||
+        (name = strrchr(request->job_state_file, '/')) == NULL)
+    {
+        return GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
+    }
+    path = globus_common_create_string(
+            "%.*s/%s",
+            (int) (name - request->job_state_file),
+            request->job_state_file,
+            GLOBUS_L_GRAM_JOURNAL_NAME);
+    name++;
+    if (path == NULL)
+    {
+        return GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+    }
+    fd = open(path, O_RDONLY);
+    free(path);
+    if (fd < 0)
+    {
+        return GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
+    }
+    rc = globus_l_gram_journal_load(fd, &journal_data, &journal_length);
+    close(fd);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        return GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
+    }
+
+    /* The newest complete record for the job wins */
+    while (globus_l_gram_journal_parse(
+            journal_data,
+            journal_length,
+            &pos,
+            &type,
+            record_name,
+            &offset,
+            &record_length) == GLOBUS_SUCCESS)
+    {
+        if (strcmp(record_name, name) == 0)
+        {
+            found = (type == 'W');
+            *length = record_length;
+            *data = journal_data + offset;
+        }
+    }
+    if (!found)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE;
+        *data = NULL;
+        *length = 0;
+    }
+    else
+    {
+        journal_record = *data;
+        *data = malloc(*length);
+        if (*data == NULL)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+            *length = 0;
+        }
+        else
+        {
+            memcpy(*data, journal_record, *length);
+        }
+    }
+    free(journal_data);
+
+    return rc;
+}
+/* globus_l_gram_state_journal_read() */
+
+/**
+ * Append a record to the job manager's state journal
+ *
+ * Returns once the record is on disk. A removal record is only written if
+ * the journal has state for the job.
+ *
+ * @param request
+ *     Request whose state is being written.
+ * @param type
+ *     'W' to replace the job's state with @a data, 'D' to remove it.
+ * @param name
+ *     Name of the job's state file.
+ * @param data
+ *     State file contents.
+ * @param length
+ *     Length of @a data.
+ * @param first
+ *     If not NULL, set to GLOBUS_TRUE if the journal had no state for the
+ *     job before this record.
+ */
+static
+int
+globus_l_gram_journal_append(
+    globus_gram_jobmanager_request_t *  request,
+    char                                type,
+    const char *                        name,
+    const char *                        data,
+    size_t                              length,
+    globus_bool_t *                     first)
+{
+    globus_gram_job_manager_state_journal_t *
+                                        journal;
+    char                                header[GLOBUS_L_GRAM_JOURNAL_HEADER_MAX];
+    int                                 header_length;
+    struct iovec                        iov[2];
+    uint64_t                            seq;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    journal = request->manager->state_journal;
+
+    header_length = globus_l_gram_journal_header(
+            header,
+            type,
+            name,
+            data,
+            length);
+    if (header_length < 0)
+    {
+        return GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+    }
+    iov[0].iov_base = header;
+    iov[0].iov_len = header_length;
+    iov[1].iov_base = (void *) data;
+    iov[1].iov_len = length;
+
+    globus_mutex_lock(&journal->mutex);
+    if (type == 'D' &&
+        globus_hashtable_lookup(&journal->records, (void *) name) == NULL)
+    {
+        goto unlock_exit;
+    }
+
+    rc = globus_l_gram_journal_writev(journal->fd, iov, 2);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        /* Don't leave part of a record for the next one to follow */
+        if (ftruncate(journal->fd, journal->size) != 0)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+        }
+        goto unlock_exit;
+    }
+    rc = globus_l_gram_journal_index(
+            journal,
+            type,
+            name,
+            journal->size + header_length,
+            length,
+            header_length + length,
+            first);
+    journal->size += header_length + length;
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto unlock_exit;
+    }
+
+    /*
+     * Group commit: if another thread is in fsync() wait for it, then one
+     * thread syncs every record appended in the meantime.
+     */
+    seq = ++journal->written;
+    while (journal->synced < seq && journal->failed < seq)
+    {
+        if (journal->syncing)
+        {
+            globus_cond_wait(&journal->cond, &journal->mutex);
+        }
+        else
+        {
+            uint64_t                    written = journal->written;
+            int                         fd = journal->fd;
+
+            journal->syncing = GLOBUS_TRUE;
+            globus_mutex_unlock(&journal->mutex);
+            rc = fsync(fd);
+            globus_mutex_lock(&journal->mutex);
+            journal->syncing = GLOBUS_FALSE;
+            globus_cond_broadcast(&journal->cond);
+
+            if (rc != 0)
+            {
+                /*
+                 * Fail every record appended so far: their pages may have
+                 * been lost with the error, and the next fsync() would not
+                 * report it again
+                 */
+                journal->failed = journal->written;
+            }
+            else if (journal->synced < written)
+            {
+                journal->synced = written;
+            }
+        }
+    }
+    if (journal->failed >= seq)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+        goto unlock_exit;
+    }
+
+    if (journal->size >= GLOBUS_L_GRAM_JOURNAL_COMPACT_SIZE &&
+        journal->size >
+                GLOBUS_L_GRAM_JOURNAL_COMPACT_RATIO * journal->live_size)
+    {
+        while (journal->syncing)
+        {
+            globus_cond_wait(&journal->cond, &journal->mutex);
+        }
+        if (globus_l_gram_journal_compact(journal) != GLOBUS_SUCCESS)
+        {
+            globus_gram_job_manager_request_log(
+                    request,
+                    GLOBUS_GRAM_JOB_MANAGER_LOG_WARN,
+                    "event=gram.write_state_file.info "
+                    "level=WARN "
+                    "gramid=%s "
+                    "path=\"%s\" "
+                    "msg=\"%s\" "
+                    "\n",
+                    request->job_contact_path,
+                    journal->path,
+                    "Error compacting state journal");
+        }
+    }
+
+unlock_exit:
+    globus_mutex_unlock(&journal->mutex);
+
+    return rc;
+}
+/* globus_l_gram_journal_append() */
+
+/**
+ * Update the journal index for a record
+ */
+static
+int
+globus_l_gram_journal_index(
+    globus_gram_job_manager_state_journal_t *
+                                        journal,
+    char                                type,
+    const char *                        name,
+    off_t                               offset,
+    size_t                              length,
+    size_t                              record_length,
+    globus_bool_t *                     first)
+{
+    globus_l_gram_journal_record_t *    record;
+
+    record = globus_hashtable_lookup(&journal->records, (void *) name);
+    if (first != NULL)
+    {
+        *first = (record == NULL);
+    }
+    if (record != NULL)
+    {
+        journal->live_size -= record->record_length;
+    }
+
+    if (type == 'D')
+    {
+        if (record != NULL)
+        {
+            globus_hashtable_remove(&journal->records, record->name);
+            globus_l_gram_journal_record_free(record);
+        }
+        return GLOBUS_SUCCESS;
+    }
+
+    if (record == NULL)
+    {
+        record = calloc(1, sizeof(globus_l_gram_journal_record_t));
+        if (record == NULL)
+        {
+            return GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        }
+        record->name = strdup(name);
+        if (record->name == NULL ||
+            globus_hashtable_insert(
+                    &journal->records,
+                    record->name,
+                    record) != GLOBUS_SUCCESS)
+        {
+            globus_l_gram_journal_record_free(record);
+            return GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        }
+    }
+    record->offset = offset;
+    record->length = length;
+    record->record_length = record_length;
+    journal->live_size += record_length;
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_l_gram_journal_index() */
+
+/**
+ * Rewrite the journal with only the newest record for each job
+ *
+ * Called with the journal mutex held and no fsync() in progress.
+ */
+static
+int
+globus_l_gram_journal_compact(
+    globus_gram_job_manager_state_journal_t *
+                                        journal)
+{
+    globus_l_gram_journal_record_t *    record;
+    char *                              tmp_path;
+    char *                              data;
+    char                                header[GLOBUS_L_GRAM_JOURNAL_HEADER_MAX];
+    int                                 header_length;
+    struct iovec                        iov[2];
+    off_t                               size = 0;
+    int                                 fd;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    tmp_path = globus_common_create_string("%s.tmp", journal->path);
+    if (tmp_path == NULL)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+        goto tmp_path_failed;
+    }
+    fd = open(tmp_path, O_RDWR|O_CREAT|O_TRUNC|O_APPEND, S_IRUSR|S_IWUSR);
+    if (fd < 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+        goto open_failed;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    for (record = globus_hashtable_first(&journal->records);
+         record != NULL;
+         record = globus_hashtable_next(&journal->records))
+    {
+        rc = globus_l_gram_journal_pread(
+                journal->fd,
+                record->offset,
+                record->length,
+                &data);
+        if (rc != GLOBUS_SUCCESS)
+        {
+            goto write_failed;
+        }
+        header_length = globus_l_gram_journal_header(
+                header,
+                'W',
+                record->name,
+                data,
+                record->length);
+        iov[0].iov_base = header;
+        iov[0].iov_len = header_length;
+        iov[1].iov_base = data;
+        iov[1].iov_len = record->length;
+
+        rc = globus_l_gram_journal_writev(fd, iov, 2);
+        free(data);
+        if (rc != GLOBUS_SUCCESS)
+        {
+            goto write_failed;
+        }
+        record->compact_offset = size + header_length;
+        size += header_length + record->length;
+    }
+
+    if (fsync(fd) != 0 || rename(tmp_path, journal->path) != 0)
+    {
+        rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+        goto write_failed;
+    }
+
+    for (record = globus_hashtable_first(&journal->records);
+         record != NULL;
+         record = globus_hashtable_next(&journal->records))
+    {
+        record->offset = record->compact_offset;
+    }
+    close(journal->fd);
+    journal->fd = fd;
+    journal->size = size;
+    journal->live_size = size;
+    journal->synced = journal->written;
+    free(tmp_path);
+
+    return GLOBUS_SUCCESS;
+
+write_failed:
+    close(fd);
+    unlink(tmp_path);
+open_failed:
+    free(tmp_path);
+tmp_path_failed:
+    return rc;
+}
+/* globus_l_gram_journal_compact() */
+
+/**
+ * Write the newest state of each journaled job to its own state file
+ */
+static
+int
+globus_l_gram_journal_export(
+    globus_gram_job_manager_state_journal_t *
+                                        journal)
+{
+    globus_l_gram_journal_record_t *    record;
+    char *                              state_file;
+    char *                              tmp_file;
+    char *                              data;
+    struct iovec                        iov;
+    int                                 fd;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    for (record = globus_hashtable_first(&journal->records);
+         record != NULL && rc == GLOBUS_SUCCESS;
+         record = globus_hashtable_next(&journal->records))
+    {
+        state_file = globus_common_create_string(
+                "%s/%s",
+                journal->dir,
+                record->name);
+        tmp_file = globus_common_create_string(
+                "%s/%s.tmp",
+                journal->dir,
+                record->name);
+        if (state_file == NULL || tmp_file == NULL)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+            goto free_paths;
+        }
+        rc = globus_l_gram_journal_pread(
+                journal->fd,
+                record->offset,
+                record->length,
+                &data);
+        if (rc != GLOBUS_SUCCESS)
+        {
+            goto free_paths;
+        }
+        fd = open(tmp_file, O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
+        if (fd < 0)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+            goto free_data;
+        }
+        iov.iov_base = data;
+        iov.iov_len = record->length;
+        rc = globus_l_gram_journal_writev(fd, &iov, 1);
+        if (rc == GLOBUS_SUCCESS && fsync(fd) != 0)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+        }
+        close(fd);
+        if (rc == GLOBUS_SUCCESS && rename(tmp_file, state_file) != 0)
+        {
+            rc = GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+        }
+        if (rc != GLOBUS_SUCCESS)
+        {
+            unlink(tmp_file);
+        }
+free_data:
+        free(data);
+free_paths:
+        if (state_file != NULL)
+        {
+            free(state_file);
+        }
+        if (tmp_file != NULL)
+        {
+            free(tmp_file);
+        }
+    }
+
+    return rc;
+}
+/* globus_l_gram_journal_export() */
+
+static
+void
+globus_l_gram_journal_destroy(
+    globus_gram_job_manager_state_journal_t *
+                                        journal)
+{
+    globus_mutex_lock(&journal->mutex);
+    while (journal->syncing)
+    {
+        globus_cond_wait(&journal->cond, &journal->mutex);
+    }
+    globus_mutex_unlock(&journal->mutex);
+
+    if (journal->fd >= 0)
+    {
+        close(journal->fd);
+    }
+    globus_hashtable_destroy_all(
+            &journal->records,
+            globus_l_gram_journal_record_free);
+    globus_cond_destroy(&journal->cond);
+    globus_mutex_destroy(&journal->mutex);
+    if (journal->path != NULL)
+    {
+        free(journal->path);
+    }
+    if (journal->dir != NULL)
+    {
+        free(journal->dir);
+    }
+    free(journal);
+}
+/* globus_l_gram_journal_destroy() */
+
+static
+void
+globus_l_gram_journal_record_free(
+    void *                              datum)
+{
+    globus_l_gram_journal_record_t *    record = datum;
+
+    if (record->name != NULL)
+    {
+        free(record->name);
+    }
+    free(record);
+}
+/* globus_l_gram_journal_record_free() */
+
+/**
+ * Format a record header, returning its length or -1 if the name is too
+ * long
+ */
+static
+int
+globus_l_gram_journal_header(
+    char *                              header,
+    char                                type,
+    const char *                        name,
+    const char *                        data,
+    size_t                              length)
+{
+    uint32_t                            crc;
+    int                                 rc;
+
+    crc = globus_l_gram_journal_crc(0, name, strlen(name));
+    crc = globus_l_gram_journal_crc(crc, data, length);
+
+    rc = snprintf(
+            header,
+            GLOBUS_L_GRAM_JOURNAL_HEADER_MAX,
+            "%s %c %08lx %lu %s\n",
+            GLOBUS_L_GRAM_JOURNAL_MAGIC,
+            type,
+            (unsigned long) crc,
+            (unsigned long) length,
+            name);
+    if (rc < 0 || rc >= GLOBUS_L_GRAM_JOURNAL_HEADER_MAX)
+    {
+        return -1;
+    }
+
+    return rc;
+}
+/* globus_l_gram_journal_header() */
+
+/**
+ * Parse the record at *pos in journal contents
+ *
+ * On success, sets @a type, @a name (which must be
+ * GLOBUS_L_GRAM_JOURNAL_HEADER_MAX bytes long) and the offset and length of
+ * the record contents, and advances @a pos to the next record. Fails if the
+ * record is incomplete or corrupt.
+ */
+static
+int
+globus_l_gram_journal_parse(
+    const char *                        data,
+    size_t                              data_length,
+    size_t *                            pos,
+    char *                              type,
+    char *                              name,
+    size_t *                            offset,
+    size_t *                            length)
+{
+    char                                header[GLOBUS_L_GRAM_JOURNAL_HEADER_MAX];
+    const char *                        eol;
+    size_t                              header_length;
+    unsigned long                       crc;
+    unsigned long                       record_length;
+    int                                 name_start = -1;
+    int                                 name_end = -1;
+
+    eol = memchr(data + *pos, '\n', data_length - *pos);
+    if (eol == NULL)
+    {
+        return GLOBUS_FAILURE;
+    }
+    header_length = eol - (data + *pos) + 1;
+    if (header_length >= GLOBUS_L_GRAM_JOURNAL_HEADER_MAX)
+    {
+        return GLOBUS_FAILURE;
+    }
+    memcpy(header, data + *pos, header_length - 1);
+    header[header_length - 1] = '\0';
+
+    if (sscanf(header,
+                GLOBUS_L_GRAM_JOURNAL_MAGIC " %c %8lx %lu %n%*s%n",
+                type,
+                &crc,
+                &record_length,
+                &name_start,
+                &name_end) != 3 ||
+        name_end < 0 ||
+        header[name_end] != '\0' ||
+        (*type != 'W' && *type != 'D') ||
+        record_length > data_length - *pos - header_length)
+    {
+        return GLOBUS_FAILURE;
+    }
+    strcpy(name, header + name_start);
+
+    if (crc != globus_l_gram_journal_crc(
+                globus_l_gram_journal_crc(0, name, strlen(name)),
+                data + *pos + header_length,
+                record_length))
+    {
+        return GLOBUS_FAILURE;
+    }
+    *offset = *pos + header_length;
+    *length = record_length;
+    *pos = *offset + record_length;
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_l_gram_journal_parse() */
+
+/**
+ * Read a whole journal into memory, ignoring journals owned by other users
+ */
+static
+int
+globus_l_gram_journal_load(
+    int                                 fd,
+    char **                             data,
+    size_t *                            length)
+{
+    struct stat                         statbuf;
+    int                                 rc;
+
+    *data = NULL;
+    *length = 0;
+
+    if (fstat(fd, &statbuf) != 0 || statbuf.st_uid != getuid())
+    {
+        return GLOBUS_GRAM_PROTOCOL_ERROR_READING_STATE_FILE;
+    }
+    rc = globus_l_gram_journal_pread(fd, 0, (size_t) statbuf.st_size, data);
+    if (rc == GLOBUS_SUCCESS)
+    {
+        *length = (size_t) statbuf.st_size;
+    }
+
+    return rc;
+}
+/* globus_l_gram_journal_load() */
+
+/**
+ * Read length bytes at offset into a new buffer
+ */
+static
+int
+globus_l_gram_journal_pread(
+    int                                 fd,
+    off_t                               offset,
+    size_t                              length,
+    char **                             data)
+{
+    size_t                              done = 0;
+    ssize_t                             rc;
+
+    /* Extra byte so an empty journal still gets a buffer */
+    *data = malloc(length + 1);
+    if (*data == NULL)
+    {
+        return GLOBUS_GRAM_PROTOCOL_ERROR_MALLOC_FAILED;
+    }
+    while (done < length)
+    {
+        rc = pread(fd, *data + done, length - done, offset + done);
+        if (rc < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (rc <= 0)
+        {
+            free(*data);
+            *data = NULL;
+
+            return GLOBUS_GRAM_PROTOCOL_ERROR_READING_STATE_FILE;
+        }
+        done += rc;
+    }
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_l_gram_journal_pread() */
+
+static
+int
+globus_l_gram_journal_writev(
+    int                                 fd,
+    struct iovec *                      iov,
+    int                                 iovcnt)
+{
+    ssize_t                             rc;
+
+    while (iovcnt > 0)
+    {
+        rc = writev(fd, iov, iovcnt);
+        if (rc < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (rc < 0)
+        {
+            return GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE;
+        }
+        while (iovcnt > 0 && (size_t) rc >= iov->iov_len)
+        {
+            rc -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (char *) iov->iov_base + rc;
+            iov->iov_len -= rc;
+        }
+    }
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_l_gram_journal_writev() */
+
+/**
+ * Update a CRC-32 (IEEE 802.3) with length bytes of data
+ */
+static
+uint32_t
+globus_l_gram_journal_crc(
+    uint32_t                            crc,
+    const char *                        data,
+    size_t                              length)
+{
+    size_t                              i;
+    int                                 j;
+
+    crc = ~crc;
+    for (i = 0; i < length; i++)
+    {
+        crc ^= (unsigned char) data[i];
+        for (j = 0; j < 8; j++)
+        {
+            crc = (crc >> 1) ^ (0xedb88320U & (0U - (crc & 1)));
+        }
+    }
+
+    return ~crc;
+}
+/* globus_l_gram_journal_crc() */
@@ -78,8 +78,6 @@ typedef struct
     struct tm                           start_timestamp;
     /** Stdio file handle of the log file */
     FILE *                              fp;
-    /** Callback for periodic file polling */
-    globus_callback_handle_t            callback;
     /**
      * Flag inidicating that this logfile isn't the one corresponding to
      * today, so and EOF on it should require us to close and open a newer
@@ -97,6 +95,8 @@ static globus_mutex_t                   globus_l_job_manager_mutex;
 static globus_cond_t                    globus_l_job_manager_cond;
 static globus_bool_t                    shutdown_called;
 static int                              callback_count;
+static globus_scheduler_event_generator_tail_t
+                                        globus_l_job_manager_tail;
 
 
 GlobusDebugDefine(SEG_JOB_MANAGER);
@@ -264,8 +264,17 @@ globus_l_job_manager_module_activate(void)
         goto bad_log_path;
     }
 
-    result = globus_callback_register_oneshot(
-            &logfile_state->callback,
+    result = globus_scheduler_event_generator_tail_init(
+            &globus_l_job_manager_tail,
+            logfile_state->log_dir,
+            NULL);
+    if (result != GLOBUS_SUCCESS)
+    {
+        goto tail_init_failed;
+    }
+
+    result = globus_scheduler_event_generator_tail_register(
+            globus_l_job_manager_tail,
             &delay,
             globus_l_job_manager_poll_callback,
             logfile_state);
@@ -277,6 +286,9 @@ globus_l_job_manager_module_activate(void)
 
     return 0;
 oneshot_failed:
+    globus_scheduler_event_generator_tail_destroy(globus_l_job_manager_tail);
+    globus_l_job_manager_tail = NULL;
+tail_init_failed:
     if (logfile_state->fp)
     {
         fclose(logfile_state->fp);
@@ -310,6 +322,7 @@ globus_l_job_manager_module_deactivate(void)
 {
     globus_mutex_lock(&globus_l_job_manager_mutex);
     shutdown_called = GLOBUS_TRUE;
+    globus_scheduler_event_generator_tail_wakeup(globus_l_job_manager_tail);
 
     while (callback_count > 0)
     {
@@ -317,6 +330,9 @@ globus_l_job_manager_module_deactivate(void)
     }
     globus_mutex_unlock(&globus_l_job_manager_mutex);
 
+    globus_scheduler_event_generator_tail_destroy(globus_l_job_manager_tail);
+    globus_l_job_manager_tail = NULL;
+
     GlobusDebugDestroy(SEG_JOB_MANAGER);
 
     globus_module_deactivate(GLOBUS_COMMON_MODULE);
@@ -325,7 +341,8 @@ globus_l_job_manager_module_deactivate(void)
 }
 
 /**
- * Periodic poll of file to act like tail -f
+ * Read new data from the log file to act like tail -f. Called when the log
+ * directory changes or the poll delay expires.
  *
  * @param user_arg
  *     Log file parsing state
@@ -466,8 +483,8 @@ globus_l_job_manager_poll_callback(
         GlobusTimeReltimeSet(delay, 0, 0);
     }
 
-    result = globus_callback_register_oneshot(
-            &state->callback,
+    result = globus_scheduler_event_generator_tail_register(
+            globus_l_job_manager_tail,
             &delay,
             globus_l_job_manager_poll_callback,
             state);
@@ -0,0 +1,550 @@
+/*
+ * Copyright 1999-2009 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Fork job SEG tests. Jobs made of child processes are registered with the
+ * job manager's fork SEG, which watches them with pidfds or falls back to
+ * polling them. Each job must get exactly one done event, after its last
+ * process exits, also when watching another job fails and the poller has
+ * to run alongside the pidfds.
+ */
+#include "globus_gram_job_manager.h"
+#include "globus_scheduler_event_generator_app.h"
+
+#include <string.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#if defined(HAVE_SYS_EPOLL_H) && HAVE_DECL_SYS_PIDFD_OPEN
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#define SEG_FORK_TEST_PIDFD 1
+#endif
+
+#define MAX_PIDS 2
+
+static globus_gram_job_manager_config_t config;
+static globus_gram_job_manager_t        manager;
+
+#ifdef SEG_FORK_TEST_PIDFD
+/*
+ * epoll_create1() and epoll_ctl() replacements: pass through unless a test
+ * has asked for epoll to be unavailable, or for the next watch to fail
+ */
+static globus_bool_t                    epoll_disabled;
+static globus_bool_t                    epoll_add_fail;
+
+int
+epoll_create1(int flags)
+{
+    if (epoll_disabled)
+    {
+        errno = ENOSYS;
+        return -1;
+    }
+    return (int) syscall(SYS_epoll_create1, flags);
+}
+
+int
+epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    if (op == EPOLL_CTL_ADD && epoll_add_fail)
+    {
+        epoll_add_fail = GLOBUS_FALSE;
+        errno = ENOMEM;
+        return -1;
+    }
+    return (int) syscall(SYS_epoll_ctl, epfd, op, fd, event);
+}
+#endif /* SEG_FORK_TEST_PIDFD */
+
+typedef struct
+{
+    globus_gram_jobmanager_request_t    request;
+    globus_gram_job_manager_ref_t       ref;
+    char *                              job_id;
+    pid_t                               pids[MAX_PIDS];
+    int                                 pid_count;
+    int                                 done_count;
+    int                                 other_count;
+}
+test_job_t;
+
+/*
+ * Start a job of pid_count processes which run until they are killed, or
+ * which have already exited and been reaped if running is not set
+ */
+static
+int
+job_start(
+    test_job_t *                        job,
+    int                                 n,
+    int                                 pid_count,
+    globus_bool_t                       running)
+{
+    char *                              job_id;
+    int                                 i;
+    int                                 rc;
+
+    memset(job, 0, sizeof(test_job_t));
+    job->request.config = &config;
+    job->request.manager = &manager;
+    job->request.job_contact_path = globus_common_create_string("/%d", n);
+    job->request.jobmanager_state = GLOBUS_GRAM_JOB_MANAGER_STATE_POLL1;
+    globus_mutex_init(&job->request.mutex, NULL);
+    globus_fifo_init(&job->request.seg_event_queue);
+
+    job->ref.key = job->request.job_contact_path;
+    job->ref.manager = &manager;
+    job->ref.request = &job->request;
+    job->ref.reference_count = 1;
+    job->ref.cleanup_timer = GLOBUS_NULL_HANDLE;
+    globus_hashtable_insert(&manager.request_hash, job->ref.key, &job->ref);
+
+    for (i = 0; i < pid_count; i++)
+    {
+        job->pids[i] = fork();
+        if (job->pids[i] == 0)
+        {
+            while (running)
+            {
+                pause();
+            }
+            _exit(0);
+        }
+        else if (job->pids[i] < 0)
+        {
+            return GLOBUS_FAILURE;
+        }
+        job->pid_count++;
+        job_id = job->job_id;
+        job->job_id = job_id
+            ? globus_common_create_string(
+                    "%s,%ld", job_id, (long) job->pids[i])
+            : globus_common_create_string("%ld", (long) job->pids[i]);
+        free(job_id);
+
+        if (!running)
+        {
+            waitpid(job->pids[i], NULL, 0);
+            job->pids[i] = 0;
+        }
+    }
+
+    rc = globus_gram_job_manager_register_job_id(
+            &manager,
+            job->job_id,
+            &job->request,
+            GLOBUS_FALSE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        printf("# register of %s failed: %d\n", job->job_id, rc);
+    }
+    return rc;
+}
+
+/* Kill and reap one of a job's processes */
+static
+void
+job_kill(
+    test_job_t *                        job,
+    int                                 i)
+{
+    if (job->pids[i] > 0)
+    {
+        kill(job->pids[i], SIGKILL);
+        waitpid(job->pids[i], NULL, 0);
+        job->pids[i] = 0;
+    }
+}
+
+static
+void
+job_destroy(
+    test_job_t *                        job)
+{
+    globus_scheduler_event_t *          event;
+    int                                 i;
+
+    for (i = 0; i < job->pid_count; i++)
+    {
+        job_kill(job, i);
+    }
+    (void) globus_gram_job_manager_unregister_job_id(&manager, job->job_id);
+    globus_hashtable_remove(&manager.request_hash, job->ref.key);
+
+    while (!globus_fifo_empty(&job->request.seg_event_queue))
+    {
+        event = globus_fifo_dequeue(&job->request.seg_event_queue);
+        globus_scheduler_event_destroy(event);
+    }
+    globus_fifo_destroy(&job->request.seg_event_queue);
+    globus_mutex_destroy(&job->request.mutex);
+    free(job->request.job_contact_path);
+    free(job->job_id);
+}
+
+/* Count the events delivered to a job since the last call */
+static
+void
+job_events(
+    test_job_t *                        job)
+{
+    globus_scheduler_event_t *          event;
+
+    while (!globus_fifo_empty(&job->request.seg_event_queue))
+    {
+        event = globus_fifo_dequeue(&job->request.seg_event_queue);
+        if (event->event_type == GLOBUS_SCHEDULER_EVENT_DONE &&
+            strcmp(event->job_id, job->job_id) == 0)
+        {
+            job->done_count++;
+        }
+        else
+        {
+            job->other_count++;
+        }
+        globus_scheduler_event_destroy(event);
+    }
+}
+
+/*
+ * Run callbacks for the given number of seconds, or until every job has at
+ * least one done event if until_done is set
+ */
+static
+void
+jobs_run(
+    test_job_t *                        jobs,
+    int                                 job_count,
+    int                                 seconds,
+    globus_bool_t                       until_done)
+{
+    globus_abstime_t                    timeout;
+    time_t                              deadline;
+    globus_bool_t                       all_done;
+    int                                 i;
+
+    deadline = time(NULL) + seconds;
+    do
+    {
+        GlobusTimeAbstimeSet(timeout, 0, 100000);
+        globus_callback_poll(&timeout);
+
+        all_done = GLOBUS_TRUE;
+        for (i = 0; i < job_count; i++)
+        {
+            job_events(&jobs[i]);
+            all_done = all_done && jobs[i].done_count > 0;
+        }
+    }
+    while (time(NULL) < deadline && !(until_done && all_done));
+}
+
+/* Check each job got the expected number of done events and nothing else */
+static
+int
+jobs_check(
+    test_job_t *                        jobs,
+    int                                 job_count,
+    int                                 done_count)
+{
+    int                                 rc = GLOBUS_SUCCESS;
+    int                                 i;
+
+    for (i = 0; i < job_count; i++)
+    {
+        if (jobs[i].done_count != done_count || jobs[i].other_count != 0)
+        {
+            printf("# job %s got %d done events and %d others, expected %d\n",
+                    jobs[i].job_id,
+                    jobs[i].done_count,
+                    jobs[i].other_count,
+                    done_count);
+            rc = GLOBUS_FAILURE;
+        }
+    }
+    return rc;
+}
+
+static
+int
+seg_start(void)
+{
+    globus_result_t                     result;
+
+    result = globus_gram_job_manager_init_seg(&manager);
+    if (result != GLOBUS_SUCCESS)
+    {
+        printf("# init_seg failed\n");
+        return GLOBUS_FAILURE;
+    }
+    return GLOBUS_SUCCESS;
+}
+
+#ifdef SEG_FORK_TEST_PIDFD
+/*
+ * Watch a two-process job and a job which has already exited when it is
+ * registered. The first job is done only when both its processes have
+ * exited, and each job gets one done event.
+ */
+static
+int
+pidfd_test(void)
+{
+    test_job_t                          jobs[2];
+    int                                 rc;
+
+    rc = seg_start();
+    if (rc != GLOBUS_SUCCESS)
+    {
+        return rc;
+    }
+    if (manager.fork_event_fd == -1 ||
+        manager.fork_callback_handle != GLOBUS_NULL_HANDLE)
+    {
+        printf("# fork SEG is polling instead of using pidfds\n");
+        rc = GLOBUS_FAILURE;
+        goto shutdown;
+    }
+
+    rc = job_start(&jobs[0], 0, 2, GLOBUS_TRUE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto destroy_0;
+    }
+
+    job_kill(&jobs[0], 0);
+    jobs_run(jobs, 1, 2, GLOBUS_FALSE);
+    rc = jobs_check(jobs, 1, 0);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        printf("# job done before its last process exited\n");
+        goto destroy_0;
+    }
+    job_kill(&jobs[0], 1);
+
+    rc = job_start(&jobs[1], 1, 1, GLOBUS_FALSE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto destroy_1;
+    }
+
+    jobs_run(jobs, 2, 5, GLOBUS_TRUE);
+    jobs_run(jobs, 2, 2, GLOBUS_FALSE);
+    rc = jobs_check(jobs, 2, 1);
+
+destroy_1:
+    job_destroy(&jobs[1]);
+destroy_0:
+    job_destroy(&jobs[0]);
+shutdown:
+    globus_gram_job_manager_shutdown_seg(&manager);
+
+    return rc;
+}
+#endif /* SEG_FORK_TEST_PIDFD */
+
+/*
+ * Without pidfds the fork SEG polls the job processes, and each job gets
+ * one done event once its processes have exited.
+ */
+static
+int
+poll_test(void)
+{
+    test_job_t                          jobs[2];
+    int                                 rc;
+
+#ifdef SEG_FORK_TEST_PIDFD
+    epoll_disabled = GLOBUS_TRUE;
+#endif
+    rc = seg_start();
+#ifdef SEG_FORK_TEST_PIDFD
+    epoll_disabled = GLOBUS_FALSE;
+#endif
+    if (rc != GLOBUS_SUCCESS)
+    {
+        return rc;
+    }
+    if (manager.fork_event_fd != -1 ||
+        manager.fork_callback_handle == GLOBUS_NULL_HANDLE)
+    {
+        printf("# fork SEG is not polling\n");
+        rc = GLOBUS_FAILURE;
+        goto shutdown;
+    }
+
+    rc = job_start(&jobs[0], 0, 2, GLOBUS_TRUE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto destroy_0;
+    }
+    rc = job_start(&jobs[1], 1, 1, GLOBUS_TRUE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto destroy_1;
+    }
+
+    job_kill(&jobs[0], 0);
+    job_kill(&jobs[1], 0);
+    jobs_run(jobs, 2, 3, GLOBUS_FALSE);
+    if (jobs[0].done_count != 0)
+    {
+        printf("# job done before its last process exited\n");
+        rc = GLOBUS_FAILURE;
+        goto destroy_1;
+    }
+
+    job_kill(&jobs[0], 1);
+    jobs_run(jobs, 2, 5, GLOBUS_TRUE);
+    jobs_run(jobs, 2, 3, GLOBUS_FALSE);
+    rc = jobs_check(jobs, 2, 1);
+
+destroy_1:
+    job_destroy(&jobs[1]);
+destroy_0:
+    job_destroy(&jobs[0]);
+shutdown:
+    globus_gram_job_manager_shutdown_seg(&manager);
+
+    return rc;
+}
+
+#ifdef SEG_FORK_TEST_PIDFD
+/*
+ * Watching the second job fails, so the poller starts while the first is
+ * still watched with its pidfd. Both jobs must still get exactly one done
+ * event each.
+ */
+static
+int
+watch_failure_test(void)
+{
+    test_job_t                          jobs[2];
+    int                                 rc;
+
+    rc = seg_start();
+    if (rc != GLOBUS_SUCCESS)
+    {
+        return rc;
+    }
+
+    rc = job_start(&jobs[0], 0, 1, GLOBUS_TRUE);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto destroy_0;
+    }
+    epoll_add_fail = GLOBUS_TRUE;
+    rc = job_start(&jobs[1], 1, 1, GLOBUS_TRUE);
+    epoll_add_fail = GLOBUS_FALSE;
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto destroy_1;
+    }
+    if (manager.fork_event_fd == -1 ||
+        manager.fork_callback_handle == GLOBUS_NULL_HANDLE)
+    {
+        printf("# failed watch did not start the poller\n");
+        rc = GLOBUS_FAILURE;
+        goto destroy_1;
+    }
+
+    job_kill(&jobs[0], 0);
+    job_kill(&jobs[1], 0);
+    jobs_run(jobs, 2, 5, GLOBUS_TRUE);
+    jobs_run(jobs, 2, 3, GLOBUS_FALSE);
+    rc = jobs_check(jobs, 2, 1);
+
+destroy_1:
+    job_destroy(&jobs[1]);
+destroy_0:
+    job_destroy(&jobs[0]);
+    globus_gram_job_manager_shutdown_seg(&manager);
+
+    return rc;
+}
+#endif /* SEG_FORK_TEST_PIDFD */
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    int                                 fail_count = 0;
+    int                                 rc;
+
+    globus_module_activate(GLOBUS_COMMON_MODULE);
+    globus_module_activate(GLOBUS_XIO_MODULE);
+    globus_thread_key_create(&globus_i_gram_request_key, NULL);
+
+    globus_xio_driver_load("file", &globus_i_gram_job_manager_file_driver);
+    globus_xio_stack_init(&globus_i_gram_job_manager_file_stack, NULL);
+    globus_xio_stack_push_driver(
+            globus_i_gram_job_manager_file_stack,
+            globus_i_gram_job_manager_file_driver);
+
+    config.hostname = "localhost";
+    config.logname = "test";
+    config.service_tag = "untagged";
+    config.jobmanager_type = "fork";
+
+    globus_mutex_init(&manager.mutex, NULL);
+    globus_hashtable_init(
+            &manager.request_hash,
+            17,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+    globus_hashtable_init(
+            &manager.job_id_hash,
+            17,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+    manager.config = &config;
+    manager.fork_callback_handle = GLOBUS_NULL_HANDLE;
+    manager.fork_event_fd = -1;
+    /* keep globus_gram_job_manager_log() off stderr */
+    manager.done = GLOBUS_TRUE;
+
+    printf("1..3\n");
+
+#ifdef SEG_FORK_TEST_PIDFD
+    rc = pidfd_test();
+    printf("%s - pidfd_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+#else
+    printf("ok - pidfd_test # SKIP no pidfd support\n");
+#endif
+
+    rc = poll_test();
+    printf("%s - poll_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+#ifdef SEG_FORK_TEST_PIDFD
+    rc = watch_failure_test();
+    printf("%s - watch_failure_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+#else
+    printf("ok - watch_failure_test # SKIP no pidfd support\n");
+#endif
+
+    globus_xio_stack_destroy(globus_i_gram_job_manager_file_stack);
+    globus_xio_driver_unload(globus_i_gram_job_manager_file_driver);
+    globus_module_deactivate(GLOBUS_XIO_MODULE);
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return fail_count;
+}
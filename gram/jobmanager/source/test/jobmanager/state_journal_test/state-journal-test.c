@@ -0,0 +1,739 @@
+/*
+ * Copyright 1999-2009 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * State journal tests. Jobs are written to and reloaded from the journal,
+ * the journal is cut at and inside each record to check that reopening it
+ * keeps exactly the complete records, large jobs are rewritten until the
+ * journal compacts itself, and a failed fsync() must fail every record
+ * waiting on it.
+ */
+#include "globus_gram_job_manager.h"
+
+#include <string.h>
+#include <sys/syscall.h>
+
+#define JOBS 4
+
+static globus_gram_job_manager_config_t config;
+static globus_gram_job_manager_t        manager;
+static char                             test_dir[] = "/tmp/state-journal-testXXXXXX";
+
+/*
+ * fsync() replacement: passes through unless a test has asked the next
+ * call to block until released and then fail
+ */
+static globus_mutex_t                   fsync_lock;
+static globus_cond_t                    fsync_cond;
+static globus_bool_t                    fsync_block;
+static globus_bool_t                    fsync_blocked;
+static globus_bool_t                    fsync_release;
+
+int
+fsync(int fd)
+{
+    globus_bool_t                       fail = GLOBUS_FALSE;
+
+    globus_mutex_lock(&fsync_lock);
+    if (fsync_block)
+    {
+        fsync_block = GLOBUS_FALSE;
+        fsync_blocked = GLOBUS_TRUE;
+        globus_cond_broadcast(&fsync_cond);
+        while (!fsync_release)
+        {
+            globus_cond_wait(&fsync_cond, &fsync_lock);
+        }
+        fail = GLOBUS_TRUE;
+    }
+    globus_mutex_unlock(&fsync_lock);
+
+    if (fail)
+    {
+        errno = EIO;
+        return -1;
+    }
+    return (int) syscall(SYS_fsync, fd);
+}
+
+static
+char *
+dir_path(
+    const char *                        dir,
+    const char *                        name)
+{
+    return globus_common_create_string("%s/%s", dir, name);
+}
+
+static
+int
+journal_open(
+    const char *                        dir)
+{
+    manager.state_journal = NULL;
+    return globus_gram_job_manager_state_journal_open(&manager, dir);
+}
+
+static
+void
+request_init(
+    globus_gram_jobmanager_request_t *  request,
+    const char *                        dir,
+    int                                 job)
+{
+    memset(request, 0, sizeof(globus_gram_jobmanager_request_t));
+    request->config = &config;
+    request->manager = &manager;
+    request->job_log_level = 0;
+    request->job_contact_path = globus_common_create_string("/%d", job);
+    request->job_state_file = globus_common_create_string(
+            "%s/job.%d", dir, job);
+}
+
+static
+void
+request_destroy(
+    globus_gram_jobmanager_request_t *  request)
+{
+    free(request->job_contact_path);
+    free(request->job_state_file);
+    free(request->job_id_string);
+    free(request->rsl_spec);
+    free(request->cache_tag);
+    free(request->original_job_id_string);
+}
+
+/* Write revision rev of a job's state, with an rsl padded to pad bytes */
+static
+int
+job_write(
+    const char *                        dir,
+    int                                 job,
+    int                                 rev,
+    size_t                              pad)
+{
+    globus_gram_jobmanager_request_t    request;
+    int                                 rc;
+
+    request_init(&request, dir, job);
+    request.job_id_string = globus_common_create_string("%d.%d", job, rev);
+    request.rsl_spec = malloc(pad + 3);
+    request.rsl_spec[0] = '&';
+    memset(request.rsl_spec + 1, 'x', pad + 1);
+    request.rsl_spec[pad + 2] = '\0';
+    request.cache_tag = strdup("cache");
+    request.status = GLOBUS_GRAM_PROTOCOL_JOB_STATE_ACTIVE;
+    request.jobmanager_state = GLOBUS_GRAM_JOB_MANAGER_STATE_POLL1;
+
+    rc = globus_gram_job_manager_state_file_write(&request);
+    request_destroy(&request);
+
+    return rc;
+}
+
+static
+int
+job_remove(
+    const char *                        dir,
+    int                                 job)
+{
+    globus_gram_jobmanager_request_t    request;
+    int                                 rc;
+
+    request_init(&request, dir, job);
+    rc = globus_gram_job_manager_state_file_remove(&request);
+    request_destroy(&request);
+
+    return rc;
+}
+
+/* Return the revision of a job's state, 0 if none, -1 on error */
+static
+int
+job_read(
+    const char *                        dir,
+    int                                 job)
+{
+    globus_gram_jobmanager_request_t    request;
+    int                                 rc;
+    int                                 read_job;
+    int                                 rev = -1;
+
+    request_init(&request, dir, job);
+    rc = globus_gram_job_manager_state_file_read(&request);
+    if (rc == GLOBUS_GRAM_PROTOCOL_ERROR_NO_STATE_FILE)
+    {
+        rev = 0;
+    }
+    else if (rc == GLOBUS_SUCCESS &&
+             (request.job_id_string == NULL ||
+              sscanf(request.job_id_string, "%d.%d", &read_job, &rev) != 2 ||
+              read_job != job))
+    {
+        rev = -1;
+    }
+    globus_gram_job_manager_contact_list_free(&request);
+    globus_gram_job_manager_staging_free_all(&request);
+    free(request.scratchdir);
+    free(request.gateway_user);
+    free(request.job_stats.client_address);
+    free(request.job_stats.user_dn);
+    request_destroy(&request);
+
+    return rev;
+}
+
+/*
+ * Check the open journal lists exactly the jobs with a revision in revs
+ * and that each reads back at that revision
+ */
+static
+int
+jobs_check(
+    const char *                        dir,
+    int                                 revs[JOBS])
+{
+    globus_list_t *                     state_files;
+    globus_list_t *                     l;
+    char                                name[32];
+    int                                 listed = 0;
+    int                                 expected = 0;
+    int                                 job;
+    int                                 rev;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    if (globus_gram_job_manager_state_journal_list(
+            &manager, &state_files) != GLOBUS_SUCCESS)
+    {
+        return GLOBUS_FAILURE;
+    }
+    for (job = 0; job < JOBS; job++)
+    {
+        if (revs[job] == 0)
+        {
+            continue;
+        }
+        expected++;
+        sprintf(name, "job.%d", job);
+        for (l = state_files; !globus_list_empty(l); l = globus_list_rest(l))
+        {
+            if (strcmp(globus_list_first(l), name) == 0)
+            {
+                listed++;
+            }
+        }
+    }
+    if (listed != expected || globus_list_size(state_files) != expected)
+    {
+        printf("# listed %d of %d jobs, %d in all\n",
+                listed, expected, globus_list_size(state_files));
+        rc = GLOBUS_FAILURE;
+    }
+    globus_list_destroy_all(state_files, free);
+
+    for (job = 0; job < JOBS; job++)
+    {
+        rev = job_read(dir, job);
+        if (rev != revs[job])
+        {
+            printf("# job %d is at revision %d, expected %d\n",
+                    job, rev, revs[job]);
+            rc = GLOBUS_FAILURE;
+        }
+    }
+
+    return rc;
+}
+
+static
+char *
+file_load(
+    const char *                        path,
+    size_t *                            length)
+{
+    FILE *                              fp;
+    char *                              data;
+    struct stat                         st;
+
+    if (stat(path, &st) != 0 || (fp = fopen(path, "r")) == NULL)
+    {
+        return NULL;
+    }
+    data = malloc(st.st_size + 1);
+    *length = fread(data, 1, st.st_size, fp);
+    data[*length] = '\0';
+    fclose(fp);
+
+    return data;
+}
+
+/*
+ * Return the number of complete records in the journal contents, setting
+ * ends[i] to the end of record i if ends is not NULL
+ */
+static
+int
+journal_records(
+    const char *                        data,
+    size_t                              length,
+    size_t *                            ends)
+{
+    size_t                              pos = 0;
+    unsigned long                       record_length;
+    const char *                        eol;
+    int                                 count = 0;
+
+    while (pos < length &&
+           (eol = memchr(data + pos, '\n', length - pos)) != NULL &&
+           sscanf(data + pos, "GJ1 %*c %*x %lu", &record_length) == 1 &&
+           (size_t) (eol - data) + 1 + record_length <= length)
+    {
+        pos = (eol - data) + 1 + record_length;
+        if (ends != NULL)
+        {
+            ends[count] = pos;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/*
+ * Operations of the journal used in the write and truncation tests: a
+ * revision of a job's state, or 0 to remove it
+ */
+static struct { int job; int rev; } ops[] =
+{
+    { 0, 1 }, { 1, 1 }, { 0, 2 }, { 2, 1 }, { 1, 2 },
+    { 2, 0 }, { 3, 1 }, { 0, 3 }, { 3, 2 }, { 1, 0 }
+};
+#define OPS (sizeof(ops) / sizeof(ops[0]))
+
+static char *                           journal_data;
+static size_t                           journal_length;
+
+static
+int
+write_reload_test(void)
+{
+    char *                              dir;
+    char *                              path;
+    char *                              data;
+    size_t                              length;
+    size_t                              ends[OPS];
+    int                                 revs[JOBS] = { 0 };
+    size_t                              i;
+    int                                 rc;
+
+    dir = dir_path(test_dir, "write");
+    globus_i_gram_mkdir(dir);
+    path = dir_path(dir, "journal");
+
+    rc = journal_open(dir);
+    for (i = 0; rc == GLOBUS_SUCCESS && i < OPS; i++)
+    {
+        rc = ops[i].rev
+            ? job_write(dir, ops[i].job, ops[i].rev, 100)
+            : job_remove(dir, ops[i].job);
+        revs[ops[i].job] = ops[i].rev;
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = jobs_check(dir, revs);
+    }
+    globus_gram_job_manager_state_journal_close(&manager);
+
+    /* kept for the truncation test */
+    journal_data = file_load(path, &journal_length);
+    if (rc == GLOBUS_SUCCESS &&
+        (journal_data == NULL ||
+         journal_records(journal_data, journal_length, NULL) != OPS))
+    {
+        printf("# journal does not have one record per operation\n");
+        rc = GLOBUS_FAILURE;
+    }
+
+    /* reopening keeps the jobs and compacts away the older records */
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = journal_open(dir);
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = jobs_check(dir, revs);
+        globus_gram_job_manager_state_journal_close(&manager);
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        data = file_load(path, &length);
+        if (data == NULL ||
+            journal_records(data, length, ends) != 2 ||
+            ends[1] != length)
+        {
+            printf("# reopened journal was not compacted to 2 records\n");
+            rc = GLOBUS_FAILURE;
+        }
+        free(data);
+    }
+    free(path);
+    free(dir);
+
+    return rc;
+}
+
+/* Open a copy of the journal cut to length bytes, expecting the state
+ * after the first records operations */
+static
+int
+cut_check(
+    size_t                              length,
+    size_t                              records)
+{
+    char *                              dir;
+    char *                              path;
+    char                                name[32];
+    int                                 revs[JOBS] = { 0 };
+    FILE *                              fp;
+    size_t                              i;
+    int                                 rc;
+
+    sprintf(name, "cut.%lu", (unsigned long) length);
+    dir = dir_path(test_dir, name);
+    globus_i_gram_mkdir(dir);
+    path = dir_path(dir, "journal");
+
+    fp = fopen(path, "w");
+    fwrite(journal_data, 1, length, fp);
+    fclose(fp);
+
+    for (i = 0; i < records; i++)
+    {
+        revs[ops[i].job] = ops[i].rev;
+    }
+    /* twice, to check the torn record is gone from the file too */
+    for (i = 0, rc = GLOBUS_SUCCESS; rc == GLOBUS_SUCCESS && i < 2; i++)
+    {
+        rc = journal_open(dir);
+        if (rc == GLOBUS_SUCCESS)
+        {
+            rc = jobs_check(dir, revs);
+            globus_gram_job_manager_state_journal_close(&manager);
+        }
+    }
+    if (rc != GLOBUS_SUCCESS)
+    {
+        printf("# journal cut at %lu bytes, after %lu records\n",
+                (unsigned long) length, (unsigned long) records);
+    }
+    free(path);
+    free(dir);
+
+    return rc;
+}
+
+static
+int
+truncate_test(void)
+{
+    size_t                              ends[OPS + 1];
+    size_t                              header_end;
+    size_t                              i;
+    int                                 rc = GLOBUS_SUCCESS;
+
+    if (journal_data == NULL ||
+        journal_records(journal_data, journal_length, ends + 1) != OPS)
+    {
+        return GLOBUS_FAILURE;
+    }
+    ends[0] = 0;
+
+    for (i = 0; i <= OPS; i++)
+    {
+        rc |= cut_check(ends[i], i);
+        if (i == OPS)
+        {
+            break;
+        }
+        /* in the header, just after it, and in the state. A removal
+         * record has no state, so it is complete after its header */
+        header_end = (char *) memchr(
+                journal_data + ends[i],
+                '\n',
+                journal_length - ends[i]) - journal_data + 1;
+        rc |= cut_check(ends[i] + 1, i);
+        rc |= cut_check(header_end, header_end == ends[i + 1] ? i + 1 : i);
+        if (header_end < ends[i + 1])
+        {
+            rc |= cut_check(ends[i + 1] - 1, i);
+        }
+    }
+
+    return rc;
+}
+
+static
+int
+compact_test(void)
+{
+    char *                              dir;
+    char *                              path;
+    int                                 revs[JOBS] = { 0 };
+    struct stat                         st;
+    int                                 rev;
+    int                                 rc;
+
+    dir = dir_path(test_dir, "compact");
+    globus_i_gram_mkdir(dir);
+    path = dir_path(dir, "journal");
+
+    /* 40 64k records: the journal must compact once it passes 1MB */
+    rc = journal_open(dir);
+    for (rev = 1; rc == GLOBUS_SUCCESS && rev <= 40; rev++)
+    {
+        rc = job_write(dir, 0, rev, 64 * 1024);
+    }
+    revs[0] = 40;
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = job_write(dir, 1, 1, 10);
+        revs[1] = 1;
+    }
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = jobs_check(dir, revs);
+    }
+    if (rc == GLOBUS_SUCCESS &&
+        (stat(path, &st) != 0 || st.st_size >= 1024 * 1024))
+    {
+        printf("# journal is %ld bytes\n", (long) st.st_size);
+        rc = GLOBUS_FAILURE;
+    }
+    globus_gram_job_manager_state_journal_close(&manager);
+
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = journal_open(dir);
+        if (rc == GLOBUS_SUCCESS)
+        {
+            rc = jobs_check(dir, revs);
+            globus_gram_job_manager_state_journal_close(&manager);
+        }
+    }
+    free(path);
+    free(dir);
+
+    return rc;
+}
+
+typedef struct
+{
+    const char *                        dir;
+    int                                 job;
+    int                                 rc;
+    globus_bool_t                       done;
+}
+writer_t;
+
+static globus_mutex_t                   writer_lock;
+static globus_cond_t                    writer_cond;
+
+static
+void *
+writer(
+    void *                              arg)
+{
+    writer_t *                          w = arg;
+    int                                 rc;
+
+    rc = job_write(w->dir, w->job, 1, 10);
+
+    globus_mutex_lock(&writer_lock);
+    w->rc = rc;
+    w->done = GLOBUS_TRUE;
+    globus_cond_broadcast(&writer_cond);
+    globus_mutex_unlock(&writer_lock);
+
+    return NULL;
+}
+
+/*
+ * Jobs 1 and 2 are appended while job 0's fsync() is in progress. That
+ * fsync() fails, so all three writes must fail, even though the next
+ * fsync() succeeds.
+ */
+static
+int
+fsync_failure_test(void)
+{
+    char *                              dir;
+    char *                              path;
+    char *                              data;
+    size_t                              length;
+    writer_t                            w[3];
+    globus_thread_t                     thread;
+    int                                 i;
+    int                                 tries;
+    int                                 rc;
+
+    dir = dir_path(test_dir, "fsync");
+    globus_i_gram_mkdir(dir);
+    path = dir_path(dir, "journal");
+
+    rc = journal_open(dir);
+    if (rc != GLOBUS_SUCCESS)
+    {
+        goto out;
+    }
+
+    globus_mutex_lock(&fsync_lock);
+    fsync_block = GLOBUS_TRUE;
+    globus_mutex_unlock(&fsync_lock);
+
+    for (i = 0; i < 3; i++)
+    {
+        w[i].dir = dir;
+        w[i].job = i;
+        w[i].rc = GLOBUS_SUCCESS;
+        w[i].done = GLOBUS_FALSE;
+        globus_thread_create(&thread, NULL, writer, &w[i]);
+
+        if (i == 0)
+        {
+            globus_mutex_lock(&fsync_lock);
+            while (!fsync_blocked)
+            {
+                globus_cond_wait(&fsync_cond, &fsync_lock);
+            }
+            globus_mutex_unlock(&fsync_lock);
+        }
+    }
+
+    /* wait for the other two records to be appended behind the fsync() */
+    for (tries = 0; tries < 1000; tries++)
+    {
+        data = file_load(path, &length);
+        i = data ? journal_records(data, length, NULL) : 0;
+        free(data);
+        if (i == 3)
+        {
+            break;
+        }
+        globus_libc_usleep(10000);
+    }
+
+    globus_mutex_lock(&fsync_lock);
+    fsync_release = GLOBUS_TRUE;
+    globus_cond_broadcast(&fsync_cond);
+    globus_mutex_unlock(&fsync_lock);
+
+    globus_mutex_lock(&writer_lock);
+    for (i = 0; i < 3; i++)
+    {
+        while (!w[i].done)
+        {
+            globus_cond_wait(&writer_cond, &writer_lock);
+        }
+        if (w[i].rc != GLOBUS_GRAM_PROTOCOL_ERROR_WRITING_STATE_FILE)
+        {
+            printf("# write of job %d returned %d\n", i, w[i].rc);
+            rc = GLOBUS_FAILURE;
+        }
+    }
+    globus_mutex_unlock(&writer_lock);
+
+    /* records after the failure are written normally */
+    if (rc == GLOBUS_SUCCESS && job_write(dir, 3, 1, 10) != GLOBUS_SUCCESS)
+    {
+        printf("# write after the failed fsync failed\n");
+        rc = GLOBUS_FAILURE;
+    }
+    globus_gram_job_manager_state_journal_close(&manager);
+
+out:
+    free(path);
+    free(dir);
+
+    return rc;
+}
+
+int
+main(
+    int                                 argc,
+    char *                              argv[])
+{
+    int                                 fail_count = 0;
+    int                                 rc;
+    char *                              command;
+
+    globus_thread_set_model("pthread");
+    globus_module_activate(GLOBUS_COMMON_MODULE);
+    globus_thread_key_create(&globus_i_gram_request_key, NULL);
+    globus_mutex_init(&fsync_lock, NULL);
+    globus_cond_init(&fsync_cond, NULL);
+    globus_mutex_init(&writer_lock, NULL);
+    globus_cond_init(&writer_cond, NULL);
+
+    if (mkdtemp(test_dir) == NULL)
+    {
+        printf("Bail out! mkdtemp failed\n");
+        return 1;
+    }
+
+    config.hostname = "localhost";
+    config.logname = "test";
+    config.service_tag = "untagged";
+    config.jobmanager_type = "fork";
+    config.job_state_file_dir = test_dir;
+
+    globus_mutex_init(&manager.mutex, NULL);
+    globus_hashtable_init(
+            &manager.request_hash,
+            17,
+            globus_hashtable_string_hash,
+            globus_hashtable_string_keyeq);
+    manager.config = &config;
+    /* keep globus_gram_job_manager_log() off stderr */
+    manager.done = GLOBUS_TRUE;
+
+    printf("1..4\n");
+
+    rc = write_reload_test();
+    printf("%s - write_reload_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+    rc = truncate_test();
+    printf("%s - truncate_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+    rc = compact_test();
+    printf("%s - compact_test\n", rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+    rc = fsync_failure_test();
+    printf("%s - fsync_failure_test\n",
+            rc == GLOBUS_SUCCESS ? "ok" : "not ok");
+    fail_count += (rc != GLOBUS_SUCCESS);
+
+    free(journal_data);
+    command = globus_common_create_string("rm -rf %s", test_dir);
+    system(command);
+    free(command);
+
+    globus_module_deactivate_all();
+
+    return fail_count;
+}
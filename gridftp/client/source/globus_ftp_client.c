@@ -141,6 +141,8 @@ globus_l_ftp_client_activate(void)
 				      0,
 				      0);
 
+    globus_i_ftp_client_pool_init();
+
     globus_i_ftp_client_debug_printf(1,
         (stderr, "globus_l_ftp_client_activate() exiting\n"));
 
@@ -189,6 +191,7 @@ globus_l_ftp_client_deactivate(void)
     }
     globus_mutex_unlock(&globus_l_ftp_client_active_list_mutex);
     /* TODO: Destroy all cached targets. */
+    globus_i_ftp_client_pool_destroy();
 
     /* Wait for all detached target control library callbacks to
      * complete.
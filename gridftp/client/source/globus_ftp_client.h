@@ -128,7 +128,8 @@ typedef enum
     GLOBUS_FTP_CLIENT_ERROR_PROTOCOL,
     GLOBUS_FTP_CLIENT_ERROR_RESPONSE,
     GLOBUS_FTP_CLIENT_ERROR_FEATURE,
-    GLOBUS_FTP_CLIENT_ERROR_NO_RESTART_MARKER
+    GLOBUS_FTP_CLIENT_ERROR_NO_RESTART_MARKER,
+    GLOBUS_FTP_CLIENT_ERROR_CHECKSUM
 } globus_ftp_client_error_t;
 
 /**
@@ -410,6 +411,25 @@ globus_ftp_client_restart_marker_from_string(
     const char *				marker_string);
 #endif
 
+/**
+ * Connection pool counters.
+ * @ingroup globus_ftp_client_handle
+ *
+ * @see globus_ftp_client_pool_get_stats()
+ */
+typedef struct
+{
+    /** Operations that reused an idle connection from the pool */
+    globus_size_t				hits;
+    /** Operations on pooling handles that found no usable connection */
+    globus_size_t				misses;
+    /** Idle connections closed for age or to stay within the limits */
+    globus_size_t				evictions;
+    /** Connections idle in the pool now */
+    globus_size_t				idle;
+}
+globus_ftp_client_pool_stats_t;
+
 /**
  * @defgroup globus_ftp_client_handle Handle Management
  * @ingroup globus_ftp_client_api
@@ -450,6 +470,19 @@ globus_ftp_client_handle_flush_url_state(
     globus_ftp_client_handle_t *		handle,
     const char *				url);
 
+globus_result_t
+globus_ftp_client_pool_set_limits(
+    globus_size_t				max_idle,
+    globus_size_t				max_idle_per_server,
+    const globus_reltime_t *			idle_timeout);
+
+globus_result_t
+globus_ftp_client_pool_get_stats(
+    globus_ftp_client_pool_stats_t *		stats);
+
+globus_result_t
+globus_ftp_client_pool_flush(void);
+
 globus_result_t
 globus_ftp_client_handle_set_user_pointer(
     globus_ftp_client_handle_t *		handle,
@@ -523,6 +556,16 @@ globus_ftp_client_handleattr_get_cache_all(
     const globus_ftp_client_handleattr_t *	attr,
     globus_bool_t *				cache_all);
 
+globus_result_t
+globus_ftp_client_handleattr_set_pool(
+    globus_ftp_client_handleattr_t *		attr,
+    globus_bool_t				use_pool);
+
+globus_result_t
+globus_ftp_client_handleattr_get_pool(
+    const globus_ftp_client_handleattr_t *	attr,
+    globus_bool_t *				use_pool);
+
 globus_result_t
 globus_ftp_client_handleattr_set_rfc1738_url(
     globus_ftp_client_handleattr_t *		attr,
@@ -879,6 +922,175 @@ globus_ftp_client_exists(
     globus_ftp_client_operationattr_t *		attr,
     globus_ftp_client_complete_callback_t	complete_callback,
     void *					callback_arg);
+
+/**
+ * Bundle parser handle.
+ * @ingroup globus_ftp_client_operations
+ *
+ * Splits the data from globus_ftp_client_bundle_get() into files.
+ */
+typedef struct globus_i_ftp_client_bundle_parser_s *
+    globus_ftp_client_bundle_parser_t;
+
+/**
+ * Bundle file data callback.
+ * @ingroup globus_ftp_client_operations
+ *
+ * @param user_arg
+ *        The callback_arg passed to globus_ftp_client_bundle_parser_init().
+ * @param name
+ *        Name of the file, relative to the bundle directory.
+ * @param size
+ *        Size of the file.
+ * @param mode
+ *        Permission bits of the file.
+ * @param mtime
+ *        Modification time of the file.
+ * @param buffer
+ *        File data, valid only until the callback returns.
+ * @param length
+ *        Length of the file data in buffer.
+ * @param offset
+ *        Offset of buffer in the file.
+ * @param eof
+ *        GLOBUS_TRUE on the last callback for this file.
+ */
+typedef void (*globus_ftp_client_bundle_callback_t) (
+    void *					user_arg,
+    const char *				name,
+    globus_off_t				size,
+    int						mode,
+    time_t					mtime,
+    globus_byte_t *				buffer,
+    globus_size_t				length,
+    globus_off_t				offset,
+    globus_bool_t				eof);
+
+globus_result_t
+globus_ftp_client_bundle_get(
+    globus_ftp_client_handle_t *		handle,
+    const char *				url,
+    globus_ftp_client_operationattr_t *		attr,
+    globus_bool_t				recursive,
+    globus_ftp_client_complete_callback_t	complete_callback,
+    void *					callback_arg);
+
+globus_result_t
+globus_ftp_client_bundle_put(
+    globus_ftp_client_handle_t *		handle,
+    const char *				url,
+    globus_ftp_client_operationattr_t *		attr,
+    globus_ftp_client_complete_callback_t	complete_callback,
+    void *					callback_arg);
+
+globus_result_t
+globus_ftp_client_bundle_header(
+    globus_byte_t *				buffer,
+    globus_size_t				buffer_length,
+    const char *				name,
+    globus_off_t				size,
+    int						mode,
+    time_t					mtime,
+    globus_size_t *				header_length);
+
+globus_result_t
+globus_ftp_client_bundle_parser_init(
+    globus_ftp_client_bundle_parser_t *		parser,
+    globus_ftp_client_bundle_callback_t		callback,
+    void *					callback_arg);
+
+globus_result_t
+globus_ftp_client_bundle_parser_destroy(
+    globus_ftp_client_bundle_parser_t *		parser);
+
+globus_result_t
+globus_ftp_client_bundle_parser_parse(
+    globus_ftp_client_bundle_parser_t		parser,
+    globus_byte_t *				buffer,
+    globus_size_t				length,
+    globus_off_t				offset);
+
+globus_result_t
+globus_ftp_client_bundle_parser_finish(
+    globus_ftp_client_bundle_parser_t		parser);
+
+/**
+ * Batch transfer handle.
+ * @ingroup globus_ftp_client_operations
+ *
+ * A queue of third-party transfers run over several cached, pipelined
+ * control connections.
+ */
+typedef struct globus_i_ftp_client_batch_s * globus_ftp_client_batch_t;
+
+/**
+ * Batch item complete callback.
+ * @ingroup globus_ftp_client_operations
+ *
+ * @param user_arg
+ *        The item_callback_arg passed to globus_ftp_client_batch_init().
+ * @param source_url
+ *        Source URL of the item.
+ * @param dest_url
+ *        Destination URL of the item.
+ * @param item_arg
+ *        The item_arg passed to globus_ftp_client_batch_add().
+ * @param error
+ *        GLOBUS_NULL if the item was transferred, and its checksum
+ *        matched if one was given, otherwise the reason it failed.
+ */
+typedef void (*globus_ftp_client_batch_item_callback_t) (
+    void *					user_arg,
+    const char *				source_url,
+    const char *				dest_url,
+    void *					item_arg,
+    globus_object_t *				error);
+
+/**
+ * Batch complete callback.
+ * @ingroup globus_ftp_client_operations
+ *
+ * @param user_arg
+ *        The callback_arg passed to globus_ftp_client_batch_start().
+ * @param failed
+ *        Number of items which failed.
+ */
+typedef void (*globus_ftp_client_batch_complete_callback_t) (
+    void *					user_arg,
+    globus_size_t				failed);
+
+globus_result_t
+globus_ftp_client_batch_init(
+    globus_ftp_client_batch_t *			batch,
+    globus_ftp_client_handleattr_t *		handle_attr,
+    globus_ftp_client_operationattr_t *		source_attr,
+    globus_ftp_client_operationattr_t *		dest_attr,
+    globus_size_t				connections,
+    globus_size_t				outstanding_commands,
+    globus_ftp_client_batch_item_callback_t	item_callback,
+    void *					item_callback_arg);
+
+globus_result_t
+globus_ftp_client_batch_destroy(
+    globus_ftp_client_batch_t *			batch);
+
+globus_result_t
+globus_ftp_client_batch_add(
+    globus_ftp_client_batch_t *			batch,
+    const char *				source_url,
+    globus_ftp_client_operationattr_t *		source_attr,
+    const char *				dest_url,
+    globus_ftp_client_operationattr_t *		dest_attr,
+    globus_off_t				offset,
+    const char *				checksum_algorithm,
+    const char *				checksum,
+    void *					item_arg);
+
+globus_result_t
+globus_ftp_client_batch_start(
+    globus_ftp_client_batch_t *			batch,
+    globus_ftp_client_batch_complete_callback_t	complete_callback,
+    void *					callback_arg);
 #endif
 
 /**
@@ -1242,6 +1454,7 @@ typedef enum
     GLOBUS_FTP_CLIENT_FEATURE_CHGRP,
     GLOBUS_FTP_CLIENT_FEATURE_UTIME,
     GLOBUS_FTP_CLIENT_FEATURE_SYMLINK,
+    GLOBUS_FTP_CLIENT_FEATURE_BUNDLE,
     GLOBUS_FTP_CLIENT_FEATURE_MAX,
     GLOBUS_FTP_CLIENT_LAST_BUFFER_COMMAND = GLOBUS_FTP_CLIENT_FEATURE_ABUF,
     GLOBUS_FTP_CLIENT_FIRST_FEAT_FEATURE = GLOBUS_FTP_CLIENT_FEATURE_SBUF,
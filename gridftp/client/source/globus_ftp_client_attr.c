@@ -491,6 +491,88 @@ globus_ftp_client_handleattr_get_cache_all(
     return globus_error_put(err);
 }
 /* globus_ftp_client_handleattr_get_cache_all() */
+
+/**
+ * Set/Get the connection pool attribute for an ftp client handle
+ * attribute set.
+ * @ingroup globus_ftp_client_handleattr
+ *
+ * This attribute lets handles share idle control connections through a
+ * process-wide pool. A connection a handle no longer needs, and would
+ * otherwise close, is kept in the pool, and any handle with this
+ * attribute set may take it for a later operation to the same server
+ * with the same credentials and DCAU settings, skipping the connection
+ * and authentication handshake. Connections in a handle's own cache are
+ * handed to the pool when the handle is destroyed.
+ *
+ * The pool is safe to use from many threads at once. Its size and how
+ * long connections may sit idle are set with
+ * globus_ftp_client_pool_set_limits().
+ *
+ * @param attr
+ *        Attribute to query or modify.
+ * @param use_pool
+ *        Value of the pool attribute.
+ *
+ * @see globus_ftp_client_pool_set_limits(),
+ *      globus_ftp_client_pool_get_stats(),
+ *      globus_ftp_client_pool_flush()
+ */
+globus_result_t
+globus_ftp_client_handleattr_set_pool(
+    globus_ftp_client_handleattr_t *		attr,
+    globus_bool_t				use_pool)
+{
+    globus_object_t *				err = GLOBUS_SUCCESS;
+    globus_i_ftp_client_handleattr_t *		i_attr;
+    GlobusFuncName(globus_ftp_client_handleattr_set_pool);
+
+    if(attr == GLOBUS_NULL)
+    {
+	err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("attr");
+
+	goto error_exit;
+    }
+    i_attr = *(globus_i_ftp_client_handleattr_t **) attr;
+
+    i_attr->use_pool = use_pool;
+
+    return GLOBUS_SUCCESS;
+
+ error_exit:
+    return globus_error_put(err);
+}
+/* globus_ftp_client_handleattr_set_pool() */
+
+globus_result_t
+globus_ftp_client_handleattr_get_pool(
+    const globus_ftp_client_handleattr_t *	attr,
+    globus_bool_t *				use_pool)
+{
+    const globus_i_ftp_client_handleattr_t *	i_attr;
+    globus_object_t *				err = GLOBUS_SUCCESS;
+    GlobusFuncName(globus_ftp_client_handleattr_get_pool);
+
+    if(attr == GLOBUS_NULL)
+    {
+	err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("attr");
+
+	goto error_exit;
+    }
+    if(use_pool == GLOBUS_NULL)
+    {
+	err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("use_pool");
+
+	goto error_exit;
+    }
+    i_attr = *(const globus_i_ftp_client_handleattr_t **) attr;
+    (*use_pool) = i_attr->use_pool;
+
+    return GLOBUS_SUCCESS;
+ error_exit:
+    return globus_error_put(err);
+}
+/* globus_ftp_client_handleattr_get_pool() */
 /*@}*/
 
 /**
@@ -3949,6 +4031,7 @@ globus_i_ftp_client_handleattr_copy(
     }
     
     dest->cache_all = src->cache_all;
+    dest->use_pool = src->use_pool;
     dest->rfc1738_url = src->rfc1738_url;
     dest->nl_handle = src->nl_handle;
     dest->nl_ftp = src->nl_ftp;
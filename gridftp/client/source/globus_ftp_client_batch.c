@@ -0,0 +1,1354 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+
+/**
+ * @file globus_ftp_client_batch.c
+ * @brief Batch transfers
+ */
+
+#include "globus_i_ftp_client.h"
+
+#define GLOBUS_L_FTP_CLIENT_BATCH_PLUGIN_NAME "globus_ftp_client_batch_plugin"
+#define GLOBUS_L_FTP_CLIENT_BATCH_CKSM_MAX 1024
+
+/* Module specific data types */
+/**
+ * Batch transfer item.
+ * @internal
+ *
+ * One third-party transfer queued on a batch. Items without their own
+ * attributes or offset may be pipelined after another item between the
+ * same two servers.
+ */
+typedef struct
+{
+    struct globus_i_ftp_client_batch_s *	batch;
+
+    char *					source_url;
+    char *					dest_url;
+
+    /** "scheme://user@host:port" of each URL, to find pipelinable items */
+    char *					source_key;
+    char *					dest_key;
+
+    globus_ftp_client_operationattr_t		source_attr;
+    globus_ftp_client_operationattr_t		dest_attr;
+    globus_bool_t				own_source_attr;
+    globus_bool_t				own_dest_attr;
+
+    globus_off_t				offset;
+    char *					checksum_algorithm;
+    char *					checksum;
+    void *					item_arg;
+
+    /** May follow another item in a pipelined transfer */
+    globus_bool_t				pipelinable;
+
+    /** The destination server has sent the preliminary reply for it */
+    globus_bool_t				started;
+
+    globus_object_t *				error;
+}
+globus_l_ftp_client_batch_item_t;
+
+struct globus_i_ftp_client_batch_s;
+
+/**
+ * Batch connection.
+ * @internal
+ *
+ * Each lane is an FTP client handle with its own cached control
+ * connections, running one transfer (possibly pipelined) or checksum at
+ * a time.
+ */
+typedef struct
+{
+    struct globus_i_ftp_client_batch_s *	batch;
+    globus_ftp_client_handle_t			handle;
+    globus_ftp_client_plugin_t			plugin;
+
+    /** Items sent in the current transfer and not yet complete, in order */
+    globus_fifo_t				inflight;
+
+    /** Completed items waiting for their checksum to be verified */
+    globus_fifo_t				verify;
+
+    /** Item whose checksum is being computed */
+    globus_l_ftp_client_batch_item_t *		verifying;
+    char					checksum[
+					GLOBUS_L_FTP_CLIENT_BATCH_CKSM_MAX];
+
+    /** Servers of the current transfer, when more items may be pipelined */
+    char *					source_key;
+    char *					dest_key;
+    globus_bool_t				pipeline;
+
+    globus_bool_t				busy;
+}
+globus_l_ftp_client_batch_lane_t;
+
+/**
+ * Batch transfer.
+ * @internal
+ */
+typedef struct globus_i_ftp_client_batch_s
+{
+    globus_mutex_t				mutex;
+
+    globus_ftp_client_operationattr_t		source_attr;
+    globus_ftp_client_operationattr_t		dest_attr;
+
+    globus_l_ftp_client_batch_lane_t *		lanes;
+    globus_size_t				lane_count;
+
+    /** Items not yet started, in the order they were added */
+    globus_fifo_t				queue;
+
+    /**
+     * Items whose pipelined transfer failed before they were reached,
+     * retried on their own before the rest of the queue
+     */
+    globus_fifo_t				retry;
+
+    /** Items added and not yet reported */
+    globus_size_t				pending;
+    globus_size_t				failed;
+
+    globus_bool_t				started;
+    globus_bool_t				completed;
+
+    globus_ftp_client_batch_item_callback_t	item_callback;
+    void *					item_callback_arg;
+    globus_ftp_client_batch_complete_callback_t	complete_callback;
+    void *					complete_callback_arg;
+}
+globus_i_ftp_client_batch_t;
+
+/* Module specific prototypes */
+static
+void
+globus_l_ftp_client_batch_lane_next(
+    globus_l_ftp_client_batch_lane_t *		lane);
+
+static
+void
+globus_l_ftp_client_batch_report(
+    globus_i_ftp_client_batch_t *		batch,
+    globus_l_ftp_client_batch_item_t *		item);
+
+static
+void
+globus_l_ftp_client_batch_item_destroy(
+    globus_l_ftp_client_batch_item_t *		item);
+
+static
+char *
+globus_l_ftp_client_batch_key(
+    const char *				url);
+
+static
+globus_ftp_client_plugin_t *
+globus_l_ftp_client_batch_plugin_copy(
+    globus_ftp_client_plugin_t *		plugin_template,
+    void *					plugin_specific);
+
+static
+void
+globus_l_ftp_client_batch_plugin_destroy(
+    globus_ftp_client_plugin_t *		plugin,
+    void *					plugin_specific);
+
+static
+globus_result_t
+globus_l_ftp_client_batch_plugin_init(
+    globus_ftp_client_plugin_t *		plugin,
+    globus_l_ftp_client_batch_lane_t *		lane);
+
+static
+void
+globus_l_ftp_client_batch_empty_kickout(
+    void *					user_arg);
+
+static
+void
+globus_l_ftp_client_batch_transfer_callback(
+    void *					user_arg,
+    globus_ftp_client_handle_t *		handle,
+    globus_object_t *				error);
+
+static
+void
+globus_l_ftp_client_batch_cksm_callback(
+    void *					user_arg,
+    globus_ftp_client_handle_t *		handle,
+    globus_object_t *				error);
+
+static
+void
+globus_l_ftp_client_batch_pipeline(
+    globus_ftp_client_handle_t *		handle,
+    char **					source_url,
+    char **					dest_url,
+    void *					user_arg);
+
+#endif
+
+/**
+ * @name Batch Transfers
+ */
+/* @{ */
+/**
+ * Initialize a batch transfer.
+ * @ingroup globus_ftp_client_operations
+ *
+ * A batch moves a queue of files between FTP servers with third-party
+ * transfers, using several control connections at once and pipelining
+ * the transfer commands on each of them. The application adds items
+ * with globus_ftp_client_batch_add(), starts the batch with
+ * globus_ftp_client_batch_start(), and is told as each item completes.
+ *
+ * The batch opens up to connections FTP client handles, each of which
+ * caches its connections to the servers between transfers. When
+ * outstanding_commands is larger than connections, consecutive items
+ * between the same two servers, using the batch attributes and no
+ * offset, are pipelined on each handle with up to
+ * outstanding_commands / connections commands sent ahead. Pipelining
+ * needs the extended block mode set in source_attr.
+ *
+ * @param batch
+ *        The batch to initialize.
+ * @param handle_attr
+ *        Attributes for the batch's FTP client handles, or GLOBUS_NULL.
+ *        URL caching is enabled on the handles whatever this says.
+ * @param source_attr
+ *        Attributes used for the source of items added without their
+ *        own, or GLOBUS_NULL for the defaults.
+ * @param dest_attr
+ *        Attributes used for the destination of items added without
+ *        their own, or GLOBUS_NULL for the defaults.
+ * @param connections
+ *        Number of transfers run at once.
+ * @param outstanding_commands
+ *        Number of transfer commands in flight over all connections.
+ * @param item_callback
+ *        Called once for each item when it is complete.
+ * @param item_callback_arg
+ *        Argument passed to item_callback.
+ */
+globus_result_t
+globus_ftp_client_batch_init(
+    globus_ftp_client_batch_t *			batch,
+    globus_ftp_client_handleattr_t *		handle_attr,
+    globus_ftp_client_operationattr_t *		source_attr,
+    globus_ftp_client_operationattr_t *		dest_attr,
+    globus_size_t				connections,
+    globus_size_t				outstanding_commands,
+    globus_ftp_client_batch_item_callback_t	item_callback,
+    void *					item_callback_arg)
+{
+    globus_i_ftp_client_batch_t *		i_batch;
+    globus_l_ftp_client_batch_lane_t *		lane;
+    globus_ftp_client_handleattr_t		attr;
+    globus_ftp_control_mode_t			mode;
+    globus_size_t				per_lane;
+    globus_object_t *				err;
+    globus_result_t				result;
+    globus_size_t				i;
+    GlobusFuncName(globus_ftp_client_batch_init);
+
+    if(batch == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("batch");
+
+        goto error;
+    }
+    if(connections == 0)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_INVALID_PARAMETER("connections");
+
+        goto error;
+    }
+    if(item_callback == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("item_callback");
+
+        goto error;
+    }
+
+    i_batch = globus_libc_calloc(1, sizeof(globus_i_ftp_client_batch_t));
+    if(i_batch == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_OUT_OF_MEMORY();
+
+        goto error;
+    }
+    i_batch->lanes = globus_libc_calloc(
+        connections, sizeof(globus_l_ftp_client_batch_lane_t));
+    if(i_batch->lanes == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_OUT_OF_MEMORY();
+
+        goto free_batch;
+    }
+
+    if(source_attr)
+    {
+        result = globus_ftp_client_operationattr_copy(
+            &i_batch->source_attr, source_attr);
+    }
+    else
+    {
+        result = globus_ftp_client_operationattr_init(&i_batch->source_attr);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        err = globus_error_get(result);
+
+        goto free_lanes;
+    }
+    if(dest_attr)
+    {
+        result = globus_ftp_client_operationattr_copy(
+            &i_batch->dest_attr, dest_attr);
+    }
+    else
+    {
+        result = globus_ftp_client_operationattr_init(&i_batch->dest_attr);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        err = globus_error_get(result);
+
+        goto destroy_source_attr;
+    }
+
+    /* commands can only be pipelined on an extended block data channel */
+    per_lane = outstanding_commands / connections;
+    globus_ftp_client_operationattr_get_mode(&i_batch->source_attr, &mode);
+    if(mode != GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK)
+    {
+        per_lane = 1;
+    }
+
+    globus_mutex_init(&i_batch->mutex, GLOBUS_NULL);
+    globus_fifo_init(&i_batch->queue);
+    globus_fifo_init(&i_batch->retry);
+    i_batch->item_callback = item_callback;
+    i_batch->item_callback_arg = item_callback_arg;
+
+    for(i = 0; i < connections; i++)
+    {
+        lane = &i_batch->lanes[i];
+        lane->batch = i_batch;
+        globus_fifo_init(&lane->inflight);
+        globus_fifo_init(&lane->verify);
+
+        if(handle_attr)
+        {
+            result = globus_ftp_client_handleattr_copy(&attr, handle_attr);
+        }
+        else
+        {
+            result = globus_ftp_client_handleattr_init(&attr);
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            err = globus_error_get(result);
+
+            goto destroy_lanes;
+        }
+        globus_ftp_client_handleattr_set_cache_all(&attr, GLOBUS_TRUE);
+        if(per_lane > 1)
+        {
+            globus_ftp_client_handleattr_set_pipeline(
+                &attr,
+                per_lane,
+                globus_l_ftp_client_batch_pipeline,
+                lane);
+        }
+        result = globus_ftp_client_handle_init(&lane->handle, &attr);
+        globus_ftp_client_handleattr_destroy(&attr);
+        if(result != GLOBUS_SUCCESS)
+        {
+            err = globus_error_get(result);
+
+            goto destroy_lanes;
+        }
+        i_batch->lane_count++;
+
+        result = globus_l_ftp_client_batch_plugin_init(&lane->plugin, lane);
+        if(result == GLOBUS_SUCCESS)
+        {
+            result = globus_ftp_client_handle_add_plugin(
+                &lane->handle, &lane->plugin);
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_ftp_client_plugin_destroy(&lane->plugin);
+            }
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            err = globus_error_get(result);
+            globus_ftp_client_handle_destroy(&lane->handle);
+            i_batch->lane_count--;
+
+            goto destroy_lanes;
+        }
+    }
+
+    *batch = i_batch;
+
+    return GLOBUS_SUCCESS;
+
+destroy_lanes:
+    for(i = 0; i < i_batch->lane_count; i++)
+    {
+        lane = &i_batch->lanes[i];
+        globus_ftp_client_handle_destroy(&lane->handle);
+        globus_ftp_client_plugin_destroy(&lane->plugin);
+    }
+    for(i = 0; i < connections; i++)
+    {
+        globus_fifo_destroy(&i_batch->lanes[i].inflight);
+        globus_fifo_destroy(&i_batch->lanes[i].verify);
+    }
+    globus_fifo_destroy(&i_batch->queue);
+    globus_fifo_destroy(&i_batch->retry);
+    globus_mutex_destroy(&i_batch->mutex);
+    globus_ftp_client_operationattr_destroy(&i_batch->dest_attr);
+destroy_source_attr:
+    globus_ftp_client_operationattr_destroy(&i_batch->source_attr);
+free_lanes:
+    globus_libc_free(i_batch->lanes);
+free_batch:
+    globus_libc_free(i_batch);
+error:
+    if(batch)
+    {
+        *batch = GLOBUS_NULL;
+    }
+    return globus_error_put(err);
+}
+/* globus_ftp_client_batch_init() */
+
+/**
+ * Destroy a batch transfer.
+ * @ingroup globus_ftp_client_operations
+ *
+ * The batch must not have items in progress: either it was never
+ * started, or its complete callback has been called. The batch's
+ * cached connections are closed.
+ *
+ * @param batch
+ *        The batch to destroy.
+ */
+globus_result_t
+globus_ftp_client_batch_destroy(
+    globus_ftp_client_batch_t *			batch)
+{
+    globus_i_ftp_client_batch_t *		i_batch;
+    globus_l_ftp_client_batch_lane_t *		lane;
+    globus_object_t *				err;
+    globus_size_t				i;
+    GlobusFuncName(globus_ftp_client_batch_destroy);
+
+    if(batch == GLOBUS_NULL || *batch == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("batch");
+
+        goto error;
+    }
+    i_batch = *batch;
+
+    globus_mutex_lock(&i_batch->mutex);
+    if(i_batch->started && !i_batch->completed)
+    {
+        globus_mutex_unlock(&i_batch->mutex);
+        err = GLOBUS_I_FTP_CLIENT_ERROR_OBJECT_IN_USE("batch");
+
+        goto error;
+    }
+    globus_mutex_unlock(&i_batch->mutex);
+
+    /* items added but never started */
+    while(!globus_fifo_empty(&i_batch->queue))
+    {
+        globus_l_ftp_client_batch_item_destroy(
+            globus_fifo_dequeue(&i_batch->queue));
+    }
+
+    for(i = 0; i < i_batch->lane_count; i++)
+    {
+        lane = &i_batch->lanes[i];
+        globus_ftp_client_handle_destroy(&lane->handle);
+        globus_ftp_client_plugin_destroy(&lane->plugin);
+        globus_fifo_destroy(&lane->inflight);
+        globus_fifo_destroy(&lane->verify);
+        if(lane->source_key)
+        {
+            globus_libc_free(lane->source_key);
+            globus_libc_free(lane->dest_key);
+        }
+    }
+    globus_fifo_destroy(&i_batch->queue);
+    globus_fifo_destroy(&i_batch->retry);
+    globus_mutex_destroy(&i_batch->mutex);
+    globus_ftp_client_operationattr_destroy(&i_batch->source_attr);
+    globus_ftp_client_operationattr_destroy(&i_batch->dest_attr);
+    globus_libc_free(i_batch->lanes);
+    globus_libc_free(i_batch);
+    *batch = GLOBUS_NULL;
+
+    return GLOBUS_SUCCESS;
+
+error:
+    return globus_error_put(err);
+}
+/* globus_ftp_client_batch_destroy() */
+
+/**
+ * Add a transfer to a batch.
+ * @ingroup globus_ftp_client_operations
+ *
+ * Items are started in the order they are added. Items may be added
+ * before the batch is started, and while it runs from the item
+ * callback of an earlier item.
+ *
+ * @param batch
+ *        The batch to add the transfer to.
+ * @param source_url
+ *        The ftp or gsiftp URL of the file to transfer.
+ * @param source_attr
+ *        Attributes for the source of this transfer, or GLOBUS_NULL to
+ *        use the batch's.
+ * @param dest_url
+ *        The ftp or gsiftp URL to transfer the file to.
+ * @param dest_attr
+ *        Attributes for the destination of this transfer, or
+ *        GLOBUS_NULL to use the batch's.
+ * @param offset
+ *        Offset in the file to start the transfer at, 0 for the whole
+ *        file.
+ * @param checksum_algorithm
+ *        If not GLOBUS_NULL, the destination file's checksum is computed
+ *        with this algorithm once the transfer is complete, and the item
+ *        fails if it does not match checksum.
+ * @param checksum
+ *        Expected checksum of the destination file.
+ * @param item_arg
+ *        Passed to the batch's item callback for this item.
+ */
+globus_result_t
+globus_ftp_client_batch_add(
+    globus_ftp_client_batch_t *			batch,
+    const char *				source_url,
+    globus_ftp_client_operationattr_t *		source_attr,
+    const char *				dest_url,
+    globus_ftp_client_operationattr_t *		dest_attr,
+    globus_off_t				offset,
+    const char *				checksum_algorithm,
+    const char *				checksum,
+    void *					item_arg)
+{
+    globus_i_ftp_client_batch_t *		i_batch;
+    globus_l_ftp_client_batch_item_t *		item;
+    globus_l_ftp_client_batch_lane_t *		idle = GLOBUS_NULL;
+    globus_object_t *				err;
+    globus_result_t				result;
+    globus_size_t				i;
+    GlobusFuncName(globus_ftp_client_batch_add);
+
+    if(batch == GLOBUS_NULL || *batch == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("batch");
+
+        goto error;
+    }
+    if(source_url == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("source_url");
+
+        goto error;
+    }
+    if(dest_url == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("dest_url");
+
+        goto error;
+    }
+    if(offset < 0)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_INVALID_PARAMETER("offset");
+
+        goto error;
+    }
+    if(checksum_algorithm && checksum == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("checksum");
+
+        goto error;
+    }
+    i_batch = *batch;
+
+    item = globus_libc_calloc(1, sizeof(globus_l_ftp_client_batch_item_t));
+    if(item == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_OUT_OF_MEMORY();
+
+        goto error;
+    }
+    item->source_key = globus_l_ftp_client_batch_key(source_url);
+    if(item->source_key == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_INVALID_PARAMETER("source_url");
+
+        goto free_item;
+    }
+    item->dest_key = globus_l_ftp_client_batch_key(dest_url);
+    if(item->dest_key == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_INVALID_PARAMETER("dest_url");
+
+        goto free_item;
+    }
+    item->source_url = globus_libc_strdup(source_url);
+    item->dest_url = globus_libc_strdup(dest_url);
+    if(checksum_algorithm)
+    {
+        item->checksum_algorithm = globus_libc_strdup(checksum_algorithm);
+        item->checksum = globus_libc_strdup(checksum);
+    }
+    if(source_attr)
+    {
+        result = globus_ftp_client_operationattr_copy(
+            &item->source_attr, source_attr);
+        if(result != GLOBUS_SUCCESS)
+        {
+            err = globus_error_get(result);
+
+            goto free_item;
+        }
+        item->own_source_attr = GLOBUS_TRUE;
+    }
+    if(dest_attr)
+    {
+        result = globus_ftp_client_operationattr_copy(
+            &item->dest_attr, dest_attr);
+        if(result != GLOBUS_SUCCESS)
+        {
+            err = globus_error_get(result);
+
+            goto free_item;
+        }
+        item->own_dest_attr = GLOBUS_TRUE;
+    }
+    item->batch = i_batch;
+    item->offset = offset;
+    item->item_arg = item_arg;
+    item->pipelinable =
+        !item->own_source_attr && !item->own_dest_attr && offset == 0;
+
+    globus_mutex_lock(&i_batch->mutex);
+    {
+        globus_fifo_enqueue(&i_batch->queue, item);
+        i_batch->pending++;
+        if(i_batch->started)
+        {
+            for(i = 0; i < i_batch->lane_count && idle == GLOBUS_NULL; i++)
+            {
+                if(!i_batch->lanes[i].busy)
+                {
+                    idle = &i_batch->lanes[i];
+                    idle->busy = GLOBUS_TRUE;
+                }
+            }
+        }
+    }
+    globus_mutex_unlock(&i_batch->mutex);
+
+    if(idle)
+    {
+        globus_l_ftp_client_batch_lane_next(idle);
+    }
+
+    return GLOBUS_SUCCESS;
+
+free_item:
+    globus_l_ftp_client_batch_item_destroy(item);
+error:
+    return globus_error_put(err);
+}
+/* globus_ftp_client_batch_add() */
+
+/**
+ * Start a batch transfer.
+ * @ingroup globus_ftp_client_operations
+ *
+ * The batch's connections start taking items from its queue. The
+ * complete callback is called once every item added to the batch has
+ * been reported to the item callback.
+ *
+ * @param batch
+ *        The batch to start.
+ * @param complete_callback
+ *        Called when the batch is complete, with the number of items
+ *        which failed.
+ * @param callback_arg
+ *        Argument passed to complete_callback.
+ */
+globus_result_t
+globus_ftp_client_batch_start(
+    globus_ftp_client_batch_t *			batch,
+    globus_ftp_client_batch_complete_callback_t	complete_callback,
+    void *					callback_arg)
+{
+    globus_i_ftp_client_batch_t *		i_batch;
+    globus_object_t *				err;
+    globus_bool_t				empty;
+    globus_size_t				i;
+    GlobusFuncName(globus_ftp_client_batch_start);
+
+    if(batch == GLOBUS_NULL || *batch == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("batch");
+
+        goto error;
+    }
+    if(complete_callback == GLOBUS_NULL)
+    {
+        err = GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("complete_callback");
+
+        goto error;
+    }
+    i_batch = *batch;
+
+    globus_mutex_lock(&i_batch->mutex);
+    if(i_batch->started)
+    {
+        globus_mutex_unlock(&i_batch->mutex);
+        err = GLOBUS_I_FTP_CLIENT_ERROR_ALREADY_DONE();
+
+        goto error;
+    }
+    i_batch->started = GLOBUS_TRUE;
+    i_batch->complete_callback = complete_callback;
+    i_batch->complete_callback_arg = callback_arg;
+    empty = (i_batch->pending == 0);
+    for(i = 0; i < i_batch->lane_count; i++)
+    {
+        i_batch->lanes[i].busy = GLOBUS_TRUE;
+    }
+    globus_mutex_unlock(&i_batch->mutex);
+
+    if(empty)
+    {
+        globus_callback_register_oneshot(
+            GLOBUS_NULL,
+            GLOBUS_NULL,
+            globus_l_ftp_client_batch_empty_kickout,
+            i_batch);
+    }
+    else
+    {
+        for(i = 0; i < i_batch->lane_count; i++)
+        {
+            globus_l_ftp_client_batch_lane_next(&i_batch->lanes[i]);
+        }
+    }
+
+    return GLOBUS_SUCCESS;
+
+error:
+    return globus_error_put(err);
+}
+/* globus_ftp_client_batch_start() */
+/* @} */
+
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+/**
+ * Complete a batch which was started with no items.
+ * @internal
+ */
+static
+void
+globus_l_ftp_client_batch_empty_kickout(
+    void *					user_arg)
+{
+    globus_i_ftp_client_batch_t *		i_batch;
+    globus_bool_t				done = GLOBUS_FALSE;
+    globus_size_t				i;
+
+    i_batch = user_arg;
+
+    globus_mutex_lock(&i_batch->mutex);
+    {
+        for(i = 0; i < i_batch->lane_count; i++)
+        {
+            i_batch->lanes[i].busy = GLOBUS_FALSE;
+        }
+        /* an item may have been added since, and finished */
+        if(i_batch->pending == 0 && !i_batch->completed)
+        {
+            i_batch->completed = GLOBUS_TRUE;
+            done = GLOBUS_TRUE;
+        }
+    }
+    globus_mutex_unlock(&i_batch->mutex);
+
+    if(done)
+    {
+        i_batch->complete_callback(
+            i_batch->complete_callback_arg, i_batch->failed);
+    }
+}
+/* globus_l_ftp_client_batch_empty_kickout() */
+
+/**
+ * Key identifying the server and login of a URL.
+ * @internal
+ *
+ * @return A new string, or GLOBUS_NULL if the URL is not an ftp or
+ *         gsiftp URL.
+ */
+static
+char *
+globus_l_ftp_client_batch_key(
+    const char *				url)
+{
+    globus_url_t				parsed;
+    char *					key = GLOBUS_NULL;
+
+    if(globus_url_parse(url, &parsed) != GLOBUS_SUCCESS)
+    {
+        return GLOBUS_NULL;
+    }
+    if(parsed.scheme_type == GLOBUS_URL_SCHEME_FTP ||
+       parsed.scheme_type == GLOBUS_URL_SCHEME_GSIFTP)
+    {
+        key = globus_common_create_string(
+            "%s://%s@%s:%u",
+            parsed.scheme,
+            parsed.user ? parsed.user : "",
+            parsed.host,
+            (unsigned int) parsed.port);
+    }
+    globus_url_destroy(&parsed);
+
+    return key;
+}
+/* globus_l_ftp_client_batch_key() */
+
+static
+void
+globus_l_ftp_client_batch_item_destroy(
+    globus_l_ftp_client_batch_item_t *		item)
+{
+    if(item->own_source_attr)
+    {
+        globus_ftp_client_operationattr_destroy(&item->source_attr);
+    }
+    if(item->own_dest_attr)
+    {
+        globus_ftp_client_operationattr_destroy(&item->dest_attr);
+    }
+    if(item->error)
+    {
+        globus_object_free(item->error);
+    }
+    globus_libc_free(item->source_url);
+    globus_libc_free(item->dest_url);
+    globus_libc_free(item->source_key);
+    globus_libc_free(item->dest_key);
+    globus_libc_free(item->checksum_algorithm);
+    globus_libc_free(item->checksum);
+    globus_libc_free(item);
+}
+/* globus_l_ftp_client_batch_item_destroy() */
+
+/**
+ * Tell the application an item is complete, and complete the batch
+ * after its last item.
+ * @internal
+ *
+ * @note This function must not be called with the batch mutex locked.
+ */
+static
+void
+globus_l_ftp_client_batch_report(
+    globus_i_ftp_client_batch_t *		batch,
+    globus_l_ftp_client_batch_item_t *		item)
+{
+    globus_bool_t				done = GLOBUS_FALSE;
+
+    batch->item_callback(
+        batch->item_callback_arg,
+        item->source_url,
+        item->dest_url,
+        item->item_arg,
+        item->error);
+
+    globus_mutex_lock(&batch->mutex);
+    {
+        if(item->error)
+        {
+            batch->failed++;
+        }
+        batch->pending--;
+        if(batch->pending == 0 && batch->started && !batch->completed)
+        {
+            batch->completed = GLOBUS_TRUE;
+            done = GLOBUS_TRUE;
+        }
+    }
+    globus_mutex_unlock(&batch->mutex);
+
+    globus_l_ftp_client_batch_item_destroy(item);
+
+    if(done)
+    {
+        batch->complete_callback(batch->complete_callback_arg, batch->failed);
+    }
+}
+/* globus_l_ftp_client_batch_report() */
+
+/**
+ * Report an item from a callback of its own.
+ * @internal
+ *
+ * Items seen to complete by the batch plugin are reported this way, as
+ * the plugin is called with the handle locked.
+ */
+static
+void
+globus_l_ftp_client_batch_report_kickout(
+    void *					user_arg)
+{
+    globus_l_ftp_client_batch_item_t *		item;
+
+    item = user_arg;
+    globus_l_ftp_client_batch_report(item->batch, item);
+}
+/* globus_l_ftp_client_batch_report_kickout() */
+
+/**
+ * Start the next thing a lane has to do: verify the checksum of an item
+ * it transferred, or start the next transfer in the queue.
+ * @internal
+ *
+ * The lane must be marked busy by the caller. It is marked idle when
+ * there is nothing left to do.
+ *
+ * @note This function must not be called with the batch mutex locked.
+ */
+static
+void
+globus_l_ftp_client_batch_lane_next(
+    globus_l_ftp_client_batch_lane_t *		lane)
+{
+    globus_i_ftp_client_batch_t *		batch;
+    globus_l_ftp_client_batch_item_t *		item;
+    globus_ftp_client_operationattr_t *		source_attr;
+    globus_ftp_client_operationattr_t *		dest_attr;
+    globus_result_t				result;
+    globus_bool_t				retry;
+
+    batch = lane->batch;
+
+    for(;;)
+    {
+        globus_mutex_lock(&batch->mutex);
+
+        if(!globus_fifo_empty(&lane->verify))
+        {
+            item = globus_fifo_dequeue(&lane->verify);
+            lane->verifying = item;
+            globus_mutex_unlock(&batch->mutex);
+
+            lane->checksum[0] = '\0';
+            result = globus_ftp_client_cksm(
+                &lane->handle,
+                item->dest_url,
+                item->own_dest_attr ? &item->dest_attr : &batch->dest_attr,
+                lane->checksum,
+                0,
+                -1,
+                item->checksum_algorithm,
+                globus_l_ftp_client_batch_cksm_callback,
+                lane);
+            if(result == GLOBUS_SUCCESS)
+            {
+                return;
+            }
+            lane->verifying = GLOBUS_NULL;
+            item->error = globus_error_get(result);
+            globus_l_ftp_client_batch_report(batch, item);
+            continue;
+        }
+
+        retry = !globus_fifo_empty(&batch->retry);
+        if(!retry && globus_fifo_empty(&batch->queue))
+        {
+            lane->busy = GLOBUS_FALSE;
+            globus_mutex_unlock(&batch->mutex);
+            return;
+        }
+        item = globus_fifo_dequeue(retry ? &batch->retry : &batch->queue);
+        globus_fifo_enqueue(&lane->inflight, item);
+
+        if(lane->source_key)
+        {
+            globus_libc_free(lane->source_key);
+            globus_libc_free(lane->dest_key);
+        }
+        lane->source_key = globus_libc_strdup(item->source_key);
+        lane->dest_key = globus_libc_strdup(item->dest_key);
+        lane->pipeline = item->pipelinable && !retry;
+        globus_mutex_unlock(&batch->mutex);
+
+        source_attr =
+            item->own_source_attr ? &item->source_attr : &batch->source_attr;
+        dest_attr =
+            item->own_dest_attr ? &item->dest_attr : &batch->dest_attr;
+        if(item->offset > 0)
+        {
+            result = globus_ftp_client_partial_third_party_transfer(
+                &lane->handle,
+                item->source_url,
+                source_attr,
+                item->dest_url,
+                dest_attr,
+                GLOBUS_NULL,
+                item->offset,
+                -1,
+                globus_l_ftp_client_batch_transfer_callback,
+                lane);
+        }
+        else
+        {
+            result = globus_ftp_client_third_party_transfer(
+                &lane->handle,
+                item->source_url,
+                source_attr,
+                item->dest_url,
+                dest_attr,
+                GLOBUS_NULL,
+                globus_l_ftp_client_batch_transfer_callback,
+                lane);
+        }
+        if(result == GLOBUS_SUCCESS)
+        {
+            return;
+        }
+
+        /* nothing was sent, so nothing more can have been pipelined */
+        globus_mutex_lock(&batch->mutex);
+        {
+            lane->pipeline = GLOBUS_FALSE;
+            globus_fifo_remove(&lane->inflight, item);
+        }
+        globus_mutex_unlock(&batch->mutex);
+        item->error = globus_error_get(result);
+        globus_l_ftp_client_batch_report(batch, item);
+    }
+}
+/* globus_l_ftp_client_batch_lane_next() */
+
+/**
+ * Transfer complete callback.
+ * @internal
+ *
+ * Items the batch plugin has not already seen complete are complete
+ * now if the transfer succeeded. If it failed, the first of them is the
+ * one which failed, and the others are retried on their own as the
+ * server may never have acted on their commands.
+ */
+static
+void
+globus_l_ftp_client_batch_transfer_callback(
+    void *					user_arg,
+    globus_ftp_client_handle_t *		handle,
+    globus_object_t *				error)
+{
+    globus_l_ftp_client_batch_lane_t *		lane;
+    globus_i_ftp_client_batch_t *		batch;
+    globus_l_ftp_client_batch_item_t *		item;
+    globus_fifo_t				done;
+
+    lane = user_arg;
+    batch = lane->batch;
+    globus_fifo_init(&done);
+
+    globus_mutex_lock(&batch->mutex);
+    {
+        lane->pipeline = GLOBUS_FALSE;
+        if(error && !globus_fifo_empty(&lane->inflight))
+        {
+            item = globus_fifo_dequeue(&lane->inflight);
+            item->error = globus_object_copy(error);
+            globus_fifo_enqueue(&done, item);
+        }
+        while(!globus_fifo_empty(&lane->inflight))
+        {
+            item = globus_fifo_dequeue(&lane->inflight);
+            if(error)
+            {
+                item->pipelinable = GLOBUS_FALSE;
+                globus_fifo_enqueue(&batch->retry, item);
+            }
+            else if(item->checksum_algorithm)
+            {
+                globus_fifo_enqueue(&lane->verify, item);
+            }
+            else
+            {
+                globus_fifo_enqueue(&done, item);
+            }
+        }
+    }
+    globus_mutex_unlock(&batch->mutex);
+
+    while(!globus_fifo_empty(&done))
+    {
+        globus_l_ftp_client_batch_report(batch, globus_fifo_dequeue(&done));
+    }
+    globus_fifo_destroy(&done);
+
+    globus_l_ftp_client_batch_lane_next(lane);
+}
+/* globus_l_ftp_client_batch_transfer_callback() */
+
+/**
+ * Checksum complete callback.
+ * @internal
+ */
+static
+void
+globus_l_ftp_client_batch_cksm_callback(
+    void *					user_arg,
+    globus_ftp_client_handle_t *		handle,
+    globus_object_t *				error)
+{
+    globus_l_ftp_client_batch_lane_t *		lane;
+    globus_l_ftp_client_batch_item_t *		item;
+    GlobusFuncName(globus_l_ftp_client_batch_cksm_callback);
+
+    lane = user_arg;
+    item = lane->verifying;
+    lane->verifying = GLOBUS_NULL;
+
+    if(error)
+    {
+        item->error = globus_object_copy(error);
+    }
+    else if(strcasecmp(lane->checksum, item->checksum) != 0)
+    {
+        item->error = GLOBUS_I_FTP_CLIENT_ERROR_CHECKSUM_MISMATCH(
+            item->dest_url, lane->checksum, item->checksum);
+    }
+    globus_l_ftp_client_batch_report(lane->batch, item);
+    globus_l_ftp_client_batch_lane_next(lane);
+}
+/* globus_l_ftp_client_batch_cksm_callback() */
+
+/**
+ * Pipeline callback.
+ * @internal
+ *
+ * Gives the FTP client the next item in the queue if it can follow the
+ * current transfer: between the same servers, with the batch's
+ * attributes and no offset.
+ */
+static
+void
+globus_l_ftp_client_batch_pipeline(
+    globus_ftp_client_handle_t *		handle,
+    char **					source_url,
+    char **					dest_url,
+    void *					user_arg)
+{
+    globus_l_ftp_client_batch_lane_t *		lane;
+    globus_i_ftp_client_batch_t *		batch;
+    globus_l_ftp_client_batch_item_t *		item;
+
+    lane = user_arg;
+    batch = lane->batch;
+    *source_url = GLOBUS_NULL;
+    *dest_url = GLOBUS_NULL;
+
+    globus_mutex_lock(&batch->mutex);
+    {
+        if(lane->pipeline &&
+           globus_fifo_empty(&batch->retry) &&
+           !globus_fifo_empty(&batch->queue))
+        {
+            item = globus_fifo_peek(&batch->queue);
+            if(item->pipelinable &&
+               strcmp(item->source_key, lane->source_key) == 0 &&
+               strcmp(item->dest_key, lane->dest_key) == 0)
+            {
+                globus_fifo_dequeue(&batch->queue);
+                globus_fifo_enqueue(&lane->inflight, item);
+                *source_url = item->source_url;
+                *dest_url = item->dest_url;
+            }
+            else
+            {
+                lane->pipeline = GLOBUS_FALSE;
+            }
+        }
+    }
+    globus_mutex_unlock(&batch->mutex);
+}
+/* globus_l_ftp_client_batch_pipeline() */
+
+/**
+ * Batch plugin response callback.
+ * @internal
+ *
+ * Watches the destination server's replies to find when each pipelined
+ * item is complete: the preliminary reply to its STOR or ESTO, then the
+ * completion reply.
+ */
+static
+void
+globus_l_ftp_client_batch_plugin_response(
+    globus_ftp_client_plugin_t *		plugin,
+    void *					plugin_specific,
+    globus_ftp_client_handle_t *		handle,
+    const char *				url,
+    globus_object_t *				error,
+    const globus_ftp_control_response_t *	ftp_response)
+{
+    globus_l_ftp_client_batch_lane_t *		lane;
+    globus_i_ftp_client_batch_t *		batch;
+    globus_l_ftp_client_batch_item_t *		item;
+    globus_l_ftp_client_batch_item_t *		done = GLOBUS_NULL;
+
+    lane = plugin_specific;
+    batch = lane->batch;
+
+    if(error || ftp_response == GLOBUS_NULL || url == GLOBUS_NULL)
+    {
+        return;
+    }
+
+    globus_mutex_lock(&batch->mutex);
+    {
+        if(!globus_fifo_empty(&lane->inflight))
+        {
+            item = globus_fifo_peek(&lane->inflight);
+            if(strcmp(url, item->dest_url) != 0)
+            {
+                /* source replies, or not ours */
+            }
+            else if(ftp_response->code == 125 || ftp_response->code == 150)
+            {
+                item->started = GLOBUS_TRUE;
+            }
+            else if(item->started &&
+                    ftp_response->response_class ==
+                        GLOBUS_FTP_POSITIVE_COMPLETION_REPLY)
+            {
+                globus_fifo_dequeue(&lane->inflight);
+                if(item->checksum_algorithm)
+                {
+                    globus_fifo_enqueue(&lane->verify, item);
+                }
+                else
+                {
+                    done = item;
+                }
+            }
+        }
+    }
+    globus_mutex_unlock(&batch->mutex);
+
+    if(done)
+    {
+        globus_callback_register_oneshot(
+            GLOBUS_NULL,
+            GLOBUS_NULL,
+            globus_l_ftp_client_batch_report_kickout,
+            done);
+    }
+}
+/* globus_l_ftp_client_batch_plugin_response() */
+
+static
+globus_result_t
+globus_l_ftp_client_batch_plugin_init(
+    globus_ftp_client_plugin_t *		plugin,
+    globus_l_ftp_client_batch_lane_t *		lane)
+{
+    globus_result_t				result;
+
+    result = globus_ftp_client_plugin_init(
+        plugin,
+        GLOBUS_L_FTP_CLIENT_BATCH_PLUGIN_NAME,
+        GLOBUS_FTP_CLIENT_CMD_MASK_ALL,
+        lane);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return result;
+    }
+    globus_ftp_client_plugin_set_copy_func(
+        plugin, globus_l_ftp_client_batch_plugin_copy);
+    globus_ftp_client_plugin_set_destroy_func(
+        plugin, globus_l_ftp_client_batch_plugin_destroy);
+    globus_ftp_client_plugin_set_response_func(
+        plugin, globus_l_ftp_client_batch_plugin_response);
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_l_ftp_client_batch_plugin_init() */
+
+static
+globus_ftp_client_plugin_t *
+globus_l_ftp_client_batch_plugin_copy(
+    globus_ftp_client_plugin_t *		plugin_template,
+    void *					plugin_specific)
+{
+    globus_ftp_client_plugin_t *		plugin;
+
+    plugin = globus_libc_malloc(sizeof(globus_ftp_client_plugin_t));
+    if(plugin == GLOBUS_NULL)
+    {
+        return GLOBUS_NULL;
+    }
+    if(globus_l_ftp_client_batch_plugin_init(plugin, plugin_specific)
+        != GLOBUS_SUCCESS)
+    {
+        globus_libc_free(plugin);
+        return GLOBUS_NULL;
+    }
+
+    return plugin;
+}
+/* globus_l_ftp_client_batch_plugin_copy() */
+
+static
+void
+globus_l_ftp_client_batch_plugin_destroy(
+    globus_ftp_client_plugin_t *		plugin,
+    void *					plugin_specific)
+{
+    globus_ftp_client_plugin_destroy(plugin);
+    globus_libc_free(plugin);
+}
+/* globus_l_ftp_client_batch_plugin_destroy() */
+#endif
@@ -0,0 +1,672 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+
+/**
+ * @file globus_ftp_client_bundle.c
+ * @brief Bundle transfers
+ */
+
+#include "globus_i_ftp_client.h"
+
+#define GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER_MAX 96
+#define GLOBUS_L_FTP_CLIENT_BUNDLE_NAME_MAX 4096
+
+/* Module specific data types */
+/**
+ * Bundle parser state enumeration.
+ * @internal
+ *
+ * Each file in a bundle stream is a header line, a name and the file
+ * data. This enumeration shows which part the parser is in.
+ */
+typedef enum
+{
+    GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER,
+    GLOBUS_L_FTP_CLIENT_BUNDLE_NAME,
+    GLOBUS_L_FTP_CLIENT_BUNDLE_DATA
+}
+globus_l_ftp_client_bundle_state_t;
+
+/**
+ * Out of order bundle data.
+ * @internal
+ *
+ * Data which arrives ahead of the parser is copied and held here until
+ * the data before it has been parsed.
+ */
+typedef struct
+{
+    globus_off_t				offset;
+    globus_size_t				length;
+    globus_byte_t *				buffer;
+}
+globus_l_ftp_client_bundle_piece_t;
+
+/**
+ * Bundle parser.
+ * @internal
+ */
+typedef struct globus_i_ftp_client_bundle_parser_s
+{
+    /** User callback for file data */
+    globus_ftp_client_bundle_callback_t		callback;
+    void *					callback_arg;
+
+    /** Offset in the stream of the next byte to parse */
+    globus_off_t				offset;
+
+    /** Pieces received ahead of offset, ordered by offset */
+    globus_priority_q_t				pieces;
+
+    globus_l_ftp_client_bundle_state_t		state;
+    char					header[
+					GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER_MAX];
+    int						header_length;
+    char					name[
+					GLOBUS_L_FTP_CLIENT_BUNDLE_NAME_MAX];
+    int						name_length;
+    int						name_fill;
+    globus_off_t				size;
+    int						mode;
+    time_t					mtime;
+    globus_off_t				remaining;
+
+    /** Set once the stream is found to be malformed */
+    globus_bool_t				failed;
+}
+globus_i_ftp_client_bundle_parser_t;
+
+/* Module specific prototypes */
+static
+int
+globus_l_ftp_client_bundle_offset_cmp(
+    void *					priority_1,
+    void *					priority_2);
+
+static
+globus_result_t
+globus_l_ftp_client_bundle_parse(
+    globus_i_ftp_client_bundle_parser_t *	parser,
+    globus_byte_t *				buffer,
+    globus_size_t				length);
+
+#endif
+
+/**
+ * @name Bundle Transfers
+ */
+/* @{ */
+/**
+ * Get a directory of files as a bundle.
+ * @ingroup globus_ftp_client_operations
+ *
+ * This function starts a "bundle get" of the directory named by the url.
+ * The server sends every file in the directory over the data channel as
+ * one stream, which the application reads with
+ * globus_ftp_client_register_read() and passes to a bundle parser.
+ * Many small files are moved this way without a transfer command for
+ * each of them.
+ *
+ * The server must support the BUNDLE feature, see
+ * globus_ftp_client_feat().
+ *
+ * @param u_handle
+ *        An FTP Client handle to use for the get operation.
+ * @param url
+ *        The URL of the directory to download. The URL may be an ftp or
+ *        gsiftp URL.
+ * @param attr
+ *        Attributes for this transfer.
+ * @param recursive
+ *        If GLOBUS_TRUE, files in subdirectories are included, named by
+ *        their path relative to the url.
+ * @param complete_callback
+ *        Callback to be invoked once the get is completed.
+ * @param callback_arg
+ *        Argument to be passed to the complete_callback.
+ *
+ * @return
+ *        This function returns an error when any of the conditions listed
+ *        for globus_ftp_client_extended_get() are true.
+ *
+ * @see globus_ftp_client_bundle_parser_init()
+ */
+globus_result_t
+globus_ftp_client_bundle_get(
+    globus_ftp_client_handle_t *		u_handle,
+    const char *				url,
+    globus_ftp_client_operationattr_t *		attr,
+    globus_bool_t				recursive,
+    globus_ftp_client_complete_callback_t	complete_callback,
+    void *					callback_arg)
+{
+    return globus_ftp_client_extended_get(
+        u_handle,
+        url,
+        attr,
+        GLOBUS_NULL,
+        recursive ? "bundle=\"R\"" : "bundle=\"F\"",
+        complete_callback,
+        callback_arg);
+}
+/* globus_ftp_client_bundle_get() */
+
+/**
+ * Put a bundle of files into a directory.
+ * @ingroup globus_ftp_client_operations
+ *
+ * This function starts a "bundle put" into the directory named by the
+ * url, which is created if it does not exist. The application writes
+ * the bundle stream with globus_ftp_client_register_write(), framing
+ * each file with globus_ftp_client_bundle_header(). File names may
+ * contain subdirectories, which the server creates.
+ *
+ * @param u_handle
+ *        An FTP Client handle to use for the put operation.
+ * @param url
+ *        The URL of the directory to store the files in.
+ * @param attr
+ *        Attributes for this transfer.
+ * @param complete_callback
+ *        Callback to be invoked once the put is completed.
+ * @param callback_arg
+ *        Argument to be passed to the complete_callback.
+ *
+ * @return
+ *        This function returns an error when any of the conditions listed
+ *        for globus_ftp_client_extended_put() are true.
+ */
+globus_result_t
+globus_ftp_client_bundle_put(
+    globus_ftp_client_handle_t *		u_handle,
+    const char *				url,
+    globus_ftp_client_operationattr_t *		attr,
+    globus_ftp_client_complete_callback_t	complete_callback,
+    void *					callback_arg)
+{
+    return globus_ftp_client_extended_put(
+        u_handle,
+        url,
+        attr,
+        GLOBUS_NULL,
+        "bundle=\"F\"",
+        complete_callback,
+        callback_arg);
+}
+/* globus_ftp_client_bundle_put() */
+
+/**
+ * Write the header for a file in a bundle.
+ * @ingroup globus_ftp_client_operations
+ *
+ * The header and the name are written to buffer, and must be followed in
+ * the stream by exactly size bytes of file data.
+ *
+ * @param buffer
+ *        Buffer to write the header into.
+ * @param buffer_length
+ *        Size of buffer.
+ * @param name
+ *        Name of the file, relative to the bundle directory. It must not
+ *        start with '/' or contain a ".." component.
+ * @param size
+ *        Size of the file data.
+ * @param mode
+ *        Permission bits to create the file with.
+ * @param mtime
+ *        Modification time to set on the file.
+ * @param header_length
+ *        Set to the number of bytes written to buffer.
+ *
+ * @return
+ *        This function returns an error if buffer is too small for the
+ *        header.
+ */
+globus_result_t
+globus_ftp_client_bundle_header(
+    globus_byte_t *				buffer,
+    globus_size_t				buffer_length,
+    const char *				name,
+    globus_off_t				size,
+    int						mode,
+    time_t					mtime,
+    globus_size_t *				header_length)
+{
+    char					header[
+					GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER_MAX];
+    int						len;
+    int						name_len;
+    GlobusFuncName(globus_ftp_client_bundle_header);
+
+    if(buffer == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("buffer"));
+    }
+    if(name == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("name"));
+    }
+    name_len = strlen(name);
+    if(name_len == 0 || name_len >= GLOBUS_L_FTP_CLIENT_BUNDLE_NAME_MAX ||
+        size < 0)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_INVALID_PARAMETER("name"));
+    }
+
+    len = snprintf(header, sizeof(header),
+        "F %" GLOBUS_OFF_T_FORMAT " %o %ld %d\n",
+        size, mode & 07777, (long) mtime, name_len);
+    if(len + name_len > buffer_length)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_INVALID_PARAMETER("buffer_length"));
+    }
+    memcpy(buffer, header, len);
+    memcpy(buffer + len, name, name_len);
+    *header_length = len + name_len;
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_bundle_header() */
+
+/**
+ * Initialize a bundle parser.
+ * @ingroup globus_ftp_client_operations
+ *
+ * A bundle parser splits the data read from a bundle get into files. The
+ * callback is invoked with each piece of file data in order, and with
+ * eof set to GLOBUS_TRUE on the last piece of each file. Empty files get
+ * one callback with a length of 0.
+ *
+ * @param parser
+ *        The parser to initialize.
+ * @param callback
+ *        Callback to be invoked with file data.
+ * @param callback_arg
+ *        Argument to be passed to the callback.
+ */
+globus_result_t
+globus_ftp_client_bundle_parser_init(
+    globus_ftp_client_bundle_parser_t *		parser,
+    globus_ftp_client_bundle_callback_t		callback,
+    void *					callback_arg)
+{
+    globus_i_ftp_client_bundle_parser_t *	i_parser;
+    GlobusFuncName(globus_ftp_client_bundle_parser_init);
+
+    if(parser == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("parser"));
+    }
+    if(callback == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("callback"));
+    }
+
+    i_parser = globus_libc_calloc(
+        1, sizeof(globus_i_ftp_client_bundle_parser_t));
+    if(i_parser == GLOBUS_NULL)
+    {
+        return globus_error_put(GLOBUS_I_FTP_CLIENT_ERROR_OUT_OF_MEMORY());
+    }
+    i_parser->callback = callback;
+    i_parser->callback_arg = callback_arg;
+    i_parser->state = GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER;
+    globus_priority_q_init(
+        &i_parser->pieces, globus_l_ftp_client_bundle_offset_cmp);
+
+    *parser = i_parser;
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_bundle_parser_init() */
+
+/**
+ * Destroy a bundle parser.
+ * @ingroup globus_ftp_client_operations
+ *
+ * @param parser
+ *        The parser to destroy.
+ */
+globus_result_t
+globus_ftp_client_bundle_parser_destroy(
+    globus_ftp_client_bundle_parser_t *		parser)
+{
+    globus_i_ftp_client_bundle_parser_t *	i_parser;
+    globus_l_ftp_client_bundle_piece_t *	piece;
+    GlobusFuncName(globus_ftp_client_bundle_parser_destroy);
+
+    if(parser == GLOBUS_NULL || *parser == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("parser"));
+    }
+    i_parser = *parser;
+
+    while(!globus_priority_q_empty(&i_parser->pieces))
+    {
+        piece = globus_priority_q_dequeue(&i_parser->pieces);
+        globus_libc_free(piece);
+    }
+    globus_priority_q_destroy(&i_parser->pieces);
+    globus_libc_free(i_parser);
+    *parser = GLOBUS_NULL;
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_bundle_parser_destroy() */
+
+/**
+ * Parse bundle data.
+ * @ingroup globus_ftp_client_operations
+ *
+ * Pass each buffer from a bundle get data callback to this function.
+ * Buffers may arrive in any order, as they do with parallel streams;
+ * data ahead of what has been parsed is copied and parsed once the data
+ * before it arrives. The buffer may be reused as soon as this function
+ * returns.
+ *
+ * @param parser
+ *        The parser.
+ * @param buffer
+ *        Data from the bundle stream.
+ * @param length
+ *        Length of buffer.
+ * @param offset
+ *        Offset of buffer in the bundle stream.
+ *
+ * @return
+ *        This function returns an error if the data is not a valid bundle
+ *        stream. All later calls with this parser will fail.
+ */
+globus_result_t
+globus_ftp_client_bundle_parser_parse(
+    globus_ftp_client_bundle_parser_t		parser,
+    globus_byte_t *				buffer,
+    globus_size_t				length,
+    globus_off_t				offset)
+{
+    globus_i_ftp_client_bundle_parser_t *	i_parser;
+    globus_l_ftp_client_bundle_piece_t *	piece;
+    globus_result_t				result;
+    globus_off_t				skip;
+    GlobusFuncName(globus_ftp_client_bundle_parser_parse);
+
+    i_parser = parser;
+    if(i_parser == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("parser"));
+    }
+    if(i_parser->failed)
+    {
+        return globus_error_put(GLOBUS_I_FTP_CLIENT_ERROR_PROTOCOL_ERROR());
+    }
+    if(length == 0)
+    {
+        return GLOBUS_SUCCESS;
+    }
+
+    if(offset > i_parser->offset)
+    {
+        piece = globus_libc_malloc(
+            sizeof(globus_l_ftp_client_bundle_piece_t) + length);
+        if(piece == GLOBUS_NULL)
+        {
+            return globus_error_put(GLOBUS_I_FTP_CLIENT_ERROR_OUT_OF_MEMORY());
+        }
+        piece->offset = offset;
+        piece->length = length;
+        piece->buffer = (globus_byte_t *) (piece + 1);
+        memcpy(piece->buffer, buffer, length);
+        globus_priority_q_enqueue(&i_parser->pieces, piece, &piece->offset);
+
+        return GLOBUS_SUCCESS;
+    }
+
+    /* skip anything already parsed */
+    skip = i_parser->offset - offset;
+    if(skip >= (globus_off_t) length)
+    {
+        return GLOBUS_SUCCESS;
+    }
+    result = globus_l_ftp_client_bundle_parse(
+        i_parser, buffer + skip, length - skip);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+
+    while(!globus_priority_q_empty(&i_parser->pieces))
+    {
+        piece = globus_priority_q_first(&i_parser->pieces);
+        if(piece->offset > i_parser->offset)
+        {
+            break;
+        }
+        globus_priority_q_dequeue(&i_parser->pieces);
+
+        result = GLOBUS_SUCCESS;
+        skip = i_parser->offset - piece->offset;
+        if(skip < (globus_off_t) piece->length)
+        {
+            result = globus_l_ftp_client_bundle_parse(
+                i_parser, piece->buffer + skip, piece->length - skip);
+        }
+        globus_libc_free(piece);
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto error;
+        }
+    }
+
+    return GLOBUS_SUCCESS;
+
+error:
+    i_parser->failed = GLOBUS_TRUE;
+    return result;
+}
+/* globus_ftp_client_bundle_parser_parse() */
+
+/**
+ * Check that a bundle stream was complete.
+ * @ingroup globus_ftp_client_operations
+ *
+ * Call this once the bundle get has completed successfully.
+ *
+ * @param parser
+ *        The parser.
+ *
+ * @return
+ *        This function returns an error if the stream ended in the middle
+ *        of a file or data is missing from it.
+ */
+globus_result_t
+globus_ftp_client_bundle_parser_finish(
+    globus_ftp_client_bundle_parser_t		parser)
+{
+    globus_i_ftp_client_bundle_parser_t *	i_parser;
+    GlobusFuncName(globus_ftp_client_bundle_parser_finish);
+
+    i_parser = parser;
+    if(i_parser == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("parser"));
+    }
+    if(i_parser->failed ||
+        i_parser->state != GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER ||
+        i_parser->header_length != 0 ||
+        !globus_priority_q_empty(&i_parser->pieces))
+    {
+        return globus_error_put(GLOBUS_I_FTP_CLIENT_ERROR_EOF());
+    }
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_bundle_parser_finish() */
+/* @} */
+
+/* Local/internal functions */
+#ifndef GLOBUS_DONT_DOCUMENT_INTERNAL
+static
+int
+globus_l_ftp_client_bundle_offset_cmp(
+    void *					priority_1,
+    void *					priority_2)
+{
+    globus_off_t *				offset_1;
+    globus_off_t *				offset_2;
+
+    offset_1 = (globus_off_t *) priority_1;
+    offset_2 = (globus_off_t *) priority_2;
+
+    if(*offset_1 < *offset_2)
+    {
+        return -1;
+    }
+    else if(*offset_1 > *offset_2)
+    {
+        return 1;
+    }
+    return 0;
+}
+/* globus_l_ftp_client_bundle_offset_cmp() */
+
+/**
+ * Parse the next part of a bundle stream.
+ * @internal
+ *
+ * This function is called with the bundle data in order, and invokes
+ * the user callback with the file data found in it.
+ */
+static
+globus_result_t
+globus_l_ftp_client_bundle_parse(
+    globus_i_ftp_client_bundle_parser_t *	parser,
+    globus_byte_t *				buffer,
+    globus_size_t				length)
+{
+    globus_size_t				pos = 0;
+    globus_size_t				n;
+    globus_off_t				size;
+    unsigned int				mode;
+    long					mtime;
+    GlobusFuncName(globus_l_ftp_client_bundle_parse);
+
+    while(pos < length)
+    {
+        switch(parser->state)
+        {
+          case GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER:
+            while(pos < length && buffer[pos] != '\n' &&
+                parser->header_length <
+                    GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER_MAX - 1)
+            {
+                parser->header[parser->header_length++] = buffer[pos++];
+            }
+            if(pos == length)
+            {
+                break;
+            }
+            if(buffer[pos] != '\n')
+            {
+                return globus_error_put(
+                    GLOBUS_I_FTP_CLIENT_ERROR_PROTOCOL_ERROR());
+            }
+            pos++;
+            parser->header[parser->header_length] = '\0';
+            parser->header_length = 0;
+            if(sscanf(parser->header,
+                "F %" GLOBUS_OFF_T_FORMAT " %o %ld %d",
+                &size, &mode, &mtime, &parser->name_length) != 4 ||
+                size < 0 || parser->name_length <= 0 ||
+                parser->name_length >= GLOBUS_L_FTP_CLIENT_BUNDLE_NAME_MAX)
+            {
+                return globus_error_put(
+                    GLOBUS_I_FTP_CLIENT_ERROR_PROTOCOL_ERROR());
+            }
+            parser->size = size;
+            parser->remaining = size;
+            parser->mode = mode;
+            parser->mtime = (time_t) mtime;
+            parser->name_fill = 0;
+            parser->state = GLOBUS_L_FTP_CLIENT_BUNDLE_NAME;
+            break;
+
+          case GLOBUS_L_FTP_CLIENT_BUNDLE_NAME:
+            n = parser->name_length - parser->name_fill;
+            n = n < length - pos ? n : length - pos;
+            memcpy(parser->name + parser->name_fill, buffer + pos, n);
+            parser->name_fill += n;
+            pos += n;
+            if(parser->name_fill < parser->name_length)
+            {
+                break;
+            }
+            parser->name[parser->name_length] = '\0';
+            parser->state = GLOBUS_L_FTP_CLIENT_BUNDLE_DATA;
+            if(parser->size == 0)
+            {
+                parser->state = GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER;
+                parser->callback(
+                    parser->callback_arg,
+                    parser->name,
+                    parser->size,
+                    parser->mode,
+                    parser->mtime,
+                    buffer + pos,
+                    0,
+                    0,
+                    GLOBUS_TRUE);
+            }
+            break;
+
+          case GLOBUS_L_FTP_CLIENT_BUNDLE_DATA:
+            n = parser->remaining < (globus_off_t) (length - pos) ?
+                (globus_size_t) parser->remaining : length - pos;
+            parser->remaining -= n;
+            if(parser->remaining == 0)
+            {
+                parser->state = GLOBUS_L_FTP_CLIENT_BUNDLE_HEADER;
+            }
+            parser->callback(
+                parser->callback_arg,
+                parser->name,
+                parser->size,
+                parser->mode,
+                parser->mtime,
+                buffer + pos,
+                n,
+                parser->size - parser->remaining - n,
+                parser->remaining == 0);
+            pos += n;
+            break;
+        }
+    }
+    parser->offset += length;
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_l_ftp_client_bundle_parse() */
+#endif
@@ -59,6 +59,48 @@ typedef struct
 }
 globus_l_ftp_client_target_search_t;
 
+#define GLOBUS_L_FTP_CLIENT_POOL_MAX_IDLE 64
+#define GLOBUS_L_FTP_CLIENT_POOL_MAX_IDLE_PER_SERVER 8
+#define GLOBUS_L_FTP_CLIENT_POOL_IDLE_TIMEOUT 300
+
+/**
+ * Process-wide pool of idle control connections.
+ * @internal
+ *
+ * Targets released idle by handles with the pool attribute set are kept
+ * here until another such handle needs a connection to the same server.
+ * The servers table maps "scheme://host:port" to a list of that server's
+ * idle targets, newest first, and all idle targets are also linked newest
+ * first through their pool_prev/pool_next fields so that the oldest can
+ * be closed when a limit is reached. Targets in the pool have no owner
+ * and nothing registered on their control handles.
+ */
+typedef struct
+{
+    globus_mutex_t				mutex;
+    globus_hashtable_t				servers;
+    globus_i_ftp_client_target_t *		newest;
+    globus_i_ftp_client_target_t *		oldest;
+    globus_size_t				max_idle;
+    globus_size_t				max_idle_per_server;
+    globus_reltime_t				idle_timeout;
+    globus_ftp_client_pool_stats_t		stats;
+}
+globus_l_ftp_client_pool_t;
+
+/**
+ * One server's idle targets in the connection pool.
+ * @internal
+ */
+typedef struct
+{
+    char *					key;
+    globus_list_t *				targets;
+}
+globus_l_ftp_client_pool_server_t;
+
+static globus_l_ftp_client_pool_t		globus_l_ftp_client_pool;
+
 /* MODULE SPECIFIC PROTOTYPES */
 static
 void
@@ -91,6 +133,32 @@ void
 globus_l_ftp_client_target_delete(
     globus_i_ftp_client_target_t *		target);
 
+static
+globus_i_ftp_client_target_t *
+globus_l_ftp_client_pool_get(
+    globus_url_t *				url,
+    globus_i_ftp_client_operationattr_t *	attr);
+
+static
+globus_bool_t
+globus_l_ftp_client_pool_put(
+    globus_i_ftp_client_target_t *		target);
+
+static
+void
+globus_l_ftp_client_pool_unlink(
+    globus_i_ftp_client_target_t *		target);
+
+static
+void
+globus_l_ftp_client_pool_trim(
+    globus_list_t **				evicted);
+
+static
+void
+globus_l_ftp_client_pool_delete(
+    globus_list_t *				evicted);
+
 #endif
 
 static char *                           globus_l_ftp_client_ssh_client_program = NULL;
@@ -392,7 +460,9 @@ globus_ftp_client_handle_destroy(
 	cache_entry = (globus_i_ftp_client_cache_entry_t *)
 	    globus_list_remove(&i_handle->attr.url_cache,
 			       i_handle->attr.url_cache);
-	if(cache_entry->target)
+	if(cache_entry->target &&
+	   !(i_handle->attr.use_pool &&
+	     globus_l_ftp_client_pool_put(cache_entry->target)))
 	{
 	    globus_l_ftp_client_target_delete(cache_entry->target);
 	}
@@ -533,6 +603,124 @@ error:
 /* globus_ftp_client_handle_flush_url_state() */
 /*@}*/
 
+/**
+ * @name Connection Pool
+ */
+/*@{*/
+/**
+ * Set the limits of the connection pool.
+ * @ingroup globus_ftp_client_handle
+ *
+ * Handles created with the pool handle attribute set leave their idle
+ * connections in a connection pool shared by the whole process, and take
+ * connections from it for new operations. The pool keeps at most
+ * max_idle connections, at most max_idle_per_server of them to any one
+ * server, and closes connections which have been idle for longer than
+ * idle_timeout. When a limit is reached, the connections which have been
+ * idle the longest are closed first. Setting either count to 0 stops
+ * connections from being added to the pool.
+ *
+ * @param max_idle
+ *        Maximum number of idle connections kept. The default is 64.
+ * @param max_idle_per_server
+ *        Maximum number of idle connections kept to each server. The
+ *        default is 8.
+ * @param idle_timeout
+ *        How long a connection may stay idle in the pool. If this is
+ *        GLOBUS_NULL, the timeout is not changed. The default is 300
+ *        seconds.
+ *
+ * @see globus_ftp_client_handleattr_set_pool()
+ */
+globus_result_t
+globus_ftp_client_pool_set_limits(
+    globus_size_t				max_idle,
+    globus_size_t				max_idle_per_server,
+    const globus_reltime_t *			idle_timeout)
+{
+    globus_list_t *				evicted = GLOBUS_NULL;
+
+    globus_mutex_lock(&globus_l_ftp_client_pool.mutex);
+    {
+        globus_l_ftp_client_pool.max_idle = max_idle;
+        globus_l_ftp_client_pool.max_idle_per_server = max_idle_per_server;
+        if(idle_timeout)
+        {
+            GlobusTimeReltimeCopy(globus_l_ftp_client_pool.idle_timeout,
+                                  *idle_timeout);
+        }
+        globus_l_ftp_client_pool_trim(&evicted);
+    }
+    globus_mutex_unlock(&globus_l_ftp_client_pool.mutex);
+
+    globus_l_ftp_client_pool_delete(evicted);
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_pool_set_limits() */
+
+/**
+ * Get the connection pool statistics.
+ * @ingroup globus_ftp_client_handle
+ *
+ * @param stats
+ *        Filled with the number of times a pooled connection was reused,
+ *        the number of times none could be, the number of connections
+ *        closed to stay within the pool limits, and the number of
+ *        connections now in the pool.
+ */
+globus_result_t
+globus_ftp_client_pool_get_stats(
+    globus_ftp_client_pool_stats_t *		stats)
+{
+    GlobusFuncName(globus_ftp_client_pool_get_stats);
+
+    if(stats == GLOBUS_NULL)
+    {
+        return globus_error_put(
+            GLOBUS_I_FTP_CLIENT_ERROR_NULL_PARAMETER("stats"));
+    }
+
+    globus_mutex_lock(&globus_l_ftp_client_pool.mutex);
+    {
+        *stats = globus_l_ftp_client_pool.stats;
+    }
+    globus_mutex_unlock(&globus_l_ftp_client_pool.mutex);
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_pool_get_stats() */
+
+/**
+ * Close all connections in the connection pool.
+ * @ingroup globus_ftp_client_handle
+ *
+ * Connections in use by handles are not affected, and may be put in the
+ * pool when the handles are done with them.
+ */
+globus_result_t
+globus_ftp_client_pool_flush(void)
+{
+    globus_list_t *				evicted = GLOBUS_NULL;
+    globus_i_ftp_client_target_t *		target;
+
+    globus_mutex_lock(&globus_l_ftp_client_pool.mutex);
+    {
+        while((target = globus_l_ftp_client_pool.oldest) != GLOBUS_NULL)
+        {
+            globus_l_ftp_client_pool_unlink(target);
+            globus_list_insert(&evicted, target);
+        }
+    }
+    globus_mutex_unlock(&globus_l_ftp_client_pool.mutex);
+
+    globus_l_ftp_client_pool_delete(evicted);
+
+    return GLOBUS_SUCCESS;
+}
+/* globus_ftp_client_pool_flush() */
+/*@}*/
+
 /**
  * @name User Pointer
  */
@@ -1403,7 +1591,8 @@ globus_i_ftp_client_target_release(
 		cache_entry->target = target;
 		GlobusTimeAbstimeGetCurrent(target->last_access);
 	    }
-            else
+            else if(!handle->attr.use_pool ||
+                    !globus_l_ftp_client_pool_put(target))
             {
 	        /* duplicate url in cache, can't add */
                 globus_i_ftp_client_debug_printf(1, 
@@ -1420,6 +1609,14 @@ globus_i_ftp_client_target_release(
 	}
     }
 
+    if(handle->attr.use_pool && globus_l_ftp_client_pool_put(target))
+    {
+        globus_i_ftp_client_debug_printf(1, 
+            (stderr, "globus_i_ftp_client_target_release() exiting, "
+            "target pooled\n"));
+
+        return;
+    }
     globus_l_ftp_client_target_delete(target);
     
     globus_i_ftp_client_debug_printf(1, 
@@ -1524,6 +1721,15 @@ globus_i_ftp_client_target_find(
 				      url,
 				      handle->attr.rfc1738_url);
     }
+    if((*target) == GLOBUS_NULL && handle->attr.use_pool)
+    {
+        /* another handle may have left an idle connection to this server */
+        (*target) = globus_l_ftp_client_pool_get(&parsed_url, attr);
+        if(*target)
+        {
+            (*target)->owner = handle;
+        }
+    }
     if((*target) == GLOBUS_NULL)
     {
 	/*
@@ -1801,6 +2007,42 @@ globus_l_ftp_client_quit_callback(
 }
 /* globus_l_ftp_client_quit_callback() */
 
+/**
+ * Check whether a connected target was authenticated as an operation
+ * with the given attributes would be.
+ *
+ * @param target
+ *        The cached or pooled target.
+ * @param url
+ *        The URL the operation is for.
+ * @param attr
+ *        The attributes of the operation.
+ */
+static
+globus_bool_t
+globus_l_ftp_client_auth_matches(
+    globus_i_ftp_client_target_t *		target,
+    globus_url_t *				url,
+    globus_i_ftp_client_operationattr_t *	attr)
+{
+    if(globus_ftp_control_auth_info_compare(
+           &target->attr->auth_info,
+           &attr->auth_info) == 0)
+    {
+        return GLOBUS_TRUE;
+    }
+    else if(attr->using_default_auth &&
+            url->scheme_type == GLOBUS_URL_SCHEME_GSIFTP &&
+            globus_ftp_control_auth_info_compare(
+                &target->attr->auth_info,
+                &globus_i_ftp_client_default_auth_info) == 0)
+    {
+        return GLOBUS_TRUE;
+    }
+    return GLOBUS_FALSE;
+}
+/* globus_l_ftp_client_auth_matches() */
+
 /**
  * Comparison predicate for searching the URL cache.
  *
@@ -1835,20 +2077,8 @@ globus_l_ftp_client_compare_canonically(
     {
         if(cache_entry->target && key->attr && !key->want_empty)
 	{
-	    if(globus_ftp_control_auth_info_compare(
-	           &cache_entry->target->attr->auth_info,
-		   &key->attr->auth_info) == 0)
-            {
-	        return GLOBUS_TRUE;
-            }
-	    else if(key->attr->using_default_auth &&
-	            key->url->scheme_type == GLOBUS_URL_SCHEME_GSIFTP &&
-		    globus_ftp_control_auth_info_compare(
-		        &cache_entry->target->attr->auth_info,
-			&globus_i_ftp_client_default_auth_info) == 0)
-	    {
-	        return GLOBUS_TRUE;
-	    }
+	    return globus_l_ftp_client_auth_matches(
+	        cache_entry->target, key->url, key->attr);
 	}
 	else
 	{
@@ -2152,4 +2382,355 @@ globus_i_ftp_client_cache_destroy(
     return GLOBUS_SUCCESS;
 }
 /* globus_i_ftp_client_cache_destroy() */
+
+/**
+ * Initialize the connection pool.
+ *
+ * Called when the module is activated.
+ */
+void
+globus_i_ftp_client_pool_init(void)
+{
+    globus_mutex_init(&globus_l_ftp_client_pool.mutex, GLOBUS_NULL);
+    globus_hashtable_init(&globus_l_ftp_client_pool.servers,
+                          16,
+                          globus_hashtable_string_hash,
+                          globus_hashtable_string_keyeq);
+    globus_l_ftp_client_pool.newest = GLOBUS_NULL;
+    globus_l_ftp_client_pool.oldest = GLOBUS_NULL;
+    globus_l_ftp_client_pool.max_idle = GLOBUS_L_FTP_CLIENT_POOL_MAX_IDLE;
+    globus_l_ftp_client_pool.max_idle_per_server =
+        GLOBUS_L_FTP_CLIENT_POOL_MAX_IDLE_PER_SERVER;
+    GlobusTimeReltimeSet(globus_l_ftp_client_pool.idle_timeout,
+                         GLOBUS_L_FTP_CLIENT_POOL_IDLE_TIMEOUT,
+                         0);
+    memset(&globus_l_ftp_client_pool.stats,
+           '\0',
+           sizeof(globus_ftp_client_pool_stats_t));
+}
+/* globus_i_ftp_client_pool_init() */
+
+/**
+ * Close all pooled connections and free the pool.
+ *
+ * Called when the module is deactivated, before waiting for the control
+ * handles to close.
+ */
+void
+globus_i_ftp_client_pool_destroy(void)
+{
+    globus_ftp_client_pool_flush();
+    globus_hashtable_destroy(&globus_l_ftp_client_pool.servers);
+    globus_mutex_destroy(&globus_l_ftp_client_pool.mutex);
+}
+/* globus_i_ftp_client_pool_destroy() */
+
+/**
+ * Pool key for a URL: connections are shared between URLs with the same
+ * scheme, host and port.
+ */
+static
+char *
+globus_l_ftp_client_pool_key(
+    globus_url_t *				url)
+{
+    return globus_common_create_string("%s://%s:%u",
+                                       url->scheme,
+                                       url->host,
+                                       (unsigned int) url->port);
+}
+/* globus_l_ftp_client_pool_key() */
+
+/**
+ * Take a target out of the pool.
+ *
+ * @note This function @a must be called with the pool mutex locked.
+ */
+static
+void
+globus_l_ftp_client_pool_unlink(
+    globus_i_ftp_client_target_t *		target)
+{
+    globus_l_ftp_client_pool_server_t *		server;
+    char *					key;
+
+    key = globus_l_ftp_client_pool_key(&target->url);
+    server = globus_hashtable_lookup(&globus_l_ftp_client_pool.servers, key);
+    globus_libc_free(key);
+
+    globus_list_remove(&server->targets,
+                       globus_list_search(server->targets, target));
+    if(globus_list_empty(server->targets))
+    {
+        globus_hashtable_remove(&globus_l_ftp_client_pool.servers,
+                                server->key);
+        globus_libc_free(server->key);
+        globus_libc_free(server);
+    }
+
+    if(target->pool_prev)
+    {
+        target->pool_prev->pool_next = target->pool_next;
+    }
+    else
+    {
+        globus_l_ftp_client_pool.newest = target->pool_next;
+    }
+    if(target->pool_next)
+    {
+        target->pool_next->pool_prev = target->pool_prev;
+    }
+    else
+    {
+        globus_l_ftp_client_pool.oldest = target->pool_prev;
+    }
+    target->pool_prev = GLOBUS_NULL;
+    target->pool_next = GLOBUS_NULL;
+    globus_l_ftp_client_pool.stats.idle--;
+}
+/* globus_l_ftp_client_pool_unlink() */
+
+/**
+ * Evict pooled targets which have been idle too long, and the oldest
+ * targets while there are more than the pool may keep.
+ *
+ * The evicted targets are added to the evicted list, to be deleted once
+ * the pool mutex has been unlocked.
+ *
+ * @note This function @a must be called with the pool mutex locked.
+ */
+static
+void
+globus_l_ftp_client_pool_trim(
+    globus_list_t **				evicted)
+{
+    globus_i_ftp_client_target_t *		target;
+    globus_abstime_t				expire_time;
+
+    GlobusTimeAbstimeGetCurrent(expire_time);
+    GlobusTimeAbstimeDec(expire_time, globus_l_ftp_client_pool.idle_timeout);
+
+    while((target = globus_l_ftp_client_pool.oldest) != GLOBUS_NULL &&
+          (globus_l_ftp_client_pool.stats.idle >
+               globus_l_ftp_client_pool.max_idle ||
+           globus_abstime_cmp(&target->last_access, &expire_time) < 0))
+    {
+        globus_l_ftp_client_pool_unlink(target);
+        globus_list_insert(evicted, target);
+        globus_l_ftp_client_pool.stats.evictions++;
+    }
+}
+/* globus_l_ftp_client_pool_trim() */
+
+/**
+ * Close targets taken out of the pool.
+ *
+ * @note This function must not be called with the pool mutex locked.
+ */
+static
+void
+globus_l_ftp_client_pool_delete(
+    globus_list_t *				evicted)
+{
+    while(!globus_list_empty(evicted))
+    {
+        globus_l_ftp_client_target_delete(
+            (globus_i_ftp_client_target_t *)
+                globus_list_remove(&evicted, evicted));
+    }
+}
+/* globus_l_ftp_client_pool_delete() */
+
+/**
+ * Take an idle target from the pool which can be used for an operation
+ * on a URL with the given attributes.
+ *
+ * A pooled target must have the same scheme, host, port, and
+ * authentication as the operation. For GSIFTP, a target left with
+ * subject DCAU is only reused for the same subject.
+ *
+ * @param url
+ *        The URL of the operation.
+ * @param attr
+ *        The attributes of the operation.
+ *
+ * @return The target, now out of the pool and with no owner, or
+ *         GLOBUS_NULL if there is none.
+ */
+static
+globus_i_ftp_client_target_t *
+globus_l_ftp_client_pool_get(
+    globus_url_t *				url,
+    globus_i_ftp_client_operationattr_t *	attr)
+{
+    globus_l_ftp_client_pool_server_t *		server;
+    globus_i_ftp_client_target_t *		target = GLOBUS_NULL;
+    globus_i_ftp_client_target_t *		candidate;
+    globus_list_t *				evicted = GLOBUS_NULL;
+    globus_list_t *				node;
+    char *					key;
+
+    key = globus_l_ftp_client_pool_key(url);
+
+    globus_mutex_lock(&globus_l_ftp_client_pool.mutex);
+    {
+        globus_l_ftp_client_pool_trim(&evicted);
+
+        server = globus_hashtable_lookup(
+            &globus_l_ftp_client_pool.servers, key);
+        for(node = server ? server->targets : GLOBUS_NULL;
+            !globus_list_empty(node);
+            node = globus_list_rest(node))
+        {
+            candidate = globus_list_first(node);
+
+            if(!globus_l_ftp_client_auth_matches(candidate, url, attr))
+            {
+                continue;
+            }
+            /* a different DCAU mode is sent again during setup, but a
+             * different subject with the same mode would not be
+             */
+            if(url->scheme_type == GLOBUS_URL_SCHEME_GSIFTP &&
+               attr->dcau.mode == GLOBUS_FTP_CONTROL_DCAU_SUBJECT &&
+               candidate->dcau.mode == GLOBUS_FTP_CONTROL_DCAU_SUBJECT &&
+               (candidate->dcau.subject.subject == GLOBUS_NULL ||
+                attr->dcau.subject.subject == GLOBUS_NULL ||
+                strcmp(candidate->dcau.subject.subject,
+                       attr->dcau.subject.subject) != 0))
+            {
+                continue;
+            }
+            target = candidate;
+            break;
+        }
+
+        if(target)
+        {
+            globus_l_ftp_client_pool_unlink(target);
+            globus_l_ftp_client_pool.stats.hits++;
+        }
+        else
+        {
+            globus_l_ftp_client_pool.stats.misses++;
+        }
+    }
+    globus_mutex_unlock(&globus_l_ftp_client_pool.mutex);
+
+    globus_libc_free(key);
+    globus_l_ftp_client_pool_delete(evicted);
+
+    return target;
+}
+/* globus_l_ftp_client_pool_get() */
+
+/**
+ * Put a target a handle no longer needs into the pool.
+ *
+ * Only targets left idle and connected after a completed operation are
+ * pooled. Adding a target may evict the oldest of that server's targets,
+ * or of all targets, to stay within the pool limits.
+ *
+ * @param target
+ *        The target being released.
+ *
+ * @return GLOBUS_TRUE if the target is now owned by the pool,
+ *         GLOBUS_FALSE if the caller must delete it.
+ */
+static
+globus_bool_t
+globus_l_ftp_client_pool_put(
+    globus_i_ftp_client_target_t *		target)
+{
+    globus_l_ftp_client_pool_server_t *		server;
+    globus_list_t *				evicted = GLOBUS_NULL;
+    globus_list_t *				node;
+    char *					key;
+
+    if(target->state != GLOBUS_FTP_CLIENT_TARGET_SETUP_CONNECTION)
+    {
+        return GLOBUS_FALSE;
+    }
+
+    key = globus_l_ftp_client_pool_key(&target->url);
+
+    globus_mutex_lock(&globus_l_ftp_client_pool.mutex);
+    {
+        if(globus_l_ftp_client_pool.max_idle == 0 ||
+           globus_l_ftp_client_pool.max_idle_per_server == 0)
+        {
+            globus_mutex_unlock(&globus_l_ftp_client_pool.mutex);
+            globus_libc_free(key);
+
+            return GLOBUS_FALSE;
+        }
+
+        /* the data connections belong to whatever the last handle was
+         * transferring with, the next owner will make its own
+         */
+        target->owner = GLOBUS_NULL;
+        memset(&target->cached_data_conn,
+               '\0',
+               sizeof(globus_i_ftp_client_data_target_t));
+        GlobusTimeAbstimeGetCurrent(target->last_access);
+
+        server = globus_hashtable_lookup(
+            &globus_l_ftp_client_pool.servers, key);
+        if(server == GLOBUS_NULL)
+        {
+            server = globus_libc_malloc(
+                sizeof(globus_l_ftp_client_pool_server_t));
+            server->key = key;
+            server->targets = GLOBUS_NULL;
+            globus_hashtable_insert(&globus_l_ftp_client_pool.servers,
+                                    server->key,
+                                    server);
+        }
+        else
+        {
+            globus_libc_free(key);
+        }
+        globus_list_insert(&server->targets, target);
+
+        target->pool_prev = GLOBUS_NULL;
+        target->pool_next = globus_l_ftp_client_pool.newest;
+        if(globus_l_ftp_client_pool.newest)
+        {
+            globus_l_ftp_client_pool.newest->pool_prev = target;
+        }
+        else
+        {
+            globus_l_ftp_client_pool.oldest = target;
+        }
+        globus_l_ftp_client_pool.newest = target;
+        globus_l_ftp_client_pool.stats.idle++;
+
+        /* the new target is first in the server's list, so this never
+         * empties it
+         */
+        while(globus_list_size(server->targets) >
+              globus_l_ftp_client_pool.max_idle_per_server)
+        {
+            for(node = server->targets;
+                !globus_list_empty(globus_list_rest(node));
+                node = globus_list_rest(node))
+            {
+            }
+            globus_list_insert(&evicted, globus_list_first(node));
+            globus_l_ftp_client_pool_unlink(globus_list_first(node));
+            globus_l_ftp_client_pool.stats.evictions++;
+        }
+        globus_l_ftp_client_pool_trim(&evicted);
+    }
+    globus_mutex_unlock(&globus_l_ftp_client_pool.mutex);
+
+    globus_l_ftp_client_pool_delete(evicted);
+
+    globus_i_ftp_client_debug_printf(1,
+        (stderr, "globus_l_ftp_client_pool_put() pooled %s\n",
+        target->url_string));
+
+    return GLOBUS_TRUE;
+}
+/* globus_l_ftp_client_pool_put() */
 #endif
@@ -5551,6 +5551,15 @@ globus_l_ftp_client_parse_feat(
 		        target->features, i, GLOBUS_FTP_CLIENT_FALSE);
 		}
 	    }
+	    if(globus_i_ftp_client_feature_get(
+		target->features, GLOBUS_FTP_CLIENT_FEATURE_BUNDLE) ==
+		GLOBUS_FTP_CLIENT_MAYBE)
+	    {
+		globus_i_ftp_client_feature_set(
+		    target->features,
+		    GLOBUS_FTP_CLIENT_FEATURE_BUNDLE,
+		    GLOBUS_FTP_CLIENT_FALSE);
+	    }
 	    return;
 	}
 	else if(first)
@@ -5681,6 +5690,13 @@ globus_l_ftp_client_parse_feat(
 	            GLOBUS_FTP_CLIENT_FEATURE_MLST,
 	            GLOBUS_FTP_CLIENT_TRUE);
 	    }
+	    else if(strncmp(feature_label, "BUNDLE", 6) == 0)
+	    {
+	        globus_i_ftp_client_feature_set(
+	            target->features,
+	            GLOBUS_FTP_CLIENT_FEATURE_BUNDLE,
+	            GLOBUS_FTP_CLIENT_TRUE);
+	    }
             else if(strncmp(feature_label, "PASV", 4) == 0)
 	    {
 		if(strstr(feature_parms, "AllowDelayed"))
@@ -201,6 +201,12 @@ typedef struct globus_i_ftp_client_handleattr_t
      */
     globus_bool_t                               cache_all;
 
+    /**
+     * Share idle control connections with other handles through the
+     * process-wide connection pool.
+     */
+    globus_bool_t                               use_pool;
+
     /**
      * parse all URLs for caching with RFC1738 compliant parser
      */
@@ -735,6 +741,12 @@ typedef struct globus_i_ftp_client_target_s
     int                                         dcsc_type;
     char *                                      dcsc_blob;
     gss_cred_id_t                               dcsc_p_cred;
+
+    /** Connection pool links, newest first, while the target is idle in
+     * the pool.
+     */
+    struct globus_i_ftp_client_target_s *       pool_prev;
+    struct globus_i_ftp_client_target_s *       pool_next;
 } globus_i_ftp_client_target_t;
 
 /**
@@ -963,6 +975,12 @@ globus_result_t
 globus_i_ftp_client_cache_destroy(
     globus_list_t **				cache);
 
+void
+globus_i_ftp_client_pool_init(void);
+
+void
+globus_i_ftp_client_pool_destroy(void);
+
 /* globus_ftp_client_data.c  */
 int
 globus_i_ftp_client_data_cmp(
@@ -1386,6 +1404,16 @@ globus_i_ftp_client_wrap_ftp_error(
             _globus_func_name, \
             __LINE__, \
             "Could not find restart info\n")
+#define GLOBUS_I_FTP_CLIENT_ERROR_CHECKSUM_MISMATCH(url, got, expected) \
+	globus_error_construct_error(\
+		GLOBUS_FTP_CLIENT_MODULE,\
+		GLOBUS_NULL,\
+		GLOBUS_FTP_CLIENT_ERROR_CHECKSUM, \
+		__FILE__, \
+		_globus_func_name, \
+		__LINE__, \
+		"the checksum of %s is %s, expected %s",\
+		url, got, expected)
 
 #endif
 
@@ -0,0 +1,226 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ * 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * 
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * 
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * batch transfer test. Copy the source file to ITEMS destination files,
+ * dst.0 to dst.N, in one batch using extended block mode, two connections
+ * and pipelining. One item starts at an offset, one has its checksum
+ * verified, and one has a wrong checksum and must be the only failure.
+ */
+#include "globus_ftp_client.h"
+#include "globus_ftp_client_test_common.h"
+
+#define ITEMS 16
+#define CHECKSUM_ITEM 7
+#define BAD_CHECKSUM_ITEM 11
+#define OFFSET_ITEM 5
+
+static globus_mutex_t lock;
+static globus_cond_t cond;
+static globus_bool_t done;
+static int error = 0;
+static int reported[ITEMS];
+static globus_size_t batch_failed;
+static char checksum[1024];
+
+static
+void
+done_cb(
+	void *					user_arg,
+	globus_ftp_client_handle_t *		handle,
+	globus_object_t *			err)
+{
+    char * tmpstr;
+
+    if(err) { tmpstr = globus_object_printable_to_string(err);
+	      printf("done with error: %s\n", tmpstr);
+              error++;
+	      globus_libc_free(tmpstr); }
+    globus_mutex_lock(&lock);
+    done = GLOBUS_TRUE;
+    globus_cond_signal(&cond);
+    globus_mutex_unlock(&lock);
+}
+
+static
+void
+item_cb(
+    void *					user_arg,
+    const char *				source_url,
+    const char *				dest_url,
+    void *					item_arg,
+    globus_object_t *				err)
+{
+    int						i = (int) (intptr_t) item_arg;
+    char *					tmpstr;
+
+    globus_mutex_lock(&lock);
+    reported[i]++;
+    if((err != GLOBUS_NULL) != (i == BAD_CHECKSUM_ITEM))
+    {
+	tmpstr = err ? globus_object_printable_to_string(err) : GLOBUS_NULL;
+	printf("item %d: %s\n", i, tmpstr ? tmpstr : "unexpected success");
+	if(tmpstr)
+	{
+	    globus_libc_free(tmpstr);
+	}
+	error++;
+    }
+    globus_mutex_unlock(&lock);
+}
+
+static
+void
+batch_done_cb(
+    void *					user_arg,
+    globus_size_t				failed)
+{
+    globus_mutex_lock(&lock);
+    batch_failed = failed;
+    done = GLOBUS_TRUE;
+    globus_cond_signal(&cond);
+    globus_mutex_unlock(&lock);
+}
+
+int main(int argc, char **argv)
+{
+    globus_ftp_client_handle_t			handle;
+    globus_ftp_client_batch_t			batch;
+    globus_ftp_client_operationattr_t		attr;
+    globus_ftp_client_handleattr_t		handle_attr;
+    globus_result_t				result;
+    char *					src;
+    char *					dst;
+    char *					dst_url;
+    int						i;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    globus_module_activate(GLOBUS_FTP_CLIENT_MODULE);
+    globus_mutex_init(&lock, GLOBUS_NULL);
+    globus_cond_init(&cond, GLOBUS_NULL);
+
+    globus_ftp_client_handleattr_init(&handle_attr);
+    globus_ftp_client_operationattr_init(&attr);
+
+    test_parse_args(argc,
+		    argv,
+		    &handle_attr,
+		    &attr,
+		    &src,
+		    &dst);
+    globus_ftp_client_operationattr_set_mode(
+	&attr,
+	GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK);
+
+    /* the checksum the verified item should have */
+    globus_ftp_client_handle_init(&handle, &handle_attr);
+    done = GLOBUS_FALSE;
+    result = globus_ftp_client_cksm(&handle,
+				    src,
+				    &attr,
+				    checksum,
+				    0,
+				    -1,
+				    "MD5",
+				    done_cb,
+				    0);
+    if(result != GLOBUS_SUCCESS)
+    {
+	error++;
+	done = GLOBUS_TRUE;
+    }
+    globus_mutex_lock(&lock);
+    while(!done)
+    {
+	globus_cond_wait(&cond, &lock);
+    }
+    globus_mutex_unlock(&lock);
+    globus_ftp_client_handle_destroy(&handle);
+    if(error)
+    {
+	goto exit;
+    }
+
+    result = globus_ftp_client_batch_init(&batch,
+					  &handle_attr,
+					  &attr,
+					  &attr,
+					  2,
+					  8,
+					  item_cb,
+					  GLOBUS_NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+	error++;
+	goto exit;
+    }
+
+    for(i = 0; i < ITEMS; i++)
+    {
+	dst_url = globus_common_create_string("%s.%d", dst, i);
+	result = globus_ftp_client_batch_add(
+	    &batch,
+	    src,
+	    GLOBUS_NULL,
+	    dst_url,
+	    GLOBUS_NULL,
+	    i == OFFSET_ITEM ? 1 : 0,
+	    (i == CHECKSUM_ITEM || i == BAD_CHECKSUM_ITEM) ? "MD5" : GLOBUS_NULL,
+	    i == CHECKSUM_ITEM ? checksum : "0123456789abcdef",
+	    (void *) (intptr_t) i);
+	globus_libc_free(dst_url);
+	if(result != GLOBUS_SUCCESS)
+	{
+	    error++;
+	}
+    }
+
+    done = GLOBUS_FALSE;
+    result = globus_ftp_client_batch_start(&batch, batch_done_cb, GLOBUS_NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+	error++;
+	done = GLOBUS_TRUE;
+    }
+    globus_mutex_lock(&lock);
+    while(!done)
+    {
+	globus_cond_wait(&cond, &lock);
+    }
+    globus_mutex_unlock(&lock);
+
+    for(i = 0; i < ITEMS; i++)
+    {
+	if(reported[i] != 1)
+	{
+	    printf("item %d reported %d times\n", i, reported[i]);
+	    error++;
+	}
+    }
+    if(batch_failed != 1)
+    {
+	printf("%d items failed\n", (int) batch_failed);
+	error++;
+    }
+    globus_ftp_client_batch_destroy(&batch);
+
+exit:
+    globus_ftp_client_handleattr_destroy(&handle_attr);
+    globus_ftp_client_operationattr_destroy(&attr);
+    globus_module_deactivate_all();
+
+    return error;
+}
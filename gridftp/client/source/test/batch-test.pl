@@ -0,0 +1,209 @@
+#! /usr/bin/perl
+
+#
+# Copyright 1999-2006 University of Chicago
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+=head1 Batch Transfer Tests
+
+Tests to exercise the batch transfer functionality of the Globus FTP
+client library.  batch-test copies the source file to 16 destination
+files, dest.0 to dest.15, in one batch.  Item 5 starts at offset 1, item 7
+has its checksum verified and item 11 has a wrong checksum, which must be
+the only failure.
+
+=cut
+
+use strict;
+use Test::More;
+use File::Basename;
+use lib dirname($0);
+use FtpTestLib;
+use File::Spec;
+
+my $test_exec = './batch-test';
+my @tests;
+my @todo;
+
+my $items = 16;
+my $offset_item = 5;
+my $bad_checksum_item = 11;
+
+my ($proto) = setup_proto();
+my ($source_host, $source_file, $local_copy) = setup_remote_source();
+my ($dest_host, $dest_file) = setup_remote_dest();
+
+sub read_file
+{
+    my $path = shift;
+    my ($fd, $contents);
+
+    open($fd, "<$path") or return undef;
+    binmode($fd);
+    local($/);
+    $contents = <$fd>;
+    close($fd);
+
+    return $contents;
+}
+
+sub clean_items
+{
+    for my $i (0..$items-1)
+    {
+        clean_remote_file($dest_host, "$dest_file.$i");
+    }
+}
+
+# compare each item with the source; the offset item only from offset 1
+# on, the bad checksum item is not checked
+sub compare_items
+{
+    my $errors = "";
+    my $expected = read_file($local_copy);
+
+    for my $i (0..$items-1)
+    {
+        next if $i == $bad_checksum_item;
+
+        my ($output) = get_remote_file($dest_host, "$dest_file.$i");
+        my $got = read_file($output);
+        unlink($output);
+
+        if($i == $offset_item)
+        {
+            if(!defined($got) || length($got) != length($expected) ||
+               substr($got, 1) ne substr($expected, 1))
+            {
+                $errors .= "\n# Item $i differs from offset 1.";
+            }
+        }
+        elsif(!defined($got) || $got ne $expected)
+        {
+            $errors .= "\n# Item $i differs.";
+        }
+    }
+
+    return $errors;
+}
+
+=head2 I<basic_func> (Test 1-2)
+
+Do a batch transfer of the test file to/from localhost (with and without
+a valid proxy).
+
+=over 4
+
+=item Test 1
+
+Transfer without a valid proxy. Success if test program returns non-zero,
+and no core dump is generated.
+
+=item Test 2
+
+Transfer with a valid proxy. Success if test program returns 0, each item
+is reported once, only the bad checksum item fails, and the items compare.
+
+=back
+
+=cut
+sub basic_func
+{
+    my ($use_proxy) = (shift);
+    my ($errors,$rc) = ("",0);
+
+    if($use_proxy == 0)
+    {
+        FtpTestLib::push_proxy(File::Spec::->devnull());
+    }
+
+    my $command = "$test_exec -s $proto$source_host$source_file -d $proto$dest_host$dest_file";
+    $errors = run_command($command, $use_proxy ? 0 : -1);
+    if($use_proxy && $errors eq "")
+    {
+        $errors = compare_items();
+    }
+
+    ok($errors eq "", "basic_func $use_proxy $command");
+
+    if($use_proxy == 0)
+    {
+        FtpTestLib::pop_proxy();
+    }
+
+    clean_items();
+}
+push(@tests, "basic_func" . "(0);") unless $proto ne "gsiftp://"; #Use invalid proxy
+push(@tests, "basic_func" . "(1);"); #Use proxy
+
+=head2 I<bad_url_src> (Test 3)
+
+Do a batch transfer of a non-existent source file. Success if program
+returns non-zero and no core file is generated.
+
+=cut
+sub bad_url_src
+{
+    my ($errors,$rc) = ("",0);
+
+    my $command = "$test_exec -s $proto$source_host$source_file/etc/no-such-file-here -d $proto$dest_host$dest_file";
+    $errors = run_command($command, -1);
+
+    ok($errors eq "", "bad_url_src $command");
+
+    clean_items();
+}
+push(@tests, "bad_url_src();");
+
+=head2 I<bad_url_dest> (Test 4)
+
+Do a batch transfer to an unwritable location. Success if program returns
+non-zero and no core file is generated.
+
+=cut
+sub bad_url_dest
+{
+    my ($errors,$rc) = ("",0);
+
+    my $command = "$test_exec -s $proto$source_host$source_file -d $proto$dest_host$dest_file/etc/no-such-file-here";
+    $errors = run_command($command, -1);
+
+    ok($errors eq "", "bad_url_dest $command");
+}
+push(@tests, "bad_url_dest();");
+
+if(defined($ENV{FTP_TEST_RANDOMIZE}))
+{
+    shuffle(\@tests);
+}
+
+if(@ARGV)
+{
+    plan tests => scalar(@ARGV);
+
+    foreach (@ARGV)
+    {
+        eval "&$tests[$_-1]";
+    }
+}
+else
+{
+    plan tests => scalar(@tests), todo => \@todo;
+
+    foreach (@tests)
+    {
+        eval "&$_";
+    }
+}
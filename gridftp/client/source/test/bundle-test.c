@@ -0,0 +1,378 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * bundle get and put.
+ *
+ * gets the directory named by the source URL as a bundle, splits it into
+ * files, and if a destination URL is given puts the files back as a bundle
+ * into that directory.  Prints the file rate of each transfer.
+ *
+ * -R includes subdirectories, -P n uses n parallel streams.  -n name puts
+ * a bundle of one small file by that name instead, without a get, to check
+ * which names the server accepts.
+ */
+#include "globus_ftp_client.h"
+#include "globus_ftp_client_test_common.h"
+
+static globus_mutex_t lock;
+static globus_cond_t cond;
+static globus_bool_t done;
+static globus_bool_t error = GLOBUS_FALSE;
+static globus_ftp_client_bundle_parser_t parser;
+static globus_byte_t * stream;
+static globus_size_t stream_length;
+static globus_size_t stream_max;
+static globus_off_t put_offset;
+static int file_count;
+#define SIZE 65536
+#define BUFFERS 4
+
+static
+void
+done_cb(
+	void *					user_arg,
+	globus_ftp_client_handle_t *		handle,
+	globus_object_t *			err)
+{
+    char * tmpstr;
+
+    if(err)
+    {
+	tmpstr = globus_object_printable_to_string(err);
+	fprintf(stderr, "%s\n", tmpstr);
+        error = GLOBUS_TRUE;
+	globus_libc_free(tmpstr);
+    }
+
+    globus_mutex_lock(&lock);
+    done = GLOBUS_TRUE;
+    globus_cond_signal(&cond);
+    globus_mutex_unlock(&lock);
+}
+
+static
+void
+stream_append(
+    globus_byte_t *				data,
+    globus_size_t				length)
+{
+    if(stream_length + length > stream_max)
+    {
+	stream_max = (stream_length + length) * 2;
+	stream = realloc(stream, stream_max);
+    }
+    memcpy(stream + stream_length, data, length);
+    stream_length += length;
+}
+
+/* rebuild the bundle from the parsed files, for the put */
+static
+void
+file_cb(
+    void *					user_arg,
+    const char *				name,
+    globus_off_t				size,
+    int						mode,
+    time_t					mtime,
+    globus_byte_t *				buffer,
+    globus_size_t				length,
+    globus_off_t				offset,
+    globus_bool_t				eof)
+{
+    globus_byte_t				header[4200];
+    globus_size_t				header_length;
+
+    if(offset == 0)
+    {
+	globus_ftp_client_bundle_header(
+	    header, sizeof(header), name, size, mode, mtime, &header_length);
+	stream_append(header, header_length);
+    }
+    stream_append(buffer, length);
+    if(eof)
+    {
+	file_count++;
+    }
+}
+
+static
+void
+data_cb(
+    void *					user_arg,
+    globus_ftp_client_handle_t *		handle,
+    globus_object_t *				err,
+    globus_byte_t *				buffer,
+    globus_size_t				length,
+    globus_off_t				offset,
+    globus_bool_t				eof)
+{
+    globus_result_t				result;
+
+    result = globus_ftp_client_bundle_parser_parse(
+	parser, buffer, length, offset);
+    if(result != GLOBUS_SUCCESS)
+    {
+	fprintf(stderr, "bad bundle data at %ld\n", (long) offset);
+	error = GLOBUS_TRUE;
+	globus_ftp_client_abort(handle);
+    }
+    if(!eof && !error)
+    {
+	globus_ftp_client_register_read(handle,
+					buffer,
+					SIZE,
+					data_cb,
+					0);
+    }
+}
+
+static
+void
+write_cb(
+    void *					user_arg,
+    globus_ftp_client_handle_t *		handle,
+    globus_object_t *				err,
+    globus_byte_t *				buffer,
+    globus_size_t				length,
+    globus_off_t				offset,
+    globus_bool_t				eof)
+{
+    globus_size_t				n;
+
+    /* the eof buffer has to be registered last */
+    globus_mutex_lock(&lock);
+    if(!err && put_offset < stream_length)
+    {
+	n = stream_length - put_offset < SIZE ?
+	    stream_length - put_offset : SIZE;
+	put_offset += n;
+	globus_ftp_client_register_write(handle,
+					 stream + put_offset - n,
+					 n,
+					 put_offset - n,
+					 put_offset == stream_length,
+					 write_cb,
+					 0);
+    }
+    globus_mutex_unlock(&lock);
+}
+
+static
+void
+wait_done(void)
+{
+    globus_mutex_lock(&lock);
+    while(!done)
+    {
+	globus_cond_wait(&cond, &lock);
+    }
+    done = GLOBUS_FALSE;
+    globus_mutex_unlock(&lock);
+}
+
+static
+void
+report(
+    const char *				label,
+    globus_abstime_t *				start)
+{
+    globus_abstime_t				end;
+    globus_reltime_t				elapsed;
+    long					usec;
+
+    GlobusTimeAbstimeGetCurrent(end);
+    GlobusTimeAbstimeDiff(elapsed, end, *start);
+    GlobusTimeReltimeToUSec(usec, elapsed);
+    if(usec == 0)
+    {
+	usec = 1;
+    }
+    printf("%s: %d files, %ld bytes, %.3f s, %.1f files/s\n",
+	   label,
+	   file_count,
+	   (long) stream_length,
+	   usec / 1000000.0,
+	   file_count * 1000000.0 / usec);
+}
+
+int main(int argc,
+	 char *argv[])
+{
+    globus_ftp_client_handle_t			handle;
+    globus_ftp_client_operationattr_t		attr;
+    globus_ftp_client_handleattr_t		handle_attr;
+    globus_ftp_control_parallelism_t		parallelism;
+    globus_byte_t *				buffers[BUFFERS];
+    globus_result_t				result;
+    globus_abstime_t				start;
+    globus_bool_t				recursive = GLOBUS_FALSE;
+    char *					name = GLOBUS_NULL;
+    globus_byte_t				header[4200];
+    globus_size_t				header_length;
+    char *					src;
+    char *					dst;
+    int						i;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    globus_module_activate(GLOBUS_FTP_CLIENT_MODULE);
+    globus_ftp_client_handleattr_init(&handle_attr);
+    globus_ftp_client_operationattr_init(&attr);
+
+    parallelism.mode = GLOBUS_FTP_CONTROL_PARALLELISM_NONE;
+
+    /* Parse local arguments */
+    for(i = 1; i < argc; i++)
+    {
+	if(strcmp(argv[i], "-R") == 0)
+	{
+	    recursive = GLOBUS_TRUE;
+	    test_remove_arg(&argc, argv, &i, 0);
+	}
+	else if(strcmp(argv[i], "-P") == 0 && i + 1 < argc)
+	{
+	    parallelism.mode = GLOBUS_FTP_CONTROL_PARALLELISM_FIXED;
+	    parallelism.fixed.size = atoi(argv[i+1]);
+
+	    test_remove_arg(&argc, argv, &i, 1);
+	}
+	else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+	{
+	    name = argv[i+1];
+	    test_remove_arg(&argc, argv, &i, 1);
+	}
+    }
+    test_parse_args(argc,
+		    argv,
+                    &handle_attr,
+                    &attr,
+		    &src,
+		    &dst);
+
+    globus_mutex_init(&lock, GLOBUS_NULL);
+    globus_cond_init(&cond, GLOBUS_NULL);
+
+    globus_ftp_client_operationattr_set_mode(
+        &attr,
+        GLOBUS_FTP_CONTROL_MODE_EXTENDED_BLOCK);
+    globus_ftp_client_operationattr_set_parallelism(&attr,
+					            &parallelism);
+
+    globus_ftp_client_handle_init(&handle,  &handle_attr);
+    globus_ftp_client_bundle_parser_init(&parser, file_cb, GLOBUS_NULL);
+
+    done = GLOBUS_FALSE;
+    GlobusTimeAbstimeGetCurrent(start);
+    if(name != GLOBUS_NULL)
+    {
+	globus_ftp_client_bundle_header(
+	    header, sizeof(header), name, 12, 0644, time(NULL),
+	    &header_length);
+	stream_append(header, header_length);
+	stream_append((globus_byte_t *) "bundle-test\n", 12);
+	file_count = 1;
+	result = GLOBUS_SUCCESS;
+	done = GLOBUS_TRUE;
+    }
+    else
+    {
+	result = globus_ftp_client_bundle_get(&handle,
+					  src,
+					  &attr,
+					  recursive,
+					  done_cb,
+					  0);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+	fprintf(stderr, "%s", globus_object_printable_to_string(globus_error_get(result)));
+	done = GLOBUS_TRUE;
+	error = GLOBUS_TRUE;
+    }
+    else if(name == GLOBUS_NULL)
+    {
+	for(i = 0; i < BUFFERS; i++)
+	{
+	    buffers[i] = globus_libc_malloc(SIZE);
+	    globus_ftp_client_register_read(
+		&handle,
+		buffers[i],
+		SIZE,
+		data_cb,
+		0);
+	}
+    }
+    wait_done();
+
+    if(name == GLOBUS_NULL)
+    {
+	if(!error &&
+	   globus_ftp_client_bundle_parser_finish(parser) != GLOBUS_SUCCESS)
+	{
+	    fprintf(stderr, "bundle was truncated\n");
+	    error = GLOBUS_TRUE;
+	}
+	if(!error)
+	{
+	    report("get", &start);
+	}
+    }
+
+    if(!error && dst != GLOBUS_NULL)
+    {
+	GlobusTimeAbstimeGetCurrent(start);
+	result = globus_ftp_client_bundle_put(&handle,
+					      dst,
+					      &attr,
+					      done_cb,
+					      0);
+	if(result != GLOBUS_SUCCESS)
+	{
+	    fprintf(stderr, "%s", globus_object_printable_to_string(globus_error_get(result)));
+	    done = GLOBUS_TRUE;
+	    error = GLOBUS_TRUE;
+	}
+	else if(stream_length == 0)
+	{
+	    globus_ftp_client_register_write(
+		&handle, (globus_byte_t *) "", 0, 0, GLOBUS_TRUE, write_cb, 0);
+	}
+	else
+	{
+	    for(i = 0; i < BUFFERS; i++)
+	    {
+		write_cb(0, &handle, GLOBUS_NULL, GLOBUS_NULL, 0, 0,
+			 GLOBUS_FALSE);
+	    }
+	}
+	wait_done();
+	if(!error)
+	{
+	    report("put", &start);
+	}
+    }
+
+    globus_ftp_client_bundle_parser_destroy(&parser);
+    globus_ftp_client_handle_destroy(&handle);
+
+    globus_module_deactivate_all();
+
+    if(test_abort_count && error)
+    {
+	return 0;
+    }
+    return error;
+}
@@ -0,0 +1,182 @@
+#! /usr/bin/perl
+
+# 
+# Copyright 1999-2006 University of Chicago
+# 
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+# 
+# http://www.apache.org/licenses/LICENSE-2.0
+# 
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# 
+
+=head1 Bundle Tests
+
+Tests to exercise the bundle get and put of the Globus FTP client library
+against the "bundle" ERET/ESTO module of the server.  The test wrapper
+starts the server with -allowed-modules bundle.
+
+=cut
+
+use strict;
+use Test::More;
+use File::Basename;
+use File::Path qw/ mkpath /;
+use File::Temp qw/ tempdir /;
+use lib dirname($0);
+use FtpTestLib;
+use File::Spec;
+
+my $test_exec = './bundle-test';
+my @tests;
+my @todo;
+
+my ($proto) = setup_proto();
+my ($dest_host) = setup_remote_dest();
+
+# the server runs on this host, so the trees are checked on disk
+my $work_dir = tempdir(CLEANUP => 1);
+my $source_dir = "$work_dir/source";
+
+sub make_file
+{
+    my ($path, $contents) = @_;
+    my $fd;
+
+    mkpath(dirname($path));
+    open($fd, ">$path");
+    print $fd $contents;
+    close($fd);
+}
+
+sub read_file
+{
+    my $path = shift;
+    my ($fd, $contents);
+
+    open($fd, "<$path") or return undef;
+    local($/);
+    $contents = <$fd>;
+    close($fd);
+
+    return $contents;
+}
+
+for my $i (0..9)
+{
+    make_file("$source_dir/f$i", "file $i\n" x ($i * 10));
+    make_file("$source_dir/d$i/g$i", "dir file $i\n");
+}
+make_file("$source_dir/d0/d1/big", "x" x (4 * 1024 * 1024));
+
+=pod
+
+=head2 I<get_put> (Test 1-2)
+
+Get a directory as a bundle and put the bundle into an empty directory.
+Success if the program returns 0 and the new tree has the same files as
+the source, with or without subdirectories.
+
+=cut
+
+sub get_put
+{
+    my ($recursive) = shift;
+    my $dest_dir = tempdir(DIR => $work_dir);
+    my ($errors, @names);
+
+    my $command = "$test_exec " . ($recursive ? "-R " : "") .
+        "-s $proto$dest_host$source_dir/ -d $proto$dest_host$dest_dir/";
+    $errors = run_command($command, 0);
+    if($errors eq '')
+    {
+        @names = map { "f$_" } (0..9);
+        if($recursive)
+        {
+            push(@names, (map { "d$_/g$_" } (0..9)), "d0/d1/big");
+        }
+        foreach my $name (@names)
+        {
+            my $got = read_file("$dest_dir/$name");
+
+            if(!defined($got) || $got ne read_file("$source_dir/$name"))
+            {
+                $errors .= "\n# $name differs";
+            }
+        }
+        if(!$recursive && -e "$dest_dir/d0")
+        {
+            $errors .= "\n# subdirectories sent without -R";
+        }
+    }
+    ok($errors eq '', "get_put $recursive $command");
+}
+push(@tests, "get_put(0);");
+push(@tests, "get_put(1);");
+
+=pod
+
+=head2 I<bad_name> (Test 3-8)
+
+Put a bundle holding a file whose name leads out of the destination
+directory.  Success if the program returns 1 and nothing is written
+outside the destination.
+
+=cut
+
+sub bad_name
+{
+    my ($name, $outside) = @_;
+    my $dest_dir = tempdir(DIR => $work_dir);
+    my $errors;
+
+    $name =~ s/\@DEST\@/$dest_dir/g;
+    $outside =~ s/\@DEST\@/$dest_dir/g;
+    mkpath("$dest_dir/sub");
+    symlink($work_dir, "$dest_dir/link");
+
+    my $command = "$test_exec -n '$name' -d $proto$dest_host$dest_dir/";
+    $errors = run_command($command, 1);
+    if(-e $outside)
+    {
+        $errors .= "\n# $outside was written";
+        -d $outside ? rmdir($outside) : unlink($outside);
+    }
+    ok($errors eq '', "bad_name $name");
+}
+push(@tests, "bad_name('../escaped', '\@DEST\@/../escaped');");
+push(@tests, "bad_name('sub/../../escaped', '\@DEST\@/../escaped');");
+push(@tests, "bad_name('$work_dir/absolute', '$work_dir/absolute');");
+push(@tests, "bad_name('\@DEST\@/../escaped', '\@DEST\@/../escaped');");
+push(@tests, "bad_name('link/escaped', '$work_dir/escaped');");
+push(@tests, "bad_name('link/new/escaped', '$work_dir/new');");
+
+if(defined($ENV{FTP_TEST_RANDOMIZE}))
+{
+    shuffle(\@tests);
+}
+
+if(@ARGV)
+{
+    plan tests => scalar(@ARGV);
+
+    foreach (@ARGV)
+    {
+        eval "&$tests[$_-1]";
+    }
+}
+else
+{
+    plan tests => scalar(@tests), todo => \@todo;
+
+    foreach (@tests)
+    {
+        eval "&$_";
+    }
+}
@@ -8398,7 +8398,17 @@ globus_l_ftp_stream_write_eof_callback(
 
     globus_mutex_lock(&dc_handle->mutex);
     {
-        globus_l_ftp_control_stripes_destroy(dc_handle, GLOBUS_NULL);
+        /*
+         *  the user may have started the next transfer from the callback
+         *  (or another thread once the transfer completed), leave its
+         *  stripes alone.  ours were closed by the stripes_destroy() in
+         *  local_pasv()/local_port() that orphaned this transfer_handle,
+         *  and dec_ref() frees it with its last reference.
+         */
+        if(dc_handle->transfer_handle == transfer_handle)
+        {
+            globus_l_ftp_control_stripes_destroy(dc_handle, GLOBUS_NULL);
+        }
         poll = !globus_l_ftp_control_dc_dec_ref(transfer_handle);
         if(poll)
         {
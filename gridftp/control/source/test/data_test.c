@@ -42,6 +42,19 @@ typedef struct data_test_info_s
     int                                         bb_len;
 } data_test_info_t;
 
+/*
+ *  the reader of restart_from_eof_test() starts the next transfer from its
+ *  eof callback, as a client reusing a cached connection does
+ */
+typedef struct restart_test_info_s
+{
+    ftp_test_monitor_t *                        monitor;
+    globus_ftp_control_host_port_t              host_port;
+    globus_result_t                             restart_result;
+    globus_bool_t                               restart;
+    globus_off_t                                nbytes;
+} restart_test_info_t;
+
 static int                              g_test_count = 0;
 static char                             g_test_file[L_tmpnam] = {0};
 static char                             g_tmp_file[TEST_ITERATIONS][L_tmpnam] = {0};
@@ -56,6 +69,11 @@ reuse_handles_test(
     set_handle_mode_cb_t                       mode_cb,
     int                                        plevel);
 
+globus_result_t
+restart_from_eof_test(
+    set_handle_mode_cb_t                       mode_cb,
+    int                                        plevel);
+
 void
 test_result(
     globus_result_t                             result,
@@ -120,6 +138,24 @@ data_read_big_buffer_callback(
     globus_off_t                                offset,
     globus_bool_t                               eof);
 
+void
+restart_connect_read_callback(
+    void *                                      callback_arg,
+    struct globus_ftp_control_handle_s *        handle,
+    unsigned int                                stripe_ndx,
+    globus_bool_t                               resuse,
+    globus_object_t *                           error);
+
+void
+restart_read_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error,
+    globus_byte_t *                             buffer,
+    globus_size_t                               length,
+    globus_off_t                                offset,
+    globus_bool_t                               eof);
+
 void
 data_write_callback(
     void *                                      callback_arg,
@@ -201,7 +237,7 @@ main(
     LTDL_SET_PRELOADED_SYMBOLS();
     setbuf(stdout, NULL);
     setbuf(stderr, NULL);
-    printf("1..11\n");
+    printf("1..12\n");
 
     for(ctr = 0; ctr < argc; ctr++)
     {
@@ -262,6 +298,14 @@ main(
     verbose_printf(1, "reuse handles test in stream mode passed.\n");
     verbose_printf(1, "------------------------------------\n");
 
+    g_test_count++;
+    verbose_printf(1, "------------------------------------\n");
+    verbose_printf(1, "running restart from eof test in stream mode.\n");
+    restart_from_eof_test(binary_stream_mode, 1);
+    printf("ok - restart_from_eof_test(binary_stream_mode, 1)\n");
+    verbose_printf(1, "restart from eof test in stream mode passed.\n");
+    verbose_printf(1, "------------------------------------\n");
+
     g_test_count++;
     verbose_printf(1, "------------------------------------\n");
     verbose_printf(1, "running big buffer test in stream mode\n");
@@ -684,6 +728,218 @@ reuse_handles_test(
     return GLOBUS_SUCCESS;
 }
 
+/*
+ *  every transfer after the first is set up on the reading handle from the
+ *  eof callback of the one before it.  the closing of the old transfer must
+ *  not tear down the new one.
+ */
+globus_result_t
+restart_from_eof_test(
+    set_handle_mode_cb_t                       mode_cb,
+    int                                        plevel)
+{
+    int                                        ctr;
+    globus_result_t                            res;
+    globus_ftp_control_host_port_t             host_port;
+    globus_ftp_control_handle_t                port_handle;
+    globus_ftp_control_handle_t                pasv_handle;
+    ftp_test_monitor_t                         done_monitor;
+    data_test_info_t                           write_info;
+    restart_test_info_t                        read_info;
+    struct stat                                stat_info;
+
+    ftp_test_monitor_init(&done_monitor);
+    done_monitor.result = GLOBUS_SUCCESS;
+
+    if(stat(g_test_file, &stat_info) < 0)
+    {
+        failure_end("stat failed\n");
+    }
+
+    memset(&write_info, 0, sizeof(data_test_info_t));
+    write_info.monitor = &done_monitor;
+    memset(&read_info, 0, sizeof(restart_test_info_t));
+    read_info.monitor = &done_monitor;
+
+    res = globus_i_ftp_control_data_cc_init(&pasv_handle);
+    test_result(res, "pasv handle init", __LINE__);
+
+    res = globus_i_ftp_control_data_cc_init(&port_handle);
+    test_result(res, "port handle init", __LINE__);
+
+    globus_ftp_control_host_port_init(&host_port, "localhost", 0);
+    res = globus_ftp_control_local_pasv(&pasv_handle, &host_port);
+    test_result(res, "local pasv", __LINE__);
+
+    for(ctr = 0; ctr < TEST_ITERATIONS * 2; ctr++)
+    {
+        done_monitor.done = GLOBUS_FALSE;
+        done_monitor.count = 0;
+        read_info.nbytes = 0;
+        read_info.restart = (ctr + 1 < TEST_ITERATIONS * 2);
+
+        res = globus_ftp_control_local_port(&port_handle, &host_port);
+        test_result(res, "local port", __LINE__);
+
+        mode_cb(&pasv_handle, plevel);
+        mode_cb(&port_handle, plevel);
+
+        res = globus_ftp_control_data_connect_read(
+                  &pasv_handle,
+                  restart_connect_read_callback,
+                  (void *)&read_info);
+        test_result(res, "connect_read", __LINE__);
+        res = globus_ftp_control_data_connect_write(
+                  &port_handle,
+                  connect_write_callback,
+                  (void *)&write_info);
+        test_result(res, "connect_write", __LINE__);
+
+        globus_mutex_lock(&done_monitor.mutex);
+        {
+            while(done_monitor.count < 2 && 
+                  !done_monitor.done)
+            {
+                globus_cond_wait(&done_monitor.cond, &done_monitor.mutex);
+            }
+        }
+        globus_mutex_unlock(&done_monitor.mutex);
+
+        if(read_info.nbytes != stat_info.st_size)
+        {
+            failure_end("short read\n");
+        }
+        if(read_info.restart)
+        {
+            test_result(read_info.restart_result, "local pasv", __LINE__);
+            host_port = read_info.host_port;
+        }
+    }
+
+    done_monitor.done = GLOBUS_FALSE;
+    res = globus_ftp_control_data_force_close(
+              &pasv_handle,
+              force_close_cb,
+              (void *)&done_monitor);
+    if(res == GLOBUS_SUCCESS)
+    {
+        globus_mutex_lock(&done_monitor.mutex);
+        {
+            while(!done_monitor.done)
+            {
+                globus_cond_wait(&done_monitor.cond, &done_monitor.mutex);
+            }
+        }
+        globus_mutex_unlock(&done_monitor.mutex);
+    }
+
+    res = globus_i_ftp_control_data_cc_destroy(&pasv_handle);
+    test_result(res, "destroy handle", __LINE__);
+
+    done_monitor.done = GLOBUS_FALSE;
+    res = globus_ftp_control_data_force_close(
+              &port_handle,
+              force_close_cb,
+              (void *)&done_monitor);
+    if(res == GLOBUS_SUCCESS)
+    {
+        globus_mutex_lock(&done_monitor.mutex);
+        {
+            while(!done_monitor.done)
+            {
+                globus_cond_wait(&done_monitor.cond, &done_monitor.mutex);
+            }
+        }
+        globus_mutex_unlock(&done_monitor.mutex);
+    }
+
+    res = globus_i_ftp_control_data_cc_destroy(&port_handle);
+    test_result(res, "destroy", __LINE__);
+
+    return GLOBUS_SUCCESS;
+}
+
+void
+restart_connect_read_callback(
+    void *                                      callback_arg,
+    struct globus_ftp_control_handle_s *        handle,
+    unsigned int                                stripe_ndx,
+    globus_bool_t                               resuse,
+    globus_object_t *                           error)
+{
+    globus_result_t                             res;
+    globus_byte_t *                             buf;
+
+    if(error != GLOBUS_NULL)
+    {
+        test_result(globus_error_put(globus_object_copy(error)),
+            "restart_connect_read_callback error", __LINE__);
+    }
+
+    buf = (globus_byte_t *) globus_malloc(1024);
+    res = globus_ftp_control_data_read(
+              handle,
+              buf,
+              1024,
+              restart_read_callback,
+              callback_arg);
+    test_result(res, "data_read", __LINE__);
+}
+
+void
+restart_read_callback(
+    void *                                      callback_arg,
+    globus_ftp_control_handle_t *               handle,
+    globus_object_t *                           error,
+    globus_byte_t *                             buffer,
+    globus_size_t                               length,
+    globus_off_t                                offset,
+    globus_bool_t                               eof)
+{
+    restart_test_info_t *                       read_info;
+    globus_result_t                             res;
+
+    read_info = (restart_test_info_t *) callback_arg;
+    if(error != GLOBUS_NULL)
+    {
+        verbose_printf(1, "error:%s\n",
+            globus_object_printable_to_string(error));
+        failure_end("restart_read_callback error\n");
+    }
+
+    globus_mutex_lock(&read_info->monitor->mutex);
+    {
+        if(offset + length > read_info->nbytes)
+        {
+            read_info->nbytes = offset + length;
+        }
+        if(!eof)
+        {
+            res = globus_ftp_control_data_read(
+                      handle,
+                      buffer,
+                      1024,
+                      restart_read_callback,
+                      callback_arg);
+            test_result(res, "data_read", __LINE__);
+        }
+        else
+        {
+            globus_free(buffer);
+            if(read_info->restart)
+            {
+                globus_ftp_control_host_port_init(
+                    &read_info->host_port, "localhost", 0);
+                read_info->restart_result = globus_ftp_control_local_pasv(
+                    handle, &read_info->host_port);
+            }
+            read_info->monitor->count++;
+            globus_cond_signal(&read_info->monitor->cond);
+        }
+    }
+    globus_mutex_unlock(&read_info->monitor->mutex);
+}
+
 void 
 binary_eb_mode(
     globus_ftp_control_handle_t *               handle,
@@ -547,8 +547,6 @@ hdfs_start(
             hdfs_handle->port = port;
     }
 
-    hdfs_handle->using_file_buffer = 0;
-
     hdfs_handle->cksm_root = "/cksums";
 
     globus_gfs_log_message(GLOBUS_GFS_LOG_INFO, "Checking current load on the server.\n");
@@ -604,8 +602,6 @@ hdfs_start(
         hdfs_handle->cksm_types = 0;
     }
 
-    hdfs_handle->tmp_file_pattern = (char *)NULL;
-
     // Handle core limits
     gridftp_check_core();
 
@@ -637,7 +633,6 @@ hdfs_destroy(
             globus_free(hdfs_handle->local_host);
         if (hdfs_handle->syslog_msg)
             globus_free(hdfs_handle->syslog_msg);
-        remove_file_buffer(hdfs_handle);
         if (hdfs_handle->mutex) {
             globus_mutex_destroy(hdfs_handle->mutex);
             globus_free(hdfs_handle->mutex);
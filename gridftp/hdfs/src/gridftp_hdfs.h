@@ -64,9 +64,7 @@ typedef struct globus_l_gfs_hdfs_handle_s
     unsigned int                        mount_point_len;
     unsigned int                        replicas;
     char *                              username;
-    char *                              tmp_file_pattern;
-    int                                 tmpfilefd;
-    globus_bool_t                       using_file_buffer;
+    globus_gfs_reorder_t                reorder; // Holds out-of-order blocks until they can be written.
     char *                              syslog_host; // The host to send syslog message to.
     char *                              remote_host; // The remote host connecting to us.
     char *                              local_host;  // Our local hostname.
@@ -108,17 +106,6 @@ hdfs_recv(
     void *                              user_arg);
 
 // Buffer management for writes
-globus_result_t
-hdfs_store_buffer(
-    globus_l_gfs_hdfs_handle_t * hdfs_handle,
-    globus_byte_t* buffer,
-    globus_off_t offset,
-    globus_size_t nbytes);
-
-globus_result_t
-hdfs_dump_buffers(
-    globus_l_gfs_hdfs_handle_t *      hdfs_handle);
-
 globus_result_t
 hdfs_dump_buffer_immed(
     hdfs_handle_t *                   hdfs_handle,
@@ -145,10 +132,6 @@ disgard_buffer(
     hdfs_handle_t * hdfs_handle,
     globus_ssize_t idx);
 
-void
-remove_file_buffer(
-    hdfs_handle_t * hdfs_handle);
-
 
 // Metadata-related functions
 void
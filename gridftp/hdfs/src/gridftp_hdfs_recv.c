@@ -1,6 +1,5 @@
 
 #include "gridftp_hdfs.h"
-#include <sys/mman.h>
 
 #define ADVANCE_SLASHES(x) {while (x[0] == '/' && x[1] == '/') x++;}
 
@@ -19,6 +18,13 @@ static void
 hdfs_dispatch_write(
     globus_l_gfs_hdfs_handle_t *      hdfs_handle);
 
+static globus_result_t
+hdfs_reorder_write(
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    globus_off_t                        offset,
+    void *                              user_arg);
+
 // Taken from globus_gridftp_server_file.c
 // Assume md5_human is length MD5_DIGEST_LENGTH*2+1
 // Assume md5_openssl is length MD5_DIGEST_LENGTH
@@ -48,6 +54,15 @@ close_and_clean(hdfs_handle_t *hdfs_handle, globus_result_t rc) {
         return hdfs_handle->done_status;
     }
 
+    if (hdfs_handle->reorder) {
+        // A successful transfer must not leave blocks behind a gap.
+        if ((rc == GLOBUS_SUCCESS) && (hdfs_handle->done_status == GLOBUS_SUCCESS)) {
+            rc = globus_gridftp_server_reorder_finish(hdfs_handle->reorder);
+        }
+        globus_gridftp_server_reorder_destroy(hdfs_handle->reorder);
+        hdfs_handle->reorder = NULL;
+    }
+
     // Only close the file for successful transfers and if the handle is valid.
     // This might cause long-term leaks, but Java has been crash-y when closing
     // invalid handles.
@@ -58,17 +73,6 @@ close_and_clean(hdfs_handle_t *hdfs_handle, globus_result_t rc) {
         hdfs_handle->fd = NULL;
     }
 
-    if (hdfs_handle->using_file_buffer == 0) {
-        globus_free(hdfs_handle->buffer);
-    } else {
-        munmap(hdfs_handle->buffer, hdfs_handle->block_size*hdfs_handle->buffer_count*sizeof(globus_byte_t));
-        hdfs_handle->using_file_buffer = 0;
-        close(hdfs_handle->tmpfilefd);
-    }
-    globus_free(hdfs_handle->used);
-    globus_free(hdfs_handle->nbytes);
-    globus_free(hdfs_handle->offsets);
-
     globus_gfs_log_message(GLOBUS_GFS_LOG_INFO, "receive %d blocks of size %d bytes\n",
         hdfs_handle->io_count, hdfs_handle->io_block_size);
 
@@ -163,6 +167,7 @@ globus_result_t prepare_handle(hdfs_handle_t *hdfs_handle) {
     GlobusGFSName(prepare_handle);
     globus_result_t rc;
     hdfs_handle->sent_finish = GLOBUS_FALSE;
+    hdfs_handle->reorder = NULL;
 
     const char *path = hdfs_handle->pathname;
 
@@ -194,17 +199,16 @@ globus_result_t prepare_handle(hdfs_handle_t *hdfs_handle) {
 
     globus_gridftp_server_get_optimal_concurrency(hdfs_handle->op,
                                                   &hdfs_handle->optimal_count);
-    hdfs_handle->buffer_count = hdfs_handle->optimal_count;
-    hdfs_handle->nbytes = globus_malloc(hdfs_handle->buffer_count*sizeof(globus_size_t));
-    hdfs_handle->offsets = globus_malloc(hdfs_handle->buffer_count*sizeof(globus_off_t));
-    hdfs_handle->used = globus_malloc(hdfs_handle->buffer_count*sizeof(short));
-    int i;
-    for (i=0; i<hdfs_handle->buffer_count; i++)
-        hdfs_handle->used[i] = 0;
-    hdfs_handle->buffer = globus_malloc(hdfs_handle->buffer_count*hdfs_handle->block_size*sizeof(globus_byte_t));
-    if (hdfs_handle->buffer == NULL || hdfs_handle->nbytes==NULL || 
-            hdfs_handle->offsets==NULL || hdfs_handle->used==NULL) {
-        MemoryError(hdfs_handle, "Memory allocation error.", rc);
+
+    // Out-of-order blocks are held in memory up to max_buffer_count blocks,
+    // then in a file-backed buffer up to max_file_buffer_count blocks.
+    rc = globus_gridftp_server_reorder_init(&hdfs_handle->reorder,
+        hdfs_handle->offset,
+        (globus_size_t)hdfs_handle->max_buffer_count*hdfs_handle->block_size,
+        (globus_off_t)hdfs_handle->max_file_buffer_count*hdfs_handle->block_size,
+        hdfs_reorder_write, hdfs_handle);
+    if (rc != GLOBUS_SUCCESS) {
+        hdfs_handle->reorder = NULL;
         return rc;
     }
     return GLOBUS_SUCCESS;
@@ -359,23 +363,12 @@ hdfs_handle_write_op(
         goto cleanup;
     }
 
-    // First, see if we can dump this block immediately.
-    if (offset == hdfs_handle->offset) {
-        globus_gfs_log_message(GLOBUS_GFS_LOG_DUMP, "Dumping this block immediately.\n");
-        if ((rc = hdfs_dump_buffer_immed(hdfs_handle, buffer, nbytes)) != GLOBUS_SUCCESS) {
-            goto cleanup;
-        }
-    } else {
-        // Try to store the buffer into memory.
-        if ((rc = hdfs_store_buffer(hdfs_handle, buffer, offset, nbytes)) != GLOBUS_SUCCESS) {
-            goto cleanup;
-        }
-    }
-
-    // Try to write out as many buffers as we can to HDFS.
-    if ((rc = hdfs_dump_buffers(hdfs_handle)) != GLOBUS_SUCCESS) {
+    // Write this block and any held blocks it makes contiguous, or hold it
+    // until the blocks before it arrive.
+    if ((rc = globus_gridftp_server_reorder_write(hdfs_handle->reorder,
+            buffer, nbytes, offset)) != GLOBUS_SUCCESS) {
         goto cleanup;
-    }   
+    }
 
 cleanup:
 
@@ -484,3 +477,21 @@ cleanup:
     }
 }
 
+/*************************************************************************
+ *  hdfs_reorder_write
+ *  ------------------
+ *  Called by the reorder buffer with data in file order.
+ *************************************************************************/
+static
+globus_result_t
+hdfs_reorder_write(
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    globus_off_t                        offset,
+    void *                              user_arg)
+{
+    hdfs_handle_t *                     hdfs_handle;
+
+    hdfs_handle = (hdfs_handle_t *) user_arg;
+    return hdfs_dump_buffer_immed(hdfs_handle, buffer, nbytes);
+}
@@ -224,10 +224,10 @@ main(
     {
         goto error_write;
     }
-    /* read reply */
+    /* read reply, only the ack header matters */
     result = globus_xio_read(
         g_xio_handle, buffer,
-        GF_DYN_PACKET_LEN, GF_DYN_PACKET_LEN, &nbytes, NULL);
+        GF_DYN_PACKET_LEN, GF_DYN_PACKET_MIN_LEN, &nbytes, NULL);
     if(result != GLOBUS_SUCCESS)
     {
         gfs_l_dynclient_log(GLOBUS_SUCCESS, 0,
@@ -0,0 +1,421 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * reads the events the server sends to its event_stream socket and prints
+ * one line of key=value pairs per event.  with -r the records are written
+ * to stdout as they were received, and -f reads such a file back.
+ *
+ *   gfs-event-reader [-r] [-m mode] [-f file | socket-path]
+ *
+ * the server connects to the socket before its sessions change to the
+ * users they run as, so by default only the reader's own user, which should
+ * be the server's, may send to it.
+ */
+
+#define GLOBUS_I_GFS_EVENT_STREAM_FORMAT_ONLY
+#include "globus_i_gfs_event_stream.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+static const char *                     gfs_l_event_reader_path = NULL;
+
+static
+const char *
+gfs_l_event_reader_type_name(
+    unsigned int                        type)
+{
+    switch(type)
+    {
+        case GLOBUS_I_GFS_EVENT_SESSION_START:
+            return "session.start";
+        case GLOBUS_I_GFS_EVENT_SESSION_END:
+            return "session.end";
+        case GLOBUS_I_GFS_EVENT_TRANSFER_BEGIN:
+            return "transfer.begin";
+        case GLOBUS_I_GFS_EVENT_TRANSFER_END:
+            return "transfer.end";
+        case GLOBUS_I_GFS_EVENT_PERF:
+            return "perf";
+        case GLOBUS_I_GFS_EVENT_ERROR:
+            return "error";
+        default:
+            return NULL;
+    }
+}
+
+static
+const char *
+gfs_l_event_reader_tag_name(
+    unsigned int                        tag)
+{
+    switch(tag)
+    {
+        case GLOBUS_I_GFS_EVENT_TAG_USER:
+            return "user";
+        case GLOBUS_I_GFS_EVENT_TAG_SUBJECT:
+            return "subject";
+        case GLOBUS_I_GFS_EVENT_TAG_CLIENT_IP:
+            return "client";
+        case GLOBUS_I_GFS_EVENT_TAG_REMOTE_IP:
+            return "remote";
+        case GLOBUS_I_GFS_EVENT_TAG_PATH:
+            return "path";
+        case GLOBUS_I_GFS_EVENT_TAG_OP:
+            return "op";
+        case GLOBUS_I_GFS_EVENT_TAG_BYTES:
+            return "bytes";
+        case GLOBUS_I_GFS_EVENT_TAG_DURATION_USEC:
+            return "usec";
+        case GLOBUS_I_GFS_EVENT_TAG_STREAMS:
+            return "streams";
+        case GLOBUS_I_GFS_EVENT_TAG_STRIPES:
+            return "stripes";
+        case GLOBUS_I_GFS_EVENT_TAG_STRIPE:
+            return "stripe";
+        case GLOBUS_I_GFS_EVENT_TAG_BLOCKSIZE:
+            return "blocksize";
+        case GLOBUS_I_GFS_EVENT_TAG_TCP_BUFFER:
+            return "tcpbuffer";
+        case GLOBUS_I_GFS_EVENT_TAG_MESSAGE:
+            return "message";
+        case GLOBUS_I_GFS_EVENT_TAG_TASKID:
+            return "taskid";
+        default:
+            return NULL;
+    }
+}
+
+static
+uint64_t
+gfs_l_event_reader_get(
+    const unsigned char *               buf,
+    int                                 len)
+{
+    uint64_t                            value = 0;
+    int                                 i;
+
+    for(i = 0; i < len; i++)
+    {
+        value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+static
+void
+gfs_l_event_reader_print(
+    const unsigned char *               buf,
+    size_t                              length)
+{
+    const char *                        name;
+    size_t                              offset;
+    unsigned int                        tag;
+    unsigned int                        len;
+    unsigned int                        i;
+    uint64_t                            usec;
+
+    if(length < GLOBUS_I_GFS_EVENT_STREAM_HEADER_LEN ||
+        gfs_l_event_reader_get(buf, 4) != length)
+    {
+        fprintf(stderr, "Skipping malformed record of %lu bytes.\n",
+            (unsigned long) length);
+        return;
+    }
+    if(gfs_l_event_reader_get(buf + 4, 2) !=
+        GLOBUS_I_GFS_EVENT_STREAM_VERSION)
+    {
+        fprintf(stderr, "Skipping record of unknown version %u.\n",
+            (unsigned int) gfs_l_event_reader_get(buf + 4, 2));
+        return;
+    }
+
+    usec = gfs_l_event_reader_get(buf + 16, 8);
+    printf("time=%lu.%06lu",
+        (unsigned long) (usec / 1000000), (unsigned long) (usec % 1000000));
+    name = gfs_l_event_reader_type_name(gfs_l_event_reader_get(buf + 6, 2));
+    if(name)
+    {
+        printf(" event=%s", name);
+    }
+    else
+    {
+        printf(" event=%u", (unsigned int) gfs_l_event_reader_get(buf + 6, 2));
+    }
+    printf(" pid=%lu session=%llx",
+        (unsigned long) gfs_l_event_reader_get(buf + 8, 4),
+        (unsigned long long) gfs_l_event_reader_get(buf + 24, 8));
+    if(gfs_l_event_reader_get(buf + 32, 8))
+    {
+        printf(" transfer=%llx",
+            (unsigned long long) gfs_l_event_reader_get(buf + 32, 8));
+    }
+    if(gfs_l_event_reader_get(buf + 12, 4))
+    {
+        printf(" dropped=%lu",
+            (unsigned long) gfs_l_event_reader_get(buf + 12, 4));
+    }
+
+    offset = GLOBUS_I_GFS_EVENT_STREAM_HEADER_LEN;
+    while(offset + 4 <= length)
+    {
+        tag = gfs_l_event_reader_get(buf + offset, 2);
+        len = gfs_l_event_reader_get(buf + offset + 2, 2);
+        offset += 4;
+        if(offset + len > length)
+        {
+            break;
+        }
+        name = gfs_l_event_reader_tag_name(tag);
+        /* tags from a newer server are skipped */
+        if(name == NULL)
+        {
+            offset += len;
+            continue;
+        }
+        switch(tag)
+        {
+            case GLOBUS_I_GFS_EVENT_TAG_BYTES:
+            case GLOBUS_I_GFS_EVENT_TAG_DURATION_USEC:
+            case GLOBUS_I_GFS_EVENT_TAG_STREAMS:
+            case GLOBUS_I_GFS_EVENT_TAG_STRIPES:
+            case GLOBUS_I_GFS_EVENT_TAG_STRIPE:
+            case GLOBUS_I_GFS_EVENT_TAG_BLOCKSIZE:
+            case GLOBUS_I_GFS_EVENT_TAG_TCP_BUFFER:
+                printf(" %s=%lld", name,
+                    (long long) gfs_l_event_reader_get(buf + offset, len));
+                break;
+
+            default:
+                printf(" %s=\"", name);
+                for(i = 0; i < len; i++)
+                {
+                    if(buf[offset + i] == '"' || buf[offset + i] == '\\')
+                    {
+                        putchar('\\');
+                    }
+                    putchar(buf[offset + i] < ' ' ? ' ' : buf[offset + i]);
+                }
+                putchar('"');
+                break;
+        }
+        offset += len;
+    }
+    putchar('\n');
+    fflush(stdout);
+}
+
+static
+int
+gfs_l_event_reader_file(
+    const char *                        filename,
+    int                                 raw)
+{
+    unsigned char                       buf[GLOBUS_I_GFS_EVENT_STREAM_MAX];
+    FILE *                              fp;
+    size_t                              length;
+
+    fp = strcmp(filename, "-") == 0 ? stdin : fopen(filename, "rb");
+    if(fp == NULL)
+    {
+        fprintf(stderr, "Unable to open %s: %s\n", filename, strerror(errno));
+        return 1;
+    }
+    while(fread(buf, 1, 4, fp) == 4)
+    {
+        length = gfs_l_event_reader_get(buf, 4);
+        if(length < GLOBUS_I_GFS_EVENT_STREAM_HEADER_LEN ||
+            length > sizeof(buf) ||
+            fread(buf + 4, 1, length - 4, fp) != length - 4)
+        {
+            fprintf(stderr, "Truncated or malformed record in %s.\n",
+                filename);
+            break;
+        }
+        if(raw)
+        {
+            fwrite(buf, 1, length, stdout);
+        }
+        else
+        {
+            gfs_l_event_reader_print(buf, length);
+        }
+    }
+    if(fp != stdin)
+    {
+        fclose(fp);
+    }
+    return 0;
+}
+
+static
+void
+gfs_l_event_reader_unlink(
+    int                                 sig)
+{
+    unlink(gfs_l_event_reader_path);
+    _exit(0);
+}
+
+static
+int
+gfs_l_event_reader_socket(
+    const char *                        path,
+    mode_t                              mode,
+    int                                 raw)
+{
+    unsigned char                       buf[GLOBUS_I_GFS_EVENT_STREAM_MAX];
+    struct sockaddr_un                  addr;
+    ssize_t                             length;
+    mode_t                              old_mask;
+    int                                 fd;
+    int                                 rc;
+    int                                 bufsize = 1024 * 1024;
+
+    if(strlen(path) >= sizeof(addr.sun_path))
+    {
+        fprintf(stderr, "Socket path is too long: %s\n", path);
+        return 1;
+    }
+    fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(fd < 0)
+    {
+        fprintf(stderr, "Unable to create socket: %s\n", strerror(errno));
+        return 1;
+    }
+    /* room for bursts at session start and end */
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    /* no wider than mode even until the chmod */
+    old_mask = umask(0777 & ~mode);
+    rc = bind(fd, (struct sockaddr *) &addr, sizeof(addr));
+    umask(old_mask);
+    if(rc < 0)
+    {
+        fprintf(stderr, "Unable to bind %s: %s\n", path, strerror(errno));
+        close(fd);
+        return 1;
+    }
+    if(chmod(path, mode) < 0)
+    {
+        fprintf(stderr, "Unable to set mode of %s: %s\n",
+            path, strerror(errno));
+    }
+    gfs_l_event_reader_path = path;
+    signal(SIGINT, gfs_l_event_reader_unlink);
+    signal(SIGTERM, gfs_l_event_reader_unlink);
+
+    for(;;)
+    {
+        length = recv(fd, buf, sizeof(buf), 0);
+        if(length < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            fprintf(stderr, "Receive failed: %s\n", strerror(errno));
+            break;
+        }
+        if(raw)
+        {
+            fwrite(buf, 1, length, stdout);
+            fflush(stdout);
+        }
+        else
+        {
+            gfs_l_event_reader_print(buf, length);
+        }
+    }
+
+    unlink(path);
+    close(fd);
+    return 1;
+}
+
+static
+void
+gfs_l_event_reader_usage(
+    const char *                        prog)
+{
+    fprintf(stderr,
+        "Usage: %s [-r] [-m mode] socket-path\n"
+        "       %s [-r] -f file\n"
+        "Prints the events a GridFTP server sends to its event_stream "
+        "socket.\n"
+        "  -r       write the records unchanged instead of printing them\n"
+        "  -m mode  permissions of the socket, default 0600.  run the "
+        "reader as\n"
+        "           the server's user, the server connects before "
+        "sessions change\n"
+        "           to other users\n"
+        "  -f file  read records written with -r from file, - for stdin\n",
+        prog, prog);
+}
+
+int
+main(
+    int                                 argc,
+    char **                             argv)
+{
+    const char *                        filename = NULL;
+    mode_t                              mode = 0600;
+    int                                 raw = 0;
+    int                                 c;
+
+    while((c = getopt(argc, argv, "rm:f:h")) != -1)
+    {
+        switch(c)
+        {
+            case 'r':
+                raw = 1;
+                break;
+            case 'm':
+                mode = strtol(optarg, NULL, 8);
+                break;
+            case 'f':
+                filename = optarg;
+                break;
+            default:
+                gfs_l_event_reader_usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+
+    if(filename)
+    {
+        return gfs_l_event_reader_file(filename, raw);
+    }
+    if(optind != argc - 1)
+    {
+        gfs_l_event_reader_usage(argv[0]);
+        return 1;
+    }
+    return gfs_l_event_reader_socket(argv[optind], mode, raw);
+}
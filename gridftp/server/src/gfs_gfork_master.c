@@ -61,6 +61,12 @@
 #define GFS_GFORK_MAX_DELAY             30
 #define GFS_GFORK_MAX_RETRY             2
 
+typedef struct gfs_l_qos_class_s
+{
+    char *                              name;
+    globus_list_t *                     pids;
+} gfs_l_qos_class_t;
+
 typedef struct gfs_l_memlimit_entry_s
 {
     int                                 mem_size;
@@ -95,6 +101,7 @@ static char *                           g_reg_cs = NULL;
 static char *                           g_be_cs;
 static uint32_t                         g_at_once;
 static uint32_t                         g_total_cons;
+static int                              g_be_load_timer_sec = 30;
 
 /* memory limiting globals */
 static globus_bool_t                    gfs_l_memlimiting = GLOBUS_FALSE;
@@ -112,6 +119,9 @@ static globus_list_t *                  gfs_l_gfork_mem_retry_list = NULL;
 
 static int                              gfs_l_gfork_nice_share_count = 2;
 
+/* qos class name -> pids of the children transferring in it */
+static globus_hashtable_t               gfs_l_qos_table;
+
 static
 globus_result_t
 gfs_gfork_master_options(
@@ -125,6 +135,13 @@ gfs_l_gfork_read_dynbe(
     globus_byte_t *                     buffer,
     globus_size_t                       len);
 
+static
+globus_result_t
+gfs_l_gfork_read_load(
+    globus_xio_handle_t                 handle,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len);
+
 #define GFS_421_NO_TCP_MEM \
     "421 Not enough memory for TCP buffers.  Try later."
 
@@ -318,11 +335,19 @@ gfs_l_gfork_read_cb(
     globus_xio_data_descriptor_t        data_desc,
     void *                              user_arg)
 {
+    globus_byte_t *                     packet;
+    globus_size_t                       done;
     GFSGForkFuncName(gfs_l_gfork_read_cb);
 
     gfs_l_gfork_log(
         result, 3, "Reading incoming registration message\n");
 
+    /* user_arg is the start of the packet when finishing a short read */
+    packet = (user_arg != NULL) ? (globus_byte_t *) user_arg : buffer;
+    done = (buffer - packet) + nbytes;
+    buffer = packet;
+    len = GF_DYN_PACKET_LEN;
+
     globus_mutex_lock(&g_mutex);
     {
         if(result != GLOBUS_SUCCESS)
@@ -334,6 +359,23 @@ gfs_l_gfork_read_cb(
         {
             goto error_version;
         }
+        if(done < GF_DYN_PACKET_LEN)
+        {
+            result = globus_xio_register_read(
+                handle,
+                buffer + done,
+                GF_DYN_PACKET_LEN - done,
+                GF_DYN_PACKET_LEN - done,
+                NULL,
+                gfs_l_gfork_read_cb,
+                buffer);
+            if(result != GLOBUS_SUCCESS)
+            {
+                goto error;
+            }
+            globus_mutex_unlock(&g_mutex);
+            return;
+        }
 
         switch(buffer[GF_MSG_TYPE_NDX])
         {
@@ -345,6 +387,10 @@ gfs_l_gfork_read_cb(
                 result = gfs_l_gfork_read_remove_dynbe(handle, buffer, len);
                 break;
 
+            case GFS_GFORK_MSG_TYPE_LOAD:
+                result = gfs_l_gfork_read_load(handle, buffer, len);
+                break;
+
             default:
                 result = GFSGforkError("unknown registration command", 0);
                 gfs_l_gfork_log(
@@ -410,34 +456,15 @@ gfs_l_gfork_read_dynbe_bc_cb(
 }
 
 static
-globus_result_t
-gfs_l_gfork_read_dynbe(
-    globus_xio_handle_t                 handle,
-    globus_byte_t *                     buffer,
-    globus_size_t                       len)
+globus_bool_t
+gfs_l_gfork_cs_ok(
+    globus_byte_t *                     buffer)
 {
-    globus_result_t                     result;
-    gfs_l_gfork_master_entry_t *        ent_buf;
-    globus_xio_iovec_t                  iov[1];
     globus_bool_t                       ok;
     globus_bool_t                       done;
     int                                 i;
-    globus_reltime_t                    delay;
-    uint32_t                            tmp_32;
-    uint32_t                            converted_32;
-    char *                              table_key;
-    GFSGForkFuncName(gfs_l_gfork_read_dynbe);
-
-    if(!g_gfork_alive)
-    {
-        result = GFSGforkError("GFork is no longer alive", 0);
-        gfs_l_gfork_log(
-            GLOBUS_SUCCESS, 1,
-            "GFork is no longer a live in gfs_l_gfork_read_dynbe\n");
 
-        return result;
-    }
-        /* we are only ok if the string ends in a \0 */
+    /* we are only ok if the string ends in a \0 */
     done = GLOBUS_FALSE;
     ok = GLOBUS_TRUE;
     for(i = GF_DYN_CS_NDX; i < GF_DYN_CS_NDX + GF_DYN_CS_LEN && !done; i++)
@@ -459,6 +486,158 @@ gfs_l_gfork_read_dynbe(
         }
     }
 
+    return ok;
+}
+
+/* the load vector comes from the data node in network order, the
+    worker children get it in host order */
+static
+void
+gfs_l_gfork_load_ntoh(
+    globus_byte_t *                     buffer)
+{
+    uint32_t                            tmp_32;
+    int                                 i;
+    static const int                    ndx[] =
+    {
+        GF_DYN_LOAD_CONN_NDX,
+        GF_DYN_LOAD_CPU_NDX,
+        GF_DYN_LOAD_MEM_NDX
+    };
+
+    for(i = 0; i < sizeof(ndx) / sizeof(int); i++)
+    {
+        memcpy(&tmp_32, &buffer[ndx[i]], sizeof(uint32_t));
+        tmp_32 = ntohl(tmp_32);
+        memcpy(&buffer[ndx[i]], &tmp_32, sizeof(uint32_t));
+    }
+}
+
+/* tell all worker children about the current state of a backend.  this
+    is how they learn both of new registrations and of load updates */
+static
+globus_result_t
+gfs_l_gfork_dynbe_broadcast(
+    gfs_l_gfork_master_entry_t *        ent_buf)
+{
+    globus_xio_iovec_t                  iov[1];
+    globus_byte_t *                     buffer;
+    uint32_t                            n32;
+    globus_result_t                     result;
+
+    buffer = malloc(GF_DYN_PACKET_LEN);
+    memcpy(buffer, ent_buf->buffer, GF_DYN_PACKET_LEN);
+    buffer[GF_MSG_TYPE_NDX] = GFS_GFORK_MSG_TYPE_DYNBE;
+    n32 = 1;
+    memcpy(&buffer[GF_DYN_ENTRY_COUNT_NDX], &n32, sizeof(uint32_t));
+
+    iov[0].iov_base = buffer;
+    iov[0].iov_len = GF_DYN_PACKET_LEN;
+
+    result = globus_gfork_broadcast(
+        g_handle,
+        iov,
+        1,
+        gfs_l_gfork_read_dynbe_bc_cb,
+        NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_free(buffer);
+    }
+
+    return result;
+}
+
+static
+globus_result_t
+gfs_l_gfork_read_load(
+    globus_xio_handle_t                 handle,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len)
+{
+    globus_result_t                     result;
+    gfs_l_gfork_master_entry_t *        ent_buf;
+    GFSGForkFuncName(gfs_l_gfork_read_load);
+
+    if(!gfs_l_gfork_cs_ok(buffer))
+    {
+        gfs_l_gfork_log(
+            GLOBUS_SUCCESS, 2, "Load message not ok\n");
+        return GFSGforkError("bad contact string", 0);
+    }
+
+    ent_buf = (gfs_l_gfork_master_entry_t *) globus_hashtable_lookup(
+        &g_gfork_be_table, (char *)&buffer[GF_DYN_CS_NDX]);
+    if(ent_buf == NULL)
+    {
+        /* the registration expired or has not happened yet, the nack
+            tells the data node its load is going nowhere */
+        gfs_l_gfork_log(
+            GLOBUS_SUCCESS, 2, "Load update from unregistered backend %s\n",
+            &buffer[GF_DYN_CS_NDX]);
+        return GFSGforkError("backend not registered", 0);
+    }
+
+    gfs_l_gfork_load_ntoh(buffer);
+    memcpy(&ent_buf->buffer[GF_DYN_LOAD_CONN_NDX],
+        &buffer[GF_DYN_LOAD_CONN_NDX],
+        GF_DYN_PACKET_LEN - GF_DYN_LOAD_CONN_NDX);
+
+    memset(buffer, '\0', GF_DYN_PACKET_LEN);
+    buffer[GF_VERSION_NDX] = GF_VERSION;
+    buffer[GF_MSG_TYPE_NDX] = GFS_GFORK_MSG_TYPE_ACK;
+
+    result = globus_xio_register_write(
+        handle,
+        buffer,
+        GF_DYN_PACKET_LEN,
+        GF_DYN_PACKET_LEN,
+        NULL,
+        gfs_l_gfork_write_cb,
+        NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_xio_register_close(
+            handle,
+            NULL,
+            gfs_l_gfork_write_close_cb,
+            buffer);
+    }
+
+    result = gfs_l_gfork_dynbe_broadcast(ent_buf);
+    gfs_l_gfork_log(
+        result, 3, "Broadcasted load update from %s\n", ent_buf->table_key);
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_result_t
+gfs_l_gfork_read_dynbe(
+    globus_xio_handle_t                 handle,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len)
+{
+    globus_result_t                     result;
+    gfs_l_gfork_master_entry_t *        ent_buf;
+    globus_bool_t                       ok;
+    globus_reltime_t                    delay;
+    uint32_t                            tmp_32;
+    uint32_t                            converted_32;
+    char *                              table_key;
+    GFSGForkFuncName(gfs_l_gfork_read_dynbe);
+
+    if(!g_gfork_alive)
+    {
+        result = GFSGforkError("GFork is no longer alive", 0);
+        gfs_l_gfork_log(
+            GLOBUS_SUCCESS, 1,
+            "GFork is no longer a live in gfs_l_gfork_read_dynbe\n");
+
+        return result;
+    }
+    ok = gfs_l_gfork_cs_ok(buffer);
+
     /* registering client may not be same byte order but worker child
         will be */
     memcpy(&tmp_32, &buffer[GF_DYN_AT_ONCE_NDX], sizeof(uint32_t));
@@ -469,6 +648,8 @@ gfs_l_gfork_read_dynbe(
     converted_32 = ntohl(tmp_32);
     memcpy(&buffer[GF_DYN_TOTAL_NDX], &converted_32, sizeof(uint32_t));
 
+    gfs_l_gfork_load_ntoh(buffer);
+
     if(!ok)
     {
         gfs_l_gfork_log(
@@ -494,6 +675,13 @@ gfs_l_gfork_read_dynbe(
             ent_buf);
         globus_fifo_enqueue(&gfs_l_gfork_be_q, ent_buf);
     }
+    else
+    {
+        /* a refresh carries the latest load too */
+        memcpy(&ent_buf->buffer[GF_DYN_LOAD_CONN_NDX],
+            &buffer[GF_DYN_LOAD_CONN_NDX],
+            GF_DYN_PACKET_LEN - GF_DYN_LOAD_CONN_NDX);
+    }
     memset(buffer, '\0', GF_DYN_PACKET_LEN);
 
     /* count the timeout callbacks.  For each refresh there will
@@ -529,28 +717,17 @@ gfs_l_gfork_read_dynbe(
         globus_free(buffer);
         goto error_cs;   
     }
-    iov[0].iov_base = malloc(GF_DYN_PACKET_LEN);
-    memcpy(iov[0].iov_base, buffer, GF_DYN_PACKET_LEN);
-    iov[0].iov_len = GF_DYN_PACKET_LEN;
-
-    buffer = iov[0].iov_base;
-    buffer[GF_MSG_TYPE_NDX] = GFS_GFORK_MSG_TYPE_DYNBE;
 
     gfs_l_gfork_log(
         GLOBUS_SUCCESS, 2, "Successful registration from: %s\n",
-        &buffer[GF_DYN_CS_NDX]);
+        ent_buf->table_key);
     /* TODO: keep an "in need" list.  if only 3 were available at
         the time the client asked but wanted 4, send this message,
         otherwise, do not send.
 
         for now this is fine because all children have knowledge
         of all servers and choose themselves. */
-    result = globus_gfork_broadcast(
-        g_handle,
-        iov,
-        1,
-        gfs_l_gfork_read_dynbe_bc_cb,
-        NULL);
+    result = gfs_l_gfork_dynbe_broadcast(ent_buf);
     gfs_l_gfork_log(
         result, 3, "Broadcasted new registration\n");
     return GLOBUS_SUCCESS;
@@ -697,7 +874,7 @@ gfs_l_gfork_open_server_cb(
         handle,
         buffer,
         GF_DYN_PACKET_LEN,
-        GF_DYN_PACKET_LEN,
+        GF_DYN_PACKET_MIN_LEN,
         NULL,
         gfs_l_gfork_read_cb,
         NULL);
@@ -1293,6 +1470,136 @@ gfs_l_gfork_error_cb(
     globus_mutex_unlock(&g_mutex);
 }
 
+static
+void
+gfs_l_gfork_qos_send(
+    gfork_child_handle_t                handle,
+    const char *                        class_name,
+    globus_list_t *                     pids)
+{
+    uint32_t                            n;
+    globus_list_t *                     list;
+    globus_xio_iovec_t                  iov;
+    globus_byte_t *                     buffer;
+    globus_result_t                     result;
+    pid_t                               to_pid;
+
+    n = (uint32_t) globus_list_size(pids);
+    for(list = pids; !globus_list_empty(list); list = globus_list_rest(list))
+    {
+        to_pid = (pid_t) (intptr_t) globus_list_first(list);
+
+        buffer = globus_calloc(1, GF_QOS_MSG_LEN);
+        buffer[GF_VERSION_NDX] = GF_VERSION;
+        buffer[GF_MSG_TYPE_NDX] = GFS_GFORK_MSG_TYPE_QOS;
+        memcpy(&buffer[GF_QOS_COUNT_NDX], &n, sizeof(uint32_t));
+        strncpy((char *) &buffer[GF_QOS_CLASS_NDX],
+            class_name, GF_QOS_CLASS_LEN - 1);
+
+        iov.iov_base = buffer;
+        iov.iov_len = GF_QOS_MSG_LEN;
+
+        result = globus_gfork_send(
+            handle,
+            to_pid,
+            &iov,
+            1,
+            gfs_l_gfork_free_write_cb,
+            NULL);
+        if(result != GLOBUS_SUCCESS)
+        {
+            gfs_l_gfork_log(
+                result, 3, "failed to send qos share to %d\n", to_pid);
+        }
+    }
+}
+
+/* a child started or stopped transferring in a qos class, tell everyone
+    in the class how many are now sharing it */
+static
+void
+gfs_l_gfork_qos_update(
+    gfork_child_handle_t                handle,
+    pid_t                               from_pid,
+    globus_byte_t *                     buffer)
+{
+    uint32_t                            tmp32;
+    char *                              class_name;
+    gfs_l_qos_class_t *                 class;
+    globus_list_t *                     list;
+
+    memcpy(&tmp32, &buffer[GF_QOS_COUNT_NDX], GF_QOS_COUNT_LEN);
+    buffer[GF_QOS_CLASS_NDX + GF_QOS_CLASS_LEN - 1] = '\0';
+    class_name = (char *) &buffer[GF_QOS_CLASS_NDX];
+
+    class = (gfs_l_qos_class_t *) globus_hashtable_lookup(
+        &gfs_l_qos_table, class_name);
+    if(class == NULL)
+    {
+        if(tmp32 == 0)
+        {
+            return;
+        }
+        class = (gfs_l_qos_class_t *)
+            globus_calloc(1, sizeof(gfs_l_qos_class_t));
+        class->name = globus_libc_strdup(class_name);
+        globus_hashtable_insert(&gfs_l_qos_table, class->name, class);
+    }
+
+    list = globus_list_search(class->pids, (void *) (intptr_t) from_pid);
+    if(tmp32 > 0 && list == NULL)
+    {
+        globus_list_insert(&class->pids, (void *) (intptr_t) from_pid);
+    }
+    else if(tmp32 == 0 && list != NULL)
+    {
+        globus_list_remove(&class->pids, list);
+    }
+    gfs_l_gfork_log(GLOBUS_SUCCESS, 3,
+        "qos class %s shared by %d\n",
+        class->name, globus_list_size(class->pids));
+
+    gfs_l_gfork_qos_send(handle, class->name, class->pids);
+    if(globus_list_empty(class->pids))
+    {
+        globus_hashtable_remove(&gfs_l_qos_table, class->name);
+        globus_free(class->name);
+        globus_free(class);
+    }
+}
+
+/* drop a closed child from every qos class it was transferring in */
+static
+void
+gfs_l_gfork_qos_remove(
+    gfork_child_handle_t                handle,
+    pid_t                               from_pid)
+{
+    globus_list_t *                     classes = NULL;
+    globus_list_t *                     list;
+    gfs_l_qos_class_t *                 class;
+
+    globus_hashtable_to_list(&gfs_l_qos_table, &classes);
+    while(!globus_list_empty(classes))
+    {
+        class = (gfs_l_qos_class_t *)
+            globus_list_remove(&classes, classes);
+        list = globus_list_search(class->pids, (void *) (intptr_t) from_pid);
+        if(list == NULL)
+        {
+            continue;
+        }
+        globus_list_remove(&class->pids, list);
+        gfs_l_gfork_qos_send(handle, class->name, class->pids);
+        if(globus_list_empty(class->pids))
+        {
+            globus_hashtable_remove(&gfs_l_qos_table, class->name);
+            globus_free(class->name);
+            globus_free(class);
+        }
+    }
+}
+
 /* connection cloesd */
 static
 void
@@ -1309,6 +1616,8 @@ gfs_l_gfork_closed_cb(
         gfs_l_gfork_log(
             GLOBUS_SUCCESS, 2, "Closed called for pid %d\n", from_pid);
 
+        gfs_l_gfork_qos_remove(handle, from_pid);
+
         if(gfs_l_memlimiting)
         {
             /* if we have it as a memory entry */
@@ -1353,19 +1662,27 @@ gfs_l_gfork_incoming_cb(
             goto error;
         }
 
-        entry = (gfs_l_memlimit_entry_t *) globus_hashtable_lookup(
-            &gfs_l_memlimit_table, (void *) (intptr_t) from_pid);
-        if(entry == NULL)
-        {
-            gfs_l_gfork_log(GLOBUS_SUCCESS, 0, 
-                "Incoming message from unknown pid %d", from_pid);
-            goto error;
-        }
-
         switch(buffer[GF_MSG_TYPE_NDX])
         {
+            case GFS_GFORK_MSG_TYPE_QOS:
+                if(len >= GF_QOS_MSG_LEN)
+                {
+                    gfs_l_gfork_qos_update(handle, from_pid, buffer);
+                }
+                globus_free(buffer);
+                break;
+
             case GFS_GFORK_MSG_TYPE_RELEASE:
 
+                entry = (gfs_l_memlimit_entry_t *) globus_hashtable_lookup(
+                    &gfs_l_memlimit_table, (void *) (intptr_t) from_pid);
+                if(entry == NULL)
+                {
+                    gfs_l_gfork_log(GLOBUS_SUCCESS, 0, 
+                        "Incoming message from unknown pid %d", from_pid);
+                    goto error;
+                }
+
                 memcpy(&tmp32, 
                     &buffer[GF_RELEASE_COUNT_NDX], GF_RELEASE_COUNT_LEN);
                 if(tmp32 > 0)
@@ -1493,6 +1810,10 @@ gfs_l_gfork_backend_xio_read_cb(
         /* just log it */
         gfs_l_gfork_log(result, 0, "Backend registration failed\n");
     }
+    else if(buffer[GF_MSG_TYPE_NDX] != GFS_GFORK_MSG_TYPE_ACK)
+    {
+        gfs_l_gfork_log(GLOBUS_SUCCESS, 0, "Backend update rejected\n");
+    }
 
     globus_free(buffer);
 
@@ -1522,11 +1843,12 @@ gfs_l_gfork_backend_xio_write_cb(
         goto error;
     }
 
+    /* only the ack header matters, an older master sends less */
     result = globus_xio_register_read(
         handle,
         buffer,
         GF_DYN_PACKET_LEN,
-        GF_DYN_PACKET_LEN,
+        GF_DYN_PACKET_MIN_LEN,
         NULL,
         gfs_l_gfork_backend_xio_read_cb,
         NULL);
@@ -1546,6 +1868,52 @@ error:
         NULL);
 }
 
+/* fill in the load vector the frontends use to pick the least loaded
+    data node: sessions open here, run queue length per cpu and how much
+    of the memory limit is handed out, the latter two in percent */
+static
+void
+gfs_l_gfork_backend_load(
+    globus_byte_t *                     buffer)
+{
+    uint32_t                            conn = 0;
+    uint32_t                            cpu = 0;
+    uint32_t                            mem = 0;
+    uint32_t                            converted_32;
+#ifndef TARGET_ARCH_WIN32
+    double                              avg;
+    long                                ncpu;
+
+    if(getloadavg(&avg, 1) == 1)
+    {
+        ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        if(ncpu < 1)
+        {
+            ncpu = 1;
+        }
+        cpu = (uint32_t) (avg * 100.0 / ncpu);
+    }
+#endif
+
+    globus_mutex_lock(&g_mutex);
+    {
+        conn = (uint32_t) g_connection_count;
+        if(gfs_l_memlimiting && gfs_l_memlimit > 0)
+        {
+            mem = (uint32_t) (100 -
+                (gfs_l_memlimit_available * 100 / gfs_l_memlimit));
+        }
+    }
+    globus_mutex_unlock(&g_mutex);
+
+    converted_32 = htonl(conn);
+    memcpy(&buffer[GF_DYN_LOAD_CONN_NDX], &converted_32, sizeof(uint32_t));
+    converted_32 = htonl(cpu);
+    memcpy(&buffer[GF_DYN_LOAD_CPU_NDX], &converted_32, sizeof(uint32_t));
+    converted_32 = htonl(mem);
+    memcpy(&buffer[GF_DYN_LOAD_MEM_NDX], &converted_32, sizeof(uint32_t));
+}
+
 static
 void
 gfs_l_gfork_backend_xio_open_cb(
@@ -1563,12 +1931,14 @@ gfs_l_gfork_backend_xio_open_cb(
 
     buffer = globus_calloc(1, GF_DYN_PACKET_LEN);
     buffer[GF_VERSION_NDX] = GF_VERSION;
-    buffer[GF_MSG_TYPE_NDX] = GFS_GFORK_MSG_TYPE_DYNBE;
+    /* either a full registration or just a load update */
+    buffer[GF_MSG_TYPE_NDX] = (globus_byte_t) (intptr_t) user_arg;
     converted_32 = htonl(g_at_once);
     memcpy(&buffer[GF_DYN_AT_ONCE_NDX], &converted_32, sizeof(uint32_t));
     converted_32 = htonl(g_total_cons);
     memcpy(&buffer[GF_DYN_TOTAL_NDX], &converted_32, sizeof(uint32_t));
     strncpy((char *)&buffer[GF_DYN_CS_NDX], g_be_cs, GF_DYN_CS_LEN);
+    gfs_l_gfork_backend_load(buffer);
 
     result = globus_xio_register_write(
         handle,
@@ -1645,7 +2015,7 @@ gfs_l_gfork_backend_timer(
         g_reg_cs,
         xio_attr,
         gfs_l_gfork_backend_xio_open_cb,
-        NULL);
+        user_arg);
     if(result != GLOBUS_SUCCESS)
     {
         /* log nasty error, but don't exit */
@@ -1678,7 +2048,20 @@ gfs_l_gfork_backend_setup()
         &delay,
         &period,
         gfs_l_gfork_backend_timer,
-        NULL);
+        (void *) (intptr_t) GFS_GFORK_MSG_TYPE_DYNBE);
+
+    /* load updates are cheap for the frontend, so they go out much more
+        often than the registration refresh */
+    if(g_be_load_timer_sec > 0)
+    {
+        GlobusTimeReltimeSet(period, g_be_load_timer_sec, 0);
+        globus_callback_register_periodic(
+            NULL,
+            &period,
+            &period,
+            gfs_l_gfork_backend_timer,
+            (void *) (intptr_t) GFS_GFORK_MSG_TYPE_LOAD);
+    }
 
     return GLOBUS_SUCCESS;
 }
@@ -1737,6 +2120,12 @@ main(
         globus_hashtable_int_hash,
         globus_hashtable_int_keyeq);
 
+    globus_hashtable_init(
+        &gfs_l_qos_table,
+        64,
+        globus_hashtable_string_hash,
+        globus_hashtable_string_keyeq);
+
     globus_mutex_lock(&g_mutex);
     {
         result = gfs_l_gfork_xio_setup();
@@ -2031,6 +2420,36 @@ error_format:
 
 }
 
+static
+globus_result_t
+gfs_l_gfork_opts_loadtime(
+    globus_options_handle_t             opts_handle,
+    char *                              cmd,
+    char **                             opt,
+    void *                              arg,
+    int *                               out_parms_used)
+{   
+    globus_result_t                     result;
+    int                                 sc;
+    int                                 tm;
+    GFSGForkFuncName(gfs_l_gfork_opts_loadtime);
+
+    sc = sscanf(opt[0], "%d", &tm);
+    if(sc != 1 || tm < 0)
+    {
+        result = GFSGforkError("load interval must be a non-negative integer",
+            GFS_GFORK_ERROR_PARAMETER);
+        goto error_format;
+    }
+
+    g_be_load_timer_sec = tm;
+    *out_parms_used = 1;
+
+    return GLOBUS_SUCCESS;
+error_format:
+    return result;
+}
+
 static
 globus_result_t
 gfs_l_gfork_opts_mem_size(
@@ -2160,6 +2579,10 @@ globus_options_entry_t                   gfork_l_opts_table[] =
     {"update-interval", "u", NULL, "<int>",
         "Number of seconds between registration updates.",
         1, gfs_l_gfork_opts_updatetime},
+    {"load-interval", "li", NULL, "<int>",
+        "Number of seconds between load reports to the frontend."
+        "  0 disables them.  Default is 30",
+        1, gfs_l_gfork_opts_loadtime},
     {"mem-size", "M", NULL, "<long>",
         "Limit memory usage to a specific value.",
         1, gfs_l_gfork_opts_mem_size},
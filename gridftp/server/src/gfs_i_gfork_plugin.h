@@ -41,7 +41,8 @@
 #endif
 
 
-#define GF_VERSION                  'a'
+/* 'b' added the load vector to the end of the dynamic backend packet */
+#define GF_VERSION                  'b'
 
 /* use this to mark buffer in fifo as bad.  we know it was not 
    sent over the wire because we would not have alloed it in the first
@@ -75,7 +76,22 @@
 #define GF_DYN_REPO_NDX            (GF_DYN_COOKIE_NDX+GF_DYN_COOKIE_NDX)
 #define GF_DYN_CS_NDX              (GF_DYN_REPO_NDX+GF_DYN_REPO_LEN)
 
-#define GF_DYN_PACKET_LEN          (GF_DYN_CS_LEN+GF_DYN_CS_NDX)
+/* length of a version 'a' packet.  the master waits for no more than
+    this before checking the version so that an old peer is nacked
+    instead of left waiting */
+#define GF_DYN_PACKET_MIN_LEN      (GF_DYN_CS_LEN+GF_DYN_CS_NDX)
+
+/* load vector reported by the data node, all in network byte order on
+    the wire and converted to host order by the frontend master */
+#define GF_DYN_LOAD_CONN_LEN       (sizeof(uint32_t))
+#define GF_DYN_LOAD_CPU_LEN        (sizeof(uint32_t))
+#define GF_DYN_LOAD_MEM_LEN        (sizeof(uint32_t))
+
+#define GF_DYN_LOAD_CONN_NDX       (GF_DYN_CS_NDX+GF_DYN_CS_LEN)
+#define GF_DYN_LOAD_CPU_NDX        (GF_DYN_LOAD_CONN_NDX+GF_DYN_LOAD_CONN_LEN)
+#define GF_DYN_LOAD_MEM_NDX        (GF_DYN_LOAD_CPU_NDX+GF_DYN_LOAD_CPU_LEN)
+
+#define GF_DYN_PACKET_LEN          (GF_DYN_LOAD_MEM_LEN+GF_DYN_LOAD_MEM_NDX)
 
 /* mem messaging */
 #define GF_MEM_LIMIT_NDX            (GF_MSG_TYPE_NDX+GF_MSG_TYPE_LEN)
@@ -98,6 +114,16 @@
 
 #define GF_RELEASE_MSG_LEN          (GF_RELEASE_COUNT_NDX+GF_RELEASE_COUNT_LEN)
 
+/* qos message.  to the master the count is 1 when the child starts
+    transferring in the class and 0 when it stops, from the master it is
+    the number of children transferring in the class */
+#define GF_QOS_COUNT_NDX            (GF_MSG_TYPE_NDX+GF_MSG_TYPE_LEN)
+#define GF_QOS_COUNT_LEN            (sizeof(uint32_t))
+#define GF_QOS_CLASS_NDX            (GF_QOS_COUNT_NDX+GF_QOS_COUNT_LEN)
+#define GF_QOS_CLASS_LEN            128
+
+#define GF_QOS_MSG_LEN              (GF_QOS_CLASS_NDX+GF_QOS_CLASS_LEN)
+
 typedef enum gfs_gfork_msg_type_e
 {
     GFS_GFORK_MSG_TYPE_DYNBE = 1,
@@ -108,7 +134,9 @@ typedef enum gfs_gfork_msg_type_e
     GFS_GFORK_MSG_TYPE_NACK,
     GFS_GFORK_MSG_TYPE_CC,
     GFS_GFORK_MSG_TYPE_RELEASE,
-    GFS_GFORK_MSG_TYPE_REMOVE_DYNBE
+    GFS_GFORK_MSG_TYPE_REMOVE_DYNBE,
+    GFS_GFORK_MSG_TYPE_LOAD,
+    GFS_GFORK_MSG_TYPE_QOS
 } gfs_gfork_msg_type_t;
 
 
@@ -24,6 +24,8 @@
 #ifndef TARGET_ARCH_WIN32
 #include <grp.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #endif
 
 #ifdef TARGET_ARCH_WIN32
@@ -89,6 +91,37 @@ static globus_bool_t                    globus_l_gfs_sigint_caught = GLOBUS_FALS
 static char **                          globus_l_gfs_child_argv = NULL;
 static int                              globus_l_gfs_child_argc = 0;
 
+typedef enum
+{
+    GLOBUS_L_GFS_SESSION_WORKER_STARTING,
+    GLOBUS_L_GFS_SESSION_WORKER_IDLE,
+    GLOBUS_L_GFS_SESSION_WORKER_BUSY,
+    GLOBUS_L_GFS_SESSION_WORKER_RETIRED
+} globus_l_gfs_session_worker_state_t;
+
+/* a pre-forked server process waiting for, or serving, a session */
+typedef struct
+{
+    pid_t                               pid;
+    /* daemon end of the socketpair on the worker's stdin, -1 once closed */
+    int                                 fd;
+    /* reads the worker's ready notices from fd, NULL once closed */
+    globus_xio_handle_t                 watch;
+    globus_byte_t                       msg;
+    globus_bool_t                       retired;
+    globus_bool_t                       reaped;
+    globus_l_gfs_session_worker_state_t state;
+} globus_l_gfs_session_worker_t;
+
+/* daemon side */
+static globus_list_t *                  globus_l_gfs_session_workers = NULL;
+static char **                          globus_l_gfs_worker_argv = NULL;
+static int                              globus_l_gfs_session_worker_watches = 0;
+/* worker side */
+static int                              globus_l_gfs_session_worker_fd = -1;
+static uid_t                            globus_l_gfs_session_worker_uid;
+static int                              globus_l_gfs_session_worker_count = 0;
+
 
 #ifndef BUILD_LITE
 #define GLOBUS_L_GFS_SIGCHLD_DELAY 10
@@ -101,6 +134,44 @@ globus_result_t
 globus_l_gfs_open_new_server(
     globus_xio_handle_t                 handle);
 
+static
+globus_result_t
+globus_l_gfs_prepare_stack(
+    globus_xio_stack_t *                stack);
+
+static
+globus_result_t
+globus_l_gfs_convert_inetd_handle(void);
+
+static
+void
+globus_l_gfs_session_workers_adjust(void);
+
+static
+void
+globus_l_gfs_session_workers_reload(void);
+
+static
+void
+globus_l_gfs_session_workers_stop(void);
+
+static
+void
+globus_l_gfs_session_worker_retire(
+    globus_l_gfs_session_worker_t *     worker);
+
+static
+void
+globus_l_gfs_session_worker_open_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg);
+
+static
+globus_bool_t
+globus_l_gfs_session_worker_exited(
+    pid_t                               pid);
+
 static
 void
 globus_l_gfs_server_closed(
@@ -274,6 +345,13 @@ globus_l_gfs_sighup(
     argc = globus_i_gfs_config_int("argc");
 
     globus_i_gfs_config_init(argc, argv, GLOBUS_FALSE);
+
+    globus_mutex_lock(&globus_l_gfs_mutex);
+    {
+        globus_l_gfs_session_workers_reload();
+    }
+    globus_mutex_unlock(&globus_l_gfs_mutex);
+
     globus_gfs_log_message(
         GLOBUS_GFS_LOG_INFO, 
         "Done reloading config.\n");           
@@ -292,7 +370,8 @@ globus_l_gfs_sigchld(
     GlobusGFSName(globus_l_gfs_sigchld);
     GlobusGFSDebugEnter();
 #ifndef TARGET_ARCH_WIN32
-    while(globus_gfs_config_get_int("open_connections_count") > 0 &&
+    while((globus_gfs_config_get_int("open_connections_count") > 0 ||
+            !globus_list_empty(globus_l_gfs_session_workers)) &&
         (child_pid = waitpid(-1, &child_status, WNOHANG)) > 0)
     {
         if(WIFEXITED(child_status))
@@ -333,7 +412,10 @@ globus_l_gfs_sigchld(
     
         globus_mutex_lock(&globus_l_gfs_mutex);
         {
-            globus_i_gfs_connection_closed();
+            if(!globus_l_gfs_session_worker_exited(child_pid))
+            {
+                globus_i_gfs_connection_closed();
+            }
         }
         globus_mutex_unlock(&globus_l_gfs_mutex);   
     }
@@ -463,6 +545,8 @@ globus_l_gfs_spawn_child(
         goto error;
     }
 
+    /* the child may change to another user before it sends an event */
+    globus_i_gfs_event_stream_reconnect();
     child_pid = fork();
     if(child_pid == 0)
     { 
@@ -560,6 +644,738 @@ error:
     return result;
 }
 
+#ifndef TARGET_ARCH_WIN32
+/* start a session worker: a server process run like an inetd child, which
+   loads its configuration, modules and credentials up front and then waits
+   for the daemon to pass it an accepted connection.
+   called locked */
+static
+globus_result_t
+globus_l_gfs_session_worker_spawn(void)
+{
+    globus_result_t                     result;
+    globus_l_gfs_session_worker_t *     worker;
+    pid_t                               child_pid;
+    int                                 fds[2];
+    int                                 rc;
+    globus_xio_stack_t                  stack;
+    globus_xio_attr_t                   attr;
+    GlobusGFSName(globus_l_gfs_session_worker_spawn);
+    GlobusGFSDebugEnter();
+
+    worker = (globus_l_gfs_session_worker_t *)
+        globus_calloc(1, sizeof(globus_l_gfs_session_worker_t));
+    if(worker == NULL)
+    {
+        result = GlobusGFSErrorMemory("worker");
+        goto error_alloc;
+    }
+
+    rc = socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    if(rc == -1)
+    {
+        result = GlobusGFSErrorSystemError("socketpair", errno);
+        goto error_socketpair;
+    }
+
+    result = globus_l_gfs_prepare_stack(&stack);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_stack;
+    }
+    result = globus_xio_attr_init(&attr);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_attr;
+    }
+    result = globus_xio_attr_cntl(
+        attr,
+        globus_l_gfs_tcp_driver,
+        GLOBUS_XIO_TCP_SET_HANDLE,
+        (globus_xio_system_socket_t) fds[0]);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_watch;
+    }
+    result = globus_xio_handle_create(&worker->watch, stack);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_watch;
+    }
+
+    /* the child may change to another user before it sends an event */
+    globus_i_gfs_event_stream_reconnect();
+    child_pid = fork();
+    if(child_pid == 0)
+    {
+        if(globus_l_gfs_xio_server)
+        {
+            result = globus_xio_server_register_close(
+                globus_l_gfs_xio_server, globus_l_gfs_server_close_cb, NULL);
+            if(result == GLOBUS_SUCCESS)
+            {
+                globus_l_gfs_outstanding++;
+            }
+            else
+            {
+                globus_l_gfs_xio_server = GLOBUS_NULL;
+            }
+        }
+
+        close(fds[0]);
+        rc = dup2(fds[1], STDIN_FILENO);
+        if(rc == -1)
+        {
+            result = GlobusGFSErrorSystemError("dup2", errno);
+            globus_gfs_log_result(
+                GLOBUS_GFS_LOG_ERR, 
+                _GSSL("Could not open new handle for child process"), 
+                result);
+            exit(1);
+        }
+        close(fds[1]);
+
+        if(*globus_l_gfs_worker_argv[0] == '/')
+        {
+            rc = execv(globus_l_gfs_worker_argv[0], globus_l_gfs_worker_argv);
+        }
+        else
+        {
+            rc = execvp(globus_l_gfs_worker_argv[0], globus_l_gfs_worker_argv);
+        }
+        result = GlobusGFSErrorSystemError("execv", errno);
+        globus_gfs_log_result(
+            GLOBUS_GFS_LOG_ERR, _GSSL("Could not exec child process."), result);
+        exit(1);
+    }
+    else if(child_pid == -1)
+    {
+        result = GlobusGFSErrorSystemError("fork", errno);
+        goto error_fork;
+    }
+
+    close(fds[1]);
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+
+    worker->pid = child_pid;
+    worker->fd = fds[0];
+    worker->state = GLOBUS_L_GFS_SESSION_WORKER_STARTING;
+    globus_list_insert(&globus_l_gfs_session_workers, worker);
+
+    /* a worker that cannot be watched is retired at once */
+    result = globus_xio_register_open(
+        worker->watch,
+        NULL,
+        attr,
+        globus_l_gfs_session_worker_open_cb,
+        worker);
+    if(result == GLOBUS_SUCCESS)
+    {
+        globus_l_gfs_session_worker_watches++;
+    }
+    else
+    {
+        globus_xio_close(worker->watch, NULL);
+        worker->watch = NULL;
+        globus_l_gfs_session_worker_retire(worker);
+    }
+    globus_xio_attr_destroy(attr);
+    globus_xio_stack_destroy(stack);
+
+    globus_gfs_log_event(
+        GLOBUS_GFS_LOG_INFO,
+        GLOBUS_GFS_LOG_EVENT_START,
+        "child",
+        0,
+        "c.id=%d", 
+        child_pid);
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_fork:
+    globus_xio_close(worker->watch, NULL);
+error_watch:
+    globus_xio_attr_destroy(attr);
+error_attr:
+    globus_xio_stack_destroy(stack);
+error_stack:
+    close(fds[0]);
+    close(fds[1]);
+error_socketpair:
+    globus_free(worker);
+error_alloc:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+/* stop handing sessions to a worker.  shutting down its channel makes an
+   idle worker exit, and ends the watch; it is removed from the list when
+   it is reaped.  called locked */
+static
+void
+globus_l_gfs_session_worker_retire(
+    globus_l_gfs_session_worker_t *     worker)
+{
+    worker->retired = GLOBUS_TRUE;
+    if(worker->watch != NULL)
+    {
+        shutdown(worker->fd, SHUT_RDWR);
+    }
+    else if(worker->fd != -1)
+    {
+        close(worker->fd);
+        worker->fd = -1;
+    }
+    if(worker->state != GLOBUS_L_GFS_SESSION_WORKER_BUSY)
+    {
+        worker->state = GLOBUS_L_GFS_SESSION_WORKER_RETIRED;
+    }
+}
+
+/* the watch is closed, the worker is freed here if it was already reaped.
+   called locked */
+static
+void
+globus_l_gfs_session_worker_unwatched(
+    globus_l_gfs_session_worker_t *     worker)
+{
+    close(worker->fd);
+    worker->fd = -1;
+    worker->watch = NULL;
+    if(worker->reaped)
+    {
+        globus_free(worker);
+    }
+
+    globus_l_gfs_session_worker_watches--;
+    if(globus_l_gfs_session_worker_watches == 0)
+    {
+        globus_cond_signal(&globus_l_gfs_cond);
+    }
+}
+
+static
+void
+globus_l_gfs_session_worker_close_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    globus_mutex_lock(&globus_l_gfs_mutex);
+    {
+        globus_l_gfs_session_worker_unwatched(
+            (globus_l_gfs_session_worker_t *) user_arg);
+    }
+    globus_mutex_unlock(&globus_l_gfs_mutex);
+}
+
+/* called locked */
+static
+void
+globus_l_gfs_session_worker_unwatch(
+    globus_l_gfs_session_worker_t *     worker)
+{
+    globus_result_t                     result;
+
+    globus_l_gfs_session_worker_retire(worker);
+    result = globus_xio_register_close(
+        worker->watch,
+        NULL,
+        globus_l_gfs_session_worker_close_cb,
+        worker);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_l_gfs_session_worker_unwatched(worker);
+    }
+}
+
+/* a worker writes a byte when it has finished starting up or finished a
+   session, and its channel ends when it exits or is retired */
+static
+void
+globus_l_gfs_session_worker_read_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    globus_l_gfs_session_worker_t *     worker;
+
+    worker = (globus_l_gfs_session_worker_t *) user_arg;
+    globus_mutex_lock(&globus_l_gfs_mutex);
+    {
+        if(result == GLOBUS_SUCCESS && nbytes == 1 && !worker->retired)
+        {
+            if(worker->state == GLOBUS_L_GFS_SESSION_WORKER_BUSY)
+            {
+                globus_i_gfs_connection_closed();
+            }
+            worker->state = GLOBUS_L_GFS_SESSION_WORKER_IDLE;
+
+            result = globus_xio_register_read(
+                handle,
+                &worker->msg,
+                1,
+                1,
+                NULL,
+                globus_l_gfs_session_worker_read_cb,
+                worker);
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_l_gfs_session_worker_unwatch(worker);
+            }
+            globus_l_gfs_session_workers_adjust();
+        }
+        else
+        {
+            globus_l_gfs_session_worker_unwatch(worker);
+        }
+    }
+    globus_mutex_unlock(&globus_l_gfs_mutex);
+}
+
+static
+void
+globus_l_gfs_session_worker_open_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    globus_l_gfs_session_worker_t *     worker;
+
+    worker = (globus_l_gfs_session_worker_t *) user_arg;
+    globus_mutex_lock(&globus_l_gfs_mutex);
+    {
+        if(result == GLOBUS_SUCCESS && !worker->retired)
+        {
+            result = globus_xio_register_read(
+                handle,
+                &worker->msg,
+                1,
+                1,
+                NULL,
+                globus_l_gfs_session_worker_read_cb,
+                worker);
+        }
+        else if(result == GLOBUS_SUCCESS)
+        {
+            result = GlobusGFSErrorGeneric("Session worker retired.");
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_l_gfs_session_worker_unwatch(worker);
+        }
+    }
+    globus_mutex_unlock(&globus_l_gfs_mutex);
+}
+
+/* start or stop workers to keep the number of idle ones between
+   session_workers_min_spare and session_workers_max_spare.
+   called locked */
+static
+void
+globus_l_gfs_session_workers_adjust(void)
+{
+    globus_list_t *                     list;
+    globus_l_gfs_session_worker_t *     worker;
+    globus_result_t                     result;
+    int                                 spare = 0;
+    int                                 min_spare;
+    int                                 max_spare;
+
+    min_spare = globus_i_gfs_config_int("session_workers_min_spare");
+    max_spare = globus_i_gfs_config_int("session_workers_max_spare");
+    if(max_spare < min_spare)
+    {
+        max_spare = min_spare;
+    }
+    if(globus_l_gfs_worker_argv == NULL)
+    {
+        return;
+    }
+
+    for(list = globus_l_gfs_session_workers;
+        !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        worker = (globus_l_gfs_session_worker_t *) globus_list_first(list);
+        if(worker->state == GLOBUS_L_GFS_SESSION_WORKER_STARTING ||
+            worker->state == GLOBUS_L_GFS_SESSION_WORKER_IDLE)
+        {
+            spare++;
+        }
+    }
+    for(list = globus_l_gfs_session_workers;
+        spare > max_spare && !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        worker = (globus_l_gfs_session_worker_t *) globus_list_first(list);
+        if(worker->state == GLOBUS_L_GFS_SESSION_WORKER_IDLE)
+        {
+            globus_l_gfs_session_worker_retire(worker);
+            spare--;
+        }
+    }
+
+    while(spare < min_spare && !globus_l_gfs_terminated)
+    {
+        result = globus_l_gfs_session_worker_spawn();
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_gfs_log_result(
+                GLOBUS_GFS_LOG_ERR,
+                _GSSL("Could not start a session worker"),
+                result);
+            break;
+        }
+        spare++;
+    }
+}
+
+/* retire all waiting workers, so that new ones pick up a reloaded
+   configuration.  called locked */
+static
+void
+globus_l_gfs_session_workers_reload(void)
+{
+    globus_list_t *                     list;
+    globus_l_gfs_session_worker_t *     worker;
+
+    for(list = globus_l_gfs_session_workers;
+        !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        worker = (globus_l_gfs_session_worker_t *) globus_list_first(list);
+        if(worker->state != GLOBUS_L_GFS_SESSION_WORKER_BUSY)
+        {
+            globus_l_gfs_session_worker_retire(worker);
+        }
+    }
+    globus_l_gfs_session_workers_adjust();
+}
+
+/* retire all workers when the daemon exits, and wait for their watches
+   to close.  called locked */
+static
+void
+globus_l_gfs_session_workers_stop(void)
+{
+    globus_list_t *                     list;
+
+    for(list = globus_l_gfs_session_workers;
+        !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        globus_l_gfs_session_worker_retire(
+            (globus_l_gfs_session_worker_t *) globus_list_first(list));
+    }
+    while(globus_l_gfs_session_worker_watches > 0)
+    {
+        globus_cond_wait(&globus_l_gfs_cond, &globus_l_gfs_mutex);
+    }
+}
+
+/* remove a reaped worker.  returns GLOBUS_FALSE if pid was not a worker.
+   called locked */
+static
+globus_bool_t
+globus_l_gfs_session_worker_exited(
+    pid_t                               pid)
+{
+    globus_list_t *                     list;
+    globus_l_gfs_session_worker_t *     worker;
+
+    for(list = globus_l_gfs_session_workers;
+        !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        worker = (globus_l_gfs_session_worker_t *) globus_list_first(list);
+        if(worker->pid == pid)
+        {
+            globus_list_remove(&globus_l_gfs_session_workers, list);
+            if(worker->state == GLOBUS_L_GFS_SESSION_WORKER_BUSY)
+            {
+                globus_i_gfs_connection_closed();
+            }
+            worker->state = GLOBUS_L_GFS_SESSION_WORKER_RETIRED;
+            globus_l_gfs_session_worker_retire(worker);
+            if(worker->watch == NULL)
+            {
+                globus_free(worker);
+            }
+            else
+            {
+                /* freed when the watch is closed */
+                worker->reaped = GLOBUS_TRUE;
+            }
+
+            globus_l_gfs_session_workers_adjust();
+            return GLOBUS_TRUE;
+        }
+    }
+
+    return GLOBUS_FALSE;
+}
+
+/* pass an accepted connection to an idle worker.  fails if there is none,
+   in which case the caller spawns a child as usual.
+   called locked */
+static
+globus_result_t
+globus_l_gfs_session_worker_dispatch(
+    globus_xio_handle_t                 handle)
+{
+    globus_result_t                     result;
+    globus_list_t *                     list;
+    globus_l_gfs_session_worker_t *     worker = NULL;
+    globus_xio_system_socket_t          socket_handle;
+    struct msghdr                       msg;
+    struct iovec                        iov;
+    struct cmsghdr *                    cmsg;
+    char                                cbuf[CMSG_SPACE(sizeof(int))];
+    char                                byte = 'S';
+    int                                 fd;
+    ssize_t                             rc;
+    GlobusGFSName(globus_l_gfs_session_worker_dispatch);
+    GlobusGFSDebugEnter();
+
+    for(list = globus_l_gfs_session_workers;
+        !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        worker = (globus_l_gfs_session_worker_t *) globus_list_first(list);
+        if(worker->state == GLOBUS_L_GFS_SESSION_WORKER_IDLE)
+        {
+            break;
+        }
+        worker = NULL;
+    }
+    if(worker == NULL)
+    {
+        result = GlobusGFSErrorGeneric("No idle session worker.");
+        goto error;
+    }
+
+    result = globus_xio_handle_cntl(
+        handle,
+        globus_l_gfs_tcp_driver,
+        GLOBUS_XIO_TCP_GET_HANDLE,
+        &socket_handle);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+    fd = socket_handle;
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    do
+    {
+        rc = sendmsg(worker->fd, &msg, 0);
+    } while(rc == -1 && errno == EINTR);
+    if(rc != 1)
+    {
+        result = GlobusGFSErrorSystemError("sendmsg", errno);
+        globus_l_gfs_session_worker_retire(worker);
+        goto error;
+    }
+    worker->state = GLOBUS_L_GFS_SESSION_WORKER_BUSY;
+
+    globus_gfs_log_message(
+        GLOBUS_GFS_LOG_INFO, 
+        "Connection passed to session worker %d\n", 
+        worker->pid);
+
+    /* inc the connection count 2 here since we will dec it on this close
+    and when the worker reports the session is over or exits */
+    globus_gfs_config_inc_int("open_connections_count", 2);
+    result = globus_xio_register_close(
+        handle,
+        NULL,
+        globus_l_gfs_close_cb,
+        NULL);    
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_i_gfs_connection_closed();
+    }
+
+    globus_l_gfs_session_workers_adjust();
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+/* worker side: tell the daemon we are ready, and start serving the next
+   connection it passes us.  returns GLOBUS_FALSE if the worker should exit
+   instead.  called locked */
+static
+globus_bool_t
+globus_l_gfs_session_worker_next(void)
+{
+    globus_result_t                     result;
+    struct msghdr                       msg;
+    struct iovec                        iov;
+    struct cmsghdr *                    cmsg;
+    char                                cbuf[CMSG_SPACE(sizeof(int))];
+    char                                byte = 'R';
+    int                                 max_sessions;
+    int                                 fd;
+    ssize_t                             rc;
+    GlobusGFSName(globus_l_gfs_session_worker_next);
+    GlobusGFSDebugEnter();
+
+    if(!globus_i_gfs_config_bool("session_worker"))
+    {
+        goto exit;
+    }
+
+    if(globus_l_gfs_session_worker_fd == -1)
+    {
+        /* the daemon's channel arrives on stdin, where sessions go */
+        globus_l_gfs_session_worker_fd = dup(STDIN_FILENO);
+        if(globus_l_gfs_session_worker_fd == -1)
+        {
+            goto exit;
+        }
+        fcntl(globus_l_gfs_session_worker_fd, F_SETFD, FD_CLOEXEC);
+        globus_l_gfs_session_worker_uid = getuid();
+    }
+    else
+    {
+        /* sessions of a root worker change the process user (process_user,
+           chroot), so it never serves more than one */
+        max_sessions = globus_i_gfs_config_int("session_worker_sessions");
+        if(globus_l_gfs_session_worker_uid == 0 ||
+            getuid() != globus_l_gfs_session_worker_uid ||
+            (max_sessions > 0 &&
+                globus_l_gfs_session_worker_count >= max_sessions))
+        {
+            goto exit;
+        }
+    }
+
+    do
+    {
+        rc = write(globus_l_gfs_session_worker_fd, &byte, 1);
+    } while(rc == -1 && errno == EINTR);
+    if(rc != 1)
+    {
+        goto exit;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cbuf;
+    msg.msg_controllen = sizeof(cbuf);
+
+    globus_mutex_unlock(&globus_l_gfs_mutex);
+    do
+    {
+        rc = recvmsg(globus_l_gfs_session_worker_fd, &msg, 0);
+    } while(rc == -1 && errno == EINTR);
+    globus_mutex_lock(&globus_l_gfs_mutex);
+    if(rc != 1)
+    {
+        /* retired by the daemon */
+        goto exit;
+    }
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    if(cmsg == NULL ||
+        cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+    {
+        goto exit;
+    }
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    rc = dup2(fd, STDIN_FILENO);
+    close(fd);
+    if(rc == -1)
+    {
+        goto exit;
+    }
+
+    globus_l_gfs_session_worker_count++;
+    globus_l_gfs_terminated = GLOBUS_FALSE;
+    result = globus_l_gfs_convert_inetd_handle();
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_gfs_log_result(
+            GLOBUS_GFS_LOG_ERR, _GSSL("Could not open new handle"), result);
+        goto exit;
+    }
+
+    GlobusGFSDebugExit();
+    return GLOBUS_TRUE;
+
+exit:
+    GlobusGFSDebugExit();
+    return GLOBUS_FALSE;
+}
+#else
+static
+void
+globus_l_gfs_session_workers_adjust(void)
+{
+}
+
+static
+void
+globus_l_gfs_session_workers_reload(void)
+{
+}
+
+static
+void
+globus_l_gfs_session_workers_stop(void)
+{
+}
+
+static
+globus_bool_t
+globus_l_gfs_session_worker_exited(
+    pid_t                               pid)
+{
+    return GLOBUS_FALSE;
+}
+
+static
+globus_result_t
+globus_l_gfs_session_worker_dispatch(
+    globus_xio_handle_t                 handle)
+{
+    return GlobusGFSErrorGeneric("No idle session worker.");
+}
+
+static
+globus_bool_t
+globus_l_gfs_session_worker_next(void)
+{
+    return GLOBUS_FALSE;
+}
+#endif
+
 static
 void
 globus_i_gfs_connection_closed()
@@ -1190,7 +2006,12 @@ globus_l_gfs_server_accept_cb(
         {
             /* if we fail to actually open a connection with either method we
                 do not fail, just log that the connection failed */
-            if(globus_i_gfs_config_bool("daemon"))
+            if(globus_i_gfs_config_bool("daemon") &&
+                globus_l_gfs_session_worker_dispatch(handle) == GLOBUS_SUCCESS)
+            {
+                /* handed to a pre-forked worker */
+            }
+            else if(globus_i_gfs_config_bool("daemon"))
             {
                 result = globus_l_gfs_spawn_child(handle);
                 if(result != GLOBUS_SUCCESS)
@@ -1421,6 +2242,8 @@ globus_l_gfs_be_daemon()
     globus_xio_stack_destroy(stack);
     globus_xio_attr_destroy(attr);
 
+    globus_l_gfs_session_workers_adjust();
+
     GlobusGFSDebugExit();
     return GLOBUS_SUCCESS;
 
@@ -1516,6 +2339,18 @@ globus_l_gfs_server_build_child_args(
     
     globus_l_gfs_child_argv[j] = NULL;
     globus_l_gfs_child_argc = j;
+
+    if(!detach && globus_i_gfs_config_int("session_workers_min_spare") > 0)
+    {
+        globus_l_gfs_worker_argv = (char **)
+            globus_calloc(1, sizeof(char *) * (j + 2));
+        if(globus_l_gfs_worker_argv != NULL)
+        {
+            memcpy(globus_l_gfs_worker_argv,
+                globus_l_gfs_child_argv, sizeof(char *) * j);
+            globus_l_gfs_worker_argv[j] = "-session-worker";
+        }
+    }
 }
 
 static
@@ -1972,7 +2807,14 @@ main(
             config ? config : "none");
            
 
-        if(inetd)
+        if(inetd && globus_i_gfs_config_bool("session_worker"))
+        {
+            if(!globus_l_gfs_session_worker_next())
+            {
+                globus_l_gfs_terminated = GLOBUS_TRUE;
+            }
+        }
+        else if(inetd)
         {
             result = globus_l_gfs_convert_inetd_handle();
             if(result != GLOBUS_SUCCESS)
@@ -2011,13 +2853,18 @@ main(
             cs ? " contact=" : "",
             cs ? cs : "");
 
-        /* run until we are done */ 
-        while(!globus_l_gfs_terminated || 
-            globus_gfs_config_get_int("open_connections_count") > 0 ||
-                globus_l_gfs_outstanding > 0)
+        /* run until we are done, session workers then wait for the next
+            connection */
+        do
         {
-            globus_cond_wait(&globus_l_gfs_cond, &globus_l_gfs_mutex);
-        }
+            while(!globus_l_gfs_terminated || 
+                globus_gfs_config_get_int("open_connections_count") > 0 ||
+                    globus_l_gfs_outstanding > 0)
+            {
+                globus_cond_wait(&globus_l_gfs_cond, &globus_l_gfs_mutex);
+            }
+        } while(globus_l_gfs_session_worker_next());
+        globus_l_gfs_session_workers_stop();
     }
     globus_mutex_unlock(&globus_l_gfs_mutex);
 
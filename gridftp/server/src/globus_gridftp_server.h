@@ -1182,7 +1182,107 @@ void
 globus_gridftp_server_get_stripe_block_size(
     globus_gfs_operation_t              op,
     globus_size_t *                     stripe_block_size);
-    
+
+/*
+ * transfer buffers
+ *
+ * A process wide pool of transfer buffers, held to the memory budget set
+ * by the buffer_memory_limit option or by the gfork master.  A module
+ * creates a client per recv() or send() with the block size it will use,
+ * and gets and puts buffers through it.  globus_gridftp_server_buffer_get()
+ * returns NULL when the client already holds its fair share of the
+ * budget; it never fails that way while the client holds no buffers, so
+ * a transfer can always make progress with one.  All buffers must be put
+ * back before the client is destroyed.
+ */
+typedef struct globus_i_gfs_buffer_client_s *  globus_gfs_buffer_client_t;
+
+typedef struct globus_gfs_buffer_stats_s
+{
+    int                                 clients;
+    int                                 in_use_buffers;
+    int                                 free_buffers;
+    int                                 denied;
+    globus_off_t                        in_use_bytes;
+    globus_off_t                        free_bytes;
+    globus_off_t                        mapped_bytes;
+    globus_off_t                        peak_mapped_bytes;
+} globus_gfs_buffer_stats_t;
+
+globus_result_t
+globus_gridftp_server_buffer_client_init(
+    globus_gfs_buffer_client_t *        client,
+    globus_size_t                       buffer_size);
+
+globus_byte_t *
+globus_gridftp_server_buffer_get(
+    globus_gfs_buffer_client_t          client);
+
+void
+globus_gridftp_server_buffer_put(
+    globus_gfs_buffer_client_t          client,
+    globus_byte_t *                     buffer);
+
+void
+globus_gridftp_server_buffer_client_destroy(
+    globus_gfs_buffer_client_t          client);
+
+void
+globus_gridftp_server_buffer_get_stats(
+    globus_gfs_buffer_stats_t *         stats);
+
+/*
+ * reorder buffer
+ *
+ * For modules whose storage can only be written sequentially.  Blocks
+ * read with globus_gridftp_server_register_read() are passed to
+ * globus_gridftp_server_reorder_write() as they arrive, in any order.
+ * Data at the next expected offset is passed straight to write_func, and
+ * data ahead of it is copied and held until the gap before it is filled:
+ * in memory up to memory_limit bytes (0 for no limit), then in an
+ * unlinked, memory-mapped temp file up to spill_limit bytes (0 for none).
+ * write_func always sees the data in order, and its buffer is only valid
+ * for the call.  An error is returned once both limits are reached.
+ * globus_gridftp_server_reorder_finish() fails if data is still held
+ * behind a gap.  Calls on one reorder buffer must be serialized.
+ */
+typedef struct globus_i_gfs_reorder_s *  globus_gfs_reorder_t;
+
+typedef globus_result_t
+(*globus_gfs_reorder_write_t)(
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset,
+    void *                              user_arg);
+
+globus_result_t
+globus_gridftp_server_reorder_init(
+    globus_gfs_reorder_t *              reorder,
+    globus_off_t                        offset,
+    globus_size_t                       memory_limit,
+    globus_off_t                        spill_limit,
+    globus_gfs_reorder_write_t          write_func,
+    void *                              user_arg);
+
+globus_result_t
+globus_gridftp_server_reorder_write(
+    globus_gfs_reorder_t                reorder,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset);
+
+globus_off_t
+globus_gridftp_server_reorder_get_offset(
+    globus_gfs_reorder_t                reorder);
+
+globus_result_t
+globus_gridftp_server_reorder_finish(
+    globus_gfs_reorder_t                reorder);
+
+void
+globus_gridftp_server_reorder_destroy(
+    globus_gfs_reorder_t                reorder);
+
 /*
  * get session username
  * 
@@ -0,0 +1,527 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * process wide pool of transfer buffers.
+ *
+ * buffers of one size are carved out of slabs mapped 2MB at a time so
+ * they can be backed by huge pages, and are handed back to their slab
+ * when a transfer is done so the next transfer reuses them.  the pool
+ * is held to a memory budget: the buffer_memory_limit option, or the
+ * share of the gfork master's memory limit this process was given,
+ * whichever is smaller.  each open client may hold at most its fair
+ * share (budget / clients) but is always allowed one buffer so that
+ * every transfer can make progress.
+ */
+
+#include "globus_i_gridftp_server.h"
+#ifndef TARGET_ARCH_WIN32
+#include <sys/mman.h>
+#endif
+
+#define GFS_BUFFER_SLAB_SIZE            (2 * 1024 * 1024)
+#define GFS_BUFFER_HASH_SIZE            256
+
+struct gfs_l_buffer_class_s;
+
+typedef struct gfs_l_buffer_slab_s
+{
+    struct gfs_l_buffer_class_s *       class;
+    globus_byte_t *                     base;
+    globus_size_t                       map_size;
+    globus_bool_t                       mapped;
+    int                                 nbuffers;
+    int                                 nfree;
+    globus_byte_t **                    free_stack;
+} gfs_l_buffer_slab_t;
+
+typedef struct gfs_l_buffer_class_s
+{
+    globus_size_t                       buffer_size;
+    globus_list_t *                     slabs;
+    int                                 clients;
+} gfs_l_buffer_class_t;
+
+struct globus_i_gfs_buffer_client_s
+{
+    gfs_l_buffer_class_t *              class;
+    int                                 in_use;
+};
+
+static globus_thread_once_t             gfs_l_buffer_once =
+                                            GLOBUS_THREAD_ONCE_INIT;
+static globus_mutex_t                   gfs_l_buffer_mutex;
+static globus_list_t *                  gfs_l_buffer_classes = NULL;
+/* buffer address -> owning slab */
+static globus_hashtable_t               gfs_l_buffer_table;
+static int                              gfs_l_buffer_clients = 0;
+static globus_off_t                     gfs_l_buffer_mapped = 0;
+static globus_gfs_buffer_stats_t        gfs_l_buffer_stats;
+
+
+static
+void
+gfs_l_buffer_init(void)
+{
+    globus_mutex_init(&gfs_l_buffer_mutex, NULL);
+    globus_hashtable_init(
+        &gfs_l_buffer_table,
+        GFS_BUFFER_HASH_SIZE,
+        globus_hashtable_voidp_hash,
+        globus_hashtable_voidp_keyeq);
+    memset(&gfs_l_buffer_stats, 0, sizeof(globus_gfs_buffer_stats_t));
+}
+
+/* 0 means no limit */
+static
+globus_off_t
+gfs_l_buffer_budget()
+{
+    globus_off_t                        limit;
+    globus_off_t                        share;
+
+    limit = (globus_off_t) globus_i_gfs_config_int("buffer_memory_limit");
+    share = (globus_off_t) globus_gfs_config_get_int("tcp_mem_limit");
+    if(share > 0 && (limit <= 0 || share < limit))
+    {
+        limit = share;
+    }
+
+    return limit > 0 ? limit : 0;
+}
+
+static
+void
+gfs_l_buffer_slab_unmap(
+    gfs_l_buffer_slab_t *               slab)
+{
+    int                                 i;
+
+    for(i = 0; i < slab->nbuffers; i++)
+    {
+        globus_hashtable_remove(
+            &gfs_l_buffer_table,
+            slab->base + i * slab->class->buffer_size);
+    }
+#ifndef TARGET_ARCH_WIN32
+    if(slab->mapped)
+    {
+        munmap(slab->base, slab->map_size);
+    }
+    else
+#endif
+    {
+        globus_free(slab->base);
+    }
+    gfs_l_buffer_mapped -= slab->map_size;
+    gfs_l_buffer_stats.free_buffers -= slab->nbuffers;
+    gfs_l_buffer_stats.free_bytes -=
+        (globus_off_t) slab->nbuffers * slab->class->buffer_size;
+    gfs_l_buffer_stats.mapped_bytes = gfs_l_buffer_mapped;
+
+    globus_free(slab->free_stack);
+    globus_free(slab);
+}
+
+static
+gfs_l_buffer_slab_t *
+gfs_l_buffer_slab_map(
+    gfs_l_buffer_class_t *              class)
+{
+    gfs_l_buffer_slab_t *               slab;
+    globus_size_t                       map_size;
+    int                                 nbuffers;
+    int                                 i;
+
+    nbuffers = GFS_BUFFER_SLAB_SIZE / class->buffer_size;
+    if(nbuffers < 1)
+    {
+        nbuffers = 1;
+    }
+    map_size = nbuffers * class->buffer_size;
+    map_size = (map_size + GFS_BUFFER_SLAB_SIZE - 1) &
+        ~((globus_size_t) GFS_BUFFER_SLAB_SIZE - 1);
+
+    slab = (gfs_l_buffer_slab_t *)
+        globus_calloc(1, sizeof(gfs_l_buffer_slab_t));
+    if(slab == NULL)
+    {
+        goto error_slab;
+    }
+    slab->free_stack = (globus_byte_t **)
+        globus_malloc(nbuffers * sizeof(globus_byte_t *));
+    if(slab->free_stack == NULL)
+    {
+        goto error_stack;
+    }
+
+#ifndef TARGET_ARCH_WIN32
+    slab->base = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if(globus_i_gfs_config_bool("buffer_hugepages"))
+    {
+        slab->base = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if(slab->base == MAP_FAILED)
+    {
+        /* no reserved huge pages, let the kernel back it if it can */
+        slab->base = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+        if(slab->base != MAP_FAILED &&
+            globus_i_gfs_config_bool("buffer_hugepages"))
+        {
+            madvise(slab->base, map_size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    if(slab->base != MAP_FAILED)
+    {
+        slab->mapped = GLOBUS_TRUE;
+    }
+    else
+#endif
+    {
+        slab->base = globus_malloc(map_size);
+        if(slab->base == NULL)
+        {
+            goto error_map;
+        }
+    }
+
+    slab->class = class;
+    slab->map_size = map_size;
+    slab->nbuffers = nbuffers;
+    slab->nfree = nbuffers;
+    for(i = 0; i < nbuffers; i++)
+    {
+        slab->free_stack[i] = slab->base + i * class->buffer_size;
+        globus_hashtable_insert(
+            &gfs_l_buffer_table, slab->free_stack[i], slab);
+    }
+    globus_list_insert(&class->slabs, slab);
+
+    gfs_l_buffer_mapped += map_size;
+    gfs_l_buffer_stats.free_buffers += nbuffers;
+    gfs_l_buffer_stats.free_bytes +=
+        (globus_off_t) nbuffers * class->buffer_size;
+    gfs_l_buffer_stats.mapped_bytes = gfs_l_buffer_mapped;
+    if(gfs_l_buffer_mapped > gfs_l_buffer_stats.peak_mapped_bytes)
+    {
+        gfs_l_buffer_stats.peak_mapped_bytes = gfs_l_buffer_mapped;
+    }
+
+    return slab;
+
+error_map:
+    globus_free(slab->free_stack);
+error_stack:
+    globus_free(slab);
+error_slab:
+    return NULL;
+}
+
+/* unmap completely free slabs.  the last slab of a class that still has
+ * clients is kept unless reclaiming for room, so back to back transfers
+ * do not remap their buffers. */
+static
+void
+gfs_l_buffer_trim(
+    globus_bool_t                       reclaim)
+{
+    globus_list_t *                     class_list;
+    globus_list_t *                     list;
+    globus_list_t *                     next;
+    gfs_l_buffer_class_t *              class;
+    gfs_l_buffer_slab_t *               slab;
+    globus_bool_t                       kept;
+
+    class_list = gfs_l_buffer_classes;
+    while(!globus_list_empty(class_list))
+    {
+        class = (gfs_l_buffer_class_t *) globus_list_first(class_list);
+        class_list = globus_list_rest(class_list);
+
+        kept = reclaim;
+        list = class->slabs;
+        while(!globus_list_empty(list))
+        {
+            slab = (gfs_l_buffer_slab_t *) globus_list_first(list);
+            next = globus_list_rest(list);
+            if(slab->nfree == slab->nbuffers)
+            {
+                if(!kept && class->clients > 0)
+                {
+                    kept = GLOBUS_TRUE;
+                }
+                else
+                {
+                    globus_list_remove(&class->slabs, list);
+                    gfs_l_buffer_slab_unmap(slab);
+                }
+            }
+            list = next;
+        }
+    }
+}
+
+static
+gfs_l_buffer_class_t *
+gfs_l_buffer_class_find(
+    globus_size_t                       buffer_size)
+{
+    globus_list_t *                     list;
+    gfs_l_buffer_class_t *              class;
+
+    for(list = gfs_l_buffer_classes;
+        !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        class = (gfs_l_buffer_class_t *) globus_list_first(list);
+        if(class->buffer_size == buffer_size)
+        {
+            return class;
+        }
+    }
+
+    class = (gfs_l_buffer_class_t *)
+        globus_calloc(1, sizeof(gfs_l_buffer_class_t));
+    if(class != NULL)
+    {
+        class->buffer_size = buffer_size;
+        globus_list_insert(&gfs_l_buffer_classes, class);
+    }
+
+    return class;
+}
+
+globus_result_t
+globus_gridftp_server_buffer_client_init(
+    globus_gfs_buffer_client_t *        u_client,
+    globus_size_t                       buffer_size)
+{
+    globus_gfs_buffer_client_t          client;
+    globus_result_t                     result;
+    GlobusGFSName(globus_gridftp_server_buffer_client_init);
+    GlobusGFSDebugEnter();
+
+    if(u_client == NULL || buffer_size == 0)
+    {
+        result = GlobusGFSErrorParameter("buffer_size");
+        goto error_param;
+    }
+
+    client = (globus_gfs_buffer_client_t)
+        globus_calloc(1, sizeof(struct globus_i_gfs_buffer_client_s));
+    if(client == NULL)
+    {
+        result = GlobusGFSErrorMemory("client");
+        goto error_alloc;
+    }
+
+    globus_thread_once(&gfs_l_buffer_once, gfs_l_buffer_init);
+    globus_mutex_lock(&gfs_l_buffer_mutex);
+    {
+        client->class = gfs_l_buffer_class_find(buffer_size);
+        if(client->class == NULL)
+        {
+            globus_mutex_unlock(&gfs_l_buffer_mutex);
+            globus_free(client);
+            result = GlobusGFSErrorMemory("class");
+            goto error_alloc;
+        }
+        client->class->clients++;
+        gfs_l_buffer_clients++;
+        gfs_l_buffer_stats.clients = gfs_l_buffer_clients;
+    }
+    globus_mutex_unlock(&gfs_l_buffer_mutex);
+
+    *u_client = client;
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_alloc:
+error_param:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+globus_byte_t *
+globus_gridftp_server_buffer_get(
+    globus_gfs_buffer_client_t          client)
+{
+    globus_list_t *                     list;
+    gfs_l_buffer_class_t *              class;
+    gfs_l_buffer_slab_t *               slab = NULL;
+    globus_byte_t *                     buffer = NULL;
+    globus_off_t                        budget;
+    globus_off_t                        share;
+    globus_off_t                        slab_size;
+
+    globus_mutex_lock(&gfs_l_buffer_mutex);
+    {
+        class = client->class;
+        budget = gfs_l_buffer_budget();
+        if(budget > 0 && client->in_use > 0)
+        {
+            share = budget / gfs_l_buffer_clients;
+            if((globus_off_t) (client->in_use + 1) * class->buffer_size >
+                share)
+            {
+                gfs_l_buffer_stats.denied++;
+                goto done;
+            }
+        }
+
+        for(list = class->slabs;
+            !globus_list_empty(list) && slab == NULL;
+            list = globus_list_rest(list))
+        {
+            if(((gfs_l_buffer_slab_t *) globus_list_first(list))->nfree > 0)
+            {
+                slab = (gfs_l_buffer_slab_t *) globus_list_first(list);
+            }
+        }
+
+        if(slab == NULL)
+        {
+            slab_size = GFS_BUFFER_SLAB_SIZE > class->buffer_size ?
+                GFS_BUFFER_SLAB_SIZE : class->buffer_size;
+            if(budget > 0 && gfs_l_buffer_mapped + slab_size > budget)
+            {
+                gfs_l_buffer_trim(GLOBUS_TRUE);
+                if(gfs_l_buffer_mapped + slab_size > budget &&
+                    client->in_use > 0)
+                {
+                    gfs_l_buffer_stats.denied++;
+                    goto done;
+                }
+            }
+            slab = gfs_l_buffer_slab_map(class);
+            if(slab == NULL)
+            {
+                goto done;
+            }
+        }
+
+        buffer = slab->free_stack[--slab->nfree];
+        client->in_use++;
+        gfs_l_buffer_stats.in_use_buffers++;
+        gfs_l_buffer_stats.in_use_bytes += class->buffer_size;
+        gfs_l_buffer_stats.free_buffers--;
+        gfs_l_buffer_stats.free_bytes -= class->buffer_size;
+    }
+done:
+    globus_mutex_unlock(&gfs_l_buffer_mutex);
+
+    return buffer;
+}
+
+void
+globus_gridftp_server_buffer_put(
+    globus_gfs_buffer_client_t          client,
+    globus_byte_t *                     buffer)
+{
+    gfs_l_buffer_slab_t *               slab;
+
+    globus_mutex_lock(&gfs_l_buffer_mutex);
+    {
+        slab = (gfs_l_buffer_slab_t *)
+            globus_hashtable_lookup(&gfs_l_buffer_table, buffer);
+        globus_assert(slab != NULL && slab->class == client->class);
+
+        slab->free_stack[slab->nfree++] = buffer;
+        client->in_use--;
+        gfs_l_buffer_stats.in_use_buffers--;
+        gfs_l_buffer_stats.in_use_bytes -= slab->class->buffer_size;
+        gfs_l_buffer_stats.free_buffers++;
+        gfs_l_buffer_stats.free_bytes += slab->class->buffer_size;
+    }
+    globus_mutex_unlock(&gfs_l_buffer_mutex);
+}
+
+void
+globus_gridftp_server_buffer_client_destroy(
+    globus_gfs_buffer_client_t          client)
+{
+    globus_list_t *                     list;
+    GlobusGFSName(globus_gridftp_server_buffer_client_destroy);
+    GlobusGFSDebugEnter();
+
+    globus_mutex_lock(&gfs_l_buffer_mutex);
+    {
+        globus_assert(client->in_use == 0);
+
+        client->class->clients--;
+        gfs_l_buffer_clients--;
+        gfs_l_buffer_stats.clients = gfs_l_buffer_clients;
+        if(client->class->clients == 0)
+        {
+            /* keep one slab of the size just used; the next transfer
+             * will most likely want the same size */
+            client->class->clients++;
+            gfs_l_buffer_trim(GLOBUS_FALSE);
+            client->class->clients--;
+            list = gfs_l_buffer_classes;
+            while(!globus_list_empty(list))
+            {
+                gfs_l_buffer_class_t *  class;
+                globus_list_t *         next;
+
+                class = (gfs_l_buffer_class_t *) globus_list_first(list);
+                next = globus_list_rest(list);
+                if(class->clients == 0 && globus_list_empty(class->slabs))
+                {
+                    globus_list_remove(&gfs_l_buffer_classes, list);
+                    globus_free(class);
+                }
+                list = next;
+            }
+        }
+
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_DUMP,
+            "buffer pool: %d clients, %" GLOBUS_OFF_T_FORMAT " bytes in use, "
+            "%" GLOBUS_OFF_T_FORMAT " free, %" GLOBUS_OFF_T_FORMAT
+            " mapped (peak %" GLOBUS_OFF_T_FORMAT "), %d requests denied\n",
+            gfs_l_buffer_stats.clients,
+            gfs_l_buffer_stats.in_use_bytes,
+            gfs_l_buffer_stats.free_bytes,
+            gfs_l_buffer_stats.mapped_bytes,
+            gfs_l_buffer_stats.peak_mapped_bytes,
+            gfs_l_buffer_stats.denied);
+    }
+    globus_mutex_unlock(&gfs_l_buffer_mutex);
+
+    globus_free(client);
+
+    GlobusGFSDebugExit();
+}
+
+void
+globus_gridftp_server_buffer_get_stats(
+    globus_gfs_buffer_stats_t *         stats)
+{
+    globus_thread_once(&gfs_l_buffer_once, gfs_l_buffer_init);
+    globus_mutex_lock(&gfs_l_buffer_mutex);
+    {
+        *stats = gfs_l_buffer_stats;
+    }
+    globus_mutex_unlock(&gfs_l_buffer_mutex);
+}
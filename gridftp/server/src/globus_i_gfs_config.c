@@ -144,6 +144,18 @@ static const globus_l_gfs_config_option_t option_list[] =
     NULL /* attempt to run non-forked if fork fails */, NULL, NULL, GLOBUS_FALSE, NULL},
  {"single", "single", NULL, "single", "1", GLOBUS_L_GFS_CONFIG_BOOL, GLOBUS_FALSE, NULL, 
     "Exit after a single connection.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"session_workers_min_spare", "session_workers_min_spare", NULL, "session-workers-min-spare", NULL, GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
+    "Number of idle, pre-initialized session workers to keep in daemon mode.  New connections are "
+    "handed to an idle worker instead of starting a new server process.  The default is 0, which "
+    "disables the worker pool.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"session_workers_max_spare", "session_workers_max_spare", NULL, "session-workers-max-spare", NULL, GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
+    "Maximum number of idle session workers.  Idle workers above this number are stopped.  If less than "
+    "session_workers_min_spare, session_workers_min_spare is used.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"session_worker_sessions", "session_worker_sessions", NULL, "session-worker-sessions", NULL, GLOBUS_L_GFS_CONFIG_INT, 1, NULL,
+    "Number of sessions a session worker serves before exiting.  0 means no limit.  Workers started "
+    "as 'root' always exit after a single session.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"session_worker", "session_worker", NULL, "session-worker", NULL, GLOBUS_L_GFS_CONFIG_BOOL, GLOBUS_FALSE, NULL,
+    NULL /* pre-forked session worker, receives connections from the daemon */, NULL, NULL, GLOBUS_FALSE, NULL},
  {"chroot_path", "chroot_path", NULL, "chroot-path", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL, 
     "Path to become the new root after authentication.  This path must contain a valid "
     "certificate structure, /etc/passwd, and /etc/group.  The command "
@@ -302,6 +314,9 @@ static const globus_l_gfs_config_option_t option_list[] =
     "The default options are a 64k buffer size and a 5 second flush interval.  A 0 second flush interval "
     "will disable periodic flushing, and the buffer will only flush when it is full.  A value of 0 for "
     "buffer will disable buffering and all messages will be written immediately.  "
+    "The stdio modules also take 'writer', which gives each thread a buffer of its own that "
+    "a separate thread writes out.  With writer=wait a thread whose buffer is full writes it "
+    "out itself, with writer=drop the message is dropped and counted in the log.  "
     "Example: -log-module stdio:buffer=4096:interval=10", NULL, NULL,GLOBUS_FALSE, NULL},
  {"log_single", "log_single", NULL, "logfile", "l", GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
     "Path of a single file to log all activity to.  If neither this option or log_unique is set, "
@@ -319,6 +334,11 @@ static const globus_l_gfs_config_option_t option_list[] =
  {"log_filemode", "log_filemode", NULL, "log-filemode", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
     "File access permissions of log files. Should be an octal number such as "
     "0644.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"event_stream", "event_stream", NULL, "event-stream", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
+    "Path of a local unix datagram socket to send binary session, transfer, performance and "
+    "error events to.  Events are dropped and counted when nothing is reading them.  "
+    "gfs-event-reader reads and prints them.  The server connects to the socket before "
+    "sessions change user, so it only needs to be writable by the server's user.", NULL, NULL,GLOBUS_FALSE, NULL},
  {"disable_usage_stats", "disable_usage_stats", "GLOBUS_USAGE_OPTOUT", "disable-usage-stats", NULL, GLOBUS_L_GFS_CONFIG_BOOL, GLOBUS_FALSE, NULL,
     "Disable transmission of per-transfer usage statistics.  See the Usage Statistics "
     "section in the online documentation for more information.", NULL, NULL,GLOBUS_FALSE, NULL},
@@ -366,6 +386,10 @@ static const globus_l_gfs_config_option_t option_list[] =
     " ", NULL, NULL,GLOBUS_FALSE, NULL},
  {"data_node", "data_node", NULL, "data-node", "dn", GLOBUS_L_GFS_CONFIG_BOOL, GLOBUS_FALSE, NULL,
     "This server is a backend data node.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"data_node_reuse", "data_node_reuse", NULL, "data-node-reuse", NULL, GLOBUS_L_GFS_CONFIG_BOOL, GLOBUS_TRUE, NULL,
+    "Keep connections to data nodes open when a transfer completes and reuse them for "
+    "later transfers in the same session, instead of connecting to a data node for "
+    "every transfer.", NULL, NULL,GLOBUS_FALSE, NULL},
  {"stripe_blocksize", "stripe_blocksize", NULL, "stripe-blocksize", "sbs", GLOBUS_L_GFS_CONFIG_INT, (1024 * 1024), NULL,
     "Size in bytes of sequential data that each stripe will transfer.", NULL, NULL,GLOBUS_FALSE, NULL},
  {"stripe_count", "stripe_count", NULL, "stripe-count", NULL, GLOBUS_L_GFS_CONFIG_INT, -1, NULL,
@@ -391,6 +415,12 @@ static const globus_l_gfs_config_option_t option_list[] =
     "on different storage systems. See the manpage for sync() for more information.", NULL, NULL,GLOBUS_FALSE, NULL},
  {"direct_io", "direct", NULL, "direct", NULL, GLOBUS_L_GFS_CONFIG_BOOL, GLOBUS_FALSE, NULL,
     NULL /* use O_DIRECT */, NULL, NULL, GLOBUS_FALSE, NULL},
+ {"buffer_memory_limit", "buffer_memory_limit", NULL, "buffer-memory-limit", NULL, GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
+    "Maximum number of bytes of transfer buffers a server process will hold at once, shared fairly "
+    "among its concurrent transfers.  When run under gfork with a memory limit, the smaller of this "
+    "and the share given by the gfork master is used.  A value of 0 sets no limit.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"buffer_hugepages", "buffer_hugepages", NULL, "buffer-hugepages", NULL, GLOBUS_L_GFS_CONFIG_BOOL, GLOBUS_FALSE, NULL,
+    "Back transfer buffers with huge pages when the system provides them.", NULL, NULL,GLOBUS_FALSE, NULL},
  {"perms", "perms", NULL, "perms", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
     "Set the default permissions for created files. Should be an octal number "
     "such as 0644.  The default is 0644.  Note: If umask is set it will affect "
@@ -398,6 +428,17 @@ static const globus_l_gfs_config_option_t option_list[] =
     "resulting files will be created with permissions of 0664. ", NULL, NULL,GLOBUS_FALSE, NULL},
  {"file_timeout", "file_timeout", NULL, "file-timeout", NULL, GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
     "Timeout in seconds for all disk accesses.  A value of 0 disables the timeout.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"file_queue_depth", "file_queue_depth", NULL, "file-queue-depth", NULL, GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
+    "Number of disk reads or writes to keep in flight for each file transfer, issued from "
+    "a pool of I/O threads instead of through the XIO file driver.  Adjacent blocks "
+    "are merged into a single write.  Only used when no file_timeout or custom disk "
+    "stack is set, and only in a threaded server (see threads).  A value of 0 disables "
+    "the I/O threads.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"file_readahead", "file_readahead", NULL, "file-readahead", NULL, GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
+    "Number of bytes of a file being sent to read ahead of the network.  Up to this much file "
+    "data is read into transfer buffers beyond those the data channel has in flight, and the "
+    "kernel is asked to prefetch this far ahead of the current read, so that disk latency on "
+    "slow parallel filesystems overlaps with sending.  A value of 0 disables read ahead.", NULL, NULL,GLOBUS_FALSE, NULL},
 {NULL, "Network Options", NULL, NULL, NULL, 0, 0, NULL, NULL, NULL, NULL,GLOBUS_FALSE, NULL},
  {"port", "port", NULL, "port", "p", GLOBUS_L_GFS_CONFIG_INT, 0, NULL,
     "Port on which a frontend will listen for client control channel connections, "
@@ -435,6 +476,18 @@ static const globus_l_gfs_config_option_t option_list[] =
     "This, along with -data-interface, can be used to enable operation behind "
     "a firewall and/or when NAT is involved. "
     "This is the same as setting the environment variable GLOBUS_TCP_PORT_RANGE.", NULL, NULL, GLOBUS_FALSE, NULL},
+ {"http_streams", "http_streams", NULL, "http-streams", NULL, GLOBUS_L_GFS_CONFIG_INT, 1, NULL,
+    "Number of connections an HTTP DOWNLOAD uses to fetch a file as parallel byte ranges, when "
+    "the HTTP server supports ranges.  Each connection is given at least 1MB of the file.  The "
+    "client may choose a different number with a STREAMS=n argument to the command.", NULL, NULL,GLOBUS_FALSE, NULL},
+ {"qos_rules", "qos_rules", NULL, "qos-rules", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
+    "Comma separated list of bandwidth and metadata operation limits, each of the form "
+    "class=rate[:ops], where rate is in bytes per second (K, M and G suffixes are allowed) and "
+    "ops is operations per second.  A class is * for the whole server, user:name, user:* for each "
+    "user without a rule of their own, group:name for sessions with that primary group, or "
+    "path:/prefix for files under that path.  An operation is held to every class it is in.  "
+    "When run under gfork, the limit of a class is split evenly among the server processes "
+    "transferring in it.  Example: *=1G,user:*=200M:50,path:/scratch=400M", NULL, NULL,GLOBUS_FALSE, NULL},
 {NULL, "User Messages", NULL, NULL, NULL, 0, 0, NULL, NULL, NULL, NULL,GLOBUS_FALSE, NULL},
  {"banner", "banner", NULL, "banner", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
     "Message to display to the client before authentication.", NULL, NULL,GLOBUS_TRUE, NULL},
@@ -463,9 +516,12 @@ static const globus_l_gfs_config_option_t option_list[] =
     "string is defined by the DSI being loaded.", NULL, NULL,GLOBUS_FALSE, NULL},
  {"allowed_modules", "allowed_modules", NULL, "allowed-modules", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
     "Comma separated list of ERET/ESTO modules to allow, and optionally specify an alias for. "
-    "Example: module1,alias2:module2,module3 (module2 will be loaded when a client asks for alias2).", NULL, NULL,GLOBUS_FALSE, NULL}, 
+    "Example: module1,alias2:module2,module3 (module2 will be loaded when a client asks for alias2). "
+    "The file DSI provides the bundle module, which sends or receives a directory of files over "
+    "one data connection, and the manifest module, which sends the checksum of every file under "
+    "a directory.", NULL, NULL,GLOBUS_FALSE, NULL}, 
  {"dc_whitelist", "dc_whitelist", NULL, "dc-whitelist", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
-    "A comma separated list of drivers allowed on the network stack.", NULL, NULL,GLOBUS_FALSE, NULL},
+    "A comma separated list of drivers allowed on the network stack.  The default is gsi,tcp,shm.", NULL, NULL,GLOBUS_FALSE, NULL},
  {"fs_whitelist", "fs_whitelist", NULL, "fs-whitelist", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
     "A comma separated list of drivers allowed on the disk stack.", NULL, NULL,GLOBUS_FALSE, NULL},
  {"popen_whitelist", "popen_whitelist", NULL, "popen-whitelist", NULL, GLOBUS_L_GFS_CONFIG_STRING, 0, NULL,
@@ -91,6 +91,7 @@ typedef struct
     char *                              username;
     globus_gridftp_server_control_t     server_handle;
     globus_object_t *                   close_error;
+    globus_callback_handle_t            watchdog_handle;
     
     globus_hashtable_t                  custom_cmd_table;
 } globus_l_gfs_server_instance_t;
@@ -516,6 +517,13 @@ globus_l_gfs_done_cb(
     }
     globus_mutex_unlock(&globus_l_gfs_control_mutex);
 
+    /* a session worker may live on to serve another session */
+    if(instance->watchdog_handle != GLOBUS_NULL_HANDLE)
+    {
+        globus_callback_unregister(instance->watchdog_handle, NULL, NULL, NULL);
+        instance->watchdog_handle = GLOBUS_NULL_HANDLE;
+    }
+
     globus_gridftp_server_control_destroy(instance->server_handle);
 
     instance->close_error = 
@@ -2323,6 +2331,30 @@ globus_l_gfs_data_transfer_cb(
     GlobusGFSDebugExit();
 }
 
+/* the bundle and manifest modules act on everything under the path.  like
+ * a recursive MLSC they are refused unless nothing under it is restricted */
+static
+int
+globus_l_gfs_module_access(
+    const char *                        mod_name,
+    int                                 access_type)
+{
+    const char *                        module_name;
+
+    if(mod_name != NULL)
+    {
+        module_name = globus_i_gfs_config_get_module_name(mod_name);
+        if(module_name != NULL &&
+            (strcmp(module_name, "bundle") == 0 ||
+            strcmp(module_name, "manifest") == 0))
+        {
+            access_type |= GFS_L_DIR;
+        }
+    }
+
+    return access_type;
+}
+
 static
 void
 globus_l_gfs_request_send(
@@ -2380,7 +2412,10 @@ globus_l_gfs_request_send(
     }
 
     result = globus_l_gfs_get_full_path(
-        instance, path, &send_info->pathname, GFS_L_READ);
+        instance,
+        path,
+        &send_info->pathname,
+        globus_l_gfs_module_access(send_info->module_name, GFS_L_READ));
     if(result != GLOBUS_SUCCESS)
     {
         goto error_init;
@@ -2512,7 +2547,10 @@ globus_l_gfs_request_recv(
     }
         
     result = globus_l_gfs_get_full_path(
-        instance, path, &recv_info->pathname, GFS_L_WRITE);
+        instance,
+        path,
+        &recv_info->pathname,
+        globus_l_gfs_module_access(recv_info->module_name, GFS_L_WRITE));
     if(result != GLOBUS_SUCCESS)
     {
         goto error_init;
@@ -3110,6 +3148,7 @@ globus_l_gfs_add_commands(
     globus_result_t                     result;
     char *                              feat_str = NULL;
     char *                              dsi_ver = NULL;
+    const char *                        module_name;
     GlobusGFSName(globus_l_gfs_add_commands);
     GlobusGFSDebugEnter();
 
@@ -3563,6 +3602,30 @@ globus_l_gfs_add_commands(
         goto error;
     }
 
+    /* ERET/ESTO bundle="R|F" <dir>, see the file DSI */
+    module_name = globus_i_gfs_config_get_module_name("bundle");
+    if(module_name != NULL && strcmp(module_name, "bundle") == 0)
+    {
+        result = globus_gridftp_server_control_add_feature(
+            control_handle, "BUNDLE");
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto error;
+        }
+    }
+
+    /* ERET manifest="MD5|ADLER32" <dir>, see the file DSI */
+    module_name = globus_i_gfs_config_get_module_name("manifest");
+    if(module_name != NULL && strcmp(module_name, "manifest") == 0)
+    {
+        result = globus_gridftp_server_control_add_feature(
+            control_handle, "MANIFEST");
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto error;
+        }
+    }
+
     dsi_ver = globus_i_gfs_data_dsi_version();
     if(dsi_ver)
     {
@@ -3714,6 +3777,7 @@ globus_i_gfs_control_start(
     instance->close_func = close_func;
     instance->close_arg = close_arg;
     instance->xio_handle = handle;
+    instance->watchdog_handle = GLOBUS_NULL_HANDLE;
     instance->rnfr_pathname = NULL;
     instance->slfr_pathname = NULL;
     instance->scks_alg = NULL;
@@ -3914,6 +3978,7 @@ globus_i_gfs_control_start(
         {
             goto error_start;
         }
+        globus_l_gfs_control_should_be_gone = GLOBUS_FALSE;
         
         globus_gfs_log_event(
             GLOBUS_GFS_LOG_INFO,
@@ -3941,7 +4006,7 @@ globus_i_gfs_control_start(
         globus_reltime_t                timer;
         GlobusTimeReltimeSet(timer, 300, 0);
         globus_callback_register_periodic(
-            NULL,
+            &instance->watchdog_handle,
             &timer,
             &timer,
             globus_l_gfs_control_watchdog_check,
@@ -216,6 +216,18 @@ typedef struct
     globus_byte_t *                     list_response;
     globus_bool_t                       free_buffer;
     globus_bool_t                       final;
+
+    /* data callback held back by qos */
+    globus_result_t                     result;
+    globus_byte_t *                     buffer;
+    globus_size_t                       length;
+    globus_off_t                        offset;
+    globus_bool_t                       eof;
+    globus_callback_func_t              kickout;
+    globus_abstime_t                    deadline;
+
+    /* HTTP DOWNLOAD range the read was registered on */
+    int                                 http_range;
 } globus_l_gfs_data_bounce_t;
 
 typedef struct 
@@ -307,8 +319,22 @@ typedef struct
     globus_callback_handle_t            watch_handle;
     
     globus_hashtable_t                  custom_cmd_table;
+
+    /* session id in event_stream records */
+    globus_off_t                        event_id;
 } globus_l_gfs_data_session_t;
 
+/* one byte range of an HTTP DOWNLOAD, fetched on its own connection.
+ * offsets are into the response body */
+typedef struct
+{
+    globus_xio_handle_t                 handle;
+    globus_off_t                        offset;
+    globus_off_t                        end;
+    globus_bool_t                       busy;
+    globus_bool_t                       eof;
+} globus_l_gfs_data_http_range_t;
+
 typedef struct
 {
     globus_l_gfs_data_session_t *       session_handle;
@@ -324,6 +350,12 @@ typedef struct
     globus_xio_attr_t                   xio_attr;
     globus_off_t                        http_length;
     globus_off_t                        http_transferred;
+    /* set when the download is split into ranges, http_ranges[0].handle
+     * is http_handle.  reads wait in http_pending_reads while every range
+     * with data left has one outstanding */
+    globus_l_gfs_data_http_range_t *    http_ranges;
+    int                                 http_range_count;
+    globus_fifo_t                       http_pending_reads;
     char *                              http_response_str;
     char *                              http_ip;
     globus_callback_handle_t            perf_handle;
@@ -444,6 +476,19 @@ typedef struct globus_l_gfs_data_operation_s
 
     globus_bool_t                       order_data;
     globus_off_t                        order_data_start;
+
+    /* qos_rules classes this op draws from */
+    globus_i_gfs_qos_t                  qos;
+    globus_bool_t                       qos_charged;
+    /* data callbacks held back by qos, in the order they completed */
+    globus_fifo_t                       qos_q;
+    globus_bool_t                       qos_draining;
+    /* the data channel is at eof while reads are still held */
+    globus_bool_t                       qos_eof;
+    globus_off_t                        qos_eof_offset;
+
+    /* transfer id in event_stream records */
+    globus_off_t                        event_id;
 } globus_l_gfs_data_operation_t;
 
 typedef struct
@@ -586,6 +631,31 @@ globus_l_gfs_data_update_restricted_paths_symlinks(
     globus_l_gfs_data_session_t *   session_handle,
     globus_list_t **                rp_list);
 
+static
+void
+globus_l_gfs_data_event_stream_session(
+    globus_l_gfs_data_session_t *       session_handle,
+    globus_i_gfs_event_stream_type_t    type)
+{
+    globus_i_gfs_event_record_t         record;
+
+    if(!globus_i_gfs_event_stream_enabled())
+    {
+        return;
+    }
+    globus_i_gfs_event_stream_start(
+        &record, type, session_handle->event_id, 0);
+    globus_i_gfs_event_stream_add_string(
+        &record, GLOBUS_I_GFS_EVENT_TAG_USER, session_handle->username);
+    globus_i_gfs_event_stream_add_string(
+        &record, GLOBUS_I_GFS_EVENT_TAG_SUBJECT, session_handle->subject);
+    globus_i_gfs_event_stream_add_string(
+        &record, GLOBUS_I_GFS_EVENT_TAG_CLIENT_IP, session_handle->client_ip);
+    globus_i_gfs_event_stream_add_string(
+        &record, GLOBUS_I_GFS_EVENT_TAG_TASKID, session_handle->taskid);
+    globus_i_gfs_event_stream_send(&record);
+}
+
 static
 void
 globus_l_gfs_data_brain_ready_delay_cb(
@@ -610,6 +680,12 @@ globus_i_gfs_data_http_write_cb(
     globus_xio_data_descriptor_t        data_desc,
     void *                              user_arg);
 
+static
+void
+globus_l_gfs_data_http_range_read(
+    globus_l_gfs_data_operation_t *     op,
+    globus_l_gfs_data_bounce_t *        bounce_info);
+
 globus_result_t 
 globus_i_gfs_data_http_get(
     globus_l_gfs_data_operation_t *     op,
@@ -617,6 +693,7 @@ globus_i_gfs_data_http_get(
     char *                              request,
     globus_off_t                        offset,
     globus_off_t                        length,
+    int                                 streams,
     globus_bool_t                       do_retry);
 
 globus_result_t
@@ -2309,6 +2386,56 @@ globus_i_gfs_kv_replaceval(
 
 
 
+/* every op takes one qos operation token on its way to the DSI, and a
+ * transfer is then paced by the classes it was attached to here */
+static
+globus_bool_t
+globus_l_gfs_data_qos_delay(
+    globus_l_gfs_data_operation_t *     op,
+    globus_reltime_t *                  delay)
+{
+    const char *                        pathname;
+    globus_bool_t                       transfer = GLOBUS_FALSE;
+
+    op->qos_charged = GLOBUS_TRUE;
+    switch(op->type)
+    {
+        case GLOBUS_L_GFS_DATA_INFO_TYPE_COMMAND:
+            pathname = ((globus_gfs_command_info_t *)
+                op->info_struct)->pathname;
+            break;
+
+        case GLOBUS_L_GFS_DATA_INFO_TYPE_STAT:
+            pathname = ((globus_gfs_stat_info_t *)
+                op->info_struct)->pathname;
+            break;
+
+        case GLOBUS_L_GFS_DATA_INFO_TYPE_SEND:
+        case GLOBUS_L_GFS_DATA_INFO_TYPE_RECV:
+            transfer = GLOBUS_TRUE;
+            /* fall through */
+        case GLOBUS_L_GFS_DATA_INFO_TYPE_LIST:
+            pathname = ((globus_gfs_transfer_info_t *)
+                op->info_struct)->pathname;
+            break;
+
+        default:
+            return GLOBUS_FALSE;
+    }
+
+    op->qos = globus_i_gfs_qos_attach(
+        op->session_handle->username,
+        op->session_handle->gid,
+        pathname,
+        transfer);
+    if(op->qos != NULL)
+    {
+        globus_fifo_init(&op->qos_q);
+    }
+
+    return globus_i_gfs_qos_charge(op->qos, 0, 1, delay);
+}
+
 static
 void
 globus_l_gfs_blocking_dispatch_kickout(
@@ -2319,11 +2446,23 @@ globus_l_gfs_blocking_dispatch_kickout(
     globus_gfs_command_info_t *         cmd_info;
     globus_gfs_data_info_t *            data_info;
     globus_gfs_stat_info_t *            stat_info;
+    globus_reltime_t                    delay;
     GlobusGFSName(globus_l_gfs_blocking_dispatch_kickout);
     GlobusGFSDebugEnter();
 
     op = (globus_l_gfs_data_operation_t *) user_arg;
 
+    if(!op->qos_charged && globus_l_gfs_data_qos_delay(op, &delay))
+    {
+        globus_callback_register_oneshot(
+            NULL,
+            &delay,
+            globus_l_gfs_blocking_dispatch_kickout,
+            op);
+        GlobusGFSDebugExit();
+        return;
+    }
+
     if(op->session_handle->dsi->descriptor & GLOBUS_GFS_DSI_DESCRIPTOR_BLOCKING)
     {
         globus_thread_blocking_will_block();
@@ -2835,6 +2974,9 @@ globus_l_gfs_data_brain_ready_delay_cb(
         globus_xio_contact_destroy(&parsed_contact);
     }
 
+    globus_l_gfs_data_event_stream_session(
+        op->session_handle, GLOBUS_I_GFS_EVENT_SESSION_START);
+
     if(op->session_handle->dsi->init_func != NULL)
     {
         op->session_handle->dsi->init_func(op, session_info);
@@ -5179,7 +5321,7 @@ globus_i_gfs_data_init()
         globus_hashtable_string_hash,
         globus_hashtable_string_keyeq);
     globus_l_gfs_load_safe(
-        "dc_whitelist", "gsi,tcp", &gfs_l_data_net_allowed_drivers);
+        "dc_whitelist", "gsi,tcp,shm", &gfs_l_data_net_allowed_drivers);
 
     globus_hashtable_init(
         &gfs_l_data_disk_allowed_drivers,
@@ -5295,6 +5437,7 @@ globus_l_gfs_data_operation_init(
     op->recvd_bytes = 0;
     op->max_offset = -1;
     op->order_data = session_handle->order_data;
+    op->event_id = globus_i_gfs_event_stream_next_id();
     globus_mutex_init(&op->stat_lock, NULL);
 
     *u_op = op;
@@ -5352,6 +5495,11 @@ globus_l_gfs_data_operation_destroy(
         globus_free(op->storattr->checksum_md5);
         globus_free(op->storattr);
     }
+    if(op->qos != NULL)
+    {
+        globus_fifo_destroy(&op->qos_q);
+        globus_i_gfs_qos_detach(op->qos);
+    }
     globus_mutex_destroy(&op->stat_lock);
 
     globus_free(op);
@@ -6022,13 +6170,23 @@ globus_i_gfs_data_request_command(
             char *                  path;
             globus_off_t            offset;
             globus_off_t            length;                
+            int                     streams;
+            char *                  tmp_val;
             
             result = globus_i_gfs_data_http_parse_args(
                 cmd_info->pathname, &path, &request, &offset, &length);
             if(result == GLOBUS_SUCCESS)
             {
+                /* optional STREAMS=n overrides http_streams */
+                streams = globus_i_gfs_config_int("http_streams");
+                if((tmp_val = globus_i_gfs_kv_getval(
+                    cmd_info->pathname, "STREAMS", 0)) != NULL)
+                {
+                    streams = atoi(tmp_val);
+                    globus_free(tmp_val);
+                }
                 result = globus_i_gfs_data_http_get(
-                    op, path, request, offset, length, GLOBUS_TRUE);
+                    op, path, request, offset, length, streams, GLOBUS_TRUE);
             }
             if(result != GLOBUS_SUCCESS)
             {
@@ -10045,6 +10203,113 @@ globus_l_gfs_data_get_nl_msg(
 }
 
 
+/* the command a transfer was for, as named in the transfer log */
+static
+char *
+globus_l_gfs_data_transfer_type(
+    globus_l_gfs_data_operation_t *     op)
+{
+    globus_gfs_transfer_info_t *        info;
+
+    info = (globus_gfs_transfer_info_t *) op->info_struct;
+
+    if(op->writing)
+    {
+        if(info->list_type)
+        {
+            if(strncmp(info->list_type, "LIST:", 5) == 0)
+            {
+                return "LIST";
+            }
+            else if(strncmp(info->list_type, "NLST:", 5) == 0)
+            {
+                return "NLST";
+            }
+            return "MLSD";
+        }
+        else if(info->module_name || info->partial_offset != 0 ||
+            info->partial_length != -1)
+        {
+            return "ERET";
+        }
+        return "RETR";
+    }
+    if(info->module_name || info->partial_offset != 0 || !info->truncate)
+    {
+        return "ESTO";
+    }
+    return "STOR";
+}
+
+static
+void
+globus_l_gfs_data_event_stream_transfer(
+    globus_l_gfs_data_operation_t *     op,
+    globus_i_gfs_event_stream_type_t    type)
+{
+    globus_i_gfs_event_record_t         record;
+    globus_gfs_transfer_info_t *        info;
+    struct timeval                      now;
+    char *                              message;
+
+    if(!globus_i_gfs_event_stream_enabled())
+    {
+        return;
+    }
+    info = (globus_gfs_transfer_info_t *) op->info_struct;
+
+    globus_i_gfs_event_stream_start(
+        &record, type, op->session_handle->event_id, op->event_id);
+    globus_i_gfs_event_stream_add_string(
+        &record, GLOBUS_I_GFS_EVENT_TAG_OP,
+        globus_l_gfs_data_transfer_type(op));
+    globus_i_gfs_event_stream_add_string(
+        &record, GLOBUS_I_GFS_EVENT_TAG_PATH, info->pathname);
+    switch(type)
+    {
+      case GLOBUS_I_GFS_EVENT_TRANSFER_BEGIN:
+        globus_i_gfs_event_stream_add_string(
+            &record, GLOBUS_I_GFS_EVENT_TAG_USER,
+            op->session_handle->username);
+        break;
+
+      case GLOBUS_I_GFS_EVENT_ERROR:
+        message = globus_error_print_friendly(
+            globus_error_peek(op->cached_res));
+        globus_i_gfs_event_stream_add_string(
+            &record, GLOBUS_I_GFS_EVENT_TAG_MESSAGE, message);
+        if(message)
+        {
+            globus_free(message);
+        }
+        break;
+
+      default:
+        gettimeofday(&now, NULL);
+        globus_i_gfs_event_stream_add_int(
+            &record, GLOBUS_I_GFS_EVENT_TAG_BYTES, op->bytes_transferred);
+        globus_i_gfs_event_stream_add_int(
+            &record, GLOBUS_I_GFS_EVENT_TAG_DURATION_USEC,
+            (globus_off_t) (now.tv_sec - op->start_timeval.tv_sec) * 1000000 +
+                (now.tv_usec - op->start_timeval.tv_usec));
+        globus_i_gfs_event_stream_add_int(
+            &record, GLOBUS_I_GFS_EVENT_TAG_STREAMS,
+            op->data_handle->info.nstreams);
+        globus_i_gfs_event_stream_add_int(
+            &record, GLOBUS_I_GFS_EVENT_TAG_STRIPES, op->node_count);
+        globus_i_gfs_event_stream_add_int(
+            &record, GLOBUS_I_GFS_EVENT_TAG_BLOCKSIZE,
+            op->data_handle->info.blocksize);
+        globus_i_gfs_event_stream_add_int(
+            &record, GLOBUS_I_GFS_EVENT_TAG_TCP_BUFFER,
+            op->data_handle->info.tcp_bufsize);
+        globus_i_gfs_event_stream_add_string(
+            &record, GLOBUS_I_GFS_EVENT_TAG_REMOTE_IP, op->remote_ip);
+        break;
+    }
+    globus_i_gfs_event_stream_send(&record);
+}
+
 static
 void
 globus_l_gfs_data_end_transfer_kickout(
@@ -10290,45 +10555,7 @@ response_exit:
 
         info = (globus_gfs_transfer_info_t *) op->info_struct;
 
-        if(op->writing)
-        {
-            if(info->list_type)
-            {
-                if(strncmp(info->list_type, "LIST:", 5) == 0)
-                {
-                    type = "LIST";
-                }
-                else if(strncmp(info->list_type, "NLST:", 5) == 0)
-                {
-                    type = "NLST";
-                }
-                else
-                {
-                    type = "MLSD";
-                }
-            }
-            else if(info->module_name || info->partial_offset != 0 ||
-                info->partial_length != -1)
-            {
-                type = "ERET";
-            }
-            else
-            {
-                type = "RETR";
-            }
-        }
-        else
-        {
-            if(info->module_name || info->partial_offset != 0 ||
-                 !info->truncate)
-            {
-                type = "ESTO";
-            }
-            else
-            {
-                type = "STOR";
-            }
-        }
+        type = globus_l_gfs_data_transfer_type(op);
 
         globus_gfs_log_message(
             GLOBUS_GFS_LOG_INFO,
@@ -10383,7 +10610,12 @@ response_exit:
             op->cached_res,
             "file=\"%s\"",
             ((globus_gfs_transfer_info_t *) op->info_struct)->pathname);
+
+        globus_l_gfs_data_event_stream_transfer(op, GLOBUS_I_GFS_EVENT_ERROR);
     }
+    globus_l_gfs_data_event_stream_transfer(
+        op, GLOBUS_I_GFS_EVENT_TRANSFER_END);
+
     if(disconnect && op->data_handle->is_mine)
     {
         memset(&event_reply, '\0', sizeof(globus_gfs_event_info_t));
@@ -10420,45 +10652,7 @@ response_exit:
 
         info = (globus_gfs_transfer_info_t *) op->info_struct;
 
-        if(op->writing)
-        {
-            if(info->list_type)
-            {
-                if(strncmp(info->list_type, "LIST:", 5) == 0)
-                {
-                    type = "LIST";
-                }
-                else if(strncmp(info->list_type, "NLST:", 5) == 0)
-                {
-                    type = "NLST";
-                }
-                else
-                {
-                    type = "MLSD";
-                }
-            }
-            else if(info->module_name || info->partial_offset != 0 ||
-                info->partial_length != -1)
-            {
-                type = "ERET";
-            }
-            else
-            {
-                type = "RETR";
-            }
-        }
-        else
-        {
-            if(info->module_name || info->partial_offset != 0 ||
-                 !info->truncate)
-            {
-                type = "ESTO";
-            }
-            else
-            {
-                type = "STOR";
-            }
-        }
+        type = globus_l_gfs_data_transfer_type(op);
         gettimeofday(&end_timeval, NULL);
 
         if(globus_i_gfs_config_string("log_transfer"))
@@ -11038,30 +11232,20 @@ globus_l_gfs_data_send_eof(
 
 static
 void
-globus_l_gfs_data_write_cb(
-    void *                              user_arg,
-    globus_ftp_control_handle_t *       handle,
-    globus_object_t *                   error,
-    globus_byte_t *                     buffer,
-    globus_size_t                       length,
-    globus_off_t                        offset,
-    globus_bool_t                       eof)
+globus_l_gfs_data_write_kickout(
+    void *                              user_arg)
 {
     globus_l_gfs_data_bounce_t *        bounce_info;
-    GlobusGFSName(globus_l_gfs_data_write_cb);
+    GlobusGFSName(globus_l_gfs_data_write_kickout);
     GlobusGFSDebugEnter();
 
     bounce_info = (globus_l_gfs_data_bounce_t *) user_arg;
-    globus_l_gfs_data_alive(bounce_info->op->session_handle);
-
-    bounce_info->op->bytes_transferred += length;
-    bounce_info->op->recvd_bytes += length;
 
     bounce_info->callback.write(
         bounce_info->op,
-        error ? globus_error_put(globus_object_copy(error)) : GLOBUS_SUCCESS,
-        buffer,
-        length,
+        bounce_info->result,
+        bounce_info->buffer,
+        bounce_info->length,
         bounce_info->user_arg);
 
     globus_free(bounce_info);
@@ -11071,31 +11255,22 @@ globus_l_gfs_data_write_cb(
 
 static
 void
-globus_l_gfs_data_read_cb(
-    void *                              user_arg,
-    globus_ftp_control_handle_t *       handle,
-    globus_object_t *                   error,
-    globus_byte_t *                     buffer,
-    globus_size_t                       length,
-    globus_off_t                        offset,
-    globus_bool_t                       eof)
+globus_l_gfs_data_read_kickout(
+    void *                              user_arg)
 {
     globus_l_gfs_data_bounce_t *        bounce_info;
-    GlobusGFSName(globus_l_gfs_data_read_cb);
+    GlobusGFSName(globus_l_gfs_data_read_kickout);
     GlobusGFSDebugEnter();
 
     bounce_info = (globus_l_gfs_data_bounce_t *) user_arg;
-    globus_l_gfs_data_alive(bounce_info->op->session_handle);
-
-    bounce_info->op->bytes_transferred += length;
 
     bounce_info->callback.read(
         bounce_info->op,
-        error ? globus_error_put(globus_object_copy(error)) : GLOBUS_SUCCESS,
-        buffer,
-        length,
-        offset + bounce_info->op->write_delta,
-        eof,
+        bounce_info->result,
+        bounce_info->buffer,
+        bounce_info->length,
+        bounce_info->offset,
+        bounce_info->eof,
         bounce_info->user_arg);
 
     globus_free(bounce_info);
@@ -11105,74 +11280,237 @@ globus_l_gfs_data_read_cb(
 
 static
 void
-globus_l_gfs_data_trev_kickout(
+globus_l_gfs_data_qos_drain(
     void *                              user_arg)
 {
-    globus_l_gfs_data_trev_bounce_t *   bounce_info;
-    globus_gfs_event_info_t *           event_reply;
-    void *                              remote_data_arg = NULL;
-    globus_bool_t                       pass = GLOBUS_FALSE;
-    globus_bool_t                       destroy_session = GLOBUS_FALSE;
-    globus_bool_t                       destroy_op = GLOBUS_FALSE;
-    globus_gfs_event_info_t             event_info;
-
-    globus_gfs_acl_action_t             action;
-    int                                 rc;
-    globus_result_t                     res;
-    globus_gfs_transfer_info_t *        recv_info;
-    globus_gfs_acl_object_desc_t        object;
-
-    GlobusGFSName(globus_l_gfs_data_trev_kickout);
+    globus_l_gfs_data_operation_t *     op;
+    globus_l_gfs_data_bounce_t *        bounce_info;
+    globus_abstime_t                    now;
+    globus_reltime_t                    delay;
+    GlobusGFSName(globus_l_gfs_data_qos_drain);
     GlobusGFSDebugEnter();
 
-    bounce_info = (globus_l_gfs_data_trev_bounce_t *) user_arg;
-    event_reply = (globus_gfs_event_info_t *)
-        globus_calloc(1, sizeof(globus_gfs_event_info_t));
+    op = (globus_l_gfs_data_operation_t *) user_arg;
 
-    event_reply->id = bounce_info->op->id;
-    event_reply->node_ndx = bounce_info->op->node_ndx;
-    globus_mutex_lock(&bounce_info->op->session_handle->mutex);
+    globus_mutex_lock(&op->session_handle->mutex);
+    while(op->qos_draining)
     {
-        switch(bounce_info->op->state)
+        if(globus_fifo_empty(&op->qos_q))
         {
-            case GLOBUS_L_GFS_DATA_CONNECTING:
-            case GLOBUS_L_GFS_DATA_CONNECTED:
-            case GLOBUS_L_GFS_DATA_ABORTING:
-            case GLOBUS_L_GFS_DATA_ABORT_CLOSING:
-                pass = GLOBUS_TRUE;
-                break;
-
-            case GLOBUS_L_GFS_DATA_FINISH:
-            case GLOBUS_L_GFS_DATA_FINISH_WITH_ERROR:
-                pass = GLOBUS_FALSE;
-                break;
-
-            case GLOBUS_L_GFS_DATA_COMPLETING:
-            case GLOBUS_L_GFS_DATA_COMPLETE:
-            case GLOBUS_L_GFS_DATA_REQUESTING:
-            default:
-                globus_assert(0 && "possibly memory corruption");
-                break;
+            op->qos_draining = GLOBUS_FALSE;
+            break;
         }
-        if(pass)
+        bounce_info = (globus_l_gfs_data_bounce_t *)
+            globus_fifo_peek(&op->qos_q);
+        GlobusTimeAbstimeGetCurrent(now);
+        if(globus_abstime_cmp(&bounce_info->deadline, &now) > 0)
         {
-            switch(bounce_info->event_type)
-            {
-                case GLOBUS_GFS_EVENT_BYTES_RECVD:
-                    event_reply->recvd_bytes = bounce_info->op->recvd_bytes;
-                    bounce_info->op->recvd_bytes = 0;
-                    event_reply->type = GLOBUS_GFS_EVENT_BYTES_RECVD;
-                    break;
-    
-                case GLOBUS_GFS_EVENT_RANGES_RECVD:
-                    event_reply->type = GLOBUS_GFS_EVENT_RANGES_RECVD;
-                    globus_range_list_copy(
-                        &event_reply->recvd_ranges,
-                        bounce_info->op->recvd_ranges);
-                    globus_range_list_remove(
-                        bounce_info->op->recvd_ranges, 0, GLOBUS_RANGE_LIST_MAX);
-                    break;
-    
+            GlobusTimeAbstimeDiff(delay, bounce_info->deadline, now);
+            globus_callback_register_oneshot(
+                NULL,
+                &delay,
+                globus_l_gfs_data_qos_drain,
+                op);
+            break;
+        }
+        globus_fifo_dequeue(&op->qos_q);
+
+        /* still draining, so anything completing meanwhile queues behind */
+        globus_mutex_unlock(&op->session_handle->mutex);
+        bounce_info->kickout(bounce_info);
+        globus_mutex_lock(&op->session_handle->mutex);
+    }
+    globus_mutex_unlock(&op->session_handle->mutex);
+
+    GlobusGFSDebugExit();
+}
+
+/* hand the data back to the DSI now, or once qos allows it more.  held
+ * callbacks keep their order so an eof is never seen before the data
+ * ahead of it.  oneshot never calls back from this stack. */
+static
+void
+globus_l_gfs_data_qos_kickout(
+    globus_l_gfs_data_bounce_t *        bounce_info,
+    globus_callback_func_t              kickout,
+    globus_bool_t                       oneshot)
+{
+    globus_l_gfs_data_operation_t *     op;
+    globus_reltime_t                    delay;
+    globus_bool_t                       held = GLOBUS_FALSE;
+
+    op = bounce_info->op;
+    if(op->qos != NULL)
+    {
+        globus_mutex_lock(&op->session_handle->mutex);
+        {
+            if(kickout == globus_l_gfs_data_read_kickout && bounce_info->eof)
+            {
+                op->qos_eof = GLOBUS_TRUE;
+                op->qos_eof_offset = bounce_info->offset;
+            }
+            GlobusTimeReltimeSet(delay, 0, 0);
+            if(globus_i_gfs_qos_charge(
+                    op->qos, bounce_info->length, 0, &delay) ||
+                op->qos_draining || oneshot)
+            {
+                GlobusTimeAbstimeGetCurrent(bounce_info->deadline);
+                GlobusTimeAbstimeInc(bounce_info->deadline, delay);
+                bounce_info->kickout = kickout;
+                globus_fifo_enqueue(&op->qos_q, bounce_info);
+                if(!op->qos_draining)
+                {
+                    op->qos_draining = GLOBUS_TRUE;
+                    globus_callback_register_oneshot(
+                        NULL,
+                        &delay,
+                        globus_l_gfs_data_qos_drain,
+                        op);
+                }
+                held = GLOBUS_TRUE;
+            }
+        }
+        globus_mutex_unlock(&op->session_handle->mutex);
+    }
+    if(!held)
+    {
+        kickout(bounce_info);
+    }
+}
+
+static
+void
+globus_l_gfs_data_write_cb(
+    void *                              user_arg,
+    globus_ftp_control_handle_t *       handle,
+    globus_object_t *                   error,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset,
+    globus_bool_t                       eof)
+{
+    globus_l_gfs_data_bounce_t *        bounce_info;
+    GlobusGFSName(globus_l_gfs_data_write_cb);
+    GlobusGFSDebugEnter();
+
+    bounce_info = (globus_l_gfs_data_bounce_t *) user_arg;
+    globus_l_gfs_data_alive(bounce_info->op->session_handle);
+
+    bounce_info->op->bytes_transferred += length;
+    bounce_info->op->recvd_bytes += length;
+
+    bounce_info->result =
+        error ? globus_error_put(globus_object_copy(error)) : GLOBUS_SUCCESS;
+    bounce_info->buffer = buffer;
+    bounce_info->length = length;
+    globus_l_gfs_data_qos_kickout(
+        bounce_info, globus_l_gfs_data_write_kickout, GLOBUS_FALSE);
+
+    GlobusGFSDebugExit();
+}
+
+static
+void
+globus_l_gfs_data_read_cb(
+    void *                              user_arg,
+    globus_ftp_control_handle_t *       handle,
+    globus_object_t *                   error,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset,
+    globus_bool_t                       eof)
+{
+    globus_l_gfs_data_bounce_t *        bounce_info;
+    GlobusGFSName(globus_l_gfs_data_read_cb);
+    GlobusGFSDebugEnter();
+
+    bounce_info = (globus_l_gfs_data_bounce_t *) user_arg;
+    globus_l_gfs_data_alive(bounce_info->op->session_handle);
+
+    bounce_info->op->bytes_transferred += length;
+
+    bounce_info->result =
+        error ? globus_error_put(globus_object_copy(error)) : GLOBUS_SUCCESS;
+    bounce_info->buffer = buffer;
+    bounce_info->length = length;
+    bounce_info->offset = offset + bounce_info->op->write_delta;
+    bounce_info->eof = eof;
+    globus_l_gfs_data_qos_kickout(
+        bounce_info, globus_l_gfs_data_read_kickout, GLOBUS_FALSE);
+
+    GlobusGFSDebugExit();
+}
+
+static
+void
+globus_l_gfs_data_trev_kickout(
+    void *                              user_arg)
+{
+    globus_l_gfs_data_trev_bounce_t *   bounce_info;
+    globus_gfs_event_info_t *           event_reply;
+    void *                              remote_data_arg = NULL;
+    globus_bool_t                       pass = GLOBUS_FALSE;
+    globus_bool_t                       destroy_session = GLOBUS_FALSE;
+    globus_bool_t                       destroy_op = GLOBUS_FALSE;
+    globus_gfs_event_info_t             event_info;
+
+    globus_gfs_acl_action_t             action;
+    int                                 rc;
+    globus_result_t                     res;
+    globus_gfs_transfer_info_t *        recv_info;
+    globus_gfs_acl_object_desc_t        object;
+
+    GlobusGFSName(globus_l_gfs_data_trev_kickout);
+    GlobusGFSDebugEnter();
+
+    bounce_info = (globus_l_gfs_data_trev_bounce_t *) user_arg;
+    event_reply = (globus_gfs_event_info_t *)
+        globus_calloc(1, sizeof(globus_gfs_event_info_t));
+
+    event_reply->id = bounce_info->op->id;
+    event_reply->node_ndx = bounce_info->op->node_ndx;
+    globus_mutex_lock(&bounce_info->op->session_handle->mutex);
+    {
+        switch(bounce_info->op->state)
+        {
+            case GLOBUS_L_GFS_DATA_CONNECTING:
+            case GLOBUS_L_GFS_DATA_CONNECTED:
+            case GLOBUS_L_GFS_DATA_ABORTING:
+            case GLOBUS_L_GFS_DATA_ABORT_CLOSING:
+                pass = GLOBUS_TRUE;
+                break;
+
+            case GLOBUS_L_GFS_DATA_FINISH:
+            case GLOBUS_L_GFS_DATA_FINISH_WITH_ERROR:
+                pass = GLOBUS_FALSE;
+                break;
+
+            case GLOBUS_L_GFS_DATA_COMPLETING:
+            case GLOBUS_L_GFS_DATA_COMPLETE:
+            case GLOBUS_L_GFS_DATA_REQUESTING:
+            default:
+                globus_assert(0 && "possibly memory corruption");
+                break;
+        }
+        if(pass)
+        {
+            switch(bounce_info->event_type)
+            {
+                case GLOBUS_GFS_EVENT_BYTES_RECVD:
+                    event_reply->recvd_bytes = bounce_info->op->recvd_bytes;
+                    bounce_info->op->recvd_bytes = 0;
+                    event_reply->type = GLOBUS_GFS_EVENT_BYTES_RECVD;
+                    break;
+    
+                case GLOBUS_GFS_EVENT_RANGES_RECVD:
+                    event_reply->type = GLOBUS_GFS_EVENT_RANGES_RECVD;
+                    globus_range_list_copy(
+                        &event_reply->recvd_ranges,
+                        bounce_info->op->recvd_ranges);
+                    globus_range_list_remove(
+                        bounce_info->op->recvd_ranges, 0, GLOBUS_RANGE_LIST_MAX);
+                    break;
+    
                 default:
                     globus_assert(0 && "invalid state, not possible");
                     break;
@@ -11207,6 +11545,24 @@ globus_l_gfs_data_trev_kickout(
 
     if(pass)
     {
+        if(event_reply->type == GLOBUS_GFS_EVENT_BYTES_RECVD &&
+            globus_i_gfs_event_stream_enabled())
+        {
+            globus_i_gfs_event_record_t record;
+
+            globus_i_gfs_event_stream_start(
+                &record, GLOBUS_I_GFS_EVENT_PERF,
+                bounce_info->op->session_handle->event_id,
+                bounce_info->op->event_id);
+            globus_i_gfs_event_stream_add_int(
+                &record, GLOBUS_I_GFS_EVENT_TAG_STRIPE,
+                event_reply->node_ndx);
+            globus_i_gfs_event_stream_add_int(
+                &record, GLOBUS_I_GFS_EVENT_TAG_BYTES,
+                event_reply->recvd_bytes);
+            globus_i_gfs_event_stream_send(&record);
+        }
+
         if(bounce_info->op->event_callback != NULL)
         {
             bounce_info->op->event_callback(
@@ -11666,6 +12022,7 @@ globus_i_gfs_data_session_start(
     session_handle->dcsc_cred = GSS_C_NO_CREDENTIAL;
     session_handle->order_data = session_handle->dsi->descriptor & 
         GLOBUS_GFS_DSI_DESCRIPTOR_REQUIRES_ORDERED_DATA;
+    session_handle->event_id = globus_i_gfs_event_stream_next_id();
     result = globus_l_gfs_data_operation_init(&op, session_handle);
     if(result != GLOBUS_SUCCESS)
     {
@@ -11836,6 +12193,9 @@ globus_i_gfs_data_session_stop(
     session_handle = (globus_l_gfs_data_session_t *) session_arg;
     if(session_handle != NULL)
     {
+        globus_l_gfs_data_event_stream_session(
+            session_handle, GLOBUS_I_GFS_EVENT_SESSION_END);
+
         while(waitcnt < maxwait && !free_session)
         {
             globus_mutex_lock(&session_handle->mutex);
@@ -12463,6 +12823,9 @@ globus_gridftp_server_begin_transfer(
     op->event_mask = event_mask;
     op->event_arg = event_arg;
 
+    globus_l_gfs_data_event_stream_transfer(
+        op, GLOBUS_I_GFS_EVENT_TRANSFER_BEGIN);
+
     /* increase refrence count for the events.  This gets decreased when
         the COMPLETE event occurs.  it is safe to increment outside of a
         lock because until we enable events there should be no
@@ -13198,7 +13561,9 @@ globus_gridftp_server_get_optimal_concurrency(
 
     if(op->data_handle->http_handle)
     {
-        *count = 1;
+        /* one read per range connection */
+        *count = op->data_handle->http_range_count > 1 ?
+            op->data_handle->http_range_count : 1;
         return;
     }
     if(!op->writing)
@@ -13899,6 +14264,7 @@ globus_gridftp_server_register_read(
 {
     globus_result_t                     result;
     globus_l_gfs_data_bounce_t *        bounce_info;
+    globus_bool_t                       eof;
     GlobusGFSName(globus_gridftp_server_register_read);
     GlobusGFSDebugEnter();
 
@@ -13915,8 +14281,39 @@ globus_gridftp_server_register_read(
     bounce_info->callback.read = callback;
     bounce_info->user_arg = user_arg;
 
-    if(op->data_handle->http_handle)
+    if(op->qos != NULL)
     {
+        globus_mutex_lock(&op->session_handle->mutex);
+        {
+            eof = op->qos_eof;
+        }
+        globus_mutex_unlock(&op->session_handle->mutex);
+        if(eof)
+        {
+            /* the data channel already finished while the DSI was held
+                back, answer the way it would have */
+            bounce_info->result = GLOBUS_SUCCESS;
+            bounce_info->buffer = buffer;
+            bounce_info->length = 0;
+            bounce_info->offset = op->qos_eof_offset;
+            bounce_info->eof = GLOBUS_TRUE;
+            globus_l_gfs_data_qos_kickout(
+                bounce_info, globus_l_gfs_data_read_kickout, GLOBUS_TRUE);
+
+            GlobusGFSDebugExit();
+            return GLOBUS_SUCCESS;
+        }
+    }
+
+    if(op->data_handle->http_range_count > 1)
+    {
+        bounce_info->buffer = buffer;
+        bounce_info->length = length;
+        globus_l_gfs_data_http_range_read(op, bounce_info);
+    }
+    else if(op->data_handle->http_handle)
+    {
+        bounce_info->http_range = 0;
         result = globus_xio_register_read(
             op->data_handle->http_handle,
             buffer,
@@ -14254,6 +14651,174 @@ globus_i_gfs_data_request_buffer_send(
 
 
 
+/* hands the read to a range that has data left and no read outstanding.
+ * if there is none it waits in http_pending_reads for one, or gets eof
+ * once every range is finished */
+static
+void
+globus_l_gfs_data_http_range_read(
+    globus_l_gfs_data_operation_t *     op,
+    globus_l_gfs_data_bounce_t *        bounce_info)
+{
+    globus_l_gfs_data_handle_t *        data_handle;
+    globus_l_gfs_data_http_range_t *    range;
+    globus_result_t                     result;
+    globus_bool_t                       done = GLOBUS_TRUE;
+    int                                 i;
+    GlobusGFSName(globus_l_gfs_data_http_range_read);
+    GlobusGFSDebugEnter();
+
+    data_handle = op->data_handle;
+    bounce_info->http_range = -1;
+    globus_mutex_lock(&op->session_handle->mutex);
+    {
+        for(i = 0; i < data_handle->http_range_count; i++)
+        {
+            range = &data_handle->http_ranges[i];
+            if(range->busy)
+            {
+                done = GLOBUS_FALSE;
+            }
+            else if(!range->eof && bounce_info->http_range < 0)
+            {
+                bounce_info->http_range = i;
+                range->busy = GLOBUS_TRUE;
+                done = GLOBUS_FALSE;
+            }
+        }
+        if(bounce_info->http_range < 0 && !done)
+        {
+            globus_fifo_enqueue(
+                &data_handle->http_pending_reads, bounce_info);
+        }
+    }
+    globus_mutex_unlock(&op->session_handle->mutex);
+
+    if(bounce_info->http_range >= 0)
+    {
+        range = &data_handle->http_ranges[bounce_info->http_range];
+        result = globus_xio_register_read(
+            range->handle,
+            bounce_info->buffer,
+            bounce_info->length,
+            bounce_info->length,
+            NULL,
+            globus_i_gfs_data_http_read_cb,
+            bounce_info);
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_mutex_lock(&op->session_handle->mutex);
+            {
+                range->busy = GLOBUS_FALSE;
+                range->eof = GLOBUS_TRUE;
+            }
+            globus_mutex_unlock(&op->session_handle->mutex);
+
+            bounce_info->result = GlobusGFSErrorWrapFailed(
+                "globus_xio_register_read", result);
+            bounce_info->length = 0;
+            bounce_info->offset = range->offset + op->write_delta;
+            bounce_info->eof = GLOBUS_FALSE;
+            globus_l_gfs_data_qos_kickout(
+                bounce_info, globus_l_gfs_data_read_kickout, GLOBUS_TRUE);
+        }
+    }
+    else if(done)
+    {
+        bounce_info->result = GLOBUS_SUCCESS;
+        bounce_info->length = 0;
+        bounce_info->offset = data_handle->http_length + op->write_delta;
+        bounce_info->eof = GLOBUS_TRUE;
+        globus_l_gfs_data_qos_kickout(
+            bounce_info, globus_l_gfs_data_read_kickout, GLOBUS_TRUE);
+    }
+
+    GlobusGFSDebugExit();
+}
+
+static
+void
+globus_l_gfs_data_http_range_read_cb(
+    globus_l_gfs_data_bounce_t *        bounce_info,
+    globus_result_t                     result,
+    globus_size_t                       nbytes)
+{
+    globus_l_gfs_data_operation_t *     op;
+    globus_l_gfs_data_handle_t *        data_handle;
+    globus_l_gfs_data_http_range_t *    range;
+    globus_off_t                        offset;
+    globus_bool_t                       eof;
+    globus_fifo_t                       pending;
+    int                                 i;
+    GlobusGFSName(globus_l_gfs_data_http_range_read_cb);
+    GlobusGFSDebugEnter();
+
+    op = bounce_info->op;
+    data_handle = op->data_handle;
+    globus_mutex_lock(&op->session_handle->mutex);
+    {
+        range = &data_handle->http_ranges[bounce_info->http_range];
+        offset = range->offset;
+        range->offset += nbytes;
+        range->busy = GLOBUS_FALSE;
+        op->bytes_transferred += nbytes;
+
+        if(globus_xio_error_is_eof(result))
+        {
+            if(range->offset < range->end)
+            {
+                result = GlobusGFSErrorGeneric(
+                    "HTTP data length was shorter than expected.");
+            }
+            else
+            {
+                result = GLOBUS_SUCCESS;
+            }
+            range->eof = GLOBUS_TRUE;
+        }
+        if(range->offset > range->end)
+        {
+            result = GlobusGFSErrorGeneric(
+                "HTTP data length was longer than expected.");
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            range->eof = GLOBUS_TRUE;
+        }
+
+        /* the DSI sees eof once, after every range has it */
+        eof = GLOBUS_TRUE;
+        for(i = 0; i < data_handle->http_range_count; i++)
+        {
+            if(data_handle->http_ranges[i].busy ||
+                !data_handle->http_ranges[i].eof)
+            {
+                eof = GLOBUS_FALSE;
+            }
+        }
+
+        /* this range is free again, or everything is done.  waiting reads
+         * are retried, those that still find no range go back in line */
+        globus_fifo_move(&pending, &data_handle->http_pending_reads);
+    }
+    globus_mutex_unlock(&op->session_handle->mutex);
+
+    while(!globus_fifo_empty(&pending))
+    {
+        globus_l_gfs_data_http_range_read(op, globus_fifo_dequeue(&pending));
+    }
+    globus_fifo_destroy(&pending);
+
+    bounce_info->result = result;
+    bounce_info->length = nbytes;
+    bounce_info->offset = offset + op->write_delta;
+    bounce_info->eof = eof;
+    globus_l_gfs_data_qos_kickout(
+        bounce_info, globus_l_gfs_data_read_kickout, GLOBUS_FALSE);
+
+    GlobusGFSDebugExit();
+}
+
 void
 globus_i_gfs_data_http_read_cb(
     globus_xio_handle_t                 xio_handle, 
@@ -14271,6 +14836,13 @@ globus_i_gfs_data_http_read_cb(
     GlobusGFSDebugEnter();
     bounce_info = (globus_l_gfs_data_bounce_t *) user_arg;
 
+    if(bounce_info->op->data_handle->http_range_count > 1)
+    {
+        globus_l_gfs_data_http_range_read_cb(bounce_info, result, nbytes);
+        GlobusGFSDebugExit();
+        return;
+    }
+
     offset = bounce_info->op->bytes_transferred;
     bounce_info->op->bytes_transferred += nbytes;
     
@@ -14295,16 +14867,13 @@ globus_i_gfs_data_http_read_cb(
             "HTTP data length was longer than expected.");
     }
 
-    bounce_info->callback.read(
-        bounce_info->op,
-        result,
-        buffer,
-        nbytes,
-        offset + bounce_info->op->write_delta,
-        eof,
-        bounce_info->user_arg);
-
-    globus_free(bounce_info);
+    bounce_info->result = result;
+    bounce_info->buffer = buffer;
+    bounce_info->length = nbytes;
+    bounce_info->offset = offset + bounce_info->op->write_delta;
+    bounce_info->eof = eof;
+    globus_l_gfs_data_qos_kickout(
+        bounce_info, globus_l_gfs_data_read_kickout, GLOBUS_FALSE);
 
     GlobusGFSDebugExit();
 }
@@ -14333,14 +14902,11 @@ globus_i_gfs_data_http_write_cb(
     }
     globus_mutex_unlock(&bounce_info->op->session_handle->mutex);
 
-    bounce_info->callback.write(
-        bounce_info->op,
-        result,
-        buffer,
-        nbytes,
-        bounce_info->user_arg);
-
-    globus_free(bounce_info);
+    bounce_info->result = result;
+    bounce_info->buffer = buffer;
+    bounce_info->length = nbytes;
+    globus_l_gfs_data_qos_kickout(
+        bounce_info, globus_l_gfs_data_write_kickout, GLOBUS_FALSE);
 
     GlobusGFSDebugExit();
 }
@@ -14399,6 +14965,19 @@ globus_l_gfs_data_http_transfer_cb(
         op->data_handle->perf_handle = GLOBUS_NULL_HANDLE;
     }
     
+    if(op->data_handle->http_ranges)
+    {
+        int                             i;
+
+        for(i = 1; i < op->data_handle->http_range_count; i++)
+        {
+            globus_xio_close(op->data_handle->http_ranges[i].handle, NULL);
+        }
+        globus_free(op->data_handle->http_ranges);
+        op->data_handle->http_ranges = NULL;
+        op->data_handle->http_range_count = 0;
+        globus_fifo_destroy(&op->data_handle->http_pending_reads);
+    }
     globus_xio_close(op->data_handle->http_handle, NULL);
     globus_libc_unsetenv("GLOBUS_GFS_EXTRA_CA_CERTS");
 
@@ -14904,6 +15483,255 @@ err:
 }
 
 
+/* a download is only split while each range gets at least this much */
+#define GLOBUS_L_GFS_HTTP_MIN_RANGE (1024 * 1024)
+#define GLOBUS_L_GFS_HTTP_MAX_STREAMS 64
+
+/* a 206 response must carry exactly the bytes start to end - 1 of a
+ * resource of the given length, anything else would be stored at the
+ * wrong offsets */
+static
+globus_result_t
+globus_l_gfs_data_http_check_range(
+    globus_hashtable_t *                header_table,
+    globus_off_t                        start,
+    globus_off_t                        end,
+    globus_off_t                        length)
+{
+    globus_result_t                     result;
+    globus_xio_http_header_t *          header;
+    char *                              value = NULL;
+    char *                              ptr;
+    globus_off_t                        range[3];
+    int                                 consumed;
+    int                                 i;
+    GlobusGFSName(globus_l_gfs_data_http_check_range);
+    GlobusGFSDebugEnter();
+
+    /* header names are stored as the server sent them */
+    for(header = globus_hashtable_first(header_table);
+        header != NULL;
+        header = globus_hashtable_next(header_table))
+    {
+        if(strcasecmp(header->name, "Content-Range") == 0)
+        {
+            value = header->value;
+        }
+    }
+    if(value == NULL)
+    {
+        GlobusGFSErrorGenericStr(result,
+            ("HTTP range response for bytes %"GLOBUS_OFF_T_FORMAT
+            "-%"GLOBUS_OFF_T_FORMAT" has no Content-Range",
+            start, end - 1));
+        goto error;
+    }
+
+    /* bytes start-last/length */
+    ptr = value;
+    if(strncasecmp(ptr, "bytes", 5) != 0 || !isspace(ptr[5]))
+    {
+        goto error_range;
+    }
+    for(ptr += 5; isspace(*ptr); ptr++);
+    for(i = 0; i < 3; i++)
+    {
+        if(!isdigit(*ptr) ||
+            globus_libc_scan_off_t(ptr, &range[i], &consumed) != 1)
+        {
+            goto error_range;
+        }
+        ptr += consumed;
+        if(i < 2 && *ptr++ != "-/"[i])
+        {
+            goto error_range;
+        }
+    }
+    for(; isspace(*ptr); ptr++);
+    if(*ptr != '\0' ||
+        range[0] != start || range[1] != end - 1 || range[2] != length)
+    {
+        goto error_range;
+    }
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_range:
+    GlobusGFSErrorGenericStr(result,
+        ("HTTP range response has \"Content-Range: %s\", expected "
+        "\"bytes %"GLOBUS_OFF_T_FORMAT"-%"GLOBUS_OFF_T_FORMAT
+        "/%"GLOBUS_OFF_T_FORMAT"\"",
+        value, start, end - 1, length));
+error:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+/* opens one more connection for bytes start to end - 1 of a download.
+ * with HTTP/1.1 the xio http driver hands back a connection cached by an
+ * earlier request to the same server when it has one */
+static
+globus_result_t
+globus_l_gfs_data_http_open_range(
+    globus_l_gfs_data_operation_t *     op,
+    char *                              url,
+    globus_bool_t                       https,
+    int                                 http_ver,
+    char *                              method,
+    globus_xio_http_header_t *          headers,
+    int                                 count,
+    globus_off_t                        start,
+    globus_off_t                        end,
+    globus_off_t                        length,
+    globus_bool_t                       do_retry,
+    globus_xio_handle_t *               out_handle)
+{
+    globus_result_t                     result;
+    globus_xio_handle_t                 handle = NULL;
+    globus_xio_attr_t                   attr;
+    globus_xio_data_descriptor_t        descriptor;
+    globus_byte_t                       buffer[1];
+    globus_hashtable_t                  header_table = NULL;
+    int                                 status_code;
+    char *                              reason_phrase;
+    char                                range_str[64];
+    int                                 i;
+    GlobusGFSName(globus_l_gfs_data_http_open_range);
+    GlobusGFSDebugEnter();
+
+    result = globus_i_gfs_data_http_init(op->session_handle,
+        https, &handle, &attr, &descriptor);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+
+    result = globus_xio_attr_cntl(
+        attr,
+        op->session_handle->http_driver,
+        GLOBUS_XIO_HTTP_ATTR_SET_REQUEST_HTTP_VERSION,
+        http_ver);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_attr;
+    }
+    result = globus_xio_attr_cntl(
+        attr,
+        op->session_handle->http_driver,
+        GLOBUS_XIO_HTTP_ATTR_SET_REQUEST_METHOD,
+        method);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_attr;
+    }
+    for(i = 0; i < count; i++)
+    {
+        result = globus_xio_attr_cntl(
+            attr,
+            op->session_handle->http_driver,
+            GLOBUS_XIO_HTTP_ATTR_SET_REQUEST_HEADER,
+            headers[i].name,
+            headers[i].value);
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto error_attr;
+        }
+    }
+    sprintf(range_str, "bytes=%"GLOBUS_OFF_T_FORMAT"-%"GLOBUS_OFF_T_FORMAT,
+        start, end - 1);
+    result = globus_xio_attr_cntl(
+        attr,
+        op->session_handle->http_driver,
+        GLOBUS_XIO_HTTP_ATTR_SET_REQUEST_HEADER,
+        "Range",
+        range_str);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_attr;
+    }
+
+    result = globus_xio_open(handle, url, attr);
+    globus_xio_attr_destroy(attr);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_xio_data_descriptor_destroy(descriptor);
+        /* a cached connection the server has since closed */
+        if(do_retry && globus_error_get_type(globus_error_peek(result)) ==
+            GLOBUS_XIO_HTTP_ERROR_PERSISTENT_CONNECTION_DROPPED)
+        {
+            return globus_l_gfs_data_http_open_range(
+                op, url, https, http_ver, method, headers, count,
+                start, end, length, GLOBUS_FALSE, out_handle);
+        }
+        result = GlobusGFSErrorWrapFailed("HTTP connection", result);
+        goto error;
+    }
+
+    /* read response, no data */
+    result = globus_xio_read(handle, buffer, 0, 0, NULL, descriptor);
+    if(result != GLOBUS_SUCCESS && globus_xio_error_is_eof(result))
+    {
+        if(do_retry && globus_error_get_type(globus_error_peek(result)) ==
+            GLOBUS_XIO_HTTP_ERROR_PERSISTENT_CONNECTION_DROPPED)
+        {
+            globus_xio_data_descriptor_destroy(descriptor);
+            globus_xio_close(handle, NULL);
+            return globus_l_gfs_data_http_open_range(
+                op, url, https, http_ver, method, headers, count,
+                start, end, length, GLOBUS_FALSE, out_handle);
+        }
+        result = GLOBUS_SUCCESS;
+    }
+    /* the response belongs to the descriptor, it is kept until checked */
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_data_descriptor_cntl(
+            descriptor,
+            op->session_handle->http_driver,
+            GLOBUS_XIO_HTTP_GET_RESPONSE,
+            &status_code,
+            &reason_phrase,
+            NULL,
+            &header_table);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed("HTTP range request", result);
+        goto error_response;
+    }
+    if(status_code != 206)
+    {
+        GlobusGFSErrorGenericStr(result,
+            ("HTTP range request for %s failed with \"%03d %s\"",
+            range_str, status_code, reason_phrase));
+        goto error_response;
+    }
+    result = globus_l_gfs_data_http_check_range(
+        &header_table, start, end, length);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_response;
+    }
+    globus_xio_data_descriptor_destroy(descriptor);
+
+    *out_handle = handle;
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_response:
+    globus_xio_data_descriptor_destroy(descriptor);
+    globus_xio_close(handle, NULL);
+    goto error;
+error_attr:
+    globus_xio_attr_destroy(attr);
+    globus_xio_data_descriptor_destroy(descriptor);
+error:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
 globus_result_t 
 globus_i_gfs_data_http_get(
     globus_l_gfs_data_operation_t *     op,
@@ -14911,6 +15739,7 @@ globus_i_gfs_data_http_get(
     char *                              request,
     globus_off_t                        offset,
     globus_off_t                        length,
+    int                                 streams,
     globus_bool_t                       do_retry)
 {
     globus_result_t                     result = GLOBUS_SUCCESS;
@@ -14935,6 +15764,9 @@ globus_i_gfs_data_http_get(
     globus_bool_t                       eof;
     globus_bool_t                       retry = GLOBUS_FALSE;
     char *                              ptr;
+    globus_off_t                        range_size = 0;
+    globus_l_gfs_data_http_range_t *    ranges = NULL;
+    char                                range_str[64];
     GlobusGFSName(globus_l_gfs_data_http_get);
     GlobusGFSDebugEnter();
     
@@ -14990,6 +15822,41 @@ globus_i_gfs_data_http_get(
         }
     }
 
+    /* a large plain GET is split into ranges.  the first is asked for on
+     * this connection, the others are opened once its answer shows the
+     * server supports ranges */
+    if(streams > 1 && strcasecmp(method, "GET") == 0)
+    {
+        streams = GLOBUS_MIN(streams, GLOBUS_L_GFS_HTTP_MAX_STREAMS);
+        if(length / streams < GLOBUS_L_GFS_HTTP_MIN_RANGE)
+        {
+            streams = length / GLOBUS_L_GFS_HTTP_MIN_RANGE;
+        }
+        for(i = 0; i < count; i++)
+        {
+            if(strcasecmp(headers[i].name, "Range") == 0)
+            {
+                streams = 1;
+            }
+        }
+        if(streams > 1)
+        {
+            range_size = length / streams;
+            sprintf(range_str, "bytes=0-%"GLOBUS_OFF_T_FORMAT,
+                range_size - 1);
+            result = globus_xio_attr_cntl(
+                attr,
+                op->session_handle->http_driver,
+                GLOBUS_XIO_HTTP_ATTR_SET_REQUEST_HEADER,
+                "Range",
+                range_str);
+            if(result != GLOBUS_SUCCESS)
+            {
+                goto response_exit;
+            }
+        }
+    }
+
     result = globus_xio_open(handle, url, attr);
     if(result != GLOBUS_SUCCESS)
     {
@@ -15019,7 +15886,7 @@ globus_i_gfs_data_http_get(
         }
 
         return globus_i_gfs_data_http_get(
-            op, path, request, offset, length, GLOBUS_FALSE);
+            op, path, request, offset, length, streams, GLOBUS_FALSE);
     }
 
     result = globus_xio_handle_cntl(
@@ -15069,7 +15936,7 @@ globus_i_gfs_data_http_get(
         }
 
         return globus_i_gfs_data_http_get(
-            op, path, request, offset, length, GLOBUS_FALSE);
+            op, path, request, offset, length, streams, GLOBUS_FALSE);
     }
     
     if(result != GLOBUS_SUCCESS)
@@ -15152,8 +16019,49 @@ globus_i_gfs_data_http_get(
 
         goto open_exit;
     }
+    else if(range_size > 0 && status_code == 206)
+    {
+        result = globus_l_gfs_data_http_check_range(
+            &header_table, 0, range_size, length);
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto open_exit;
+        }
+        ranges = (globus_l_gfs_data_http_range_t *) globus_calloc(
+            streams, sizeof(globus_l_gfs_data_http_range_t));
+        for(i = 0; i < streams; i++)
+        {
+            ranges[i].offset = i * range_size;
+            ranges[i].end = (i == streams - 1) ? length : (i + 1) * range_size;
+        }
+        ranges[0].handle = handle;
+        for(i = 1; i < streams && result == GLOBUS_SUCCESS; i++)
+        {
+            result = globus_l_gfs_data_http_open_range(
+                op, url, https, http_ver, method, headers, count,
+                ranges[i].offset, ranges[i].end, length, GLOBUS_TRUE,
+                &ranges[i].handle);
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            for(i = 1; i < streams; i++)
+            {
+                if(ranges[i].handle)
+                {
+                    globus_xio_close(ranges[i].handle, NULL);
+                }
+            }
+            globus_free(ranges);
+            goto open_exit;
+        }
+
+        /* the client asked for the whole file and gets it */
+        globus_i_gfs_data_http_print_response(
+            200, &header_table, NULL, &op->user_msg);
+    }
     else
     {
+        /* a 200 to a range request is the whole body on this connection */
         globus_i_gfs_data_http_print_response(
             status_code, &header_table, NULL, &op->user_msg);
     }        
@@ -15193,6 +16101,13 @@ globus_i_gfs_data_http_get(
     data_handle->http_handle = handle;
     data_handle->http_length = length;
     data_handle->http_ip = globus_libc_strdup(op->http_ip);
+    if(ranges)
+    {
+        data_handle->info.nstreams = streams;
+        data_handle->http_ranges = ranges;
+        data_handle->http_range_count = streams;
+        globus_fifo_init(&data_handle->http_pending_reads);
+    }
     op->data_handle = data_handle;
 
     op->ref++;
@@ -24,6 +24,13 @@
 #define GFS_DB_REPO_NAME        "default"
 #define STATIC_TIMEOUT          10
 
+/* weights of the load vector reported by the data nodes.  a session is
+    the unit, so a node whose run queue is a full cpu deep costs as much
+    as GFS_DB_CPU_WEIGHT extra sessions */
+#define GFS_DB_CONN_WEIGHT      1.0
+#define GFS_DB_CPU_WEIGHT       4.0
+#define GFS_DB_MEM_WEIGHT       4.0
+
 typedef enum gfs_l_db_node_type_e
 {
     GFS_DB_NODE_TYPE_STATIC = 1,
@@ -46,6 +53,10 @@ typedef struct gfs_l_db_node_s
     globus_bool_t                       error;
     char *                              cookie_id;
     struct gfs_l_db_repo_s *            repo;
+    /* last load vector reported by the node, see gfs_i_gfork_plugin.h */
+    int                                 reported_connections;
+    int                                 cpu_load;
+    int                                 mem_load;
 } gfs_l_db_node_t;
 
 typedef struct gfs_l_db_repo_s
@@ -65,6 +76,23 @@ static globus_callback_func_t           globus_l_gfs_gfork_ready_cb = NULL;
 static void *                           globus_l_gfs_gfork_ready_cb_arg;
 static globus_bool_t                    globus_l_gfs_gfork_on = GLOBUS_FALSE;
 
+/* weighted least loaded.  the connections this process handed out count
+    right away, the rest of the vector is only as fresh as the last report.
+    static nodes never report, so for them this is just the connection
+    count as before */
+static
+void
+gfs_l_db_node_score(
+    gfs_l_db_node_t *                   node)
+{
+    float                               conn;
+
+    conn = node->current_connection + node->reported_connections;
+    node->load = GFS_DB_CONN_WEIGHT * conn +
+        GFS_DB_CPU_WEIGHT * node->cpu_load / 100.0 +
+        GFS_DB_MEM_WEIGHT * node->mem_load / 100.0;
+}
+
 static
 int
 gfs_l_db_node_cmp(
@@ -93,7 +121,15 @@ gfs_l_db_node_cmp(
     {
         return -1;
     }
-    if(n1->current_connection < n2->current_connection)
+    if(n1->load < n2->load)
+    {
+        return -1;
+    }
+    else if(n1->load > n2->load)
+    {
+        return 1;
+    }
+    else if(n1->current_connection < n2->current_connection)
     {
         return -1;
     }
@@ -200,6 +236,10 @@ globus_l_gfs_gfork_dyn_reg(
     gfs_l_db_repo_t *                   repo = NULL;
     int                                 con_max;
     int                                 total_max;
+    int                                 load_conn;
+    int                                 load_cpu;
+    int                                 load_mem;
+    void *                              tmp_ptr;
     char                                repo_name[GF_DYN_REPO_LEN];
     char                                cs[GF_DYN_CS_LEN];
     char                                cookie[GF_DYN_COOKIE_LEN];
@@ -220,6 +260,13 @@ globus_l_gfs_gfork_dyn_reg(
         total_max = -1;
     }
 
+    memcpy(&tmp_32, &buffer[GF_DYN_LOAD_CONN_NDX], sizeof(uint32_t));
+    load_conn = (int) tmp_32;
+    memcpy(&tmp_32, &buffer[GF_DYN_LOAD_CPU_NDX], sizeof(uint32_t));
+    load_cpu = (int) tmp_32;
+    memcpy(&tmp_32, &buffer[GF_DYN_LOAD_MEM_NDX], sizeof(uint32_t));
+    load_mem = (int) tmp_32;
+
     memcpy(cookie, &buffer[GF_DYN_COOKIE_NDX], GF_DYN_COOKIE_LEN);
     memcpy(cs, &buffer[GF_DYN_CS_NDX], GF_DYN_CS_LEN);
     memcpy(repo_name, &buffer[GF_DYN_REPO_NDX], GF_DYN_REPO_LEN);
@@ -263,14 +310,18 @@ globus_l_gfs_gfork_dyn_reg(
         node->cookie_id = cookie_id;
         node->repo_name = strdup(repo_name);
         node->repo = repo;
-        globus_priority_q_enqueue(&repo->node_q, node, node);
-        globus_hashtable_insert(&repo->node_table, node->cookie_id, node);
         /* the next line is here so that if it was static it will
             remain static */
         node->type = GFS_DB_NODE_TYPE_DYNAMIC;
         node->current_connection = 0;
         node->max_connection = con_max;
         node->total_max_connections = total_max;
+        node->reported_connections = load_conn;
+        node->cpu_load = load_cpu;
+        node->mem_load = load_mem;
+        gfs_l_db_node_score(node);
+        globus_priority_q_enqueue(&repo->node_q, node, node);
+        globus_hashtable_insert(&repo->node_table, node->cookie_id, node);
         globus_gfs_log_message(
             GLOBUS_GFS_LOG_WARN,
             "A new backend registered, contact string: [%s] %s\n"
@@ -283,9 +334,28 @@ globus_l_gfs_gfork_dyn_reg(
     }
     else
     {
-        /* XXX ? do i need to dequeue and requeue ? */
+        /* the order in the queue depends on all of this so it has to
+            come out and go back in.  if it is not in the queue it is
+            in error and stays out */
+        tmp_ptr = globus_priority_q_remove(&repo->node_q, node);
         node->total_max_connections = total_max;
         node->max_connection = con_max;
+        node->reported_connections = load_conn;
+        node->cpu_load = load_cpu;
+        node->mem_load = load_mem;
+        gfs_l_db_node_score(node);
+        if(tmp_ptr != NULL)
+        {
+            globus_priority_q_enqueue(&repo->node_q, node, node);
+        }
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_INFO,
+            "Backend load update: [%s] %s conn=%d cpu=%d%% mem=%d%%\n",
+            node->repo_name,
+            node->host_id,
+            node->reported_connections,
+            node->cpu_load,
+            node->mem_load);
         free(cookie_id);
     }
 error_cs:
@@ -355,6 +425,35 @@ globus_l_gfs_mem_limit_release_cb(
     }
 }
 
+static
+void
+globus_l_gfs_gfork_qos_share(
+    const char *                        class_name,
+    globus_bool_t                       active)
+{
+    globus_xio_iovec_t                  iov[1];
+    globus_byte_t *                     buffer;
+    uint32_t                            tmp32;
+
+    tmp32 = active ? 1 : 0;
+    buffer = globus_calloc(1, GF_QOS_MSG_LEN);
+    buffer[GF_VERSION_NDX] = GF_VERSION;
+    buffer[GF_MSG_TYPE_NDX] = GFS_GFORK_MSG_TYPE_QOS;
+    memcpy(&buffer[GF_QOS_COUNT_NDX], &tmp32, sizeof(uint32_t));
+    strncpy((char *) &buffer[GF_QOS_CLASS_NDX],
+        class_name, GF_QOS_CLASS_LEN - 1);
+
+    iov[0].iov_base = buffer;
+    iov[0].iov_len = GF_QOS_MSG_LEN;
+
+    globus_gfork_send(
+        globus_l_gfs_gfork_handle,
+        -1, /* to the master */
+        iov,
+        1,
+        globus_l_gfs_mem_release_write_cb,
+        buffer);
+}
 
 static
 void
@@ -446,6 +545,18 @@ globus_l_gfs_gfork_incoming_cb(
                     NULL);
                 break;
 
+            case GFS_GFORK_MSG_TYPE_QOS:
+                if(len < GF_QOS_MSG_LEN)
+                {
+                    goto error;
+                }
+                memcpy(&n32, &buffer[GF_QOS_COUNT_NDX], sizeof(uint32_t));
+                buffer[GF_QOS_CLASS_NDX + GF_QOS_CLASS_LEN - 1] = '\0';
+                globus_i_gfs_qos_set_share(
+                    (char *) &buffer[GF_QOS_CLASS_NDX], (int) n32);
+                globus_free(buffer);
+                break;
+
             case GFS_GFORK_MSG_TYPE_READY:
                 globus_gfs_log_message(
                     GLOBUS_GFS_LOG_WARN, "Ready message received.\n");
@@ -592,6 +703,7 @@ globus_l_gfs_default_brain_init(
         else
         {
             globus_l_gfs_gfork_on = GLOBUS_TRUE;
+            globus_i_gfs_qos_set_share_func(globus_l_gfs_gfork_qos_share);
         }
     }
     globus_mutex_unlock(&globus_l_brain_mutex);
@@ -634,6 +746,8 @@ globus_l_gfs_default_brain_select_nodes(
 {
     globus_bool_t                       done = GLOBUS_FALSE;
     int                                 best_count;
+    int                                 blocksize;
+    globus_off_t                        blocks;
     int                                 count;
     int                                 e_count;
     int                                 loop_count;
@@ -676,6 +790,21 @@ globus_l_gfs_default_brain_select_nodes(
         {
             best_count = max_count;
         }
+        /* when the size is known do not spread a small file over more
+            nodes than it has stripe blocks, every extra node is another
+            data mover busy for almost nothing */
+        if(filesize >= 0)
+        {
+            blocksize = globus_i_gfs_config_int("stripe_blocksize");
+            if(blocksize > 0)
+            {
+                blocks = (filesize + blocksize - 1) / blocksize;
+                if(blocks < best_count)
+                {
+                    best_count = blocks > 0 ? (int) blocks : 1;
+                }
+            }
+        }
         if(best_count < min_count)
         {
             best_count = min_count;
@@ -740,6 +869,7 @@ globus_l_gfs_default_brain_select_nodes(
             {
                 node = (gfs_l_db_node_t *) node_array[i];
                 node->total_connections++;
+                gfs_l_db_node_score(node);
                 globus_priority_q_enqueue(
                     &repo->node_q, node_array[i], node_array[i]);
             }
@@ -759,6 +889,7 @@ error_short:
     {
         node = (gfs_l_db_node_t *) node_array[i];
         node->current_connection--;
+        gfs_l_db_node_score(node);
         globus_priority_q_enqueue(&repo->node_q, node, node);
         globus_gfs_log_message(
             GLOBUS_GFS_LOG_WARN,
@@ -903,6 +1034,7 @@ globus_l_gfs_default_brain_release_node(
             if(node->total_max_connections < 0
                 || node->total_connections < node->total_max_connections)
             {
+                gfs_l_db_node_score(node);
                 globus_priority_q_enqueue(&repo->node_q, node, node);
             }
             else
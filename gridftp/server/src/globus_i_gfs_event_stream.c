@@ -0,0 +1,321 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * binary session and transfer events for dashboards and accounting.
+ *
+ * when event_stream names a unix socket each event is sent to it as one
+ * datagram in the format described in globus_i_gfs_event_stream.h.  the
+ * socket is connected when the log is opened, and again by the daemon
+ * before it forks each session, while the process still runs as the
+ * server's own user.  sessions that have since changed to another user
+ * keep sending on the connected socket, so the reader's socket only has to
+ * be writable by the server's user and no one else can forge events.  a
+ * session that finds the reader was restarted connects again if it is
+ * still allowed to.  sends never block; an event that can't be sent is
+ * counted and the count goes out with the next one that can.
+ * gfs-event-reader receives and prints the events.
+ */
+
+#include "globus_i_gridftp_server.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+static int                              globus_l_gfs_event_stream_fd = -1;
+#ifndef _WIN32
+static struct sockaddr_un               globus_l_gfs_event_stream_addr;
+#endif
+static globus_mutex_t                   globus_l_gfs_event_stream_mutex;
+static globus_bool_t                    globus_l_gfs_event_stream_mutex_init;
+static globus_off_t                     globus_l_gfs_event_stream_dropped;
+static globus_off_t                     globus_l_gfs_event_stream_last_id;
+
+static
+void
+globus_l_gfs_event_stream_put16(
+    unsigned char *                     buf,
+    unsigned int                        value)
+{
+    buf[0] = (value >> 8) & 0xff;
+    buf[1] = value & 0xff;
+}
+
+static
+void
+globus_l_gfs_event_stream_put32(
+    unsigned char *                     buf,
+    globus_off_t                        value)
+{
+    buf[0] = (value >> 24) & 0xff;
+    buf[1] = (value >> 16) & 0xff;
+    buf[2] = (value >> 8) & 0xff;
+    buf[3] = value & 0xff;
+}
+
+static
+void
+globus_l_gfs_event_stream_put64(
+    unsigned char *                     buf,
+    globus_off_t                        value)
+{
+    globus_l_gfs_event_stream_put32(buf, (value >> 32) & 0xffffffff);
+    globus_l_gfs_event_stream_put32(buf + 4, value & 0xffffffff);
+}
+
+#ifndef _WIN32
+/* called locked, or before other threads can send */
+static
+void
+globus_l_gfs_event_stream_connect(void)
+{
+    /* fails if the reader isn't running, sends then fail until a later
+     * connect succeeds */
+    connect(
+        globus_l_gfs_event_stream_fd,
+        (struct sockaddr *) &globus_l_gfs_event_stream_addr,
+        sizeof(globus_l_gfs_event_stream_addr));
+}
+#endif
+
+void
+globus_i_gfs_event_stream_init(void)
+{
+#ifndef _WIN32
+    char *                              path;
+    int                                 fd;
+    GlobusGFSName(globus_i_gfs_event_stream_init);
+    GlobusGFSDebugEnter();
+
+    path = globus_i_gfs_config_string("event_stream");
+    if(path == NULL || globus_l_gfs_event_stream_fd != -1)
+    {
+        goto done;
+    }
+    if(strlen(path) >= sizeof(globus_l_gfs_event_stream_addr.sun_path))
+    {
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_WARN,
+            "Event stream socket path is too long: %s\n", path);
+        goto done;
+    }
+
+    fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    if(fd < 0)
+    {
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_WARN,
+            "Unable to create event stream socket: %s\n", strerror(errno));
+        goto done;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    memset(&globus_l_gfs_event_stream_addr, 0,
+        sizeof(globus_l_gfs_event_stream_addr));
+    globus_l_gfs_event_stream_addr.sun_family = AF_UNIX;
+    strcpy(globus_l_gfs_event_stream_addr.sun_path, path);
+
+    if(!globus_l_gfs_event_stream_mutex_init)
+    {
+        globus_mutex_init(&globus_l_gfs_event_stream_mutex, NULL);
+        globus_l_gfs_event_stream_mutex_init = GLOBUS_TRUE;
+    }
+    globus_l_gfs_event_stream_dropped = 0;
+    globus_l_gfs_event_stream_fd = fd;
+    globus_l_gfs_event_stream_connect();
+
+done:
+    GlobusGFSDebugExit();
+#endif
+}
+
+void
+globus_i_gfs_event_stream_close(void)
+{
+    GlobusGFSName(globus_i_gfs_event_stream_close);
+    GlobusGFSDebugEnter();
+
+    /* the mutex is kept, as with the log handle other threads may still
+     * send during shutdown */
+    if(globus_l_gfs_event_stream_fd != -1)
+    {
+        globus_mutex_lock(&globus_l_gfs_event_stream_mutex);
+        {
+            close(globus_l_gfs_event_stream_fd);
+            globus_l_gfs_event_stream_fd = -1;
+        }
+        globus_mutex_unlock(&globus_l_gfs_event_stream_mutex);
+    }
+
+    GlobusGFSDebugExit();
+}
+
+void
+globus_i_gfs_event_stream_reconnect(void)
+{
+#ifndef _WIN32
+    if(globus_l_gfs_event_stream_fd != -1)
+    {
+        globus_mutex_lock(&globus_l_gfs_event_stream_mutex);
+        if(globus_l_gfs_event_stream_fd != -1)
+        {
+            globus_l_gfs_event_stream_connect();
+        }
+        globus_mutex_unlock(&globus_l_gfs_event_stream_mutex);
+    }
+#endif
+}
+
+globus_bool_t
+globus_i_gfs_event_stream_enabled(void)
+{
+    return globus_l_gfs_event_stream_fd != -1;
+}
+
+globus_off_t
+globus_i_gfs_event_stream_next_id(void)
+{
+    globus_off_t                        id = 0;
+
+    if(globus_l_gfs_event_stream_fd != -1)
+    {
+        globus_mutex_lock(&globus_l_gfs_event_stream_mutex);
+        {
+            id = ++globus_l_gfs_event_stream_last_id;
+        }
+        globus_mutex_unlock(&globus_l_gfs_event_stream_mutex);
+    }
+
+    return id;
+}
+
+void
+globus_i_gfs_event_stream_start(
+    globus_i_gfs_event_record_t *       record,
+    globus_i_gfs_event_stream_type_t    type,
+    globus_off_t                        session_id,
+    globus_off_t                        transfer_id)
+{
+    struct timeval                      now;
+    unsigned char *                     buf;
+
+    gettimeofday(&now, NULL);
+    buf = record->buffer;
+
+    /* length and dropped are filled in when sent */
+    globus_l_gfs_event_stream_put16(
+        buf + 4, GLOBUS_I_GFS_EVENT_STREAM_VERSION);
+    globus_l_gfs_event_stream_put16(buf + 6, type);
+    globus_l_gfs_event_stream_put32(buf + 8, getpid());
+    globus_l_gfs_event_stream_put64(
+        buf + 16, (globus_off_t) now.tv_sec * 1000000 + now.tv_usec);
+    globus_l_gfs_event_stream_put64(buf + 24, session_id);
+    globus_l_gfs_event_stream_put64(buf + 32, transfer_id);
+    record->length = GLOBUS_I_GFS_EVENT_STREAM_HEADER_LEN;
+}
+
+void
+globus_i_gfs_event_stream_add_int(
+    globus_i_gfs_event_record_t *       record,
+    globus_i_gfs_event_stream_tag_t     tag,
+    globus_off_t                        value)
+{
+    unsigned char *                     buf;
+
+    if(record->length + 12 > GLOBUS_I_GFS_EVENT_STREAM_MAX)
+    {
+        return;
+    }
+    buf = record->buffer + record->length;
+    globus_l_gfs_event_stream_put16(buf, tag);
+    globus_l_gfs_event_stream_put16(buf + 2, 8);
+    globus_l_gfs_event_stream_put64(buf + 4, value);
+    record->length += 12;
+}
+
+void
+globus_i_gfs_event_stream_add_string(
+    globus_i_gfs_event_record_t *       record,
+    globus_i_gfs_event_stream_tag_t     tag,
+    const char *                        value)
+{
+    unsigned char *                     buf;
+    globus_size_t                       len;
+
+    if(value == NULL || record->length + 4 > GLOBUS_I_GFS_EVENT_STREAM_MAX)
+    {
+        return;
+    }
+    len = strlen(value);
+    if(len > GLOBUS_I_GFS_EVENT_STREAM_MAX - record->length - 4)
+    {
+        len = GLOBUS_I_GFS_EVENT_STREAM_MAX - record->length - 4;
+    }
+    buf = record->buffer + record->length;
+    globus_l_gfs_event_stream_put16(buf, tag);
+    globus_l_gfs_event_stream_put16(buf + 2, len);
+    memcpy(buf + 4, value, len);
+    record->length += 4 + len;
+}
+
+void
+globus_i_gfs_event_stream_send(
+    globus_i_gfs_event_record_t *       record)
+{
+#ifndef _WIN32
+    globus_off_t                        dropped;
+    ssize_t                             rc;
+
+    if(globus_l_gfs_event_stream_fd == -1)
+    {
+        return;
+    }
+
+    globus_mutex_lock(&globus_l_gfs_event_stream_mutex);
+    if(globus_l_gfs_event_stream_fd != -1)
+    {
+        dropped = globus_l_gfs_event_stream_dropped;
+        globus_l_gfs_event_stream_put32(record->buffer, record->length);
+        globus_l_gfs_event_stream_put32(record->buffer + 12, dropped);
+
+        rc = send(
+            globus_l_gfs_event_stream_fd, record->buffer, record->length, 0);
+        if(rc < 0 && (errno == ECONNREFUSED || errno == ENOTCONN))
+        {
+            /* the reader was restarted or started late */
+            globus_l_gfs_event_stream_connect();
+            rc = send(
+                globus_l_gfs_event_stream_fd,
+                record->buffer,
+                record->length,
+                0);
+        }
+        if(rc < 0)
+        {
+            /* no reader, or it is behind */
+            globus_l_gfs_event_stream_dropped++;
+        }
+        else
+        {
+            globus_l_gfs_event_stream_dropped = 0;
+        }
+    }
+    globus_mutex_unlock(&globus_l_gfs_event_stream_mutex);
+#endif
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_I_GFS_EVENT_STREAM_H
+#define GLOBUS_I_GFS_EVENT_STREAM_H
+
+/*
+ * binary event records, sent one per datagram to the unix socket named by
+ * the event_stream option.  all numbers are in network byte order.
+ *
+ *   uint32  length of the whole record
+ *   uint16  GLOBUS_I_GFS_EVENT_STREAM_VERSION
+ *   uint16  record type
+ *   uint32  pid of the server process
+ *   uint32  records this process dropped since the last one sent
+ *   uint64  time, microseconds since the epoch
+ *   uint64  session id, counts up from 1 within the process
+ *   uint64  transfer id, counts up from 1 within the process, 0 if none
+ *
+ * then fields until length, each a uint16 tag, a uint16 value length and
+ * the value.  numbers are 8 byte values, strings are not terminated.
+ * readers skip tags they don't know, new tags don't change the version.
+ */
+
+#define GLOBUS_I_GFS_EVENT_STREAM_VERSION       1
+#define GLOBUS_I_GFS_EVENT_STREAM_HEADER_LEN    40
+#define GLOBUS_I_GFS_EVENT_STREAM_MAX           4096
+
+typedef enum
+{
+    GLOBUS_I_GFS_EVENT_SESSION_START = 1,
+    GLOBUS_I_GFS_EVENT_SESSION_END,
+    GLOBUS_I_GFS_EVENT_TRANSFER_BEGIN,
+    GLOBUS_I_GFS_EVENT_TRANSFER_END,
+    /* bytes moved by one stripe since its last perf marker */
+    GLOBUS_I_GFS_EVENT_PERF,
+    GLOBUS_I_GFS_EVENT_ERROR
+} globus_i_gfs_event_stream_type_t;
+
+typedef enum
+{
+    GLOBUS_I_GFS_EVENT_TAG_USER = 1,
+    GLOBUS_I_GFS_EVENT_TAG_SUBJECT,
+    GLOBUS_I_GFS_EVENT_TAG_CLIENT_IP,
+    GLOBUS_I_GFS_EVENT_TAG_REMOTE_IP,
+    GLOBUS_I_GFS_EVENT_TAG_PATH,
+    /* RETR, STOR, ERET, ESTO, LIST... */
+    GLOBUS_I_GFS_EVENT_TAG_OP,
+    GLOBUS_I_GFS_EVENT_TAG_BYTES,
+    GLOBUS_I_GFS_EVENT_TAG_DURATION_USEC,
+    GLOBUS_I_GFS_EVENT_TAG_STREAMS,
+    GLOBUS_I_GFS_EVENT_TAG_STRIPES,
+    GLOBUS_I_GFS_EVENT_TAG_STRIPE,
+    GLOBUS_I_GFS_EVENT_TAG_BLOCKSIZE,
+    GLOBUS_I_GFS_EVENT_TAG_TCP_BUFFER,
+    GLOBUS_I_GFS_EVENT_TAG_MESSAGE,
+    GLOBUS_I_GFS_EVENT_TAG_TASKID
+} globus_i_gfs_event_stream_tag_t;
+
+#ifndef GLOBUS_I_GFS_EVENT_STREAM_FORMAT_ONLY
+
+typedef struct
+{
+    unsigned char                       buffer[GLOBUS_I_GFS_EVENT_STREAM_MAX];
+    globus_size_t                       length;
+} globus_i_gfs_event_record_t;
+
+/* opens the socket named by event_stream, if set */
+void
+globus_i_gfs_event_stream_init(void);
+
+void
+globus_i_gfs_event_stream_close(void);
+
+/* connects to the reader again, in case it was restarted.  the daemon
+ * calls this before it forks a session, which may not be allowed to once it
+ * runs as the session's user */
+void
+globus_i_gfs_event_stream_reconnect(void);
+
+/* true when records are being sent.  check before building one */
+globus_bool_t
+globus_i_gfs_event_stream_enabled(void);
+
+/* a new session or transfer id, 0 when records are not being sent */
+globus_off_t
+globus_i_gfs_event_stream_next_id(void);
+
+void
+globus_i_gfs_event_stream_start(
+    globus_i_gfs_event_record_t *       record,
+    globus_i_gfs_event_stream_type_t    type,
+    globus_off_t                        session_id,
+    globus_off_t                        transfer_id);
+
+void
+globus_i_gfs_event_stream_add_int(
+    globus_i_gfs_event_record_t *       record,
+    globus_i_gfs_event_stream_tag_t     tag,
+    globus_off_t                        value);
+
+/* does nothing if value is NULL, cuts the value short if it doesn't fit */
+void
+globus_i_gfs_event_stream_add_string(
+    globus_i_gfs_event_record_t *       record,
+    globus_i_gfs_event_stream_tag_t     tag,
+    const char *                        value);
+
+/* never blocks, the record is dropped and counted if it can't be sent */
+void
+globus_i_gfs_event_stream_send(
+    globus_i_gfs_event_record_t *       record);
+
+#endif
+
+#endif
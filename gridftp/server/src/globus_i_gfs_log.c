@@ -368,6 +368,15 @@ globus_i_gfs_log_open()
                     }
                     GlobusTimeReltimeSet(flush_interval, (int) tmp_off, 0);
                 }
+                else if(strcasecmp(opts, "writer=wait") == 0)
+                {
+                    log_mask |= GLOBUS_LOGGING_WRITER_THREAD;
+                }
+                else if(strcasecmp(opts, "writer=drop") == 0)
+                {
+                    log_mask |= 
+                        GLOBUS_LOGGING_WRITER_THREAD | GLOBUS_LOGGING_DROP;
+                }
                 else
                 {
                     fprintf(stderr, "Invalid log module option: %s\n", opts);
@@ -543,6 +552,8 @@ globus_i_gfs_log_open()
         result = globus_l_gfs_log_usage_stats_init();
     }
 
+    globus_i_gfs_event_stream_init();
+
 
     if(module_str)
     {
@@ -584,6 +595,7 @@ globus_i_gfs_log_close(void)
         fclose(globus_l_gfs_transfer_log_file);
         globus_l_gfs_transfer_log_file = NULL;
     }
+    globus_i_gfs_event_stream_close();
     
     list = globus_l_gfs_log_usage_handle_list;
     
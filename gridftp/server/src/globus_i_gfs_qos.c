@@ -0,0 +1,620 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * bandwidth and metadata operation limits.
+ *
+ * the qos_rules option defines classes, each a token bucket of bytes and
+ * of operations per second:
+ *
+ *   *               every transfer on the server
+ *   group:name      sessions whose primary group is name
+ *   user:name       sessions of user name
+ *   user:*          each user not named in a rule of its own
+ *   path:/prefix    files under /prefix, the longest prefix wins
+ *
+ * an operation draws from every class it is in, so the tightest one
+ * sets its pace.  tokens are taken when data completes and the data
+ * callback is held back while a class is in debt, which in turn holds
+ * back the next read or write the DSI registers.
+ *
+ * under gfork every server process is a separate session, so the brain
+ * tells the master which classes this process is transferring in and
+ * the master answers with how many processes are; each gets an equal
+ * share of the class rate.
+ */
+
+#include "globus_i_gridftp_server.h"
+#ifndef TARGET_ARCH_WIN32
+#include <grp.h>
+#endif
+
+#define GFS_QOS_HASH_SIZE               64
+/* an operation is in the root and at most one group, user and path class */
+#define GFS_QOS_MAX_CLASSES             4
+/* a class can save up this long a burst while idle */
+#define GFS_QOS_BURST_USEC              250000
+#define GFS_QOS_MIN_BURST               (256 * 1024)
+
+typedef struct gfs_l_qos_class_s
+{
+    char *                              name;
+    /* bytes and operations per second, 0 for no limit */
+    globus_off_t                        rate;
+    int                                 ops;
+    gid_t                               gid;
+    /* processes transferring in this class, from the gfork master */
+    int                                 share;
+    /* transfers in this process */
+    int                                 active;
+    globus_off_t                        tokens;
+    /* thousandths of an operation */
+    globus_off_t                        op_tokens;
+    globus_abstime_t                    last;
+} gfs_l_qos_class_t;
+
+struct globus_i_gfs_qos_s
+{
+    gfs_l_qos_class_t *                 classes[GFS_QOS_MAX_CLASSES];
+    int                                 count;
+    globus_bool_t                       transfer;
+};
+
+static globus_thread_once_t             gfs_l_qos_once =
+                                            GLOBUS_THREAD_ONCE_INIT;
+static globus_mutex_t                   gfs_l_qos_mutex;
+static globus_bool_t                    gfs_l_qos_enabled = GLOBUS_FALSE;
+/* name -> class */
+static globus_hashtable_t               gfs_l_qos_table;
+static gfs_l_qos_class_t *              gfs_l_qos_root = NULL;
+static gfs_l_qos_class_t *              gfs_l_qos_user_default = NULL;
+static globus_list_t *                  gfs_l_qos_groups = NULL;
+static globus_list_t *                  gfs_l_qos_paths = NULL;
+static globus_i_gfs_qos_share_func_t    gfs_l_qos_share_func = NULL;
+
+
+static
+gfs_l_qos_class_t *
+gfs_l_qos_class_create(
+    const char *                        name,
+    globus_off_t                        rate,
+    int                                 ops)
+{
+    gfs_l_qos_class_t *                 class;
+
+    class = (gfs_l_qos_class_t *) globus_calloc(1, sizeof(gfs_l_qos_class_t));
+    if(class == NULL)
+    {
+        return NULL;
+    }
+    class->name = globus_libc_strdup(name);
+    class->rate = rate;
+    class->ops = ops;
+    class->share = 1;
+    /* start with a full bucket */
+    class->tokens = rate * GFS_QOS_BURST_USEC / 1000000;
+    if(class->tokens < GFS_QOS_MIN_BURST)
+    {
+        class->tokens = GFS_QOS_MIN_BURST;
+    }
+    class->op_tokens = ops > 0 ? (globus_off_t) ops * 1000 : 1000;
+    GlobusTimeAbstimeGetCurrent(class->last);
+
+    return class;
+}
+
+/* name=rate[:ops] */
+static
+globus_result_t
+gfs_l_qos_add_rule(
+    char *                              rule)
+{
+    char *                              value;
+    char *                              ops_str;
+    char *                              name;
+    globus_off_t                        rate = 0;
+    int                                 ops = 0;
+    gfs_l_qos_class_t *                 class;
+    struct group *                      grent;
+    globus_result_t                     result;
+    GlobusGFSName(gfs_l_qos_add_rule);
+    GlobusGFSDebugEnter();
+
+    value = strrchr(rule, '=');
+    if(value == NULL || value == rule)
+    {
+        result = GlobusGFSErrorGeneric("qos rule is missing a rate");
+        goto error;
+    }
+    *value++ = '\0';
+    name = rule;
+
+    ops_str = strchr(value, ':');
+    if(ops_str != NULL)
+    {
+        *ops_str++ = '\0';
+        ops = atoi(ops_str);
+    }
+    if(*value != '\0' && globus_args_bytestr_to_num(value, &rate) != 0)
+    {
+        result = GlobusGFSErrorGeneric("invalid qos rate");
+        goto error;
+    }
+    if(rate < 0 || ops < 0)
+    {
+        result = GlobusGFSErrorGeneric("invalid qos rate");
+        goto error;
+    }
+
+    if(strcmp(name, "*") != 0 &&
+        strncmp(name, "user:", 5) != 0 &&
+        strncmp(name, "group:", 6) != 0 &&
+        strncmp(name, "path:/", 6) != 0)
+    {
+        result = GlobusGFSErrorGeneric("unknown qos class");
+        goto error;
+    }
+
+    class = gfs_l_qos_class_create(name, rate, ops);
+    if(class == NULL)
+    {
+        result = GlobusGFSErrorMemory("class");
+        goto error;
+    }
+
+    if(strcmp(name, "*") == 0)
+    {
+        gfs_l_qos_root = class;
+    }
+    else if(strcmp(name, "user:*") == 0)
+    {
+        /* template for the per user classes, never charged itself */
+        gfs_l_qos_user_default = class;
+    }
+    else if(strncmp(name, "group:", 6) == 0)
+    {
+        globus_libc_lock();
+        grent = getgrnam(name + 6);
+        if(grent != NULL)
+        {
+            class->gid = grent->gr_gid;
+        }
+        globus_libc_unlock();
+        if(grent == NULL)
+        {
+            if(!isdigit(name[6]))
+            {
+                globus_free(class->name);
+                globus_free(class);
+                result = GlobusGFSErrorGeneric("unknown qos group");
+                goto error;
+            }
+            class->gid = (gid_t) atoi(name + 6);
+        }
+        globus_list_insert(&gfs_l_qos_groups, class);
+    }
+    else if(strncmp(name, "path:", 5) == 0)
+    {
+        globus_list_insert(&gfs_l_qos_paths, class);
+    }
+    globus_hashtable_insert(&gfs_l_qos_table, class->name, class);
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+static
+void
+gfs_l_qos_init(void)
+{
+    char *                              rules;
+    char *                              rule;
+    char *                              next;
+    globus_result_t                     result;
+
+    globus_mutex_init(&gfs_l_qos_mutex, NULL);
+    globus_hashtable_init(
+        &gfs_l_qos_table,
+        GFS_QOS_HASH_SIZE,
+        globus_hashtable_string_hash,
+        globus_hashtable_string_keyeq);
+
+    rules = globus_i_gfs_config_string("qos_rules");
+    if(rules == NULL || *rules == '\0')
+    {
+        return;
+    }
+    rules = globus_libc_strdup(rules);
+
+    for(rule = rules; rule != NULL; rule = next)
+    {
+        next = strchr(rule, ',');
+        if(next != NULL)
+        {
+            *next++ = '\0';
+        }
+        while(isspace(*rule))
+        {
+            rule++;
+        }
+        if(*rule == '\0')
+        {
+            continue;
+        }
+        result = gfs_l_qos_add_rule(rule);
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_gfs_log_result(
+                GLOBUS_GFS_LOG_ERR,
+                "Ignoring qos_rules entry",
+                result);
+            continue;
+        }
+        gfs_l_qos_enabled = GLOBUS_TRUE;
+    }
+    globus_free(rules);
+
+    if(gfs_l_qos_enabled)
+    {
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_INFO,
+            "QoS limits enabled: %s\n",
+            globus_i_gfs_config_string("qos_rules"));
+    }
+}
+
+/* longest prefix that ends at a path component */
+static
+gfs_l_qos_class_t *
+gfs_l_qos_path_find(
+    const char *                        pathname)
+{
+    globus_list_t *                     list;
+    gfs_l_qos_class_t *                 class;
+    gfs_l_qos_class_t *                 best = NULL;
+    const char *                        prefix;
+    int                                 len;
+    int                                 best_len = 0;
+
+    for(list = gfs_l_qos_paths;
+        !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        class = (gfs_l_qos_class_t *) globus_list_first(list);
+        prefix = class->name + 5;
+        len = strlen(prefix);
+        if(len > best_len && strncmp(pathname, prefix, len) == 0 &&
+            (pathname[len] == '\0' || pathname[len] == '/' ||
+                prefix[len - 1] == '/'))
+        {
+            best = class;
+            best_len = len;
+        }
+    }
+
+    return best;
+}
+
+/* called locked */
+static
+gfs_l_qos_class_t *
+gfs_l_qos_user_find(
+    const char *                        username)
+{
+    gfs_l_qos_class_t *                 class;
+    char *                              name;
+
+    name = globus_common_create_string("user:%s", username);
+    class = (gfs_l_qos_class_t *)
+        globus_hashtable_lookup(&gfs_l_qos_table, name);
+    if(class == NULL && gfs_l_qos_user_default != NULL &&
+        strlen(name) < GLOBUS_I_GFS_QOS_CLASS_LEN)
+    {
+        class = gfs_l_qos_class_create(
+            name,
+            gfs_l_qos_user_default->rate,
+            gfs_l_qos_user_default->ops);
+        if(class != NULL)
+        {
+            globus_hashtable_insert(&gfs_l_qos_table, class->name, class);
+        }
+    }
+    globus_free(name);
+
+    return class;
+}
+
+globus_i_gfs_qos_t
+globus_i_gfs_qos_attach(
+    const char *                        username,
+    gid_t                               gid,
+    const char *                        pathname,
+    globus_bool_t                       transfer)
+{
+    globus_i_gfs_qos_t                  qos;
+    gfs_l_qos_class_t *                 classes[GFS_QOS_MAX_CLASSES];
+    gfs_l_qos_class_t *                 class;
+    globus_list_t *                     list;
+    int                                 count = 0;
+    int                                 i;
+    GlobusGFSName(globus_i_gfs_qos_attach);
+    GlobusGFSDebugEnter();
+
+    globus_thread_once(&gfs_l_qos_once, gfs_l_qos_init);
+    if(!gfs_l_qos_enabled)
+    {
+        goto none;
+    }
+
+    globus_mutex_lock(&gfs_l_qos_mutex);
+    {
+        if(gfs_l_qos_root != NULL)
+        {
+            classes[count++] = gfs_l_qos_root;
+        }
+        for(list = gfs_l_qos_groups;
+            !globus_list_empty(list);
+            list = globus_list_rest(list))
+        {
+            class = (gfs_l_qos_class_t *) globus_list_first(list);
+            if(class->gid == gid)
+            {
+                classes[count++] = class;
+                break;
+            }
+        }
+        if(username != NULL)
+        {
+            class = gfs_l_qos_user_find(username);
+            if(class != NULL)
+            {
+                classes[count++] = class;
+            }
+        }
+        if(pathname != NULL)
+        {
+            class = gfs_l_qos_path_find(pathname);
+            if(class != NULL)
+            {
+                classes[count++] = class;
+            }
+        }
+
+        if(count == 0)
+        {
+            globus_mutex_unlock(&gfs_l_qos_mutex);
+            goto none;
+        }
+
+        qos = (globus_i_gfs_qos_t)
+            globus_calloc(1, sizeof(struct globus_i_gfs_qos_s));
+        if(qos == NULL)
+        {
+            globus_mutex_unlock(&gfs_l_qos_mutex);
+            goto none;
+        }
+        qos->count = count;
+        qos->transfer = transfer;
+        for(i = 0; i < count; i++)
+        {
+            qos->classes[i] = classes[i];
+            if(transfer && classes[i]->active++ == 0 &&
+                gfs_l_qos_share_func != NULL)
+            {
+                gfs_l_qos_share_func(classes[i]->name, GLOBUS_TRUE);
+            }
+        }
+    }
+    globus_mutex_unlock(&gfs_l_qos_mutex);
+
+    GlobusGFSDebugExit();
+    return qos;
+
+none:
+    GlobusGFSDebugExit();
+    return NULL;
+}
+
+void
+globus_i_gfs_qos_detach(
+    globus_i_gfs_qos_t                  qos)
+{
+    int                                 i;
+    GlobusGFSName(globus_i_gfs_qos_detach);
+    GlobusGFSDebugEnter();
+
+    if(qos == NULL)
+    {
+        GlobusGFSDebugExit();
+        return;
+    }
+
+    globus_mutex_lock(&gfs_l_qos_mutex);
+    {
+        for(i = 0; qos->transfer && i < qos->count; i++)
+        {
+            if(--qos->classes[i]->active == 0 &&
+                gfs_l_qos_share_func != NULL)
+            {
+                gfs_l_qos_share_func(qos->classes[i]->name, GLOBUS_FALSE);
+            }
+        }
+    }
+    globus_mutex_unlock(&gfs_l_qos_mutex);
+
+    globus_free(qos);
+
+    GlobusGFSDebugExit();
+}
+
+/* called locked.  returns the usecs until class is out of debt */
+static
+long
+gfs_l_qos_class_charge(
+    gfs_l_qos_class_t *                 class,
+    const globus_abstime_t *            now,
+    globus_off_t                        bytes,
+    int                                 ops)
+{
+    globus_reltime_t                    elapsed;
+    globus_off_t                        rate;
+    globus_off_t                        op_rate;
+    globus_off_t                        burst;
+    long                                usec;
+    long                                wait = 0;
+    long                                op_wait = 0;
+
+    GlobusTimeAbstimeDiff(elapsed, *now, class->last);
+    GlobusTimeReltimeToUSec(usec, elapsed);
+    if(globus_abstime_cmp(now, &class->last) < 0)
+    {
+        usec = 0;
+    }
+    if(usec > 1000000)
+    {
+        usec = 1000000;
+    }
+    class->last = *now;
+
+    if(class->rate > 0)
+    {
+        rate = class->rate / class->share;
+        if(rate < 1)
+        {
+            rate = 1;
+        }
+        burst = rate * GFS_QOS_BURST_USEC / 1000000;
+        if(burst < GFS_QOS_MIN_BURST)
+        {
+            burst = GFS_QOS_MIN_BURST;
+        }
+        class->tokens += rate * usec / 1000000;
+        if(class->tokens > burst)
+        {
+            class->tokens = burst;
+        }
+        class->tokens -= bytes;
+        if(class->tokens < 0)
+        {
+            wait = (long) (-class->tokens * 1000000 / rate);
+        }
+    }
+
+    if(class->ops > 0)
+    {
+        op_rate = (globus_off_t) class->ops * 1000 / class->share;
+        if(op_rate < 1)
+        {
+            op_rate = 1;
+        }
+        class->op_tokens += op_rate * usec / 1000000;
+        /* at most one second of operations, and always at least one */
+        if(class->op_tokens > (op_rate > 1000 ? op_rate : 1000))
+        {
+            class->op_tokens = op_rate > 1000 ? op_rate : 1000;
+        }
+        class->op_tokens -= (globus_off_t) ops * 1000;
+        if(class->op_tokens < 0)
+        {
+            op_wait = (long) (-class->op_tokens * 1000000 / op_rate);
+        }
+    }
+
+    return wait > op_wait ? wait : op_wait;
+}
+
+globus_bool_t
+globus_i_gfs_qos_charge(
+    globus_i_gfs_qos_t                  qos,
+    globus_off_t                        bytes,
+    int                                 ops,
+    globus_reltime_t *                  delay)
+{
+    globus_abstime_t                    now;
+    long                                wait = 0;
+    long                                class_wait;
+    int                                 i;
+
+    if(qos == NULL || (bytes <= 0 && ops <= 0))
+    {
+        return GLOBUS_FALSE;
+    }
+
+    GlobusTimeAbstimeGetCurrent(now);
+    globus_mutex_lock(&gfs_l_qos_mutex);
+    {
+        for(i = 0; i < qos->count; i++)
+        {
+            class_wait = gfs_l_qos_class_charge(
+                qos->classes[i], &now, bytes, ops);
+            if(class_wait > wait)
+            {
+                wait = class_wait;
+            }
+        }
+    }
+    globus_mutex_unlock(&gfs_l_qos_mutex);
+
+    if(wait <= 0)
+    {
+        return GLOBUS_FALSE;
+    }
+    GlobusTimeReltimeSet(*delay, wait / 1000000, wait % 1000000);
+
+    return GLOBUS_TRUE;
+}
+
+void
+globus_i_gfs_qos_set_share_func(
+    globus_i_gfs_qos_share_func_t       share_func)
+{
+    globus_thread_once(&gfs_l_qos_once, gfs_l_qos_init);
+
+    globus_mutex_lock(&gfs_l_qos_mutex);
+    {
+        gfs_l_qos_share_func = share_func;
+    }
+    globus_mutex_unlock(&gfs_l_qos_mutex);
+}
+
+void
+globus_i_gfs_qos_set_share(
+    const char *                        class_name,
+    int                                 count)
+{
+    gfs_l_qos_class_t *                 class;
+
+    globus_thread_once(&gfs_l_qos_once, gfs_l_qos_init);
+
+    globus_mutex_lock(&gfs_l_qos_mutex);
+    {
+        class = (gfs_l_qos_class_t *)
+            globus_hashtable_lookup(&gfs_l_qos_table, (void *) class_name);
+        if(class != NULL)
+        {
+            class->share = count > 0 ? count : 1;
+            globus_gfs_log_message(
+                GLOBUS_GFS_LOG_DUMP,
+                "QoS class %s shared by %d processes\n",
+                class_name, class->share);
+        }
+    }
+    globus_mutex_unlock(&gfs_l_qos_mutex);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_I_GFS_QOS_H
+#define GLOBUS_I_GFS_QOS_H
+
+/* longest class name passed between processes, including the nul */
+#define GLOBUS_I_GFS_QOS_CLASS_LEN      128
+
+typedef struct globus_i_gfs_qos_s *     globus_i_gfs_qos_t;
+
+/* called when this process starts or stops transferring in a class */
+typedef void
+(*globus_i_gfs_qos_share_func_t)(
+    const char *                        class_name,
+    globus_bool_t                       active);
+
+/*
+ * look up the classes an operation on pathname by username draws from.
+ * returns NULL when no qos_rules apply.  a transfer marks this process
+ * active in its classes until globus_i_gfs_qos_detach().
+ */
+globus_i_gfs_qos_t
+globus_i_gfs_qos_attach(
+    const char *                        username,
+    gid_t                               gid,
+    const char *                        pathname,
+    globus_bool_t                       transfer);
+
+void
+globus_i_gfs_qos_detach(
+    globus_i_gfs_qos_t                  qos);
+
+/*
+ * take bytes and metadata ops from every class of qos.  returns
+ * GLOBUS_TRUE and sets delay if the caller must wait before going on.
+ */
+globus_bool_t
+globus_i_gfs_qos_charge(
+    globus_i_gfs_qos_t                  qos,
+    globus_off_t                        bytes,
+    int                                 ops,
+    globus_reltime_t *                  delay);
+
+/* set by the brain when limits are shared with other processes */
+void
+globus_i_gfs_qos_set_share_func(
+    globus_i_gfs_qos_share_func_t       share_func);
+
+/* count processes, including this one, now active in class_name */
+void
+globus_i_gfs_qos_set_share(
+    const char *                        class_name,
+    int                                 count);
+
+#endif
@@ -0,0 +1,543 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * reorder buffer for modules that can only write sequentially.
+ *
+ * data at the next expected offset goes straight to the write function.
+ * data ahead of it is copied and held in a priority queue keyed by
+ * offset, in memory until memory_limit is reached and after that in
+ * fixed size slots of an unlinked temp file that is mapped once and
+ * grown as needed.  whenever the next expected offset is written the
+ * queue is drained for as long as its head is contiguous.  held data
+ * that overlaps what has already been written is trimmed, so repeated
+ * blocks are harmless.
+ */
+
+#include "globus_i_gridftp_server.h"
+#ifndef TARGET_ARCH_WIN32
+#include <sys/mman.h>
+#endif
+
+#define GFS_REORDER_SLOT_SIZE           (64 * 1024)
+/* slots added to the spill file at a time */
+#define GFS_REORDER_SLOT_GROW           64
+
+typedef struct gfs_l_reorder_ent_s
+{
+    globus_off_t                        offset;
+    globus_size_t                       length;
+    /* NULL when held in the spill file */
+    globus_byte_t *                     data;
+    globus_size_t                       slot;
+} gfs_l_reorder_ent_t;
+
+struct globus_i_gfs_reorder_s
+{
+    globus_off_t                        offset;
+    globus_gfs_reorder_write_t          write_func;
+    void *                              user_arg;
+    globus_priority_q_t                 queue;
+
+    globus_size_t                       memory_limit;
+    globus_size_t                       memory_held;
+    globus_size_t                       memory_peak;
+
+    globus_off_t                        spill_limit;
+    int                                 spill_fd;
+    globus_byte_t *                     spill_map;
+    globus_size_t                       spill_map_slots;
+    globus_size_t                       spill_slots;
+    globus_size_t *                     spill_free;
+    globus_size_t                       spill_nfree;
+    globus_size_t                       spill_peak;
+};
+
+static
+int
+gfs_l_reorder_cmp(
+    void *                              priority_1,
+    void *                              priority_2)
+{
+    globus_off_t *                      offset_1;
+    globus_off_t *                      offset_2;
+
+    offset_1 = (globus_off_t *) priority_1;
+    offset_2 = (globus_off_t *) priority_2;
+
+    if(*offset_1 > *offset_2)
+    {
+        return 1;
+    }
+    if(*offset_1 < *offset_2)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+static
+globus_result_t
+gfs_l_reorder_spill_open(
+    globus_gfs_reorder_t                reorder)
+{
+#ifndef TARGET_ARCH_WIN32
+    char *                              tmpdir;
+    char *                              path;
+    globus_result_t                     result;
+    GlobusGFSName(gfs_l_reorder_spill_open);
+    GlobusGFSDebugEnter();
+
+    tmpdir = getenv("TMPDIR");
+    if(tmpdir == NULL || *tmpdir == '\0')
+    {
+        tmpdir = "/tmp";
+    }
+    path = globus_common_create_string(
+        "%s/gridftp-reorder-XXXXXX", tmpdir);
+    if(path == NULL)
+    {
+        result = GlobusGFSErrorMemory("path");
+        goto error_path;
+    }
+    reorder->spill_fd = mkstemp(path);
+    if(reorder->spill_fd < 0)
+    {
+        result = GlobusGFSErrorSystemError("mkstemp", errno);
+        goto error_open;
+    }
+    unlink(path);
+    fcntl(reorder->spill_fd, F_SETFD, FD_CLOEXEC);
+
+    /* map the whole limit now so held slots never move; only the part
+     * the file has been grown to is ever touched */
+    reorder->spill_map_slots = reorder->spill_limit / GFS_REORDER_SLOT_SIZE;
+    reorder->spill_map = mmap(
+        NULL,
+        reorder->spill_map_slots * GFS_REORDER_SLOT_SIZE,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        reorder->spill_fd,
+        0);
+    if(reorder->spill_map == MAP_FAILED)
+    {
+        result = GlobusGFSErrorSystemError("mmap", errno);
+        goto error_map;
+    }
+
+    globus_gfs_log_message(
+        GLOBUS_GFS_LOG_INFO,
+        "Reorder buffer holding %lu bytes in memory, spilling to %s.\n",
+        (unsigned long) reorder->memory_held, path);
+    globus_free(path);
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_map:
+    reorder->spill_map = NULL;
+    close(reorder->spill_fd);
+    reorder->spill_fd = -1;
+error_open:
+    globus_free(path);
+error_path:
+    GlobusGFSDebugExitWithError();
+    return result;
+#else
+    GlobusGFSName(gfs_l_reorder_spill_open);
+    return GlobusGFSErrorGeneric("reorder spill file not supported");
+#endif
+}
+
+static
+globus_result_t
+gfs_l_reorder_spill_slot(
+    globus_gfs_reorder_t                reorder,
+    globus_size_t *                     slot)
+{
+    globus_size_t                       new_slots;
+    globus_size_t *                     new_free;
+    globus_size_t                       i;
+    globus_result_t                     result;
+    GlobusGFSName(gfs_l_reorder_spill_slot);
+    GlobusGFSDebugEnter();
+
+    if(reorder->spill_nfree == 0)
+    {
+        if(reorder->spill_map == NULL)
+        {
+            result = gfs_l_reorder_spill_open(reorder);
+            if(result != GLOBUS_SUCCESS)
+            {
+                goto error;
+            }
+        }
+        new_slots = reorder->spill_slots + GFS_REORDER_SLOT_GROW;
+        if(new_slots > reorder->spill_map_slots)
+        {
+            new_slots = reorder->spill_map_slots;
+        }
+        if(new_slots == reorder->spill_slots)
+        {
+            result = GlobusGFSErrorGeneric(
+                "Reorder buffer is full; data is too far out of order.");
+            goto error;
+        }
+        if(ftruncate(reorder->spill_fd,
+            (off_t) new_slots * GFS_REORDER_SLOT_SIZE) != 0)
+        {
+            result = GlobusGFSErrorSystemError("ftruncate", errno);
+            goto error;
+        }
+        new_free = globus_realloc(
+            reorder->spill_free, new_slots * sizeof(globus_size_t));
+        if(new_free == NULL)
+        {
+            result = GlobusGFSErrorMemory("spill_free");
+            goto error;
+        }
+        reorder->spill_free = new_free;
+        /* hand out the low slots first */
+        for(i = new_slots; i > reorder->spill_slots; i--)
+        {
+            reorder->spill_free[reorder->spill_nfree++] = i - 1;
+        }
+        reorder->spill_slots = new_slots;
+    }
+
+    *slot = reorder->spill_free[--reorder->spill_nfree];
+    if(reorder->spill_slots - reorder->spill_nfree > reorder->spill_peak)
+    {
+        reorder->spill_peak = reorder->spill_slots - reorder->spill_nfree;
+    }
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+static
+void
+gfs_l_reorder_ent_free(
+    globus_gfs_reorder_t                reorder,
+    gfs_l_reorder_ent_t *               ent)
+{
+    if(ent->data == NULL)
+    {
+        reorder->spill_free[reorder->spill_nfree++] = ent->slot;
+    }
+    else
+    {
+        reorder->memory_held -= ent->length;
+    }
+    globus_free(ent);
+}
+
+/* hold a copy of data that can not be written yet */
+static
+globus_result_t
+gfs_l_reorder_hold(
+    globus_gfs_reorder_t                reorder,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset)
+{
+    gfs_l_reorder_ent_t *               ent;
+    globus_size_t                       len;
+    globus_result_t                     result;
+    GlobusGFSName(gfs_l_reorder_hold);
+    GlobusGFSDebugEnter();
+
+    if(reorder->memory_limit == 0 ||
+        reorder->memory_held + length <= reorder->memory_limit)
+    {
+        ent = globus_malloc(sizeof(gfs_l_reorder_ent_t) + length);
+        if(ent == NULL)
+        {
+            result = GlobusGFSErrorMemory("ent");
+            goto error;
+        }
+        ent->offset = offset;
+        ent->length = length;
+        ent->data = (globus_byte_t *) (ent + 1);
+        memcpy(ent->data, buffer, length);
+        globus_priority_q_enqueue(&reorder->queue, ent, &ent->offset);
+
+        reorder->memory_held += length;
+        if(reorder->memory_held > reorder->memory_peak)
+        {
+            reorder->memory_peak = reorder->memory_held;
+        }
+    }
+    else if(reorder->spill_limit >= GFS_REORDER_SLOT_SIZE)
+    {
+        /* a block larger than a slot is held as several entries */
+        while(length > 0)
+        {
+            len = length < GFS_REORDER_SLOT_SIZE ?
+                length : GFS_REORDER_SLOT_SIZE;
+            ent = globus_malloc(sizeof(gfs_l_reorder_ent_t));
+            if(ent == NULL)
+            {
+                result = GlobusGFSErrorMemory("ent");
+                goto error;
+            }
+            result = gfs_l_reorder_spill_slot(reorder, &ent->slot);
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_free(ent);
+                goto error;
+            }
+            ent->offset = offset;
+            ent->length = len;
+            ent->data = NULL;
+            memcpy(reorder->spill_map +
+                ent->slot * GFS_REORDER_SLOT_SIZE, buffer, len);
+            globus_priority_q_enqueue(&reorder->queue, ent, &ent->offset);
+
+            buffer += len;
+            offset += len;
+            length -= len;
+        }
+    }
+    else
+    {
+        result = GlobusGFSErrorGeneric(
+            "Reorder buffer is full; data is too far out of order.");
+        goto error;
+    }
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+/* pass data on at the expected offset, skipping what was already written */
+static
+globus_result_t
+gfs_l_reorder_emit(
+    globus_gfs_reorder_t                reorder,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset)
+{
+    globus_size_t                       skip;
+    globus_result_t                     result;
+    GlobusGFSName(gfs_l_reorder_emit);
+
+    if(offset + (globus_off_t) length <= reorder->offset)
+    {
+        return GLOBUS_SUCCESS;
+    }
+    skip = (globus_size_t) (reorder->offset - offset);
+
+    result = reorder->write_func(
+        buffer + skip, length - skip, reorder->offset, reorder->user_arg);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return GlobusGFSErrorWrapFailed("reorder write", result);
+    }
+    reorder->offset += length - skip;
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_result_t
+gfs_l_reorder_drain(
+    globus_gfs_reorder_t                reorder)
+{
+    gfs_l_reorder_ent_t *               ent;
+    globus_byte_t *                     data;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+
+    while(result == GLOBUS_SUCCESS)
+    {
+        ent = globus_priority_q_first(&reorder->queue);
+        if(ent == NULL || ent->offset > reorder->offset)
+        {
+            break;
+        }
+        globus_priority_q_dequeue(&reorder->queue);
+
+        data = ent->data;
+        if(data == NULL)
+        {
+            data = reorder->spill_map + ent->slot * GFS_REORDER_SLOT_SIZE;
+        }
+        result = gfs_l_reorder_emit(reorder, data, ent->length, ent->offset);
+        gfs_l_reorder_ent_free(reorder, ent);
+    }
+
+    return result;
+}
+
+globus_result_t
+globus_gridftp_server_reorder_init(
+    globus_gfs_reorder_t *              reorder_out,
+    globus_off_t                        offset,
+    globus_size_t                       memory_limit,
+    globus_off_t                        spill_limit,
+    globus_gfs_reorder_write_t          write_func,
+    void *                              user_arg)
+{
+    globus_gfs_reorder_t                reorder;
+    globus_result_t                     result;
+    GlobusGFSName(globus_gridftp_server_reorder_init);
+    GlobusGFSDebugEnter();
+
+    if(reorder_out == NULL || write_func == NULL)
+    {
+        result = GlobusGFSErrorParameter("reorder");
+        goto error;
+    }
+
+    reorder = globus_calloc(1, sizeof(struct globus_i_gfs_reorder_s));
+    if(reorder == NULL)
+    {
+        result = GlobusGFSErrorMemory("reorder");
+        goto error;
+    }
+    reorder->offset = offset;
+    reorder->write_func = write_func;
+    reorder->user_arg = user_arg;
+    reorder->memory_limit = memory_limit;
+    reorder->spill_limit = spill_limit > 0 ? spill_limit : 0;
+    reorder->spill_fd = -1;
+    globus_priority_q_init(&reorder->queue, gfs_l_reorder_cmp);
+
+    *reorder_out = reorder;
+
+    GlobusGFSDebugExit();
+    return GLOBUS_SUCCESS;
+
+error:
+    GlobusGFSDebugExitWithError();
+    return result;
+}
+
+globus_result_t
+globus_gridftp_server_reorder_write(
+    globus_gfs_reorder_t                reorder,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset)
+{
+    globus_result_t                     result;
+    GlobusGFSName(globus_gridftp_server_reorder_write);
+    GlobusGFSDebugEnter();
+
+    if(length == 0)
+    {
+        result = GLOBUS_SUCCESS;
+    }
+    else if(offset <= reorder->offset)
+    {
+        result = gfs_l_reorder_emit(reorder, buffer, length, offset);
+        if(result == GLOBUS_SUCCESS)
+        {
+            result = gfs_l_reorder_drain(reorder);
+        }
+    }
+    else
+    {
+        result = gfs_l_reorder_hold(reorder, buffer, length, offset);
+    }
+
+    GlobusGFSDebugExit();
+    return result;
+}
+
+globus_off_t
+globus_gridftp_server_reorder_get_offset(
+    globus_gfs_reorder_t                reorder)
+{
+    return reorder->offset;
+}
+
+globus_result_t
+globus_gridftp_server_reorder_finish(
+    globus_gfs_reorder_t                reorder)
+{
+    gfs_l_reorder_ent_t *               ent;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    char *                              msg;
+    GlobusGFSName(globus_gridftp_server_reorder_finish);
+    GlobusGFSDebugEnter();
+
+    ent = globus_priority_q_first(&reorder->queue);
+    if(ent != NULL)
+    {
+        msg = globus_common_create_string(
+            "Missing data at offset %"GLOBUS_OFF_T_FORMAT
+            "; data is held from offset %"GLOBUS_OFF_T_FORMAT".",
+            reorder->offset, ent->offset);
+        result = GlobusGFSErrorGeneric(msg);
+        globus_free(msg);
+    }
+
+    GlobusGFSDebugExit();
+    return result;
+}
+
+void
+globus_gridftp_server_reorder_destroy(
+    globus_gfs_reorder_t                reorder)
+{
+    gfs_l_reorder_ent_t *               ent;
+    GlobusGFSName(globus_gridftp_server_reorder_destroy);
+    GlobusGFSDebugEnter();
+
+    while((ent = globus_priority_q_dequeue(&reorder->queue)) != NULL)
+    {
+        gfs_l_reorder_ent_free(reorder, ent);
+    }
+    globus_priority_q_destroy(&reorder->queue);
+
+    if(reorder->memory_peak > 0 || reorder->spill_peak > 0)
+    {
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_DUMP,
+            "Reorder buffer held at most %lu bytes in memory and %lu "
+            "bytes in its spill file.\n",
+            (unsigned long) reorder->memory_peak,
+            (unsigned long) reorder->spill_peak * GFS_REORDER_SLOT_SIZE);
+    }
+#ifndef TARGET_ARCH_WIN32
+    if(reorder->spill_map != NULL)
+    {
+        munmap(reorder->spill_map,
+            reorder->spill_map_slots * GFS_REORDER_SLOT_SIZE);
+    }
+#endif
+    if(reorder->spill_fd >= 0)
+    {
+        close(reorder->spill_fd);
+    }
+    if(reorder->spill_free != NULL)
+    {
+        globus_free(reorder->spill_free);
+    }
+    globus_free(reorder);
+
+    GlobusGFSDebugExit();
+}
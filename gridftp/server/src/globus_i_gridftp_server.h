@@ -166,5 +166,7 @@ typedef enum globus_l_gfs_auth_level_e
 #include "globus_i_gfs_ipc.h"
 #include "globus_i_gfs_data.h"
 #include "globus_i_gfs_config.h"
+#include "globus_i_gfs_qos.h"
+#include "globus_i_gfs_event_stream.h"
 
 #endif
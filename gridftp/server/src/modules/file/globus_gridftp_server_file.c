@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "globus_i_gridftp_server_config.h"
 #include "globus_common.h"
 #include "globus_gridftp_server.h"
 #include "globus_xio.h"
@@ -25,6 +26,9 @@
 #include <utime.h>
 #ifndef TARGET_ARCH_WIN32
 #include <grp.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#define GLOBUS_L_GFS_FILE_AIO 1
 #endif
 
 #ifdef TARGET_ARCH_WIN32
@@ -113,10 +117,13 @@ typedef struct
     char *                              pw;
 } gfs_l_file_session_t;
 
+struct globus_l_gfs_file_bundle_s;
+struct globus_l_gfs_file_manifest_s;
+
 typedef struct
 {
     globus_mutex_t                      lock;
-    globus_memory_t                     mem;
+    globus_gfs_buffer_client_t          buffers;
     globus_priority_q_t                 queue;
     globus_list_t *                     buffer_list;
     globus_gfs_operation_t              op;
@@ -143,6 +150,29 @@ typedef struct
     gfs_l_file_session_t *              session;
 
     globus_result_t                     finish_result;
+
+    /* disk i/o through the aio threads when fd >= 0 */
+    int                                 fd;
+    int                                 queue_depth;
+    globus_fifo_t                       aio_order;
+    int                                 aio_ops;
+    int                                 aio_max_depth;
+    globus_off_t                        aio_usec;
+    globus_off_t                        aio_max_usec;
+
+    /* sends: blocks read ahead of the network wait in ready until fewer
+     * than write_limit writes are outstanding, and the kernel is asked to
+     * prefetch ra_window bytes ahead of the reads when ra_fd >= 0 */
+    globus_fifo_t                       ready;
+    int                                 write_limit;
+    int                                 ra_fd;
+    globus_off_t                        ra_window;
+    globus_off_t                        ra_offset;
+
+    /* set for bundle module transfers */
+    struct globus_l_gfs_file_bundle_s * bundle;
+    /* set for manifest module transfers */
+    struct globus_l_gfs_file_manifest_s * manifest;
 } globus_l_file_monitor_t;
 
 
@@ -180,6 +210,16 @@ globus_l_gfs_file_cksm(
     globus_l_gfs_file_cksm_cb_t         internal_cb,
     void *                              internal_cb_arg);
     
+static
+void
+globus_l_gfs_file_bundle_destroy(
+    struct globus_l_gfs_file_bundle_s * bundle);
+
+static
+void
+globus_l_gfs_file_manifest_destroy(
+    struct globus_l_gfs_file_manifest_s * manifest);
+
 static
 globus_result_t
 globus_l_gfs_file_make_stack(
@@ -307,7 +347,6 @@ globus_l_gfs_file_monitor_init(
 {
     globus_l_file_monitor_t *           monitor;
     globus_result_t                     result;
-    int                                 rc;
     GlobusGFSName(globus_l_gfs_file_monitor_init);
     GlobusGFSFileDebugEnter();
         
@@ -319,11 +358,13 @@ globus_l_gfs_file_monitor_init(
         goto error_alloc;
     }
        
-    rc = globus_memory_init(&monitor->mem, block_size, optimal_count);
-    if(!rc)
+    result = globus_gridftp_server_buffer_client_init(
+        &monitor->buffers, block_size);
+    if(result != GLOBUS_SUCCESS)
     {
         globus_free(monitor);
-        result = GlobusGFSErrorMemory("buffer");
+        result = GlobusGFSErrorWrapFailed(
+            "globus_gridftp_server_buffer_client_init", result);
         goto error_alloc;
     } 
     
@@ -347,6 +388,20 @@ globus_l_gfs_file_monitor_init(
     monitor->expected_cksm_alg = NULL;
     monitor->utime = -1;
     monitor->pathname = NULL;
+    monitor->fd = -1;
+    monitor->queue_depth = 0;
+    globus_fifo_init(&monitor->aio_order);
+    monitor->aio_ops = 0;
+    monitor->aio_max_depth = 0;
+    monitor->aio_usec = 0;
+    monitor->aio_max_usec = 0;
+    globus_fifo_init(&monitor->ready);
+    monitor->write_limit = optimal_count;
+    monitor->ra_fd = -1;
+    monitor->ra_window = 0;
+    monitor->ra_offset = 0;
+    monitor->bundle = NULL;
+    monitor->manifest = NULL;
 
     *u_monitor = monitor;
     
@@ -377,20 +432,51 @@ globus_l_gfs_file_monitor_destroy(
         {
             if(buf_info->buffer)
             {
-                globus_memory_push_node(&monitor->mem, buf_info->buffer);
+                globus_gridftp_server_buffer_put(monitor->buffers, buf_info->buffer);
             }
             globus_free(buf_info);
         }
     }
     
+    while(!globus_fifo_empty(&monitor->ready))
+    {
+        buf_info = (globus_l_buffer_info_t *)
+            globus_fifo_dequeue(&monitor->ready);
+        globus_gridftp_server_buffer_put(monitor->buffers, buf_info->buffer);
+        globus_free(buf_info);
+    }
+
     for(list = monitor->buffer_list;
         !globus_list_empty(list);
         list = globus_list_rest(list))
     {
         buffer = (globus_byte_t *) globus_list_first(list);
-        globus_memory_push_node(&monitor->mem, buffer);
+        globus_gridftp_server_buffer_put(monitor->buffers, buffer);
     }
     
+    if(monitor->bundle)
+    {
+        globus_l_gfs_file_bundle_destroy(monitor->bundle);
+    }
+    if(monitor->manifest)
+    {
+        globus_l_gfs_file_manifest_destroy(monitor->manifest);
+    }
+
+    if(monitor->aio_ops > 0)
+    {
+        globus_gfs_log_message(
+            GLOBUS_GFS_LOG_INFO,
+            "Disk queue for %s: %d ops, max depth %d, "
+            "avg latency %" GLOBUS_OFF_T_FORMAT " usec, "
+            "max latency %" GLOBUS_OFF_T_FORMAT " usec.\n",
+            monitor->pathname ? monitor->pathname : "(unknown)",
+            monitor->aio_ops,
+            monitor->aio_max_depth,
+            monitor->aio_usec / monitor->aio_ops,
+            monitor->aio_max_usec);
+    }
+
     if(monitor->pathname)
     {
         globus_free(monitor->pathname);
@@ -405,9 +491,11 @@ globus_l_gfs_file_monitor_destroy(
         globus_free(monitor->expected_cksm_alg);
     }
     
+    globus_fifo_destroy(&monitor->aio_order);
+    globus_fifo_destroy(&monitor->ready);
     globus_priority_q_destroy(&monitor->queue);
     globus_list_free(monitor->buffer_list);
-    globus_memory_destroy(&monitor->mem);
+    globus_gridftp_server_buffer_client_destroy(monitor->buffers);
     globus_mutex_destroy(&monitor->lock);
     globus_free(monitor);
 
@@ -535,6 +623,11 @@ globus_l_gfs_file_close_kickout(
 
     monitor = (globus_l_file_monitor_t *) arg;
 
+    /* the close may have been called locked from another thread, wait for
+     * it to unlock before destroying */
+    globus_mutex_lock(&monitor->lock);
+    globus_mutex_unlock(&monitor->lock);
+
     globus_gridftp_server_finished_transfer(
         monitor->op, monitor->finish_result);
 
@@ -583,6 +676,334 @@ globus_l_gfs_file_close(
     }
 }
 
+/**
+ * aio threads
+ *
+ * When file_queue_depth is set, transfers on the plain file driver read and
+ * write the file descriptor directly from a shared pool of i/o threads so
+ * that several blocks are on their way to the disk at once instead of one
+ * buffer at a time through xio.  Requests for a monitor are completed in the
+ * order they were issued.
+ */
+
+#define GLOBUS_L_GFS_FILE_AIO_MAX_THREADS 32
+#define GLOBUS_L_GFS_FILE_AIO_MAX_IOV 16
+
+struct globus_l_gfs_file_aio_req_s;
+
+typedef void
+(*globus_l_gfs_file_aio_cb_t)(
+    struct globus_l_gfs_file_aio_req_s * req);
+
+typedef struct globus_l_gfs_file_aio_req_s
+{
+    globus_l_file_monitor_t *           monitor;
+    globus_l_gfs_file_aio_cb_t          callback;
+    /* run instead of the read or write when set */
+    globus_l_gfs_file_aio_cb_t          run;
+    globus_bool_t                       write;
+    globus_bool_t                       done;
+    globus_off_t                        offset;
+    globus_size_t                       length;
+    globus_size_t                       nbytes;
+    int                                 err;
+    globus_abstime_t                    start_time;
+    globus_off_t                        usec;
+    int                                 iovc;
+    globus_byte_t *                     buffers[GLOBUS_L_GFS_FILE_AIO_MAX_IOV];
+    globus_size_t                       lengths[GLOBUS_L_GFS_FILE_AIO_MAX_IOV];
+} globus_l_gfs_file_aio_req_t;
+
+typedef struct
+{
+    globus_mutex_t                      lock;
+    globus_cond_t                       cond;
+    globus_fifo_t                       queue;
+    int                                 thread_count;
+    int                                 idle_count;
+    globus_bool_t                       shutdown;
+} globus_l_gfs_file_aio_pool_t;
+
+static globus_l_gfs_file_aio_pool_t     globus_l_gfs_file_aio_pool;
+
+#ifdef GLOBUS_L_GFS_FILE_AIO
+static
+void
+globus_l_gfs_file_aio_run(
+    globus_l_gfs_file_aio_req_t *       req)
+{
+    struct iovec                        iov[GLOBUS_L_GFS_FILE_AIO_MAX_IOV];
+    struct iovec *                      iov_p;
+    int                                 iovc;
+    int                                 fd;
+    int                                 i;
+    ssize_t                             rc = 0;
+#ifdef O_DIRECT
+    int                                 flags;
+#endif
+
+    fd = req->monitor->fd;
+    for(i = 0; i < req->iovc; i++)
+    {
+        iov[i].iov_base = req->buffers[i];
+        iov[i].iov_len = req->lengths[i];
+    }
+    iov_p = iov;
+    iovc = req->iovc;
+    req->nbytes = 0;
+
+    while(req->nbytes < req->length)
+    {
+        /* step past whatever the last call finished */
+        while(iovc > 0 && (size_t) rc >= iov_p->iov_len)
+        {
+            rc -= iov_p->iov_len;
+            iov_p++;
+            iovc--;
+        }
+        if(rc > 0)
+        {
+            iov_p->iov_base = (char *) iov_p->iov_base + rc;
+            iov_p->iov_len -= rc;
+        }
+
+        if(req->write)
+        {
+#ifdef HAVE_PWRITEV
+            rc = pwritev(fd, iov_p, iovc, req->offset + req->nbytes);
+#else
+            rc = pwrite(
+                fd, iov_p->iov_base, iov_p->iov_len,
+                req->offset + req->nbytes);
+#endif
+        }
+        else
+        {
+            rc = pread(
+                fd, iov_p->iov_base, iov_p->iov_len,
+                req->offset + req->nbytes);
+        }
+
+        if(rc < 0)
+        {
+            rc = 0;
+            if(errno == EINTR)
+            {
+                continue;
+            }
+#ifdef O_DIRECT
+            /* unaligned offset or tail, do the rest of the file buffered */
+            if(errno == EINVAL && (flags = fcntl(fd, F_GETFL)) != -1 &&
+                (flags & O_DIRECT) &&
+                fcntl(fd, F_SETFL, flags & ~O_DIRECT) == 0)
+            {
+                continue;
+            }
+#endif
+            req->err = errno;
+            break;
+        }
+        if(rc == 0)
+        {
+            /* eof on a read, and a write that can't make progress */
+            if(req->write)
+            {
+                req->err = EIO;
+            }
+            break;
+        }
+        req->nbytes += rc;
+    }
+}
+
+static
+void *
+globus_l_gfs_file_aio_thread(
+    void *                              user_arg)
+{
+    globus_l_gfs_file_aio_pool_t *      pool;
+    globus_l_gfs_file_aio_req_t *       req;
+    globus_abstime_t                    now;
+    globus_reltime_t                    elapsed;
+
+    pool = (globus_l_gfs_file_aio_pool_t *) user_arg;
+
+    globus_mutex_lock(&pool->lock);
+    while(!pool->shutdown)
+    {
+        if(globus_fifo_empty(&pool->queue))
+        {
+            pool->idle_count++;
+            globus_cond_wait(&pool->cond, &pool->lock);
+            pool->idle_count--;
+            continue;
+        }
+
+        req = (globus_l_gfs_file_aio_req_t *)
+            globus_fifo_dequeue(&pool->queue);
+        globus_mutex_unlock(&pool->lock);
+
+        if(req->run != NULL)
+        {
+            req->run(req);
+        }
+        else
+        {
+            globus_l_gfs_file_aio_run(req);
+        }
+
+        GlobusTimeAbstimeGetCurrent(now);
+        GlobusTimeAbstimeDiff(elapsed, now, req->start_time);
+        GlobusTimeReltimeToUSec(req->usec, elapsed);
+
+        req->callback(req);
+
+        globus_mutex_lock(&pool->lock);
+    }
+    pool->thread_count--;
+    globus_cond_broadcast(&pool->cond);
+    globus_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+#endif
+
+/* called locked.  hands a request to the aio threads, starting another
+ * thread if none are idle */
+static
+void
+globus_l_gfs_file_aio_submit(
+    globus_l_gfs_file_aio_req_t *       req)
+{
+    globus_l_gfs_file_aio_pool_t *      pool;
+    globus_l_file_monitor_t *           monitor;
+    globus_thread_t                     thread;
+    int                                 depth;
+
+    pool = &globus_l_gfs_file_aio_pool;
+    monitor = req->monitor;
+
+    req->done = GLOBUS_FALSE;
+    req->err = 0;
+    req->nbytes = 0;
+    GlobusTimeAbstimeGetCurrent(req->start_time);
+    globus_fifo_enqueue(&monitor->aio_order, req);
+
+    depth = globus_fifo_size(&monitor->aio_order);
+    if(depth > monitor->aio_max_depth)
+    {
+        monitor->aio_max_depth = depth;
+    }
+
+    globus_mutex_lock(&pool->lock);
+    {
+        globus_fifo_enqueue(&pool->queue, req);
+#ifdef GLOBUS_L_GFS_FILE_AIO
+        if(pool->idle_count == 0 &&
+            pool->thread_count < GLOBUS_L_GFS_FILE_AIO_MAX_THREADS &&
+            globus_thread_create(
+                &thread, NULL, globus_l_gfs_file_aio_thread, pool) == 0)
+        {
+            pool->thread_count++;
+        }
+#endif
+        globus_cond_signal(&pool->cond);
+    }
+    globus_mutex_unlock(&pool->lock);
+}
+
+/* called locked.  record the stats for a finished request */
+static
+void
+globus_l_gfs_file_aio_account(
+    globus_l_file_monitor_t *           monitor,
+    globus_l_gfs_file_aio_req_t *       req)
+{
+    monitor->aio_ops++;
+    monitor->aio_usec += req->usec;
+    if(req->usec > monitor->aio_max_usec)
+    {
+        monitor->aio_max_usec = req->usec;
+    }
+}
+
+#ifdef GLOBUS_L_GFS_FILE_AIO
+/* the descriptor of the open file, or -1 if anything but the file driver
+ * is on the disk stack */
+static
+int
+globus_l_gfs_file_get_fd(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_list_t *                     driver_list = NULL;
+    globus_xio_driver_list_ent_t *      ent;
+    globus_xio_system_file_t            fd;
+    globus_bool_t                       plain = GLOBUS_TRUE;
+    globus_result_t                     result;
+
+    globus_gfs_data_get_file_stack_list(monitor->op, &driver_list);
+    while(!globus_list_empty(driver_list))
+    {
+        ent = (globus_xio_driver_list_ent_t *)
+            globus_list_remove(&driver_list, driver_list);
+        if(strcmp(ent->driver_name, "file") != 0)
+        {
+            plain = GLOBUS_FALSE;
+        }
+    }
+    if(!plain)
+    {
+        return -1;
+    }
+
+    result = globus_xio_handle_cntl(
+        monitor->file_handle,
+        globus_l_gfs_file_driver,
+        GLOBUS_XIO_FILE_GET_HANDLE,
+        &fd);
+    if(result != GLOBUS_SUCCESS || fd < 0)
+    {
+        return -1;
+    }
+
+    return fd;
+}
+#endif
+
+/* use the aio threads for this transfer if file_queue_depth asks for them
+ * and nothing but the file driver is on the disk stack */
+static
+void
+globus_l_gfs_file_aio_attach(
+    globus_l_file_monitor_t *           monitor)
+{
+#ifdef GLOBUS_L_GFS_FILE_AIO
+    int                                 fd;
+    int                                 depth;
+    GlobusGFSName(globus_l_gfs_file_aio_attach);
+    GlobusGFSFileDebugEnter();
+
+    depth = globus_gfs_config_get_int("file_queue_depth");
+    if(depth <= 0 || globus_gfs_config_get_int("file_timeout") > 0 ||
+        globus_i_am_only_thread())
+    {
+        goto done;
+    }
+
+    fd = globus_l_gfs_file_get_fd(monitor);
+    if(fd < 0)
+    {
+        goto done;
+    }
+
+    monitor->fd = fd;
+    monitor->queue_depth = depth;
+
+done:
+    GlobusGFSFileDebugExit();
+#endif
+}
+
 /**
  * stat calls
  */
@@ -1377,115 +1798,617 @@ error:
     return result;
 }
 
+/**
+ * tree walks
+ *
+ * Recursive deletes and checksum manifests visit everything under a
+ * directory.  A bounded set of threads takes whole directories from a
+ * shared stack: each reads its directory once, handles the entries
+ * relative to the open directory with the *at() calls and pushes the
+ * subdirectories it finds back onto the stack in batches.  A directory is
+ * finished once every directory below it is, which is when a delete
+ * removes it.  Without threads the walk runs in the caller.
+ *
+ * A directory stays open until it is finished and everything below the top
+ * is opened and removed relative to its parent, so a directory swapped for
+ * a link while the walk runs is never followed out of the tree.
+ */
+
+/* threads per walk when file_queue_depth is not set */
+#define GLOBUS_L_GFS_FILE_WALK_THREADS 8
+/* subdirectories pushed onto the stack at a time */
+#define GLOBUS_L_GFS_FILE_WALK_BATCH 64
+
+struct globus_l_gfs_file_walk_s;
+
+typedef struct globus_l_gfs_file_walk_dir_s
+{
+    struct globus_l_gfs_file_walk_dir_s * parent;
+    char *                              path;
+    /* the last component of path */
+    const char *                        name;
+    /* open once the directory has been read, -1 before */
+    int                                 fd;
+    /* one until it has been read, plus one per unfinished subdirectory */
+    int                                 ref;
+} globus_l_gfs_file_walk_dir_t;
+
+/* called for every entry that isn't a directory.  type is the DT_ type */
+typedef globus_result_t
+(*globus_l_gfs_file_walk_entry_func_t)(
+    struct globus_l_gfs_file_walk_s *   walk,
+    globus_l_gfs_file_walk_dir_t *      dir,
+    int                                 dir_fd,
+    const char *                        name,
+    int                                 type,
+    globus_byte_t *                     scratch);
+
+/* called for every directory once everything below it is finished */
+typedef globus_result_t
+(*globus_l_gfs_file_walk_dir_func_t)(
+    struct globus_l_gfs_file_walk_s *   walk,
+    globus_l_gfs_file_walk_dir_t *      dir);
+
+/* called once by the last thread out, it must destroy the walk */
+typedef void
+(*globus_l_gfs_file_walk_done_func_t)(
+    struct globus_l_gfs_file_walk_s *   walk,
+    globus_result_t                     result);
+
+typedef struct globus_l_gfs_file_walk_s
+{
+    globus_mutex_t                      lock;
+    globus_cond_t                       cond;
+    globus_list_t *                     stack;
+    int                                 thread_count;
+    int                                 max_threads;
+    int                                 idle_count;
+    int                                 busy_count;
+    globus_object_t *                   error;
+    int                                 base_len;
+    globus_size_t                       scratch_size;
+    globus_l_gfs_file_walk_entry_func_t entry_func;
+    globus_l_gfs_file_walk_dir_func_t   dir_func;
+    globus_l_gfs_file_walk_done_func_t  done_func;
+    void *                              user_arg;
+    globus_off_t                        file_count;
+    globus_off_t                        dir_count;
+} globus_l_gfs_file_walk_t;
+
 static
 globus_result_t
-globus_l_gfs_file_delete_dir(
-    const char *                        pathname)
+globus_l_gfs_file_walk_init(
+    globus_l_gfs_file_walk_t **         u_walk,
+    const char *                        pathname,
+    globus_size_t                       scratch_size,
+    globus_l_gfs_file_walk_entry_func_t entry_func,
+    globus_l_gfs_file_walk_dir_func_t   dir_func,
+    globus_l_gfs_file_walk_done_func_t  done_func,
+    void *                              user_arg)
+{
+    globus_l_gfs_file_walk_t *          walk;
+    globus_l_gfs_file_walk_dir_t *      root;
+    int                                 depth;
+    GlobusGFSName(globus_l_gfs_file_walk_init);
+
+    walk = (globus_l_gfs_file_walk_t *)
+        globus_calloc(1, sizeof(globus_l_gfs_file_walk_t));
+    root = (globus_l_gfs_file_walk_dir_t *)
+        globus_calloc(1, sizeof(globus_l_gfs_file_walk_dir_t));
+    if(walk == NULL || root == NULL || 
+        (root->path = globus_libc_strdup(pathname)) == NULL)
+    {
+        if(root)
+        {
+            globus_free(root);
+        }
+        if(walk)
+        {
+            globus_free(walk);
+        }
+        return GlobusGFSErrorMemory("walk");
+    }
+    walk->base_len = strlen(root->path);
+    while(walk->base_len > 0 && root->path[walk->base_len - 1] == '/')
+    {
+        walk->base_len--;
+    }
+    if(walk->base_len > 0)
+    {
+        root->path[walk->base_len] = '\0';
+    }
+    else if(root->path[0] != '\0')
+    {
+        /* keep a lone "/" for the root */
+        root->path[1] = '\0';
+    }
+    root->name = root->path;
+    root->fd = -1;
+    root->ref = 1;
+    globus_list_insert(&walk->stack, root);
+
+    globus_mutex_init(&walk->lock, NULL);
+    globus_cond_init(&walk->cond, NULL);
+    depth = globus_gfs_config_get_int("file_queue_depth");
+    walk->max_threads = depth > 0 ? depth : GLOBUS_L_GFS_FILE_WALK_THREADS;
+    walk->scratch_size = scratch_size;
+    walk->entry_func = entry_func;
+    walk->dir_func = dir_func;
+    walk->done_func = done_func;
+    walk->user_arg = user_arg;
+
+    *u_walk = walk;
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+void
+globus_l_gfs_file_walk_destroy(
+    globus_l_gfs_file_walk_t *          walk)
 {
+    globus_assert(globus_list_empty(walk->stack));
 
-    globus_result_t                     result;
-    int                                 rc;
-    DIR *                               dir;
-    struct stat                         stat_buf;
-    struct dirent *                     dir_entry;
-    int                                 i;
-    char                                path[MAXPATHLEN];
-    GlobusGFSName(globus_l_gfs_file_delete_dir);
-    GlobusGFSFileDebugEnter();
-    
-    /* lstat is the same as stat when not operating on a link */
-    if(lstat(pathname, &stat_buf) != 0)
+    if(walk->error)
     {
-        result = GlobusGFSErrorSystemError("stat", errno);
-        goto error_stat;
+        globus_object_free(walk->error);
     }
-    
-    if(!S_ISDIR(stat_buf.st_mode))
+    globus_cond_destroy(&walk->cond);
+    globus_mutex_destroy(&walk->lock);
+    globus_free(walk);
+}
+
+/* the path of dir relative to the top of the walk, "" for the top */
+static
+const char *
+globus_l_gfs_file_walk_relative(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_l_gfs_file_walk_dir_t *      dir)
+{
+    return dir->parent ? dir->path + walk->base_len + 1 : "";
+}
+
+static
+void
+globus_l_gfs_file_walk_set_error(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_result_t                     result)
+{
+    globus_object_t *                   error;
+
+    error = globus_error_get(result);
+    globus_mutex_lock(&walk->lock);
     {
-        /* remove anything that isn't a dir -- don't follow links */
-        rc = unlink(pathname);       
-        if(rc != 0)
+        if(walk->error == NULL)
         {
-            result = GlobusGFSErrorSystemError("unlink", errno);
-            goto error_unlink1;
+            walk->error = error;
+            error = NULL;
         }
+        globus_cond_broadcast(&walk->cond);
     }
-    else
+    globus_mutex_unlock(&walk->lock);
+
+    if(error)
     {
-        dir = globus_libc_opendir(pathname);
-        if(!dir)
+        globus_object_free(error);
+    }
+}
+
+/* drop a reference to dir, finishing it and any parents left unreferenced */
+static
+void
+globus_l_gfs_file_walk_release(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_l_gfs_file_walk_dir_t *      dir)
+{
+    globus_l_gfs_file_walk_dir_t *      parent;
+    globus_result_t                     result;
+    globus_bool_t                       finished;
+    globus_bool_t                       failed;
+
+    while(dir != NULL)
+    {
+        globus_mutex_lock(&walk->lock);
         {
-            result = GlobusGFSErrorSystemError("opendir", errno);
-            goto error_open;
+            finished = --dir->ref == 0;
+            failed = walk->error != NULL;
         }
-        
-        for(i = 0;
-            globus_libc_readdir_r(dir, &dir_entry) == 0 && dir_entry;
-            i++)
-        {   
-            if(dir_entry->d_name[0] == '.' && 
-                (dir_entry->d_name[1] == '\0' || 
-                (dir_entry->d_name[1] == '.' && dir_entry->d_name[2] == '\0')))
-            {
-                globus_free(dir_entry);
-                continue;
+        globus_mutex_unlock(&walk->lock);
+
+        if(!finished)
+        {
+            break;
+        }
+        if(!failed && walk->dir_func != NULL)
+        {
+            result = walk->dir_func(walk, dir);
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_l_gfs_file_walk_set_error(walk, result);
             }
-            snprintf(path, sizeof(path), "%s/%s", pathname, dir_entry->d_name);
-            path[MAXPATHLEN - 1] = '\0';
-              
-            /* lstat is the same as stat when not operating on a link */
-            if(lstat(path, &stat_buf) != 0)
+        }
+        parent = dir->parent;
+        if(dir->fd >= 0)
+        {
+            close(dir->fd);
+        }
+        globus_free(dir->path);
+        globus_free(dir);
+        dir = parent;
+    }
+}
+
+static
+void *
+globus_l_gfs_file_walk_thread(
+    void *                              user_arg);
+
+/* hand a batch of subdirectories to the walk threads */
+static
+void
+globus_l_gfs_file_walk_push(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_list_t **                    batch)
+{
+    globus_l_gfs_file_walk_dir_t *      dir;
+    globus_thread_t                     thread;
+
+    globus_mutex_lock(&walk->lock);
+    {
+        while(!globus_list_empty(*batch))
+        {
+            dir = (globus_l_gfs_file_walk_dir_t *)
+                globus_list_remove(batch, *batch);
+            dir->parent->ref++;
+            globus_list_insert(&walk->stack, dir);
+            walk->dir_count++;
+        }
+        if(walk->idle_count == 0 &&
+            walk->thread_count < walk->max_threads &&
+            !globus_i_am_only_thread() &&
+            globus_thread_create(
+                &thread, NULL, globus_l_gfs_file_walk_thread, walk) == 0)
+        {
+            walk->thread_count++;
+        }
+        globus_cond_broadcast(&walk->cond);
+    }
+    globus_mutex_unlock(&walk->lock);
+}
+
+/* read one directory, handling its entries and pushing its subdirectories */
+static
+void
+globus_l_gfs_file_walk_read(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_l_gfs_file_walk_dir_t *      dir,
+    globus_byte_t *                     scratch)
+{
+    globus_l_gfs_file_walk_dir_t *      sub;
+    globus_list_t *                     batch = NULL;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    struct dirent *                     dir_entry;
+    struct stat                         stat_buf;
+    DIR *                               dir_h;
+    int                                 batch_count = 0;
+    int                                 file_count = 0;
+    int                                 type;
+    int                                 fd;
+    int                                 read_fd;
+    GlobusGFSName(globus_l_gfs_file_walk_read);
+    GlobusGFSFileDebugEnter();
+
+    /* links are followed only at the top, below it the parent is open */
+    if(dir->parent == NULL)
+    {
+        fd = open(dir->path, O_RDONLY | O_DIRECTORY);
+    }
+    else
+    {
+        fd = openat(dir->parent->fd, dir->name,
+            O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+    }
+    if(fd < 0)
+    {
+        /* removed since it was listed */
+        if(errno != ENOENT || dir->parent == NULL)
+        {
+            result = GlobusGFSErrorSystemError("open", errno);
+        }
+        goto error_open;
+    }
+    /* the stream gets its own fd, fd stays open for the subdirectories */
+    read_fd = dup(fd);
+    if(read_fd < 0)
+    {
+        result = GlobusGFSErrorSystemError("dup", errno);
+        close(fd);
+        goto error_open;
+    }
+    dir_h = fdopendir(read_fd);
+    if(dir_h == NULL)
+    {
+        result = GlobusGFSErrorSystemError("opendir", errno);
+        close(read_fd);
+        close(fd);
+        goto error_open;
+    }
+    dir->fd = fd;
+
+    while((dir_entry = readdir(dir_h)) != NULL)
+    {
+        if(dir_entry->d_name[0] == '.' &&
+            (dir_entry->d_name[1] == '\0' ||
+            (dir_entry->d_name[1] == '.' && dir_entry->d_name[2] == '\0')))
+        {
+            continue;
+        }
+
+        type = dir_entry->d_type;
+        if(type == DT_UNKNOWN)
+        {
+            if(fstatat(fd, dir_entry->d_name, 
+                &stat_buf, AT_SYMLINK_NOFOLLOW) != 0)
             {
-                result = GlobusGFSErrorSystemError("lstat", errno);
-                globus_free(dir_entry);
                 /* just skip invalid entries */
                 continue;
             }
-            
-            if(!S_ISDIR(stat_buf.st_mode))
+            type = IFTODT(stat_buf.st_mode);
+        }
+
+        if(type == DT_DIR)
+        {
+            sub = (globus_l_gfs_file_walk_dir_t *)
+                globus_calloc(1, sizeof(globus_l_gfs_file_walk_dir_t));
+            if(sub == NULL)
             {
-                /* remove anything that isn't a dir -- don't follow links */
-                rc = unlink(path);       
-                if(rc != 0)
-                {
-                    result = GlobusGFSErrorSystemError("unlink", errno);
-                    goto error_unlink2;
-                }
+                result = GlobusGFSErrorMemory("walk");
+                break;
             }
-            else
+            sub->parent = dir;
+            sub->fd = -1;
+            sub->ref = 1;
+            sub->path = globus_common_create_string(
+                "%s/%s", dir->path[1] ? dir->path : "", dir_entry->d_name);
+            if(sub->path == NULL)
             {
-                result = globus_l_gfs_file_delete_dir(path);
-                if(result != GLOBUS_SUCCESS)
+                globus_free(sub);
+                result = GlobusGFSErrorMemory("walk");
+                break;
+            }
+            sub->name = sub->path + strlen(sub->path) - 
+                strlen(dir_entry->d_name);
+            globus_list_insert(&batch, sub);
+            if(++batch_count == GLOBUS_L_GFS_FILE_WALK_BATCH)
+            {
+                globus_l_gfs_file_walk_push(walk, &batch);
+                batch_count = 0;
+                if(walk->error != NULL)
                 {
-                    goto error_recurse;
+                    break;
                 }
             }
+        }
+        else
+        {
+            result = walk->entry_func(
+                walk, dir, fd, dir_entry->d_name, type, scratch);
+            if(result != GLOBUS_SUCCESS)
+            {
+                break;
+            }
+            file_count++;
+        }
+    }
+    closedir(dir_h);
 
-            globus_free(dir_entry);
+    globus_mutex_lock(&walk->lock);
+    {
+        walk->file_count += file_count;
+    }
+    globus_mutex_unlock(&walk->lock);
+
+    if(!globus_list_empty(batch))
+    {
+        globus_l_gfs_file_walk_push(walk, &batch);
+    }
+
+error_open:
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_l_gfs_file_walk_set_error(walk, result);
+        GlobusGFSFileDebugExitWithError();
+        return;
+    }
+    GlobusGFSFileDebugExit();
+}
+
+static
+void *
+globus_l_gfs_file_walk_thread(
+    void *                              user_arg)
+{
+    globus_l_gfs_file_walk_t *          walk;
+    globus_l_gfs_file_walk_dir_t *      dir;
+    globus_byte_t *                     scratch = NULL;
+    globus_result_t                     result;
+    globus_bool_t                       failed;
+    globus_bool_t                       last;
+    GlobusGFSName(globus_l_gfs_file_walk_thread);
+
+    walk = (globus_l_gfs_file_walk_t *) user_arg;
+
+    if(walk->scratch_size > 0)
+    {
+        scratch = globus_malloc(walk->scratch_size);
+        if(scratch == NULL)
+        {
+            globus_l_gfs_file_walk_set_error(
+                walk, GlobusGFSErrorMemory("scratch"));
         }
+    }
 
-        closedir(dir);
-        rc = rmdir(pathname);
-        if(rc != 0)
+    globus_mutex_lock(&walk->lock);
+    for(;;)
+    {
+        if(globus_list_empty(walk->stack))
         {
-            result = GlobusGFSErrorSystemError("rmdir", errno);
-            goto error_rmdir;
+            if(walk->busy_count == 0)
+            {
+                break;
+            }
+            walk->idle_count++;
+            globus_cond_wait(&walk->cond, &walk->lock);
+            walk->idle_count--;
+            continue;
         }
-    } 
-    
-    GlobusGFSFileDebugExit();
+
+        dir = (globus_l_gfs_file_walk_dir_t *)
+            globus_list_remove(&walk->stack, walk->stack);
+        walk->busy_count++;
+        /* after an error what is left is just released */
+        failed = walk->error != NULL || 
+            (walk->scratch_size > 0 && scratch == NULL);
+        globus_mutex_unlock(&walk->lock);
+
+        if(!failed)
+        {
+            globus_l_gfs_file_walk_read(walk, dir, scratch);
+        }
+        globus_l_gfs_file_walk_release(walk, dir);
+
+        globus_mutex_lock(&walk->lock);
+        walk->busy_count--;
+        if(walk->busy_count == 0 && globus_list_empty(walk->stack))
+        {
+            globus_cond_broadcast(&walk->cond);
+        }
+    }
+    last = --walk->thread_count == 0;
+    globus_mutex_unlock(&walk->lock);
+
+    if(scratch)
+    {
+        globus_free(scratch);
+    }
+
+    if(last)
+    {
+        result = GLOBUS_SUCCESS;
+        if(walk->error != NULL)
+        {
+            result = globus_error_put(walk->error);
+            walk->error = NULL;
+        }
+        walk->done_func(walk, result);
+    }
+
+    return NULL;
+}
+
+/* start the walk on its own thread, or run all of it here without threads.
+ * the done func may be called before this returns */
+static
+void
+globus_l_gfs_file_walk_start(
+    globus_l_gfs_file_walk_t *          walk)
+{
+    globus_thread_t                     thread;
+
+    walk->thread_count = 1;
+    if(globus_i_am_only_thread() ||
+        globus_thread_create(
+            &thread, NULL, globus_l_gfs_file_walk_thread, walk) != 0)
+    {
+        globus_l_gfs_file_walk_thread(walk);
+    }
+}
+
+/*
+ * recursive delete
+ */
+
+static
+globus_result_t
+globus_l_gfs_file_delete_entry(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_l_gfs_file_walk_dir_t *      dir,
+    int                                 dir_fd,
+    const char *                        name,
+    int                                 type,
+    globus_byte_t *                     scratch)
+{
+    GlobusGFSName(globus_l_gfs_file_delete_entry);
+
+    /* remove anything that isn't a dir -- don't follow links */
+    if(unlinkat(dir_fd, name, 0) != 0 && errno != ENOENT)
+    {
+        return GlobusGFSErrorSystemError("unlink", errno);
+    }
+
     return GLOBUS_SUCCESS;
+}
 
-error_recurse:
-error_unlink2:
-        closedir(dir);
-        globus_free(dir_entry);
-error_open: 
-error_stat:
-error_unlink1:
-error_rmdir:    
-    GlobusGFSFileDebugExitWithError();
-    return result; 
+static
+globus_result_t
+globus_l_gfs_file_delete_rmdir(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_l_gfs_file_walk_dir_t *      dir)
+{
+    int                                 rc;
+    GlobusGFSName(globus_l_gfs_file_delete_rmdir);
+
+    if(dir->fd >= 0)
+    {
+        close(dir->fd);
+        dir->fd = -1;
+    }
+    if(dir->parent == NULL)
+    {
+        rc = rmdir(dir->path);
+    }
+    else
+    {
+        rc = unlinkat(dir->parent->fd, dir->name, AT_REMOVEDIR);
+    }
+    if(rc != 0 && (errno != ENOENT || dir->parent == NULL))
+    {
+        return GlobusGFSErrorSystemError("rmdir", errno);
+    }
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+void
+globus_l_gfs_file_delete_done(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_result_t                     result)
+{
+    globus_gfs_operation_t              op;
+    GlobusGFSName(globus_l_gfs_file_delete_done);
+    GlobusGFSFileDebugEnter();
+
+    op = (globus_gfs_operation_t) walk->user_arg;
+
+    globus_gfs_log_message(
+        GLOBUS_GFS_LOG_INFO,
+        "Recursive delete: %" GLOBUS_OFF_T_FORMAT " files, "
+        "%" GLOBUS_OFF_T_FORMAT " directories, %d threads.\n",
+        walk->file_count, walk->dir_count + 1, walk->max_threads);
+
+    globus_l_gfs_file_walk_destroy(walk);
+
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed("recursion", result);
+        globus_gridftp_server_finished_command(op, result, NULL);
+        GlobusGFSFileDebugExitWithError();
+        return;
+    }
+    globus_gridftp_server_finished_command(op, GLOBUS_SUCCESS, NULL);
+
+    GlobusGFSFileDebugExit();
 }
     
 static
@@ -1497,9 +2420,23 @@ globus_l_gfs_file_delete(
 {
     int                                 rc;
     globus_result_t                     result;
+    struct stat                         stat_buf;
+    globus_l_gfs_file_walk_t *          walk;
     GlobusGFSName(globus_l_gfs_file_delete);
     GlobusGFSFileDebugEnter();
 
+    if(recurse)
+    {
+        /* lstat is the same as stat when not operating on a link */
+        if(lstat(pathname, &stat_buf) != 0)
+        {
+            result = GlobusGFSErrorSystemError("stat", errno);
+            result = GlobusGFSErrorWrapFailed("recursion", result);
+            goto error;
+        }
+        recurse = S_ISDIR(stat_buf.st_mode);
+    }
+
     if(!recurse)
     {
         rc = unlink(pathname);
@@ -1511,12 +2448,25 @@ globus_l_gfs_file_delete(
     }
     else
     {
-        result = globus_l_gfs_file_delete_dir(pathname);
+        result = globus_l_gfs_file_walk_init(
+            &walk,
+            pathname,
+            0,
+            globus_l_gfs_file_delete_entry,
+            globus_l_gfs_file_delete_rmdir,
+            globus_l_gfs_file_delete_done,
+            op);
         if(result != GLOBUS_SUCCESS)
         {
             result = GlobusGFSErrorWrapFailed("recursion", result);
             goto error;
         }
+
+        /* finished when the walk is done */
+        globus_l_gfs_file_walk_start(walk);
+
+        GlobusGFSFileDebugExit();
+        return GLOBUS_SUCCESS;
     }
     
     globus_gridftp_server_finished_command(op, GLOBUS_SUCCESS, NULL);
@@ -2335,7 +3285,7 @@ globus_l_gfs_file_write_cb(
         }
         else
         {
-            globus_memory_push_node(&monitor->mem, buffer);
+            globus_gridftp_server_buffer_put(monitor->buffers, buffer);
         }
         
         result = globus_l_gfs_file_dispatch_write(monitor);
@@ -2364,7 +3314,7 @@ globus_l_gfs_file_write_cb(
     return;
 
 error:
-    globus_memory_push_node(&monitor->mem, buffer);
+    globus_gridftp_server_buffer_put(monitor->buffers, buffer);
 error_dispatch:
     if(monitor->pending_reads != 0 || monitor->pending_writes != 0)
     {
@@ -2381,51 +3331,215 @@ error_dispatch:
     GlobusGFSFileDebugExitWithError();
 }
 
-/* Called LOCKED */
 static
-globus_result_t
-globus_l_gfs_file_dispatch_write(
-    globus_l_file_monitor_t *           monitor)
+void
+globus_l_gfs_file_aio_write_cb(
+    globus_l_gfs_file_aio_req_t *       req)
 {
-    globus_l_buffer_info_t *            buf_info;
+    globus_l_file_monitor_t *           monitor;
     globus_result_t                     result;
-    GlobusGFSName(globus_l_gfs_file_dispatch_write);
+    int                                 i;
+    GlobusGFSName(globus_l_gfs_file_aio_write_cb);
     GlobusGFSFileDebugEnter();
-    
-    if(monitor->pending_writes == 0 && !monitor->aborted)
+
+    monitor = req->monitor;
+
+    globus_mutex_lock(&monitor->lock);
     {
-        buf_info = (globus_l_buffer_info_t *)
-            globus_priority_q_dequeue(&monitor->queue);
-        if(buf_info)
+        globus_fifo_remove(&monitor->aio_order, req);
+        globus_l_gfs_file_aio_account(monitor, req);
+        monitor->pending_writes--;
+        if(req->nbytes > 0)
         {
-            if(buf_info->offset != monitor->file_offset)
-            { 
-                globus_off_t            seek_tmp;
+            globus_gridftp_server_update_bytes_written(
+                monitor->op,
+                req->offset,
+                req->nbytes);
+        }
 
-                monitor->file_offset = buf_info->offset;
-                seek_tmp = monitor->file_offset;
+        if(req->err != 0 && monitor->error == NULL)
+        {
+            monitor->error = GlobusGFSErrorObjSystemError(
+                "pwrite", req->err);
+        }
 
-                result = globus_xio_handle_cntl(
-                    monitor->file_handle,
-                    GLOBUS_XIO_QUERY,
-                    GLOBUS_XIO_SEEK,
-                    seek_tmp,
-                    GLOBUS_XIO_FILE_SEEK_SET);
-                if(result != GLOBUS_SUCCESS)
-                {
-                    result = GlobusGFSErrorWrapFailed(
-                        "globus_xio_handle_cntl", result);
-                    goto error_seek;
-                }
+        for(i = 0; i < req->iovc; i++)
+        {
+            if(monitor->error != NULL || monitor->eof)
+            {
+                globus_gridftp_server_buffer_put(
+                    monitor->buffers, req->buffers[i]);
+                continue;
             }
-            
-            result = globus_xio_register_write(
-                monitor->file_handle,
-                buf_info->buffer,
-                buf_info->length,
-                buf_info->length,
-                NULL,
-                globus_l_gfs_file_write_cb,
+
+            result = globus_gridftp_server_register_read(
+                monitor->op,
+                req->buffers[i],
+                monitor->block_size,
+                globus_l_gfs_file_server_read_cb,
+                monitor);
+            if(result != GLOBUS_SUCCESS)
+            {
+                monitor->error = GlobusGFSErrorObjWrapFailed(
+                    "globus_gridftp_server_register_read", result);
+                globus_gridftp_server_buffer_put(
+                    monitor->buffers, req->buffers[i]);
+                continue;
+            }
+
+            monitor->pending_reads++;
+        }
+        if(monitor->error != NULL)
+        {
+            goto error;
+        }
+
+        result = globus_l_gfs_file_dispatch_write(monitor);
+        if(result != GLOBUS_SUCCESS)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed(
+                "globus_l_gfs_file_dispatch_write", result);
+            goto error;
+        }
+
+        if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
+        {
+            globus_assert(monitor->eof || monitor->aborted);
+
+            globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
+        }
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    globus_free(req);
+
+    GlobusGFSFileDebugExit();
+    return;
+
+error:
+    if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
+    {
+        globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
+    }
+    /* otherwise the outstanding callbacks finish up */
+    globus_mutex_unlock(&monitor->lock);
+
+    globus_free(req);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
+/* Called LOCKED.  keep up to queue_depth writes with the aio threads,
+ * merging blocks that pick up where the previous one ended */
+static
+globus_result_t
+globus_l_gfs_file_aio_dispatch_write(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_l_gfs_file_aio_req_t *       req;
+    globus_l_buffer_info_t *            buf_info;
+    globus_result_t                     result;
+    GlobusGFSName(globus_l_gfs_file_aio_dispatch_write);
+    GlobusGFSFileDebugEnter();
+
+    while(monitor->pending_writes < monitor->queue_depth &&
+        !monitor->aborted && !globus_priority_q_empty(&monitor->queue))
+    {
+        req = (globus_l_gfs_file_aio_req_t *)
+            globus_calloc(1, sizeof(globus_l_gfs_file_aio_req_t));
+        if(req == NULL)
+        {
+            result = GlobusGFSErrorMemory("req");
+            goto error_alloc;
+        }
+        req->monitor = monitor;
+        req->callback = globus_l_gfs_file_aio_write_cb;
+        req->write = GLOBUS_TRUE;
+
+        do
+        {
+            buf_info = (globus_l_buffer_info_t *)
+                globus_priority_q_dequeue(&monitor->queue);
+            if(req->iovc == 0)
+            {
+                req->offset = buf_info->offset;
+            }
+            req->buffers[req->iovc] = buf_info->buffer;
+            req->lengths[req->iovc] = buf_info->length;
+            req->length += buf_info->length;
+            req->iovc++;
+            globus_free(buf_info);
+
+            buf_info = (globus_l_buffer_info_t *)
+                globus_priority_q_first(&monitor->queue);
+        } while(buf_info != NULL &&
+            req->iovc < GLOBUS_L_GFS_FILE_AIO_MAX_IOV &&
+            buf_info->offset == req->offset + req->length);
+
+        monitor->pending_writes++;
+        globus_l_gfs_file_aio_submit(req);
+    }
+
+    GlobusGFSFileDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_alloc:
+    GlobusGFSFileDebugExitWithError();
+    return result;
+}
+
+/* Called LOCKED */
+static
+globus_result_t
+globus_l_gfs_file_dispatch_write(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_l_buffer_info_t *            buf_info;
+    globus_result_t                     result;
+    GlobusGFSName(globus_l_gfs_file_dispatch_write);
+    GlobusGFSFileDebugEnter();
+    
+    if(monitor->fd >= 0)
+    {
+        result = globus_l_gfs_file_aio_dispatch_write(monitor);
+        GlobusGFSFileDebugExit();
+        return result;
+    }
+
+    if(monitor->pending_writes == 0 && !monitor->aborted)
+    {
+        buf_info = (globus_l_buffer_info_t *)
+            globus_priority_q_dequeue(&monitor->queue);
+        if(buf_info)
+        {
+            if(buf_info->offset != monitor->file_offset)
+            { 
+                globus_off_t            seek_tmp;
+
+                monitor->file_offset = buf_info->offset;
+                seek_tmp = monitor->file_offset;
+
+                result = globus_xio_handle_cntl(
+                    monitor->file_handle,
+                    GLOBUS_XIO_QUERY,
+                    GLOBUS_XIO_SEEK,
+                    seek_tmp,
+                    GLOBUS_XIO_FILE_SEEK_SET);
+                if(result != GLOBUS_SUCCESS)
+                {
+                    result = GlobusGFSErrorWrapFailed(
+                        "globus_xio_handle_cntl", result);
+                    goto error_seek;
+                }
+            }
+            
+            result = globus_xio_register_write(
+                monitor->file_handle,
+                buf_info->buffer,
+                buf_info->length,
+                buf_info->length,
+                NULL,
+                globus_l_gfs_file_write_cb,
                 monitor);
             if(result != GLOBUS_SUCCESS)
             {
@@ -2447,7 +3561,7 @@ error_register:
 error_seek:
     if(buf_info->buffer)
     {
-        globus_memory_push_node(&monitor->mem, buf_info->buffer);
+        globus_gridftp_server_buffer_put(monitor->buffers, buf_info->buffer);
     }
     globus_free(buf_info);
 
@@ -2480,12 +3594,20 @@ globus_l_gfs_file_update_concurrency(
             monitor->op, &optimal_count);
         extra = optimal_count - monitor->optimal_count;
             
-        monitor->optimal_count = optimal_count;
+        if(extra <= 0)
+        {
+            monitor->optimal_count = optimal_count;
+        }
         while(extra-- > 0)
         {
             globus_byte_t *             buffer;
             
-            buffer = globus_memory_pop_node(&monitor->mem);
+            /* out of budget, try again at the next check */
+            buffer = globus_gridftp_server_buffer_get(monitor->buffers);
+            if(buffer == NULL)
+            {
+                break;
+            }
             result = globus_gridftp_server_register_read(
                 monitor->op,
                 buffer,
@@ -2494,13 +3616,14 @@ globus_l_gfs_file_update_concurrency(
                 monitor);
             if(result != GLOBUS_SUCCESS)
             {
-                globus_memory_push_node(&monitor->mem, buffer);
+                globus_gridftp_server_buffer_put(monitor->buffers, buffer);
                 result = GlobusGFSErrorWrapFailed(
                     "globus_gridftp_server_register_read", result);
                 goto error_register;
             }
             
             monitor->pending_reads++;
+            monitor->optimal_count++;
         }
     }
     
@@ -2597,7 +3720,7 @@ error_dispatch:
     
 error_alloc:
 error:
-    globus_memory_push_node(&monitor->mem, buffer);
+    globus_gridftp_server_buffer_put(monitor->buffers, buffer);
     if(monitor->pending_reads != 0 || monitor->pending_writes != 0)
     {
         /* there are still outstanding callbacks, wait for them */
@@ -2634,6 +3757,7 @@ globus_l_gfs_file_open_write_cb(
 
     globus_gridftp_server_begin_transfer(
         monitor->op, GLOBUS_GFS_EVENT_TRANSFER_ABORT, monitor);
+    globus_l_gfs_file_aio_attach(monitor);
     
     globus_mutex_lock(&monitor->lock);
     {
@@ -2646,7 +3770,18 @@ globus_l_gfs_file_open_write_cb(
         {
             globus_byte_t *             buffer;
             
-            buffer = globus_memory_pop_node(&monitor->mem);
+            buffer = globus_gridftp_server_buffer_get(monitor->buffers);
+            if(buffer == NULL)
+            {
+                if(monitor->pending_reads > 0)
+                {
+                    /* run with what the budget allows */
+                    monitor->optimal_count = monitor->pending_reads;
+                    break;
+                }
+                result = GlobusGFSErrorMemory("buffer");
+                goto error_register;
+            }
             result = globus_gridftp_server_register_read(
                 monitor->op,
                 buffer,
@@ -2655,7 +3790,7 @@ globus_l_gfs_file_open_write_cb(
                 monitor);
             if(result != GLOBUS_SUCCESS)
             {
-                globus_memory_push_node(&monitor->mem, buffer);
+                globus_gridftp_server_buffer_put(monitor->buffers, buffer);
                 result = GlobusGFSErrorWrapFailed(
                     "globus_gridftp_server_register_read", result);
                 goto error_register;
@@ -2954,131 +4089,218 @@ globus_l_gfs_file_read_cb(
     globus_xio_data_descriptor_t        data_desc,
     void *                              user_arg);
     
-/* called LOCKED */
+static
+void
+globus_l_gfs_file_server_write_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    void *                              user_arg);
+
 static
 globus_result_t
 globus_l_gfs_file_dispatch_read(
+    globus_l_file_monitor_t *           monitor);
+
+/**
+ * read ahead
+ *
+ * With file_readahead set a send gets that many bytes of extra buffers, so
+ * disk reads can run ahead of the network while the number of writes
+ * outstanding on the data channel stays at the network's own concurrency.
+ * On the plain file driver the kernel is also asked to prefetch that far
+ * past the current read.
+ */
+
+static
+void
+globus_l_gfs_file_readahead_attach(
     globus_l_file_monitor_t *           monitor)
 {
-    globus_result_t                     result;
-    globus_byte_t *                     buffer;
-    globus_size_t                       read_length;
-    GlobusGFSName(globus_l_gfs_file_dispatch_read);
-    GlobusGFSFileDebugEnter();
-    
-    if(monitor->first_read && monitor->pending_reads == 0 && 
-        !monitor->eof && !globus_list_empty(monitor->buffer_list) &&
-        !monitor->aborted)
-    {
-        globus_gridftp_server_get_read_range(
-            monitor->op,
-            &monitor->read_offset,
-            &monitor->read_length);
-        if(monitor->read_length == 0)
-        {
-            monitor->eof = GLOBUS_TRUE;
-        }
-        else
-        {                                        
-            if (monitor->file_offset != monitor->read_offset)
-            {
-                globus_off_t            seek_tmp;
-                seek_tmp = monitor->read_offset;
-                
-                result = globus_xio_handle_cntl(
-                    monitor->file_handle,
-                    GLOBUS_XIO_QUERY,
-                    GLOBUS_XIO_SEEK,
-                    seek_tmp,
-                    GLOBUS_XIO_FILE_SEEK_SET);
-            
-                if(result != GLOBUS_SUCCESS)
-                {
-                    result = GlobusGFSErrorWrapFailed(
-                        "globus_xio_handle_cntl", result);
-                    goto error_seek;
-                }
-                monitor->file_offset = monitor->read_offset;
-            }
-            
-        }
-        monitor->first_read = GLOBUS_FALSE;
-    }             
+#if defined(GLOBUS_L_GFS_FILE_AIO) && defined(HAVE_POSIX_FADVISE)
+    int                                 window;
+    int                                 fd;
 
-    if(monitor->pending_reads == 0 && !monitor->eof && 
-        !globus_list_empty(monitor->buffer_list) && !monitor->aborted)
+    window = globus_gfs_config_get_int("file_readahead");
+    if(window <= 0)
     {
-        buffer = globus_list_remove(
-            &monitor->buffer_list, monitor->buffer_list);
-        globus_assert(buffer);
-             
-        if(monitor->read_length != -1 && 
-            monitor->block_size > monitor->read_length)
-        {
-            read_length = monitor->read_length;
-        }
-        else
-        {
-            read_length = monitor->block_size;
-        }
-        
-        result = globus_xio_register_read(
-            monitor->file_handle,
-            buffer,
-            read_length,
-            read_length,
-            NULL,
-            globus_l_gfs_file_read_cb,
-            monitor);
-        if(result != GLOBUS_SUCCESS)
-        {
-            globus_list_insert(&monitor->buffer_list, buffer);
-            result = GlobusGFSErrorWrapFailed(
-                "globus_xio_register_read", result);
-            goto error_register;
-        }
-        
-        monitor->pending_reads++;
+        return;
+    }
+    fd = monitor->fd >= 0 ? monitor->fd : globus_l_gfs_file_get_fd(monitor);
+    if(fd < 0)
+    {
+        return;
     }
-    
-    GlobusGFSFileDebugExit();
-    return GLOBUS_SUCCESS;
 
-error_seek:
-error_register:
-    GlobusGFSFileDebugExitWithError();
-    return result;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    monitor->ra_fd = fd;
+    monitor->ra_window = window;
+    monitor->ra_offset = 0;
+#endif
 }
 
+/* called LOCKED after reads are dispatched.  file_offset is where the next
+ * read starts and read_length what is left of the current range */
 static
 void
-globus_l_gfs_file_server_write_cb(
-    globus_gfs_operation_t   op,
-    globus_result_t                     result,
-    globus_byte_t *                     buffer,
-    globus_size_t                       nbytes,
-    void *                              user_arg)
+globus_l_gfs_file_readahead(
+    globus_l_file_monitor_t *           monitor)
 {
-    globus_l_file_monitor_t *           monitor;
-    GlobusGFSName(globus_l_gfs_file_server_write_cb);
-    GlobusGFSFileDebugEnter();
-    
-    monitor = (globus_l_file_monitor_t *) user_arg;
-    
-    globus_mutex_lock(&monitor->lock);
-    { 
-        monitor->pending_writes--;
-        globus_list_insert(&monitor->buffer_list, buffer);
+#if defined(GLOBUS_L_GFS_FILE_AIO) && defined(HAVE_POSIX_FADVISE)
+    globus_off_t                        end;
+    globus_off_t                        step;
 
-        if(result != GLOBUS_SUCCESS && monitor->error == NULL)
+    if(monitor->ra_fd < 0 || monitor->eof || monitor->aborted)
+    {
+        return;
+    }
+
+    /* a new range, possibly behind the last one */
+    if(monitor->ra_offset < monitor->file_offset ||
+        monitor->ra_offset > monitor->file_offset + monitor->ra_window)
+    {
+        monitor->ra_offset = monitor->file_offset;
+    }
+
+    end = monitor->file_offset + monitor->ra_window;
+    if(monitor->read_length != -1 &&
+        end > monitor->file_offset + monitor->read_length)
+    {
+        end = monitor->file_offset + monitor->read_length;
+        step = 1;
+    }
+    else
+    {
+        /* a hint per quarter window rather than per block */
+        step = monitor->ra_window / 4;
+        if(step < (globus_off_t) monitor->block_size)
         {
-            monitor->error = GlobusGFSErrorObjWrapFailed("callback", result);
+            step = monitor->block_size;
+        }
+    }
+
+    if(end - monitor->ra_offset >= step)
+    {
+        posix_fadvise(
+            monitor->ra_fd,
+            monitor->ra_offset,
+            end - monitor->ra_offset,
+            POSIX_FADV_WILLNEED);
+        monitor->ra_offset = end;
+    }
+#endif
+}
+
+/* called LOCKED.  write a block read from the file to the network, or hold
+ * it if write_limit writes are already outstanding */
+static
+globus_result_t
+globus_l_gfs_file_send_buffer(
+    globus_l_file_monitor_t *           monitor,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    globus_off_t                        offset)
+{
+    globus_l_buffer_info_t *            buf_info;
+    globus_result_t                     result;
+    GlobusGFSName(globus_l_gfs_file_send_buffer);
+
+    if(monitor->pending_writes >= monitor->write_limit)
+    {
+        buf_info = (globus_l_buffer_info_t *)
+            globus_malloc(sizeof(globus_l_buffer_info_t));
+        if(buf_info == NULL)
+        {
+            return GlobusGFSErrorMemory("buf_info");
+        }
+        buf_info->buffer = buffer;
+        buf_info->offset = offset;
+        buf_info->length = nbytes;
+        globus_fifo_enqueue(&monitor->ready, buf_info);
+        return GLOBUS_SUCCESS;
+    }
+
+    result = globus_gridftp_server_register_write(
+        monitor->op,
+        buffer,
+        nbytes,
+        offset,
+        -1,
+        globus_l_gfs_file_server_write_cb,
+        monitor);
+    if(result != GLOBUS_SUCCESS)
+    {
+        return GlobusGFSErrorWrapFailed(
+            "globus_gridftp_server_register_write", result);
+    }
+    monitor->pending_writes++;
+
+    return GLOBUS_SUCCESS;
+}
+
+/* reads may finish out of order, but are handed to the network in the
+ * order they were issued so stream mode sees the file in sequence */
+static
+void
+globus_l_gfs_file_aio_read_cb(
+    globus_l_gfs_file_aio_req_t *       req)
+{
+    globus_l_file_monitor_t *           monitor;
+    globus_result_t                     result;
+    globus_byte_t *                     buffer;
+    GlobusGFSName(globus_l_gfs_file_aio_read_cb);
+    GlobusGFSFileDebugEnter();
+
+    monitor = req->monitor;
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        req->done = GLOBUS_TRUE;
+        while(!globus_fifo_empty(&monitor->aio_order))
+        {
+            req = (globus_l_gfs_file_aio_req_t *)
+                globus_fifo_peek(&monitor->aio_order);
+            if(!req->done)
+            {
+                break;
+            }
+            globus_fifo_dequeue(&monitor->aio_order);
+            globus_l_gfs_file_aio_account(monitor, req);
+            monitor->pending_reads--;
+
+            buffer = req->buffers[0];
+            if(req->err != 0 && monitor->error == NULL)
+            {
+                monitor->error = GlobusGFSErrorObjSystemError(
+                    "pread", req->err);
+            }
+            if(req->nbytes < req->length)
+            {
+                monitor->eof = GLOBUS_TRUE;
+            }
+
+            if(monitor->error != NULL || req->nbytes == 0)
+            {
+                globus_list_insert(&monitor->buffer_list, buffer);
+            }
+            else
+            {
+                result = globus_l_gfs_file_send_buffer(
+                    monitor, buffer, req->nbytes, req->offset);
+                if(result != GLOBUS_SUCCESS)
+                {
+                    globus_list_insert(&monitor->buffer_list, buffer);
+                    monitor->error = globus_error_get(result);
+                }
+            }
+            globus_free(req);
         }
         if(monitor->error != NULL)
         {
             goto error;
         }
-        
+
         result = globus_l_gfs_file_dispatch_read(monitor);
         if(result != GLOBUS_SUCCESS)
         {
@@ -3086,228 +4308,2406 @@ globus_l_gfs_file_server_write_cb(
                 "globus_l_gfs_file_dispatch_read", result);
             goto error;
         }
-        
+
         if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
         {
             globus_assert(monitor->eof || monitor->aborted);
             globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
-            globus_mutex_unlock(&monitor->lock);
         }
-        else
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExit();
+    return;
+
+error:
+    if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
+    {
+        globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
+    }
+    /* otherwise the outstanding callbacks finish up */
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
+/* called LOCKED.  keep up to queue_depth reads with the aio threads */
+static
+globus_result_t
+globus_l_gfs_file_aio_dispatch_read(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_l_gfs_file_aio_req_t *       req;
+    globus_result_t                     result;
+    globus_size_t                       read_length;
+    GlobusGFSName(globus_l_gfs_file_aio_dispatch_read);
+    GlobusGFSFileDebugEnter();
+
+    while(monitor->pending_reads < monitor->queue_depth &&
+        !monitor->eof && !monitor->aborted &&
+        !globus_list_empty(monitor->buffer_list))
+    {
+        if(monitor->first_read)
+        {
+            monitor->first_read = GLOBUS_FALSE;
+            globus_gridftp_server_get_read_range(
+                monitor->op,
+                &monitor->read_offset,
+                &monitor->read_length);
+            if(monitor->read_length == 0)
+            {
+                monitor->eof = GLOBUS_TRUE;
+                break;
+            }
+            /* no seek, reads carry their own offset */
+            monitor->file_offset = monitor->read_offset;
+        }
+
+        req = (globus_l_gfs_file_aio_req_t *)
+            globus_calloc(1, sizeof(globus_l_gfs_file_aio_req_t));
+        if(req == NULL)
+        {
+            result = GlobusGFSErrorMemory("req");
+            goto error_alloc;
+        }
+
+        if(monitor->read_length != -1 &&
+            monitor->block_size > monitor->read_length)
+        {
+            read_length = monitor->read_length;
+        }
+        else
+        {
+            read_length = monitor->block_size;
+        }
+
+        req->monitor = monitor;
+        req->callback = globus_l_gfs_file_aio_read_cb;
+        req->write = GLOBUS_FALSE;
+        req->offset = monitor->file_offset;
+        req->length = read_length;
+        req->iovc = 1;
+        req->buffers[0] = globus_list_remove(
+            &monitor->buffer_list, monitor->buffer_list);
+        req->lengths[0] = read_length;
+
+        monitor->file_offset += read_length;
+        if(monitor->read_length != -1)
+        {
+            monitor->read_length -= read_length;
+            if(monitor->read_length == 0)
+            {
+                monitor->first_read = GLOBUS_TRUE;
+            }
+        }
+
+        monitor->pending_reads++;
+        globus_l_gfs_file_aio_submit(req);
+    }
+
+    GlobusGFSFileDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_alloc:
+    GlobusGFSFileDebugExitWithError();
+    return result;
+}
+
+/* called LOCKED */
+static
+globus_result_t
+globus_l_gfs_file_dispatch_read(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_result_t                     result;
+    globus_byte_t *                     buffer;
+    globus_size_t                       read_length;
+    GlobusGFSName(globus_l_gfs_file_dispatch_read);
+    GlobusGFSFileDebugEnter();
+    
+    if(monitor->fd >= 0)
+    {
+        result = globus_l_gfs_file_aio_dispatch_read(monitor);
+        if(result == GLOBUS_SUCCESS)
+        {
+            globus_l_gfs_file_readahead(monitor);
+        }
+        GlobusGFSFileDebugExit();
+        return result;
+    }
+
+    if(monitor->first_read && monitor->pending_reads == 0 && 
+        !monitor->eof && !globus_list_empty(monitor->buffer_list) &&
+        !monitor->aborted)
+    {
+        globus_gridftp_server_get_read_range(
+            monitor->op,
+            &monitor->read_offset,
+            &monitor->read_length);
+        if(monitor->read_length == 0)
+        {
+            monitor->eof = GLOBUS_TRUE;
+        }
+        else
+        {                                        
+            if (monitor->file_offset != monitor->read_offset)
+            {
+                globus_off_t            seek_tmp;
+                seek_tmp = monitor->read_offset;
+                
+                result = globus_xio_handle_cntl(
+                    monitor->file_handle,
+                    GLOBUS_XIO_QUERY,
+                    GLOBUS_XIO_SEEK,
+                    seek_tmp,
+                    GLOBUS_XIO_FILE_SEEK_SET);
+            
+                if(result != GLOBUS_SUCCESS)
+                {
+                    result = GlobusGFSErrorWrapFailed(
+                        "globus_xio_handle_cntl", result);
+                    goto error_seek;
+                }
+                monitor->file_offset = monitor->read_offset;
+            }
+            
+        }
+        monitor->first_read = GLOBUS_FALSE;
+    }             
+
+    if(monitor->pending_reads == 0 && !monitor->eof && 
+        !globus_list_empty(monitor->buffer_list) && !monitor->aborted)
+    {
+        buffer = globus_list_remove(
+            &monitor->buffer_list, monitor->buffer_list);
+        globus_assert(buffer);
+             
+        if(monitor->read_length != -1 && 
+            monitor->block_size > monitor->read_length)
+        {
+            read_length = monitor->read_length;
+        }
+        else
+        {
+            read_length = monitor->block_size;
+        }
+        
+        result = globus_xio_register_read(
+            monitor->file_handle,
+            buffer,
+            read_length,
+            read_length,
+            NULL,
+            globus_l_gfs_file_read_cb,
+            monitor);
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_list_insert(&monitor->buffer_list, buffer);
+            result = GlobusGFSErrorWrapFailed(
+                "globus_xio_register_read", result);
+            goto error_register;
+        }
+        
+        monitor->pending_reads++;
+    }
+    globus_l_gfs_file_readahead(monitor);
+    
+    GlobusGFSFileDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_seek:
+error_register:
+    GlobusGFSFileDebugExitWithError();
+    return result;
+}
+
+static
+void
+globus_l_gfs_file_server_write_cb(
+    globus_gfs_operation_t   op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_file_monitor_t *           monitor;
+    globus_l_buffer_info_t *            buf_info;
+    GlobusGFSName(globus_l_gfs_file_server_write_cb);
+    GlobusGFSFileDebugEnter();
+    
+    monitor = (globus_l_file_monitor_t *) user_arg;
+    
+    globus_mutex_lock(&monitor->lock);
+    { 
+        monitor->pending_writes--;
+        globus_list_insert(&monitor->buffer_list, buffer);
+
+        if(result != GLOBUS_SUCCESS && monitor->error == NULL)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed("callback", result);
+        }
+        if(monitor->error != NULL)
+        {
+            goto error;
+        }
+
+        while(!globus_fifo_empty(&monitor->ready) &&
+            monitor->pending_writes < monitor->write_limit)
+        {
+            buf_info = (globus_l_buffer_info_t *)
+                globus_fifo_dequeue(&monitor->ready);
+            result = globus_l_gfs_file_send_buffer(
+                monitor, buf_info->buffer, buf_info->length, buf_info->offset);
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_list_insert(&monitor->buffer_list, buf_info->buffer);
+                globus_free(buf_info);
+                monitor->error = globus_error_get(result);
+                goto error;
+            }
+            globus_free(buf_info);
+        }
+        
+        result = globus_l_gfs_file_dispatch_read(monitor);
+        if(result != GLOBUS_SUCCESS)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed(
+                "globus_l_gfs_file_dispatch_read", result);
+            goto error;
+        }
+        
+        if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
+        {
+            globus_assert(monitor->eof || monitor->aborted);
+            globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
+            globus_mutex_unlock(&monitor->lock);
+        }
+        else
+        {
+            globus_mutex_unlock(&monitor->lock);
+        }
+    }
+    /* already unlocked */
+    
+    GlobusGFSFileDebugExit();
+    return;
+
+error:
+    if(monitor->pending_reads != 0 || monitor->pending_writes != 0)
+    {
+        /* there are still outstanding callbacks, wait for them */
+        globus_mutex_unlock(&monitor->lock);
+    
+        GlobusGFSFileDebugExitWithError();
+        return;
+    }
+    globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
+static
+void
+globus_l_gfs_file_read_cb(
+    globus_xio_handle_t                 xio_handle, 
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes, 
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    globus_l_file_monitor_t *           monitor;
+    GlobusGFSName(globus_l_gfs_file_read_cb);
+    GlobusGFSFileDebugEnter();
+    
+    monitor = (globus_l_file_monitor_t *) user_arg;
+    
+    globus_mutex_lock(&monitor->lock);
+    {
+        monitor->pending_reads--;
+        if(result != GLOBUS_SUCCESS && monitor->error == NULL)
+        {
+            if(globus_xio_error_is_eof(result))
+            {
+                monitor->eof = GLOBUS_TRUE;
+            }
+            else
+            {
+                monitor->error = GlobusGFSErrorObjWrapFailed(
+                    "callback", result);
+            }
+        }
+        if(monitor->error != NULL)
+        {
+            globus_list_insert(&monitor->buffer_list, buffer);
+            goto error;
+        }
+        
+        if(nbytes > 0)
+        {
+            result = globus_l_gfs_file_send_buffer(
+                monitor, buffer, nbytes, monitor->file_offset);
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_list_insert(&monitor->buffer_list, buffer);
+                monitor->error = globus_error_get(result);
+                goto error;
+            }
+            
+            monitor->file_offset += nbytes;
+            if(monitor->read_length != -1)
+            {
+                monitor->read_length -= nbytes;
+            }
+        }
+        else
+        {
+            globus_list_insert(&monitor->buffer_list, buffer);
+        }
+                    
+        if(monitor->read_length == 0)
+        {
+            monitor->first_read = GLOBUS_TRUE;
+        }
+        
+        result = globus_l_gfs_file_dispatch_read(monitor);
+        if(result != GLOBUS_SUCCESS)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed(
+                "globus_l_gfs_file_dispatch_read", result);
+            goto error;
+        }
+       
+        if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
+        {
+            globus_assert(monitor->eof || monitor->aborted);
+            globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
+            globus_mutex_unlock(&monitor->lock);
+        }
+        else
+        {
+            globus_mutex_unlock(&monitor->lock);
+        }
+    }
+    /* already unlocked */
+
+    GlobusGFSFileDebugExit();
+    return;
+
+error:
+    globus_assert(monitor->pending_reads == 0);
+    if(monitor->pending_writes != 0)
+    {
+        /* there are still outstanding callbacks, wait for them */
+        globus_mutex_unlock(&monitor->lock);
+    
+        GlobusGFSFileDebugExitWithError();
+        return;
+    }
+    globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
+static
+void
+globus_l_gfs_file_open_read_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    globus_l_file_monitor_t *           monitor;
+    GlobusGFSName(globus_l_gfs_file_open_read_cb);
+    GlobusGFSFileDebugEnter();
+    
+    monitor = (globus_l_file_monitor_t *) user_arg;
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed(
+            "globus_l_gfs_file_open_write_cb", result);
+        monitor->file_handle = NULL;
+        goto error_open;
+    }
+    
+    globus_gridftp_server_begin_transfer(
+        monitor->op, GLOBUS_GFS_EVENT_TRANSFER_ABORT, monitor);
+    globus_l_gfs_file_aio_attach(monitor);
+    globus_l_gfs_file_readahead_attach(monitor);
+    
+    globus_mutex_lock(&monitor->lock);
+    monitor->first_read = GLOBUS_TRUE;
+    result = globus_l_gfs_file_dispatch_read(monitor);
+    if(result != GLOBUS_SUCCESS)
+    {
+        monitor->error = GlobusGFSErrorObjWrapFailed(
+            "globus_l_gfs_file_dispatch_read", result);
+        goto error_dispatch;
+    }
+    
+    if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
+    {
+        globus_assert(monitor->eof || monitor->aborted);
+
+        globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
+        globus_mutex_unlock(&monitor->lock);
+    }
+    else
+    {
+        globus_mutex_unlock(&monitor->lock);
+    }
+    
+    GlobusGFSFileDebugExit();
+    return;
+
+error_dispatch:
+    globus_mutex_unlock(&monitor->lock);
+
+error_open:
+    globus_gridftp_server_finished_transfer(monitor->op, result);
+    globus_l_gfs_file_monitor_destroy(monitor);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
+static
+void
+globus_l_gfs_file_send(
+    globus_gfs_operation_t              op,
+    globus_gfs_transfer_info_t *        transfer_info,
+    void *                              user_arg)
+{
+    globus_result_t                     result;
+    globus_l_file_monitor_t *           monitor;
+    int                                 optimal_count;
+    int                                 buffer_count;
+    int                                 readahead;
+    globus_size_t                       block_size;
+    globus_xio_file_flag_t              open_flags;
+    GlobusGFSName(globus_l_gfs_file_send);
+    GlobusGFSFileDebugEnter();
+    
+    globus_gridftp_server_get_optimal_concurrency(op, &optimal_count);
+    globus_gridftp_server_get_block_size(op, &block_size);
+    globus_assert(optimal_count > 0 && block_size > 0);
+    
+    result = globus_l_gfs_file_monitor_init(
+        &monitor, block_size, optimal_count);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed(
+            "globus_l_gfs_file_monitor_init", result);
+        goto error_alloc;
+    }
+
+    /* buffers beyond the network concurrency hold data read ahead */
+    buffer_count = optimal_count;
+    readahead = globus_gfs_config_get_int("file_readahead");
+    if(readahead > 0)
+    {
+        buffer_count += (readahead + block_size - 1) / block_size;
+    }
+          
+    while(buffer_count--)
+    {
+        globus_byte_t *                 buffer;
+        buffer = globus_gridftp_server_buffer_get(monitor->buffers);
+        if(buffer == NULL)
+        {
+            break;
+        }
+        globus_list_insert(&monitor->buffer_list, buffer);
+    }
+    if(globus_list_empty(monitor->buffer_list))
+    {
+        result = GlobusGFSErrorMemory("buffer");
+        goto error_open;
+    }
+    monitor->session = (gfs_l_file_session_t *) user_arg;
+
+    monitor->op = op;
+    monitor->pathname = globus_libc_strdup(transfer_info->pathname);
+
+    open_flags = GLOBUS_XIO_FILE_BINARY | GLOBUS_XIO_FILE_RDONLY;
+
+    result = globus_l_gfs_file_open(
+        &monitor->file_handle, transfer_info->pathname, open_flags, monitor);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed("globus_l_gfs_file_open", result);
+        goto error_open;
+    }
+    
+    GlobusGFSFileDebugExit();
+    return;
+
+error_open:
+    globus_l_gfs_file_monitor_destroy(monitor);
+    
+error_alloc:  
+    globus_gridftp_server_finished_transfer(op, result);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
+/**
+ * bundle calls
+ *
+ * The "bundle" ERET/ESTO module moves a directory of small files over one
+ * data channel.  The data is a stream of frames, each a header line
+ *
+ *     F <size> <octal mode> <mtime> <name length>\n
+ *
+ * followed by the name of the file relative to the transfer path and then
+ * size bytes of file data.  ERET BUNDLE="R" includes subdirectories,
+ * ERET BUNDLE="F" only the files directly in the directory.  Files are
+ * opened, read and created on the aio threads so that many of them are in
+ * progress at once.
+ */
+
+#define GLOBUS_L_GFS_FILE_BUNDLE_HEADER_MAX 96
+/* files up to this size are read or written whole on the aio threads */
+#define GLOBUS_L_GFS_FILE_BUNDLE_SMALL_FILE (1024 * 1024)
+/* files opened ahead of the sender when file_queue_depth is not set */
+#define GLOBUS_L_GFS_FILE_BUNDLE_JOBS 16
+/* received file data waiting on the aio threads before reads stop */
+#define GLOBUS_L_GFS_FILE_BUNDLE_MAX_PENDING (64 * 1024 * 1024)
+
+enum
+{
+    GLOBUS_L_GFS_FILE_BUNDLE_HEADER = 0,
+    GLOBUS_L_GFS_FILE_BUNDLE_NAME,
+    GLOBUS_L_GFS_FILE_BUNDLE_DATA
+};
+
+typedef struct
+{
+    /* must be first, jobs are handed to the aio threads as requests */
+    globus_l_gfs_file_aio_req_t         req;
+    char *                              path;
+    char *                              name;
+    globus_off_t                        size;
+    int                                 mode;
+    time_t                              mtime;
+    int                                 fd;
+    globus_byte_t *                     data;
+    char                                header[GLOBUS_L_GFS_FILE_BUNDLE_HEADER_MAX];
+    int                                 header_len;
+    int                                 name_len;
+    globus_off_t                        framed;
+} globus_l_gfs_file_bundle_entry_t;
+
+typedef struct globus_l_gfs_file_bundle_s
+{
+    char *                              base;
+    int                                 base_len;
+    int                                 max_jobs;
+    int                                 file_count;
+    globus_off_t                        stream_offset;
+
+    /* send */
+    globus_fifo_t                       files;
+    globus_l_gfs_file_bundle_entry_t *  current;
+    globus_byte_t *                     out_buffer;
+    globus_size_t                       out_fill;
+
+    /* recv */
+    int                                 state;
+    char                                header[GLOBUS_L_GFS_FILE_BUNDLE_HEADER_MAX];
+    int                                 header_len;
+    char                                name[MAXPATHLEN];
+    int                                 name_len;
+    int                                 name_fill;
+    char *                              last_dir;
+    globus_l_gfs_file_bundle_entry_t *  entry;
+    int                                 file_mode;
+    time_t                              file_mtime;
+    globus_off_t                        remaining;
+    globus_off_t                        job_bytes;
+} globus_l_gfs_file_bundle_t;
+
+static
+void
+globus_l_gfs_file_bundle_entry_free(
+    globus_l_gfs_file_bundle_entry_t *  entry)
+{
+    if(entry->fd >= 0)
+    {
+        close(entry->fd);
+    }
+    if(entry->data)
+    {
+        globus_free(entry->data);
+    }
+    globus_free(entry->path);
+    globus_free(entry);
+}
+
+static
+void
+globus_l_gfs_file_bundle_destroy(
+    globus_l_gfs_file_bundle_t *        bundle)
+{
+    globus_l_gfs_file_bundle_entry_t *  entry;
+
+    globus_gfs_log_message(
+        GLOBUS_GFS_LOG_INFO,
+        "Bundle transfer of %s: %d files.\n",
+        bundle->base[0] ? bundle->base : "/", bundle->file_count);
+
+    while(!globus_fifo_empty(&bundle->files))
+    {
+        entry = (globus_l_gfs_file_bundle_entry_t *)
+            globus_fifo_dequeue(&bundle->files);
+        globus_l_gfs_file_bundle_entry_free(entry);
+    }
+    if(bundle->current)
+    {
+        globus_l_gfs_file_bundle_entry_free(bundle->current);
+    }
+    if(bundle->entry)
+    {
+        globus_l_gfs_file_bundle_entry_free(bundle->entry);
+    }
+    if(bundle->last_dir)
+    {
+        globus_free(bundle->last_dir);
+    }
+    globus_fifo_destroy(&bundle->files);
+    globus_free(bundle->base);
+    globus_free(bundle);
+}
+
+static
+globus_result_t
+globus_l_gfs_file_bundle_init(
+    globus_l_file_monitor_t *           monitor,
+    const char *                        pathname)
+{
+    globus_l_gfs_file_bundle_t *        bundle;
+    int                                 depth;
+    GlobusGFSName(globus_l_gfs_file_bundle_init);
+
+    bundle = (globus_l_gfs_file_bundle_t *)
+        globus_calloc(1, sizeof(globus_l_gfs_file_bundle_t));
+    if(bundle == NULL)
+    {
+        return GlobusGFSErrorMemory("bundle");
+    }
+    bundle->base = globus_libc_strdup(pathname);
+    if(bundle->base == NULL)
+    {
+        globus_free(bundle);
+        return GlobusGFSErrorMemory("bundle");
+    }
+    bundle->base_len = strlen(bundle->base);
+    while(bundle->base_len > 0 && bundle->base[bundle->base_len - 1] == '/')
+    {
+        bundle->base[--bundle->base_len] = '\0';
+    }
+    globus_fifo_init(&bundle->files);
+    bundle->state = GLOBUS_L_GFS_FILE_BUNDLE_HEADER;
+
+    depth = globus_gfs_config_get_int("file_queue_depth");
+    bundle->max_jobs = depth > 0 ? depth : GLOBUS_L_GFS_FILE_BUNDLE_JOBS;
+
+    monitor->bundle = bundle;
+
+    return GLOBUS_SUCCESS;
+}
+
+/* called locked.  run a job on the aio threads, or right here when the
+ * server has no threads.  returns GLOBUS_TRUE if the job has already run */
+static
+globus_bool_t
+globus_l_gfs_file_bundle_submit(
+    globus_l_gfs_file_bundle_entry_t *  entry)
+{
+#ifdef GLOBUS_L_GFS_FILE_AIO
+    if(!globus_i_am_only_thread())
+    {
+        globus_l_gfs_file_aio_submit(&entry->req);
+        return GLOBUS_FALSE;
+    }
+#endif
+    entry->req.err = 0;
+    entry->req.nbytes = 0;
+    globus_fifo_enqueue(&entry->req.monitor->aio_order, &entry->req);
+    entry->req.run(&entry->req);
+    entry->req.done = GLOBUS_TRUE;
+
+    return GLOBUS_TRUE;
+}
+
+/* called locked.  finish the transfer once nothing is outstanding */
+static
+void
+globus_l_gfs_file_bundle_check_done(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_l_gfs_file_bundle_t *        bundle;
+    GlobusGFSName(globus_l_gfs_file_bundle_check_done);
+
+    bundle = monitor->bundle;
+    if(monitor->pending_reads != 0 || monitor->pending_writes != 0)
+    {
+        return;
+    }
+
+    if(monitor->error == NULL && !monitor->aborted &&
+        (bundle->state != GLOBUS_L_GFS_FILE_BUNDLE_HEADER ||
+        bundle->header_len != 0 || !globus_priority_q_empty(&monitor->queue)))
+    {
+        monitor->error = GlobusGFSErrorObjGeneric("Bundle data truncated.");
+    }
+
+    if(monitor->error != NULL)
+    {
+        globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
+    }
+    else
+    {
+        globus_assert(monitor->eof || monitor->aborted);
+        globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
+    }
+}
+
+/*
+ * bundle send
+ */
+
+static
+globus_result_t
+globus_l_gfs_file_bundle_list(
+    globus_l_gfs_file_bundle_t *        bundle,
+    const char *                        dir,
+    globus_bool_t                       recursive)
+{
+    globus_l_gfs_file_bundle_entry_t *  entry;
+    globus_result_t                     result;
+    struct dirent *                     dir_entry;
+    struct stat                         stat_buf;
+    DIR *                               dir_h;
+    char *                              full;
+    char *                              rel;
+    char *                              path;
+    GlobusGFSName(globus_l_gfs_file_bundle_list);
+    GlobusGFSFileDebugEnter();
+
+    if(*dir)
+    {
+        full = globus_common_create_string("%s/%s", bundle->base, dir);
+    }
+    else
+    {
+        full = globus_libc_strdup(*bundle->base ? bundle->base : "/");
+    }
+
+    dir_h = opendir(full);
+    if(dir_h == NULL)
+    {
+        result = GlobusGFSErrorSystemError("opendir", errno);
+        globus_free(full);
+        goto error_open;
+    }
+    globus_free(full);
+
+    while((dir_entry = readdir(dir_h)) != NULL)
+    {
+        if(strcmp(dir_entry->d_name, ".") == 0 ||
+            strcmp(dir_entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+        if(*dir)
+        {
+            rel = globus_common_create_string("%s/%s", dir, dir_entry->d_name);
+        }
+        else
+        {
+            rel = globus_libc_strdup(dir_entry->d_name);
+        }
+        path = globus_common_create_string("%s/%s", bundle->base, rel);
+
+        if(lstat(path, &stat_buf) != 0)
+        {
+            /* gone since the readdir, skip it */
+            globus_free(path);
+        }
+        else if(S_ISREG(stat_buf.st_mode))
+        {
+            entry = (globus_l_gfs_file_bundle_entry_t *)
+                globus_calloc(1, sizeof(globus_l_gfs_file_bundle_entry_t));
+            if(entry == NULL)
+            {
+                globus_free(path);
+                globus_free(rel);
+                result = GlobusGFSErrorMemory("entry");
+                goto error_alloc;
+            }
+            entry->path = path;
+            entry->name = path + bundle->base_len + 1;
+            entry->size = stat_buf.st_size;
+            entry->mode = stat_buf.st_mode & 0777;
+            entry->mtime = stat_buf.st_mtime;
+            entry->fd = -1;
+            globus_fifo_enqueue(&bundle->files, entry);
+        }
+        else if(S_ISDIR(stat_buf.st_mode) && recursive)
+        {
+            globus_free(path);
+            result = globus_l_gfs_file_bundle_list(bundle, rel, recursive);
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_free(rel);
+                goto error_alloc;
+            }
+        }
+        else
+        {
+            globus_free(path);
+        }
+        globus_free(rel);
+    }
+    closedir(dir_h);
+
+    GlobusGFSFileDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_alloc:
+    closedir(dir_h);
+error_open:
+    GlobusGFSFileDebugExitWithError();
+    return result;
+}
+
+/* aio thread.  open the file and read it whole if it is small */
+static
+void
+globus_l_gfs_file_bundle_open_run(
+    globus_l_gfs_file_aio_req_t *       req)
+{
+    globus_l_gfs_file_bundle_entry_t *  entry;
+    ssize_t                             rc;
+
+    entry = (globus_l_gfs_file_bundle_entry_t *) req;
+
+    /* it was listed as a regular file, don't follow it if that changed */
+    entry->fd = open(entry->path, O_RDONLY | O_NOFOLLOW);
+    if(entry->fd < 0)
+    {
+        req->err = errno;
+        return;
+    }
+    if(entry->size > GLOBUS_L_GFS_FILE_BUNDLE_SMALL_FILE)
+    {
+        return;
+    }
+
+    entry->data = globus_malloc(entry->size > 0 ? entry->size : 1);
+    if(entry->data == NULL)
+    {
+        req->err = ENOMEM;
+        return;
+    }
+    while(req->nbytes < entry->size)
+    {
+        rc = pread(
+            entry->fd,
+            entry->data + req->nbytes,
+            entry->size - req->nbytes,
+            req->nbytes);
+        if(rc < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(rc < 0)
+        {
+            req->err = errno;
+            return;
+        }
+        if(rc == 0)
+        {
+            break;
+        }
+        req->nbytes += rc;
+    }
+    /* send what was there if it shrank since the listing */
+    entry->size = req->nbytes;
+    close(entry->fd);
+    entry->fd = -1;
+}
+
+static
+void
+globus_l_gfs_file_bundle_write_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    void *                              user_arg);
+
+/* called locked.  write out a full or final buffer */
+static
+globus_result_t
+globus_l_gfs_file_bundle_flush(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_l_gfs_file_bundle_t *        bundle;
+    globus_result_t                     result;
+    GlobusGFSName(globus_l_gfs_file_bundle_flush);
+
+    bundle = monitor->bundle;
+    result = globus_gridftp_server_register_write(
+        monitor->op,
+        bundle->out_buffer,
+        bundle->out_fill,
+        bundle->stream_offset,
+        -1,
+        globus_l_gfs_file_bundle_write_cb,
+        monitor);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_list_insert(&monitor->buffer_list, bundle->out_buffer);
+        bundle->out_buffer = NULL;
+        return GlobusGFSErrorWrapFailed(
+            "globus_gridftp_server_register_write", result);
+    }
+    monitor->pending_writes++;
+    bundle->stream_offset += bundle->out_fill;
+    bundle->out_buffer = NULL;
+    bundle->out_fill = 0;
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+void
+globus_l_gfs_file_bundle_open_cb(
+    globus_l_gfs_file_aio_req_t *       req);
+
+/* called locked.  open files ahead on the aio threads and pack the ones that
+ * are ready, in listing order, into network buffers */
+static
+void
+globus_l_gfs_file_bundle_fill(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_l_gfs_file_bundle_t *        bundle;
+    globus_l_gfs_file_bundle_entry_t *  entry;
+    globus_result_t                     result;
+    globus_off_t                        frame_len;
+    globus_off_t                        data_off;
+    globus_size_t                       room;
+    globus_size_t                       n;
+    ssize_t                             rc;
+    GlobusGFSName(globus_l_gfs_file_bundle_fill);
+    GlobusGFSFileDebugEnter();
+
+    bundle = monitor->bundle;
+
+    while(monitor->error == NULL && !monitor->aborted &&
+        monitor->pending_reads < bundle->max_jobs &&
+        !globus_fifo_empty(&bundle->files))
+    {
+        entry = (globus_l_gfs_file_bundle_entry_t *)
+            globus_fifo_dequeue(&bundle->files);
+        entry->req.monitor = monitor;
+        entry->req.run = globus_l_gfs_file_bundle_open_run;
+        entry->req.callback = globus_l_gfs_file_bundle_open_cb;
+        monitor->pending_reads++;
+        globus_l_gfs_file_bundle_submit(entry);
+    }
+
+    while(monitor->error == NULL && !monitor->aborted)
+    {
+        if(bundle->current == NULL)
+        {
+            if(globus_fifo_empty(&monitor->aio_order))
+            {
+                break;
+            }
+            entry = (globus_l_gfs_file_bundle_entry_t *)
+                globus_fifo_peek(&monitor->aio_order);
+            if(!entry->req.done)
+            {
+                break;
+            }
+            globus_fifo_dequeue(&monitor->aio_order);
+            globus_l_gfs_file_aio_account(monitor, &entry->req);
+            monitor->pending_reads--;
+            if(entry->req.err != 0)
+            {
+                monitor->error = GlobusGFSErrorObjSystemError(
+                    "open", entry->req.err);
+                globus_l_gfs_file_bundle_entry_free(entry);
+                break;
+            }
+            entry->name_len = strlen(entry->name);
+            entry->header_len = snprintf(
+                entry->header,
+                sizeof(entry->header),
+                "F %" GLOBUS_OFF_T_FORMAT " %o %ld %d\n",
+                entry->size,
+                entry->mode,
+                (long) entry->mtime,
+                entry->name_len);
+            bundle->current = entry;
+        }
+
+        if(bundle->out_buffer == NULL)
+        {
+            if(globus_list_empty(monitor->buffer_list))
+            {
+                break;
+            }
+            bundle->out_buffer = globus_list_remove(
+                &monitor->buffer_list, monitor->buffer_list);
+            bundle->out_fill = 0;
+        }
+
+        entry = bundle->current;
+        frame_len = entry->header_len + entry->name_len + entry->size;
+        room = monitor->block_size - bundle->out_fill;
+        while(room > 0 && entry->framed < frame_len)
+        {
+            if(entry->framed < entry->header_len)
+            {
+                n = entry->header_len - entry->framed;
+                n = n < room ? n : room;
+                memcpy(bundle->out_buffer + bundle->out_fill,
+                    entry->header + entry->framed, n);
+            }
+            else if(entry->framed < entry->header_len + entry->name_len)
+            {
+                n = entry->header_len + entry->name_len - entry->framed;
+                n = n < room ? n : room;
+                memcpy(bundle->out_buffer + bundle->out_fill,
+                    entry->name + (entry->framed - entry->header_len), n);
+            }
+            else
+            {
+                data_off = entry->framed - entry->header_len - entry->name_len;
+                n = (entry->size - data_off) < (globus_off_t) room ?
+                    (globus_size_t) (entry->size - data_off) : room;
+                if(entry->data != NULL)
+                {
+                    memcpy(bundle->out_buffer + bundle->out_fill,
+                        entry->data + data_off, n);
+                }
+                else
+                {
+                    /* large file, read it in place */
+                    do
+                    {
+                        rc = pread(entry->fd,
+                            bundle->out_buffer + bundle->out_fill, n, data_off);
+                    } while(rc < 0 && errno == EINTR);
+                    if(rc <= 0)
+                    {
+                        monitor->error = rc < 0 ?
+                            GlobusGFSErrorObjSystemError("pread", errno) :
+                            GlobusGFSErrorObjGeneric(
+                                "File shrank during bundle transfer.");
+                        break;
+                    }
+                    n = rc;
+                }
+            }
+            bundle->out_fill += n;
+            entry->framed += n;
+            room -= n;
+        }
+        if(monitor->error != NULL)
+        {
+            break;
+        }
+
+        if(entry->framed == frame_len)
+        {
+            globus_l_gfs_file_bundle_entry_free(entry);
+            bundle->current = NULL;
+            bundle->file_count++;
+        }
+        if(bundle->out_fill == monitor->block_size)
+        {
+            result = globus_l_gfs_file_bundle_flush(monitor);
+            if(result != GLOBUS_SUCCESS)
+            {
+                monitor->error = globus_error_get(result);
+                break;
+            }
+        }
+    }
+
+    if(monitor->error == NULL && !monitor->aborted &&
+        bundle->current == NULL && monitor->pending_reads == 0 &&
+        globus_fifo_empty(&bundle->files))
+    {
+        /* everything is framed */
+        if(bundle->out_buffer != NULL && bundle->out_fill > 0)
+        {
+            result = globus_l_gfs_file_bundle_flush(monitor);
+            if(result != GLOBUS_SUCCESS)
+            {
+                monitor->error = globus_error_get(result);
+            }
+        }
+        monitor->eof = GLOBUS_TRUE;
+    }
+
+    if(monitor->error != NULL || monitor->aborted)
+    {
+        /* drop whatever is ready, the rest is dropped as it finishes */
+        while(!globus_fifo_empty(&monitor->aio_order))
+        {
+            entry = (globus_l_gfs_file_bundle_entry_t *)
+                globus_fifo_peek(&monitor->aio_order);
+            if(!entry->req.done)
+            {
+                break;
+            }
+            globus_fifo_dequeue(&monitor->aio_order);
+            monitor->pending_reads--;
+            globus_l_gfs_file_bundle_entry_free(entry);
+        }
+    }
+    if(bundle->out_buffer != NULL &&
+        (monitor->eof || monitor->error != NULL || monitor->aborted))
+    {
+        globus_list_insert(&monitor->buffer_list, bundle->out_buffer);
+        bundle->out_buffer = NULL;
+    }
+
+    GlobusGFSFileDebugExit();
+}
+
+static
+void
+globus_l_gfs_file_bundle_open_cb(
+    globus_l_gfs_file_aio_req_t *       req)
+{
+    globus_l_file_monitor_t *           monitor;
+    GlobusGFSName(globus_l_gfs_file_bundle_open_cb);
+    GlobusGFSFileDebugEnter();
+
+    monitor = req->monitor;
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        req->done = GLOBUS_TRUE;
+        globus_l_gfs_file_bundle_fill(monitor);
+        globus_l_gfs_file_bundle_check_done(monitor);
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExit();
+}
+
+static
+void
+globus_l_gfs_file_bundle_write_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_file_monitor_t *           monitor;
+    GlobusGFSName(globus_l_gfs_file_bundle_write_cb);
+    GlobusGFSFileDebugEnter();
+
+    monitor = (globus_l_file_monitor_t *) user_arg;
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        monitor->pending_writes--;
+        globus_list_insert(&monitor->buffer_list, buffer);
+
+        if(result != GLOBUS_SUCCESS && monitor->error == NULL)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed("callback", result);
+        }
+        globus_l_gfs_file_bundle_fill(monitor);
+        globus_l_gfs_file_bundle_check_done(monitor);
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExit();
+}
+
+static
+void
+globus_l_gfs_file_bundle_send(
+    globus_gfs_operation_t              op,
+    globus_gfs_transfer_info_t *        transfer_info,
+    void *                              user_arg)
+{
+    globus_result_t                     result;
+    globus_l_file_monitor_t *           monitor;
+    int                                 optimal_count;
+    globus_size_t                       block_size;
+    globus_bool_t                       recursive;
+    GlobusGFSName(globus_l_gfs_file_bundle_send);
+    GlobusGFSFileDebugEnter();
+
+    globus_gridftp_server_get_optimal_concurrency(op, &optimal_count);
+    globus_gridftp_server_get_block_size(op, &block_size);
+    globus_assert(optimal_count > 0 && block_size > 0);
+
+    result = globus_l_gfs_file_monitor_init(
+        &monitor, block_size, optimal_count);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed(
+            "globus_l_gfs_file_monitor_init", result);
+        goto error_alloc;
+    }
+    monitor->op = op;
+    monitor->pathname = globus_libc_strdup(transfer_info->pathname);
+
+    result = globus_l_gfs_file_bundle_init(monitor, transfer_info->pathname);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_init;
+    }
+
+    recursive = transfer_info->module_args != NULL &&
+        strchr(transfer_info->module_args, 'R') != NULL;
+    result = globus_l_gfs_file_bundle_list(monitor->bundle, "", recursive);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_init;
+    }
+
+    while(optimal_count--)
+    {
+        globus_byte_t *                 buffer;
+
+        buffer = globus_gridftp_server_buffer_get(monitor->buffers);
+        if(buffer == NULL)
+        {
+            break;
+        }
+        globus_list_insert(&monitor->buffer_list, buffer);
+    }
+    if(globus_list_empty(monitor->buffer_list))
+    {
+        result = GlobusGFSErrorMemory("buffer");
+        goto error_init;
+    }
+
+    globus_gridftp_server_begin_transfer(
+        op, GLOBUS_GFS_EVENT_TRANSFER_ABORT, monitor);
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        globus_l_gfs_file_bundle_fill(monitor);
+        globus_l_gfs_file_bundle_check_done(monitor);
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExit();
+    return;
+
+error_init:
+    globus_l_gfs_file_monitor_destroy(monitor);
+
+error_alloc:
+    globus_gridftp_server_finished_transfer(op, result);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
+/*
+ * bundle recv
+ */
+
+/* aio thread.  create a small file from the data collected for it */
+static
+void
+globus_l_gfs_file_bundle_create_run(
+    globus_l_gfs_file_aio_req_t *       req)
+{
+    globus_l_gfs_file_bundle_entry_t *  entry;
+    struct utimbuf                      ubuf;
+    ssize_t                             rc;
+
+    entry = (globus_l_gfs_file_bundle_entry_t *) req;
+
+    entry->fd = open(
+        entry->path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, entry->mode);
+    if(entry->fd < 0)
+    {
+        req->err = errno;
+        return;
+    }
+    while(req->nbytes < entry->size)
+    {
+        rc = pwrite(
+            entry->fd,
+            entry->data + req->nbytes,
+            entry->size - req->nbytes,
+            req->nbytes);
+        if(rc < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(rc <= 0)
+        {
+            req->err = rc < 0 ? errno : EIO;
+            return;
+        }
+        req->nbytes += rc;
+    }
+    if(close(entry->fd) != 0)
+    {
+        req->err = errno;
+    }
+    entry->fd = -1;
+
+    ubuf.actime = time(NULL);
+    ubuf.modtime = entry->mtime;
+    utime(entry->path, &ubuf);
+}
+
+/* called locked */
+static
+void
+globus_l_gfs_file_bundle_create_finished(
+    globus_l_file_monitor_t *           monitor,
+    globus_l_gfs_file_bundle_entry_t *  entry)
+{
+    GlobusGFSName(globus_l_gfs_file_bundle_create_finished);
+
+    globus_fifo_remove(&monitor->aio_order, &entry->req);
+    globus_l_gfs_file_aio_account(monitor, &entry->req);
+    monitor->pending_writes--;
+    monitor->bundle->job_bytes -= entry->size;
+    monitor->bundle->file_count++;
+    if(entry->req.err != 0 && monitor->error == NULL)
+    {
+        monitor->error = GlobusGFSErrorObjSystemError(
+            "write", entry->req.err);
+    }
+    globus_l_gfs_file_bundle_entry_free(entry);
+}
+
+static
+void
+globus_l_gfs_file_bundle_read_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    globus_off_t                        offset,
+    globus_bool_t                       eof,
+    void *                              user_arg);
+
+/* called locked.  hand a network buffer back for more data, unless too
+ * much file data is still waiting to be written */
+static
+void
+globus_l_gfs_file_bundle_return_buffer(
+    globus_l_file_monitor_t *           monitor,
+    globus_byte_t *                     buffer)
+{
+    globus_result_t                     result;
+    GlobusGFSName(globus_l_gfs_file_bundle_return_buffer);
+
+    if(monitor->error != NULL || monitor->eof || monitor->aborted)
+    {
+        globus_gridftp_server_buffer_put(monitor->buffers, buffer);
+    }
+    else if(monitor->bundle->job_bytes > GLOBUS_L_GFS_FILE_BUNDLE_MAX_PENDING)
+    {
+        globus_list_insert(&monitor->buffer_list, buffer);
+    }
+    else
+    {
+        result = globus_gridftp_server_register_read(
+            monitor->op,
+            buffer,
+            monitor->block_size,
+            globus_l_gfs_file_bundle_read_cb,
+            monitor);
+        if(result != GLOBUS_SUCCESS)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed(
+                "globus_gridftp_server_register_read", result);
+            globus_gridftp_server_buffer_put(monitor->buffers, buffer);
+            return;
+        }
+        monitor->pending_reads++;
+    }
+}
+
+static
+void
+globus_l_gfs_file_bundle_create_cb(
+    globus_l_gfs_file_aio_req_t *       req)
+{
+    globus_l_file_monitor_t *           monitor;
+    GlobusGFSName(globus_l_gfs_file_bundle_create_cb);
+    GlobusGFSFileDebugEnter();
+
+    monitor = req->monitor;
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        globus_l_gfs_file_bundle_create_finished(
+            monitor, (globus_l_gfs_file_bundle_entry_t *) req);
+
+        while(!globus_list_empty(monitor->buffer_list) &&
+            monitor->bundle->job_bytes <= GLOBUS_L_GFS_FILE_BUNDLE_MAX_PENDING)
+        {
+            globus_l_gfs_file_bundle_return_buffer(
+                monitor,
+                globus_list_remove(
+                    &monitor->buffer_list, monitor->buffer_list));
+        }
+        globus_l_gfs_file_bundle_check_done(monitor);
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExit();
+}
+
+/* create a directory for received files.  one that is already there must
+ * not be a link, which could lead out of the transfer directory */
+static
+globus_result_t
+globus_l_gfs_file_bundle_mkdir(
+    const char *                        dir)
+{
+    struct stat                         stat_buf;
+    GlobusGFSName(globus_l_gfs_file_bundle_mkdir);
+
+    if(mkdir(dir, 0777) != 0 && errno != EEXIST)
+    {
+        return GlobusGFSErrorSystemError("mkdir", errno);
+    }
+    if(lstat(dir, &stat_buf) != 0)
+    {
+        return GlobusGFSErrorSystemError("lstat", errno);
+    }
+    if(!S_ISDIR(stat_buf.st_mode))
+    {
+        return GlobusGFSErrorGeneric("Invalid file name in bundle.");
+    }
+
+    return GLOBUS_SUCCESS;
+}
+
+/* called locked.  a header and name have been read, set up the file */
+static
+globus_result_t
+globus_l_gfs_file_bundle_start_file(
+    globus_l_file_monitor_t *           monitor,
+    globus_off_t                        size,
+    int                                 mode,
+    time_t                              mtime)
+{
+    globus_l_gfs_file_bundle_t *        bundle;
+    globus_l_gfs_file_bundle_entry_t *  entry;
+    globus_result_t                     result;
+    char *                              name;
+    char *                              slash;
+    char *                              dir;
+    GlobusGFSName(globus_l_gfs_file_bundle_start_file);
+
+    bundle = monitor->bundle;
+    name = bundle->name;
+
+    /* names stay inside the transfer directory */
+    if(memchr(name, '\0', bundle->name_len) != NULL || *name == '/' ||
+        strcmp(name, "..") == 0 || strncmp(name, "../", 3) == 0 ||
+        strstr(name, "/../") != NULL ||
+        (bundle->name_len >= 3 &&
+        strcmp(name + bundle->name_len - 3, "/..") == 0))
+    {
+        return GlobusGFSErrorGeneric("Invalid file name in bundle.");
+    }
+
+    entry = (globus_l_gfs_file_bundle_entry_t *)
+        globus_calloc(1, sizeof(globus_l_gfs_file_bundle_entry_t));
+    if(entry == NULL)
+    {
+        return GlobusGFSErrorMemory("entry");
+    }
+    entry->fd = -1;
+    entry->size = size;
+    entry->mode = (mode & 0777) ? (mode & 0777) : 0644;
+    entry->mtime = mtime;
+    entry->path = globus_common_create_string("%s/%s", bundle->base, name);
+    if(entry->path == NULL)
+    {
+        globus_free(entry);
+        return GlobusGFSErrorMemory("path");
+    }
+    entry->name = entry->path + bundle->base_len + 1;
+
+    /* create the parent directories, once per directory */
+    slash = strrchr(entry->path, '/');
+    if(slash > entry->name)
+    {
+        dir = globus_libc_strdup(entry->path);
+        dir[slash - entry->path] = '\0';
+        if(bundle->last_dir == NULL || strcmp(dir, bundle->last_dir) != 0)
+        {
+            result = GLOBUS_SUCCESS;
+            for(slash = dir + (entry->name - entry->path);
+                result == GLOBUS_SUCCESS &&
+                    (slash = strchr(slash, '/')) != NULL;
+                slash++)
+            {
+                *slash = '\0';
+                result = globus_l_gfs_file_bundle_mkdir(dir);
+                *slash = '/';
+            }
+            if(result == GLOBUS_SUCCESS)
+            {
+                result = globus_l_gfs_file_bundle_mkdir(dir);
+            }
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_free(dir);
+                goto error;
+            }
+            if(bundle->last_dir)
+            {
+                globus_free(bundle->last_dir);
+            }
+            bundle->last_dir = dir;
+        }
+        else
+        {
+            globus_free(dir);
+        }
+    }
+
+    if(size <= GLOBUS_L_GFS_FILE_BUNDLE_SMALL_FILE)
+    {
+        entry->data = globus_malloc(size > 0 ? size : 1);
+        if(entry->data == NULL)
+        {
+            result = GlobusGFSErrorMemory("data");
+            goto error;
+        }
+    }
+    else
+    {
+        /* large file, written as it arrives */
+        entry->fd = open(
+            entry->path,
+            O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW,
+            entry->mode);
+        if(entry->fd < 0)
+        {
+            result = GlobusGFSErrorSystemError("open", errno);
+            goto error;
+        }
+    }
+    bundle->entry = entry;
+    bundle->remaining = size;
+
+    return GLOBUS_SUCCESS;
+
+error:
+    globus_l_gfs_file_bundle_entry_free(entry);
+    return result;
+}
+
+/* called locked.  all the data for the current file is in */
+static
+globus_result_t
+globus_l_gfs_file_bundle_end_file(
+    globus_l_file_monitor_t *           monitor)
+{
+    globus_l_gfs_file_bundle_t *        bundle;
+    globus_l_gfs_file_bundle_entry_t *  entry;
+    struct utimbuf                      ubuf;
+    GlobusGFSName(globus_l_gfs_file_bundle_end_file);
+
+    bundle = monitor->bundle;
+    entry = bundle->entry;
+    bundle->entry = NULL;
+    bundle->state = GLOBUS_L_GFS_FILE_BUNDLE_HEADER;
+
+    if(entry->data == NULL)
+    {
+        if(close(entry->fd) != 0)
+        {
+            entry->fd = -1;
+            globus_l_gfs_file_bundle_entry_free(entry);
+            return GlobusGFSErrorSystemError("close", errno);
+        }
+        entry->fd = -1;
+        ubuf.actime = time(NULL);
+        ubuf.modtime = entry->mtime;
+        utime(entry->path, &ubuf);
+        globus_l_gfs_file_bundle_entry_free(entry);
+        bundle->file_count++;
+        return GLOBUS_SUCCESS;
+    }
+
+    entry->req.monitor = monitor;
+    entry->req.run = globus_l_gfs_file_bundle_create_run;
+    entry->req.callback = globus_l_gfs_file_bundle_create_cb;
+    monitor->pending_writes++;
+    bundle->job_bytes += entry->size;
+    if(globus_l_gfs_file_bundle_submit(entry))
+    {
+        globus_l_gfs_file_bundle_create_finished(monitor, entry);
+    }
+
+    return GLOBUS_SUCCESS;
+}
+
+/* called locked.  parse the next in order piece of the bundle stream */
+static
+globus_result_t
+globus_l_gfs_file_bundle_parse(
+    globus_l_file_monitor_t *           monitor,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length)
+{
+    globus_l_gfs_file_bundle_t *        bundle;
+    globus_l_gfs_file_bundle_entry_t *  entry;
+    globus_result_t                     result;
+    globus_size_t                       pos = 0;
+    globus_size_t                       n;
+    globus_off_t                        size;
+    unsigned int                        mode;
+    long                                mtime;
+    ssize_t                             rc;
+    GlobusGFSName(globus_l_gfs_file_bundle_parse);
+
+    bundle = monitor->bundle;
+    while(pos < length)
+    {
+        switch(bundle->state)
+        {
+          case GLOBUS_L_GFS_FILE_BUNDLE_HEADER:
+            while(pos < length && buffer[pos] != '\n' &&
+                bundle->header_len < GLOBUS_L_GFS_FILE_BUNDLE_HEADER_MAX - 1)
+            {
+                bundle->header[bundle->header_len++] = buffer[pos++];
+            }
+            if(pos == length)
+            {
+                break;
+            }
+            if(buffer[pos] != '\n')
+            {
+                return GlobusGFSErrorGeneric("Invalid bundle header.");
+            }
+            pos++;
+            bundle->header[bundle->header_len] = '\0';
+            bundle->header_len = 0;
+            if(sscanf(bundle->header,
+                "F %" GLOBUS_OFF_T_FORMAT " %o %ld %d",
+                &size, &mode, &mtime, &bundle->name_len) != 4 ||
+                size < 0 || bundle->name_len <= 0 ||
+                bundle->name_len >= MAXPATHLEN)
+            {
+                return GlobusGFSErrorGeneric("Invalid bundle header.");
+            }
+            bundle->remaining = size;
+            bundle->file_mode = mode;
+            bundle->file_mtime = (time_t) mtime;
+            bundle->name_fill = 0;
+            bundle->state = GLOBUS_L_GFS_FILE_BUNDLE_NAME;
+            break;
+
+          case GLOBUS_L_GFS_FILE_BUNDLE_NAME:
+            n = bundle->name_len - bundle->name_fill;
+            n = n < length - pos ? n : length - pos;
+            memcpy(bundle->name + bundle->name_fill, buffer + pos, n);
+            bundle->name_fill += n;
+            pos += n;
+            if(bundle->name_fill < bundle->name_len)
+            {
+                break;
+            }
+            bundle->name[bundle->name_len] = '\0';
+
+            result = globus_l_gfs_file_bundle_start_file(
+                monitor,
+                bundle->remaining,
+                bundle->file_mode,
+                bundle->file_mtime);
+            if(result != GLOBUS_SUCCESS)
+            {
+                return result;
+            }
+            bundle->state = GLOBUS_L_GFS_FILE_BUNDLE_DATA;
+            if(bundle->remaining == 0)
+            {
+                result = globus_l_gfs_file_bundle_end_file(monitor);
+                if(result != GLOBUS_SUCCESS)
+                {
+                    return result;
+                }
+            }
+            break;
+
+          case GLOBUS_L_GFS_FILE_BUNDLE_DATA:
+            entry = bundle->entry;
+            n = bundle->remaining < (globus_off_t) (length - pos) ?
+                (globus_size_t) bundle->remaining : length - pos;
+            if(entry->data != NULL)
+            {
+                memcpy(entry->data + (entry->size - bundle->remaining),
+                    buffer + pos, n);
+            }
+            else
+            {
+                do
+                {
+                    rc = pwrite(entry->fd, buffer + pos, n,
+                        entry->size - bundle->remaining);
+                } while(rc < 0 && errno == EINTR);
+                if(rc <= 0)
+                {
+                    return GlobusGFSErrorSystemError(
+                        "pwrite", rc < 0 ? errno : EIO);
+                }
+                n = rc;
+            }
+            pos += n;
+            bundle->remaining -= n;
+            if(bundle->remaining == 0)
+            {
+                result = globus_l_gfs_file_bundle_end_file(monitor);
+                if(result != GLOBUS_SUCCESS)
+                {
+                    return result;
+                }
+            }
+            break;
+        }
+    }
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+void
+globus_l_gfs_file_bundle_read_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    globus_off_t                        offset,
+    globus_bool_t                       eof,
+    void *                              user_arg)
+{
+    globus_l_file_monitor_t *           monitor;
+    globus_l_gfs_file_bundle_t *        bundle;
+    globus_l_buffer_info_t *            buf_info;
+    GlobusGFSName(globus_l_gfs_file_bundle_read_cb);
+    GlobusGFSFileDebugEnter();
+
+    monitor = (globus_l_file_monitor_t *) user_arg;
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        bundle = monitor->bundle;
+        monitor->pending_reads--;
+        if(result != GLOBUS_SUCCESS && monitor->error == NULL)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed("callback", result);
+        }
+        if(eof)
+        {
+            monitor->eof = GLOBUS_TRUE;
+        }
+
+        if(monitor->error != NULL || nbytes == 0)
+        {
+            globus_l_gfs_file_bundle_return_buffer(monitor, buffer);
+        }
+        else
+        {
+            buf_info = (globus_l_buffer_info_t *)
+                globus_malloc(sizeof(globus_l_buffer_info_t));
+            if(buf_info == NULL)
+            {
+                monitor->error = GlobusGFSErrorObjMemory("buf_info");
+                globus_gridftp_server_buffer_put(monitor->buffers, buffer);
+            }
+            else
+            {
+                buf_info->buffer = buffer;
+                buf_info->offset = offset;
+                buf_info->length = nbytes;
+                globus_priority_q_enqueue(&monitor->queue, buf_info, buf_info);
+            }
+        }
+
+        /* the stream has to be parsed in order */
+        while(monitor->error == NULL &&
+            !globus_priority_q_empty(&monitor->queue))
+        {
+            buf_info = (globus_l_buffer_info_t *)
+                globus_priority_q_first(&monitor->queue);
+            if(buf_info->offset != bundle->stream_offset)
+            {
+                break;
+            }
+            globus_priority_q_dequeue(&monitor->queue);
+
+            globus_gridftp_server_update_bytes_written(
+                monitor->op, buf_info->offset, buf_info->length);
+            result = globus_l_gfs_file_bundle_parse(
+                monitor, buf_info->buffer, buf_info->length);
+            if(result != GLOBUS_SUCCESS)
+            {
+                monitor->error = globus_error_get(result);
+            }
+            bundle->stream_offset += buf_info->length;
+
+            globus_l_gfs_file_bundle_return_buffer(monitor, buf_info->buffer);
+            globus_free(buf_info);
+        }
+
+        globus_l_gfs_file_bundle_check_done(monitor);
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExit();
+}
+
+static
+void
+globus_l_gfs_file_bundle_recv(
+    globus_gfs_operation_t              op,
+    globus_gfs_transfer_info_t *        transfer_info,
+    void *                              user_arg)
+{
+    globus_result_t                     result;
+    globus_l_file_monitor_t *           monitor;
+    globus_byte_t *                     buffer;
+    int                                 optimal_count;
+    globus_size_t                       block_size;
+    GlobusGFSName(globus_l_gfs_file_bundle_recv);
+    GlobusGFSFileDebugEnter();
+
+    globus_gridftp_server_get_optimal_concurrency(op, &optimal_count);
+    globus_gridftp_server_get_block_size(op, &block_size);
+    globus_assert(optimal_count > 0 && block_size > 0);
+
+    result = globus_l_gfs_file_monitor_init(
+        &monitor, block_size, optimal_count);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusGFSErrorWrapFailed(
+            "globus_l_gfs_file_monitor_init", result);
+        goto error_alloc;
+    }
+    monitor->op = op;
+    monitor->pathname = globus_libc_strdup(transfer_info->pathname);
+
+    result = globus_l_gfs_file_bundle_init(monitor, transfer_info->pathname);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_init;
+    }
+    if(mkdir(transfer_info->pathname, 0777) != 0 && errno != EEXIST)
+    {
+        result = GlobusGFSErrorSystemError("mkdir", errno);
+        goto error_init;
+    }
+
+    globus_gridftp_server_set_ordered_data(op, GLOBUS_TRUE);
+    globus_gridftp_server_begin_transfer(
+        op, GLOBUS_GFS_EVENT_TRANSFER_ABORT, monitor);
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        while(optimal_count--)
+        {
+            buffer = globus_gridftp_server_buffer_get(monitor->buffers);
+            if(buffer == NULL)
+            {
+                break;
+            }
+            result = globus_gridftp_server_register_read(
+                op,
+                buffer,
+                block_size,
+                globus_l_gfs_file_bundle_read_cb,
+                monitor);
+            if(result != GLOBUS_SUCCESS)
+            {
+                globus_gridftp_server_buffer_put(monitor->buffers, buffer);
+                monitor->error = GlobusGFSErrorObjWrapFailed(
+                    "globus_gridftp_server_register_read", result);
+                break;
+            }
+            monitor->pending_reads++;
+        }
+        if(monitor->pending_reads == 0 && monitor->error == NULL)
+        {
+            monitor->error = GlobusGFSErrorObjMemory("buffer");
+        }
+        globus_l_gfs_file_bundle_check_done(monitor);
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    GlobusGFSFileDebugExit();
+    return;
+
+error_init:
+    globus_l_gfs_file_monitor_destroy(monitor);
+
+error_alloc:
+    globus_gridftp_server_finished_transfer(op, result);
+
+    GlobusGFSFileDebugExitWithError();
+}
+
+/**
+ * manifest calls
+ *
+ * The "manifest" ERET module sends the checksum of every file under a
+ * directory, one line per file:
+ *
+ *     <checksum> <size> <name>\n
+ *
+ * where name is relative to the transfer path with '%', CR and LF escaped
+ * as %XX, so a line always ends at the first LF and the name is everything
+ * after the second space.  A name too long to send fails the transfer.
+ * ERET MANIFEST="ADLER32" selects the algorithm, MD5 by default.  The files
+ * are found and summed by a tree walk and the lines are sent in the order
+ * the files finish.  Only regular files are listed and links are not
+ * followed.
+ */
+
+/* read size when summing a file */
+#define GLOBUS_L_GFS_FILE_MANIFEST_READ (256 * 1024)
+#define GLOBUS_L_GFS_FILE_MANIFEST_LINE (MAXPATHLEN * 3 + 128)
+
+typedef struct globus_l_gfs_file_manifest_s
+{
+    globus_l_file_monitor_t *           monitor;
+    /* signaled with the monitor lock as buffers come back */
+    globus_cond_t                       cond;
+    int                                 cksum_type;
+    globus_byte_t *                     out_buffer;
+    globus_size_t                       out_fill;
+    globus_off_t                        stream_offset;
+    globus_bool_t                       walk_done;
+    globus_off_t                        file_count;
+} globus_l_gfs_file_manifest_t;
+
+static
+void
+globus_l_gfs_file_manifest_destroy(
+    globus_l_gfs_file_manifest_t *      manifest)
+{
+    globus_gfs_log_message(
+        GLOBUS_GFS_LOG_INFO,
+        "Manifest of %s: %" GLOBUS_OFF_T_FORMAT " files.\n",
+        manifest->monitor->pathname ? manifest->monitor->pathname : "(unknown)",
+        manifest->file_count);
+
+    globus_cond_destroy(&manifest->cond);
+    globus_free(manifest);
+}
+
+static
+void
+globus_l_gfs_file_manifest_write_cb(
+    globus_gfs_operation_t              op,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
+    void *                              user_arg);
+
+/* called locked.  write out a full or final buffer */
+static
+globus_result_t
+globus_l_gfs_file_manifest_flush(
+    globus_l_gfs_file_manifest_t *      manifest)
+{
+    globus_l_file_monitor_t *           monitor;
+    globus_result_t                     result;
+    GlobusGFSName(globus_l_gfs_file_manifest_flush);
+
+    monitor = manifest->monitor;
+    result = globus_gridftp_server_register_write(
+        monitor->op,
+        manifest->out_buffer,
+        manifest->out_fill,
+        manifest->stream_offset,
+        -1,
+        globus_l_gfs_file_manifest_write_cb,
+        manifest);
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_list_insert(&monitor->buffer_list, manifest->out_buffer);
+        manifest->out_buffer = NULL;
+        return GlobusGFSErrorWrapFailed(
+            "globus_gridftp_server_register_write", result);
+    }
+    monitor->pending_writes++;
+    manifest->stream_offset += manifest->out_fill;
+    manifest->out_buffer = NULL;
+    manifest->out_fill = 0;
+
+    return GLOBUS_SUCCESS;
+}
+
+/* called locked.  finish the transfer once the walk and the writes are */
+static
+void
+globus_l_gfs_file_manifest_check_done(
+    globus_l_gfs_file_manifest_t *      manifest)
+{
+    globus_l_file_monitor_t *           monitor;
+
+    monitor = manifest->monitor;
+    if(!manifest->walk_done || monitor->pending_writes != 0)
+    {
+        return;
+    }
+
+    if(manifest->out_buffer != NULL)
+    {
+        globus_list_insert(&monitor->buffer_list, manifest->out_buffer);
+        manifest->out_buffer = NULL;
+    }
+    if(monitor->error != NULL)
+    {
+        globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
+    }
+    else
+    {
+        globus_assert(monitor->eof || monitor->aborted);
+        globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
+    }
+}
+
+/* walk thread.  copy a line into the network buffers, waiting for one to
+ * come back if all are being written */
+static
+globus_result_t
+globus_l_gfs_file_manifest_emit(
+    globus_l_gfs_file_manifest_t *      manifest,
+    const char *                        line,
+    globus_size_t                       length)
+{
+    globus_l_file_monitor_t *           monitor;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    globus_size_t                       n;
+    GlobusGFSName(globus_l_gfs_file_manifest_emit);
+
+    monitor = manifest->monitor;
+
+    globus_mutex_lock(&monitor->lock);
+    {
+        while(length > 0 && monitor->error == NULL && !monitor->aborted)
+        {
+            if(manifest->out_buffer == NULL)
+            {
+                if(globus_list_empty(monitor->buffer_list))
+                {
+                    globus_cond_wait(&manifest->cond, &monitor->lock);
+                    continue;
+                }
+                manifest->out_buffer = (globus_byte_t *) globus_list_remove(
+                    &monitor->buffer_list, monitor->buffer_list);
+                manifest->out_fill = 0;
+            }
+
+            n = monitor->block_size - manifest->out_fill;
+            if(n > length)
+            {
+                n = length;
+            }
+            memcpy(manifest->out_buffer + manifest->out_fill, line, n);
+            manifest->out_fill += n;
+            line += n;
+            length -= n;
+
+            if(manifest->out_fill == monitor->block_size)
+            {
+                result = globus_l_gfs_file_manifest_flush(manifest);
+                if(result != GLOBUS_SUCCESS)
+                {
+                    monitor->error = globus_error_get(result);
+                }
+            }
+        }
+        if(monitor->error != NULL || monitor->aborted)
+        {
+            result = GlobusGFSErrorGeneric("Manifest transfer stopped.");
+        }
+        else
+        {
+            manifest->file_count++;
+        }
+    }
+    globus_mutex_unlock(&monitor->lock);
+
+    return result;
+}
+
+/* walk thread.  sum one file and send its line */
+static
+globus_result_t
+globus_l_gfs_file_manifest_entry(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_l_gfs_file_walk_dir_t *      dir,
+    int                                 dir_fd,
+    const char *                        name,
+    int                                 type,
+    globus_byte_t *                     scratch)
+{
+    globus_l_gfs_file_manifest_t *      manifest;
+    globus_result_t                     result;
+    struct stat                         stat_buf;
+    MD5_CTX                             mdctx;
+    uint32_t                            adler32ctx;
+    unsigned char                       md[MD5_DIGEST_LENGTH];
+    char                                line[GLOBUS_L_GFS_FILE_MANIFEST_LINE];
+    const char *                        rel;
+    const char *                        p;
+    char *                              out;
+    char *                              end;
+    ssize_t                             rc;
+    int                                 fd;
+    int                                 i;
+    GlobusGFSName(globus_l_gfs_file_manifest_entry);
+
+    manifest = (globus_l_gfs_file_manifest_t *) walk->user_arg;
+
+    if(type != DT_REG)
+    {
+        return GLOBUS_SUCCESS;
+    }
+
+    /* it may have been replaced by a fifo or a device since it was listed,
+     * so don't block opening it and check what was opened */
+    fd = openat(dir_fd, name, O_RDONLY | O_NOFOLLOW | O_NONBLOCK);
+    if(fd < 0)
+    {
+        if(errno == ENOENT || errno == ELOOP)
+        {
+            /* removed or replaced by a link since it was listed */
+            return GLOBUS_SUCCESS;
+        }
+        return GlobusGFSErrorSystemError("open", errno);
+    }
+    if(fstat(fd, &stat_buf) != 0)
+    {
+        result = GlobusGFSErrorSystemError("fstat", errno);
+        goto error;
+    }
+    if(!S_ISREG(stat_buf.st_mode))
+    {
+        close(fd);
+        return GLOBUS_SUCCESS;
+    }
+
+    MD5_Init(&mdctx);
+    adler32ctx = adler32(0, NULL, 0);
+    for(;;)
+    {
+        rc = read(fd, scratch, GLOBUS_L_GFS_FILE_MANIFEST_READ);
+        if(rc < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(rc < 0)
+        {
+            result = GlobusGFSErrorSystemError("read", errno);
+            goto error;
+        }
+        if(rc == 0)
+        {
+            break;
+        }
+        if(manifest->cksum_type == GLOBUS_GFS_FILE_CKSM_TYPE_MD5)
+        {
+            MD5_Update(&mdctx, scratch, rc);
+        }
+        else
+        {
+            adler32ctx = adler32(adler32ctx, scratch, rc);
+        }
+    }
+    close(fd);
+
+    out = line;
+    end = line + sizeof(line) - 8;
+    if(manifest->cksum_type == GLOBUS_GFS_FILE_CKSM_TYPE_MD5)
+    {
+        MD5_Final(md, &mdctx);
+        for(i = 0; i < MD5_DIGEST_LENGTH; i++)
+        {
+            out += sprintf(out, "%02x", md[i]);
+        }
+    }
+    else
+    {
+        out += sprintf(out, "%08x", adler32ctx);
+    }
+    out += sprintf(out, " %" GLOBUS_OFF_T_FORMAT " ",
+        (globus_off_t) stat_buf.st_size);
+
+    rel = globus_l_gfs_file_walk_relative(walk, dir);
+    for(i = 0; i < 2; i++)
+    {
+        for(p = i == 0 ? rel : name; *p; p++)
+        {
+            if(out >= end)
+            {
+                return GlobusGFSErrorGeneric("File name too long for manifest.");
+            }
+            if(*p == '%' || *p == '\r' || *p == '\n')
+            {
+                out += sprintf(out, "%%%02X", (unsigned char) *p);
+            }
+            else
+            {
+                *out++ = *p;
+            }
+        }
+        if(i == 0 && *rel)
         {
-            globus_mutex_unlock(&monitor->lock);
+            *out++ = '/';
         }
     }
-    /* already unlocked */
-    
-    GlobusGFSFileDebugExit();
-    return;
+    *out++ = '\n';
 
-error:
-    if(monitor->pending_reads != 0 || monitor->pending_writes != 0)
-    {
-        /* there are still outstanding callbacks, wait for them */
-        globus_mutex_unlock(&monitor->lock);
-    
-        GlobusGFSFileDebugExitWithError();
-        return;
-    }
-    globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
-    globus_mutex_unlock(&monitor->lock);
+    return globus_l_gfs_file_manifest_emit(manifest, line, out - line);
 
-    GlobusGFSFileDebugExitWithError();
+error:
+    close(fd);
+    return result;
 }
 
 static
 void
-globus_l_gfs_file_read_cb(
-    globus_xio_handle_t                 xio_handle, 
-    globus_result_t                     result,
-    globus_byte_t *                     buffer,
-    globus_size_t                       len,
-    globus_size_t                       nbytes, 
-    globus_xio_data_descriptor_t        data_desc,
-    void *                              user_arg)
+globus_l_gfs_file_manifest_done(
+    globus_l_gfs_file_walk_t *          walk,
+    globus_result_t                     result)
 {
+    globus_l_gfs_file_manifest_t *      manifest;
     globus_l_file_monitor_t *           monitor;
-    GlobusGFSName(globus_l_gfs_file_read_cb);
+    GlobusGFSName(globus_l_gfs_file_manifest_done);
     GlobusGFSFileDebugEnter();
-    
-    monitor = (globus_l_file_monitor_t *) user_arg;
-    
+
+    manifest = (globus_l_gfs_file_manifest_t *) walk->user_arg;
+    monitor = manifest->monitor;
+
+    globus_l_gfs_file_walk_destroy(walk);
+
     globus_mutex_lock(&monitor->lock);
     {
-        monitor->pending_reads--;
-        if(result != GLOBUS_SUCCESS && monitor->error == NULL)
+        manifest->walk_done = GLOBUS_TRUE;
+        if(result != GLOBUS_SUCCESS)
         {
-            if(globus_xio_error_is_eof(result))
+            if(monitor->error == NULL && !monitor->aborted)
             {
-                monitor->eof = GLOBUS_TRUE;
+                monitor->error = globus_error_get(result);
             }
             else
             {
-                monitor->error = GlobusGFSErrorObjWrapFailed(
-                    "callback", result);
+                globus_object_free(globus_error_get(result));
             }
         }
-        if(monitor->error != NULL)
-        {
-            globus_list_insert(&monitor->buffer_list, buffer);
-            goto error;
-        }
-        
-        if(nbytes > 0)
+        else if(monitor->error == NULL && !monitor->aborted)
         {
-            result = globus_gridftp_server_register_write(
-                monitor->op,
-                buffer,
-                nbytes,
-                monitor->file_offset,
-                -1,
-                globus_l_gfs_file_server_write_cb,
-                monitor);
-            if(result != GLOBUS_SUCCESS)
-            {
-                globus_list_insert(&monitor->buffer_list, buffer);
-                monitor->error = GlobusGFSErrorObjWrapFailed(
-                    "globus_gridftp_server_register_write", result);
-                goto error;
-            }
-            
-            monitor->pending_writes++;
-            monitor->file_offset += nbytes;
-            if(monitor->read_length != -1)
+            if(manifest->out_buffer != NULL && manifest->out_fill > 0)
             {
-                monitor->read_length -= nbytes;
+                result = globus_l_gfs_file_manifest_flush(manifest);
+                if(result != GLOBUS_SUCCESS)
+                {
+                    monitor->error = globus_error_get(result);
+                }
             }
+            monitor->eof = GLOBUS_TRUE;
         }
-        else
-        {
-            globus_list_insert(&monitor->buffer_list, buffer);
-        }
-                    
-        if(monitor->read_length == 0)
-        {
-            monitor->first_read = GLOBUS_TRUE;
-        }
-        
-        result = globus_l_gfs_file_dispatch_read(monitor);
-        if(result != GLOBUS_SUCCESS)
-        {
-            monitor->error = GlobusGFSErrorObjWrapFailed(
-                "globus_l_gfs_file_dispatch_read", result);
-            goto error;
-        }
-       
-        if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
-        {
-            globus_assert(monitor->eof || monitor->aborted);
-            globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
-            globus_mutex_unlock(&monitor->lock);
-        }
-        else
-        {
-            globus_mutex_unlock(&monitor->lock);
-        }
-    }
-    /* already unlocked */
-
-    GlobusGFSFileDebugExit();
-    return;
-
-error:
-    globus_assert(monitor->pending_reads == 0);
-    if(monitor->pending_writes != 0)
-    {
-        /* there are still outstanding callbacks, wait for them */
-        globus_mutex_unlock(&monitor->lock);
-    
-        GlobusGFSFileDebugExitWithError();
-        return;
+        globus_l_gfs_file_manifest_check_done(manifest);
     }
-    globus_l_gfs_file_close(monitor, globus_error_put(monitor->error));
     globus_mutex_unlock(&monitor->lock);
 
-    GlobusGFSFileDebugExitWithError();
+    GlobusGFSFileDebugExit();
 }
 
 static
 void
-globus_l_gfs_file_open_read_cb(
-    globus_xio_handle_t                 handle,
+globus_l_gfs_file_manifest_write_cb(
+    globus_gfs_operation_t              op,
     globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       nbytes,
     void *                              user_arg)
 {
+    globus_l_gfs_file_manifest_t *      manifest;
     globus_l_file_monitor_t *           monitor;
-    GlobusGFSName(globus_l_gfs_file_open_read_cb);
+    GlobusGFSName(globus_l_gfs_file_manifest_write_cb);
     GlobusGFSFileDebugEnter();
-    
-    monitor = (globus_l_file_monitor_t *) user_arg;
-    if(result != GLOBUS_SUCCESS)
-    {
-        result = GlobusGFSErrorWrapFailed(
-            "globus_l_gfs_file_open_write_cb", result);
-        monitor->file_handle = NULL;
-        goto error_open;
-    }
-    
-    globus_gridftp_server_begin_transfer(
-        monitor->op, GLOBUS_GFS_EVENT_TRANSFER_ABORT, monitor);
-    
+
+    manifest = (globus_l_gfs_file_manifest_t *) user_arg;
+    monitor = manifest->monitor;
+
     globus_mutex_lock(&monitor->lock);
-    monitor->first_read = GLOBUS_TRUE;
-    result = globus_l_gfs_file_dispatch_read(monitor);
-    if(result != GLOBUS_SUCCESS)
-    {
-        monitor->error = GlobusGFSErrorObjWrapFailed(
-            "globus_l_gfs_file_dispatch_read", result);
-        goto error_dispatch;
-    }
-    
-    if(monitor->pending_reads == 0 && monitor->pending_writes == 0)
     {
-        globus_assert(monitor->eof || monitor->aborted);
+        monitor->pending_writes--;
+        globus_list_insert(&monitor->buffer_list, buffer);
 
-        globus_l_gfs_file_close(monitor, GLOBUS_SUCCESS);
-        globus_mutex_unlock(&monitor->lock);
-    }
-    else
-    {
-        globus_mutex_unlock(&monitor->lock);
+        if(result != GLOBUS_SUCCESS && monitor->error == NULL)
+        {
+            monitor->error = GlobusGFSErrorObjWrapFailed("callback", result);
+        }
+        globus_cond_broadcast(&manifest->cond);
+        globus_l_gfs_file_manifest_check_done(manifest);
     }
-    
-    GlobusGFSFileDebugExit();
-    return;
-
-error_dispatch:
     globus_mutex_unlock(&monitor->lock);
 
-error_open:
-    globus_gridftp_server_finished_transfer(monitor->op, result);
-    globus_l_gfs_file_monitor_destroy(monitor);
-
-    GlobusGFSFileDebugExitWithError();
+    GlobusGFSFileDebugExit();
 }
 
 static
 void
-globus_l_gfs_file_send(
+globus_l_gfs_file_manifest_send(
     globus_gfs_operation_t              op,
     globus_gfs_transfer_info_t *        transfer_info,
     void *                              user_arg)
 {
     globus_result_t                     result;
     globus_l_file_monitor_t *           monitor;
+    globus_l_gfs_file_manifest_t *      manifest;
+    globus_l_gfs_file_walk_t *          walk;
+    globus_byte_t *                     buffer;
     int                                 optimal_count;
     globus_size_t                       block_size;
-    globus_xio_file_flag_t              open_flags;
-    GlobusGFSName(globus_l_gfs_file_send);
+    const char *                        algorithm;
+    GlobusGFSName(globus_l_gfs_file_manifest_send);
     GlobusGFSFileDebugEnter();
-    
+
+    algorithm = transfer_info->module_args;
+    if(algorithm == NULL || *algorithm == '\0')
+    {
+        algorithm = "md5";
+    }
+    if(strcasecmp(algorithm, "md5") && strcasecmp(algorithm, "adler32"))
+    {
+        result = GlobusGFSErrorGeneric("Unknown checksum algorithm requested.");
+        goto error_alloc;
+    }
+
     globus_gridftp_server_get_optimal_concurrency(op, &optimal_count);
     globus_gridftp_server_get_block_size(op, &block_size);
     globus_assert(optimal_count > 0 && block_size > 0);
-    
+
     result = globus_l_gfs_file_monitor_init(
         &monitor, block_size, optimal_count);
     if(result != GLOBUS_SUCCESS)
@@ -3316,35 +6716,63 @@ globus_l_gfs_file_send(
             "globus_l_gfs_file_monitor_init", result);
         goto error_alloc;
     }
-          
+    monitor->op = op;
+    monitor->pathname = globus_libc_strdup(transfer_info->pathname);
+
+    manifest = (globus_l_gfs_file_manifest_t *)
+        globus_calloc(1, sizeof(globus_l_gfs_file_manifest_t));
+    if(manifest == NULL)
+    {
+        result = GlobusGFSErrorMemory("manifest");
+        goto error_init;
+    }
+    globus_cond_init(&manifest->cond, NULL);
+    manifest->monitor = monitor;
+    manifest->cksum_type = strcasecmp(algorithm, "md5") == 0 ?
+        GLOBUS_GFS_FILE_CKSM_TYPE_MD5 : GLOBUS_GFS_FILE_CKSM_TYPE_ADLER32;
+    monitor->manifest = manifest;
+
     while(optimal_count--)
     {
-        globus_byte_t *                 buffer;
-        buffer = globus_memory_pop_node(&monitor->mem);
+        buffer = globus_gridftp_server_buffer_get(monitor->buffers);
+        if(buffer == NULL)
+        {
+            break;
+        }
         globus_list_insert(&monitor->buffer_list, buffer);
     }
-    monitor->session = (gfs_l_file_session_t *) user_arg;
-
-    monitor->op = op;
-    monitor->pathname = globus_libc_strdup(transfer_info->pathname);
-
-    open_flags = GLOBUS_XIO_FILE_BINARY | GLOBUS_XIO_FILE_RDONLY;
+    if(globus_list_empty(monitor->buffer_list))
+    {
+        result = GlobusGFSErrorMemory("buffer");
+        goto error_init;
+    }
 
-    result = globus_l_gfs_file_open(
-        &monitor->file_handle, transfer_info->pathname, open_flags, monitor);
+    result = globus_l_gfs_file_walk_init(
+        &walk,
+        transfer_info->pathname,
+        GLOBUS_L_GFS_FILE_MANIFEST_READ,
+        globus_l_gfs_file_manifest_entry,
+        NULL,
+        globus_l_gfs_file_manifest_done,
+        manifest);
     if(result != GLOBUS_SUCCESS)
     {
-        result = GlobusGFSErrorWrapFailed("globus_l_gfs_file_open", result);
-        goto error_open;
+        goto error_init;
     }
-    
+
+    globus_gridftp_server_begin_transfer(
+        op, GLOBUS_GFS_EVENT_TRANSFER_ABORT, monitor);
+
+    /* finished when the walk and its writes are done */
+    globus_l_gfs_file_walk_start(walk);
+
     GlobusGFSFileDebugExit();
     return;
 
-error_open:
+error_init:
     globus_l_gfs_file_monitor_destroy(monitor);
-    
-error_alloc:  
+
+error_alloc:
     globus_gridftp_server_finished_transfer(op, result);
 
     GlobusGFSFileDebugExitWithError();
@@ -3371,11 +6799,15 @@ globus_l_gfs_file_event(
             }
             globus_mutex_unlock(&monitor->lock);
             
-            globus_xio_handle_cancel_operations(
-                monitor->file_handle,
-                GLOBUS_XIO_CANCEL_OPEN | 
-                GLOBUS_XIO_CANCEL_READ |
-                GLOBUS_XIO_CANCEL_WRITE);
+            /* bundle transfers have no xio handle */
+            if(monitor->file_handle != NULL)
+            {
+                globus_xio_handle_cancel_operations(
+                    monitor->file_handle,
+                    GLOBUS_XIO_CANCEL_OPEN | 
+                    GLOBUS_XIO_CANCEL_READ |
+                    GLOBUS_XIO_CANCEL_WRITE);
+            }
             break;
             
         default:
@@ -3466,6 +6898,44 @@ static globus_gfs_storage_iface_t       globus_l_gfs_file_dsi_iface =
     globus_l_gfs_file_realpath
 };
 
+static globus_gfs_storage_iface_t       globus_l_gfs_file_manifest_iface = 
+{
+    0,
+    NULL, /* init */
+    NULL, /* destroy */
+    NULL, /* list */
+    globus_l_gfs_file_manifest_send,
+    NULL, /* recv */
+    NULL, /* trev */
+    NULL, /* active */
+    NULL, /* passive */
+    NULL, /* data destroy */
+    NULL, /* command */
+    NULL, /* stat */
+    NULL,
+    NULL,
+    NULL
+};
+
+static globus_gfs_storage_iface_t       globus_l_gfs_file_bundle_iface = 
+{
+    0,
+    NULL, /* init */
+    NULL, /* destroy */
+    NULL, /* list */
+    globus_l_gfs_file_bundle_send,
+    globus_l_gfs_file_bundle_recv,
+    NULL, /* trev */
+    NULL, /* active */
+    NULL, /* passive */
+    NULL, /* data destroy */
+    NULL, /* command */
+    NULL, /* stat */
+    NULL,
+    NULL,
+    NULL
+};
+
 GlobusExtensionDefineModule(globus_gridftp_server_file) =
 {
     "globus_gridftp_server_file",
@@ -3496,9 +6966,26 @@ globus_l_gfs_file_activate(void)
         "file",
         GlobusExtensionMyModule(globus_gridftp_server_file),
         &globus_l_gfs_file_dsi_iface);
+    globus_extension_registry_add(
+        GLOBUS_GFS_DSI_REGISTRY,
+        "bundle",
+        GlobusExtensionMyModule(globus_gridftp_server_file),
+        &globus_l_gfs_file_bundle_iface);
+    globus_extension_registry_add(
+        GLOBUS_GFS_DSI_REGISTRY,
+        "manifest",
+        GlobusExtensionMyModule(globus_gridftp_server_file),
+        &globus_l_gfs_file_manifest_iface);
 
     GlobusDebugInit(GLOBUS_GRIDFTP_SERVER_FILE,
         ERROR WARNING TRACE INTERNAL_TRACE INFO STATE INFO_VERBOSE);
+
+    globus_mutex_init(&globus_l_gfs_file_aio_pool.lock, NULL);
+    globus_cond_init(&globus_l_gfs_file_aio_pool.cond, NULL);
+    globus_fifo_init(&globus_l_gfs_file_aio_pool.queue);
+    globus_l_gfs_file_aio_pool.thread_count = 0;
+    globus_l_gfs_file_aio_pool.idle_count = 0;
+    globus_l_gfs_file_aio_pool.shutdown = GLOBUS_FALSE;
     
     return GLOBUS_SUCCESS;
     
@@ -3515,6 +7002,27 @@ globus_l_gfs_file_deactivate(void)
 {
     globus_extension_registry_remove(
         GLOBUS_GFS_DSI_REGISTRY, "file");
+    globus_extension_registry_remove(
+        GLOBUS_GFS_DSI_REGISTRY, "bundle");
+    globus_extension_registry_remove(
+        GLOBUS_GFS_DSI_REGISTRY, "manifest");
+
+    /* wait for the aio threads to exit */
+    globus_mutex_lock(&globus_l_gfs_file_aio_pool.lock);
+    {
+        globus_l_gfs_file_aio_pool.shutdown = GLOBUS_TRUE;
+        globus_cond_broadcast(&globus_l_gfs_file_aio_pool.cond);
+        while(globus_l_gfs_file_aio_pool.thread_count > 0)
+        {
+            globus_cond_wait(
+                &globus_l_gfs_file_aio_pool.cond,
+                &globus_l_gfs_file_aio_pool.lock);
+        }
+    }
+    globus_mutex_unlock(&globus_l_gfs_file_aio_pool.lock);
+    globus_fifo_destroy(&globus_l_gfs_file_aio_pool.queue);
+    globus_cond_destroy(&globus_l_gfs_file_aio_pool.cond);
+    globus_mutex_destroy(&globus_l_gfs_file_aio_pool.lock);
         
     globus_xio_driver_unload(globus_l_gfs_file_driver);
     
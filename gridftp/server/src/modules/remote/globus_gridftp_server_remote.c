@@ -52,6 +52,8 @@ typedef struct globus_l_gfs_remote_handle_s
     void *                              state;
     globus_gfs_session_info_t           session_info;
     int                                 striped_mode;
+    /* data node connections kept open between transfers */
+    globus_list_t *                     idle_nodes;
 } globus_l_gfs_remote_handle_t;
 
 typedef struct globus_l_gfs_remote_node_handle_s
@@ -168,6 +170,31 @@ void
 globus_l_gfs_remote_select_nodes(
     globus_l_gfs_remote_control_node_bounce_t * bounce);
 
+static
+void
+globus_l_gfs_remote_node_free(
+    globus_l_gfs_remote_node_info_t *   node_info,
+    globus_gfs_brain_reason_t           release_reason)
+{
+    globus_gfs_brain_release_node(
+        node_info->brain_node,
+        release_reason);
+    globus_gfs_ipc_close(node_info->ipc_handle, NULL, NULL);
+    if(node_info->cs != NULL)
+    {
+        globus_free(node_info->cs);
+    }
+    if(node_info->username)
+    {
+        globus_free(node_info->username);
+    }
+    if(node_info->home_dir)
+    {
+        globus_free(node_info->home_dir);
+    }
+    globus_free(node_info);
+}
+
 static
 globus_result_t
 globus_l_gfs_remote_node_release(
@@ -179,29 +206,71 @@ globus_l_gfs_remote_node_release(
     
     if(node_info->my_handle->control_node != node_info)
     {
-        globus_gfs_brain_release_node(
-            node_info->brain_node,
-            release_reason);
-        globus_gfs_ipc_close(node_info->ipc_handle, NULL, NULL);
-        if(node_info->cs != NULL)
-        {
-            globus_free(node_info->cs);
-        }
-        if(node_info->username)
-        {
-            globus_free(node_info->username);
-        }
-        if(node_info->home_dir)
-        {
-            globus_free(node_info->home_dir);
-        }
-        globus_free(node_info);
+        globus_l_gfs_remote_node_free(node_info, release_reason);
     }
 
     GlobusGFSRemoteDebugExit();
     return GLOBUS_SUCCESS;
 }  
 
+/* an idle connection failed.  it is already off the idle list, so it
+ * is closed here rather than from inside the ipc error callback */
+static
+void
+globus_l_gfs_remote_idle_node_error_kickout(
+    void *                              user_arg)
+{
+    globus_l_gfs_remote_node_free(
+        (globus_l_gfs_remote_node_info_t *) user_arg,
+        GLOBUS_GFS_BRAIN_REASON_ERROR);
+}
+
+/* called locked.  remove and return the idle node that owns ipc_handle,
+ * or the first idle node if ipc_handle is NULL */
+static
+globus_l_gfs_remote_node_info_t *
+globus_l_gfs_remote_idle_node_remove(
+    globus_l_gfs_remote_handle_t *      my_handle,
+    globus_gfs_ipc_handle_t             ipc_handle)
+{
+    globus_list_t *                     list;
+    globus_l_gfs_remote_node_info_t *   node_info;
+
+    for(list = my_handle->idle_nodes;
+        !globus_list_empty(list);
+        list = globus_list_rest(list))
+    {
+        node_info = (globus_l_gfs_remote_node_info_t *)
+            globus_list_first(list);
+        if(ipc_handle == NULL || node_info->ipc_handle == ipc_handle)
+        {
+            globus_list_remove(&my_handle->idle_nodes, list);
+            return node_info;
+        }
+    }
+
+    return NULL;
+}
+
+static
+void
+globus_l_gfs_remote_node_reuse_kickout(
+    void *                              user_arg)
+{
+    globus_l_gfs_remote_node_info_t *   node_info;
+    GlobusGFSName(globus_l_gfs_remote_node_reuse_kickout);
+    GlobusGFSRemoteDebugEnter();
+
+    node_info = (globus_l_gfs_remote_node_info_t *) user_arg;
+
+    node_info->callback(
+        node_info,
+        GLOBUS_SUCCESS,
+        node_info->user_arg);
+
+    GlobusGFSRemoteDebugExit();
+}
+
 static
 void
 globus_l_gfs_remote_ipc_error_cb(
@@ -210,11 +279,26 @@ globus_l_gfs_remote_ipc_error_cb(
     void *                              user_arg)
 {
     globus_l_gfs_remote_handle_t *      my_handle;
+    globus_l_gfs_remote_node_info_t *   node_info;
     GlobusGFSName(globus_l_gfs_remote_ipc_error_cb);
     GlobusGFSRemoteDebugEnter();
 
     my_handle = (globus_l_gfs_remote_handle_t *) user_arg;
-    my_handle->ipc_release_reason = GLOBUS_GFS_BRAIN_REASON_ERROR;
+    globus_mutex_lock(&my_handle->mutex);
+    {
+        my_handle->ipc_release_reason = GLOBUS_GFS_BRAIN_REASON_ERROR;
+        node_info = globus_l_gfs_remote_idle_node_remove(
+            my_handle, ipc_handle);
+        if(node_info != NULL)
+        {
+            globus_callback_register_oneshot(
+                NULL,
+                NULL,
+                globus_l_gfs_remote_idle_node_error_kickout,
+                node_info);
+        }
+    }
+    globus_mutex_unlock(&my_handle->mutex);
     globus_gfs_log_result(
         GLOBUS_GFS_LOG_ERR, "IPC ERROR", result);
 
@@ -509,6 +593,7 @@ globus_l_gfs_remote_node_request(
     int                                 ndx_offset = 0;
     globus_result_t                     result = GLOBUS_SUCCESS;
     globus_l_gfs_remote_control_node_bounce_t * bounce;
+    globus_l_gfs_remote_node_info_t *   node_info;
     GlobusGFSName(globus_l_gfs_remote_node_request);
     GlobusGFSRemoteDebugEnter();
 
@@ -540,6 +625,31 @@ globus_l_gfs_remote_node_request(
         }
     }
     num_nodes -= nodes_created;
+
+    /* hand out connections left open by earlier transfers before
+     * asking the brain for new ones */
+    while(num_nodes > 0 && !globus_list_empty(my_handle->idle_nodes))
+    {
+        node_info = globus_l_gfs_remote_idle_node_remove(my_handle, NULL);
+        node_info->callback = callback;
+        node_info->user_arg = user_arg;
+        node_info->node_ndx = ndx_offset;
+
+        result = globus_callback_register_oneshot(
+            NULL,
+            NULL,
+            globus_l_gfs_remote_node_reuse_kickout,
+            node_info);
+        if(result != GLOBUS_SUCCESS)
+        {
+            globus_l_gfs_remote_node_release(
+                node_info, GLOBUS_GFS_BRAIN_REASON_ERROR);
+            goto error;
+        }
+        nodes_created++;
+        ndx_offset++;
+        num_nodes--;
+    }
     
     if(num_nodes > 0 || nodes_created == 0)
     {   
@@ -1738,9 +1848,24 @@ globus_l_gfs_remote_data_destroy(
             if(node_info->cs != NULL)
             {
                 globus_free(node_info->cs);
+                node_info->cs = NULL;
             }
             node_info->data_arg = NULL;
             node_info->stripe_count = 0;
+            if(result == GLOBUS_SUCCESS &&
+                node_info != my_handle->control_node &&
+                my_handle->ipc_release_reason ==
+                    GLOBUS_GFS_BRAIN_REASON_COMPLETE &&
+                globus_gfs_config_get_bool("data_node_reuse"))
+            {
+                node_info->bounce = NULL;
+                node_info->node_handle = NULL;
+                node_info->event_arg = NULL;
+                node_info->event_mask = 0;
+                node_info->error_count = 0;
+                globus_list_insert(&my_handle->idle_nodes, node_info);
+                continue;
+            }
             result = globus_l_gfs_remote_node_release(
                 node_info, my_handle->ipc_release_reason);
             if(result != GLOBUS_SUCCESS)
@@ -1960,6 +2085,18 @@ globus_l_gfs_remote_session_end(
         goto error;
     }
 
+    globus_mutex_lock(&my_handle->mutex);
+    {
+        while(!globus_list_empty(my_handle->idle_nodes))
+        {
+            globus_l_gfs_remote_node_release(
+                globus_list_remove(
+                    &my_handle->idle_nodes, my_handle->idle_nodes),
+                my_handle->ipc_release_reason);
+        }
+    }
+    globus_mutex_unlock(&my_handle->mutex);
+
     control_node = my_handle->control_node;
     my_handle->control_node = NULL;
     result = globus_l_gfs_remote_node_release(
@@ -0,0 +1,659 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "globus_common.h"
+#include "globus_gridftp_server.h"
+#include "globus_preload.h"
+
+#include "globus_i_gfs_data.c"
+
+/*
+ * Checks how HTTP DOWNLOAD splits a download into ranges.
+ *
+ * The range cases call globus_l_gfs_data_http_check_range() directly.  The
+ * download cases run globus-gridftp-server from PATH and a small HTTP server
+ * in this process, and send SITE HTTP DOWNLOAD with STREAMS=4 over an
+ * anonymous control connection.  The HTTP server answers range requests,
+ * ignores them, or answers them with the wrong Content-Range, and the file
+ * the gridftp server writes is compared with the resource byte for byte.
+ */
+
+#define FILE_SIZE (4 * 1024 * 1024)
+#define STREAMS 4
+#define TIMEOUT 120
+
+typedef struct
+{
+    char *                              test_name;
+    /* NULL for no Content-Range header */
+    char *                              header_name;
+    char *                              content_range;
+    globus_off_t                        start;
+    globus_off_t                        end;
+    globus_off_t                        length;
+    bool                                expected_result;
+}
+range_test_case_t;
+
+typedef enum
+{
+    HTTP_HONOUR_RANGE,
+    HTTP_IGNORE_RANGE,
+    /* answer the first range, or the later ones, one byte off */
+    HTTP_SHIFT_FIRST_RANGE,
+    HTTP_SHIFT_LATER_RANGES
+}
+http_mode_t;
+
+static pid_t                            http_pid = -1;
+static pid_t                            ftp_pid = -1;
+static globus_byte_t *                  resource;
+static char                             work_dir[] = "/tmp/http-range-testXXXXXX";
+
+static
+int
+range_test(const range_test_case_t *test_case)
+{
+    globus_hashtable_t                  header_table;
+    globus_xio_http_header_t            header;
+    globus_result_t                     result;
+    char *                              message;
+    bool                                ok;
+
+    globus_hashtable_init(
+        &header_table,
+        16,
+        globus_hashtable_string_hash,
+        globus_hashtable_string_keyeq);
+    if (test_case->content_range != NULL)
+    {
+        header.name = test_case->header_name;
+        header.value = test_case->content_range;
+        globus_hashtable_insert(&header_table, header.name, &header);
+    }
+
+    result = globus_l_gfs_data_http_check_range(
+        &header_table, test_case->start, test_case->end, test_case->length);
+    ok = (result == GLOBUS_SUCCESS) == test_case->expected_result;
+    if (result != GLOBUS_SUCCESS)
+    {
+        message = globus_error_print_friendly(globus_error_peek(result));
+        printf("# %s: %s", test_case->test_name, message);
+        free(message);
+        globus_object_free(globus_error_get(result));
+    }
+    globus_hashtable_destroy(&header_table);
+
+    return ok ? 0 : 1;
+}
+
+static
+int
+listen_port(int *port)
+{
+    struct sockaddr_in                  addr;
+    socklen_t                           addr_len = sizeof(addr);
+    int                                 fd;
+    int                                 on = 1;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0 ||
+        listen(fd, 16) != 0 ||
+        getsockname(fd, (struct sockaddr *) &addr, &addr_len) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+
+    return fd;
+}
+
+static
+int
+write_all(int fd, const void *buffer, size_t length)
+{
+    const char *                        p = buffer;
+    ssize_t                             n;
+
+    while (length > 0)
+    {
+        n = write(fd, p, length);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return -1;
+        }
+        p += n;
+        length -= n;
+    }
+    return 0;
+}
+
+/* answer one request, reporting 'P' for a 206 or 'F' for a 200 */
+static
+void
+http_answer(int fd, http_mode_t mode, int report_fd)
+{
+    char                                request[4096];
+    char                                header[512];
+    size_t                              length = 0;
+    ssize_t                             n;
+    char *                              line;
+    long                                first = -1;
+    long                                last = -1;
+    long                                shift;
+
+    while (length < sizeof(request) - 1 &&
+        (length < 4 || strstr(request, "\r\n\r\n") == NULL))
+    {
+        n = read(fd, request + length, sizeof(request) - 1 - length);
+        if (n <= 0)
+        {
+            return;
+        }
+        length += n;
+        request[length] = '\0';
+    }
+
+    for (line = strstr(request, "\r\n"); line != NULL;
+        line = strstr(line + 2, "\r\n"))
+    {
+        if (strncasecmp(line + 2, "Range: bytes=", 13) == 0)
+        {
+            sscanf(line + 15, "%ld-%ld", &first, &last);
+        }
+    }
+
+    if (first >= 0 && last >= first && last < FILE_SIZE &&
+        mode != HTTP_IGNORE_RANGE)
+    {
+        shift = (mode == HTTP_SHIFT_FIRST_RANGE && first == 0) ||
+            (mode == HTTP_SHIFT_LATER_RANGES && first > 0) ? 1 : 0;
+        snprintf(header, sizeof(header),
+            "HTTP/1.1 206 Partial Content\r\n"
+            "Content-Length: %ld\r\n"
+            "Content-Range: bytes %ld-%ld/%ld\r\n"
+            "Connection: close\r\n\r\n",
+            last - first + 1, first + shift, last + shift, (long) FILE_SIZE);
+        write(report_fd, "P", 1);
+    }
+    else
+    {
+        first = 0;
+        last = FILE_SIZE - 1;
+        snprintf(header, sizeof(header),
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Length: %ld\r\n"
+            "Connection: close\r\n\r\n",
+            (long) FILE_SIZE);
+        write(report_fd, "F", 1);
+    }
+    if (write_all(fd, header, strlen(header)) == 0)
+    {
+        write_all(fd, resource + first, last - first + 1);
+    }
+}
+
+/* each connection is answered by its own process, so that all the ranges
+ * of a download can be open at once */
+static
+pid_t
+http_server_start(int listen_fd, http_mode_t mode, int report_fd)
+{
+    pid_t                               pid;
+    int                                 fd;
+
+    fflush(stdout);
+    pid = fork();
+    if (pid != 0)
+    {
+        return pid;
+    }
+    signal(SIGCHLD, SIG_IGN);
+    for (;;)
+    {
+        fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            continue;
+        }
+        if (fork() == 0)
+        {
+            close(listen_fd);
+            http_answer(fd, mode, report_fd);
+            shutdown(fd, SHUT_WR);
+            close(fd);
+            _exit(0);
+        }
+        close(fd);
+    }
+}
+
+static
+pid_t
+ftp_server_start(int port)
+{
+    struct passwd *                     pw;
+    char                                port_str[16];
+    pid_t                               pid;
+    int                                 fd;
+
+    pid = fork();
+    if (pid != 0)
+    {
+        return pid;
+    }
+    /* anonymous sessions are not run as root */
+    if (getuid() == 0 && (pw = getpwnam("nobody")) != NULL)
+    {
+        setgroups(0, NULL);
+        if (setgid(pw->pw_gid) != 0 || setuid(pw->pw_uid) != 0)
+        {
+            _exit(1);
+        }
+    }
+    fd = open("/dev/null", O_RDWR);
+    dup2(fd, STDIN_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    dup2(fd, STDERR_FILENO);
+    snprintf(port_str, sizeof(port_str), "%d", port);
+    execlp("globus-gridftp-server", "globus-gridftp-server",
+        "-no-fork", "-no-chdir", "-aa",
+        "-p", port_str, "-control-interface", "127.0.0.1",
+        "-d", "0", NULL);
+    _exit(1);
+}
+
+/* read one reply, skipping 1xx markers, and return its code */
+static
+int
+ftp_reply(FILE *control)
+{
+    char                                line[1024];
+    int                                 code;
+
+    do
+    {
+        if (fgets(line, sizeof(line), control) == NULL)
+        {
+            return -1;
+        }
+        printf("# %s", line);
+        code = 0;
+        if (isdigit(line[0]) && isdigit(line[1]) && isdigit(line[2]) &&
+            line[3] == ' ')
+        {
+            code = atoi(line);
+        }
+    }
+    while (code < 200);
+
+    return code;
+}
+
+static
+int
+ftp_command(FILE *control, const char *command)
+{
+    fprintf(control, "%s\r\n", command);
+    fflush(control);
+
+    return ftp_reply(control);
+}
+
+static
+FILE *
+ftp_login(int port)
+{
+    struct sockaddr_in                  addr;
+    FILE *                              control = NULL;
+    int                                 fd = -1;
+    int                                 i;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    for (i = 0; i < 50 && fd < 0; i++)
+    {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0)
+        {
+            close(fd);
+            fd = -1;
+            usleep(100000);
+        }
+    }
+    if (fd < 0 || (control = fdopen(fd, "r+")) == NULL)
+    {
+        return NULL;
+    }
+    if (ftp_reply(control) != 220 ||
+        ftp_command(control, "USER anonymous") != 331 ||
+        ftp_command(control, "PASS test@localhost") != 230)
+    {
+        fclose(control);
+        return NULL;
+    }
+
+    return control;
+}
+
+/* download the resource with STREAMS streams, and check the reply code,
+ * the responses the HTTP server sent, and the file */
+static
+int
+download_test(
+    http_mode_t                         mode,
+    int                                 ftp_port,
+    int                                 expected_code,
+    const char *                        expected_responses)
+{
+    FILE *                              control = NULL;
+    char                                request[256];
+    globus_byte_t                       request_b64[512];
+    char                                responses[64];
+    char *                              path = NULL;
+    char *                              command = NULL;
+    globus_byte_t *                     got = NULL;
+    struct stat                         st;
+    int                                 report[2] = { -1, -1 };
+    int                                 listen_fd;
+    int                                 http_port;
+    int                                 fd;
+    int                                 code;
+    ssize_t                             n;
+    size_t                              got_length = 0;
+    int                                 rc = 1;
+    static int                          count;
+
+    listen_fd = listen_port(&http_port);
+    if (listen_fd < 0 || pipe(report) != 0)
+    {
+        printf("# unable to start the HTTP server\n");
+        goto cleanup;
+    }
+    http_pid = http_server_start(listen_fd, mode, report[1]);
+    close(report[1]);
+    report[1] = -1;
+
+    control = ftp_login(ftp_port);
+    if (control == NULL)
+    {
+        printf("# unable to log in to the gridftp server\n");
+        goto cleanup;
+    }
+
+    path = globus_common_create_string("%s/download.%d", work_dir, count++);
+    snprintf(request, sizeof(request),
+        "GET http://127.0.0.1:%d/resource HTTP/1.1\r\n"
+        "Host: 127.0.0.1:%d\r\n\r\n",
+        http_port, http_port);
+    globus_l_gfs_base64_encode(
+        (unsigned char *) request, strlen(request), request_b64, NULL);
+    command = globus_common_create_string(
+        "SITE HTTP DOWNLOAD OFFSET=0;LENGTH=%d;PATH=%s;REQUEST=%s;STREAMS=%d;",
+        FILE_SIZE, path, (char *) request_b64, STREAMS);
+    code = ftp_command(control, command);
+    if (code / 100 != expected_code / 100)
+    {
+        printf("# expected a %d reply, got %d\n", expected_code, code);
+        goto cleanup;
+    }
+
+    /* all the HTTP server processes are done once the download is */
+    kill(http_pid, SIGTERM);
+    waitpid(http_pid, NULL, 0);
+    http_pid = -1;
+    n = read(report[0], responses, sizeof(responses) - 1);
+    responses[n > 0 ? n : 0] = '\0';
+    if (strcmp(responses, expected_responses) != 0)
+    {
+        printf("# expected HTTP responses \"%s\", got \"%s\"\n",
+            expected_responses, responses);
+        goto cleanup;
+    }
+
+    if (expected_code / 100 != 2)
+    {
+        rc = 0;
+        goto cleanup;
+    }
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size != FILE_SIZE)
+    {
+        printf("# %s is missing or has the wrong size\n", path);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        goto cleanup;
+    }
+    got = malloc(FILE_SIZE);
+    while (got_length < FILE_SIZE &&
+        (n = read(fd, got + got_length, FILE_SIZE - got_length)) > 0)
+    {
+        got_length += n;
+    }
+    close(fd);
+    if (got_length != FILE_SIZE || memcmp(got, resource, FILE_SIZE) != 0)
+    {
+        printf("# %s differs from the resource\n", path);
+        goto cleanup;
+    }
+    rc = 0;
+
+cleanup:
+    if (http_pid > 0)
+    {
+        kill(http_pid, SIGTERM);
+        waitpid(http_pid, NULL, 0);
+        http_pid = -1;
+    }
+    if (control != NULL)
+    {
+        ftp_command(control, "QUIT");
+        fclose(control);
+    }
+    if (listen_fd >= 0)
+    {
+        close(listen_fd);
+    }
+    if (report[0] >= 0)
+    {
+        close(report[0]);
+    }
+    free(got);
+    free(command);
+    free(path);
+
+    return rc;
+}
+
+static
+void
+timeout_handler(int sig)
+{
+    if (http_pid > 0)
+    {
+        kill(http_pid, SIGTERM);
+    }
+    if (ftp_pid > 0)
+    {
+        kill(ftp_pid, SIGKILL);
+    }
+    _exit(99);
+}
+
+int main()
+{
+    range_test_case_t                   range_tests[] =
+    {
+        {
+            .test_name = "exact",
+            .header_name = "Content-Range",
+            .content_range = "bytes 0-1048575/4194304",
+            .start = 0, .end = 1048576, .length = 4194304,
+            .expected_result = true
+        },
+        {
+            .test_name = "exact-lowercase-name",
+            .header_name = "content-range",
+            .content_range = "bytes 1048576-2097151/4194304",
+            .start = 1048576, .end = 2097152, .length = 4194304,
+            .expected_result = true
+        },
+        {
+            .test_name = "shifted",
+            .header_name = "Content-Range",
+            .content_range = "bytes 1-1048576/4194304",
+            .start = 0, .end = 1048576, .length = 4194304,
+            .expected_result = false
+        },
+        {
+            .test_name = "short",
+            .header_name = "Content-Range",
+            .content_range = "bytes 0-1048574/4194304",
+            .start = 0, .end = 1048576, .length = 4194304,
+            .expected_result = false
+        },
+        {
+            .test_name = "wrong-length",
+            .header_name = "Content-Range",
+            .content_range = "bytes 0-1048575/4194305",
+            .start = 0, .end = 1048576, .length = 4194304,
+            .expected_result = false
+        },
+        {
+            .test_name = "unknown-length",
+            .header_name = "Content-Range",
+            .content_range = "bytes 0-1048575/*",
+            .start = 0, .end = 1048576, .length = 4194304,
+            .expected_result = false
+        },
+        {
+            .test_name = "trailing-garbage",
+            .header_name = "Content-Range",
+            .content_range = "bytes 0-1048575/4194304, 5",
+            .start = 0, .end = 1048576, .length = 4194304,
+            .expected_result = false
+        },
+        {
+            .test_name = "missing",
+            .header_name = NULL,
+            .content_range = NULL,
+            .start = 0, .end = 1048576, .length = 4194304,
+            .expected_result = false
+        }
+    };
+    int                                 range_count =
+        sizeof(range_tests) / sizeof(*range_tests);
+    char                                expected[STREAMS + 1];
+    char *                              command;
+    int                                 listen_fd;
+    int                                 ftp_port;
+    int                                 failed = 0;
+    int                                 rc;
+    int                                 i;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+
+    rc = globus_module_activate(GLOBUS_COMMON_MODULE);
+    if (rc == GLOBUS_SUCCESS)
+    {
+        rc = globus_module_activate(GLOBUS_GRIDFTP_SERVER_MODULE);
+    }
+    if (rc != GLOBUS_SUCCESS)
+    {
+        fprintf(stderr, "Error activating modules: %d\n", rc);
+        exit(99);
+    }
+
+    printf("1..%d\n", range_count + 4);
+
+    for (i = 0; i < range_count; i++)
+    {
+        rc = range_test(&range_tests[i]);
+        printf("%sok %d - check_range %s\n",
+            rc ? "not " : "", i + 1, range_tests[i].test_name);
+        failed += rc;
+    }
+
+    /* a pattern that doesn't repeat at any range boundary */
+    resource = malloc(FILE_SIZE);
+    for (i = 0; i < FILE_SIZE; i++)
+    {
+        resource[i] = (globus_byte_t) ((i * 7) ^ (i >> 9));
+    }
+    if (mkdtemp(work_dir) == NULL)
+    {
+        printf("Bail out! mkdtemp failed\n");
+        return 99;
+    }
+    chmod(work_dir, 0777);
+
+    /* take a free port for the gridftp server */
+    listen_fd = listen_port(&ftp_port);
+    if (listen_fd < 0)
+    {
+        printf("Bail out! no port for the gridftp server\n");
+        return 99;
+    }
+    close(listen_fd);
+    signal(SIGALRM, timeout_handler);
+    alarm(TIMEOUT);
+    fflush(stdout);
+    ftp_pid = ftp_server_start(ftp_port);
+
+    memset(expected, 'P', STREAMS);
+    expected[STREAMS] = '\0';
+    rc = download_test(HTTP_HONOUR_RANGE, ftp_port, 200, expected);
+    printf("%sok %d - download in %d ranges\n",
+        rc ? "not " : "", range_count + 1, STREAMS);
+    failed += rc;
+
+    rc = download_test(HTTP_IGNORE_RANGE, ftp_port, 200, "F");
+    printf("%sok %d - download falls back to one 200 response\n",
+        rc ? "not " : "", range_count + 2);
+    failed += rc;
+
+    rc = download_test(HTTP_SHIFT_FIRST_RANGE, ftp_port, 500, "P");
+    printf("%sok %d - download refuses a shifted first Content-Range\n",
+        rc ? "not " : "", range_count + 3);
+    failed += rc;
+
+    rc = download_test(HTTP_SHIFT_LATER_RANGES, ftp_port, 500, "PP");
+    printf("%sok %d - download refuses a shifted later Content-Range\n",
+        rc ? "not " : "", range_count + 4);
+    failed += rc;
+
+    alarm(0);
+    kill(ftp_pid, SIGINT);
+    waitpid(ftp_pid, NULL, 0);
+
+    command = globus_common_create_string("rm -rf %s", work_dir);
+    system(command);
+    free(command);
+    free(resource);
+
+    globus_module_deactivate_all();
+
+    return failed;
+}
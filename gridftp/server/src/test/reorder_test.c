@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "globus_common.h"
+#include "globus_gridftp_server.h"
+#include "globus_preload.h"
+
+#define BLOCK 10000
+#define BLOCKS 200
+
+typedef struct
+{
+    globus_byte_t *                     out;
+    globus_off_t                        out_length;
+    int                                 writes;
+    globus_bool_t                       in_order;
+}
+reorder_test_sink_t;
+
+typedef struct
+{
+    char *                              test_name;
+    globus_size_t                       memory_limit;
+    globus_off_t                        spill_limit;
+    /* send every nth block twice */
+    int                                 repeat;
+    /* drop this block, -1 for none */
+    int                                 drop;
+    globus_bool_t                       expect_full;
+}
+reorder_test_case_t;
+
+static globus_byte_t                    source[BLOCK * BLOCKS];
+
+static
+globus_result_t
+sink_write(
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_off_t                        offset,
+    void *                              user_arg)
+{
+    reorder_test_sink_t *               sink = user_arg;
+
+    if(offset != sink->out_length)
+    {
+        sink->in_order = GLOBUS_FALSE;
+    }
+    memcpy(sink->out + sink->out_length, buffer, length);
+    sink->out_length += length;
+    sink->writes++;
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+int
+test_reorder(
+    const reorder_test_case_t *         test_case)
+{
+    reorder_test_sink_t                 sink;
+    globus_gfs_reorder_t                reorder;
+    globus_result_t                     result;
+    int                                 order[BLOCKS];
+    int                                 i;
+    int                                 j;
+    int                                 tmp;
+    globus_bool_t                       full = GLOBUS_FALSE;
+    int                                 rc = 0;
+
+    memset(&sink, 0, sizeof(sink));
+    sink.out = malloc(sizeof(source));
+    sink.in_order = GLOBUS_TRUE;
+
+    /* shuffle within a sliding window, block 0 last */
+    for(i = 0; i < BLOCKS; i++)
+    {
+        order[i] = i;
+    }
+    for(i = 0; i < BLOCKS; i++)
+    {
+        j = i + rand() % (BLOCKS - i < 16 ? BLOCKS - i : 16);
+        tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+    for(i = 0; i < BLOCKS; i++)
+    {
+        if(order[i] == 0)
+        {
+            order[i] = order[BLOCKS - 1];
+            order[BLOCKS - 1] = 0;
+        }
+    }
+
+    result = globus_gridftp_server_reorder_init(
+        &reorder,
+        0,
+        test_case->memory_limit,
+        test_case->spill_limit,
+        sink_write,
+        &sink);
+    if(result != GLOBUS_SUCCESS)
+    {
+        fprintf(stderr, "# %s: init failed\n", test_case->test_name);
+        rc = 1;
+        goto done;
+    }
+
+    for(i = 0; i < BLOCKS && !full; i++)
+    {
+        if(order[i] == test_case->drop)
+        {
+            continue;
+        }
+        result = globus_gridftp_server_reorder_write(
+            reorder,
+            source + order[i] * BLOCK,
+            BLOCK,
+            (globus_off_t) order[i] * BLOCK);
+        if(result == GLOBUS_SUCCESS &&
+            test_case->repeat && order[i] % test_case->repeat == 0 &&
+            order[i] < BLOCKS - 1)
+        {
+            /* a repeated block straddling this one */
+            result = globus_gridftp_server_reorder_write(
+                reorder,
+                source + order[i] * BLOCK + BLOCK / 2,
+                BLOCK,
+                (globus_off_t) order[i] * BLOCK + BLOCK / 2);
+        }
+        if(result != GLOBUS_SUCCESS)
+        {
+            full = GLOBUS_TRUE;
+        }
+    }
+
+    if(test_case->expect_full)
+    {
+        if(!full)
+        {
+            fprintf(stderr, "# %s: limits not enforced\n",
+                test_case->test_name);
+            rc = 1;
+        }
+        goto destroy;
+    }
+    if(full)
+    {
+        fprintf(stderr, "# %s: write failed\n", test_case->test_name);
+        rc = 1;
+        goto destroy;
+    }
+
+    result = globus_gridftp_server_reorder_finish(reorder);
+    if(test_case->drop >= 0)
+    {
+        if(result == GLOBUS_SUCCESS ||
+            globus_gridftp_server_reorder_get_offset(reorder) !=
+                (globus_off_t) test_case->drop * BLOCK)
+        {
+            fprintf(stderr, "# %s: gap not reported\n",
+                test_case->test_name);
+            rc = 1;
+        }
+        goto destroy;
+    }
+    if(result != GLOBUS_SUCCESS ||
+        !sink.in_order ||
+        sink.out_length != sizeof(source) ||
+        memcmp(sink.out, source, sizeof(source)) != 0)
+    {
+        fprintf(stderr, "# %s: data mismatch, %ld bytes in %d writes\n",
+            test_case->test_name, (long) sink.out_length, sink.writes);
+        rc = 1;
+    }
+
+destroy:
+    globus_gridftp_server_reorder_destroy(reorder);
+done:
+    free(sink.out);
+    return rc;
+}
+
+int main()
+{
+    reorder_test_case_t                 tests[] =
+    {
+        { "memory", 0, 0, 0, -1, GLOBUS_FALSE },
+        { "spill", 4 * BLOCK, 64 * 1024 * 1024, 0, -1, GLOBUS_FALSE },
+        { "spill_only", 1, 64 * 1024 * 1024, 0, -1, GLOBUS_FALSE },
+        { "repeated", 4 * BLOCK, 64 * 1024 * 1024, 3, -1, GLOBUS_FALSE },
+        { "gap", 0, 0, 0, 17, GLOBUS_FALSE },
+        { "full", 4 * BLOCK, 0, 0, -1, GLOBUS_TRUE },
+        { "spill_full", 4 * BLOCK, 128 * 1024, 0, -1, GLOBUS_TRUE },
+    };
+    int test_count = (int) (sizeof(tests)/sizeof(tests[0]));
+    int failed_tests = 0;
+    int i;
+
+    LTDL_SET_PRELOADED_SYMBOLS();
+    globus_module_activate(GLOBUS_COMMON_MODULE);
+
+    srand(1);
+    for(i = 0; i < (int) sizeof(source); i++)
+    {
+        source[i] = (globus_byte_t) rand();
+    }
+
+    printf("1..%d\n", test_count);
+
+    for(i = 0; i < test_count; i++)
+    {
+        if(test_reorder(&tests[i]) == 0)
+        {
+            printf("ok %d - %s\n", i + 1, tests[i].test_name);
+        }
+        else
+        {
+            printf("not ok %d - %s\n", i + 1, tests[i].test_name);
+            failed_tests++;
+        }
+    }
+
+    globus_module_deactivate(GLOBUS_COMMON_MODULE);
+
+    return failed_tests;
+}
@@ -190,6 +190,20 @@ end:
 }
 
 
+# Run a good transfer with the gsi driver's crypto pool on. Wrap and unwrap
+# then run in the pool threads, and the client's compare of the echoed data
+# fails if they complete out of order
+sub crypto_pool_func
+{
+   my $server_args = shift;
+   my $client_args = shift;
+   my $test_name = shift;
+
+   local $ENV{GLOBUS_THREAD_MODEL} = 'pthread';
+   local $ENV{GLOBUS_XIO_GSI_CRYPTO_THREADS} = '4';
+
+   basic_func($server_args, $client_args, 0, 0, $test_name);
+}
 
 push(@tests, "basic_func(\"\",\"\",0,0,'$test-default');");
 push(@tests, "basic_func(\"\",\"\",1,1,'$test-bad-cert-dir');");
@@ -236,6 +250,11 @@ push(@tests, "basic_func(\"\",\"-a -i \'$identity\'\",1,0, '$test-anonymous-iden
 push(@tests, "basic_func(\"-g -P none\",\"-g -P none\",0,0,'$test-gsi-wrap-noprotect');");
 push(@tests, "basic_func(\"-g -P integrity\",\"-g -P integrity\",0,0,'$test-gsi-wrap-integrity');");
 push(@tests, "basic_func(\"-g -P privacy\",\"-g -P privacy\",0,0, '$test-gsi-wrap-privacy');");
+push(@tests, "crypto_pool_func(\"-g\",\"-g\", '$test-gsi-wrap-crypto-pool');");
+push(@tests, "crypto_pool_func(\"-v -g\",\"-v -g\", '$test-iovec-gsi-wrap-crypto-pool');");
+push(@tests, "crypto_pool_func(\"-g -P none\",\"-g -P none\", '$test-gsi-wrap-noprotect-crypto-pool');");
+push(@tests, "crypto_pool_func(\"-g -P integrity\",\"-g -P integrity\", '$test-gsi-wrap-integrity-crypto-pool');");
+push(@tests, "crypto_pool_func(\"-g -P privacy\",\"-g -P privacy\", '$test-gsi-wrap-privacy-crypto-pool');");
 
 # Now that the tests are defined, set up the Test to deal with them.
 plan tests => scalar(@tests);
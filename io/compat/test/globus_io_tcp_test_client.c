@@ -464,9 +464,10 @@ test1(int argc, char **argv)
     large_buf = malloc(large_buf_size);
     large_buf2 = malloc(large_buf_size);
 
+    /* vary by block too so blocks delivered out of order don't compare */
     for(i = 0; i < large_buf_size; i++)
     {
-	large_buf[i] = i & 0xff;
+	large_buf[i] = (i ^ (i >> 8) ^ (i >> 16)) & 0xff;
     }
 
     if(vector)
@@ -231,6 +231,10 @@ typedef struct
     char *                              host_name;
     gss_cred_id_t                      *cred_array;
     size_t                              cred_array_length;
+    /* crypto offload: pending wrap/unwrap jobs, run in order */
+    globus_fifo_t                       crypto_jobs;
+    globus_bool_t                       crypto_scheduled;
+    int                                 crypto_ref;
 } globus_l_handle_t;
 
 /*
@@ -268,5 +272,39 @@ typedef struct
     gss_cred_id_t *                     cred;
 } globus_l_xio_gsi_delegation_arg_t;
 
+/*
+ * Crypto worker pool. Handles with pending wrap/unwrap work are queued on
+ * the ready fifo; a handle is on it at most once so that all work for one
+ * security context is done in order by a single thread at a time, while
+ * different handles (e.g. parallel data channel streams) are spread over
+ * all workers.
+ */
+
+typedef struct
+{
+    globus_callback_func_t              func;
+    void *                              arg;
+} globus_l_xio_gsi_crypto_job_t;
+
+typedef struct
+{
+    globus_mutex_t                      mutex;
+    globus_cond_t                       cond;
+    globus_fifo_t                       ready;
+    int                                 max_threads;
+    int                                 thread_count;
+    globus_bool_t                       shutdown;
+} globus_l_xio_gsi_crypto_pool_t;
+
+/* Structure used to hand a completed transport read to the crypto pool */
+
+typedef struct
+{
+    globus_xio_operation_t              op;
+    globus_result_t                     result;
+    globus_size_t                       nbytes;
+    globus_l_handle_t *                 handle;
+} globus_l_xio_gsi_read_job_t;
+
 #endif
 
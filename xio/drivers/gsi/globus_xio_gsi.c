@@ -60,6 +60,8 @@ static globus_l_attr_t                  globus_l_xio_gsi_attr_default =
 static int                              connection_count = 0;
 static globus_mutex_t                   connection_mutex;
 
+static globus_l_xio_gsi_crypto_pool_t   globus_l_xio_gsi_crypto_pool;
+
 static
 globus_result_t
 globus_l_xio_gsi_attr_destroy(
@@ -94,6 +96,11 @@ globus_l_xio_gsi_close_cb(
     globus_result_t                     result,
     void *                              user_arg);
 
+static
+void
+globus_l_xio_gsi_handle_free(
+    globus_l_handle_t *                 handle);
+
 static int
 globus_l_xio_gsi_activate();
 
@@ -746,13 +753,256 @@ globus_l_xio_gsi_server_destroy(
 }
 
 /*
- * destroy driver structure - internal use only 
+ * crypto worker thread. Runs one job for the handle at the head of the ready
+ * queue, then puts the handle back at the tail if it has more work so that
+ * busy streams are served round robin - internal use only
+ */
+
+static
+void *
+globus_l_xio_gsi_crypto_thread(
+    void *                              user_arg)
+{
+    globus_l_xio_gsi_crypto_pool_t *    pool;
+    globus_l_xio_gsi_crypto_job_t *     job;
+    globus_l_handle_t *                 handle;
+    globus_bool_t                       free_handle;
+    GlobusXIOName(globus_l_xio_gsi_crypto_thread);
+    GlobusXIOGSIDebugInternalEnter();
+
+    pool = (globus_l_xio_gsi_crypto_pool_t *) user_arg;
+
+    globus_mutex_lock(&pool->mutex);
+    while(!pool->shutdown)
+    {
+        if(globus_fifo_empty(&pool->ready))
+        {
+            globus_cond_wait(&pool->cond, &pool->mutex);
+            continue;
+        }
+
+        handle = globus_fifo_dequeue(&pool->ready);
+        job = globus_fifo_dequeue(&handle->crypto_jobs);
+        globus_mutex_unlock(&pool->mutex);
+
+        job->func(job->arg);
+        free(job);
+
+        free_handle = GLOBUS_FALSE;
+        globus_mutex_lock(&pool->mutex);
+        if(!globus_fifo_empty(&handle->crypto_jobs))
+        {
+            globus_fifo_enqueue(&pool->ready, handle);
+        }
+        else
+        {
+            handle->crypto_scheduled = GLOBUS_FALSE;
+            free_handle = (--handle->crypto_ref == 0);
+        }
+
+        if(free_handle)
+        {
+            globus_mutex_unlock(&pool->mutex);
+            globus_l_xio_gsi_handle_free(handle);
+            globus_mutex_lock(&pool->mutex);
+        }
+    }
+    pool->thread_count--;
+    globus_cond_broadcast(&pool->cond);
+    globus_mutex_unlock(&pool->mutex);
+
+    GlobusXIOGSIDebugInternalExit();
+    return NULL;
+}
+
+/*
+ * whether a handle's wrap/unwrap work goes to the crypto pool. Unprotected
+ * handles have no crypto to do, so they never use it - internal use only
+ */
+
+static
+globus_bool_t
+globus_l_xio_gsi_crypto_pooled(
+    globus_l_handle_t *                 handle)
+{
+    return globus_l_xio_gsi_crypto_pool.max_threads > 0 &&
+        handle->attr->prot_level != GLOBUS_XIO_GSI_PROTECTION_LEVEL_NONE;
+}
+
+/*
+ * queue wrap/unwrap work for a handle on the crypto pool. Jobs for the same
+ * handle run in the order they were queued - internal use only
+ */
+
+static
+globus_result_t
+globus_l_xio_gsi_crypto_enqueue(
+    globus_l_handle_t *                 handle,
+    globus_callback_func_t              func,
+    void *                              arg)
+{
+    globus_l_xio_gsi_crypto_pool_t *    pool;
+    globus_l_xio_gsi_crypto_job_t *     job;
+    globus_result_t                     result;
+    GlobusXIOName(globus_l_xio_gsi_crypto_enqueue);
+    GlobusXIOGSIDebugInternalEnter();
+
+    pool = &globus_l_xio_gsi_crypto_pool;
+
+    job = malloc(sizeof(globus_l_xio_gsi_crypto_job_t));
+    if(!job)
+    {
+        result = GlobusXIOErrorMemory("job");
+        goto error;
+    }
+    job->func = func;
+    job->arg = arg;
+
+    globus_mutex_lock(&pool->mutex);
+    {
+        globus_fifo_enqueue(&handle->crypto_jobs, job);
+        if(!handle->crypto_scheduled)
+        {
+            handle->crypto_scheduled = GLOBUS_TRUE;
+            handle->crypto_ref++;
+            globus_fifo_enqueue(&pool->ready, handle);
+            globus_cond_signal(&pool->cond);
+        }
+    }
+    globus_mutex_unlock(&pool->mutex);
+
+    GlobusXIOGSIDebugInternalExit();
+    return GLOBUS_SUCCESS;
+
+ error:
+    GlobusXIOGSIDebugInternalExitWithError();
+    return result;
+}
+
+/*
+ * start the crypto worker pool if GLOBUS_XIO_GSI_CRYPTO_THREADS asks for
+ * one and threads are available - internal use only
+ */
+
+static
+void
+globus_l_xio_gsi_crypto_pool_init(void)
+{
+    globus_l_xio_gsi_crypto_pool_t *    pool;
+    char *                              tmp_str;
+    int                                 max_threads = 0;
+    globus_thread_t                     thread;
+    GlobusXIOName(globus_l_xio_gsi_crypto_pool_init);
+    GlobusXIOGSIDebugInternalEnter();
+
+    pool = &globus_l_xio_gsi_crypto_pool;
+
+    globus_mutex_init(&pool->mutex, NULL);
+    globus_cond_init(&pool->cond, NULL);
+    globus_fifo_init(&pool->ready);
+    pool->max_threads = 0;
+    pool->thread_count = 0;
+    pool->shutdown = GLOBUS_FALSE;
+
+    tmp_str = globus_module_getenv("GLOBUS_XIO_GSI_CRYPTO_THREADS");
+    if(tmp_str == NULL || sscanf(tmp_str, "%d", &max_threads) != 1 ||
+        max_threads <= 0 || globus_i_am_only_thread())
+    {
+        GlobusXIOGSIDebugInternalExit();
+        return;
+    }
+
+    globus_mutex_lock(&pool->mutex);
+    {
+        pool->max_threads = max_threads;
+        while(pool->thread_count < pool->max_threads)
+        {
+            if(globus_thread_create(
+                &thread, NULL, globus_l_xio_gsi_crypto_thread, pool) != 0)
+            {
+                break;
+            }
+            pool->thread_count++;
+        }
+        /* only offload if at least one worker came up */
+        pool->max_threads = pool->thread_count;
+    }
+    globus_mutex_unlock(&pool->mutex);
+
+    GlobusXIOGSIDebugPrintf(
+        GLOBUS_XIO_GSI_DEBUG_INTERNAL_TRACE,
+        (_XIOSL("[%s] Started %d crypto threads\n"),
+         _xio_name, pool->max_threads));
+
+    GlobusXIOGSIDebugInternalExit();
+}
+
+/*
+ * stop the crypto worker pool and wait for the workers to exit - internal
+ * use only
+ */
+
+static
+void
+globus_l_xio_gsi_crypto_pool_destroy(void)
+{
+    globus_l_xio_gsi_crypto_pool_t *    pool;
+    GlobusXIOName(globus_l_xio_gsi_crypto_pool_destroy);
+    GlobusXIOGSIDebugInternalEnter();
+
+    pool = &globus_l_xio_gsi_crypto_pool;
+
+    globus_mutex_lock(&pool->mutex);
+    {
+        pool->shutdown = GLOBUS_TRUE;
+        globus_cond_broadcast(&pool->cond);
+        while(pool->thread_count > 0)
+        {
+            globus_cond_wait(&pool->cond, &pool->mutex);
+        }
+        pool->max_threads = 0;
+    }
+    globus_mutex_unlock(&pool->mutex);
+
+    globus_fifo_destroy(&pool->ready);
+    globus_cond_destroy(&pool->cond);
+    globus_mutex_destroy(&pool->mutex);
+
+    GlobusXIOGSIDebugInternalExit();
+}
+
+/*
+ * drop the driver's reference to a handle. The handle is freed once no
+ * crypto worker holds it any more - internal use only
  */
 
 static
 void
 globus_l_xio_gsi_handle_destroy(
     globus_l_handle_t *                 handle)
+{
+    globus_bool_t                       free_handle;
+
+    globus_mutex_lock(&globus_l_xio_gsi_crypto_pool.mutex);
+    {
+        free_handle = (--handle->crypto_ref == 0);
+    }
+    globus_mutex_unlock(&globus_l_xio_gsi_crypto_pool.mutex);
+
+    if(free_handle)
+    {
+        globus_l_xio_gsi_handle_free(handle);
+    }
+}
+
+/*
+ * free driver structure - internal use only 
+ */
+
+static
+void
+globus_l_xio_gsi_handle_free(
+    globus_l_handle_t *                 handle)
 {
     OM_uint32                           minor_status;
     GlobusXIOName(globus_l_xio_gsi_handle_free);
@@ -834,6 +1084,7 @@ globus_l_xio_gsi_handle_destroy(
         free(handle->cred_array);
     }
 
+    globus_fifo_destroy(&handle->crypto_jobs);
     free(handle);
 
     GlobusXIOGSIDebugInternalExit();
@@ -1978,6 +2229,10 @@ globus_l_xio_gsi_open(
         goto error;
     }
 
+    globus_fifo_init(&handle->crypto_jobs);
+    handle->crypto_scheduled = GLOBUS_FALSE;
+    handle->crypto_ref = 1;
+
     handle->read_iovec[0].iov_len = 4;
     handle->read_iovec[0].iov_base = handle->header;
     handle->read_iovec[1].iov_len = handle->attr->buffer_size;
@@ -2077,12 +2332,20 @@ globus_l_xio_gsi_close(
     return result;
 }
 
+static
+void
+globus_l_xio_gsi_read_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg);
+
 /*
- *  read callback - internal only
+ *  unwrap data read from the transport and deliver it - internal only
  */
 static
 void
-globus_l_xio_gsi_read_cb(
+globus_l_xio_gsi_read_unwrap(
     globus_xio_operation_t              op,
     globus_result_t                     result,
     globus_size_t                       nbytes,
@@ -2097,7 +2360,7 @@ globus_l_xio_gsi_read_cb(
     globus_bool_t                       ssl_record;
     globus_bool_t                       no_header = GLOBUS_FALSE;
 
-    GlobusXIOName(globus_l_xio_gsi_read_cb);
+    GlobusXIOName(globus_l_xio_gsi_read_unwrap);
     GlobusXIOGSIDebugInternalEnter();
 
     handle = (globus_l_handle_t *) user_arg;
@@ -2336,6 +2599,67 @@ globus_l_xio_gsi_read_cb(
     return;
 }
 
+/*
+ *  crypto pool job for a completed transport read - internal only
+ */
+static
+void
+globus_l_xio_gsi_read_bounce(
+    void *                              user_arg)
+{
+    globus_l_xio_gsi_read_job_t *       read_job;
+
+    read_job = (globus_l_xio_gsi_read_job_t *) user_arg;
+
+    globus_l_xio_gsi_read_unwrap(
+        read_job->op, read_job->result, read_job->nbytes, read_job->handle);
+    free(read_job);
+}
+
+/*
+ *  read callback. Hands the unwrap to the crypto pool if there is one,
+ *  otherwise unwraps in the callback thread - internal only
+ */
+static
+void
+globus_l_xio_gsi_read_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_handle_t *                 handle;
+    globus_l_xio_gsi_read_job_t *       read_job;
+    GlobusXIOName(globus_l_xio_gsi_read_cb);
+    GlobusXIOGSIDebugInternalEnter();
+
+    handle = (globus_l_handle_t *) user_arg;
+
+    if(globus_l_xio_gsi_crypto_pooled(handle))
+    {
+        read_job = malloc(sizeof(globus_l_xio_gsi_read_job_t));
+        if(read_job)
+        {
+            read_job->op = op;
+            read_job->result = result;
+            read_job->nbytes = nbytes;
+            read_job->handle = handle;
+
+            if(globus_l_xio_gsi_crypto_enqueue(
+                handle, globus_l_xio_gsi_read_bounce, read_job)
+                    == GLOBUS_SUCCESS)
+            {
+                GlobusXIOGSIDebugInternalExit();
+                return;
+            }
+            free(read_job);
+        }
+    }
+
+    globus_l_xio_gsi_read_unwrap(op, result, nbytes, handle);
+    GlobusXIOGSIDebugInternalExit();
+}
+
 /* read interface function */
 
 static
@@ -3098,6 +3422,11 @@ globus_l_xio_gsi_write(
     sz += sizeof(gsi_l_write_bounce_t);
 
     bounce = (gsi_l_write_bounce_t *) globus_malloc(sz);
+    if(!bounce)
+    {
+        result = GlobusXIOErrorMemory("bounce");
+        goto error;
+    }
 
     bounce->driver_specific_handle = driver_specific_handle;
     bounce->op = op;
@@ -3107,11 +3436,16 @@ globus_l_xio_gsi_write(
         bounce->iovec[i].iov_base = iovec[i].iov_base;
         bounce->iovec[i].iov_len = iovec[i].iov_len;
     }
-    globus_callback_register_oneshot(
-        NULL,
-        NULL,
-        globus_l_xio_gsi_write_bounce,
-        bounce);
+    if(!globus_l_xio_gsi_crypto_pooled(handle) ||
+       globus_l_xio_gsi_crypto_enqueue(
+            handle, globus_l_xio_gsi_write_bounce, bounce) != GLOBUS_SUCCESS)
+    {
+        globus_callback_register_oneshot(
+            NULL,
+            NULL,
+            globus_l_xio_gsi_write_bounce,
+            bounce);
+    }
 
 /*
     globus_l_xio_gsi_write_bounce(bounce);
@@ -4128,6 +4462,7 @@ globus_l_xio_gsi_activate(void)
 
     GlobusXIORegisterDriver(gsi);
     globus_mutex_init(&connection_mutex,NULL);
+    globus_l_xio_gsi_crypto_pool_init();
     GlobusXIOGSIDebugExit();
     return rc;
 }
@@ -4143,6 +4478,7 @@ globus_l_xio_gsi_deactivate(void)
     GlobusXIOName(globus_l_xio_gsi_deactivate);
     GlobusXIOGSIDebugEnter();
     GlobusXIOUnRegisterDriver(gsi);
+    globus_l_xio_gsi_crypto_pool_destroy();
     rc = globus_module_deactivate(GLOBUS_XIO_MODULE);
     rc += globus_module_deactivate(GLOBUS_GSI_GSS_ASSIST_MODULE);
     globus_mutex_destroy(&connection_mutex);
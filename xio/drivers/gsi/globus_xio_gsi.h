@@ -106,6 +106,14 @@ extern "C" {
  *
  * For details see
  * <a href="http://toolkit.globus.org/toolkit/docs/latest-stable/gsic/pi/#gsic-pi-env">Globus: GSI Environment Variables</a>
+ *
+ * In addition, the driver checks GLOBUS_XIO_GSI_CRYPTO_THREADS when it is
+ * activated. If set to a positive number in a threaded program, that many
+ * crypto worker threads are started and the wrapping and unwrapping of
+ * protected data is done by them instead of in the thread that completed the
+ * transport operation. Work for a single handle is always done in order by
+ * one worker at a time, so this helps when many handles (for example the
+ * parallel streams of a GridFTP data channel) are active at once.
  */
 
 /**
@@ -260,7 +260,8 @@ globus_i_xio_http_guess_version(
  * @ingroup globus_i_xio_http_util
  *
  * Finds the next CRLF sequence in a byte array, returning a pointer to
- * the beginning of the sequence.
+ * the beginning of the sequence. The search is for the LF, with memchr()
+ * doing the scanning, and each LF found is checked for a CR before it.
  *
  * @param blob
  *     Character array to search through.
@@ -276,23 +277,16 @@ globus_i_xio_http_find_eol(
     const char *                        blob,
     globus_size_t                       blob_length)
 {
-    char *                              result;
-    globus_size_t                       skip = 0;
+    const char *                        end = blob + blob_length;
+    const char *                        lf;
 
-    while (((skip + 1) < blob_length) && 
-        (result = memchr(blob + skip, '\r', blob_length-skip)) != NULL)
+    for (lf = blob + 1;
+            lf < end && (lf = memchr(lf, '\n', end - lf)) != NULL;
+            lf++)
     {
-        if (result+1 == (blob + skip + blob_length))
+        if (*(lf - 1) == '\r')
         {
-            return NULL;
-        }
-        else if (*(result+1) == '\n')
-        {
-            return result;
-        }
-        else 
-        {
-            skip += (result - blob + 1);
+            return (char *) (lf - 1);
         }
     }
     return NULL;
@@ -327,6 +321,17 @@ globus_i_xio_http_clean_read_buffer(
         /* Nothing in buffer, can reuse in its entirety */
         http_handle->read_buffer_offset = 0;
     }
+    else if (http_handle->read_buffer.iov_len
+                - http_handle->read_buffer_offset
+                - http_handle->read_buffer_valid
+                >= http_handle->read_buffer_offset &&
+            http_handle->read_buffer_offset + http_handle->read_buffer_valid
+                < http_handle->read_buffer.iov_len)
+    {
+        /* At least as much room after the data as before it, read into
+         * that without moving anything
+         */
+    }
     else if (http_handle->read_buffer_valid < http_handle->read_buffer.iov_len)
     {
         /* Something in buffer, but there's some slack left, shift to beginning
@@ -966,9 +966,9 @@ globus_l_xio_http_client_parse_response(
     char *                              eol;
     char *                              current_offset;
     int                                 parsed;
+    char *                              token_end;
     unsigned int                        http_major;
     unsigned int                        http_minor;
-    int                                 rc;
     GlobusXIOName(globus_l_xio_http_client_parse_response);
 
     if (http_handle->parse_state == GLOBUS_XIO_HTTP_STATUS_LINE)
@@ -991,31 +991,37 @@ globus_l_xio_http_client_parse_response(
         }
         *eol = '\0';
 
-        rc = sscanf(current_offset,
-                "HTTP/%u.%u %n",
-                &http_major,
-                &http_minor,
-                &parsed);
+        if (strncmp(current_offset, "HTTP/", 5) != 0 ||
+                !isdigit((unsigned char) current_offset[5]))
+        {
+            result = GlobusXIOHttpErrorParse("Http-Version", current_offset);
 
-        if (rc < 2)
+            goto error_exit;
+        }
+        http_major = strtoul(current_offset + 5, &token_end, 10);
+        if (*token_end != '.' || !isdigit((unsigned char) token_end[1]))
         {
             result = GlobusXIOHttpErrorParse("Http-Version", current_offset);
 
             goto error_exit;
         }
+        http_minor = strtoul(token_end + 1, &token_end, 10);
 
         http_handle->response_info.http_version = 
             globus_i_xio_http_guess_version(http_major, http_minor);
 
-        current_offset += parsed;
+        current_offset = token_end;
+        while (*current_offset == ' ')
+        {
+            current_offset++;
+        }
 
         /* Status-Code */
-        rc = sscanf(current_offset,
-                "%d %n",
-                &http_handle->response_info.status_code,
-                &parsed);
+        http_handle->response_info.status_code =
+            strtol(current_offset, &token_end, 10);
 
-        if (http_handle->response_info.status_code < 100 ||
+        if (token_end == current_offset ||
+                http_handle->response_info.status_code < 100 ||
                 http_handle->response_info.status_code > 599)
         {
             result = GlobusXIOHttpErrorParse("Status-Code", current_offset);
@@ -1023,7 +1029,11 @@ globus_l_xio_http_client_parse_response(
             goto error_exit;
         }
        
-        current_offset += parsed;
+        current_offset = token_end;
+        while (*current_offset == ' ')
+        {
+            current_offset++;
+        }
 
         /* Reason Phrase */
         http_handle->response_info.reason_phrase =
@@ -133,11 +133,11 @@ globus_i_xio_http_header_parse(
     globus_result_t                     result;
     char *                              eol;
     char *                              current_offset;
+    char *                              p;
     int                                 parsed;
     globus_i_xio_http_header_info_t *   headers;
     char *                              header_name;
     char *                              header_value;
-    int                                 rc;
 
     GlobusXIOName(globus_i_xio_http_header_parse);
 
@@ -154,7 +154,9 @@ globus_i_xio_http_header_parse(
             + http_handle->read_buffer_offset;
 
     /*
-     * While we find a non-empty line, we are in the header block.
+     * While we find a non-empty line, we are in the header block. Each
+     * line is split in place: the name and value handed on are pointers
+     * into the read buffer, and only headers that are kept get copied.
      */
     while ((eol = globus_i_xio_http_find_eol(
                 current_offset,
@@ -182,42 +184,40 @@ globus_i_xio_http_header_parse(
                 continue;
             }
         }
-        *eol = '\0';
-
-        /* Find end of header name */
-        rc = sscanf(current_offset, "%*[^: \t\r\n]%n", &parsed);
-        if (rc < 0)
+        else
         {
-            result = GlobusXIOHttpErrorParse("field-name", current_offset);
+            /*
+             * Can't tell yet whether the next line continues this one,
+             * wait for more data.
+             */
+            *done = GLOBUS_FALSE;
 
-            goto error_exit;
+            return GLOBUS_SUCCESS;
         }
-        header_name = current_offset;
+        *eol = '\0';
 
-        if (*(current_offset+parsed) != ':')
+        /* field-name runs up to the colon, with no whitespace in it */
+        header_name = current_offset;
+        for (p = current_offset;
+                p < eol && *p != ':' && *p != ' ' && *p != '\t';
+                p++)
+        {
+        }
+        if (p == current_offset || *p != ':')
         {
             result = GlobusXIOHttpErrorParse("field-name", current_offset);
 
             goto error_exit;
         }
         /* replace : with '\0' */
-        *(current_offset+parsed) = '\0';
-        parsed++;
+        *(p++) = '\0';
 
-        current_offset += parsed;
-
-        /* Find end of post-colon whitespace */
-        rc = sscanf(current_offset, " %n", &parsed);
-        if (rc < 0)
+        /* Skip leading whitespace */
+        while (*p == ' ' || *p == '\t')
         {
-            result = GlobusXIOHttpErrorParse("header-value", current_offset);
-
-            goto error_exit;
+            p++;
         }
-
-        /* Skip leading whitespace */
-        current_offset += parsed;
-        header_value = current_offset;
+        header_value = p;
 
         /* skip past \r\n */
         current_offset = eol + 2;
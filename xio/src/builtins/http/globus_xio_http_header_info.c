@@ -172,11 +172,16 @@ globus_i_xio_http_header_info_set_header(
     int                                 rc;
     globus_off_t                        length;
     globus_bool_t                       store;
+    globus_size_t                       name_length;
     GlobusXIOName(globus_l_xio_http_header_set);
 
     store = store_all;
-    /* Special cases for entity-body handling headers */
-    if (strcasecmp(header_name, "Content-Length") == 0)
+    /*
+     * Special cases for entity-body handling headers. Their lengths all
+     * differ, so any other header costs one compare of its length
+     */
+    name_length = strlen(header_name);
+    if (name_length == 14 && strcasecmp(header_name, "Content-Length") == 0)
     {
         rc = globus_libc_scan_off_t(header_value, &length, NULL);
         if (rc < 1)
@@ -188,7 +193,8 @@ globus_i_xio_http_header_info_set_header(
         headers->content_length = length;
         headers->flags |= GLOBUS_I_XIO_HTTP_HEADER_CONTENT_LENGTH_SET;
     }
-    else if (strcasecmp(header_name, "Transfer-Encoding") == 0)
+    else if (name_length == 17 &&
+            strcasecmp(header_name, "Transfer-Encoding") == 0)
     {
         if (strcasecmp(header_value, "identity") == 0)
         {
@@ -207,7 +213,7 @@ globus_i_xio_http_header_info_set_header(
             goto error_exit;
         }
     }
-    else if (strcasecmp(header_name, "Connection") == 0)
+    else if (name_length == 10 && strcasecmp(header_name, "Connection") == 0)
     {
         if (strcasecmp(header_value, "close") == 0)
         {
@@ -623,6 +623,7 @@ globus_l_xio_http_server_parse_request(
     globus_result_t                     result;
     char *                              eol;
     char *                              current_offset;
+    char *                              token_end;
     int                                 parsed;
     int                                 rc;
     int                                 http_major;
@@ -661,14 +662,15 @@ globus_l_xio_http_server_parse_request(
         }
         *eol = '\0';
 
-        rc = sscanf(current_offset, "%*s %n", &parsed);
-
-        if (rc < 0)
+        /* Method and Request-URI each end at the next space */
+        token_end = memchr(current_offset, ' ', eol - current_offset);
+        if (token_end == NULL || token_end == current_offset)
         {
             result = GlobusXIOHttpErrorParse("Method", current_offset);
 
             goto error_exit;
         }
+        parsed = token_end - current_offset;
 
         http_handle->request_info.method = globus_libc_malloc(parsed+1);
         if (http_handle->request_info.method == NULL)
@@ -677,19 +679,23 @@ globus_l_xio_http_server_parse_request(
 
             goto error_exit;
         }
+        memcpy(http_handle->request_info.method, current_offset, parsed);
+        http_handle->request_info.method[parsed] = '\0';
 
-        rc = sscanf(current_offset, "%s ", http_handle->request_info.method);
-        globus_assert(rc == 1);
-
-        current_offset += parsed;
+        current_offset = token_end;
+        while (*current_offset == ' ')
+        {
+            current_offset++;
+        }
         
-        rc = sscanf(current_offset, "%*s %n", &parsed);
-        if (rc < 0)
+        token_end = memchr(current_offset, ' ', eol - current_offset);
+        if (token_end == NULL || token_end == current_offset)
         {
             result = GlobusXIOHttpErrorParse("Request-URI", current_offset);
 
             goto error_exit;
         }
+        parsed = token_end - current_offset;
 
         http_handle->request_info.uri = globus_libc_malloc(parsed+1);
         if (http_handle->request_info.uri == NULL)
@@ -698,10 +704,14 @@ globus_l_xio_http_server_parse_request(
 
             goto error_exit;
         }
-        rc = sscanf(current_offset, "%s ", http_handle->request_info.uri);
-        globus_assert(rc == 1);
+        memcpy(http_handle->request_info.uri, current_offset, parsed);
+        http_handle->request_info.uri[parsed] = '\0';
 
-        current_offset += parsed;
+        current_offset = token_end;
+        while (*current_offset == ' ')
+        {
+            current_offset++;
+        }
 
         rc = sscanf(current_offset, "HTTP/%d.%d", &http_major, &http_minor);
 
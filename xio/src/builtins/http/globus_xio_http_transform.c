@@ -525,6 +525,7 @@ globus_i_xio_http_read(
     
                 goto error_exit;
             }
+            http_handle->read_iovec = http_handle->read_buffer;
         }
         else
         {
@@ -537,9 +538,10 @@ globus_i_xio_http_read(
             http_handle->parse_state = GLOBUS_XIO_HTTP_REQUEST_LINE;
         }
     
+        /* after any residue of the last request */
         result = globus_xio_driver_pass_read(
                 op,
-                &http_handle->read_buffer,
+                &http_handle->read_iovec,
                 1,
                 1,
                 globus_i_xio_http_server_read_request_callback,
@@ -0,0 +1,1377 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "globus_xio_driver.h"
+#include "globus_xio_shm_driver.h"
+#include "version.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <limits.h>
+#include <arpa/inet.h>
+
+GlobusDebugDefine(GLOBUS_XIO_SHM);
+GlobusXIODeclareDriver(shm);
+
+#define GlobusXIOShmDebugPrintf(level, message)                             \
+    GlobusDebugPrintf(GLOBUS_XIO_SHM, level, message)
+
+#define GlobusXIOShmDebugEnter()                                            \
+    GlobusXIOShmDebugPrintf(                                                \
+        GLOBUS_L_XIO_SHM_DEBUG_TRACE,                                       \
+        ("[%s] Entering\n", _xio_name))
+
+#define GlobusXIOShmDebugExit()                                             \
+    GlobusXIOShmDebugPrintf(                                                \
+        GLOBUS_L_XIO_SHM_DEBUG_TRACE,                                       \
+        ("[%s] Exiting\n", _xio_name))
+
+#define GlobusXIOShmDebugExitWithError()                                    \
+    GlobusXIOShmDebugPrintf(                                                \
+        GLOBUS_L_XIO_SHM_DEBUG_TRACE,                                       \
+        ("[%s] Exiting with error\n", _xio_name))
+
+#define GlobusXIOShmErrorProtocol(reason)                                   \
+    globus_error_put(                                                       \
+        globus_error_construct_error(                                       \
+            GlobusXIOMyModule(shm),                                         \
+            GLOBUS_NULL,                                                    \
+            GLOBUS_XIO_SHM_ERROR_PROTOCOL,                                  \
+            __FILE__,                                                       \
+            _xio_name,                                                      \
+            __LINE__,                                                       \
+            "Protocol error: %s", (reason)))
+
+/* the reader marks ring space free only after it has copied the data out,
+ * and the writer reuses it only after it has seen the mark */
+#if defined(__GNUC__)
+#define GlobusXIOShmBarrier() __sync_synchronize()
+#else
+#define GlobusXIOShmBarrier()
+#endif
+
+enum globus_l_xio_shm_debug_levels
+{
+    GLOBUS_L_XIO_SHM_DEBUG_TRACE        = 1,
+    GLOBUS_L_XIO_SHM_DEBUG_INFO         = 2
+};
+
+#define GLOBUS_L_XIO_SHM_MAGIC          "GXIOSHM1"
+#define GLOBUS_L_XIO_SHM_ID_LEN         64
+#define GLOBUS_L_XIO_SHM_NAME_LEN       64
+#define GLOBUS_L_XIO_SHM_NAME_PREFIX    "/globus_xio_shm_"
+#define GLOBUS_L_XIO_SHM_SECRET_LEN     16
+/* the read position, and the secret that is only written when the ring is
+ * created, sit alone in the first cache line of the segment */
+#define GLOBUS_L_XIO_SHM_HEADER_SIZE    64
+#define GLOBUS_L_XIO_SHM_MIN_RING       (64 * 1024)
+#define GLOBUS_L_XIO_SHM_DEFAULT_RING   (4 * 1024 * 1024)
+
+/* sent over the transport once the ends have agreed on shared memory.
+ * both ends are on the same host so it is in host byte order. */
+typedef enum
+{
+    /* length bytes follow in the ring */
+    GLOBUS_L_XIO_SHM_NOTICE_RING = 1
+} globus_l_xio_shm_notice_type_t;
+
+typedef struct
+{
+    uint32_t                            type;
+    uint32_t                            reserved;
+    uint64_t                            length;
+} globus_l_xio_shm_notice_t;
+
+/* sent by both ends when the handle is opened.  the numbers are in network
+ * byte order since the ends may not be on the same host. */
+typedef struct
+{
+    char                                magic[8];
+    char                                host_id[GLOBUS_L_XIO_SHM_ID_LEN];
+    char                                name[GLOBUS_L_XIO_SHM_NAME_LEN];
+    uint32_t                            uid;
+    uint32_t                            ring_size;
+    /* also in the header of the ring, so that an end only maps the ring
+     * the other end created for this handle */
+    unsigned char                       secret[GLOBUS_L_XIO_SHM_SECRET_LEN];
+} globus_l_xio_shm_hello_t;
+
+typedef struct
+{
+    volatile uint64_t                   read_pos;
+    unsigned char                       secret[GLOBUS_L_XIO_SHM_SECRET_LEN];
+} globus_l_xio_shm_ring_header_t;
+
+typedef struct
+{
+    globus_l_xio_shm_ring_header_t *    header;
+    char *                              data;
+    globus_size_t                       size;
+    /* total bytes written into or read out of the ring by this end */
+    uint64_t                            pos;
+} globus_l_xio_shm_ring_t;
+
+typedef struct
+{
+    int                                 ring_size;
+} globus_l_xio_shm_attr_t;
+
+static globus_l_xio_shm_attr_t          globus_l_xio_shm_attr_default =
+{
+    GLOBUS_L_XIO_SHM_DEFAULT_RING
+};
+
+typedef struct
+{
+    globus_mutex_t                      mutex;
+    globus_bool_t                       active;
+    globus_size_t                       ring_size;
+
+    /* ring this end writes into, and the name it was created under until
+     * the handshake is over and it is unlinked */
+    globus_l_xio_shm_ring_t             out;
+    char                                out_name[GLOBUS_L_XIO_SHM_NAME_LEN];
+    /* ring the other end writes into */
+    globus_l_xio_shm_ring_t             in;
+
+    globus_l_xio_shm_hello_t            hello_out;
+    globus_l_xio_shm_hello_t            hello_in;
+    uint32_t                            ack_out;
+    uint32_t                            ack_in;
+    globus_xio_iovec_t                  handshake_iovec;
+
+    /* the single outstanding read */
+    globus_l_xio_shm_notice_t           notice;
+    globus_xio_iovec_t                  notice_iovec;
+    globus_size_t                       ring_pending;
+    const globus_xio_iovec_t *          read_iovec;
+    int                                 read_iovec_count;
+
+    /* writes waiting for the one in progress */
+    globus_bool_t                       writing;
+    globus_fifo_t                       write_q;
+} globus_l_xio_shm_handle_t;
+
+typedef struct
+{
+    globus_xio_operation_t              op;
+    globus_l_xio_shm_handle_t *         handle;
+    const globus_xio_iovec_t *          iovec;
+    int                                 iovec_count;
+    globus_size_t                       length;
+    /* bytes in the ring that the reader has been told about */
+    globus_size_t                       nbytes;
+    globus_l_xio_shm_notice_t           notice;
+    globus_xio_iovec_t                  notice_iovec;
+    int                                 wait_usec;
+} globus_l_xio_shm_write_t;
+
+static
+int
+globus_l_xio_shm_activate(void);
+
+static
+int
+globus_l_xio_shm_deactivate(void);
+
+static globus_xio_string_cntl_table_t  shm_l_string_opts_table[] =
+{
+    {"ring_size", GLOBUS_XIO_SHM_SET_RING_SIZE,
+        globus_xio_string_cntl_formated_int},
+    {NULL, 0, NULL}
+};
+
+GlobusXIODefineModule(shm) =
+{
+    "globus_xio_shm",
+    globus_l_xio_shm_activate,
+    globus_l_xio_shm_deactivate,
+    GLOBUS_NULL,
+    GLOBUS_NULL,
+    &local_version
+};
+
+static
+int
+globus_l_xio_shm_activate(void)
+{
+    int                                 rc;
+    GlobusXIOName(globus_l_xio_shm_activate);
+
+    GlobusDebugInit(GLOBUS_XIO_SHM, TRACE INFO);
+    GlobusXIOShmDebugEnter();
+    rc = globus_module_activate(GLOBUS_XIO_MODULE);
+    if(rc != GLOBUS_SUCCESS)
+    {
+        goto error_xio_system_activate;
+    }
+    GlobusXIORegisterDriver(shm);
+    GlobusXIOShmDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_xio_system_activate:
+    GlobusXIOShmDebugExitWithError();
+    GlobusDebugDestroy(GLOBUS_XIO_SHM);
+    return rc;
+}
+
+static
+int
+globus_l_xio_shm_deactivate(void)
+{
+    int                                 rc;
+    GlobusXIOName(globus_l_xio_shm_deactivate);
+
+    GlobusXIOShmDebugEnter();
+    GlobusXIOUnRegisterDriver(shm);
+    rc = globus_module_deactivate(GLOBUS_XIO_MODULE);
+    if(rc != GLOBUS_SUCCESS)
+    {
+        goto error_deactivate;
+    }
+    GlobusXIOShmDebugExit();
+    GlobusDebugDestroy(GLOBUS_XIO_SHM);
+    return GLOBUS_SUCCESS;
+
+error_deactivate:
+    GlobusXIOShmDebugExitWithError();
+    GlobusDebugDestroy(GLOBUS_XIO_SHM);
+    return rc;
+}
+
+/* the boot id tells apart hosts, and containers, that share a hostname */
+static
+void
+globus_l_xio_shm_host_id(
+    char *                              host_id)
+{
+    FILE *                              fp;
+    char *                              nl;
+
+    memset(host_id, 0, GLOBUS_L_XIO_SHM_ID_LEN);
+    fp = fopen("/proc/sys/kernel/random/boot_id", "r");
+    if(fp != NULL)
+    {
+        if(fgets(host_id, GLOBUS_L_XIO_SHM_ID_LEN, fp) != NULL)
+        {
+            nl = strchr(host_id, '\n');
+            if(nl != NULL)
+            {
+                *nl = '\0';
+            }
+        }
+        fclose(fp);
+    }
+    if(*host_id == '\0')
+    {
+        globus_libc_gethostname(host_id, GLOBUS_L_XIO_SHM_ID_LEN - 1);
+    }
+}
+
+static
+globus_result_t
+globus_l_xio_shm_secret(
+    unsigned char *                     secret)
+{
+    int                                 fd;
+    ssize_t                             rc;
+    globus_size_t                       nbytes = 0;
+    GlobusXIOName(globus_l_xio_shm_secret);
+
+    fd = open("/dev/urandom", O_RDONLY);
+    if(fd < 0)
+    {
+        return GlobusXIOErrorSystemError("open", errno);
+    }
+    while(nbytes < GLOBUS_L_XIO_SHM_SECRET_LEN)
+    {
+        rc = read(fd, secret + nbytes, GLOBUS_L_XIO_SHM_SECRET_LEN - nbytes);
+        if(rc <= 0)
+        {
+            if(rc < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            close(fd);
+            return GlobusXIOErrorSystemError("read", rc < 0 ? errno : EIO);
+        }
+        nbytes += rc;
+    }
+    close(fd);
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_result_t
+globus_l_xio_shm_ring_create(
+    globus_l_xio_shm_handle_t *         handle)
+{
+    globus_abstime_t                    now;
+    globus_result_t                     result;
+    void *                              map;
+    int                                 fd;
+    GlobusXIOName(globus_l_xio_shm_ring_create);
+
+    GlobusXIOShmDebugEnter();
+    result = globus_l_xio_shm_secret(handle->hello_out.secret);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_secret;
+    }
+    GlobusTimeAbstimeGetCurrent(now);
+    snprintf(handle->out_name, sizeof(handle->out_name),
+        GLOBUS_L_XIO_SHM_NAME_PREFIX "%ld_%lx_%lx",
+        (long) getpid(),
+        (unsigned long) (uintptr_t) handle,
+        (unsigned long) now.tv_nsec ^ (unsigned long) now.tv_sec);
+
+    /* only this user may map it */
+    fd = shm_open(
+        handle->out_name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if(fd < 0)
+    {
+        result = GlobusXIOErrorSystemError("shm_open", errno);
+        goto error_open;
+    }
+    /* whatever the umask, the other end insists on exactly this mode */
+    if(fchmod(fd, S_IRUSR | S_IWUSR) < 0)
+    {
+        result = GlobusXIOErrorSystemError("fchmod", errno);
+        goto error_truncate;
+    }
+    /* the pages are only allocated once they are written */
+    if(ftruncate(fd, GLOBUS_L_XIO_SHM_HEADER_SIZE + handle->ring_size) < 0)
+    {
+        result = GlobusXIOErrorSystemError("ftruncate", errno);
+        goto error_truncate;
+    }
+    map = mmap(NULL, GLOBUS_L_XIO_SHM_HEADER_SIZE + handle->ring_size,
+        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        result = GlobusXIOErrorSystemError("mmap", errno);
+        goto error_truncate;
+    }
+    close(fd);
+
+    handle->out.header = (globus_l_xio_shm_ring_header_t *) map;
+    handle->out.data = (char *) map + GLOBUS_L_XIO_SHM_HEADER_SIZE;
+    handle->out.size = handle->ring_size;
+    handle->out.pos = 0;
+    memcpy(handle->out.header->secret, handle->hello_out.secret,
+        GLOBUS_L_XIO_SHM_SECRET_LEN);
+
+    GlobusXIOShmDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_truncate:
+    close(fd);
+    shm_unlink(handle->out_name);
+error_open:
+    handle->out_name[0] = '\0';
+error_secret:
+    GlobusXIOShmDebugExitWithError();
+    return result;
+}
+
+static
+globus_result_t
+globus_l_xio_shm_ring_attach(
+    globus_l_xio_shm_handle_t *         handle)
+{
+    struct stat                         st;
+    globus_result_t                     result;
+    globus_size_t                       size;
+    char                                name[GLOBUS_L_XIO_SHM_NAME_LEN];
+    void *                              map;
+    int                                 fd;
+    GlobusXIOName(globus_l_xio_shm_ring_attach);
+
+    GlobusXIOShmDebugEnter();
+    /* nothing the other end sent is trusted: only a ring of ours, made by
+     * globus_l_xio_shm_ring_create() for this handle, is mapped */
+    memcpy(name, handle->hello_in.name, sizeof(name));
+    name[sizeof(name) - 1] = '\0';
+    size = ntohl(handle->hello_in.ring_size);
+    if(strncmp(name, GLOBUS_L_XIO_SHM_NAME_PREFIX,
+            sizeof(GLOBUS_L_XIO_SHM_NAME_PREFIX) - 1) != 0 ||
+        strchr(name + 1, '/') != NULL ||
+        size < GLOBUS_L_XIO_SHM_MIN_RING ||
+        size > INT_MAX - GLOBUS_L_XIO_SHM_HEADER_SIZE)
+    {
+        result = GlobusXIOShmErrorProtocol("invalid ring");
+        goto error_name;
+    }
+
+#ifdef O_NOFOLLOW
+    fd = shm_open(name, O_RDWR | O_NOFOLLOW, 0);
+#else
+    fd = shm_open(name, O_RDWR, 0);
+#endif
+    if(fd < 0)
+    {
+        result = GlobusXIOErrorSystemError("shm_open", errno);
+        goto error_name;
+    }
+    if(fstat(fd, &st) < 0 ||
+        !S_ISREG(st.st_mode) ||
+        st.st_uid != geteuid() ||
+        (st.st_mode & 07777) != (S_IRUSR | S_IWUSR) ||
+        st.st_size != (off_t) (GLOBUS_L_XIO_SHM_HEADER_SIZE + size))
+    {
+        result = GlobusXIOShmErrorProtocol("ring not created by the peer");
+        goto error_map;
+    }
+    map = mmap(NULL, GLOBUS_L_XIO_SHM_HEADER_SIZE + size,
+        PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED)
+    {
+        result = GlobusXIOErrorSystemError("mmap", errno);
+        goto error_map;
+    }
+    close(fd);
+    if(memcmp(((globus_l_xio_shm_ring_header_t *) map)->secret,
+        handle->hello_in.secret, GLOBUS_L_XIO_SHM_SECRET_LEN) != 0)
+    {
+        munmap(map, GLOBUS_L_XIO_SHM_HEADER_SIZE + size);
+        result = GlobusXIOShmErrorProtocol("ring secret mismatch");
+        goto error_name;
+    }
+
+    handle->in.header = (globus_l_xio_shm_ring_header_t *) map;
+    handle->in.data = (char *) map + GLOBUS_L_XIO_SHM_HEADER_SIZE;
+    handle->in.size = size;
+    handle->in.pos = 0;
+
+    GlobusXIOShmDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_map:
+    close(fd);
+error_name:
+    GlobusXIOShmDebugExitWithError();
+    return result;
+}
+
+static
+void
+globus_l_xio_shm_ring_destroy(
+    globus_l_xio_shm_ring_t *           ring)
+{
+    if(ring->header != NULL)
+    {
+        munmap(ring->header, GLOBUS_L_XIO_SHM_HEADER_SIZE + ring->size);
+        ring->header = NULL;
+        ring->data = NULL;
+    }
+}
+
+/* the other end has mapped the ring or never will */
+static
+void
+globus_l_xio_shm_ring_unlink(
+    globus_l_xio_shm_handle_t *         handle)
+{
+    if(handle->out_name[0] != '\0')
+    {
+        shm_unlink(handle->out_name);
+        handle->out_name[0] = '\0';
+    }
+}
+
+/* copy length bytes from iovec, starting skip bytes in, into the ring.
+ * the caller has checked that they fit */
+static
+void
+globus_l_xio_shm_ring_put(
+    globus_l_xio_shm_ring_t *           ring,
+    const globus_xio_iovec_t *          iovec,
+    int                                 iovec_count,
+    globus_size_t                       skip,
+    globus_size_t                       length)
+{
+    globus_size_t                       offset;
+    globus_size_t                       len;
+    globus_size_t                       part;
+    char *                              base;
+    int                                 i;
+
+    for(i = 0; i < iovec_count && length > 0; i++)
+    {
+        if(skip >= iovec[i].iov_len)
+        {
+            skip -= iovec[i].iov_len;
+            continue;
+        }
+        base = (char *) iovec[i].iov_base + skip;
+        len = iovec[i].iov_len - skip;
+        len = len < length ? len : length;
+        skip = 0;
+
+        offset = ring->pos % ring->size;
+        part = ring->size - offset < len ? ring->size - offset : len;
+        memcpy(ring->data + offset, base, part);
+        if(part < len)
+        {
+            memcpy(ring->data, base + part, len - part);
+        }
+        ring->pos += len;
+        length -= len;
+    }
+}
+
+static
+globus_size_t
+globus_l_xio_shm_ring_get(
+    globus_l_xio_shm_ring_t *           ring,
+    const globus_xio_iovec_t *          iovec,
+    int                                 iovec_count,
+    globus_size_t                       length)
+{
+    globus_size_t                       nbytes = 0;
+    globus_size_t                       offset;
+    globus_size_t                       len;
+    globus_size_t                       part;
+    int                                 i;
+
+    for(i = 0; i < iovec_count && length > 0; i++)
+    {
+        len = iovec[i].iov_len < length ? iovec[i].iov_len : length;
+        offset = ring->pos % ring->size;
+        part = ring->size - offset < len ? ring->size - offset : len;
+        memcpy(iovec[i].iov_base, ring->data + offset, part);
+        if(part < len)
+        {
+            memcpy((char *) iovec[i].iov_base + part, ring->data, len - part);
+        }
+        ring->pos += len;
+        length -= len;
+        nbytes += len;
+    }
+    GlobusXIOShmBarrier();
+    ring->header->read_pos = ring->pos;
+
+    return nbytes;
+}
+
+static
+void
+globus_l_xio_shm_handle_destroy(
+    globus_l_xio_shm_handle_t *         handle)
+{
+    globus_l_xio_shm_ring_unlink(handle);
+    globus_l_xio_shm_ring_destroy(&handle->out);
+    globus_l_xio_shm_ring_destroy(&handle->in);
+    globus_fifo_destroy(&handle->write_q);
+    globus_mutex_destroy(&handle->mutex);
+    globus_free(handle);
+}
+
+static
+void
+globus_l_xio_shm_open_failed(
+    globus_l_xio_shm_handle_t *         handle,
+    globus_xio_operation_t              op,
+    globus_result_t                     result)
+{
+    globus_l_xio_shm_handle_destroy(handle);
+    globus_xio_driver_finished_open(NULL, op, result);
+}
+
+static
+void
+globus_l_xio_shm_open_done(
+    globus_l_xio_shm_handle_t *         handle,
+    globus_xio_operation_t              op)
+{
+    GlobusXIOName(globus_l_xio_shm_open_done);
+
+    globus_l_xio_shm_ring_unlink(handle);
+    if(!handle->active)
+    {
+        globus_l_xio_shm_ring_destroy(&handle->out);
+        globus_l_xio_shm_ring_destroy(&handle->in);
+    }
+    GlobusXIOShmDebugPrintf(GLOBUS_L_XIO_SHM_DEBUG_INFO,
+        ("[%s] %s\n", _xio_name,
+        handle->active ? "using shared memory" : "passing through"));
+
+    globus_xio_driver_finished_open(handle, op, GLOBUS_SUCCESS);
+}
+
+static
+void
+globus_l_xio_shm_ack_read_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_xio_shm_handle_t *         handle;
+
+    handle = (globus_l_xio_shm_handle_t *) user_arg;
+    if(result != GLOBUS_SUCCESS)
+    {
+        globus_l_xio_shm_open_failed(handle, op, result);
+        return;
+    }
+    handle->active = ntohl(handle->ack_out) && ntohl(handle->ack_in);
+    globus_l_xio_shm_open_done(handle, op);
+}
+
+static
+void
+globus_l_xio_shm_ack_write_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_xio_shm_handle_t *         handle;
+
+    handle = (globus_l_xio_shm_handle_t *) user_arg;
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+
+    handle->handshake_iovec.iov_base = &handle->ack_in;
+    handle->handshake_iovec.iov_len = sizeof(handle->ack_in);
+    result = globus_xio_driver_pass_read(
+        op, &handle->handshake_iovec, 1, sizeof(handle->ack_in),
+        globus_l_xio_shm_ack_read_cb, handle);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+    return;
+
+error:
+    globus_l_xio_shm_open_failed(handle, op, result);
+}
+
+static
+void
+globus_l_xio_shm_hello_read_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_xio_shm_handle_t *         handle;
+    GlobusXIOName(globus_l_xio_shm_hello_read_cb);
+
+    GlobusXIOShmDebugEnter();
+    handle = (globus_l_xio_shm_handle_t *) user_arg;
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+    if(memcmp(handle->hello_in.magic, GLOBUS_L_XIO_SHM_MAGIC,
+        sizeof(handle->hello_in.magic)) != 0)
+    {
+        result = GlobusXIOShmErrorProtocol(
+            "the other end does not have the shm driver on its stack");
+        goto error;
+    }
+
+    /* both ends make the same comparison, so they agree on whether to
+     * go on to the acknowledgement */
+    if(memcmp(handle->hello_in.host_id, handle->hello_out.host_id,
+            GLOBUS_L_XIO_SHM_ID_LEN) != 0 ||
+        handle->hello_in.uid != handle->hello_out.uid)
+    {
+        handle->active = GLOBUS_FALSE;
+        globus_l_xio_shm_open_done(handle, op);
+        GlobusXIOShmDebugExit();
+        return;
+    }
+
+    handle->ack_out = htonl(GLOBUS_FALSE);
+    if(handle->out.header != NULL)
+    {
+        result = globus_l_xio_shm_ring_attach(handle);
+        if(result == GLOBUS_SUCCESS)
+        {
+            handle->ack_out = htonl(GLOBUS_TRUE);
+        }
+        else
+        {
+            globus_object_free(globus_error_get(result));
+        }
+    }
+    handle->handshake_iovec.iov_base = &handle->ack_out;
+    handle->handshake_iovec.iov_len = sizeof(handle->ack_out);
+    result = globus_xio_driver_pass_write(
+        op, &handle->handshake_iovec, 1, sizeof(handle->ack_out),
+        globus_l_xio_shm_ack_write_cb, handle);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+    GlobusXIOShmDebugExit();
+    return;
+
+error:
+    globus_l_xio_shm_open_failed(handle, op, result);
+    GlobusXIOShmDebugExitWithError();
+}
+
+static
+void
+globus_l_xio_shm_hello_write_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_xio_shm_handle_t *         handle;
+
+    handle = (globus_l_xio_shm_handle_t *) user_arg;
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+
+    handle->handshake_iovec.iov_base = &handle->hello_in;
+    handle->handshake_iovec.iov_len = sizeof(handle->hello_in);
+    result = globus_xio_driver_pass_read(
+        op, &handle->handshake_iovec, 1, sizeof(handle->hello_in),
+        globus_l_xio_shm_hello_read_cb, handle);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+    return;
+
+error:
+    globus_l_xio_shm_open_failed(handle, op, result);
+}
+
+static
+void
+globus_l_xio_shm_open_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    globus_l_xio_shm_handle_t *         handle;
+    GlobusXIOName(globus_l_xio_shm_open_cb);
+
+    GlobusXIOShmDebugEnter();
+    handle = (globus_l_xio_shm_handle_t *) user_arg;
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+
+    /* the ring is created before we know where the other end is.  it
+     * costs no memory until written and is removed if not used */
+    memcpy(handle->hello_out.magic, GLOBUS_L_XIO_SHM_MAGIC,
+        sizeof(handle->hello_out.magic));
+    globus_l_xio_shm_host_id(handle->hello_out.host_id);
+    handle->hello_out.uid = htonl(geteuid());
+    handle->hello_out.ring_size = htonl(handle->ring_size);
+    result = globus_l_xio_shm_ring_create(handle);
+    if(result == GLOBUS_SUCCESS)
+    {
+        memcpy(handle->hello_out.name, handle->out_name,
+            sizeof(handle->hello_out.name));
+    }
+    else
+    {
+        globus_object_free(globus_error_get(result));
+    }
+
+    handle->handshake_iovec.iov_base = &handle->hello_out;
+    handle->handshake_iovec.iov_len = sizeof(handle->hello_out);
+    result = globus_xio_driver_pass_write(
+        op, &handle->handshake_iovec, 1, sizeof(handle->hello_out),
+        globus_l_xio_shm_hello_write_cb, handle);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+    GlobusXIOShmDebugExit();
+    return;
+
+error:
+    globus_l_xio_shm_open_failed(handle, op, result);
+    GlobusXIOShmDebugExitWithError();
+}
+
+static
+globus_result_t
+globus_l_xio_shm_open(
+    const globus_xio_contact_t *        contact_info,
+    void *                              driver_link,
+    void *                              driver_attr,
+    globus_xio_operation_t              op)
+{
+    globus_l_xio_shm_handle_t *         handle;
+    globus_l_xio_shm_attr_t *           attr;
+    globus_result_t                     result;
+    GlobusXIOName(globus_l_xio_shm_open);
+
+    GlobusXIOShmDebugEnter();
+    attr = driver_attr ? (globus_l_xio_shm_attr_t *) driver_attr
+        : &globus_l_xio_shm_attr_default;
+
+    handle = (globus_l_xio_shm_handle_t *)
+        globus_calloc(1, sizeof(globus_l_xio_shm_handle_t));
+    if(handle == NULL)
+    {
+        result = GlobusXIOErrorMemory("handle");
+        goto error_handle;
+    }
+    globus_mutex_init(&handle->mutex, NULL);
+    globus_fifo_init(&handle->write_q);
+    handle->ring_size = attr->ring_size;
+    handle->notice_iovec.iov_base = &handle->notice;
+    handle->notice_iovec.iov_len = sizeof(handle->notice);
+
+    result = globus_xio_driver_pass_open(
+        op, contact_info, globus_l_xio_shm_open_cb, handle);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_pass;
+    }
+    GlobusXIOShmDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_pass:
+    globus_l_xio_shm_handle_destroy(handle);
+error_handle:
+    GlobusXIOShmDebugExitWithError();
+    return result;
+}
+
+static
+void
+globus_l_xio_shm_close_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    globus_l_xio_shm_handle_destroy((globus_l_xio_shm_handle_t *) user_arg);
+    globus_xio_driver_finished_close(op, result);
+}
+
+static
+globus_result_t
+globus_l_xio_shm_close(
+    void *                              driver_specific_handle,
+    void *                              attr,
+    globus_xio_operation_t              op)
+{
+    return globus_xio_driver_pass_close(
+        op, globus_l_xio_shm_close_cb, driver_specific_handle);
+}
+
+static
+void
+globus_l_xio_shm_pass_read_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_xio_driver_finished_read(op, result, nbytes);
+}
+
+static
+void
+globus_l_xio_shm_notice_read_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_xio_shm_handle_t *         handle;
+    globus_l_xio_shm_notice_t *         notice;
+    GlobusXIOName(globus_l_xio_shm_notice_read_cb);
+
+    handle = (globus_l_xio_shm_handle_t *) user_arg;
+    notice = &handle->notice;
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+    if(notice->type != GLOBUS_L_XIO_SHM_NOTICE_RING ||
+        notice->length == 0 ||
+        notice->length > handle->in.size)
+    {
+        result = GlobusXIOShmErrorProtocol("invalid notice");
+        goto error;
+    }
+
+    handle->ring_pending = notice->length;
+    nbytes = globus_l_xio_shm_ring_get(
+        &handle->in,
+        handle->read_iovec,
+        handle->read_iovec_count,
+        handle->ring_pending);
+    handle->ring_pending -= nbytes;
+    globus_xio_driver_finished_read(op, GLOBUS_SUCCESS, nbytes);
+    return;
+
+error:
+    globus_xio_driver_finished_read(op, result, 0);
+}
+
+static
+globus_result_t
+globus_l_xio_shm_read(
+    void *                              driver_specific_handle,
+    const globus_xio_iovec_t *          iovec,
+    int                                 iovec_count,
+    globus_xio_operation_t              op)
+{
+    globus_l_xio_shm_handle_t *         handle;
+    globus_size_t                       nbytes;
+    globus_result_t                     result;
+    GlobusXIOName(globus_l_xio_shm_read);
+
+    GlobusXIOShmDebugEnter();
+    handle = (globus_l_xio_shm_handle_t *) driver_specific_handle;
+    if(!handle->active)
+    {
+        result = globus_xio_driver_pass_read(
+            op, (globus_xio_iovec_t *) iovec, iovec_count,
+            globus_xio_operation_get_wait_for(op),
+            globus_l_xio_shm_pass_read_cb, NULL);
+    }
+    else if(handle->ring_pending > 0)
+    {
+        nbytes = globus_l_xio_shm_ring_get(
+            &handle->in, iovec, iovec_count, handle->ring_pending);
+        handle->ring_pending -= nbytes;
+        globus_xio_driver_finished_read(op, GLOBUS_SUCCESS, nbytes);
+        result = GLOBUS_SUCCESS;
+    }
+    else
+    {
+        handle->read_iovec = iovec;
+        handle->read_iovec_count = iovec_count;
+        result = globus_xio_driver_pass_read(
+            op, &handle->notice_iovec, 1, sizeof(handle->notice),
+            globus_l_xio_shm_notice_read_cb, handle);
+    }
+    if(result != GLOBUS_SUCCESS)
+    {
+        GlobusXIOShmDebugExitWithError();
+        return result;
+    }
+    GlobusXIOShmDebugExit();
+    return GLOBUS_SUCCESS;
+}
+
+static
+void
+globus_l_xio_shm_pass_write_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_xio_driver_finished_write(op, result, nbytes);
+}
+
+static
+void
+globus_l_xio_shm_write_next(
+    globus_l_xio_shm_write_t *          req);
+
+/* finish a write and start the next one queued behind it */
+static
+void
+globus_l_xio_shm_write_done(
+    globus_l_xio_shm_write_t *          req,
+    globus_result_t                     result)
+{
+    globus_l_xio_shm_handle_t *         handle;
+    globus_l_xio_shm_write_t *          next = NULL;
+    globus_xio_operation_t              op;
+    globus_size_t                       nbytes;
+
+    handle = req->handle;
+    op = req->op;
+    nbytes = req->nbytes;
+    globus_free(req);
+
+    globus_mutex_lock(&handle->mutex);
+    {
+        if(globus_fifo_empty(&handle->write_q))
+        {
+            handle->writing = GLOBUS_FALSE;
+        }
+        else
+        {
+            next = (globus_l_xio_shm_write_t *)
+                globus_fifo_dequeue(&handle->write_q);
+        }
+    }
+    globus_mutex_unlock(&handle->mutex);
+
+    globus_xio_driver_finished_write(op, result, nbytes);
+    if(next != NULL)
+    {
+        globus_l_xio_shm_write_next(next);
+    }
+}
+
+static
+void
+globus_l_xio_shm_write_cb(
+    globus_xio_operation_t              op,
+    globus_result_t                     result,
+    globus_size_t                       nbytes,
+    void *                              user_arg)
+{
+    globus_l_xio_shm_write_t *          req;
+
+    req = (globus_l_xio_shm_write_t *) user_arg;
+    /* the data in the ring counts once its notice is sent */
+    if(result == GLOBUS_SUCCESS)
+    {
+        req->nbytes += req->notice.length;
+        if(req->nbytes < req->length)
+        {
+            globus_l_xio_shm_write_next(req);
+            return;
+        }
+    }
+    globus_l_xio_shm_write_done(req, result);
+}
+
+static
+void
+globus_l_xio_shm_write_retry_cb(
+    void *                              user_arg)
+{
+    globus_l_xio_shm_write_next((globus_l_xio_shm_write_t *) user_arg);
+}
+
+/* copy as much of the rest of the write as fits into the ring and tell the
+ * reader.  a full ring is checked again after a short wait that grows up
+ * to a millisecond, the reader doesn't say when it has made room */
+static
+void
+globus_l_xio_shm_write_next(
+    globus_l_xio_shm_write_t *          req)
+{
+    globus_l_xio_shm_ring_t *           ring;
+    globus_reltime_t                    delay;
+    globus_result_t                     result;
+    globus_size_t                       space;
+    GlobusXIOName(globus_l_xio_shm_write_next);
+
+    ring = &req->handle->out;
+    space = ring->size - (globus_size_t) (ring->pos - ring->header->read_pos);
+    GlobusXIOShmBarrier();
+    if(space == 0)
+    {
+        if(globus_xio_operation_is_canceled(req->op))
+        {
+            result = GlobusXIOErrorCanceled();
+            goto error;
+        }
+        GlobusTimeReltimeSet(delay, 0, req->wait_usec);
+        req->wait_usec = req->wait_usec ? req->wait_usec * 2 : 10;
+        if(req->wait_usec > 1000)
+        {
+            req->wait_usec = 1000;
+        }
+        result = globus_callback_register_oneshot(
+            NULL, &delay, globus_l_xio_shm_write_retry_cb, req);
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto error;
+        }
+        return;
+    }
+    req->wait_usec = 0;
+
+    req->notice.type = GLOBUS_L_XIO_SHM_NOTICE_RING;
+    req->notice.length = req->length - req->nbytes < space
+        ? req->length - req->nbytes : space;
+    globus_l_xio_shm_ring_put(ring,
+        req->iovec, req->iovec_count, req->nbytes, req->notice.length);
+
+    result = globus_xio_driver_pass_write(
+        req->op, &req->notice_iovec, 1, sizeof(req->notice),
+        globus_l_xio_shm_write_cb, req);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error;
+    }
+    return;
+
+error:
+    globus_l_xio_shm_write_done(req, result);
+}
+
+static
+globus_result_t
+globus_l_xio_shm_write(
+    void *                              driver_specific_handle,
+    const globus_xio_iovec_t *          iovec,
+    int                                 iovec_count,
+    globus_xio_operation_t              op)
+{
+    globus_l_xio_shm_handle_t *         handle;
+    globus_l_xio_shm_write_t *          req;
+    globus_size_t                       length;
+    globus_bool_t                       start;
+    globus_result_t                     result;
+    GlobusXIOName(globus_l_xio_shm_write);
+
+    GlobusXIOShmDebugEnter();
+    handle = (globus_l_xio_shm_handle_t *) driver_specific_handle;
+    if(!handle->active)
+    {
+        result = globus_xio_driver_pass_write(
+            op, (globus_xio_iovec_t *) iovec, iovec_count,
+            globus_xio_operation_get_wait_for(op),
+            globus_l_xio_shm_pass_write_cb, NULL);
+        if(result != GLOBUS_SUCCESS)
+        {
+            goto error;
+        }
+        GlobusXIOShmDebugExit();
+        return GLOBUS_SUCCESS;
+    }
+
+    GlobusXIOUtilIovTotalLength(length, iovec, iovec_count);
+    if(length == 0)
+    {
+        globus_xio_driver_finished_write(op, GLOBUS_SUCCESS, 0);
+        GlobusXIOShmDebugExit();
+        return GLOBUS_SUCCESS;
+    }
+
+    req = (globus_l_xio_shm_write_t *)
+        globus_calloc(1, sizeof(globus_l_xio_shm_write_t));
+    if(req == NULL)
+    {
+        result = GlobusXIOErrorMemory("req");
+        goto error;
+    }
+    req->op = op;
+    req->handle = handle;
+    req->iovec = iovec;
+    req->iovec_count = iovec_count;
+    req->length = length;
+    req->notice_iovec.iov_base = &req->notice;
+    req->notice_iovec.iov_len = sizeof(req->notice);
+
+    /* writes go into the ring whole and in the order they were passed,
+     * the way the transport would send them */
+    globus_mutex_lock(&handle->mutex);
+    {
+        start = !handle->writing;
+        if(start)
+        {
+            handle->writing = GLOBUS_TRUE;
+        }
+        else
+        {
+            globus_fifo_enqueue(&handle->write_q, req);
+        }
+    }
+    globus_mutex_unlock(&handle->mutex);
+    if(start)
+    {
+        globus_l_xio_shm_write_next(req);
+    }
+
+    GlobusXIOShmDebugExit();
+    return GLOBUS_SUCCESS;
+
+error:
+    GlobusXIOShmDebugExitWithError();
+    return result;
+}
+
+static
+globus_result_t
+globus_l_xio_shm_cntl(
+    void *                              driver_specific_handle,
+    int                                 cmd,
+    va_list                             ap)
+{
+    globus_l_xio_shm_handle_t *         handle;
+    globus_bool_t *                     out_bool;
+    GlobusXIOName(globus_l_xio_shm_cntl);
+
+    handle = (globus_l_xio_shm_handle_t *) driver_specific_handle;
+    switch(cmd)
+    {
+        case GLOBUS_XIO_SHM_GET_ACTIVE:
+            out_bool = va_arg(ap, globus_bool_t *);
+            *out_bool = handle->active;
+            break;
+
+        default:
+            return GlobusXIOErrorInvalidCommand(cmd);
+    }
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_result_t
+globus_l_xio_shm_attr_init(
+    void **                             out_attr)
+{
+    globus_l_xio_shm_attr_t *           attr;
+    GlobusXIOName(globus_l_xio_shm_attr_init);
+
+    attr = (globus_l_xio_shm_attr_t *)
+        globus_malloc(sizeof(globus_l_xio_shm_attr_t));
+    if(attr == NULL)
+    {
+        return GlobusXIOErrorMemory("attr");
+    }
+    memcpy(attr, &globus_l_xio_shm_attr_default,
+        sizeof(globus_l_xio_shm_attr_t));
+    *out_attr = attr;
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_result_t
+globus_l_xio_shm_attr_copy(
+    void **                             dst,
+    void *                              src)
+{
+    globus_l_xio_shm_attr_t *           attr;
+    GlobusXIOName(globus_l_xio_shm_attr_copy);
+
+    attr = (globus_l_xio_shm_attr_t *)
+        globus_malloc(sizeof(globus_l_xio_shm_attr_t));
+    if(attr == NULL)
+    {
+        return GlobusXIOErrorMemory("attr");
+    }
+    memcpy(attr, src, sizeof(globus_l_xio_shm_attr_t));
+    *dst = attr;
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_result_t
+globus_l_xio_shm_attr_cntl(
+    void *                              driver_attr,
+    int                                 cmd,
+    va_list                             ap)
+{
+    globus_l_xio_shm_attr_t *           attr;
+    int *                               out_int;
+    GlobusXIOName(globus_l_xio_shm_attr_cntl);
+
+    attr = (globus_l_xio_shm_attr_t *) driver_attr;
+    switch(cmd)
+    {
+        case GLOBUS_XIO_SHM_SET_RING_SIZE:
+            attr->ring_size = va_arg(ap, int);
+            if(attr->ring_size < GLOBUS_L_XIO_SHM_MIN_RING)
+            {
+                attr->ring_size = GLOBUS_L_XIO_SHM_MIN_RING;
+            }
+            break;
+
+        case GLOBUS_XIO_SHM_GET_RING_SIZE:
+            out_int = va_arg(ap, int *);
+            *out_int = attr->ring_size;
+            break;
+
+        default:
+            return GlobusXIOErrorInvalidCommand(cmd);
+    }
+
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_result_t
+globus_l_xio_shm_attr_destroy(
+    void *                              driver_attr)
+{
+    globus_free(driver_attr);
+    return GLOBUS_SUCCESS;
+}
+
+static
+globus_result_t
+globus_l_xio_shm_init(
+    globus_xio_driver_t *               out_driver)
+{
+    globus_xio_driver_t                 driver;
+    globus_result_t                     result;
+    GlobusXIOName(globus_l_xio_shm_init);
+
+    GlobusXIOShmDebugEnter();
+    result = globus_xio_driver_init(&driver, "shm", GLOBUS_NULL);
+    if(result != GLOBUS_SUCCESS)
+    {
+        result = GlobusXIOErrorWrapFailed(
+            "globus_l_xio_driver_init", result);
+        goto error_init;
+    }
+    globus_xio_driver_set_transform(
+        driver,
+        globus_l_xio_shm_open,
+        globus_l_xio_shm_close,
+        globus_l_xio_shm_read,
+        globus_l_xio_shm_write,
+        globus_l_xio_shm_cntl,
+        GLOBUS_NULL);
+    globus_xio_driver_set_attr(
+        driver,
+        globus_l_xio_shm_attr_init,
+        globus_l_xio_shm_attr_copy,
+        globus_l_xio_shm_attr_cntl,
+        globus_l_xio_shm_attr_destroy);
+    globus_xio_driver_string_cntl_set_table(
+        driver,
+        shm_l_string_opts_table);
+    *out_driver = driver;
+    GlobusXIOShmDebugExit();
+    return GLOBUS_SUCCESS;
+
+error_init:
+    GlobusXIOShmDebugExitWithError();
+    return result;
+}
+
+static
+void
+globus_l_xio_shm_destroy(
+    globus_xio_driver_t                 driver)
+{
+    globus_xio_driver_destroy(driver);
+}
+
+GlobusXIODefineDriver(
+    shm,
+    globus_l_xio_shm_init,
+    globus_l_xio_shm_destroy);
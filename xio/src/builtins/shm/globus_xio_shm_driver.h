@@ -0,0 +1,165 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GLOBUS_XIO_SHM_DRIVER_H
+#define GLOBUS_XIO_SHM_DRIVER_H
+
+/**
+ * @file globus_xio_shm_driver.h
+ * @brief XIO Shared Memory Driver
+ */
+
+#include "globus_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup globus_xio_shm_driver Globus XIO Shared Memory Driver
+ * @ingroup globus_xio
+ * A transform driver that moves data through shared memory when both ends
+ * of a connection are on the same host.
+ */
+
+/**
+ * @defgroup globus_xio_shm_driver_instance Opening/Closing
+ * @ingroup globus_xio_shm_driver
+ *
+ * The shm driver is pushed on top of a connected transport, usually tcp,
+ * on both ends of the connection, for example with -dcstack tcp,shm.
+ *
+ * When the handle is opened each end sends the other its host identity and
+ * user id over the transport.  If they match, each end creates a POSIX
+ * shared memory ring for the data it writes, readable only by its own user,
+ * and the other end maps it.  If the ends are on different hosts, run as
+ * different users, or either end can't map the other's ring, the driver
+ * passes everything straight through to the transport.
+ *
+ * Both ends must have the driver on their stack.  An end without it would
+ * read the handshake as data.
+ */
+
+/**
+ * @defgroup globus_xio_shm_driver_io Reading/Writing
+ * @ingroup globus_xio_shm_driver
+ *
+ * Written data is copied into the writer's ring, and only a 16 byte notice
+ * of how much was written goes over the transport.  The reader copies the
+ * data out of the ring and marks the space free.  A write that doesn't fit
+ * waits for the reader to make room, checking again after a short delay
+ * that grows to a millisecond.  Writes reach the ring whole and in order.
+ *
+ * Only one read may be outstanding at a time.
+ */
+
+/**
+ * @defgroup globus_xio_shm_driver_envs Env Variables
+ * @ingroup globus_xio_shm_driver
+ *
+ * - GLOBUS_XIO_SHM_DEBUG Available if using a debug build.  See
+ *   globus_debug.h for format.  The SHM driver defines the levels TRACE for
+ *   all function call tracing and INFO for the result of each handshake.
+ */
+
+/**
+ * @defgroup globus_xio_shm_driver_cntls Attributes and Cntls
+ * @ingroup globus_xio_shm_driver
+ *
+ * Shm driver specific attrs and cntls.
+ *
+ * @see globus_xio_attr_cntl()
+ * @see globus_xio_handle_cntl()
+ */
+
+/**
+ * @defgroup globus_xio_shm_driver_errors Error Types
+ * @ingroup globus_xio_shm_driver
+ *
+ * The errors reported by SHM driver include GLOBUS_XIO_ERROR_EOF,
+ * GLOBUS_XIO_ERROR_CANCELED, @ref GLOBUS_XIO_SHM_ERROR_PROTOCOL and those
+ * of the transport below it.
+ *
+ * @see globus_xio_driver_error_match()
+ */
+
+/**
+ * SHM driver specific error types
+ * @ingroup globus_xio_shm_driver_errors
+ */
+typedef enum
+{
+    /**
+     * Indicates that the other end sent a notice that is not valid
+     */
+    GLOBUS_XIO_SHM_ERROR_PROTOCOL
+} globus_xio_shm_error_type_t;
+
+
+/** doxygen varargs filter stuff
+ * GlobusVarArgDefine(
+ *      attr, globus_result_t, globus_xio_attr_cntl, attr, driver)
+ * GlobusVarArgDefine(
+ *      handle, globus_result_t, globus_xio_handle_cntl, handle, driver)
+ */
+
+/**
+ * SHM driver specific cntls
+ * @ingroup globus_xio_shm_driver_cntls
+ */
+typedef enum
+{
+    /** GlobusVarArgEnum(attr)
+     * Set the size of the ring this end writes into.
+     * @ingroup globus_xio_shm_driver_cntls
+     * The string option for this is "ring_size", which takes k, m and g
+     * suffixes.
+     *
+     * @param ring_size
+     *      The size of the ring in bytes.  Values under 64k are raised to
+     *      64k.  The default is 4m.  Pages of the ring are only allocated
+     *      once they have been written.
+     */
+    /* int                              ring_size */
+    GLOBUS_XIO_SHM_SET_RING_SIZE,
+
+    /** GlobusVarArgEnum(attr)
+     * Get the size of the ring this end writes into.
+     * @ingroup globus_xio_shm_driver_cntls
+     *
+     * @param ring_size_out
+     *      The ring size will be stored here.
+     */
+    /* int *                            ring_size_out */
+    GLOBUS_XIO_SHM_GET_RING_SIZE,
+
+    /** GlobusVarArgEnum(handle)
+     * Find out whether data on this handle goes through shared memory.
+     * @ingroup globus_xio_shm_driver_cntls
+     *
+     * @param active_out
+     *      GLOBUS_TRUE will be stored here if both ends mapped each other's
+     *      ring, GLOBUS_FALSE if the driver is passing data through.
+     */
+    /* globus_bool_t *                  active_out */
+    GLOBUS_XIO_SHM_GET_ACTIVE
+} globus_xio_shm_cmd_t;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -764,6 +764,12 @@ typedef struct globus_i_xio_op_timer_s
     globus_callback_handle_t            periodic_handle;
 } globus_i_xio_timer_t;
 
+void
+globus_i_xio_error_static_init(void);
+
+void
+globus_i_xio_error_static_destroy(void);
+
 void
 globus_i_xio_timer_init(
     globus_i_xio_timer_t *              timer);
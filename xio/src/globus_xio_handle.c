@@ -812,6 +812,7 @@ globus_l_xio_activate(void)
     globus_l_xio_active = GLOBUS_TRUE;
     
     globus_i_xio_load_init();
+    globus_i_xio_error_static_init();
 
     globus_l_xio_handle_create_from_url_init();
 
@@ -838,6 +839,7 @@ globus_l_xio_deactivate(void)
     globus_cond_destroy(&globus_i_xio_cond);
     globus_i_xio_timer_destroy(&globus_i_xio_timeout_timer);
     globus_i_xio_load_destroy();
+    globus_i_xio_error_static_destroy();
     globus_l_xio_active = GLOBUS_FALSE;
 
     rc = globus_module_deactivate(GLOBUS_COMMON_MODULE);
@@ -14,10 +14,164 @@
  * limitations under the License.
  */
 
+#include "globus_i_xio.h"
 #include "globus_xio_util.h"
 #include "globus_xio_types.h"
 #include "globus_common.h"
 
+/* results of the errors made at activation, GLOBUS_SUCCESS when not made */
+static globus_result_t                  globus_l_xio_eof_result;
+static globus_result_t                  globus_l_xio_canceled_result;
+static globus_result_t                  globus_l_xio_timeout_result;
+
+static
+globus_object_t *
+globus_l_xio_error_construct(
+    int                                 type,
+    const char *                        source_file,
+    const char *                        source_func,
+    int                                 source_line)
+{
+    switch(type)
+    {
+      case GLOBUS_XIO_ERROR_EOF:
+        return globus_error_construct_error(
+            GLOBUS_XIO_MODULE,
+            GLOBUS_NULL,
+            GLOBUS_XIO_ERROR_EOF,
+            source_file,
+            source_func,
+            source_line,
+            _XIOSL("An end of file occurred"));
+
+      case GLOBUS_XIO_ERROR_TIMEOUT:
+        return globus_error_construct_error(
+            GLOBUS_XIO_MODULE,
+            globus_error_construct_error(
+                GLOBUS_XIO_MODULE,
+                GLOBUS_NULL,
+                GLOBUS_XIO_ERROR_TIMEOUT,
+                source_file,
+                source_func,
+                source_line,
+                _XIOSL("Operation timed out")),
+            GLOBUS_XIO_ERROR_CANCELED,
+            source_file,
+            source_func,
+            source_line,
+            _XIOSL("Operation was canceled"));
+
+      default:
+        return globus_error_construct_error(
+            GLOBUS_XIO_MODULE,
+            GLOBUS_NULL,
+            GLOBUS_XIO_ERROR_CANCELED,
+            source_file,
+            source_func,
+            source_line,
+            _XIOSL("Operation was canceled"));
+    }
+}
+
+static
+globus_result_t
+globus_l_xio_error_static_result(
+    int                                 type)
+{
+    if(globus_i_error_verbose)
+    {
+        /* keep the source of each error for the verbose chain */
+        return GLOBUS_SUCCESS;
+    }
+
+    switch(type)
+    {
+      case GLOBUS_XIO_ERROR_EOF:
+        return globus_l_xio_eof_result;
+
+      case GLOBUS_XIO_ERROR_TIMEOUT:
+        return globus_l_xio_timeout_result;
+
+      default:
+        return globus_l_xio_canceled_result;
+    }
+}
+
+static
+globus_result_t
+globus_l_xio_error_put_static(
+    int                                 type)
+{
+    globus_result_t                     result;
+    GlobusXIOName(globus_i_xio_error_static_init);
+
+    result = globus_error_put_static(
+        globus_l_xio_error_construct(type, __FILE__, _xio_name, __LINE__));
+
+    return result == GLOBUS_FAILURE ? GLOBUS_SUCCESS : result;
+}
+
+void
+globus_i_xio_error_static_init(void)
+{
+    globus_l_xio_eof_result =
+        globus_l_xio_error_put_static(GLOBUS_XIO_ERROR_EOF);
+    globus_l_xio_canceled_result =
+        globus_l_xio_error_put_static(GLOBUS_XIO_ERROR_CANCELED);
+    globus_l_xio_timeout_result =
+        globus_l_xio_error_put_static(GLOBUS_XIO_ERROR_TIMEOUT);
+}
+
+void
+globus_i_xio_error_static_destroy(void)
+{
+    globus_error_release_static(globus_l_xio_eof_result);
+    globus_error_release_static(globus_l_xio_canceled_result);
+    globus_error_release_static(globus_l_xio_timeout_result);
+    globus_l_xio_eof_result = GLOBUS_SUCCESS;
+    globus_l_xio_canceled_result = GLOBUS_SUCCESS;
+    globus_l_xio_timeout_result = GLOBUS_SUCCESS;
+}
+
+globus_result_t
+globus_i_xio_error_static(
+    int                                 type,
+    const char *                        source_file,
+    const char *                        source_func,
+    int                                 source_line)
+{
+    globus_result_t                     result;
+
+    result = globus_l_xio_error_static_result(type);
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_error_put(globus_l_xio_error_construct(
+            type, source_file, source_func, source_line));
+    }
+
+    return result;
+}
+
+globus_object_t *
+globus_i_xio_error_static_obj(
+    int                                 type,
+    const char *                        source_file,
+    const char *                        source_func,
+    int                                 source_line)
+{
+    globus_result_t                     result;
+
+    result = globus_l_xio_error_static_result(type);
+    if(result != GLOBUS_SUCCESS)
+    {
+        /* a reference of its own, freed or put like any other */
+        return globus_error_get(result);
+    }
+
+    return globus_l_xio_error_construct(
+        type, source_file, source_func, source_line);
+}
+
 globus_bool_t
 globus_xio_get_env_pair(
     const char *                        env_name,
@@ -41,6 +195,10 @@ globus_bool_t
 globus_xio_error_is_eof(
     globus_result_t                     res)
 {
+    if(res != GLOBUS_SUCCESS && res == globus_l_xio_eof_result)
+    {
+        return GLOBUS_TRUE;
+    }
     return globus_error_match(
         globus_error_peek(res), GLOBUS_XIO_MODULE, GLOBUS_XIO_ERROR_EOF);
 }
@@ -49,6 +207,11 @@ globus_bool_t
 globus_xio_error_is_canceled(
     globus_result_t                     res)
 {
+    if(res != GLOBUS_SUCCESS && (res == globus_l_xio_canceled_result ||
+        res == globus_l_xio_timeout_result))
+    {
+        return GLOBUS_TRUE;
+    }
     return globus_error_match(
         globus_error_peek(res), GLOBUS_XIO_MODULE, GLOBUS_XIO_ERROR_CANCELED);
 }
@@ -85,6 +85,25 @@ globus_xio_contact_copy(
     globus_xio_contact_t *              dst,
     const globus_xio_contact_t *        src);
 
+/*
+ * eof, cancel and timeout errors are the same every time, so the macros for
+ * them hand out errors made once at activation rather than building one per
+ * call.  with GLOBUS_ERROR_VERBOSE set each still names its own source line.
+ */
+globus_result_t
+globus_i_xio_error_static(
+    int                                 type,
+    const char *                        source_file,
+    const char *                        source_func,
+    int                                 source_line);
+
+globus_object_t *
+globus_i_xio_error_static_obj(
+    int                                 type,
+    const char *                        source_file,
+    const char *                        source_func,
+    int                                 source_line);
+
 /*
  * Utility macros
  */
@@ -99,29 +118,20 @@ globus_xio_contact_copy(
 #endif
 
 #define GlobusXIOErrorCanceled()                                            \
-    globus_error_put(GlobusXIOErrorObjCanceled())
+    globus_i_xio_error_static(                                              \
+        GLOBUS_XIO_ERROR_CANCELED, __FILE__, _xio_name, __LINE__)
 
 #define GlobusXIOErrorObjCanceled()                                         \
-    globus_error_construct_error(                                           \
-        GLOBUS_XIO_MODULE,                                                  \
-        GLOBUS_NULL,                                                        \
-        GLOBUS_XIO_ERROR_CANCELED,                                          \
-        __FILE__,                                                           \
-        _xio_name,                                                          \
-        __LINE__,							    \
-        _XIOSL("Operation was canceled"))                                          
+    globus_i_xio_error_static_obj(                                          \
+        GLOBUS_XIO_ERROR_CANCELED, __FILE__, _xio_name, __LINE__)
+
 #define GlobusXIOErrorTimeout()                                             \
-    globus_error_put(GlobusXIOErrorObjTimeout())                               
+    globus_i_xio_error_static(                                              \
+        GLOBUS_XIO_ERROR_TIMEOUT, __FILE__, _xio_name, __LINE__)
 
 #define GlobusXIOErrorObjTimeout()                                          \
-    globus_error_construct_error(                                           \
-        GLOBUS_XIO_MODULE,                                                  \
-        GlobusXIOErrorObjTimeoutOnly(),                                     \
-        GLOBUS_XIO_ERROR_CANCELED,                                          \
-        __FILE__,                                                           \
-        _xio_name,                                                          \
-        __LINE__,                                                           \
-        _XIOSL("Operation was canceled"))
+    globus_i_xio_error_static_obj(                                          \
+        GLOBUS_XIO_ERROR_TIMEOUT, __FILE__, _xio_name, __LINE__)
 
 #define GlobusXIOErrorObjTimeoutOnly()                                      \
     globus_error_construct_error(                                           \
@@ -134,19 +144,13 @@ globus_xio_contact_copy(
         _XIOSL("Operation timed out"))
 
 #define GlobusXIOErrorObjEOF()                                              \
-        globus_error_construct_error(                                       \
-            GLOBUS_XIO_MODULE,                                              \
-            GLOBUS_NULL,                                                    \
-            GLOBUS_XIO_ERROR_EOF,                                           \
-            __FILE__,                                                       \
-            _xio_name,                                                      \
-            __LINE__,                                                       \
-            _XIOSL("An end of file occurred"))                                
-                                                                            
+    globus_i_xio_error_static_obj(                                          \
+        GLOBUS_XIO_ERROR_EOF, __FILE__, _xio_name, __LINE__)
+
 #define GlobusXIOErrorEOF()                                                 \
-    globus_error_put(                                                       \
-        GlobusXIOErrorObjEOF())                                             \
-                                                                            
+    globus_i_xio_error_static(                                              \
+        GLOBUS_XIO_ERROR_EOF, __FILE__, _xio_name, __LINE__)
+
 #define GlobusXIOErrorInvalidCommand(cmd_number)                            \
     globus_error_put(                                                       \
         globus_error_construct_error(                                       \
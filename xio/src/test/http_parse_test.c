@@ -0,0 +1,327 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file http_parse_test.c
+ * @brief HTTP Parser test
+ *
+ * Runs the HTTP driver's response and header parsers directly on buffers
+ * in memory, without a transport:
+ * - a response parsed in one piece gives the expected status, interned
+ *   entity headers and header table
+ * - the same response arriving one byte at a time parses the same way,
+ *   including a header continued on a second line
+ * - a server drops Content-Length, Transfer-Encoding and Connection from
+ *   its header table and keeps the rest
+ * - parse throughput of a typical response, printed as a comment
+ */
+#include "globus_common.h"
+#include "globus_xio.h"
+#include "globus_i_xio_http.h"
+
+#define PARSE_ITERATIONS 200000
+
+static const char *                     test_response =
+    "HTTP/1.1 200 OK\r\n"
+    "Date: Mon, 19 Oct 2026 12:00:00 GMT\r\n"
+    "Server: Apache/2.4.58 (Unix)\r\n"
+    "Last-Modified: Sun, 18 Oct 2026 08:30:00 GMT\r\n"
+    "ETag: \"5f3a-1b2c3d4e5f607\"\r\n"
+    "Accept-Ranges: bytes\r\n"
+    "Content-Length: 123456\r\n"
+    "Cache-Control: max-age=3600,\r\n"
+    "\tmust-revalidate\r\n"
+    "Content-Type: application/octet-stream\r\n"
+    "X-Request-Id: 8b1f2a7c-4d3e-11ef-9a55-0242ac120002\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+static const char *                     test_request_headers =
+    "Host: example.org:8080\r\n"
+    "User-Agent: globus-url-copy/10.4\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "Content-Length: 42\r\n"
+    "Connection: close\r\n"
+    "Accept:*/*\r\n"
+    "\r\n";
+
+static
+void
+handle_setup(
+    globus_i_xio_http_handle_t *        http_handle,
+    char *                              buffer,
+    globus_bool_t                       is_client)
+{
+    memset(http_handle, 0, sizeof(globus_i_xio_http_handle_t));
+    http_handle->target_info.is_client = is_client;
+    http_handle->read_buffer.iov_base = buffer;
+    http_handle->read_buffer.iov_len = strlen(buffer);
+    if (is_client)
+    {
+        globus_i_xio_http_response_init(&http_handle->response_info);
+        http_handle->parse_state = GLOBUS_XIO_HTTP_STATUS_LINE;
+    }
+    else
+    {
+        globus_i_xio_http_request_init(&http_handle->request_info);
+        http_handle->parse_state = GLOBUS_XIO_HTTP_HEADERS;
+    }
+}
+
+static
+globus_bool_t
+header_is(
+    globus_i_xio_http_header_info_t *   headers,
+    const char *                        name,
+    const char *                        value)
+{
+    globus_xio_http_header_t *          header;
+
+    header = globus_hashtable_lookup(&headers->headers, (void *) name);
+    if (value == NULL)
+    {
+        return header == NULL;
+    }
+
+    return header != NULL && strcmp(header->value, value) == 0;
+}
+
+static
+int
+check_response(
+    globus_i_xio_http_handle_t *        http_handle)
+{
+    globus_i_xio_http_header_info_t *   headers;
+
+    headers = &http_handle->response_info.headers;
+    if (http_handle->response_info.status_code != 200 ||
+        http_handle->response_info.http_version
+            != GLOBUS_XIO_HTTP_VERSION_1_1 ||
+        strcmp(http_handle->response_info.reason_phrase, "OK") != 0 ||
+        !GLOBUS_I_XIO_HTTP_HEADER_IS_CONTENT_LENGTH_SET(headers) ||
+        headers->content_length != 123456 ||
+        GLOBUS_I_XIO_HTTP_HEADER_IS_CONNECTION_CLOSE(headers) ||
+        http_handle->parse_state != GLOBUS_XIO_HTTP_IDENTITY_BODY ||
+        http_handle->read_buffer_valid != 0)
+    {
+        return 1;
+    }
+    /* a client keeps every header, including the ones it interns */
+    if (!header_is(headers, "Server", "Apache/2.4.58 (Unix)") ||
+        !header_is(headers, "ETag", "\"5f3a-1b2c3d4e5f607\"") ||
+        !header_is(headers, "Content-Length", "123456") ||
+        !header_is(headers, "Connection", "keep-alive") ||
+        !header_is(headers, "X-Request-Id",
+            "8b1f2a7c-4d3e-11ef-9a55-0242ac120002") ||
+        strncmp(((globus_xio_http_header_t *) globus_hashtable_lookup(
+            &headers->headers, "Cache-Control"))->value,
+            "max-age=3600,", 13) != 0 ||
+        strstr(((globus_xio_http_header_t *) globus_hashtable_lookup(
+            &headers->headers, "Cache-Control"))->value,
+            "must-revalidate") == NULL)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+static
+int
+whole_response_test(void)
+{
+    globus_i_xio_http_handle_t          http_handle;
+    char *                              buffer;
+    globus_bool_t                       done = GLOBUS_FALSE;
+    globus_result_t                     result;
+    int                                 rc;
+
+    buffer = strdup(test_response);
+    handle_setup(&http_handle, buffer, GLOBUS_TRUE);
+    http_handle.read_buffer_valid = strlen(buffer);
+
+    result = globus_l_xio_http_client_parse_response(&http_handle, &done);
+    rc = result != GLOBUS_SUCCESS || !done || check_response(&http_handle);
+
+    globus_i_xio_http_response_destroy(&http_handle.response_info);
+    free(buffer);
+
+    return rc;
+}
+
+static
+int
+byte_at_a_time_test(void)
+{
+    globus_i_xio_http_handle_t          http_handle;
+    char *                              buffer;
+    globus_bool_t                       done = GLOBUS_FALSE;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    globus_size_t                       length;
+    globus_size_t                       i;
+    int                                 rc;
+
+    buffer = strdup(test_response);
+    length = strlen(buffer);
+    handle_setup(&http_handle, buffer, GLOBUS_TRUE);
+
+    for (i = 0; i < length && result == GLOBUS_SUCCESS && !done; i++)
+    {
+        http_handle.read_buffer_valid++;
+        result = globus_l_xio_http_client_parse_response(&http_handle, &done);
+        if (done && i != length - 1)
+        {
+            /* finished before the blank line arrived */
+            result = GLOBUS_FAILURE;
+        }
+    }
+    rc = result != GLOBUS_SUCCESS || !done || check_response(&http_handle);
+
+    globus_i_xio_http_response_destroy(&http_handle.response_info);
+    free(buffer);
+
+    return rc;
+}
+
+static
+int
+server_headers_test(void)
+{
+    globus_i_xio_http_handle_t          http_handle;
+    globus_i_xio_http_header_info_t *   headers;
+    char *                              buffer;
+    globus_bool_t                       done = GLOBUS_FALSE;
+    globus_result_t                     result;
+    int                                 rc;
+
+    buffer = strdup(test_request_headers);
+    handle_setup(&http_handle, buffer, GLOBUS_FALSE);
+    http_handle.read_buffer_valid = strlen(buffer);
+
+    result = globus_i_xio_http_header_parse(&http_handle, &done);
+    headers = &http_handle.request_info.headers;
+    rc = result != GLOBUS_SUCCESS || !done ||
+        headers->transfer_encoding
+            != GLOBUS_XIO_HTTP_TRANSFER_ENCODING_CHUNKED ||
+        headers->content_length != 42 ||
+        !GLOBUS_I_XIO_HTTP_HEADER_IS_CONNECTION_CLOSE(headers) ||
+        http_handle.parse_state != GLOBUS_XIO_HTTP_CHUNK_LINE ||
+        !header_is(headers, "Host", "example.org:8080") ||
+        !header_is(headers, "User-Agent", "globus-url-copy/10.4") ||
+        !header_is(headers, "Accept", "*/*") ||
+        !header_is(headers, "Transfer-Encoding", NULL) ||
+        !header_is(headers, "Content-Length", NULL) ||
+        !header_is(headers, "Connection", NULL) ||
+        globus_hashtable_size(&headers->headers) != 3;
+
+    globus_i_xio_http_request_destroy(&http_handle.request_info);
+    free(buffer);
+
+    return rc;
+}
+
+static
+int
+throughput_test(void)
+{
+    globus_i_xio_http_handle_t          http_handle;
+    char *                              buffer;
+    globus_size_t                       length;
+    globus_bool_t                       done;
+    globus_result_t                     result;
+    globus_abstime_t                    start;
+    globus_abstime_t                    end;
+    globus_reltime_t                    elapsed;
+    long                                usec;
+    int                                 i;
+
+    length = strlen(test_response);
+    buffer = malloc(length + 1);
+
+    GlobusTimeAbstimeGetCurrent(start);
+    for (i = 0; i < PARSE_ITERATIONS; i++)
+    {
+        /* the parser writes into the buffer */
+        memcpy(buffer, test_response, length + 1);
+        handle_setup(&http_handle, buffer, GLOBUS_TRUE);
+        http_handle.read_buffer_valid = length;
+
+        done = GLOBUS_FALSE;
+        result = globus_l_xio_http_client_parse_response(&http_handle, &done);
+        globus_i_xio_http_response_destroy(&http_handle.response_info);
+        if (result != GLOBUS_SUCCESS || !done)
+        {
+            free(buffer);
+            return 1;
+        }
+    }
+    GlobusTimeAbstimeGetCurrent(end);
+    free(buffer);
+
+    GlobusTimeAbstimeDiff(elapsed, end, start);
+    GlobusTimeReltimeToUSec(usec, elapsed);
+    if (usec <= 0)
+    {
+        usec = 1;
+    }
+    printf("# %d responses of %lu bytes: %.0f responses per second, "
+        "%.1f MB/s\n",
+        PARSE_ITERATIONS,
+        (unsigned long) length,
+        PARSE_ITERATIONS * 1000000.0 / usec,
+        (double) PARSE_ITERATIONS * length / usec);
+
+    return 0;
+}
+
+int main()
+{
+    int                                 xc = 0;
+    int                                 i;
+    struct
+    {
+        const char *                    name;
+        int                             (*func)(void);
+    }
+    tests[] =
+    {
+        { "whole_response_test", whole_response_test },
+        { "byte_at_a_time_test", byte_at_a_time_test },
+        { "server_headers_test", server_headers_test },
+        { "throughput_test", throughput_test }
+    };
+
+    printf("1..%d\n", (int) (sizeof(tests) / sizeof(tests[0])));
+
+    globus_module_activate(GLOBUS_XIO_MODULE);
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        if (tests[i].func() == 0)
+        {
+            printf("ok %d - %s\n", i + 1, tests[i].name);
+        }
+        else
+        {
+            printf("not ok %d - %s\n", i + 1, tests[i].name);
+            xc++;
+        }
+    }
+
+    globus_module_deactivate(GLOBUS_XIO_MODULE);
+
+    return xc;
+}
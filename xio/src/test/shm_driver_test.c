@@ -0,0 +1,788 @@
+/*
+ * Copyright 1999-2006 University of Chicago
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file shm_driver_test.c
+ * @brief Shared Memory Driver test
+ *
+ * Connects two handles over loopback with the shm driver on top of tcp:
+ * - both ends agree to use shared memory
+ * - data written in uneven pieces through a small ring, so that it wraps
+ *   and spills over onto tcp, is read back unchanged in other uneven pieces
+ * - a large write and the end of file reach the reader after the writer
+ *   closes
+ * - a hello naming a ring that the other end did not create for this
+ *   connection is refused and the handle passes through to tcp
+ * - throughput with and without the shm driver, printed as a comment
+ */
+#include "globus_common.h"
+#include "globus_xio.h"
+#include "globus_xio_shm_driver.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <arpa/inet.h>
+
+#define TRANSFER_SIZE           (8 * 1024 * 1024)
+#define THROUGHPUT_SIZE         (256 * 1024 * 1024)
+#define THROUGHPUT_BLOCK        (256 * 1024)
+
+static globus_xio_driver_t              tcp_driver;
+static globus_xio_driver_t              shm_driver;
+
+/* the driver's handshake and ring header, as sent by an end that does not
+ * use the driver */
+#define FORGED_RING_SIZE        (64 * 1024)
+#define FORGED_HEADER_SIZE      64
+
+typedef struct
+{
+    char                                magic[8];
+    char                                host_id[64];
+    char                                name[64];
+    uint32_t                            uid;
+    uint32_t                            ring_size;
+    unsigned char                       secret[16];
+} forged_hello_t;
+
+typedef struct
+{
+    uint64_t                            read_pos;
+    unsigned char                       secret[16];
+} forged_header_t;
+
+typedef struct
+{
+    globus_mutex_t                      mutex;
+    globus_cond_t                       cond;
+    globus_bool_t                       done;
+    globus_result_t                     result;
+    globus_byte_t *                     buffer;
+    globus_size_t                       length;
+    globus_size_t                       offset;
+    globus_size_t                       block;
+    unsigned int                        seed;
+} test_monitor_t;
+
+static
+void
+monitor_init(
+    test_monitor_t *                    monitor)
+{
+    memset(monitor, 0, sizeof(test_monitor_t));
+    globus_mutex_init(&monitor->mutex, NULL);
+    globus_cond_init(&monitor->cond, NULL);
+}
+
+static
+void
+monitor_destroy(
+    test_monitor_t *                    monitor)
+{
+    globus_mutex_destroy(&monitor->mutex);
+    globus_cond_destroy(&monitor->cond);
+}
+
+static
+globus_result_t
+monitor_wait(
+    test_monitor_t *                    monitor)
+{
+    globus_mutex_lock(&monitor->mutex);
+    while(!monitor->done)
+    {
+        globus_cond_wait(&monitor->cond, &monitor->mutex);
+    }
+    globus_mutex_unlock(&monitor->mutex);
+
+    return monitor->result;
+}
+
+static
+void
+monitor_signal(
+    test_monitor_t *                    monitor,
+    globus_result_t                     result)
+{
+    globus_mutex_lock(&monitor->mutex);
+    monitor->result = result;
+    monitor->done = GLOBUS_TRUE;
+    globus_cond_signal(&monitor->cond);
+    globus_mutex_unlock(&monitor->mutex);
+}
+
+static
+void
+open_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    monitor_signal(user_arg, result);
+}
+
+static
+globus_result_t
+connect_pair(
+    globus_bool_t                       use_shm,
+    int                                 ring_size,
+    globus_xio_handle_t *               out_client,
+    globus_xio_handle_t *               out_server)
+{
+    globus_xio_stack_t                  stack;
+    globus_xio_attr_t                   attr;
+    globus_xio_server_t                 server;
+    test_monitor_t                      monitor;
+    globus_result_t                     result;
+    char *                              contact;
+
+    monitor_init(&monitor);
+    globus_xio_stack_init(&stack, NULL);
+    globus_xio_stack_push_driver(stack, tcp_driver);
+    globus_xio_attr_init(&attr);
+    if(use_shm)
+    {
+        globus_xio_stack_push_driver(stack, shm_driver);
+        globus_xio_attr_cntl(
+            attr, shm_driver, GLOBUS_XIO_SHM_SET_RING_SIZE, ring_size);
+    }
+
+    result = globus_xio_server_create(&server, NULL, stack);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_server;
+    }
+    globus_xio_server_get_contact_string(server, &contact);
+
+    /* the client can't finish opening until the server end answers */
+    globus_xio_handle_create(out_client, stack);
+    result = globus_xio_register_open(
+        *out_client, contact, attr, open_cb, &monitor);
+    globus_free(contact);
+    if(result != GLOBUS_SUCCESS)
+    {
+        goto error_open;
+    }
+    result = globus_xio_server_accept(out_server, server);
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_open(*out_server, NULL, attr);
+    }
+    if(monitor_wait(&monitor) != GLOBUS_SUCCESS)
+    {
+        result = monitor.result;
+    }
+
+error_open:
+    globus_xio_server_close(server);
+error_server:
+    globus_xio_attr_destroy(attr);
+    globus_xio_stack_destroy(stack);
+    monitor_destroy(&monitor);
+
+    return result;
+}
+
+static
+void
+fill(
+    globus_byte_t *                     buffer,
+    globus_size_t                       length)
+{
+    globus_size_t                       i;
+
+    for(i = 0; i < length; i++)
+    {
+        buffer[i] = (i * 7 + i / 4093) & 0xff;
+    }
+}
+
+static
+void
+writer_close_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    void *                              user_arg)
+{
+    monitor_signal(user_arg, result);
+}
+
+/* writes in pieces of varying size, one after another, while the reader
+ * blocks.  works without threads since the blocking reads poll */
+static
+void
+writer_write_cb(
+    globus_xio_handle_t                 handle,
+    globus_result_t                     result,
+    globus_byte_t *                     buffer,
+    globus_size_t                       len,
+    globus_size_t                       nbytes,
+    globus_xio_data_descriptor_t        data_desc,
+    void *                              user_arg)
+{
+    test_monitor_t *                    monitor;
+
+    monitor = (test_monitor_t *) user_arg;
+    monitor->offset += nbytes;
+    if(result == GLOBUS_SUCCESS && monitor->offset < monitor->length)
+    {
+        if(monitor->block)
+        {
+            len = monitor->block;
+        }
+        else
+        {
+            monitor->seed = monitor->seed * 1103515245 + 12345;
+            len = 1 + (monitor->seed >> 8) % (150 * 1024);
+        }
+        if(len > monitor->length - monitor->offset)
+        {
+            len = monitor->length - monitor->offset;
+        }
+        result = globus_xio_register_write(handle,
+            monitor->buffer + monitor->offset, len, len, NULL,
+            writer_write_cb, monitor);
+        if(result == GLOBUS_SUCCESS)
+        {
+            return;
+        }
+    }
+    if(result == GLOBUS_SUCCESS)
+    {
+        result = globus_xio_register_close(
+            handle, NULL, writer_close_cb, monitor);
+        if(result == GLOBUS_SUCCESS)
+        {
+            return;
+        }
+    }
+    monitor_signal(monitor, result);
+}
+
+static
+void
+writer_start(
+    test_monitor_t *                    monitor,
+    globus_xio_handle_t                 handle,
+    globus_byte_t *                     buffer,
+    globus_size_t                       length,
+    globus_size_t                       block)
+{
+    monitor->buffer = buffer;
+    monitor->length = length;
+    monitor->block = block;
+    monitor->seed = 1;
+    monitor->offset = 0;
+    writer_write_cb(handle, GLOBUS_SUCCESS, NULL, 0, 0, NULL, monitor);
+}
+
+static
+globus_result_t
+transfer(
+    globus_xio_handle_t                 writer,
+    globus_xio_handle_t                 reader,
+    globus_byte_t *                     in,
+    globus_byte_t *                     out,
+    globus_size_t                       length,
+    globus_size_t                       block)
+{
+    test_monitor_t                      monitor;
+    globus_result_t                     result = GLOBUS_SUCCESS;
+    globus_size_t                       offset = 0;
+    globus_size_t                       len;
+    globus_size_t                       nbytes;
+    unsigned int                        seed = 2;
+
+    monitor_init(&monitor);
+    writer_start(&monitor, writer, in, length, block);
+
+    while(result == GLOBUS_SUCCESS)
+    {
+        if(block)
+        {
+            len = block;
+        }
+        else
+        {
+            seed = seed * 1103515245 + 12345;
+            len = 1 + (seed >> 8) % (100 * 1024);
+        }
+        if(len > length - offset)
+        {
+            len = length - offset;
+        }
+        /* one more read to see the end of file */
+        if(len == 0)
+        {
+            len = 1;
+        }
+        result = globus_xio_read(reader, out + offset, len, 1, &nbytes, NULL);
+        offset += nbytes;
+        if(offset > length)
+        {
+            break;
+        }
+    }
+    if(offset == length && globus_xio_error_is_eof(result))
+    {
+        result = GLOBUS_SUCCESS;
+    }
+    else if(result == GLOBUS_SUCCESS)
+    {
+        result = GLOBUS_FAILURE;
+    }
+    else
+    {
+        globus_object_free(globus_error_get(result));
+        result = GLOBUS_FAILURE;
+    }
+
+    if(monitor_wait(&monitor) != GLOBUS_SUCCESS)
+    {
+        result = GLOBUS_FAILURE;
+    }
+    globus_xio_close(reader, NULL);
+    monitor_destroy(&monitor);
+
+    return result;
+}
+
+static
+void
+host_id(
+    char *                              id)
+{
+    FILE *                              fp;
+
+    memset(id, 0, 64);
+    fp = fopen("/proc/sys/kernel/random/boot_id", "r");
+    if(fp != NULL)
+    {
+        if(fgets(id, 64, fp) != NULL && strchr(id, '\n') != NULL)
+        {
+            *strchr(id, '\n') = '\0';
+        }
+        fclose(fp);
+    }
+    if(*id == '\0')
+    {
+        globus_libc_gethostname(id, 63);
+    }
+}
+
+/* a segment that passes for a ring of ours, with the given mode and
+ * secret */
+static
+int
+forged_ring(
+    const char *                        name,
+    mode_t                              mode,
+    const unsigned char *               secret)
+{
+    forged_header_t *                   header;
+    int                                 fd;
+
+    shm_unlink(name);
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if(fd < 0)
+    {
+        return 1;
+    }
+    if(fchmod(fd, mode) < 0 ||
+        ftruncate(fd, FORGED_HEADER_SIZE + FORGED_RING_SIZE) < 0)
+    {
+        close(fd);
+        return 1;
+    }
+    header = mmap(NULL, FORGED_HEADER_SIZE, PROT_READ | PROT_WRITE,
+        MAP_SHARED, fd, 0);
+    close(fd);
+    if(header == MAP_FAILED)
+    {
+        return 1;
+    }
+    memcpy(header->secret, secret, sizeof(header->secret));
+    munmap(header, FORGED_HEADER_SIZE);
+
+    return 0;
+}
+
+/* play the client end of the handshake over plain tcp, sending a hello
+ * that names ring_name, and return whether the shm end accepted the ring */
+static
+int
+forged_hello(
+    const char *                        ring_name,
+    const unsigned char *               secret,
+    globus_bool_t *                     accepted)
+{
+    globus_xio_stack_t                  tcp_stack;
+    globus_xio_stack_t                  shm_stack;
+    globus_xio_server_t                 server;
+    globus_xio_handle_t                 client;
+    globus_xio_handle_t                 shm_end;
+    test_monitor_t                      client_monitor;
+    test_monitor_t                      server_monitor;
+    forged_hello_t                      hello;
+    forged_hello_t                      reply;
+    globus_bool_t                       active = GLOBUS_TRUE;
+    globus_size_t                       nbytes;
+    uint32_t                            ack;
+    char *                              contact;
+    int                                 rc = 1;
+
+    monitor_init(&client_monitor);
+    monitor_init(&server_monitor);
+    globus_xio_stack_init(&tcp_stack, NULL);
+    globus_xio_stack_push_driver(tcp_stack, tcp_driver);
+    globus_xio_stack_init(&shm_stack, NULL);
+    globus_xio_stack_push_driver(shm_stack, tcp_driver);
+    globus_xio_stack_push_driver(shm_stack, shm_driver);
+
+    if(globus_xio_server_create(&server, NULL, shm_stack) != GLOBUS_SUCCESS)
+    {
+        goto error_server;
+    }
+    globus_xio_server_get_contact_string(server, &contact);
+    globus_xio_handle_create(&client, tcp_stack);
+    if(globus_xio_register_open(
+        client, contact, NULL, open_cb, &client_monitor) != GLOBUS_SUCCESS)
+    {
+        globus_free(contact);
+        goto error_open;
+    }
+    globus_free(contact);
+    if(globus_xio_server_accept(&shm_end, server) != GLOBUS_SUCCESS ||
+        globus_xio_register_open(
+            shm_end, NULL, NULL, open_cb, &server_monitor) != GLOBUS_SUCCESS)
+    {
+        monitor_wait(&client_monitor);
+        globus_xio_close(client, NULL);
+        goto error_open;
+    }
+    if(monitor_wait(&client_monitor) != GLOBUS_SUCCESS)
+    {
+        monitor_wait(&server_monitor);
+        globus_xio_close(shm_end, NULL);
+        goto error_open;
+    }
+
+    memset(&hello, 0, sizeof(hello));
+    memcpy(hello.magic, "GXIOSHM1", sizeof(hello.magic));
+    host_id(hello.host_id);
+    strncpy(hello.name, ring_name, sizeof(hello.name) - 1);
+    hello.uid = htonl(geteuid());
+    hello.ring_size = htonl(FORGED_RING_SIZE);
+    memcpy(hello.secret, secret, sizeof(hello.secret));
+    /* our ack is always no, so the shm end passes through afterwards */
+    if(globus_xio_write(client, (globus_byte_t *) &hello, sizeof(hello),
+            sizeof(hello), &nbytes, NULL) == GLOBUS_SUCCESS &&
+        globus_xio_read(client, (globus_byte_t *) &reply, sizeof(reply),
+            sizeof(reply), &nbytes, NULL) == GLOBUS_SUCCESS &&
+        globus_xio_read(client, (globus_byte_t *) &ack, sizeof(ack),
+            sizeof(ack), &nbytes, NULL) == GLOBUS_SUCCESS)
+    {
+        *accepted = ntohl(ack);
+        ack = htonl(GLOBUS_FALSE);
+        if(globus_xio_write(client, (globus_byte_t *) &ack, sizeof(ack),
+            sizeof(ack), &nbytes, NULL) == GLOBUS_SUCCESS &&
+            monitor_wait(&server_monitor) == GLOBUS_SUCCESS)
+        {
+            globus_xio_handle_cntl(
+                shm_end, shm_driver, GLOBUS_XIO_SHM_GET_ACTIVE, &active);
+            rc = active;
+        }
+    }
+    globus_xio_close(client, NULL);
+    monitor_wait(&server_monitor);
+    globus_xio_close(shm_end, NULL);
+
+error_open:
+    globus_xio_server_close(server);
+error_server:
+    globus_xio_stack_destroy(shm_stack);
+    globus_xio_stack_destroy(tcp_stack);
+    monitor_destroy(&server_monitor);
+    monitor_destroy(&client_monitor);
+
+    return rc;
+}
+
+static
+int
+forged_hello_test(void)
+{
+    unsigned char                       secret[16];
+    unsigned char                       other[16];
+    char                                name[64];
+    char                                link_name[64];
+    char                                path[128];
+    char                                link_path[128];
+    globus_bool_t                       accepted;
+    int                                 rc = 0;
+
+    memset(secret, 0x5a, sizeof(secret));
+    memset(other, 0xa5, sizeof(other));
+    snprintf(name, sizeof(name), "/globus_xio_shm_test_%ld", (long) getpid());
+    snprintf(link_name, sizeof(link_name), "/globus_xio_shm_test_%ld_link",
+        (long) getpid());
+
+    /* the ring the hello describes is accepted, which shows the rest of
+     * the cases are refused for the reason they test */
+    if(forged_ring(name, S_IRUSR | S_IWUSR, secret) != 0 ||
+        forged_hello(name, secret, &accepted) != 0 || !accepted)
+    {
+        rc = 1;
+    }
+    /* another connection's ring */
+    if(forged_hello(name, other, &accepted) != 0 || accepted)
+    {
+        rc = 1;
+    }
+    /* a name outside the driver's */
+    if(forged_hello("/../../tmp/globus_xio_shm_test", secret, &accepted) != 0
+        || accepted)
+    {
+        rc = 1;
+    }
+    /* a link to a good ring, where the segments are files */
+    snprintf(path, sizeof(path), "/dev/shm%s", name);
+    snprintf(link_path, sizeof(link_path), "/dev/shm%s", link_name);
+    unlink(link_path);
+    if(symlink(path, link_path) == 0)
+    {
+        if(forged_hello(link_name, secret, &accepted) != 0 || accepted)
+        {
+            rc = 1;
+        }
+        unlink(link_path);
+    }
+    /* a ring others may read */
+    if(forged_ring(name, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH, secret) != 0
+        || forged_hello(name, secret, &accepted) != 0 || accepted)
+    {
+        rc = 1;
+    }
+    shm_unlink(name);
+
+    return rc;
+}
+
+static
+int
+active_test(void)
+{
+    globus_xio_handle_t                 client;
+    globus_xio_handle_t                 server;
+    globus_bool_t                       client_active = GLOBUS_FALSE;
+    globus_bool_t                       server_active = GLOBUS_FALSE;
+
+    if(connect_pair(GLOBUS_TRUE, 64 * 1024, &client, &server)
+        != GLOBUS_SUCCESS)
+    {
+        return 1;
+    }
+    globus_xio_handle_cntl(
+        client, shm_driver, GLOBUS_XIO_SHM_GET_ACTIVE, &client_active);
+    globus_xio_handle_cntl(
+        server, shm_driver, GLOBUS_XIO_SHM_GET_ACTIVE, &server_active);
+    globus_xio_close(client, NULL);
+    globus_xio_close(server, NULL);
+
+    return !client_active || !server_active;
+}
+
+static
+int
+uneven_transfer_test(void)
+{
+    globus_xio_handle_t                 client;
+    globus_xio_handle_t                 server;
+    globus_byte_t *                     in;
+    globus_byte_t *                     out;
+    int                                 rc = 1;
+
+    in = malloc(TRANSFER_SIZE);
+    out = malloc(TRANSFER_SIZE + 1);
+    fill(in, TRANSFER_SIZE);
+    memset(out, 0, TRANSFER_SIZE + 1);
+
+    /* the smallest ring, so that most writes wrap it or fill it */
+    if(connect_pair(GLOBUS_TRUE, 64 * 1024, &client, &server)
+        == GLOBUS_SUCCESS &&
+        transfer(client, server, in, out, TRANSFER_SIZE, 0)
+        == GLOBUS_SUCCESS)
+    {
+        rc = memcmp(in, out, TRANSFER_SIZE) != 0;
+    }
+    free(in);
+    free(out);
+
+    return rc;
+}
+
+static
+int
+large_write_test(void)
+{
+    globus_xio_handle_t                 client;
+    globus_xio_handle_t                 server;
+    globus_byte_t *                     in;
+    globus_byte_t *                     out;
+    int                                 rc = 1;
+
+    in = malloc(TRANSFER_SIZE);
+    out = malloc(TRANSFER_SIZE + 1);
+    fill(in, TRANSFER_SIZE);
+    memset(out, 0, TRANSFER_SIZE + 1);
+
+    /* the server end writes this time, all of it at once */
+    if(connect_pair(GLOBUS_TRUE, 1024 * 1024, &client, &server)
+        == GLOBUS_SUCCESS &&
+        transfer(server, client, in, out, TRANSFER_SIZE, TRANSFER_SIZE)
+        == GLOBUS_SUCCESS)
+    {
+        rc = memcmp(in, out, TRANSFER_SIZE) != 0;
+    }
+    free(in);
+    free(out);
+
+    return rc;
+}
+
+static
+int
+throughput_test(void)
+{
+    globus_xio_handle_t                 client;
+    globus_xio_handle_t                 server;
+    globus_byte_t *                     in;
+    globus_byte_t *                     out;
+    globus_abstime_t                    start;
+    globus_abstime_t                    end;
+    globus_reltime_t                    elapsed;
+    long                                usec[2];
+    int                                 i;
+    int                                 rc = 0;
+
+    in = malloc(THROUGHPUT_BLOCK);
+    out = malloc(THROUGHPUT_BLOCK);
+    fill(in, THROUGHPUT_BLOCK);
+
+    for(i = 0; i < 2 && rc == 0; i++)
+    {
+        if(connect_pair(i == 1, 4 * 1024 * 1024, &client, &server)
+            != GLOBUS_SUCCESS)
+        {
+            rc = 1;
+            break;
+        }
+        {
+            /* the same block over and over, only the rate matters here */
+            globus_size_t               nbytes;
+            globus_size_t               total = 0;
+            test_monitor_t              monitor;
+            globus_byte_t *             source;
+
+            source = malloc(THROUGHPUT_SIZE);
+            for(total = 0; total < THROUGHPUT_SIZE; total += THROUGHPUT_BLOCK)
+            {
+                memcpy(source + total, in, THROUGHPUT_BLOCK);
+            }
+            monitor_init(&monitor);
+            GlobusTimeAbstimeGetCurrent(start);
+            writer_start(
+                &monitor, client, source, THROUGHPUT_SIZE, THROUGHPUT_BLOCK);
+            total = 0;
+            while(globus_xio_read(server, out, THROUGHPUT_BLOCK,
+                THROUGHPUT_BLOCK, &nbytes, NULL) == GLOBUS_SUCCESS)
+            {
+                total += nbytes;
+            }
+            rc = monitor_wait(&monitor) != GLOBUS_SUCCESS ||
+                total != THROUGHPUT_SIZE;
+            globus_xio_close(server, NULL);
+            monitor_destroy(&monitor);
+            free(source);
+        }
+        GlobusTimeAbstimeGetCurrent(end);
+        GlobusTimeAbstimeDiff(elapsed, end, start);
+        GlobusTimeReltimeToUSec(usec[i], elapsed);
+        if(usec[i] <= 0)
+        {
+            usec[i] = 1;
+        }
+    }
+    free(in);
+    free(out);
+
+    if(rc == 0)
+    {
+        printf("# %d MB in %d KB writes: tcp %.1f MB/s, tcp,shm %.1f MB/s\n",
+            THROUGHPUT_SIZE / (1024 * 1024),
+            THROUGHPUT_BLOCK / 1024,
+            (double) THROUGHPUT_SIZE / usec[0],
+            (double) THROUGHPUT_SIZE / usec[1]);
+    }
+
+    return rc;
+}
+
+int main()
+{
+    int                                 xc = 0;
+    int                                 i;
+    struct
+    {
+        const char *                    name;
+        int                             (*func)(void);
+    }
+    tests[] =
+    {
+        { "active_test", active_test },
+        { "uneven_transfer_test", uneven_transfer_test },
+        { "large_write_test", large_write_test },
+        { "forged_hello_test", forged_hello_test },
+        { "throughput_test", throughput_test }
+    };
+
+    printf("1..%d\n", (int) (sizeof(tests) / sizeof(tests[0])));
+
+    globus_module_activate(GLOBUS_XIO_MODULE);
+    globus_xio_driver_load("tcp", &tcp_driver);
+    globus_xio_driver_load("shm", &shm_driver);
+
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        if (tests[i].func() == 0)
+        {
+            printf("ok %d - %s\n", i + 1, tests[i].name);
+        }
+        else
+        {
+            printf("not ok %d - %s\n", i + 1, tests[i].name);
+            xc++;
+        }
+    }
+
+    globus_xio_driver_unload(shm_driver);
+    globus_xio_driver_unload(tcp_driver);
+    globus_module_deactivate(GLOBUS_XIO_MODULE);
+
+    return xc;
+}